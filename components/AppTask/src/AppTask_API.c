@@ -3,6 +3,9 @@
 #include "freertos/FreeRTOS.h"
 #include "WiFi_Manager_API.h"
 #include "NVS_API.h"
+#include "NVS_Config.h"
+#include "FlashStats_API.h"
+#include "LogRing_API.h"
 #include "Ws_API.h"
 #include "FatFS_API.h"
 #include "SPIFFS_API.h"
@@ -12,14 +15,19 @@
 #include "TouchScreen_API.h"
 #include "TouchScreen_Services.h"
 #include "TouchScreen_UI_Manager.h"
+#include "Ota_API.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
 
 static const char* TAG = "APP_TASK";
 
 #define APP_TASK_STACK_BYTES        4096UL
 #define APP_TASK_STACK_WORDS        ((APP_TASK_STACK_BYTES + sizeof(StackType_t) - 1) / sizeof(StackType_t))
 #define APP_TASK_QUEUE_LENGTH       4UL
+#define APP_TASK_SCHEDULER_STALL_MS 10000UL     /* the scheduler task wakes every second */
+#define APP_TASK_WEB_PROBE_MS       5000UL
 
 typedef struct _APP_TASK_RSC_T
 {
@@ -31,6 +39,7 @@ typedef struct _APP_TASK_RSC_T
     WEB_SERVER_H         hWebServer;            /* Web server handle */
     TOUCHSCREEN_H        hTouchScreen;          /* Touch screen handle */
     SCHEDULER_H          hScheduler;            /* Scheduler handle */
+    esp_timer_handle_t   hOtaHealthTimer;       /* ends the probation of a new image */
 } APP_TASK_RSC_T;
 
 static void 
@@ -111,6 +120,86 @@ appTask_SetupWizardCallback(bool completed, bool wifi_configured,
 static uint32_t
 appTask_Init(APP_TASK_RSC_T* ptAppTaskRsc);
 
+/**
+ * @brief Probation timer - runs in the esp_timer task, so it only queues
+ *        the check; confirming the image writes otadata from APP_TASK.
+ */
+static void
+appTask_OtaHealthTimerCallback(void* pvArg)
+{
+    APP_TASK_RSC_T* ptAppTaskRsc = (APP_TASK_RSC_T*)pvArg;
+    APP_TASK_EVENT_T tEvent = { .ulEvent = APP_TASK_EVENTS_EVENT_OTA_HEALTH_CHECK };
+
+    if (pdPASS != xQueueSend(ptAppTaskRsc->hAppTaskQueue, &tEvent, 0))
+    {
+        /* Queue full: try again shortly rather than leave the image pending */
+        esp_timer_start_once(ptAppTaskRsc->hOtaHealthTimer, 1000000);
+    }
+}
+
+/**
+ * @brief Keep a new firmware image only if what it started is still working:
+ *        the scheduler task keeps waking, the schedule settings were read
+ *        from storage and the web server answers a queued probe.
+ */
+static void
+appTask_CheckFirmwareHealth(APP_TASK_RSC_T* ptAppTaskRsc)
+{
+    bool bHealthy = (NULL != ptAppTaskRsc->hWiFiManager) &&
+                    (NULL != ptAppTaskRsc->hTouchScreen);
+
+    SCHEDULER_STATUS_T tSched;
+    if ((ESP_OK != Scheduler_GetStatus(ptAppTaskRsc->hScheduler, &tSched)) ||
+        !tSched.bRunning || (tSched.ulLoopAgeMs > APP_TASK_SCHEDULER_STALL_MS))
+    {
+        ESP_LOGE(TAG, "Health: scheduler task not running");
+        bHealthy = false;
+    }
+    else if (!tSched.bSettingsLoaded)
+    {
+        ESP_LOGE(TAG, "Health: schedule settings not loaded");
+        bHealthy = false;
+    }
+
+    if (!Ws_IsServing(ptAppTaskRsc->hWebServer, APP_TASK_WEB_PROBE_MS))
+    {
+        ESP_LOGE(TAG, "Health: web server not serving");
+        bHealthy = false;
+    }
+
+    esp_err_t espErr = Ota_CompleteHealthCheck(bHealthy);
+    ESP_LOGI(TAG, "Firmware health check finished with result: %s", esp_err_to_name(espErr));
+}
+
+static void
+appTask_StartOtaProbation(APP_TASK_RSC_T* ptAppTaskRsc)
+{
+    const esp_timer_create_args_t tTimerArgs =
+    {
+        .callback = appTask_OtaHealthTimerCallback,
+        .arg      = ptAppTaskRsc,
+        .name     = "ota_health",
+    };
+
+    esp_err_t espErr = esp_timer_create(&tTimerArgs, &ptAppTaskRsc->hOtaHealthTimer);
+    if (ESP_OK == espErr)
+    {
+        espErr = esp_timer_start_once(ptAppTaskRsc->hOtaHealthTimer,
+                                      (uint64_t)CONFIG_OTA_HEALTH_CHECK_DELAY_SEC * 1000000ULL);
+    }
+
+    if (ESP_OK == espErr)
+    {
+        ESP_LOGI(TAG, "New firmware on probation, health check in %d s", CONFIG_OTA_HEALTH_CHECK_DELAY_SEC);
+    }
+    else
+    {
+        /* Without the timer it would never be confirmed: decide now */
+        ESP_LOGE(TAG, "Probation timer failed: %s", esp_err_to_name(espErr));
+        appTask_CheckFirmwareHealth(ptAppTaskRsc);
+    }
+}
+
 static uint32_t
 appTask_Process(APP_TASK_RSC_T* ptAppTaskRsc);
 
@@ -178,6 +267,11 @@ appTask_Enter(void* pvArg)
     {
         lResult = appTask_Process(ptAppTaskRsc);
     }
+    else
+    {
+        /* A new image that cannot start goes back to the previous one */
+        Ota_RollBack("start-up failed");
+    }
 
     assert(false);
 }
@@ -191,9 +285,39 @@ appTask_Init(APP_TASK_RSC_T* ptAppTaskRsc)
 
     /* ========== PHASE 1: Hardware & Storage Initialization ========== */
 
+    /* First, so the rest of start-up is captured for /api/logs */
+    esp_err_t logErr = LogRing_Init();
+    if (ESP_OK != logErr)
+    {
+        ESP_LOGW(TAG, "Log ring unavailable: %s", esp_err_to_name(logErr));
+    }
+
+    esp_err_t otaErr = Ota_Init();
+    if (ESP_OK != otaErr)
+    {
+        ESP_LOGW(TAG, "Firmware update state unavailable: %s", esp_err_to_name(otaErr));
+    }
+
     lResult = NVS_Init();
     ESP_LOGI(TAG, "Finish NVS Initialization with result: %" PRIu32, lResult);
 
+    if(APP_SUCCESS == lResult)
+    {
+        /* Before anything that writes flash, so every write is accounted */
+        esp_err_t statsErr = FlashStats_Init();
+        if (ESP_OK != statsErr)
+        {
+            ESP_LOGW(TAG, "Flash write accounting unavailable: %s", esp_err_to_name(statsErr));
+        }
+
+        esp_err_t cfgErr = NVS_Config_Init();
+        if (ESP_OK != cfgErr)
+        {
+            ESP_LOGE(TAG, "Config store init failed: %s", esp_err_to_name(cfgErr));
+            lResult = APP_ERROR_INIT_FAILED;
+        }
+    }
+
     if(APP_SUCCESS == lResult)
     {
         ESP_LOGI(TAG, "Start Fat FS Initialization.");
@@ -212,6 +336,12 @@ appTask_Init(APP_TASK_RSC_T* ptAppTaskRsc)
             ESP_LOGE(TAG, "SPIFFS init failed: %s", esp_err_to_name(spiffsErr));
             lResult = APP_ERROR_INIT_FAILED;
         }
+#if CONFIG_STORAGE_BENCHMARK_ON_BOOT
+        else
+        {
+            SPIFFS_RunBenchmark();
+        }
+#endif
 
         ESP_LOGI(TAG, "Finish SPIFFS Initialization.");
     }
@@ -349,6 +479,12 @@ appTask_Init(APP_TASK_RSC_T* ptAppTaskRsc)
             }
         }
     }
+
+    /* A freshly installed image has to prove itself before it is kept */
+    if ((APP_SUCCESS == lResult) && Ota_IsPendingVerify())
+    {
+        appTask_StartOtaProbation(ptAppTaskRsc);
+    }
     
     return lResult;
 }
@@ -368,6 +504,12 @@ appTask_Process(APP_TASK_RSC_T* ptAppTaskRsc)
         {
             switch(tEvent.ulEvent)
             {
+                case APP_TASK_EVENTS_EVENT_OTA_HEALTH_CHECK:
+                {
+                    appTask_CheckFirmwareHealth(ptAppTaskRsc);
+                    break;
+                }
+
                 case APP_TASK_EVENTS_EVENT_NONE:
                 default:
                 {
@@ -17,4 +17,5 @@ typedef struct _APP_TASK_EVENT_T
 typedef enum _APP_TASK_EVENTS_E
 { 
     APP_TASK_EVENTS_EVENT_NONE = 0,
+    APP_TASK_EVENTS_EVENT_OTA_HEALTH_CHECK,     /* probation of a new firmware image is over */
 } APP_TASK_EVENTS_E;
\ No newline at end of file
@@ -17,7 +17,7 @@ esp_err_t
 FatFS_Init()
 {
     esp_err_t espRslt = ESP_OK;
-    const char* pcBasePath = "/react";
+    const char* pcBasePath = FATFS_MOUNT_POINT;
 
     esp_vfs_fat_mount_config_t tFatFsConfig =
     {
@@ -45,6 +45,22 @@ FatFS_Init()
     return espRslt;
 }
 
+esp_err_t
+FatFS_GetInfo(uint64_t* pullTotal, uint64_t* pullFree)
+{
+    if ((NULL == pullTotal) || (NULL == pullFree))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (WL_INVALID_HANDLE == hWearLevelling)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return esp_vfs_fat_info(FATFS_MOUNT_POINT, pullTotal, pullFree);
+}
+
 void debug_list_react_assets(void)
 {
     const char *base = "/react";
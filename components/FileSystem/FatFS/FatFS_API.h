@@ -1,6 +1,16 @@
 #include "esp_err.h"
+#include <stdint.h>
+
+#define FATFS_MOUNT_POINT "/react"
 
 esp_err_t
 FatFS_Init();
 
+/**
+ * @brief Partition capacity and free space in bytes.
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not mounted.
+ */
+esp_err_t
+FatFS_GetInfo(uint64_t* pullTotal, uint64_t* pullFree);
+
 void debug_list_react_assets(void);
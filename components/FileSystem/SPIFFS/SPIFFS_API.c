@@ -1,42 +1,309 @@
 #include "SPIFFS_API.h"
+#include "FlashStats_API.h"
 #include "esp_spiffs.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#if CONFIG_STORAGE_BACKEND_LITTLEFS
+#include "esp_littlefs.h"
+#include "esp_heap_caps.h"
+#include <dirent.h>
+#endif
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
 static const char* TAG = "spiffs";
 
-esp_err_t
-SPIFFS_Init(void)
+#define STORAGE_PARTITION_LABEL     "storage"
+#define STORAGE_MAX_FILES           8
+#define STORAGE_PATH_MAX            64
+#define STORAGE_READ_ALLOC_MAX      (128 * 1024)   /* sanity bound, far above any config file */
+
+#if CONFIG_STORAGE_BACKEND_LITTLEFS
+#define STORAGE_MIGRATE_MAX_FILES   32
+#define STORAGE_MIGRATE_MAX_BYTES   (512 * 1024)
+#endif
+
+/* Backend actually mounted this boot (LittleFS build may stay on SPIFFS
+ * for one boot if the migration snapshot could not be taken) */
+static const char* s_pcBackend     = "none";
+static bool        s_bAtomicRename = false;
+
+/* ------------------------------------------------------------------ */
+/* Backends                                                            */
+/* ------------------------------------------------------------------ */
+
+static esp_err_t
+storage_MountSpiffs(bool bFormatIfFailed)
 {
     esp_vfs_spiffs_conf_t tConf = {
         .base_path       = SPIFFS_MOUNT_POINT,
-        .partition_label = "storage",
-        .max_files       = 8,
-        .format_if_mount_failed = true
+        .partition_label = STORAGE_PARTITION_LABEL,
+        .max_files       = STORAGE_MAX_FILES,
+        .format_if_mount_failed = bFormatIfFailed
     };
 
     esp_err_t espRslt = esp_vfs_spiffs_register(&tConf);
+    if (espRslt == ESP_OK)
+    {
+        s_pcBackend     = "spiffs";
+        s_bAtomicRename = false;   /* SPIFFS rename cannot replace an existing file */
+    }
+    return espRslt;
+}
+
+#if CONFIG_STORAGE_BACKEND_LITTLEFS
+
+static esp_err_t
+storage_MountLittleFs(bool bFormatIfFailed)
+{
+    esp_vfs_littlefs_conf_t tConf = {
+        .base_path       = SPIFFS_MOUNT_POINT,
+        .partition_label = STORAGE_PARTITION_LABEL,
+        .format_if_mount_failed = bFormatIfFailed,
+        .dont_mount      = false,
+    };
+
+    esp_err_t espRslt = esp_vfs_littlefs_register(&tConf);
+    if (espRslt == ESP_OK)
+    {
+        s_pcBackend     = "littlefs";
+        s_bAtomicRename = true;
+    }
+    return espRslt;
+}
+
+typedef struct
+{
+    char   acName[STORAGE_PATH_MAX];
+    char*  pcData;
+    size_t ulLen;
+} MIGRATE_FILE_T;
+
+static void
+storage_FreeSnapshot(MIGRATE_FILE_T* ptFiles, uint32_t ulCount)
+{
+    for (uint32_t i = 0; i < ulCount; i++)
+    {
+        free(ptFiles[i].pcData);
+    }
+    free(ptFiles);
+}
+
+/**
+ * Copy every file of the (mounted) SPIFFS partition into RAM.
+ * The storage partition holds a handful of small JSON files, so a
+ * full snapshot in PSRAM is cheap and lets us reformat in place.
+ */
+static esp_err_t
+storage_SnapshotSpiffs(MIGRATE_FILE_T** pptFiles, uint32_t* pulCount)
+{
+    *pptFiles = NULL;
+    *pulCount = 0;
+
+    MIGRATE_FILE_T* ptFiles = (MIGRATE_FILE_T*)calloc(STORAGE_MIGRATE_MAX_FILES, sizeof(MIGRATE_FILE_T));
+    if (NULL == ptFiles) return ESP_ERR_NO_MEM;
+
+    DIR* ptDir = opendir(SPIFFS_MOUNT_POINT);
+    if (NULL == ptDir)
+    {
+        free(ptFiles);
+        return ESP_FAIL;
+    }
+
+    esp_err_t espRslt = ESP_OK;
+    uint32_t ulCount = 0;
+    size_t ulTotal = 0;
+    struct dirent* ptEntry;
+
+    while ((ptEntry = readdir(ptDir)) != NULL)
+    {
+        if (ulCount >= STORAGE_MIGRATE_MAX_FILES)
+        {
+            ESP_LOGE(TAG, "Migration: more than %d files", STORAGE_MIGRATE_MAX_FILES);
+            espRslt = ESP_ERR_NO_MEM;
+            break;
+        }
+
+        char acPath[STORAGE_PATH_MAX + sizeof(SPIFFS_MOUNT_POINT) + 1];
+        snprintf(acPath, sizeof(acPath), "%s/%s", SPIFFS_MOUNT_POINT, ptEntry->d_name);
+
+        struct stat tStat;
+        if (stat(acPath, &tStat) != 0) continue;
+
+        ulTotal += (size_t)tStat.st_size;
+        if (ulTotal > STORAGE_MIGRATE_MAX_BYTES)
+        {
+            ESP_LOGE(TAG, "Migration: data exceeds %d bytes", STORAGE_MIGRATE_MAX_BYTES);
+            espRslt = ESP_ERR_NO_MEM;
+            break;
+        }
+
+        MIGRATE_FILE_T* ptFile = &ptFiles[ulCount];
+        ptFile->pcData = (char*)heap_caps_malloc(tStat.st_size + 1, MALLOC_CAP_SPIRAM);
+        if (NULL == ptFile->pcData)
+        {
+            ptFile->pcData = (char*)malloc(tStat.st_size + 1);
+        }
+        if (NULL == ptFile->pcData)
+        {
+            espRslt = ESP_ERR_NO_MEM;
+            break;
+        }
+
+        FILE* pFile = fopen(acPath, "r");
+        if (NULL == pFile)
+        {
+            free(ptFile->pcData);
+            ptFile->pcData = NULL;
+            espRslt = ESP_FAIL;
+            break;
+        }
+        ptFile->ulLen = fread(ptFile->pcData, 1, tStat.st_size, pFile);
+        fclose(pFile);
+
+        strncpy(ptFile->acName, ptEntry->d_name, sizeof(ptFile->acName) - 1);
+        ulCount++;
+    }
+    closedir(ptDir);
 
     if (espRslt != ESP_OK)
     {
-        ESP_LOGE(TAG, "Failed to mount SPIFFS (%s)", esp_err_to_name(espRslt));
+        storage_FreeSnapshot(ptFiles, ulCount);
+        return espRslt;
+    }
+
+    *pptFiles = ptFiles;
+    *pulCount = ulCount;
+    return ESP_OK;
+}
+
+/**
+ * One-time migration: the partition still holds SPIFFS from an older
+ * firmware. Snapshot the files, reformat as LittleFS and write them back.
+ * On a snapshot failure we stay on SPIFFS for this boot and retry next boot.
+ */
+static esp_err_t
+storage_MigrateFromSpiffs(void)
+{
+    if (storage_MountSpiffs(false) != ESP_OK)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    MIGRATE_FILE_T* ptFiles = NULL;
+    uint32_t ulCount = 0;
+    esp_err_t espRslt = storage_SnapshotSpiffs(&ptFiles, &ulCount);
+    if (espRslt != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Migration snapshot failed (%s), staying on SPIFFS this boot",
+                 esp_err_to_name(espRslt));
+        return ESP_OK;
+    }
+
+    ESP_LOGW(TAG, "Migrating %"PRIu32" file(s) from SPIFFS to LittleFS", ulCount);
+
+    esp_vfs_spiffs_unregister(STORAGE_PARTITION_LABEL);
+
+    espRslt = esp_littlefs_format(STORAGE_PARTITION_LABEL);
+    if (espRslt == ESP_OK)
+    {
+        espRslt = storage_MountLittleFs(false);
+    }
+    if (espRslt != ESP_OK)
+    {
+        ESP_LOGE(TAG, "LittleFS format/mount failed (%s)", esp_err_to_name(espRslt));
+        storage_FreeSnapshot(ptFiles, ulCount);
+        return espRslt;
+    }
+
+    for (uint32_t i = 0; i < ulCount; i++)
+    {
+        char acPath[STORAGE_PATH_MAX + sizeof(SPIFFS_MOUNT_POINT) + 1];
+        snprintf(acPath, sizeof(acPath), "%s/%s", SPIFFS_MOUNT_POINT, ptFiles[i].acName);
+
+        if (SPIFFS_WriteFile(acPath, ptFiles[i].pcData, ptFiles[i].ulLen) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Migration: failed to restore %s", acPath);
+            continue;
+        }
+        ESP_LOGI(TAG, "Migrated %s (%zu bytes)", acPath, ptFiles[i].ulLen);
+    }
+
+    storage_FreeSnapshot(ptFiles, ulCount);
+    return ESP_OK;
+}
+
+#endif /* CONFIG_STORAGE_BACKEND_LITTLEFS */
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+SPIFFS_Init(void)
+{
+    esp_err_t espRslt;
+
+#if CONFIG_STORAGE_BACKEND_LITTLEFS
+    espRslt = storage_MountLittleFs(false);
+    if (espRslt != ESP_OK)
+    {
+        ESP_LOGW(TAG, "No LittleFS on '%s', checking for legacy SPIFFS", STORAGE_PARTITION_LABEL);
+        espRslt = storage_MigrateFromSpiffs();
+        if (espRslt == ESP_ERR_NOT_FOUND)
+        {
+            /* Blank or unreadable partition */
+            espRslt = storage_MountLittleFs(true);
+        }
+    }
+#else
+    espRslt = storage_MountSpiffs(true);
+#endif
+
+    if (espRslt != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to mount storage (%s)", esp_err_to_name(espRslt));
     }
     else
     {
-        ESP_LOGI(TAG, "SPIFFS mounted at %s", SPIFFS_MOUNT_POINT);
+        ESP_LOGI(TAG, "Storage mounted at %s (%s)", SPIFFS_MOUNT_POINT, s_pcBackend);
 
         size_t ulTotal = 0, ulUsed = 0;
-        if (esp_spiffs_info("storage", &ulTotal, &ulUsed) == ESP_OK)
+        if (SPIFFS_GetInfo(&ulTotal, &ulUsed) == ESP_OK)
         {
-            ESP_LOGI(TAG, "SPIFFS: total=%zu, used=%zu", ulTotal, ulUsed);
+            ESP_LOGI(TAG, "Storage: total=%zu, used=%zu", ulTotal, ulUsed);
         }
     }
 
     return espRslt;
 }
 
+const char*
+SPIFFS_GetBackendName(void)
+{
+    return s_pcBackend;
+}
+
+esp_err_t
+SPIFFS_GetInfo(size_t* pulTotal, size_t* pulUsed)
+{
+    if ((NULL == pulTotal) || (NULL == pulUsed))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if CONFIG_STORAGE_BACKEND_LITTLEFS
+    if (s_bAtomicRename)
+    {
+        return esp_littlefs_info(STORAGE_PARTITION_LABEL, pulTotal, pulUsed);
+    }
+#endif
+    return esp_spiffs_info(STORAGE_PARTITION_LABEL, pulTotal, pulUsed);
+}
+
 esp_err_t
 SPIFFS_ReadFile(const char* pcPath, char* pcOutBuf, size_t ulBufSize, size_t* pulBytesRead)
 {
@@ -53,6 +320,7 @@ SPIFFS_ReadFile(const char* pcPath, char* pcOutBuf, size_t ulBufSize, size_t* pu
 
     size_t ulRead = fread(pcOutBuf, 1, ulBufSize - 1, pFile);
     pcOutBuf[ulRead] = '\0';
+    bool bTruncated = (ulRead == ulBufSize - 1) && (fgetc(pFile) != EOF);
     fclose(pFile);
 
     if (pulBytesRead != NULL)
@@ -60,6 +328,68 @@ SPIFFS_ReadFile(const char* pcPath, char* pcOutBuf, size_t ulBufSize, size_t* pu
         *pulBytesRead = ulRead;
     }
 
+    if (bTruncated)
+    {
+        ESP_LOGE(TAG, "%s does not fit in %zu bytes", pcPath, ulBufSize);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t
+SPIFFS_ReadFileAlloc(const char* pcPath, char** ppcOut, size_t* pulLen)
+{
+    if ((NULL == pcPath) || (NULL == ppcOut))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *ppcOut = NULL;
+
+    struct stat tStat;
+    if (stat(pcPath, &tStat) != 0)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if ((tStat.st_size < 0) || (tStat.st_size > STORAGE_READ_ALLOC_MAX))
+    {
+        ESP_LOGE(TAG, "%s is %ld bytes, over the %d byte read limit",
+                 pcPath, (long)tStat.st_size, STORAGE_READ_ALLOC_MAX);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t ulSize = (size_t)tStat.st_size;
+    char*  pcBuf  = (char*)malloc(ulSize + 1);
+    if (NULL == pcBuf)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    FILE* pFile = fopen(pcPath, "r");
+    if (NULL == pFile)
+    {
+        free(pcBuf);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t ulRead = fread(pcBuf, 1, ulSize, pFile);
+    bool   bMore  = (fgetc(pFile) != EOF);
+    fclose(pFile);
+
+    /* Replaced between stat() and the read: let the caller retry rather
+     * than hand back a mix of two versions */
+    if ((ulRead != ulSize) || bMore)
+    {
+        ESP_LOGE(TAG, "%s changed size while being read", pcPath);
+        free(pcBuf);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pcBuf[ulRead] = '\0';
+    *ppcOut = pcBuf;
+    if (pulLen != NULL)
+    {
+        *pulLen = ulRead;
+    }
     return ESP_OK;
 }
 
@@ -71,10 +401,23 @@ SPIFFS_WriteFile(const char* pcPath, const char* pcData, size_t ulDataLen)
         return ESP_ERR_INVALID_ARG;
     }
 
-    FILE* pFile = fopen(pcPath, "w");
+    /* LittleFS: write a sibling and rename over the target so a power
+     * cut leaves either the old or the new file, never a truncated one */
+    char acTmp[STORAGE_PATH_MAX];
+    const char* pcTarget = pcPath;
+    if (s_bAtomicRename)
+    {
+        if (snprintf(acTmp, sizeof(acTmp), "%s.tmp", pcPath) >= (int)sizeof(acTmp))
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        pcTarget = acTmp;
+    }
+
+    FILE* pFile = fopen(pcTarget, "w");
     if (NULL == pFile)
     {
-        ESP_LOGE(TAG, "Failed to open %s for writing", pcPath);
+        ESP_LOGE(TAG, "Failed to open %s for writing", pcTarget);
         return ESP_FAIL;
     }
 
@@ -84,9 +427,18 @@ SPIFFS_WriteFile(const char* pcPath, const char* pcData, size_t ulDataLen)
     if (ulWritten != ulDataLen)
     {
         ESP_LOGE(TAG, "Write incomplete: %zu of %zu bytes", ulWritten, ulDataLen);
+        if (pcTarget != pcPath) remove(pcTarget);
+        return ESP_FAIL;
+    }
+
+    if ((pcTarget != pcPath) && (rename(pcTarget, pcPath) != 0))
+    {
+        ESP_LOGE(TAG, "Failed to rename %s -> %s", pcTarget, pcPath);
+        remove(pcTarget);
         return ESP_FAIL;
     }
 
+    FlashStats_RecordWrite(FLASH_STATS_AREA_STORAGE, pcPath, ulDataLen);
     return ESP_OK;
 }
 
@@ -7,23 +7,49 @@
 #define SPIFFS_MOUNT_POINT "/storage"
 
 /**
- * @brief Initialize and mount the SPIFFS partition.
+ * @brief Initialize and mount the "storage" partition at SPIFFS_MOUNT_POINT.
+ *        The backend is chosen by CONFIG_STORAGE_BACKEND_*. With LittleFS,
+ *        a partition still holding SPIFFS is migrated once on first boot.
  * @return ESP_OK on success.
  */
 esp_err_t SPIFFS_Init(void);
 
+/**
+ * @brief Name of the mounted backend ("littlefs", "spiffs" or "none").
+ */
+const char* SPIFFS_GetBackendName(void);
+
+/**
+ * @brief Partition capacity and usage in bytes.
+ * @return ESP_OK on success.
+ */
+esp_err_t SPIFFS_GetInfo(size_t* pulTotal, size_t* pulUsed);
+
 /**
  * @brief Read entire file contents into buffer.
  * @param pcPath     Full path (e.g. "/storage/schedule.json").
  * @param pcOutBuf   Output buffer.
  * @param ulBufSize  Size of output buffer.
  * @param pulBytesRead  If non-NULL, receives actual bytes read.
- * @return ESP_OK on success, ESP_ERR_NOT_FOUND if file missing.
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if file missing,
+ *         ESP_ERR_INVALID_SIZE if the file did not fit (buffer holds the start).
  */
 esp_err_t SPIFFS_ReadFile(const char* pcPath, char* pcOutBuf, size_t ulBufSize, size_t* pulBytesRead);
 
+/**
+ * @brief Read a whole file into a buffer sized from stat(); free() it after use.
+ * @param pcPath   Full path.
+ * @param ppcOut   Receives the NUL-terminated contents, or NULL on error.
+ * @param pulLen   If non-NULL, receives the length without the NUL.
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if file missing,
+ *         ESP_ERR_INVALID_SIZE if it is over 128 KB or changed while read,
+ *         ESP_ERR_NO_MEM.
+ */
+esp_err_t SPIFFS_ReadFileAlloc(const char* pcPath, char** ppcOut, size_t* pulLen);
+
 /**
  * @brief Write data to a file (creates or overwrites).
+ *        On LittleFS the file is replaced atomically (write + rename).
  * @param pcPath   Full path.
  * @param pcData   Data to write.
  * @param ulDataLen Length of data.
@@ -37,3 +63,13 @@ esp_err_t SPIFFS_WriteFile(const char* pcPath, const char* pcData, size_t ulData
  * @return true if file exists.
  */
 bool SPIFFS_FileExists(const char* pcPath);
+
+/**
+ * @brief Format the "fs_bench" partition as SPIFFS, then as LittleFS,
+ *        and time the same workload on each (open/read/write/rename and
+ *        log appends on a 75 % full FS). Logs avg/max latency per op and
+ *        the worst-case write (GC) stall of both backends. /storage is
+ *        not touched.
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND without an "fs_bench" partition.
+ */
+esp_err_t SPIFFS_RunBenchmark(void);
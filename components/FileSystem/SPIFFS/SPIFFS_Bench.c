@@ -0,0 +1,311 @@
+#include "SPIFFS_API.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_spiffs.h"
+#include "esp_littlefs.h"
+#include "esp_partition.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "spiffs_bench";
+
+/* Both backends run in one build, one after the other, on a scratch
+ * partition of their own: /storage and its files are never touched. */
+#define BENCH_PARTITION_LABEL   "fs_bench"
+#define BENCH_MOUNT_POINT       "/fsbench"
+#define BENCH_MAX_FILES         8
+
+/* Workload modelled on the real /storage traffic: schedule JSON files
+ * rewritten whole (1 KB up to a 44 KB calendar) and a small fixed-record
+ * append-only log. The partition is first filled to BENCH_FILL_PERCENT,
+ * because garbage collection only stalls writes on a well-used FS. */
+#define BENCH_JSON_PATH         BENCH_MOUNT_POINT "/bench.json"
+#define BENCH_JSON_ALT_PATH     BENCH_MOUNT_POINT "/bench2.json"
+#define BENCH_LOG_PATH          BENCH_MOUNT_POINT "/bench.log"
+#define BENCH_FILL_PATH_FMT     BENCH_MOUNT_POINT "/fill%02" PRIu32 ".bin"
+#define BENCH_JSON_MAX_SIZE     (44 * 1024)
+#define BENCH_FILL_FILE_SIZE    (32 * 1024)
+#define BENCH_FILL_PERCENT      75
+#define BENCH_JSON_REWRITES     200
+#define BENCH_OPEN_ITERATIONS   200
+#define BENCH_LOG_APPENDS       2000
+#define BENCH_LOG_RECORD_SIZE   32
+#define BENCH_STALL_US          100000  /* a write this slow counts as a GC stall */
+
+typedef struct
+{
+    const char* pcName;
+    uint32_t    ulCount;
+    int64_t     llTotalUs;
+    int64_t     llMaxUs;
+    uint32_t    ulStalls;
+} BENCH_STAT_T;
+
+typedef struct
+{
+    const char* pcName;
+    bool        bAtomicRename;      /* as SPIFFS_WriteFile() does on this backend */
+    esp_err_t (*pfnMount)(void);
+    void      (*pfnUnmount)(void);
+    esp_err_t (*pfnInfo)(size_t* pulTotal, size_t* pulUsed);
+} BENCH_BACKEND_T;
+
+/* ------------------------------------------------------------------ */
+/* Backends                                                            */
+/* ------------------------------------------------------------------ */
+
+static esp_err_t
+bench_MountSpiffs(void)
+{
+    esp_vfs_spiffs_conf_t tConf = {
+        .base_path       = BENCH_MOUNT_POINT,
+        .partition_label = BENCH_PARTITION_LABEL,
+        .max_files       = BENCH_MAX_FILES,
+        .format_if_mount_failed = true
+    };
+
+    esp_err_t espRslt = esp_vfs_spiffs_register(&tConf);
+    if (espRslt == ESP_OK)
+    {
+        espRslt = esp_spiffs_format(BENCH_PARTITION_LABEL);
+    }
+    return espRslt;
+}
+
+static void
+bench_UnmountSpiffs(void)
+{
+    esp_vfs_spiffs_unregister(BENCH_PARTITION_LABEL);
+}
+
+static esp_err_t
+bench_InfoSpiffs(size_t* pulTotal, size_t* pulUsed)
+{
+    return esp_spiffs_info(BENCH_PARTITION_LABEL, pulTotal, pulUsed);
+}
+
+static esp_err_t
+bench_MountLittleFs(void)
+{
+    esp_err_t espRslt = esp_littlefs_format(BENCH_PARTITION_LABEL);
+    if (espRslt != ESP_OK) return espRslt;
+
+    esp_vfs_littlefs_conf_t tConf = {
+        .base_path       = BENCH_MOUNT_POINT,
+        .partition_label = BENCH_PARTITION_LABEL,
+        .format_if_mount_failed = false,
+        .dont_mount      = false,
+    };
+    return esp_vfs_littlefs_register(&tConf);
+}
+
+static void
+bench_UnmountLittleFs(void)
+{
+    esp_vfs_littlefs_unregister(BENCH_PARTITION_LABEL);
+}
+
+static esp_err_t
+bench_InfoLittleFs(size_t* pulTotal, size_t* pulUsed)
+{
+    return esp_littlefs_info(BENCH_PARTITION_LABEL, pulTotal, pulUsed);
+}
+
+static const BENCH_BACKEND_T s_atBackends[] =
+{
+    { "spiffs",   false, bench_MountSpiffs,   bench_UnmountSpiffs,   bench_InfoSpiffs },
+    { "littlefs", true,  bench_MountLittleFs, bench_UnmountLittleFs, bench_InfoLittleFs },
+};
+
+#define BENCH_BACKEND_COUNT     (sizeof(s_atBackends) / sizeof(s_atBackends[0]))
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static void
+bench_Record(BENCH_STAT_T* ptStat, int64_t llStartUs)
+{
+    int64_t llUs = esp_timer_get_time() - llStartUs;
+    ptStat->ulCount++;
+    ptStat->llTotalUs += llUs;
+    if (llUs > ptStat->llMaxUs) ptStat->llMaxUs = llUs;
+    if (llUs >= BENCH_STALL_US) ptStat->ulStalls++;
+}
+
+static void
+bench_Report(const char* pcBackend, const BENCH_STAT_T* ptStat)
+{
+    if (0 == ptStat->ulCount) return;
+    ESP_LOGI(TAG, "%-8s %-12s n=%-5"PRIu32" avg=%6"PRId64" us  max=%7"PRId64" us  stalls=%"PRIu32,
+             pcBackend, ptStat->pcName, ptStat->ulCount,
+             ptStat->llTotalUs / ptStat->ulCount, ptStat->llMaxUs, ptStat->ulStalls);
+}
+
+/* The same write SPIFFS_WriteFile() does on this backend, without the
+ * flash accounting: benchmark traffic is not device wear worth reporting */
+static esp_err_t
+bench_WriteFile(const char* pcPath, const char* pcData, size_t ulLen, bool bAtomicRename)
+{
+    char acTmp[64];
+    const char* pcTarget = pcPath;
+    if (bAtomicRename)
+    {
+        snprintf(acTmp, sizeof(acTmp), "%s.tmp", pcPath);
+        pcTarget = acTmp;
+    }
+
+    FILE* pFile = fopen(pcTarget, "w");
+    if (NULL == pFile) return ESP_FAIL;
+    size_t ulWritten = fwrite(pcData, 1, ulLen, pFile);
+    fclose(pFile);
+    if (ulWritten != ulLen) return ESP_FAIL;
+
+    if ((pcTarget != pcPath) && (rename(pcTarget, pcPath) != 0)) return ESP_FAIL;
+    return ESP_OK;
+}
+
+/** Fill the partition to BENCH_FILL_PERCENT with files that stay put */
+static uint32_t
+bench_Fill(const BENCH_BACKEND_T* ptBackend, const char* pcData)
+{
+    size_t ulTotal = 0, ulUsed = 0;
+    uint32_t ulFiles = 0;
+
+    while ((ptBackend->pfnInfo(&ulTotal, &ulUsed) == ESP_OK) &&
+           (ulUsed + BENCH_FILL_FILE_SIZE < ulTotal * BENCH_FILL_PERCENT / 100) &&
+           (ulFiles < 100))
+    {
+        char acPath[32];
+        snprintf(acPath, sizeof(acPath), BENCH_FILL_PATH_FMT, ulFiles);
+        if (bench_WriteFile(acPath, pcData, BENCH_FILL_FILE_SIZE, false) != ESP_OK) break;
+        ulFiles++;
+    }
+
+    ESP_LOGI(TAG, "%s: filled to %zu of %zu bytes", ptBackend->pcName, ulUsed, ulTotal);
+    return ulFiles;
+}
+
+/** Run the workload on one backend; returns the worst write latency */
+static int64_t
+bench_RunBackend(const BENCH_BACKEND_T* ptBackend, char* pcJson)
+{
+    esp_err_t espRslt = ptBackend->pfnMount();
+    if (espRslt != ESP_OK)
+    {
+        ESP_LOGE(TAG, "%s: format/mount of '%s' failed (%s)",
+                 ptBackend->pcName, BENCH_PARTITION_LABEL, esp_err_to_name(espRslt));
+        return -1;
+    }
+
+    uint32_t ulFill = bench_Fill(ptBackend, pcJson);
+
+    BENCH_STAT_T tWrite  = { .pcName = "json write" };
+    BENCH_STAT_T tRead   = { .pcName = "json read" };
+    BENCH_STAT_T tOpen   = { .pcName = "open+close" };
+    BENCH_STAT_T tRename = { .pcName = "rename" };
+    BENCH_STAT_T tAppend = { .pcName = "log append" };
+
+    /* Sizes cycle 1..44 KB like settings, bells and calendar edits.
+     * max(json write) is the worst-case write (GC) stall. */
+    static const size_t s_aulSizes[] = { 1024, 2048, 4096, 8192, 16384, 32768, BENCH_JSON_MAX_SIZE };
+    for (uint32_t i = 0; i < BENCH_JSON_REWRITES; i++)
+    {
+        size_t ulLen = s_aulSizes[i % (sizeof(s_aulSizes) / sizeof(s_aulSizes[0]))];
+
+        int64_t llStart = esp_timer_get_time();
+        bench_WriteFile(BENCH_JSON_PATH, pcJson, ulLen, ptBackend->bAtomicRename);
+        bench_Record(&tWrite, llStart);
+
+        char*  pcRead = NULL;
+        llStart = esp_timer_get_time();
+        SPIFFS_ReadFileAlloc(BENCH_JSON_PATH, &pcRead, NULL);
+        bench_Record(&tRead, llStart);
+        free(pcRead);
+    }
+
+    /* The file ping-pongs between two names */
+    for (uint32_t i = 0; i < BENCH_OPEN_ITERATIONS; i++)
+    {
+        const char* pcCur  = (i & 1) ? BENCH_JSON_ALT_PATH : BENCH_JSON_PATH;
+        const char* pcNext = (i & 1) ? BENCH_JSON_PATH : BENCH_JSON_ALT_PATH;
+
+        int64_t llStart = esp_timer_get_time();
+        FILE* pFile = fopen(pcCur, "r");
+        if (pFile) fclose(pFile);
+        bench_Record(&tOpen, llStart);
+
+        llStart = esp_timer_get_time();
+        rename(pcCur, pcNext);
+        bench_Record(&tRename, llStart);
+    }
+
+    /* Append-only log: fixed-width records, reopened per append as a
+     * logger that survives power loss would do */
+    char acRecord[BENCH_LOG_RECORD_SIZE];
+    memset(acRecord, 'L', sizeof(acRecord));
+    for (uint32_t i = 0; i < BENCH_LOG_APPENDS; i++)
+    {
+        int64_t llStart = esp_timer_get_time();
+        FILE* pFile = fopen(BENCH_LOG_PATH, "a");
+        if (pFile)
+        {
+            fwrite(acRecord, 1, sizeof(acRecord), pFile);
+            fclose(pFile);
+        }
+        bench_Record(&tAppend, llStart);
+    }
+
+    bench_Report(ptBackend->pcName, &tWrite);
+    bench_Report(ptBackend->pcName, &tRead);
+    bench_Report(ptBackend->pcName, &tOpen);
+    bench_Report(ptBackend->pcName, &tRename);
+    bench_Report(ptBackend->pcName, &tAppend);
+    ESP_LOGI(TAG, "%s: %"PRIu32" fill file(s) kept during the run", ptBackend->pcName, ulFill);
+
+    ptBackend->pfnUnmount();
+    return tWrite.llMaxUs;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+SPIFFS_RunBenchmark(void)
+{
+    if (NULL == esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         BENCH_PARTITION_LABEL))
+    {
+        ESP_LOGW(TAG, "No '%s' partition, benchmark skipped", BENCH_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    char* pcJson = (char*)malloc(BENCH_JSON_MAX_SIZE);
+    if (NULL == pcJson) return ESP_ERR_NO_MEM;
+
+    /* JSON-looking payload; content does not matter to the FS */
+    for (size_t i = 0; i < BENCH_JSON_MAX_SIZE; i++)
+    {
+        pcJson[i] = "{\"hour\":8,\"minute\":30,\"label\":\"Lesson\"},"[i % 40];
+    }
+
+    int64_t allWorstUs[BENCH_BACKEND_COUNT];
+    for (size_t i = 0; i < BENCH_BACKEND_COUNT; i++)
+    {
+        ESP_LOGI(TAG, "Running storage benchmark on %s ('%s')", s_atBackends[i].pcName, BENCH_PARTITION_LABEL);
+        allWorstUs[i] = bench_RunBackend(&s_atBackends[i], pcJson);
+    }
+    free(pcJson);
+
+    for (size_t i = 0; i < BENCH_BACKEND_COUNT; i++)
+    {
+        ESP_LOGI(TAG, "worst-case write (GC stall) %-8s %7"PRId64" us",
+                 s_atBackends[i].pcName, allWorstUs[i]);
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,436 @@
+#include "FlashStats_API.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <string.h>
+
+static const char* TAG = "flash_stats";
+
+#define STATS_TASK_STACK_SIZE       3072
+#define STATS_TASK_PRIORITY         1
+#define STATS_PERSIST_INTERVAL_MS   (CONFIG_FLASH_STATS_PERSIST_INTERVAL_MIN * 60UL * 1000UL)
+#define STATS_WARN_BYTES_PER_DAY    ((uint64_t)CONFIG_FLASH_STATS_WARN_KB_PER_DAY * 1024ULL)
+#define STATS_MIN_RATE_WINDOW_SEC   3600
+
+#define STATS_NVS_NAMESPACE         "flashstats"
+#define STATS_NVS_KEY               "counters"
+#define STATS_BLOB_VERSION          1
+#define STATS_OTHER_NAME            "(other)"
+
+/* ------------------------------------------------------------------ */
+/* Persisted layout                                                    */
+/* ------------------------------------------------------------------ */
+
+typedef struct __attribute__((packed))
+{
+    char     acName[FLASH_STATS_NAME_LEN];
+    uint8_t  eArea;
+    uint32_t ulWrites;
+    uint64_t ullBytes;
+    uint32_t ulEraseEquiv;
+} STATS_REC_T;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t    ulVersion;
+    uint32_t    ulTrackedSec;
+    uint32_t    ulCount;
+    STATS_REC_T atRec[FLASH_STATS_MAX_ENTRIES + FLASH_STATS_AREA_COUNT];
+} STATS_BLOB_T;
+
+/* ------------------------------------------------------------------ */
+/* State                                                               */
+/* ------------------------------------------------------------------ */
+
+typedef struct
+{
+    SemaphoreHandle_t   hMutex;
+    TaskHandle_t        hTask;
+    nvs_handle_t        hNvs;
+    bool                bNvsOpen;
+    bool                bDirty;
+    uint32_t            ulBaseTrackedSec;
+    uint32_t            ulPersistCount;
+    int64_t             llLastPersistUs;
+    uint32_t            ulCount;
+    FLASH_STATS_ENTRY_T atEntries[FLASH_STATS_MAX_ENTRIES];
+    FLASH_STATS_ENTRY_T atOther[FLASH_STATS_AREA_COUNT];
+    STATS_BLOB_T        tBlob;      /* serialisation buffer, kept off the task stack */
+} STATS_STATE_T;
+
+static STATS_STATE_T s_tStats;
+
+static const char* const s_apcAreaName[FLASH_STATS_AREA_COUNT] =
+{
+    [FLASH_STATS_AREA_STORAGE] = "storage",
+    [FLASH_STATS_AREA_NVS]     = "nvs",
+    [FLASH_STATS_AREA_FATFS]   = "fatfs",
+    [FLASH_STATS_AREA_RAW]     = "raw",
+};
+
+/* ------------------------------------------------------------------ */
+/* Helpers (mutex held)                                                */
+/* ------------------------------------------------------------------ */
+
+static uint32_t
+stats_UptimeSec(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000LL);
+}
+
+static FLASH_STATS_ENTRY_T*
+stats_Lookup(FLASH_STATS_AREA_E eArea, const char* pcName)
+{
+    for (uint32_t i = 0; i < s_tStats.ulCount; i++)
+    {
+        FLASH_STATS_ENTRY_T* ptEntry = &s_tStats.atEntries[i];
+        if ((ptEntry->eArea == eArea) &&
+            (strncmp(ptEntry->acName, pcName, FLASH_STATS_NAME_LEN - 1) == 0))
+        {
+            return ptEntry;
+        }
+    }
+
+    if (s_tStats.ulCount < FLASH_STATS_MAX_ENTRIES)
+    {
+        FLASH_STATS_ENTRY_T* ptEntry = &s_tStats.atEntries[s_tStats.ulCount++];
+        memset(ptEntry, 0, sizeof(*ptEntry));
+        strlcpy(ptEntry->acName, pcName, sizeof(ptEntry->acName));
+        ptEntry->eArea = (uint8_t)eArea;
+        return ptEntry;
+    }
+
+    return &s_tStats.atOther[eArea];
+}
+
+static void
+stats_RecordLocked(FLASH_STATS_AREA_E eArea, const char* pcName, size_t ulBytes)
+{
+    FLASH_STATS_ENTRY_T* ptEntry = stats_Lookup(eArea, pcName);
+
+    ptEntry->ulWrites++;
+    ptEntry->ullBytes += ulBytes;
+    ptEntry->ulBootWrites++;
+    ptEntry->ullBootBytes += ulBytes;
+
+    switch (eArea)
+    {
+        case FLASH_STATS_AREA_STORAGE:
+        case FLASH_STATS_AREA_FATFS:
+            /* File rewrites program whole blocks: a 10-byte file still
+             * costs one 4 KB block, which must be erased again later */
+            ptEntry->ulEraseEquiv += (ulBytes + FLASH_STATS_SECTOR_SIZE - 1) / FLASH_STATS_SECTOR_SIZE
+                                     + ((0 == ulBytes) ? 1 : 0);
+            break;
+        case FLASH_STATS_AREA_NVS:
+            /* NVS packs entries into 4 KB pages; a page is erased once full */
+            ptEntry->ulEraseEquiv = (uint32_t)(ptEntry->ullBytes / FLASH_STATS_SECTOR_SIZE);
+            break;
+        default:
+            /* Raw partitions report their erases explicitly */
+            break;
+    }
+
+    s_tStats.bDirty = true;
+}
+
+static void
+stats_Load(void)
+{
+    size_t ulLen = sizeof(s_tStats.tBlob);
+    esp_err_t err = nvs_get_blob(s_tStats.hNvs, STATS_NVS_KEY, &s_tStats.tBlob, &ulLen);
+    if (ESP_ERR_NVS_NOT_FOUND == err)
+    {
+        ESP_LOGI(TAG, "No saved counters, starting from zero");
+        return;
+    }
+
+    const size_t ulHeader = offsetof(STATS_BLOB_T, atRec);
+    STATS_BLOB_T* ptBlob = &s_tStats.tBlob;
+    if ((ESP_OK != err) || (ulLen < ulHeader) ||
+        (ptBlob->ulVersion != STATS_BLOB_VERSION) ||
+        (ptBlob->ulCount > FLASH_STATS_MAX_ENTRIES + FLASH_STATS_AREA_COUNT) ||
+        (ulLen != ulHeader + ptBlob->ulCount * sizeof(STATS_REC_T)))
+    {
+        ESP_LOGW(TAG, "Saved counters unreadable (%s), starting from zero", esp_err_to_name(err));
+        return;
+    }
+
+    s_tStats.ulBaseTrackedSec = ptBlob->ulTrackedSec;
+
+    for (uint32_t i = 0; i < ptBlob->ulCount; i++)
+    {
+        const STATS_REC_T* ptRec = &ptBlob->atRec[i];
+        if (ptRec->eArea >= FLASH_STATS_AREA_COUNT) continue;
+
+        char acName[FLASH_STATS_NAME_LEN];
+        memcpy(acName, ptRec->acName, sizeof(acName));
+        acName[sizeof(acName) - 1] = '\0';
+
+        FLASH_STATS_ENTRY_T* ptEntry = (strcmp(acName, STATS_OTHER_NAME) == 0)
+                                     ? &s_tStats.atOther[ptRec->eArea]
+                                     : stats_Lookup((FLASH_STATS_AREA_E)ptRec->eArea, acName);
+        ptEntry->ulWrites     = ptRec->ulWrites;
+        ptEntry->ullBytes     = ptRec->ullBytes;
+        ptEntry->ulEraseEquiv = ptRec->ulEraseEquiv;
+    }
+
+    ESP_LOGI(TAG, "Loaded %"PRIu32" counters covering %"PRIu32" h of uptime",
+             ptBlob->ulCount, ptBlob->ulTrackedSec / 3600);
+}
+
+static void
+stats_PackEntry(STATS_REC_T* ptRec, const FLASH_STATS_ENTRY_T* ptEntry)
+{
+    memcpy(ptRec->acName, ptEntry->acName, sizeof(ptRec->acName));
+    ptRec->eArea        = ptEntry->eArea;
+    ptRec->ulWrites     = ptEntry->ulWrites;
+    ptRec->ullBytes     = ptEntry->ullBytes;
+    ptRec->ulEraseEquiv = ptEntry->ulEraseEquiv;
+}
+
+static esp_err_t
+stats_PersistLocked(void)
+{
+    if (!s_tStats.bNvsOpen || !s_tStats.bDirty) return ESP_OK;
+
+    STATS_BLOB_T* ptBlob = &s_tStats.tBlob;
+    uint32_t ulCount = 0;
+
+    for (uint32_t i = 0; i < s_tStats.ulCount; i++)
+    {
+        stats_PackEntry(&ptBlob->atRec[ulCount++], &s_tStats.atEntries[i]);
+    }
+    for (uint32_t i = 0; i < FLASH_STATS_AREA_COUNT; i++)
+    {
+        if (0 == s_tStats.atOther[i].ulWrites) continue;
+        stats_PackEntry(&ptBlob->atRec[ulCount++], &s_tStats.atOther[i]);
+    }
+
+    ptBlob->ulVersion    = STATS_BLOB_VERSION;
+    ptBlob->ulTrackedSec = s_tStats.ulBaseTrackedSec + stats_UptimeSec();
+    ptBlob->ulCount      = ulCount;
+
+    size_t ulLen = offsetof(STATS_BLOB_T, atRec) + ulCount * sizeof(STATS_REC_T);
+    esp_err_t err = nvs_set_blob(s_tStats.hNvs, STATS_NVS_KEY, ptBlob, ulLen);
+    if (ESP_OK == err) err = nvs_commit(s_tStats.hNvs);
+    if (ESP_OK != err)
+    {
+        ESP_LOGE(TAG, "Saving counters failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    /* The save is a flash write like any other; blob payload plus its
+     * chunk index and per-32-byte entry headers */
+    stats_RecordLocked(FLASH_STATS_AREA_NVS, STATS_NVS_NAMESPACE, 64 + ((ulLen + 31) & ~31U));
+
+    s_tStats.bDirty = false;
+    s_tStats.ulPersistCount++;
+    s_tStats.llLastPersistUs = esp_timer_get_time();
+    return ESP_OK;
+}
+
+static void
+stats_WarnHotLocked(void)
+{
+    for (uint32_t i = 0; i < s_tStats.ulCount; i++)
+    {
+        const FLASH_STATS_ENTRY_T* ptEntry = &s_tStats.atEntries[i];
+        if (FlashStats_IsHot(ptEntry->ullBootBytes))
+        {
+            ESP_LOGW(TAG, "%s %s: %"PRIu32" writes since boot, ~%"PRIu64" KB/day",
+                     s_apcAreaName[ptEntry->eArea], ptEntry->acName, ptEntry->ulBootWrites,
+                     FlashStats_BootRatePerDay(ptEntry->ullBootBytes) / 1024);
+        }
+    }
+}
+
+static void
+stats_Task(void* pvArg)
+{
+    (void)pvArg;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STATS_PERSIST_INTERVAL_MS));
+
+        xSemaphoreTake(s_tStats.hMutex, portMAX_DELAY);
+        stats_PersistLocked();
+        stats_WarnHotLocked();
+        xSemaphoreGive(s_tStats.hMutex);
+    }
+}
+
+static void
+stats_ShutdownHandler(void)
+{
+    FlashStats_Persist();
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+FlashStats_Init(void)
+{
+    if (NULL != s_tStats.hMutex) return ESP_OK;
+
+    for (int i = 0; i < FLASH_STATS_AREA_COUNT; i++)
+    {
+        strlcpy(s_tStats.atOther[i].acName, STATS_OTHER_NAME, sizeof(s_tStats.atOther[i].acName));
+        s_tStats.atOther[i].eArea = (uint8_t)i;
+    }
+
+    esp_err_t err = nvs_open(STATS_NVS_NAMESPACE, NVS_READWRITE, &s_tStats.hNvs);
+    if (ESP_OK == err)
+    {
+        s_tStats.bNvsOpen = true;
+        stats_Load();
+    }
+    else
+    {
+        /* Keep counting for this boot; counters just won't survive it */
+        ESP_LOGW(TAG, "nvs_open failed (%s), counters are RAM only", esp_err_to_name(err));
+    }
+
+    s_tStats.hMutex = xSemaphoreCreateMutex();
+    if (NULL == s_tStats.hMutex) return ESP_ERR_NO_MEM;
+
+    BaseType_t xResult = xTaskCreate(stats_Task, "FLASH_STATS",
+                                     STATS_TASK_STACK_SIZE,
+                                     NULL,
+                                     STATS_TASK_PRIORITY,
+                                     &s_tStats.hTask);
+    if (pdPASS != xResult)
+    {
+        vSemaphoreDelete(s_tStats.hMutex);
+        s_tStats.hMutex = NULL;
+        return ESP_FAIL;
+    }
+
+    err = esp_register_shutdown_handler(stats_ShutdownHandler);
+    if (ESP_OK != err)
+    {
+        ESP_LOGW(TAG, "Shutdown hook not registered: %s", esp_err_to_name(err));
+    }
+
+    return ESP_OK;
+}
+
+void
+FlashStats_RecordWrite(FLASH_STATS_AREA_E eArea, const char* pcName, size_t ulBytes)
+{
+    if ((NULL == s_tStats.hMutex) || (eArea >= FLASH_STATS_AREA_COUNT) || (NULL == pcName)) return;
+
+    xSemaphoreTake(s_tStats.hMutex, portMAX_DELAY);
+    stats_RecordLocked(eArea, pcName, ulBytes);
+    xSemaphoreGive(s_tStats.hMutex);
+}
+
+void
+FlashStats_RecordErase(FLASH_STATS_AREA_E eArea, const char* pcName, uint32_t ulSectors)
+{
+    if ((NULL == s_tStats.hMutex) || (eArea >= FLASH_STATS_AREA_COUNT) || (NULL == pcName)) return;
+
+    xSemaphoreTake(s_tStats.hMutex, portMAX_DELAY);
+    stats_Lookup(eArea, pcName)->ulEraseEquiv += ulSectors;
+    s_tStats.bDirty = true;
+    xSemaphoreGive(s_tStats.hMutex);
+}
+
+uint32_t
+FlashStats_GetEntries(FLASH_STATS_ENTRY_T* ptOut, uint32_t ulMax)
+{
+    if ((NULL == ptOut) || (NULL == s_tStats.hMutex)) return 0;
+
+    uint32_t ulCount = 0;
+
+    xSemaphoreTake(s_tStats.hMutex, portMAX_DELAY);
+    for (uint32_t i = 0; (i < s_tStats.ulCount) && (ulCount < ulMax); i++)
+    {
+        ptOut[ulCount++] = s_tStats.atEntries[i];
+    }
+    for (uint32_t i = 0; (i < FLASH_STATS_AREA_COUNT) && (ulCount < ulMax); i++)
+    {
+        if (0 == s_tStats.atOther[i].ulWrites) continue;
+        ptOut[ulCount++] = s_tStats.atOther[i];
+    }
+    xSemaphoreGive(s_tStats.hMutex);
+
+    return ulCount;
+}
+
+void
+FlashStats_GetSummary(FLASH_STATS_SUMMARY_T* ptSummary)
+{
+    if (NULL == ptSummary) return;
+    memset(ptSummary, 0, sizeof(*ptSummary));
+
+    ptSummary->ulUptimeSec = stats_UptimeSec();
+    ptSummary->ulLastPersistAgeSec = UINT32_MAX;
+    if (NULL == s_tStats.hMutex) return;
+
+    xSemaphoreTake(s_tStats.hMutex, portMAX_DELAY);
+
+    ptSummary->ulTrackedSec   = s_tStats.ulBaseTrackedSec + ptSummary->ulUptimeSec;
+    ptSummary->ulPersistCount = s_tStats.ulPersistCount;
+    ptSummary->ulEntryCount   = s_tStats.ulCount;
+    if (s_tStats.ulPersistCount > 0)
+    {
+        ptSummary->ulLastPersistAgeSec =
+            (uint32_t)((esp_timer_get_time() - s_tStats.llLastPersistUs) / 1000000LL);
+    }
+
+    for (uint32_t i = 0; i < s_tStats.ulCount + FLASH_STATS_AREA_COUNT; i++)
+    {
+        const FLASH_STATS_ENTRY_T* ptEntry = (i < s_tStats.ulCount)
+                                           ? &s_tStats.atEntries[i]
+                                           : &s_tStats.atOther[i - s_tStats.ulCount];
+        FLASH_STATS_TOTAL_T* ptTotal = &ptSummary->atArea[ptEntry->eArea];
+        ptTotal->ulWrites     += ptEntry->ulWrites;
+        ptTotal->ullBytes     += ptEntry->ullBytes;
+        ptTotal->ulEraseEquiv += ptEntry->ulEraseEquiv;
+        ptTotal->ullBootBytes += ptEntry->ullBootBytes;
+    }
+
+    xSemaphoreGive(s_tStats.hMutex);
+}
+
+uint64_t
+FlashStats_BootRatePerDay(uint64_t ullBootBytes)
+{
+    uint32_t ulWindowSec = stats_UptimeSec();
+    if (ulWindowSec < STATS_MIN_RATE_WINDOW_SEC) ulWindowSec = STATS_MIN_RATE_WINDOW_SEC;
+    return (ullBootBytes * 86400ULL) / ulWindowSec;
+}
+
+bool
+FlashStats_IsHot(uint64_t ullBootBytes)
+{
+    return FlashStats_BootRatePerDay(ullBootBytes) > STATS_WARN_BYTES_PER_DAY;
+}
+
+esp_err_t
+FlashStats_Persist(void)
+{
+    if (NULL == s_tStats.hMutex) return ESP_OK;
+
+    xSemaphoreTake(s_tStats.hMutex, portMAX_DELAY);
+    esp_err_t err = stats_PersistLocked();
+    xSemaphoreGive(s_tStats.hMutex);
+
+    return err;
+}
+
+const char*
+FlashStats_AreaToStr(FLASH_STATS_AREA_E eArea)
+{
+    return (eArea < FLASH_STATS_AREA_COUNT) ? s_apcAreaName[eArea] : "unknown";
+}
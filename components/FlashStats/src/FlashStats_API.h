@@ -0,0 +1,104 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ------------------------------------------------------------------ */
+/* Limits                                                              */
+/* ------------------------------------------------------------------ */
+#define FLASH_STATS_NAME_LEN        32      /* file path or namespace, truncated */
+#define FLASH_STATS_MAX_ENTRIES     32      /* further names fold into one "(other)" per area */
+#define FLASH_STATS_SECTOR_SIZE     4096
+
+typedef enum
+{
+    FLASH_STATS_AREA_STORAGE = 0,   /* /storage files (LittleFS or SPIFFS) */
+    FLASH_STATS_AREA_NVS,           /* NVS namespaces */
+    FLASH_STATS_AREA_FATFS,         /* /react files */
+    FLASH_STATS_AREA_RAW,           /* raw data partitions (bell_log) */
+    FLASH_STATS_AREA_COUNT
+} FLASH_STATS_AREA_E;
+
+typedef struct
+{
+    char     acName[FLASH_STATS_NAME_LEN];
+    uint8_t  eArea;                 /* FLASH_STATS_AREA_E */
+    uint32_t ulWrites;              /* lifetime, persisted */
+    uint64_t ullBytes;              /* lifetime, persisted */
+    uint32_t ulEraseEquiv;          /* lifetime 4 KB sector erases, estimated */
+    uint32_t ulBootWrites;          /* since boot */
+    uint64_t ullBootBytes;          /* since boot */
+} FLASH_STATS_ENTRY_T;
+
+typedef struct
+{
+    uint32_t ulWrites;
+    uint64_t ullBytes;
+    uint32_t ulEraseEquiv;
+    uint64_t ullBootBytes;
+} FLASH_STATS_TOTAL_T;
+
+typedef struct
+{
+    uint32_t            ulTrackedSec;       /* device uptime covered by the lifetime counters */
+    uint32_t            ulUptimeSec;
+    uint32_t            ulPersistCount;     /* saves since boot */
+    uint32_t            ulLastPersistAgeSec;/* UINT32_MAX if not saved since boot */
+    uint32_t            ulEntryCount;
+    FLASH_STATS_TOTAL_T atArea[FLASH_STATS_AREA_COUNT];
+} FLASH_STATS_SUMMARY_T;
+
+/**
+ * @brief Load the saved counters from NVS and start the save task.
+ *        Call right after NVS_Init; writes recorded before this are dropped.
+ */
+esp_err_t
+FlashStats_Init(void);
+
+/**
+ * @brief Account one write of ulBytes to a file, namespace or partition.
+ *        Storage and FatFS writes count ceil(bytes / 4 KB) erase-equivalents
+ *        each; NVS bytes should be the entry footprint (see NVS_API.c).
+ */
+void
+FlashStats_RecordWrite(FLASH_STATS_AREA_E eArea, const char* pcName, size_t ulBytes);
+
+/**
+ * @brief Account explicit sector erases on a raw partition.
+ */
+void
+FlashStats_RecordErase(FLASH_STATS_AREA_E eArea, const char* pcName, uint32_t ulSectors);
+
+/**
+ * @brief Copy the per-name counters (including "(other)" buckets).
+ * @return Number of entries written to ptOut.
+ */
+uint32_t
+FlashStats_GetEntries(FLASH_STATS_ENTRY_T* ptOut, uint32_t ulMax);
+
+void
+FlashStats_GetSummary(FLASH_STATS_SUMMARY_T* ptSummary);
+
+/**
+ * @brief Bytes per day extrapolated from the since-boot counters
+ *        (uptime is floored at one hour so boot-time writes do not spike it).
+ */
+uint64_t
+FlashStats_BootRatePerDay(uint64_t ullBootBytes);
+
+/**
+ * @brief Returns true if ullBootBytes exceeds CONFIG_FLASH_STATS_WARN_KB_PER_DAY.
+ */
+bool
+FlashStats_IsHot(uint64_t ullBootBytes);
+
+/**
+ * @brief Save the counters to NVS now (also done periodically and on reboot).
+ */
+esp_err_t
+FlashStats_Persist(void);
+
+const char*
+FlashStats_AreaToStr(FLASH_STATS_AREA_E eArea);
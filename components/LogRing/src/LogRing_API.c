@@ -0,0 +1,789 @@
+#include "LogRing_API.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "log_ring";
+
+#define RING_SIZE                   (CONFIG_LOG_RING_SIZE_KB * 1024U)
+#define RING_ALIGN                  8U
+#define RING_REC_MAX                256U    /* header + payload */
+#define RING_STR_MAX                96U     /* longer %s arguments: keep the formatted line */
+#define RING_HOPS_PER_LOCK          32U     /* bounds the time readers hold the spinlock */
+#define RING_TASK_STACK_SIZE        3072
+#define RING_TASK_PRIORITY          1
+#define RING_TASK_PERIOD_MS         50
+
+#define REC_FLAG_PAD                0x01    /* filler up to the end of the buffer */
+#define REC_FLAG_TEXT               0x02    /* payload is the formatted line */
+#define REC_FLAG_ECHOED             0x04    /* cut short here; printed in full when logged */
+
+#define RING_ROUND_UP(x)            (((x) + RING_ALIGN - 1U) & ~(RING_ALIGN - 1U))
+
+/* ------------------------------------------------------------------ */
+/* Record layout                                                       */
+/* ------------------------------------------------------------------ */
+
+/* Most lines are stored as the format pointer plus the raw argument
+ * values; esp_log formats are string literals in flash, so the pointer
+ * stays valid. Formatting happens later, on the formatter task or when
+ * the lines are read over HTTP. */
+typedef struct
+{
+    uint16_t    usLen;          /* whole record, multiple of RING_ALIGN */
+    uint8_t     ucFlags;
+    char        cLevel;
+    uint32_t    ulSeq;
+    uint32_t    ulTimeMs;
+    const char* pcFmt;
+} RING_REC_HDR_T;
+
+typedef struct
+{
+    RING_REC_HDR_T tHdr;
+    uint8_t        aucPayload[RING_REC_MAX - sizeof(RING_REC_HDR_T)];
+} RING_REC_T;
+
+typedef enum
+{
+    ARG_NONE = 0,               /* "%%" */
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_LDOUBLE,
+    ARG_PTR,
+    ARG_STR,
+    ARG_COUNT,                  /* "%n": consumed, never written */
+    ARG_BAD,                    /* not understood: format the line at log time */
+} ARG_CLASS_E;
+
+typedef struct
+{
+    char        acSpec[16];     /* the conversion, '*' left in place */
+    uint8_t     ucStars;        /* int arguments for '*' width / precision */
+    bool        bStarPrec;      /* precision is the last of those */
+    int         iPrec;          /* literal precision, -1 if none */
+    ARG_CLASS_E eClass;
+} FMT_SPEC_T;
+
+/* ------------------------------------------------------------------ */
+/* State                                                               */
+/* ------------------------------------------------------------------ */
+
+typedef struct
+{
+    uint8_t*            pucBuf;
+    uint32_t            ulSize;
+    uint64_t            ullHead;            /* next write position, never wraps */
+    uint64_t            ullTail;            /* oldest record */
+    uint32_t            ulSeq;              /* last sequence number handed out */
+    uint32_t            ulTextRecords;
+    portMUX_TYPE        tLock;              /* ring positions and contents */
+
+    vprintf_like_t      pfnUart;            /* esp_log output before Init */
+    SemaphoreHandle_t   hUartMutex;         /* formatter cursor and line buffer */
+    TaskHandle_t        hTask;
+    uint64_t            ullUartPos;
+    uint32_t            ulUartSeq;          /* last line printed */
+    uint32_t            ulUartSkipped;
+    RING_REC_T          tUartRec;
+    char                acUartLine[LOG_RING_LINE_MAX];
+
+    LOG_RING_LEVEL_T    atLevels[LOG_RING_MAX_TAG_LEVELS];
+    uint32_t            ulLevelCount;
+} RING_STATE_T;
+
+static RING_STATE_T s_tRing =
+{
+    .tLock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static const char* const s_apcLevelName[] =
+{
+    [ESP_LOG_NONE]    = "none",
+    [ESP_LOG_ERROR]   = "error",
+    [ESP_LOG_WARN]    = "warn",
+    [ESP_LOG_INFO]    = "info",
+    [ESP_LOG_DEBUG]   = "debug",
+    [ESP_LOG_VERBOSE] = "verbose",
+};
+
+/* ------------------------------------------------------------------ */
+/* Format walking                                                      */
+/* ------------------------------------------------------------------ */
+
+/* Parse the conversion starting at pcFmt ('%'); returns chars consumed */
+static size_t
+ring_ParseSpec(const char* pcFmt, FMT_SPEC_T* ptSpec)
+{
+    const char* p = pcFmt + 1;
+    int iLong = 0;
+    char cMod = '\0';
+
+    ptSpec->ucStars   = 0;
+    ptSpec->bStarPrec = false;
+    ptSpec->iPrec     = -1;
+    ptSpec->eClass    = ARG_BAD;
+
+    while (('\0' != *p) && (NULL != strchr("-+ #0", *p))) p++;
+    if ('*' == *p) { ptSpec->ucStars++; p++; }
+    while ((*p >= '0') && (*p <= '9')) p++;
+    if ('.' == *p)
+    {
+        p++;
+        if ('*' == *p) { ptSpec->ucStars++; ptSpec->bStarPrec = true; p++; }
+        ptSpec->iPrec = 0;
+        while ((*p >= '0') && (*p <= '9'))
+        {
+            if (ptSpec->iPrec < 10000) ptSpec->iPrec = (ptSpec->iPrec * 10) + (*p - '0');
+            p++;
+        }
+        if (ptSpec->bStarPrec) ptSpec->iPrec = -1;
+    }
+    while (('\0' != *p) && (NULL != strchr("hlLjzt", *p)))
+    {
+        if ('l' == *p) iLong++;
+        cMod = *p++;
+    }
+
+    const char cConv = *p;
+    if ('\0' == cConv) return (size_t)(p - pcFmt);
+    p++;
+
+    switch (cConv)
+    {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            ptSpec->eClass = ((iLong >= 2) || ('j' == cMod)) ? ARG_LLONG
+                           : (1 == iLong)                     ? ARG_LONG
+                           : ('z' == cMod)                    ? ARG_SIZE
+                           : ('t' == cMod)                    ? ARG_PTRDIFF
+                           :                                    ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            ptSpec->eClass = ('L' == cMod) ? ARG_LDOUBLE : ARG_DOUBLE;
+            break;
+        case 'p': ptSpec->eClass = ARG_PTR;   break;
+        case 's': ptSpec->eClass = ARG_STR;   break;
+        case 'n': ptSpec->eClass = ARG_COUNT; break;
+        case '%': ptSpec->eClass = ARG_NONE;  break;
+        default:  break;
+    }
+
+    const size_t ulLen = (size_t)(p - pcFmt);
+    if (ulLen >= sizeof(ptSpec->acSpec))
+    {
+        ptSpec->eClass = ARG_BAD;
+        return ulLen;
+    }
+    memcpy(ptSpec->acSpec, pcFmt, ulLen);
+    ptSpec->acSpec[ulLen] = '\0';
+    return ulLen;
+}
+
+#define RING_PUT(val)                                                       \
+    do {                                                                    \
+        if (pucOut + sizeof(val) > pucEnd) return false;                    \
+        memcpy(pucOut, &(val), sizeof(val));                                \
+        pucOut += sizeof(val);                                              \
+    } while (0)
+
+#define RING_GET(var)                                                       \
+    do {                                                                    \
+        if (pucIn + sizeof(var) > pucEnd) goto done;                        \
+        memcpy(&(var), pucIn, sizeof(var));                                 \
+        pucIn += sizeof(var);                                               \
+    } while (0)
+
+/* Store the arguments of one line; false if it does not fit */
+static bool
+ring_Capture(RING_REC_T* ptRec, const char* pcFmt, va_list tArgs)
+{
+    uint8_t* pucOut = ptRec->aucPayload;
+    uint8_t* const pucEnd = ptRec->aucPayload + sizeof(ptRec->aucPayload);
+
+    for (const char* p = pcFmt; '\0' != *p; )
+    {
+        if ('%' != *p)
+        {
+            p++;
+            continue;
+        }
+
+        FMT_SPEC_T tSpec;
+        p += ring_ParseSpec(p, &tSpec);
+
+        int iPrec = tSpec.iPrec;
+        for (uint8_t i = 0; i < tSpec.ucStars; i++)
+        {
+            int iStar = va_arg(tArgs, int);
+            RING_PUT(iStar);
+            /* A negative '*' precision counts as none */
+            if (tSpec.bStarPrec && (i + 1U == tSpec.ucStars)) iPrec = (iStar < 0) ? -1 : iStar;
+        }
+
+        switch (tSpec.eClass)
+        {
+            case ARG_NONE:    break;
+            case ARG_INT:     { int v = va_arg(tArgs, int);                  RING_PUT(v); break; }
+            case ARG_LONG:    { long v = va_arg(tArgs, long);                RING_PUT(v); break; }
+            case ARG_LLONG:   { long long v = va_arg(tArgs, long long);      RING_PUT(v); break; }
+            case ARG_SIZE:    { size_t v = va_arg(tArgs, size_t);            RING_PUT(v); break; }
+            case ARG_PTRDIFF: { ptrdiff_t v = va_arg(tArgs, ptrdiff_t);      RING_PUT(v); break; }
+            case ARG_DOUBLE:  { double v = va_arg(tArgs, double);            RING_PUT(v); break; }
+            case ARG_LDOUBLE: { long double v = va_arg(tArgs, long double);  RING_PUT(v); break; }
+            case ARG_PTR:     { void* v = va_arg(tArgs, void*);              RING_PUT(v); break; }
+            case ARG_COUNT:   (void)va_arg(tArgs, void*); break;
+            case ARG_STR:
+            {
+                /* The caller's buffer is gone by the time the line is printed.
+                 * A precision bounds the read: the buffer need not be terminated */
+                const char* pcStr = va_arg(tArgs, const char*);
+                if (NULL == pcStr) pcStr = "(null)";
+                size_t ulMax = RING_STR_MAX + 1U;
+                if ((iPrec >= 0) && ((size_t)iPrec < ulMax)) ulMax = (size_t)iPrec;
+                const size_t ulStr = strnlen(pcStr, ulMax);
+                /* Too long to copy whole: format the line now rather than cut it */
+                if (ulStr > RING_STR_MAX) return false;
+                const uint8_t ucLen = (uint8_t)ulStr;
+                if (pucOut + 1 + ucLen > pucEnd) return false;
+                *pucOut++ = ucLen;
+                memcpy(pucOut, pcStr, ucLen);
+                pucOut += ucLen;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    ptRec->tHdr.usLen = (uint16_t)RING_ROUND_UP(sizeof(RING_REC_HDR_T) + (size_t)(pucOut - ptRec->aucPayload));
+    return true;
+}
+
+/* Format one record into pcOut; always terminated and ends in '\n' */
+static void
+ring_Render(const RING_REC_T* ptRec, char* pcOut, size_t ulSize)
+{
+    size_t ulPos = 0;
+
+    if (0 != (ptRec->tHdr.ucFlags & REC_FLAG_TEXT))
+    {
+        ulPos = strlcpy(pcOut, (const char*)ptRec->aucPayload, ulSize);
+        if (ulPos >= ulSize) ulPos = ulSize - 1;
+        goto done;
+    }
+
+    const uint8_t* pucIn = ptRec->aucPayload;
+    const uint8_t* const pucEnd = (const uint8_t*)ptRec + ptRec->tHdr.usLen;
+
+    for (const char* p = ptRec->tHdr.pcFmt; ('\0' != *p) && (ulPos + 1 < ulSize); )
+    {
+        if ('%' != *p)
+        {
+            pcOut[ulPos++] = *p++;
+            continue;
+        }
+
+        FMT_SPEC_T tSpec;
+        p += ring_ParseSpec(p, &tSpec);
+        if (ARG_NONE == tSpec.eClass)
+        {
+            pcOut[ulPos++] = '%';
+            continue;
+        }
+
+        /* Put the stored '*' values back into the conversion */
+        char acSpec[sizeof(tSpec.acSpec) + 24];
+        size_t ulSpec = 0;
+        for (const char* s = tSpec.acSpec; '\0' != *s; s++)
+        {
+            if ('*' == *s)
+            {
+                int iStar = 0;
+                RING_GET(iStar);
+                ulSpec += (size_t)snprintf(&acSpec[ulSpec], sizeof(acSpec) - ulSpec, "%d", iStar);
+            }
+            else
+            {
+                acSpec[ulSpec++] = *s;
+            }
+        }
+        acSpec[ulSpec] = '\0';
+
+        char* pcDst = &pcOut[ulPos];
+        const size_t ulRoom = ulSize - ulPos;
+        int iLen = 0;
+
+        switch (tSpec.eClass)
+        {
+            case ARG_INT:     { int v;         RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_LONG:    { long v;        RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_LLONG:   { long long v;   RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_SIZE:    { size_t v;      RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_PTRDIFF: { ptrdiff_t v;   RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_DOUBLE:  { double v;      RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_LDOUBLE: { long double v; RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_PTR:     { void* v;       RING_GET(v); iLen = snprintf(pcDst, ulRoom, acSpec, v); break; }
+            case ARG_STR:
+            {
+                char acStr[RING_STR_MAX + 1];
+                if (pucIn >= pucEnd) goto done;
+                uint8_t ucLen = *pucIn++;
+                if (pucIn + ucLen > pucEnd) goto done;
+                memcpy(acStr, pucIn, ucLen);
+                acStr[ucLen] = '\0';
+                pucIn += ucLen;
+                iLen = snprintf(pcDst, ulRoom, acSpec, acStr);
+                break;
+            }
+            default:
+                break;
+        }
+
+        if (iLen > 0) ulPos += ((size_t)iLen < ulRoom) ? (size_t)iLen : ulRoom - 1;
+    }
+
+done:
+    if ((ulPos > 0) && ('\n' != pcOut[ulPos - 1]))
+    {
+        if (ulPos + 1 >= ulSize) ulPos--;
+        pcOut[ulPos++] = '\n';
+    }
+    pcOut[ulPos] = '\0';
+}
+
+/* Level letter of an esp_log line: "E (123) tag: ..." after any colour code */
+static char
+ring_LevelChar(const char* pcFmt)
+{
+    if ('\033' == pcFmt[0])
+    {
+        const char* pcEnd = strchr(pcFmt, 'm');
+        if (NULL == pcEnd) return '?';
+        pcFmt = pcEnd + 1;
+    }
+    return (('\0' != pcFmt[0]) && (NULL != strchr("EWIDV", pcFmt[0])) && (' ' == pcFmt[1])) ? pcFmt[0] : '?';
+}
+
+/* Strip colour codes and the newline, then split "L (ts) tag: msg" */
+static void
+ring_Split(char* pcLine, LOG_RING_ENTRY_T* ptEntry)
+{
+    char* pcDst = pcLine;
+    for (const char* s = pcLine; '\0' != *s; )
+    {
+        if ('\033' == *s)
+        {
+            const char* pcEnd = strchr(s, 'm');
+            if (NULL == pcEnd) break;
+            s = pcEnd + 1;
+            continue;
+        }
+        *pcDst++ = *s++;
+    }
+    while ((pcDst > pcLine) && (('\n' == pcDst[-1]) || ('\r' == pcDst[-1]))) pcDst--;
+    *pcDst = '\0';
+
+    ptEntry->pcTag = "";
+    ptEntry->pcMsg = pcLine;
+
+    if (('\0' == pcLine[0]) || (NULL == strchr("EWIDV", pcLine[0])) ||
+        (' ' != pcLine[1]) || ('(' != pcLine[2]))
+    {
+        return;
+    }
+    char* pcTag = strstr(pcLine, ") ");
+    if (NULL == pcTag) return;
+    pcTag += 2;
+    char* pcSep = strstr(pcTag, ": ");
+    if (NULL == pcSep) return;
+
+    *pcSep = '\0';
+    ptEntry->pcTag = pcTag;
+    ptEntry->pcMsg = pcSep + 2;
+}
+
+/* ------------------------------------------------------------------ */
+/* Ring                                                                */
+/* ------------------------------------------------------------------ */
+
+static inline RING_REC_HDR_T*
+ring_HdrAt(uint64_t ullPos)
+{
+    return (RING_REC_HDR_T*)&s_tRing.pucBuf[ullPos % s_tRing.ulSize];
+}
+
+static void
+ring_Commit(RING_REC_T* ptRec)
+{
+    const uint32_t ulLen = ptRec->tHdr.usLen;
+
+    taskENTER_CRITICAL(&s_tRing.tLock);
+
+    uint32_t ulOff = (uint32_t)(s_tRing.ullHead % s_tRing.ulSize);
+    const uint32_t ulPad = (ulOff + ulLen > s_tRing.ulSize) ? (s_tRing.ulSize - ulOff) : 0;
+
+    /* Drop the oldest lines until the record (and any filler) fits */
+    while (s_tRing.ullHead + ulPad + ulLen - s_tRing.ullTail > s_tRing.ulSize)
+    {
+        s_tRing.ullTail += ring_HdrAt(s_tRing.ullTail)->usLen;
+    }
+
+    if (0 != ulPad)
+    {
+        /* Only the first fields: a filler can be as short as RING_ALIGN */
+        RING_REC_HDR_T* ptPad = ring_HdrAt(s_tRing.ullHead);
+        ptPad->usLen   = (uint16_t)ulPad;
+        ptPad->ucFlags = REC_FLAG_PAD;
+        s_tRing.ullHead += ulPad;
+        ulOff = 0;
+    }
+
+    ptRec->tHdr.ulSeq = ++s_tRing.ulSeq;
+    if (0 != (ptRec->tHdr.ucFlags & REC_FLAG_TEXT)) s_tRing.ulTextRecords++;
+    memcpy(&s_tRing.pucBuf[ulOff], ptRec, ulLen);
+    s_tRing.ullHead += ulLen;
+
+    taskEXIT_CRITICAL(&s_tRing.tLock);
+}
+
+/* Copy out the next record at or after *pullPos with a sequence number
+ * above ulAfterSeq, and advance past it; false when caught up */
+static bool
+ring_Next(uint64_t* pullPos, uint32_t ulAfterSeq, RING_REC_T* ptOut)
+{
+    while (true)
+    {
+        taskENTER_CRITICAL(&s_tRing.tLock);
+
+        if (*pullPos < s_tRing.ullTail) *pullPos = s_tRing.ullTail;
+
+        for (uint32_t ulHops = 0; ulHops < RING_HOPS_PER_LOCK; ulHops++)
+        {
+            if (*pullPos >= s_tRing.ullHead)
+            {
+                taskEXIT_CRITICAL(&s_tRing.tLock);
+                return false;
+            }
+
+            const RING_REC_HDR_T* ptHdr = ring_HdrAt(*pullPos);
+            *pullPos += ptHdr->usLen;
+            if ((0 == (ptHdr->ucFlags & REC_FLAG_PAD)) && (ptHdr->ulSeq > ulAfterSeq))
+            {
+                memcpy(ptOut, ptHdr, ptHdr->usLen);
+                taskEXIT_CRITICAL(&s_tRing.tLock);
+                return true;
+            }
+        }
+
+        taskEXIT_CRITICAL(&s_tRing.tLock);
+    }
+}
+
+static void
+ring_Print(const char* pcFmt, ...)
+{
+    va_list tArgs;
+    va_start(tArgs, pcFmt);
+    s_tRing.pfnUart(pcFmt, tArgs);
+    va_end(tArgs);
+}
+
+/* Print everything not yet printed; caller holds hUartMutex */
+static void
+ring_DrainLocked(void)
+{
+    while (ring_Next(&s_tRing.ullUartPos, 0, &s_tRing.tUartRec))
+    {
+        const uint32_t ulSeq = s_tRing.tUartRec.tHdr.ulSeq;
+        if (ulSeq > s_tRing.ulUartSeq + 1)
+        {
+            const uint32_t ulLost = ulSeq - s_tRing.ulUartSeq - 1;
+            s_tRing.ulUartSkipped += ulLost;
+            ring_Print("W (%" PRIu32 ") %s: %" PRIu32 " lines overwritten before printing\n",
+                       esp_log_timestamp(), TAG, ulLost);
+        }
+        s_tRing.ulUartSeq = ulSeq;
+        if (0 != (s_tRing.tUartRec.tHdr.ucFlags & REC_FLAG_ECHOED)) continue;
+
+        ring_Render(&s_tRing.tUartRec, s_tRing.acUartLine, sizeof(s_tRing.acUartLine));
+        ring_Print("%s", s_tRing.acUartLine);
+    }
+}
+
+static void
+ring_Task(void* pvArg)
+{
+    (void)pvArg;
+
+    while (true)
+    {
+        xSemaphoreTake(s_tRing.hUartMutex, portMAX_DELAY);
+        ring_DrainLocked();
+        xSemaphoreGive(s_tRing.hUartMutex);
+
+        vTaskDelay(pdMS_TO_TICKS(RING_TASK_PERIOD_MS));
+    }
+}
+
+static void
+ring_ShutdownHandler(void)
+{
+    /* Let the lines leading up to esp_restart() reach the UART */
+    if (pdTRUE == xSemaphoreTake(s_tRing.hUartMutex, pdMS_TO_TICKS(100)))
+    {
+        ring_DrainLocked();
+        xSemaphoreGive(s_tRing.hUartMutex);
+    }
+}
+
+/* A text line longer than a record: the ring keeps it cut short, the UART
+ * gets it whole. Pending lines are printed first so the order holds */
+static void
+ring_EchoFull(const char* pcFmt, va_list tArgs)
+{
+    const bool bLocked = (pdTRUE == xSemaphoreTake(s_tRing.hUartMutex, pdMS_TO_TICKS(100)));
+    if (bLocked) ring_DrainLocked();
+    s_tRing.pfnUart(pcFmt, tArgs);
+    if (bLocked) xSemaphoreGive(s_tRing.hUartMutex);
+}
+
+/* esp_log output: runs in the logging task, so keep it short */
+static int
+ring_Vprintf(const char* pcFmt, va_list tArgs)
+{
+    RING_REC_T tRec;
+    tRec.tHdr.ucFlags  = 0;
+    tRec.tHdr.cLevel   = ring_LevelChar(pcFmt);
+    tRec.tHdr.ulTimeMs = esp_log_timestamp();
+    tRec.tHdr.pcFmt    = pcFmt;
+
+    va_list tCopy;
+    va_copy(tCopy, tArgs);
+    /* On the S3 PSRAM shares the DROM address range; only flash lasts */
+    const bool bBinary = esp_ptr_in_drom(pcFmt) && !esp_ptr_external_ram(pcFmt) &&
+                         ring_Capture(&tRec, pcFmt, tCopy);
+    va_end(tCopy);
+
+    bool bEcho = false;
+    if (!bBinary)
+    {
+        /* Format built at runtime, or too many arguments: keep the text */
+        char* pcText = (char*)tRec.aucPayload;
+        va_copy(tCopy, tArgs);
+        int iLen = vsnprintf(pcText, sizeof(tRec.aucPayload), pcFmt, tCopy);
+        va_end(tCopy);
+        if (iLen < 0) return iLen;
+        size_t ulLen = strlen(pcText);
+        bEcho = ((size_t)iLen >= sizeof(tRec.aucPayload));
+        tRec.tHdr.ucFlags = REC_FLAG_TEXT | (bEcho ? REC_FLAG_ECHOED : 0);
+        tRec.tHdr.usLen   = (uint16_t)RING_ROUND_UP(sizeof(RING_REC_HDR_T) + ulLen + 1);
+    }
+
+    ring_Commit(&tRec);
+
+    /* Committed first, so the formatter skips it rather than printing it cut */
+    if (bEcho) ring_EchoFull(pcFmt, tArgs);
+
+#if CONFIG_LOG_RING_FLUSH_ON_ERROR
+    /* Errors reach the UART before the caller carries on, in case it is
+     * about to crash. If the formatter is printing, it will get there */
+    if (('E' == tRec.tHdr.cLevel) && (pdTRUE == xSemaphoreTake(s_tRing.hUartMutex, 0)))
+    {
+        ring_DrainLocked();
+        xSemaphoreGive(s_tRing.hUartMutex);
+    }
+#endif
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+LogRing_Init(void)
+{
+    if (NULL != s_tRing.pucBuf) return ESP_OK;
+
+    strlcpy(s_tRing.atLevels[0].acTag, "*", sizeof(s_tRing.atLevels[0].acTag));
+    s_tRing.atLevels[0].eLevel = (esp_log_level_t)CONFIG_LOG_DEFAULT_LEVEL;
+    s_tRing.ulLevelCount = 1;
+
+    s_tRing.hUartMutex = xSemaphoreCreateMutex();
+    if (NULL == s_tRing.hUartMutex) return ESP_ERR_NO_MEM;
+
+    uint8_t* pucBuf = (uint8_t*)heap_caps_malloc(RING_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (NULL == pucBuf)
+    {
+        ESP_LOGW(TAG, "No PSRAM for the %u KB ring, logging stays synchronous",
+                 (unsigned)CONFIG_LOG_RING_SIZE_KB);
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t xResult = xTaskCreate(ring_Task, "LOG_RING",
+                                     RING_TASK_STACK_SIZE,
+                                     NULL,
+                                     RING_TASK_PRIORITY,
+                                     &s_tRing.hTask);
+    if (pdPASS != xResult)
+    {
+        heap_caps_free(pucBuf);
+        return ESP_FAIL;
+    }
+
+    s_tRing.ulSize  = RING_SIZE;
+    s_tRing.pucBuf  = pucBuf;
+    s_tRing.pfnUart = esp_log_set_vprintf(ring_Vprintf);
+
+    esp_err_t err = esp_register_shutdown_handler(ring_ShutdownHandler);
+    if (ESP_OK != err)
+    {
+        ESP_LOGW(TAG, "Shutdown hook not registered: %s", esp_err_to_name(err));
+    }
+
+    ESP_LOGI(TAG, "Logging to a %u KB ring, UART output deferred", (unsigned)CONFIG_LOG_RING_SIZE_KB);
+    return ESP_OK;
+}
+
+uint32_t
+LogRing_Read(uint32_t ulAfterSeq, uint32_t ulMax, LOG_RING_VISIT_FN pfnVisit, void* pvCtx)
+{
+    if ((NULL == s_tRing.pucBuf) || (NULL == pfnVisit)) return ulAfterSeq;
+
+    RING_REC_T* ptRec = (RING_REC_T*)malloc(sizeof(RING_REC_T) + LOG_RING_LINE_MAX);
+    if (NULL == ptRec) return ulAfterSeq;
+    char* pcLine = (char*)(ptRec + 1);
+
+    uint64_t ullPos = 0;
+    uint32_t ulLast = ulAfterSeq;
+
+    for (uint32_t i = 0; (i < ulMax) && ring_Next(&ullPos, ulAfterSeq, ptRec); i++)
+    {
+        ring_Render(ptRec, pcLine, LOG_RING_LINE_MAX);
+
+        LOG_RING_ENTRY_T tEntry =
+        {
+            .ulSeq    = ptRec->tHdr.ulSeq,
+            .ulTimeMs = ptRec->tHdr.ulTimeMs,
+            .cLevel   = ptRec->tHdr.cLevel,
+        };
+        ring_Split(pcLine, &tEntry);
+
+        ulLast = tEntry.ulSeq;
+        if (!pfnVisit(&tEntry, pvCtx)) break;
+    }
+
+    free(ptRec);
+    return ulLast;
+}
+
+void
+LogRing_GetStats(LOG_RING_STATS_T* ptStats)
+{
+    memset(ptStats, 0, sizeof(*ptStats));
+    if (NULL == s_tRing.pucBuf) return;
+
+    taskENTER_CRITICAL(&s_tRing.tLock);
+    ptStats->ulCapacity    = s_tRing.ulSize;
+    ptStats->ulUsed        = (uint32_t)(s_tRing.ullHead - s_tRing.ullTail);
+    ptStats->ulLastSeq     = s_tRing.ulSeq;
+    ptStats->ulTextRecords = s_tRing.ulTextRecords;
+    for (uint64_t ullPos = s_tRing.ullTail; ullPos < s_tRing.ullHead; )
+    {
+        const RING_REC_HDR_T* ptHdr = ring_HdrAt(ullPos);
+        if (0 == (ptHdr->ucFlags & REC_FLAG_PAD))
+        {
+            ptStats->ulFirstSeq = ptHdr->ulSeq;
+            break;
+        }
+        ullPos += ptHdr->usLen;
+    }
+    taskEXIT_CRITICAL(&s_tRing.tLock);
+
+    ptStats->ulUartSkipped = s_tRing.ulUartSkipped;
+}
+
+esp_err_t
+LogRing_SetLevel(const char* pcTag, esp_log_level_t eLevel)
+{
+    if ((NULL == pcTag) || ('\0' == pcTag[0]) || (strlen(pcTag) >= LOG_RING_TAG_LEN) ||
+        (eLevel > ESP_LOG_VERBOSE))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_tRing.tLock);
+
+    uint32_t i = 0;
+    if (0 == strcmp(pcTag, "*"))
+    {
+        /* esp_log forgets the per-tag levels when the default is set */
+        s_tRing.ulLevelCount = 1;
+    }
+    else
+    {
+        for (i = 1; (i < s_tRing.ulLevelCount) && (0 != strcmp(s_tRing.atLevels[i].acTag, pcTag)); i++) { }
+        if (i == s_tRing.ulLevelCount)
+        {
+            if (i >= LOG_RING_MAX_TAG_LEVELS)
+            {
+                taskEXIT_CRITICAL(&s_tRing.tLock);
+                return ESP_ERR_NO_MEM;
+            }
+            strlcpy(s_tRing.atLevels[i].acTag, pcTag, sizeof(s_tRing.atLevels[i].acTag));
+            s_tRing.ulLevelCount++;
+        }
+    }
+    s_tRing.atLevels[i].eLevel = eLevel;
+
+    taskEXIT_CRITICAL(&s_tRing.tLock);
+
+    esp_log_level_set(pcTag, eLevel);
+    return ESP_OK;
+}
+
+uint32_t
+LogRing_GetLevels(LOG_RING_LEVEL_T* ptOut, uint32_t ulMax)
+{
+    taskENTER_CRITICAL(&s_tRing.tLock);
+    uint32_t ulCount = (s_tRing.ulLevelCount < ulMax) ? s_tRing.ulLevelCount : ulMax;
+    memcpy(ptOut, s_tRing.atLevels, ulCount * sizeof(LOG_RING_LEVEL_T));
+    taskEXIT_CRITICAL(&s_tRing.tLock);
+    return ulCount;
+}
+
+const char*
+LogRing_LevelToStr(esp_log_level_t eLevel)
+{
+    return (eLevel <= ESP_LOG_VERBOSE) ? s_apcLevelName[eLevel] : "unknown";
+}
+
+bool
+LogRing_LevelFromStr(const char* pcStr, esp_log_level_t* peLevel)
+{
+    if (NULL == pcStr) return false;
+
+    for (int i = ESP_LOG_NONE; i <= ESP_LOG_VERBOSE; i++)
+    {
+        if (0 == strcmp(pcStr, s_apcLevelName[i]))
+        {
+            *peLevel = (esp_log_level_t)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ------------------------------------------------------------------ */
+/* Limits                                                              */
+/* ------------------------------------------------------------------ */
+#define LOG_RING_TAG_LEN            16      /* per-tag level overrides, truncated */
+#define LOG_RING_MAX_TAG_LEVELS     16
+#define LOG_RING_LINE_MAX           320     /* one formatted line, longer is cut */
+
+typedef struct
+{
+    uint32_t    ulSeq;          /* 1-based, increases by one per line */
+    uint32_t    ulTimeMs;       /* esp_log_timestamp() when logged */
+    char        cLevel;         /* 'E', 'W', 'I', 'D', 'V', or '?' */
+    const char* pcTag;          /* valid for the callback only */
+    const char* pcMsg;          /* without prefix, colour codes or newline */
+} LOG_RING_ENTRY_T;
+
+/**
+ * @brief Called once per line by LogRing_Read(), outside any lock.
+ * @return false to stop early.
+ */
+typedef bool (*LOG_RING_VISIT_FN)(const LOG_RING_ENTRY_T* ptEntry, void* pvCtx);
+
+typedef struct
+{
+    uint32_t ulCapacity;        /* ring bytes, 0 when not running */
+    uint32_t ulUsed;
+    uint32_t ulFirstSeq;        /* oldest line still held, 0 when empty */
+    uint32_t ulLastSeq;         /* newest line logged */
+    uint32_t ulTextRecords;     /* lines formatted at log time (non-literal or oversized) */
+    uint32_t ulUartSkipped;     /* lines overwritten before the formatter printed them */
+} LOG_RING_STATS_T;
+
+typedef struct
+{
+    char            acTag[LOG_RING_TAG_LEN];    /* "*" for the default */
+    esp_log_level_t eLevel;
+} LOG_RING_LEVEL_T;
+
+/**
+ * @brief Allocate the ring and take over esp_log output. Call first thing
+ *        at start-up; lines logged before it go straight to the UART.
+ *        Without the ring buffer logging stays synchronous, as before.
+ */
+esp_err_t
+LogRing_Init(void);
+
+/**
+ * @brief Visit up to ulMax lines with a sequence number above ulAfterSeq,
+ *        oldest first.
+ * @return Sequence number of the last line visited, or ulAfterSeq if none.
+ */
+uint32_t
+LogRing_Read(uint32_t ulAfterSeq, uint32_t ulMax, LOG_RING_VISIT_FN pfnVisit, void* pvCtx);
+
+void
+LogRing_GetStats(LOG_RING_STATS_T* ptStats);
+
+/**
+ * @brief esp_log_level_set() that is remembered for LogRing_GetLevels().
+ *        Tag "*" sets the default. Levels above CONFIG_LOG_MAXIMUM_LEVEL
+ *        are accepted but have no effect: those calls are compiled out.
+ */
+esp_err_t
+LogRing_SetLevel(const char* pcTag, esp_log_level_t eLevel);
+
+/**
+ * @brief Copy the default ("*", always first) and the per-tag overrides.
+ * @return Number of entries written.
+ */
+uint32_t
+LogRing_GetLevels(LOG_RING_LEVEL_T* ptOut, uint32_t ulMax);
+
+const char*
+LogRing_LevelToStr(esp_log_level_t eLevel);
+
+/**
+ * @brief Parse "none", "error", "warn", "info", "debug" or "verbose".
+ */
+bool
+LogRing_LevelFromStr(const char* pcStr, esp_log_level_t* peLevel);
@@ -2,11 +2,45 @@
 #include "nvs.h"
 #include "AppErrors.h"
 #include "esp_log.h"
+#include "FlashStats_API.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
 
 // TODO: Null checks and param validations
 
 static const char* TAG = "NVS_API";
 
+/* Handle -> namespace, so writes can be accounted per namespace */
+#define NVS_API_MAX_OPEN_HANDLES    8
+
+typedef struct
+{
+    nvs_handle_t hHandle;
+    char         acNamespace[NVS_NS_NAME_MAX_SIZE];
+} NVS_OPEN_HANDLE_T;
+
+static NVS_OPEN_HANDLE_T s_atOpen[NVS_API_MAX_OPEN_HANDLES];
+static portMUX_TYPE      s_tOpenLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void
+nvs_RecordWrite(nvs_handle_t hNvsHandle, size_t ulFootprint)
+{
+    char acNamespace[NVS_NS_NAME_MAX_SIZE] = "(unknown)";
+
+    taskENTER_CRITICAL(&s_tOpenLock);
+    for (int i = 0; i < NVS_API_MAX_OPEN_HANDLES; i++)
+    {
+        if ((0 != s_atOpen[i].hHandle) && (s_atOpen[i].hHandle == hNvsHandle))
+        {
+            memcpy(acNamespace, s_atOpen[i].acNamespace, sizeof(acNamespace));
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_tOpenLock);
+
+    FlashStats_RecordWrite(FLASH_STATS_AREA_NVS, acNamespace, ulFootprint);
+}
+
 esp_err_t
 NVS_Init(void)  
 {
@@ -26,7 +60,41 @@ NVS_Deinit(void)
 esp_err_t
 NVS_Open(const char* pcNamespace, uint8_t usOpenMode, nvs_handle_t* phNVSHandle)
 {
-    return nvs_open(pcNamespace, usOpenMode, phNVSHandle);
+    esp_err_t espRslt = nvs_open(pcNamespace, usOpenMode, phNVSHandle);
+
+    if ((ESP_OK == espRslt) && (NVS_READWRITE == usOpenMode))
+    {
+        taskENTER_CRITICAL(&s_tOpenLock);
+        for (int i = 0; i < NVS_API_MAX_OPEN_HANDLES; i++)
+        {
+            if (0 == s_atOpen[i].hHandle)
+            {
+                s_atOpen[i].hHandle = *phNVSHandle;
+                strlcpy(s_atOpen[i].acNamespace, pcNamespace, sizeof(s_atOpen[i].acNamespace));
+                break;
+            }
+        }
+        taskEXIT_CRITICAL(&s_tOpenLock);
+    }
+
+    return espRslt;
+}
+
+size_t
+NVS_EntryFootprint(size_t ulDataLen, bool bBlob)
+{
+    /* 32-byte entry header, data padded to 32-byte spans; blobs add a
+     * 32-byte index entry. Fixed-size values fit in the header. */
+    size_t ulSize = 32;
+    if (ulDataLen > 0)
+    {
+        ulSize += (ulDataLen + 31) & ~(size_t)31;
+    }
+    if (bBlob)
+    {
+        ulSize += 32;
+    }
+    return ulSize;
 }
 
 esp_err_t
@@ -48,7 +116,12 @@ NVS_ReadString(nvs_handle_t hNvsHandle, const char* pcKey, void* pvOutBuffer, si
 esp_err_t
 NVS_WriteString(nvs_handle_t hNvsHandle, const char* pcKey, const void* pvInBuffer)
 {
-    return nvs_set_str(hNvsHandle, pcKey, (const char*)pvInBuffer);
+    esp_err_t espRslt = nvs_set_str(hNvsHandle, pcKey, (const char*)pvInBuffer);
+    if (ESP_OK == espRslt)
+    {
+        nvs_RecordWrite(hNvsHandle, NVS_EntryFootprint(strlen((const char*)pvInBuffer) + 1, false));
+    }
+    return espRslt;
 }   
 
 esp_err_t
@@ -60,7 +133,12 @@ NVS_Read(nvs_handle_t hNvsHandle, const char* pcKey, void* pvOutBuffer, size_t*
 esp_err_t
 NVS_Write(nvs_handle_t hNvsHandle, const char* pcKey, const void* pvInBuffer, size_t usInBufferLen)
 {
-    return nvs_set_blob(hNvsHandle, pcKey, pvInBuffer, usInBufferLen);
+    esp_err_t espRslt = nvs_set_blob(hNvsHandle, pcKey, pvInBuffer, usInBufferLen);
+    if (ESP_OK == espRslt)
+    {
+        nvs_RecordWrite(hNvsHandle, NVS_EntryFootprint(usInBufferLen, true));
+    }
+    return espRslt;
 }  
 
 esp_err_t
@@ -72,6 +150,17 @@ NVS_Commit(nvs_handle_t hNvsHandle)
 esp_err_t
 NVS_Close(nvs_handle_t hNVSHandle)
 {
+    taskENTER_CRITICAL(&s_tOpenLock);
+    for (int i = 0; i < NVS_API_MAX_OPEN_HANDLES; i++)
+    {
+        if (s_atOpen[i].hHandle == hNVSHandle)
+        {
+            s_atOpen[i].hHandle = 0;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_tOpenLock);
+
     nvs_close(hNVSHandle);
     return APP_SUCCESS;
 }
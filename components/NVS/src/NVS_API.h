@@ -1,5 +1,7 @@
 #include "nvs_flash.h"
 #include "nvs.h"
+#include <stdbool.h>
+#include <stddef.h>
 
 esp_err_t
 NVS_Init(void);
@@ -10,6 +12,13 @@ NVS_Deinit(void);
 esp_err_t
 NVS_Open(const char* pcNamespace, uint8_t usOpenMode, nvs_handle_t* phNvsHandle);
 
+/**
+ * @brief Estimated flash bytes one write of ulDataLen consumes in an NVS
+ *        page (used for write accounting, see FlashStats).
+ */
+size_t
+NVS_EntryFootprint(size_t ulDataLen, bool bBlob);
+
 esp_err_t
 NVS_ReadString(nvs_handle_t hNvsHandle, const char* pcKey, void* pvOutBuffer, size_t* pusOutBufferLen);
 
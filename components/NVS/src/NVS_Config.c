@@ -0,0 +1,681 @@
+#include "NVS_Config.h"
+#include "NVS_API.h"
+#include "FlashStats_API.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+static const char* TAG = "nvs_config";
+
+#define CONFIG_TASK_STACK_SIZE      3072
+#define CONFIG_TASK_PRIORITY        2
+#define CONFIG_DELAY_MS             CONFIG_NVS_CONFIG_COMMIT_DELAY_MS
+#define CONFIG_CACHE_ENTRIES        CONFIG_NVS_CONFIG_CACHE_ENTRIES
+
+/* ------------------------------------------------------------------ */
+/* State                                                               */
+/* ------------------------------------------------------------------ */
+
+typedef enum
+{
+    CFG_TYPE_STR = 0,
+    CFG_TYPE_BLOB,
+    CFG_TYPE_U8,
+} CFG_TYPE_E;
+
+typedef enum
+{
+    CFG_STATE_FREE = 0,
+    CFG_STATE_PRESENT,          /* value known */
+    CFG_STATE_ABSENT,           /* key known not to exist (negative cache) */
+} CFG_STATE_E;
+
+typedef struct
+{
+    uint8_t  ucNs;              /* index into atNs */
+    uint8_t  eState;            /* CFG_STATE_E */
+    uint8_t  eType;             /* CFG_TYPE_E */
+    bool     bDirty;
+    uint16_t usLen;             /* strings include the terminator */
+    uint32_t ulLastUse;
+    char     acKey[NVS_KEY_NAME_MAX_SIZE];
+    uint8_t  aucData[NVS_CONFIG_VALUE_MAX];
+} CFG_ENTRY_T;
+
+typedef struct
+{
+    char         acName[NVS_NS_NAME_MAX_SIZE];
+    nvs_handle_t hHandle;
+    bool         bOpen;
+    bool         bDirty;
+} CFG_NS_T;
+
+typedef struct
+{
+    SemaphoreHandle_t  hMutex;
+    TaskHandle_t       hTask;
+    esp_timer_handle_t hTimer;
+    bool               bTimerArmed;
+    uint32_t           ulUseClock;
+    CFG_NS_T           atNs[NVS_CONFIG_NAMESPACE_MAX];
+    CFG_ENTRY_T        atEntries[CONFIG_CACHE_ENTRIES];
+    NVS_CONFIG_STATS_T tStats;
+} CFG_STATE_T;
+
+static CFG_STATE_T s_tCfg;
+
+/* ------------------------------------------------------------------ */
+/* Helpers (mutex held)                                                */
+/* ------------------------------------------------------------------ */
+
+static int
+cfg_GetNamespace(const char* pcNamespace, bool bCreate)
+{
+    int iFree = -1;
+
+    for (int i = 0; i < NVS_CONFIG_NAMESPACE_MAX; i++)
+    {
+        if (!s_tCfg.atNs[i].bOpen)
+        {
+            if (iFree < 0) iFree = i;
+            continue;
+        }
+        if (strcmp(s_tCfg.atNs[i].acName, pcNamespace) == 0) return i;
+    }
+
+    if (!bCreate) return -1;
+    if (iFree < 0)
+    {
+        ESP_LOGE(TAG, "No handle slot for namespace '%s'", pcNamespace);
+        return -1;
+    }
+
+    /* READWRITE creates the namespace on first use; reads of a fresh
+     * namespace then report ESP_ERR_NVS_NOT_FOUND per key as before. */
+    CFG_NS_T* ptNs = &s_tCfg.atNs[iFree];
+    esp_err_t err = nvs_open(pcNamespace, NVS_READWRITE, &ptNs->hHandle);
+    if (ESP_OK != err)
+    {
+        ESP_LOGE(TAG, "nvs_open('%s') failed: %s", pcNamespace, esp_err_to_name(err));
+        return -1;
+    }
+
+    strlcpy(ptNs->acName, pcNamespace, sizeof(ptNs->acName));
+    ptNs->bOpen  = true;
+    ptNs->bDirty = false;
+    return iFree;
+}
+
+static CFG_ENTRY_T*
+cfg_Find(int iNs, const char* pcKey)
+{
+    for (int i = 0; i < CONFIG_CACHE_ENTRIES; i++)
+    {
+        CFG_ENTRY_T* ptEntry = &s_tCfg.atEntries[i];
+        if ((CFG_STATE_FREE != ptEntry->eState) &&
+            (ptEntry->ucNs == iNs) &&
+            (strcmp(ptEntry->acKey, pcKey) == 0))
+        {
+            ptEntry->ulLastUse = ++s_tCfg.ulUseClock;
+            return ptEntry;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t
+cfg_WriteEntry(const CFG_ENTRY_T* ptEntry)
+{
+    nvs_handle_t hNvs = s_tCfg.atNs[ptEntry->ucNs].hHandle;
+
+    if (CFG_STATE_ABSENT == ptEntry->eState)
+    {
+        esp_err_t err = nvs_erase_key(hNvs, ptEntry->acKey);
+        return (ESP_ERR_NVS_NOT_FOUND == err) ? ESP_OK : err;
+    }
+
+    switch (ptEntry->eType)
+    {
+        case CFG_TYPE_STR:  return nvs_set_str(hNvs, ptEntry->acKey, (const char*)ptEntry->aucData);
+        case CFG_TYPE_U8:   return nvs_set_u8(hNvs, ptEntry->acKey, ptEntry->aucData[0]);
+        default:            return nvs_set_blob(hNvs, ptEntry->acKey, ptEntry->aucData, ptEntry->usLen);
+    }
+}
+
+static esp_err_t
+cfg_FlushLocked(void)
+{
+    esp_err_t errRet = ESP_OK;
+    uint32_t ulWritten = 0;
+
+    if (s_tCfg.bTimerArmed)
+    {
+        esp_timer_stop(s_tCfg.hTimer);
+        s_tCfg.bTimerArmed = false;
+    }
+
+    for (int i = 0; i < CONFIG_CACHE_ENTRIES; i++)
+    {
+        CFG_ENTRY_T* ptEntry = &s_tCfg.atEntries[i];
+        if ((CFG_STATE_FREE == ptEntry->eState) || !ptEntry->bDirty) continue;
+
+        esp_err_t err = cfg_WriteEntry(ptEntry);
+        s_tCfg.tStats.ulWrites++;
+        if (ESP_OK != err)
+        {
+            /* Stays dirty and is retried on the next flush */
+            ESP_LOGE(TAG, "Write of %s/%s failed: %s",
+                     s_tCfg.atNs[ptEntry->ucNs].acName, ptEntry->acKey, esp_err_to_name(err));
+            s_tCfg.tStats.ulWriteErrors++;
+            errRet = err;
+            continue;
+        }
+
+        ptEntry->bDirty = false;
+        s_tCfg.atNs[ptEntry->ucNs].bDirty = true;
+        s_tCfg.tStats.ulDirty--;
+        ulWritten++;
+
+        /* Erases only flip entry state bits; count them without bytes */
+        size_t ulFootprint = (CFG_STATE_ABSENT == ptEntry->eState) ? 0
+                           : NVS_EntryFootprint((CFG_TYPE_U8 == ptEntry->eType) ? 0 : ptEntry->usLen,
+                                                CFG_TYPE_BLOB == ptEntry->eType);
+        FlashStats_RecordWrite(FLASH_STATS_AREA_NVS, s_tCfg.atNs[ptEntry->ucNs].acName, ulFootprint);
+    }
+
+    for (int i = 0; i < NVS_CONFIG_NAMESPACE_MAX; i++)
+    {
+        CFG_NS_T* ptNs = &s_tCfg.atNs[i];
+        if (!ptNs->bOpen || !ptNs->bDirty) continue;
+
+        esp_err_t err = nvs_commit(ptNs->hHandle);
+        s_tCfg.tStats.ulCommits++;
+        if (ESP_OK != err)
+        {
+            ESP_LOGE(TAG, "Commit of '%s' failed: %s", ptNs->acName, esp_err_to_name(err));
+            s_tCfg.tStats.ulWriteErrors++;
+            errRet = err;
+            continue;
+        }
+        ptNs->bDirty = false;
+    }
+
+    if (ulWritten > 0) s_tCfg.tStats.ulFlushes++;
+
+    if ((0 != s_tCfg.tStats.ulDirty) && (CONFIG_DELAY_MS > 0))
+    {
+        esp_timer_start_once(s_tCfg.hTimer, (uint64_t)CONFIG_DELAY_MS * 1000ULL);
+        s_tCfg.bTimerArmed = true;
+    }
+
+    return errRet;
+}
+
+/** Free slot, else the least recently used clean one. */
+static CFG_ENTRY_T*
+cfg_Alloc(int iNs, const char* pcKey)
+{
+    CFG_ENTRY_T* ptVictim = NULL;
+
+    for (int iPass = 0; (iPass < 2) && (NULL == ptVictim); iPass++)
+    {
+        for (int i = 0; i < CONFIG_CACHE_ENTRIES; i++)
+        {
+            CFG_ENTRY_T* ptEntry = &s_tCfg.atEntries[i];
+            if (CFG_STATE_FREE == ptEntry->eState)
+            {
+                ptVictim = ptEntry;
+                break;
+            }
+            if (ptEntry->bDirty) continue;
+            if ((NULL == ptVictim) || (ptEntry->ulLastUse < ptVictim->ulLastUse))
+            {
+                ptVictim = ptEntry;
+            }
+        }
+
+        /* Every slot is waiting to be written: flush early to make room */
+        if ((NULL == ptVictim) && (0 == iPass)) cfg_FlushLocked();
+    }
+
+    if (NULL == ptVictim) return NULL;
+
+    /* An evicted slot stays in use: only free -> used counts */
+    if (CFG_STATE_FREE == ptVictim->eState) s_tCfg.tStats.ulCacheUsed++;
+
+    memset(ptVictim, 0, sizeof(*ptVictim));
+    ptVictim->ucNs      = (uint8_t)iNs;
+    ptVictim->eState    = CFG_STATE_ABSENT;
+    ptVictim->ulLastUse = ++s_tCfg.ulUseClock;
+    strlcpy(ptVictim->acKey, pcKey, sizeof(ptVictim->acKey));
+    return ptVictim;
+}
+
+/** Return a slot to the free pool; counted only on the used -> free step */
+static void
+cfg_Release(CFG_ENTRY_T* ptEntry)
+{
+    if (CFG_STATE_FREE == ptEntry->eState) return;
+
+    if (ptEntry->bDirty) s_tCfg.tStats.ulDirty--;
+    memset(ptEntry, 0, sizeof(*ptEntry));
+    s_tCfg.tStats.ulCacheUsed--;
+}
+
+/** Fill a fresh entry from NVS. ESP_ERR_NVS_INVALID_LENGTH = too big to cache. */
+static esp_err_t
+cfg_Load(CFG_ENTRY_T* ptEntry, CFG_TYPE_E eType)
+{
+    nvs_handle_t hNvs = s_tCfg.atNs[ptEntry->ucNs].hHandle;
+    size_t ulLen = sizeof(ptEntry->aucData);
+    esp_err_t err;
+
+    s_tCfg.tStats.ulMisses++;
+
+    switch (eType)
+    {
+        case CFG_TYPE_STR:
+            err = nvs_get_str(hNvs, ptEntry->acKey, (char*)ptEntry->aucData, &ulLen);
+            break;
+        case CFG_TYPE_U8:
+            err = nvs_get_u8(hNvs, ptEntry->acKey, &ptEntry->aucData[0]);
+            ulLen = 1;
+            break;
+        default:
+            err = nvs_get_blob(hNvs, ptEntry->acKey, ptEntry->aucData, &ulLen);
+            break;
+    }
+
+    if (ESP_ERR_NVS_NOT_FOUND == err)
+    {
+        ptEntry->eState = CFG_STATE_ABSENT;
+        return ESP_OK;
+    }
+    if (ESP_OK != err) return err;
+
+    ptEntry->eState = CFG_STATE_PRESENT;
+    ptEntry->eType  = (uint8_t)eType;
+    ptEntry->usLen  = (uint16_t)ulLen;
+    return ESP_OK;
+}
+
+/** Read through the cache. Values too big for a slot are read directly. */
+static esp_err_t
+cfg_Get(const char* pcNamespace, const char* pcKey, CFG_TYPE_E eType,
+        void* pvOut, size_t* pulLen)
+{
+    if ((NULL == pcNamespace) || (NULL == pcKey) || (NULL == pulLen)) return ESP_ERR_INVALID_ARG;
+    if (strlen(pcKey) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_KEY_TOO_LONG;
+    if (NULL == s_tCfg.hMutex) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(s_tCfg.hMutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_OK;
+    int iNs = cfg_GetNamespace(pcNamespace, true);
+    if (iNs < 0)
+    {
+        xSemaphoreGive(s_tCfg.hMutex);
+        return ESP_FAIL;
+    }
+
+    CFG_ENTRY_T* ptEntry = cfg_Find(iNs, pcKey);
+    if (NULL != ptEntry)
+    {
+        s_tCfg.tStats.ulHits++;
+    }
+    else if (NULL != (ptEntry = cfg_Alloc(iNs, pcKey)))
+    {
+        err = cfg_Load(ptEntry, eType);
+        if (ESP_OK != err)
+        {
+            cfg_Release(ptEntry);
+            ptEntry = NULL;
+        }
+    }
+
+    if (NULL == ptEntry)
+    {
+        /* Uncacheable: straight from NVS, same semantics as the nvs_get_* call */
+        nvs_handle_t hNvs = s_tCfg.atNs[iNs].hHandle;
+        switch (eType)
+        {
+            case CFG_TYPE_STR:  err = nvs_get_str(hNvs, pcKey, (char*)pvOut, pulLen); break;
+            case CFG_TYPE_U8:   err = nvs_get_u8(hNvs, pcKey, (uint8_t*)pvOut); break;
+            default:            err = nvs_get_blob(hNvs, pcKey, pvOut, pulLen); break;
+        }
+    }
+    else if (CFG_STATE_ABSENT == ptEntry->eState)
+    {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    }
+    else if (ptEntry->eType != eType)
+    {
+        err = ESP_ERR_NVS_TYPE_MISMATCH;
+    }
+    else if (NULL == pvOut)
+    {
+        *pulLen = ptEntry->usLen;
+    }
+    else if (*pulLen < ptEntry->usLen)
+    {
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    else
+    {
+        memcpy(pvOut, ptEntry->aucData, ptEntry->usLen);
+        *pulLen = ptEntry->usLen;
+    }
+
+    xSemaphoreGive(s_tCfg.hMutex);
+    return err;
+}
+
+/** Stage a value (or an erase when pvValue is NULL) for the next flush. */
+static esp_err_t
+cfg_Set(const char* pcNamespace, const char* pcKey, CFG_TYPE_E eType,
+        const void* pvValue, size_t ulLen)
+{
+    if ((NULL == pcNamespace) || (NULL == pcKey)) return ESP_ERR_INVALID_ARG;
+    if (strlen(pcKey) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_KEY_TOO_LONG;
+    if (NULL == s_tCfg.hMutex) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(s_tCfg.hMutex, portMAX_DELAY);
+
+    int iNs = cfg_GetNamespace(pcNamespace, true);
+    if (iNs < 0)
+    {
+        xSemaphoreGive(s_tCfg.hMutex);
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = ESP_OK;
+    CFG_ENTRY_T* ptEntry = cfg_Find(iNs, pcKey);
+
+    if (ulLen > NVS_CONFIG_VALUE_MAX)
+    {
+        /* Too big to cache: drop any stale copy and write through */
+        if (NULL != ptEntry) cfg_Release(ptEntry);
+
+        nvs_handle_t hNvs = s_tCfg.atNs[iNs].hHandle;
+        err = (CFG_TYPE_STR == eType) ? nvs_set_str(hNvs, pcKey, (const char*)pvValue)
+                                      : nvs_set_blob(hNvs, pcKey, pvValue, ulLen);
+        if (ESP_OK == err) err = nvs_commit(hNvs);
+        s_tCfg.tStats.ulWrites++;
+        s_tCfg.tStats.ulCommits++;
+        if (ESP_OK != err)
+        {
+            s_tCfg.tStats.ulWriteErrors++;
+        }
+        else
+        {
+            FlashStats_RecordWrite(FLASH_STATS_AREA_NVS, pcNamespace,
+                                   NVS_EntryFootprint(ulLen, CFG_TYPE_BLOB == eType));
+        }
+
+        xSemaphoreGive(s_tCfg.hMutex);
+        return err;
+    }
+
+    if (NULL != ptEntry)
+    {
+        bool bSame = (NULL == pvValue)
+                   ? (CFG_STATE_ABSENT == ptEntry->eState)
+                   : ((CFG_STATE_PRESENT == ptEntry->eState) &&
+                      (ptEntry->eType == eType) &&
+                      (ptEntry->usLen == ulLen) &&
+                      (memcmp(ptEntry->aucData, pvValue, ulLen) == 0));
+        if (bSame)
+        {
+            s_tCfg.tStats.ulSkipped++;
+            xSemaphoreGive(s_tCfg.hMutex);
+            return ESP_OK;
+        }
+        if (ptEntry->bDirty) s_tCfg.tStats.ulCoalesced++;
+    }
+    else
+    {
+        ptEntry = cfg_Alloc(iNs, pcKey);
+        if (NULL == ptEntry)
+        {
+            xSemaphoreGive(s_tCfg.hMutex);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (NULL == pvValue)
+    {
+        ptEntry->eState = CFG_STATE_ABSENT;
+        ptEntry->usLen  = 0;
+    }
+    else
+    {
+        ptEntry->eState = CFG_STATE_PRESENT;
+        ptEntry->eType  = (uint8_t)eType;
+        ptEntry->usLen  = (uint16_t)ulLen;
+        memcpy(ptEntry->aucData, pvValue, ulLen);
+    }
+
+    if (!ptEntry->bDirty)
+    {
+        ptEntry->bDirty = true;
+        s_tCfg.tStats.ulDirty++;
+    }
+
+    if (0 == CONFIG_DELAY_MS)
+    {
+        err = cfg_FlushLocked();
+    }
+    else if (!s_tCfg.bTimerArmed)
+    {
+        /* Window opens on the first unsaved write and is not extended */
+        esp_timer_start_once(s_tCfg.hTimer, (uint64_t)CONFIG_DELAY_MS * 1000ULL);
+        s_tCfg.bTimerArmed = true;
+    }
+
+    xSemaphoreGive(s_tCfg.hMutex);
+    return err;
+}
+
+/** esp_timer context: hand the flush to the config task (no flash I/O here) */
+static void
+cfg_TimerCallback(void* pvArg)
+{
+    (void)pvArg;
+    xTaskNotifyGive(s_tCfg.hTask);
+}
+
+static void
+cfg_Task(void* pvArg)
+{
+    (void)pvArg;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        NVS_Config_Flush();
+    }
+}
+
+static void
+cfg_ShutdownHandler(void)
+{
+    NVS_Config_Flush();
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+NVS_Config_Init(void)
+{
+    if (NULL != s_tCfg.hMutex) return ESP_OK;
+
+    s_tCfg.tStats.ulDelayMs      = CONFIG_DELAY_MS;
+    s_tCfg.tStats.ulCacheEntries = CONFIG_CACHE_ENTRIES;
+
+    s_tCfg.hMutex = xSemaphoreCreateMutex();
+    if (NULL == s_tCfg.hMutex) return ESP_ERR_NO_MEM;
+
+    if (CONFIG_DELAY_MS > 0)
+    {
+        const esp_timer_create_args_t tTimerArgs = {
+            .callback = cfg_TimerCallback,
+            .name     = "nvs_config",
+        };
+        esp_err_t err = esp_timer_create(&tTimerArgs, &s_tCfg.hTimer);
+        if (ESP_OK != err)
+        {
+            vSemaphoreDelete(s_tCfg.hMutex);
+            s_tCfg.hMutex = NULL;
+            return err;
+        }
+
+        BaseType_t xResult = xTaskCreate(cfg_Task, "NVS_CONFIG",
+                                         CONFIG_TASK_STACK_SIZE,
+                                         NULL,
+                                         CONFIG_TASK_PRIORITY,
+                                         &s_tCfg.hTask);
+        if (pdPASS != xResult)
+        {
+            esp_timer_delete(s_tCfg.hTimer);
+            vSemaphoreDelete(s_tCfg.hMutex);
+            s_tCfg.hMutex = NULL;
+            return ESP_FAIL;
+        }
+
+        err = esp_register_shutdown_handler(cfg_ShutdownHandler);
+        if (ESP_OK != err)
+        {
+            ESP_LOGW(TAG, "Shutdown hook not registered: %s", esp_err_to_name(err));
+        }
+    }
+
+    ESP_LOGI(TAG, "Config store ready (%d keys cached, %d ms batching window)",
+             CONFIG_CACHE_ENTRIES, CONFIG_DELAY_MS);
+    return ESP_OK;
+}
+
+esp_err_t
+NVS_Config_GetStr(const char* pcNamespace, const char* pcKey, char* pcOut, size_t ulOutLen)
+{
+    if ((NULL == pcOut) || (0 == ulOutLen)) return ESP_ERR_INVALID_ARG;
+    return cfg_Get(pcNamespace, pcKey, CFG_TYPE_STR, pcOut, &ulOutLen);
+}
+
+esp_err_t
+NVS_Config_SetStr(const char* pcNamespace, const char* pcKey, const char* pcValue)
+{
+    if (NULL == pcValue) return ESP_ERR_INVALID_ARG;
+    return cfg_Set(pcNamespace, pcKey, CFG_TYPE_STR, pcValue, strlen(pcValue) + 1);
+}
+
+esp_err_t
+NVS_Config_GetBlob(const char* pcNamespace, const char* pcKey, void* pvOut, size_t* pulLen)
+{
+    return cfg_Get(pcNamespace, pcKey, CFG_TYPE_BLOB, pvOut, pulLen);
+}
+
+esp_err_t
+NVS_Config_SetBlob(const char* pcNamespace, const char* pcKey, const void* pvValue, size_t ulLen)
+{
+    if (NULL == pvValue) return ESP_ERR_INVALID_ARG;
+    return cfg_Set(pcNamespace, pcKey, CFG_TYPE_BLOB, pvValue, ulLen);
+}
+
+esp_err_t
+NVS_Config_GetU8(const char* pcNamespace, const char* pcKey, uint8_t* pucOut)
+{
+    if (NULL == pucOut) return ESP_ERR_INVALID_ARG;
+    size_t ulLen = sizeof(*pucOut);
+    return cfg_Get(pcNamespace, pcKey, CFG_TYPE_U8, pucOut, &ulLen);
+}
+
+esp_err_t
+NVS_Config_SetU8(const char* pcNamespace, const char* pcKey, uint8_t ucValue)
+{
+    return cfg_Set(pcNamespace, pcKey, CFG_TYPE_U8, &ucValue, sizeof(ucValue));
+}
+
+esp_err_t
+NVS_Config_EraseKey(const char* pcNamespace, const char* pcKey)
+{
+    return cfg_Set(pcNamespace, pcKey, CFG_TYPE_BLOB, NULL, 0);
+}
+
+esp_err_t
+NVS_Config_EraseNamespace(const char* pcNamespace)
+{
+    if (NULL == pcNamespace) return ESP_ERR_INVALID_ARG;
+    if (NULL == s_tCfg.hMutex) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(s_tCfg.hMutex, portMAX_DELAY);
+
+    int iNs = cfg_GetNamespace(pcNamespace, true);
+    if (iNs < 0)
+    {
+        xSemaphoreGive(s_tCfg.hMutex);
+        return ESP_FAIL;
+    }
+
+    for (int i = 0; i < CONFIG_CACHE_ENTRIES; i++)
+    {
+        CFG_ENTRY_T* ptEntry = &s_tCfg.atEntries[i];
+        if ((CFG_STATE_FREE != ptEntry->eState) && (ptEntry->ucNs == iNs))
+        {
+            cfg_Release(ptEntry);
+        }
+    }
+
+    nvs_handle_t hNvs = s_tCfg.atNs[iNs].hHandle;
+    esp_err_t err = nvs_erase_all(hNvs);
+    if (ESP_OK == err) err = nvs_commit(hNvs);
+    s_tCfg.tStats.ulCommits++;
+    if (ESP_OK != err)
+    {
+        s_tCfg.tStats.ulWriteErrors++;
+    }
+    else
+    {
+        FlashStats_RecordWrite(FLASH_STATS_AREA_NVS, pcNamespace, 0);
+    }
+
+    xSemaphoreGive(s_tCfg.hMutex);
+    return err;
+}
+
+esp_err_t
+NVS_Config_Flush(void)
+{
+    if (NULL == s_tCfg.hMutex) return ESP_OK;
+
+    xSemaphoreTake(s_tCfg.hMutex, portMAX_DELAY);
+    esp_err_t err = (0 != s_tCfg.tStats.ulDirty) ? cfg_FlushLocked() : ESP_OK;
+    xSemaphoreGive(s_tCfg.hMutex);
+
+    return err;
+}
+
+void
+NVS_Config_GetStats(NVS_CONFIG_STATS_T* ptStats)
+{
+    if (NULL == ptStats) return;
+
+    if (NULL == s_tCfg.hMutex)
+    {
+        *ptStats = s_tCfg.tStats;
+        return;
+    }
+
+    xSemaphoreTake(s_tCfg.hMutex, portMAX_DELAY);
+    *ptStats = s_tCfg.tStats;
+    xSemaphoreGive(s_tCfg.hMutex);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* ------------------------------------------------------------------ */
+/* Limits                                                              */
+/* ------------------------------------------------------------------ */
+#define NVS_CONFIG_VALUE_MAX        96      /* larger values bypass the cache */
+#define NVS_CONFIG_NAMESPACE_MAX    8       /* namespaces with a cached handle */
+
+typedef struct
+{
+    uint32_t ulDelayMs;         /* batching window (0 = write-through) */
+    uint32_t ulCacheEntries;
+    uint32_t ulCacheUsed;
+    uint32_t ulDirty;           /* keys waiting for the next flush */
+    uint32_t ulHits;            /* reads served from RAM */
+    uint32_t ulMisses;          /* reads that went to NVS */
+    uint32_t ulWrites;          /* nvs_set / nvs_erase_key calls */
+    uint32_t ulSkipped;         /* writes dropped because the value was unchanged */
+    uint32_t ulCoalesced;       /* writes replaced before they reached NVS */
+    uint32_t ulCommits;         /* nvs_commit calls */
+    uint32_t ulFlushes;
+    uint32_t ulWriteErrors;
+} NVS_CONFIG_STATS_T;
+
+/**
+ * @brief Start the config service. Call once after NVS_Init.
+ *        Namespace handles are opened lazily and kept open.
+ */
+esp_err_t
+NVS_Config_Init(void);
+
+/**
+ * @brief Read a string. Same return codes as nvs_get_str:
+ *        ESP_ERR_NVS_NOT_FOUND if unset, ESP_ERR_NVS_INVALID_LENGTH if
+ *        pcOut is too small.
+ */
+esp_err_t
+NVS_Config_GetStr(const char* pcNamespace, const char* pcKey, char* pcOut, size_t ulOutLen);
+
+esp_err_t
+NVS_Config_SetStr(const char* pcNamespace, const char* pcKey, const char* pcValue);
+
+/**
+ * @brief Read a blob. *pulLen is the buffer size on entry and the stored
+ *        size on return; pvOut may be NULL to query the size.
+ */
+esp_err_t
+NVS_Config_GetBlob(const char* pcNamespace, const char* pcKey, void* pvOut, size_t* pulLen);
+
+esp_err_t
+NVS_Config_SetBlob(const char* pcNamespace, const char* pcKey, const void* pvValue, size_t ulLen);
+
+esp_err_t
+NVS_Config_GetU8(const char* pcNamespace, const char* pcKey, uint8_t* pucOut);
+
+esp_err_t
+NVS_Config_SetU8(const char* pcNamespace, const char* pcKey, uint8_t ucValue);
+
+/**
+ * @brief Remove one key. Erasing a missing key is not an error.
+ */
+esp_err_t
+NVS_Config_EraseKey(const char* pcNamespace, const char* pcKey);
+
+/**
+ * @brief Remove every key of a namespace. Runs immediately and drops any
+ *        pending writes for that namespace.
+ */
+esp_err_t
+NVS_Config_EraseNamespace(const char* pcNamespace);
+
+/**
+ * @brief Write all pending changes now, one commit per namespace.
+ *        Use after writes that must survive an immediate power loss.
+ */
+esp_err_t
+NVS_Config_Flush(void);
+
+void
+NVS_Config_GetStats(NVS_CONFIG_STATS_T* ptStats);
@@ -0,0 +1,516 @@
+#include "Ota_API.h"
+#include "FlashStats_API.h"
+#include "esp_ota_ops.h"
+#include "esp_app_desc.h"
+#include "esp_partition.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mbedtls/sha256.h"
+#include "sdkconfig.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* TAG = "ota";
+
+#define OTA_SECTOR_SIZE             4096
+#define OTA_MIN_FREE_HEAP_BYTES     ((size_t)CONFIG_OTA_HEALTH_MIN_FREE_HEAP_KB * 1024)
+
+/* ------------------------------------------------------------------ */
+/* State                                                               */
+/* ------------------------------------------------------------------ */
+
+typedef struct
+{
+    SemaphoreHandle_t       hMutex;         /* session and last result */
+    const esp_partition_t*  ptRunning;
+    bool                    bPendingVerify;
+
+    /* Session */
+    OTA_SESSION_T           tSession;
+    const esp_partition_t*  ptTarget;
+    esp_ota_handle_t        hOta;
+    bool                    bHandleOpen;    /* hOta needs esp_ota_end or esp_ota_abort */
+    mbedtls_sha256_context  tSha;           /* runs across transfers, so a resume keeps it */
+    int64_t                 llTransferStartUs;
+    uint64_t                ullActiveUs;
+    uint64_t                ullFlashUs;
+
+    OTA_RESULT_T            tLast;
+} OTA_STATE_T;
+
+static OTA_STATE_T s_tOta;
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static const char*
+ota_StateToStr(esp_ota_img_states_t eState)
+{
+    switch (eState)
+    {
+        case ESP_OTA_IMG_NEW:               return "new";
+        case ESP_OTA_IMG_PENDING_VERIFY:    return "pending";
+        case ESP_OTA_IMG_VALID:             return "valid";
+        case ESP_OTA_IMG_INVALID:           return "invalid";
+        case ESP_OTA_IMG_ABORTED:           return "aborted";
+        case ESP_OTA_IMG_UNDEFINED:
+        default:                            return "undefined";
+    }
+}
+
+static void
+ota_CopyLabel(char* pcOut, const esp_partition_t* ptPart)
+{
+    snprintf(pcOut, OTA_LABEL_LEN, "%s", (NULL != ptPart) ? ptPart->label : "");
+}
+
+static void
+ota_SampleHeap(void)
+{
+    uint32_t ulFree = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    if (ulFree < s_tOta.tSession.ulHeapFreeMin)
+    {
+        s_tOta.tSession.ulHeapFreeMin = ulFree;
+    }
+}
+
+/* Caller holds the mutex */
+static void
+ota_EndTransfer(void)
+{
+    if (s_tOta.tSession.bTransfer)
+    {
+        s_tOta.ullActiveUs += (uint64_t)(esp_timer_get_time() - s_tOta.llTransferStartUs);
+        s_tOta.tSession.bTransfer = false;
+    }
+}
+
+/* Caller holds the mutex; records the outcome and forgets the session */
+static void
+ota_EndSession(bool bOk, const char* pcResult, const char* pcVersion)
+{
+    OTA_SESSION_T* ptSession = &s_tOta.tSession;
+
+    ota_EndTransfer();
+    if (s_tOta.bHandleOpen)
+    {
+        (void)esp_ota_abort(s_tOta.hOta);
+        s_tOta.bHandleOpen = false;
+    }
+    mbedtls_sha256_free(&s_tOta.tSha);
+
+    OTA_RESULT_T* ptLast = &s_tOta.tLast;
+    memset(ptLast, 0, sizeof(*ptLast));
+    ptLast->bValid         = true;
+    ptLast->bOk            = bOk;
+    ptLast->ulSize         = ptSession->ulSize;
+    ptLast->ulTransfers    = ptSession->ulTransfers;
+    ptLast->ulActiveMs     = (uint32_t)(s_tOta.ullActiveUs / 1000);
+    ptLast->ulFlashMs      = (uint32_t)(s_tOta.ullFlashUs / 1000);
+    ptLast->ulHeapFreeMin  = ptSession->ulHeapFreeMin;
+    ptLast->ulHeapPeakUsed = ptSession->ulHeapFreeStart - ptSession->ulHeapFreeMin;
+    snprintf(ptLast->acResult, sizeof(ptLast->acResult), "%s", pcResult);
+    snprintf(ptLast->acTarget, sizeof(ptLast->acTarget), "%s", ptSession->acTarget);
+    snprintf(ptLast->acVersion, sizeof(ptLast->acVersion), "%s", (NULL != pcVersion) ? pcVersion : "");
+
+    if (bOk)
+    {
+        ESP_LOGI(TAG, "%s: %" PRIu32 " bytes in %" PRIu32 " ms (%" PRIu32 " ms writing flash, "
+                 "%" PRIu32 " transfers), heap low %" PRIu32 " bytes",
+                 ptLast->acTarget, ptLast->ulSize, ptLast->ulActiveMs, ptLast->ulFlashMs,
+                 ptLast->ulTransfers, ptLast->ulHeapFreeMin);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "%s: session ended at %" PRIu32 "/%" PRIu32 " bytes: %s",
+                 ptLast->acTarget, ptSession->ulOffset, ptSession->ulSize, pcResult);
+    }
+
+    memset(ptSession, 0, sizeof(*ptSession));
+    s_tOta.ptTarget = NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* Boot                                                                */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+Ota_Init(void)
+{
+    if (NULL == s_tOta.hMutex)
+    {
+        s_tOta.hMutex = xSemaphoreCreateMutex();
+        if (NULL == s_tOta.hMutex)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_tOta.ptRunning = esp_ota_get_running_partition();
+
+    esp_ota_img_states_t eState = ESP_OTA_IMG_UNDEFINED;
+    if (ESP_OK != esp_ota_get_state_partition(s_tOta.ptRunning, &eState))
+    {
+        eState = ESP_OTA_IMG_UNDEFINED;     /* factory app, or otadata still blank */
+    }
+    s_tOta.bPendingVerify = (ESP_OTA_IMG_PENDING_VERIFY == eState);
+
+    ESP_LOGI(TAG, "Running %s, version %s, state %s",
+             s_tOta.ptRunning->label, esp_app_get_description()->version, ota_StateToStr(eState));
+
+    const esp_partition_t* ptInvalid = esp_ota_get_last_invalid_partition();
+    if (NULL != ptInvalid)
+    {
+        ESP_LOGW(TAG, "Image in %s failed verification and was rolled back", ptInvalid->label);
+    }
+
+    if (NULL == esp_ota_get_next_update_partition(NULL))
+    {
+        ESP_LOGW(TAG, "No OTA slots in the partition table, firmware uploads disabled");
+    }
+    return ESP_OK;
+}
+
+bool
+Ota_IsPendingVerify(void)
+{
+    return s_tOta.bPendingVerify;
+}
+
+esp_err_t
+Ota_CompleteHealthCheck(bool bAppHealthy)
+{
+    if (!s_tOta.bPendingVerify)
+    {
+        return ESP_OK;
+    }
+
+    /* The low-water mark covers the whole probation, not just this moment */
+    size_t ulHeapLow = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    if (!bAppHealthy)
+    {
+        Ota_RollBack("services not running");
+        return ESP_FAIL;
+    }
+    if (ulHeapLow < OTA_MIN_FREE_HEAP_BYTES)
+    {
+        ESP_LOGE(TAG, "Internal heap fell to %u bytes", (unsigned)ulHeapLow);
+        Ota_RollBack("internal heap below CONFIG_OTA_HEALTH_MIN_FREE_HEAP_KB");
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+    if (ESP_OK == err)
+    {
+        s_tOta.bPendingVerify = false;
+        ESP_LOGI(TAG, "Image in %s confirmed (heap low %u bytes)", s_tOta.ptRunning->label, (unsigned)ulHeapLow);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Confirming the image failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void
+Ota_RollBack(const char* pcReason)
+{
+    if (!s_tOta.bPendingVerify)
+    {
+        return;
+    }
+
+    ESP_LOGE(TAG, "Rejecting image in %s: %s", s_tOta.ptRunning->label, pcReason);
+    esp_err_t err = esp_ota_mark_app_invalid_rollback_and_reboot();
+
+    /* Only returns if there is no image to go back to */
+    ESP_LOGE(TAG, "Rollback failed: %s", esp_err_to_name(err));
+}
+
+/* ------------------------------------------------------------------ */
+/* Upload                                                              */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+Ota_Open(uint32_t ulSize, const uint8_t aucDigest[OTA_DIGEST_LEN],
+         uint32_t ulOffset, uint32_t ulLen, uint32_t* pulOffset)
+{
+    if (NULL == s_tOta.hMutex)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_tOta.hMutex, portMAX_DELAY);
+
+    OTA_SESSION_T* ptSession = &s_tOta.tSession;
+    esp_err_t err = ESP_OK;
+
+    if (ptSession->bTransfer)
+    {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    else if (0 == ulOffset)
+    {
+        /* Checked first: esp_ota_begin would refuse too, but only after the
+         * session below had been dropped */
+        const esp_partition_t* ptTarget = esp_ota_get_next_update_partition(NULL);
+        if (s_tOta.bPendingVerify)
+        {
+            err = ESP_ERR_OTA_ROLLBACK_INVALID_STATE;
+        }
+        else if (NULL == ptTarget)
+        {
+            err = ESP_ERR_NOT_SUPPORTED;
+        }
+        else if ((0 == ulSize) || (ulSize > ptTarget->size) || (ulLen > ulSize))
+        {
+            err = ESP_ERR_INVALID_SIZE;
+        }
+        else
+        {
+            if (ptSession->bOpen)
+            {
+                ota_EndSession(false, "replaced by a new upload", NULL);
+            }
+
+            /* Sequential writes erase each sector as it is reached instead of
+             * the whole slot up front, which would stall for seconds */
+            err = esp_ota_begin(ptTarget, OTA_WITH_SEQUENTIAL_WRITES, &s_tOta.hOta);
+            if (ESP_OK == err)
+            {
+                memset(ptSession, 0, sizeof(*ptSession));
+                ptSession->bOpen   = true;
+                ptSession->ulSize  = ulSize;
+                memcpy(ptSession->aucDigest, aucDigest, OTA_DIGEST_LEN);
+                ota_CopyLabel(ptSession->acTarget, ptTarget);
+                ptSession->ulHeapFreeStart = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+                ptSession->ulHeapFreeMin   = ptSession->ulHeapFreeStart;
+
+                s_tOta.ptTarget    = ptTarget;
+                s_tOta.bHandleOpen = true;
+                s_tOta.ullActiveUs = 0;
+                s_tOta.ullFlashUs  = 0;
+                mbedtls_sha256_init(&s_tOta.tSha);
+                (void)mbedtls_sha256_starts(&s_tOta.tSha, 0);
+
+                ESP_LOGI(TAG, "Receiving %" PRIu32 " byte image into %s", ulSize, ptTarget->label);
+            }
+        }
+    }
+    else if (!ptSession->bOpen || (ulSize != ptSession->ulSize) ||
+             (0 != memcmp(aucDigest, ptSession->aucDigest, OTA_DIGEST_LEN)))
+    {
+        err = ESP_ERR_NOT_FOUND;
+    }
+    else if (ulOffset != ptSession->ulOffset)
+    {
+        err = ESP_ERR_INVALID_ARG;
+    }
+    else if (ulLen > ulSize - ulOffset)
+    {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    else
+    {
+        ESP_LOGI(TAG, "Resuming %s at %" PRIu32 "/%" PRIu32, ptSession->acTarget, ulOffset, ulSize);
+    }
+
+    if (ESP_OK == err)
+    {
+        ptSession->bTransfer = true;
+        ptSession->ulTransfers++;
+        s_tOta.llTransferStartUs = esp_timer_get_time();
+    }
+
+    if (NULL != pulOffset)
+    {
+        *pulOffset = ptSession->bOpen ? ptSession->ulOffset : 0;
+    }
+
+    xSemaphoreGive(s_tOta.hMutex);
+    return err;
+}
+
+esp_err_t
+Ota_Write(const void* pvData, size_t ulLen)
+{
+    xSemaphoreTake(s_tOta.hMutex, portMAX_DELAY);
+
+    OTA_SESSION_T* ptSession = &s_tOta.tSession;
+    esp_err_t err = ESP_OK;
+
+    if (!ptSession->bTransfer)
+    {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    else if (ulLen > ptSession->ulSize - ptSession->ulOffset)
+    {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    else
+    {
+        int64_t llStart = esp_timer_get_time();
+        err = esp_ota_write(s_tOta.hOta, pvData, ulLen);
+        s_tOta.ullFlashUs += (uint64_t)(esp_timer_get_time() - llStart);
+
+        if (ESP_OK == err)
+        {
+            (void)mbedtls_sha256_update(&s_tOta.tSha, pvData, ulLen);
+
+            uint32_t ulSectorsBefore = (ptSession->ulOffset + OTA_SECTOR_SIZE - 1) / OTA_SECTOR_SIZE;
+            ptSession->ulOffset += (uint32_t)ulLen;
+            uint32_t ulSectorsAfter  = (ptSession->ulOffset + OTA_SECTOR_SIZE - 1) / OTA_SECTOR_SIZE;
+
+            FlashStats_RecordWrite(FLASH_STATS_AREA_RAW, ptSession->acTarget, ulLen);
+            if (ulSectorsAfter > ulSectorsBefore)
+            {
+                FlashStats_RecordErase(FLASH_STATS_AREA_RAW, ptSession->acTarget, ulSectorsAfter - ulSectorsBefore);
+            }
+            ota_SampleHeap();
+        }
+        else
+        {
+            ota_EndSession(false, esp_err_to_name(err), NULL);
+        }
+    }
+
+    xSemaphoreGive(s_tOta.hMutex);
+    return err;
+}
+
+void
+Ota_Close(void)
+{
+    if (NULL == s_tOta.hMutex)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_tOta.hMutex, portMAX_DELAY);
+    if (s_tOta.tSession.bTransfer)
+    {
+        ota_EndTransfer();
+        ESP_LOGW(TAG, "%s: transfer stopped at %" PRIu32 "/%" PRIu32 ", waiting for a resume",
+                 s_tOta.tSession.acTarget, s_tOta.tSession.ulOffset, s_tOta.tSession.ulSize);
+    }
+    xSemaphoreGive(s_tOta.hMutex);
+}
+
+esp_err_t
+Ota_Finish(void)
+{
+    xSemaphoreTake(s_tOta.hMutex, portMAX_DELAY);
+
+    OTA_SESSION_T* ptSession = &s_tOta.tSession;
+    if (!ptSession->bTransfer || (ptSession->ulOffset != ptSession->ulSize))
+    {
+        xSemaphoreGive(s_tOta.hMutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ota_EndTransfer();
+
+    uint8_t aucActual[OTA_DIGEST_LEN];
+    (void)mbedtls_sha256_finish(&s_tOta.tSha, aucActual);
+
+    esp_err_t err = ESP_OK;
+    esp_app_desc_t tDesc = { 0 };
+    if (0 != memcmp(aucActual, ptSession->aucDigest, OTA_DIGEST_LEN))
+    {
+        err = ESP_ERR_INVALID_CRC;
+        ota_EndSession(false, "SHA-256 mismatch", NULL);
+    }
+    else
+    {
+        /* Checks the image header, segments and appended hash */
+        err = esp_ota_end(s_tOta.hOta);
+        s_tOta.bHandleOpen = false;
+
+        if (ESP_OK == err)
+        {
+            err = esp_ota_set_boot_partition(s_tOta.ptTarget);
+        }
+        if (ESP_OK == err)
+        {
+            (void)esp_ota_get_partition_description(s_tOta.ptTarget, &tDesc);
+        }
+        ota_EndSession(ESP_OK == err, (ESP_OK == err) ? "ok" : esp_err_to_name(err), tDesc.version);
+    }
+
+    xSemaphoreGive(s_tOta.hMutex);
+    return err;
+}
+
+esp_err_t
+Ota_Abort(void)
+{
+    if (NULL == s_tOta.hMutex)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_tOta.hMutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_OK;
+    if (s_tOta.tSession.bTransfer)
+    {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    else if (s_tOta.tSession.bOpen)
+    {
+        ota_EndSession(false, "aborted", NULL);
+    }
+
+    xSemaphoreGive(s_tOta.hMutex);
+    return err;
+}
+
+void
+Ota_GetStatus(OTA_STATUS_T* ptStatus)
+{
+    memset(ptStatus, 0, sizeof(*ptStatus));
+
+    const esp_partition_t* ptRunning = esp_ota_get_running_partition();
+    esp_ota_img_states_t eState = ESP_OTA_IMG_UNDEFINED;
+    if (ESP_OK != esp_ota_get_state_partition(ptRunning, &eState))
+    {
+        eState = ESP_OTA_IMG_UNDEFINED;
+    }
+    ota_CopyLabel(ptStatus->acRunning, ptRunning);
+    snprintf(ptStatus->acVersion, sizeof(ptStatus->acVersion), "%s", esp_app_get_description()->version);
+    ptStatus->pcState        = ota_StateToStr(eState);
+    ptStatus->bPendingVerify = s_tOta.bPendingVerify;
+
+    const esp_partition_t* ptNext = esp_ota_get_next_update_partition(NULL);
+    ota_CopyLabel(ptStatus->acNext, ptNext);
+    ptStatus->ulSlotSize = (NULL != ptNext) ? ptNext->size : 0;
+
+    const esp_partition_t* ptInvalid = esp_ota_get_last_invalid_partition();
+    if (NULL != ptInvalid)
+    {
+        esp_app_desc_t tDesc;
+        ota_CopyLabel(ptStatus->acRolledBack, ptInvalid);
+        if (ESP_OK == esp_ota_get_partition_description(ptInvalid, &tDesc))
+        {
+            snprintf(ptStatus->acRolledBackVersion, sizeof(ptStatus->acRolledBackVersion), "%s", tDesc.version);
+        }
+    }
+
+    if (NULL != s_tOta.hMutex)
+    {
+        xSemaphoreTake(s_tOta.hMutex, portMAX_DELAY);
+        ptStatus->tSession = s_tOta.tSession;
+        ptStatus->tSession.ulActiveMs = (uint32_t)(s_tOta.ullActiveUs / 1000);
+        ptStatus->tSession.ulFlashMs  = (uint32_t)(s_tOta.ullFlashUs / 1000);
+        if (s_tOta.tSession.bTransfer)
+        {
+            ptStatus->tSession.ulActiveMs += (uint32_t)((esp_timer_get_time() - s_tOta.llTransferStartUs) / 1000);
+        }
+        ptStatus->tLast = s_tOta.tLast;
+        xSemaphoreGive(s_tOta.hMutex);
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Firmware updates into the spare OTA slot (ota_0 / ota_1, see partitions.csv).
+ *
+ * An upload is a session: the image size and SHA-256 are fixed when it is
+ * opened at offset 0, and every byte is written through esp_ota_write as it
+ * arrives. If the connection drops, the session stays open and a new
+ * connection continues at the offset already written. Ota_Finish checks the
+ * digest and the image and selects the slot for the next boot.
+ *
+ * The new image boots pending verification (CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE).
+ * AppTask confirms it after CONFIG_OTA_HEALTH_CHECK_DELAY_SEC of healthy
+ * running; a failed start-up or health check rolls back to the previous
+ * image, and so does any reset before then (the bootloader does that one).
+ */
+
+/* ------------------------------------------------------------------ */
+/* Limits                                                              */
+/* ------------------------------------------------------------------ */
+#define OTA_DIGEST_LEN          32
+#define OTA_LABEL_LEN           17      /* partition label + NUL */
+#define OTA_VERSION_LEN         32      /* esp_app_desc_t.version */
+#define OTA_RESULT_LEN          48
+
+typedef struct
+{
+    bool     bOpen;
+    bool     bTransfer;             /* a connection is writing now */
+    char     acTarget[OTA_LABEL_LEN];
+    uint32_t ulSize;                /* image bytes */
+    uint32_t ulOffset;              /* bytes written, where the next transfer starts */
+    uint8_t  aucDigest[OTA_DIGEST_LEN];
+    uint32_t ulTransfers;           /* connections that wrote to it; more than one means resumed */
+    uint32_t ulActiveMs;            /* time spent in transfers */
+    uint32_t ulFlashMs;             /* of which in esp_ota_write */
+    uint32_t ulHeapFreeStart;       /* internal heap free when the session opened */
+    uint32_t ulHeapFreeMin;         /* lowest seen since */
+} OTA_SESSION_T;
+
+typedef struct
+{
+    bool     bValid;                /* a session has ended since boot */
+    bool     bOk;                   /* image written, verified and selected for boot */
+    char     acResult[OTA_RESULT_LEN];
+    char     acTarget[OTA_LABEL_LEN];
+    char     acVersion[OTA_VERSION_LEN];
+    uint32_t ulSize;
+    uint32_t ulTransfers;
+    uint32_t ulActiveMs;
+    uint32_t ulFlashMs;
+    uint32_t ulHeapFreeMin;
+    uint32_t ulHeapPeakUsed;        /* free at start minus lowest free */
+} OTA_RESULT_T;
+
+typedef struct
+{
+    char          acRunning[OTA_LABEL_LEN];
+    char          acVersion[OTA_VERSION_LEN];
+    const char*   pcState;          /* running image: "valid", "pending", "new", "undefined", ... */
+    bool          bPendingVerify;   /* still on probation this boot */
+    char          acNext[OTA_LABEL_LEN];        /* slot the next upload goes to, "" without OTA slots */
+    uint32_t      ulSlotSize;
+    char          acRolledBack[OTA_LABEL_LEN];  /* image that failed verification, "" if none */
+    char          acRolledBackVersion[OTA_VERSION_LEN];
+    OTA_SESSION_T tSession;
+    OTA_RESULT_T  tLast;
+} OTA_STATUS_T;
+
+/**
+ * @brief Note the running slot and its state. Call early at start-up;
+ *        writes nothing.
+ */
+esp_err_t
+Ota_Init(void);
+
+/**
+ * @brief True while the running image waits for its health check.
+ */
+bool
+Ota_IsPendingVerify(void);
+
+/**
+ * @brief End the probation of the running image. It is kept if bAppHealthy
+ *        and the lowest internal heap since boot is at least
+ *        CONFIG_OTA_HEALTH_MIN_FREE_HEAP_KB; otherwise the device reboots
+ *        into the previous image. Does nothing if not pending.
+ */
+esp_err_t
+Ota_CompleteHealthCheck(bool bAppHealthy);
+
+/**
+ * @brief Reboot into the previous image if the running one is pending.
+ *        Returns (doing nothing) otherwise.
+ */
+void
+Ota_RollBack(const char* pcReason);
+
+/**
+ * @brief Start one transfer of ulLen bytes at ulOffset.
+ *        Offset 0 opens a new session (dropping an idle one); any other
+ *        offset resumes the session with the same size and digest.
+ * @param pulOffset  The session's offset, also set on failure (0 if none).
+ * @return ESP_ERR_INVALID_STATE                another transfer is running
+ *         ESP_ERR_OTA_ROLLBACK_INVALID_STATE   running image not yet confirmed
+ *         ESP_ERR_NOT_FOUND                    no session to resume
+ *         ESP_ERR_INVALID_ARG                  offset is not the session's offset
+ *         ESP_ERR_INVALID_SIZE                 image larger than the slot, or
+ *                                              ulLen runs past ulSize
+ *         ESP_ERR_NOT_SUPPORTED                no OTA slots in the partition table
+ */
+esp_err_t
+Ota_Open(uint32_t ulSize, const uint8_t aucDigest[OTA_DIGEST_LEN],
+         uint32_t ulOffset, uint32_t ulLen, uint32_t* pulOffset);
+
+/**
+ * @brief Write the next bytes of the open transfer. A flash error ends the
+ *        session.
+ */
+esp_err_t
+Ota_Write(const void* pvData, size_t ulLen);
+
+/**
+ * @brief End the transfer without finishing; the session waits for the
+ *        next one.
+ */
+void
+Ota_Close(void);
+
+/**
+ * @brief End the transfer and the session once every byte is written:
+ *        compare the digest, validate the image and set it to boot next.
+ * @return ESP_ERR_INVALID_CRC (digest mismatch), ESP_ERR_OTA_VALIDATE_FAILED
+ *         (not a bootable image) or an esp_ota error; the session is gone
+ *         either way.
+ */
+esp_err_t
+Ota_Finish(void);
+
+/**
+ * @brief Drop the session. ESP_ERR_INVALID_STATE while a transfer is running.
+ */
+esp_err_t
+Ota_Abort(void);
+
+void
+Ota_GetStatus(OTA_STATUS_T* ptStatus);
@@ -3,8 +3,7 @@
 #include "driver/i2c_master.h"
 #include "esp_timer.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
-#include "nvs.h"
+#include "NVS_Config.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "bsp/esp32_s3_touch_lcd_4.h"
@@ -267,16 +266,11 @@ RingBell_Init(void)
     }
 
     /* Restore panic state from NVS */
-    nvs_handle_t hNvs;
-    if (nvs_open(RING_BELL_NVS_NAMESPACE, NVS_READONLY, &hNvs) == ESP_OK)
+    uint8_t ucVal = 0;
+    size_t ulLen = sizeof(ucVal);
+    if (NVS_Config_GetBlob(RING_BELL_NVS_NAMESPACE, RING_BELL_NVS_KEY_PANIC, &ucVal, &ulLen) == ESP_OK)
     {
-        uint8_t ucVal = 0;
-        size_t ulLen = sizeof(ucVal);
-        if (nvs_get_blob(hNvs, RING_BELL_NVS_KEY_PANIC, &ucVal, &ulLen) == ESP_OK)
-        {
-            s_bPanic = (ucVal != 0);
-        }
-        nvs_close(hNvs);
+        s_bPanic = (ucVal != 0);
     }
 
     /* If panic was persisted, activate bell */
@@ -359,15 +353,9 @@ RingBell_SetPanic(bool bEnable)
 {
     s_bPanic = bEnable;
 
-    /* Persist to NVS */
-    nvs_handle_t hNvs;
-    if (nvs_open(RING_BELL_NVS_NAMESPACE, NVS_READWRITE, &hNvs) == ESP_OK)
-    {
-        uint8_t ucVal = bEnable ? 1 : 0;
-        nvs_set_blob(hNvs, RING_BELL_NVS_KEY_PANIC, &ucVal, sizeof(ucVal));
-        nvs_commit(hNvs);
-        nvs_close(hNvs);
-    }
+    /* Persist to NVS (stored as a 1-byte blob for compatibility) */
+    uint8_t ucVal = bEnable ? 1 : 0;
+    NVS_Config_SetBlob(RING_BELL_NVS_NAMESPACE, RING_BELL_NVS_KEY_PANIC, &ucVal, sizeof(ucVal));
 
     if (bEnable)
     {
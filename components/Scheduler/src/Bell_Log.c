@@ -0,0 +1,504 @@
+#include "Bell_Log.h"
+#include "FlashStats_API.h"
+#include "TimeSync_API.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char* TAG = "bell_log";
+
+/* ------------------------------------------------------------------ */
+/* On-flash layout                                                     */
+/* ------------------------------------------------------------------ */
+/*
+ * The bell_log partition is a ring of flash sectors. Each sector holds
+ * BELL_LOG_RECORDS_PER_SECTOR fixed-width records written in order into
+ * erased flash, so an append is a single 32-byte program operation.
+ * When the head sector is full the ring advances and the next (oldest)
+ * sector is erased, dropping its records.
+ *
+ * Sequence numbers only grow; the sector whose first record has the
+ * highest sequence is the head. The first record of every sector forms
+ * the sparse index used to seek by timestamp.
+ *
+ * Timestamps normally grow too, but a clock stepped back (manual set,
+ * SNTP correction) leaves a record older than the one before it. The
+ * seq of the newest such record is kept; until the ring has overwritten
+ * it, queries scan every sector instead of seeking.
+ */
+#define BELL_LOG_SECTOR_SIZE            4096
+#define BELL_LOG_RECORD_SIZE            32
+#define BELL_LOG_RECORDS_PER_SECTOR     (BELL_LOG_SECTOR_SIZE / BELL_LOG_RECORD_SIZE)
+#define BELL_LOG_SEQ_EMPTY              0xFFFFFFFFUL
+#define BELL_LOG_LAYOUT                 2       /* folded into the checksum */
+
+typedef struct __attribute__((packed))
+{
+    uint32_t ulSeq;
+    uint32_t ulTimestamp;
+    int32_t  lLatenessMs;
+    uint16_t usDurationSec;
+    uint16_t usBellId;
+    uint8_t  ucZone;
+    uint8_t  ucSource;
+    char     acLabel[BELL_LOG_LABEL_LEN];
+    uint8_t  ucCheck;
+} BELL_LOG_RECORD_T;
+
+_Static_assert(sizeof(BELL_LOG_RECORD_T) == BELL_LOG_RECORD_SIZE, "bell log record must be 32 bytes");
+
+typedef struct
+{
+    const esp_partition_t* ptPart;
+    SemaphoreHandle_t      hMutex;
+    uint32_t               ulSectorCount;
+    uint32_t*              pulSectorSeq;    /* sparse index: first seq per sector */
+    uint32_t*              pulSectorTs;     /* sparse index: first timestamp per sector */
+    uint32_t               ulHeadSector;
+    uint32_t               ulHeadSlot;      /* next free slot in the head sector */
+    uint32_t               ulNextSeq;
+    uint32_t               ulLastTs;        /* timestamp of the newest record */
+    uint32_t               ulBackStepSeq;   /* newest record older than its predecessor, or BELL_LOG_SEQ_EMPTY */
+    uint32_t               ulAppends;
+    uint32_t               ulSectorErases;
+} BELL_LOG_STATE_T;
+
+static BELL_LOG_STATE_T s_tLog;
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Seeded with the layout so records of an older layout (8-bit bell id)
+ * fail the check; their sectors are reclaimed at boot */
+static uint8_t
+bellLog_Checksum(const BELL_LOG_RECORD_T* ptRec)
+{
+    const uint8_t* pucBytes = (const uint8_t*)ptRec;
+    uint8_t ucSum = BELL_LOG_LAYOUT;
+    for (size_t i = 0; i < offsetof(BELL_LOG_RECORD_T, ucCheck); i++)
+    {
+        ucSum += pucBytes[i];
+    }
+    return (uint8_t)~ucSum;
+}
+
+static bool
+bellLog_IsValid(const BELL_LOG_RECORD_T* ptRec)
+{
+    return (ptRec->ulSeq != BELL_LOG_SEQ_EMPTY) && (ptRec->ucCheck == bellLog_Checksum(ptRec));
+}
+
+static esp_err_t
+bellLog_ReadSector(uint32_t ulSector, BELL_LOG_RECORD_T* ptBuf)
+{
+    return esp_partition_read(s_tLog.ptPart, ulSector * BELL_LOG_SECTOR_SIZE,
+                              ptBuf, BELL_LOG_SECTOR_SIZE);
+}
+
+static esp_err_t
+bellLog_EraseSector(uint32_t ulSector)
+{
+    esp_err_t err = esp_partition_erase_range(s_tLog.ptPart, ulSector * BELL_LOG_SECTOR_SIZE,
+                                              BELL_LOG_SECTOR_SIZE);
+    if (ESP_OK == err)
+    {
+        s_tLog.pulSectorSeq[ulSector] = BELL_LOG_SEQ_EMPTY;
+        s_tLog.pulSectorTs[ulSector]  = 0;
+        s_tLog.ulSectorErases++;
+        FlashStats_RecordErase(FLASH_STATS_AREA_RAW, BELL_LOG_PARTITION_LABEL, 1);
+    }
+    return err;
+}
+
+static void
+bellLog_ToEvent(const BELL_LOG_RECORD_T* ptRec, BELL_EVENT_T* ptEvent)
+{
+    ptEvent->ulSeq         = ptRec->ulSeq;
+    ptEvent->ulTimestamp   = ptRec->ulTimestamp;
+    ptEvent->lLatenessMs   = ptRec->lLatenessMs;
+    ptEvent->usDurationSec = ptRec->usDurationSec;
+    ptEvent->usBellId      = ptRec->usBellId;
+    ptEvent->ucZone        = ptRec->ucZone;
+    ptEvent->eSource       = (BELL_SOURCE_E)ptRec->ucSource;
+    memcpy(ptEvent->acLabel, ptRec->acLabel, BELL_LOG_LABEL_LEN);
+    ptEvent->acLabel[BELL_LOG_LABEL_LEN - 1] = '\0';
+}
+
+/** Used sectors in ring order, oldest first (the one after the head) */
+static uint32_t
+bellLog_RingOrderLocked(uint32_t* pulOrder)
+{
+    uint32_t ulUsed = 0;
+    for (uint32_t i = 1; i <= s_tLog.ulSectorCount; i++)
+    {
+        uint32_t ulSector = (s_tLog.ulHeadSector + i) % s_tLog.ulSectorCount;
+        if (s_tLog.pulSectorSeq[ulSector] != BELL_LOG_SEQ_EMPTY)
+        {
+            pulOrder[ulUsed++] = ulSector;
+        }
+    }
+    return ulUsed;
+}
+
+/** Stored timestamps are non-decreasing in seq order. The oldest record's
+ *  predecessor is gone, so a back step there no longer counts. */
+static bool
+bellLog_IsOrderedLocked(const uint32_t* pulOrder, uint32_t ulUsed)
+{
+    if ((BELL_LOG_SEQ_EMPTY == s_tLog.ulBackStepSeq) || (0 == ulUsed)) return true;
+    return s_tLog.ulBackStepSeq <= s_tLog.pulSectorSeq[pulOrder[0]];
+}
+
+/** Number of stored records (every non-head sector in use is full) */
+static uint32_t
+bellLog_CountLocked(void)
+{
+    uint32_t ulUsed = 0;
+    for (uint32_t i = 0; i < s_tLog.ulSectorCount; i++)
+    {
+        if (s_tLog.pulSectorSeq[i] != BELL_LOG_SEQ_EMPTY) ulUsed++;
+    }
+    if (0 == ulUsed) return 0;
+    return (ulUsed - 1) * BELL_LOG_RECORDS_PER_SECTOR + s_tLog.ulHeadSlot;
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+Bell_Log_Init(void)
+{
+    if (NULL != s_tLog.hMutex) return ESP_OK;
+
+    s_tLog.ptPart = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                             BELL_LOG_PARTITION_LABEL);
+    if (NULL == s_tLog.ptPart)
+    {
+        ESP_LOGW(TAG, "No '%s' partition, bell history disabled", BELL_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_tLog.ulSectorCount = s_tLog.ptPart->size / BELL_LOG_SECTOR_SIZE;
+    if (s_tLog.ulSectorCount < 2) return ESP_ERR_INVALID_SIZE;
+
+    s_tLog.pulSectorSeq = (uint32_t*)calloc(s_tLog.ulSectorCount, sizeof(uint32_t));
+    s_tLog.pulSectorTs  = (uint32_t*)calloc(s_tLog.ulSectorCount, sizeof(uint32_t));
+    BELL_LOG_RECORD_T* ptBuf = (BELL_LOG_RECORD_T*)malloc(BELL_LOG_SECTOR_SIZE);
+    if ((NULL == s_tLog.pulSectorSeq) || (NULL == s_tLog.pulSectorTs) || (NULL == ptBuf))
+    {
+        free(s_tLog.pulSectorSeq);
+        free(s_tLog.pulSectorTs);
+        free(ptBuf);
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Build the sparse index from the first record of every sector */
+    uint32_t ulHead = 0;
+    uint32_t ulHeadSeq = 0;
+    bool bAny = false;
+    for (uint32_t i = 0; i < s_tLog.ulSectorCount; i++)
+    {
+        BELL_LOG_RECORD_T tFirst;
+        esp_partition_read(s_tLog.ptPart, i * BELL_LOG_SECTOR_SIZE, &tFirst, sizeof(tFirst));
+
+        s_tLog.pulSectorSeq[i] = BELL_LOG_SEQ_EMPTY;
+        if (tFirst.ulSeq == BELL_LOG_SEQ_EMPTY) continue;
+
+        if (!bellLog_IsValid(&tFirst))
+        {
+            /* Torn write or foreign data: reclaim the sector */
+            ESP_LOGW(TAG, "Sector %"PRIu32" has an invalid header, erasing", i);
+            bellLog_EraseSector(i);
+            continue;
+        }
+
+        s_tLog.pulSectorSeq[i] = tFirst.ulSeq;
+        s_tLog.pulSectorTs[i]  = tFirst.ulTimestamp;
+        if (!bAny || tFirst.ulSeq > ulHeadSeq)
+        {
+            ulHead    = i;
+            ulHeadSeq = tFirst.ulSeq;
+            bAny      = true;
+        }
+    }
+
+    s_tLog.ulHeadSector  = ulHead;
+    s_tLog.ulHeadSlot    = 0;
+    s_tLog.ulNextSeq     = 0;
+    s_tLog.ulLastTs      = 0;
+    s_tLog.ulBackStepSeq = BELL_LOG_SEQ_EMPTY;
+
+    /* Find the first free slot in the head sector */
+    if (bAny && bellLog_ReadSector(ulHead, ptBuf) == ESP_OK)
+    {
+        uint32_t ulSlot = 0;
+        s_tLog.ulNextSeq = ulHeadSeq + 1;
+        while (ulSlot < BELL_LOG_RECORDS_PER_SECTOR && ptBuf[ulSlot].ulSeq != BELL_LOG_SEQ_EMPTY)
+        {
+            if (bellLog_IsValid(&ptBuf[ulSlot]) && ptBuf[ulSlot].ulSeq >= s_tLog.ulNextSeq)
+            {
+                s_tLog.ulNextSeq = ptBuf[ulSlot].ulSeq + 1;
+            }
+            ulSlot++;
+        }
+        s_tLog.ulHeadSlot = ulSlot;
+    }
+    else if (!bAny)
+    {
+        /* Empty ring: make sure slot 0 is programmable */
+        bellLog_EraseSector(0);
+    }
+
+    /* Find the newest back step of the clock: one read of the partition */
+    uint32_t* pulOrder = (uint32_t*)malloc(s_tLog.ulSectorCount * sizeof(uint32_t));
+    if (NULL == pulOrder)
+    {
+        free(ptBuf);
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t ulUsed = bellLog_RingOrderLocked(pulOrder);
+    bool bPrev = false;
+    for (uint32_t k = 0; k < ulUsed; k++)
+    {
+        uint32_t ulSector = pulOrder[k];
+        if (bellLog_ReadSector(ulSector, ptBuf) != ESP_OK) continue;
+
+        uint32_t ulSlots = (ulSector == s_tLog.ulHeadSector) ? s_tLog.ulHeadSlot
+                                                             : BELL_LOG_RECORDS_PER_SECTOR;
+        for (uint32_t i = 0; i < ulSlots; i++)
+        {
+            if (!bellLog_IsValid(&ptBuf[i])) continue;
+            if (bPrev && (ptBuf[i].ulTimestamp < s_tLog.ulLastTs)) s_tLog.ulBackStepSeq = ptBuf[i].ulSeq;
+            s_tLog.ulLastTs = ptBuf[i].ulTimestamp;
+            bPrev = true;
+        }
+    }
+    free(pulOrder);
+    free(ptBuf);
+
+    s_tLog.hMutex = xSemaphoreCreateMutex();
+    if (NULL == s_tLog.hMutex) return ESP_ERR_NO_MEM;
+
+    ESP_LOGI(TAG, "Bell log: %"PRIu32" records, capacity %"PRIu32", next seq %"PRIu32,
+             bellLog_CountLocked(), s_tLog.ulSectorCount * BELL_LOG_RECORDS_PER_SECTOR,
+             s_tLog.ulNextSeq);
+    if (BELL_LOG_SEQ_EMPTY != s_tLog.ulBackStepSeq)
+    {
+        ESP_LOGW(TAG, "Clock stepped back at seq %"PRIu32", queries scan the whole log", s_tLog.ulBackStepSeq);
+    }
+    return ESP_OK;
+}
+
+esp_err_t
+Bell_Log_Append(BELL_EVENT_T* ptEvent)
+{
+    if (NULL == ptEvent) return ESP_ERR_INVALID_ARG;
+    if (NULL == s_tLog.hMutex) return ESP_ERR_INVALID_STATE;
+
+    /* A 1970 timestamp would sit before every synced record and turn every
+     * Bell_Log_Query into a full scan until overwritten, so such events
+     * are not kept */
+    if (!TimeSync_IsSynced())
+    {
+        ESP_LOGW(TAG, "Clock not synced, %s event not logged", Bell_Log_SourceToStr(ptEvent->eSource));
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (0 == ptEvent->ulTimestamp)
+    {
+        ptEvent->ulTimestamp = (uint32_t)time(NULL);
+    }
+
+    xSemaphoreTake(s_tLog.hMutex, portMAX_DELAY);
+
+    esp_err_t err = ESP_OK;
+
+    /* Advance the ring: the next sector holds the oldest records */
+    if (s_tLog.ulHeadSlot >= BELL_LOG_RECORDS_PER_SECTOR)
+    {
+        uint32_t ulNext = (s_tLog.ulHeadSector + 1) % s_tLog.ulSectorCount;
+        err = bellLog_EraseSector(ulNext);
+        if (ESP_OK != err)
+        {
+            xSemaphoreGive(s_tLog.hMutex);
+            ESP_LOGE(TAG, "Erase of sector %"PRIu32" failed: %s", ulNext, esp_err_to_name(err));
+            return err;
+        }
+        s_tLog.ulHeadSector = ulNext;
+        s_tLog.ulHeadSlot   = 0;
+    }
+
+    BELL_LOG_RECORD_T tRec;
+    memset(&tRec, 0, sizeof(tRec));
+    tRec.ulSeq         = s_tLog.ulNextSeq;
+    tRec.ulTimestamp   = ptEvent->ulTimestamp;
+    tRec.lLatenessMs   = ptEvent->lLatenessMs;
+    tRec.usDurationSec = ptEvent->usDurationSec;
+    tRec.usBellId      = ptEvent->usBellId;
+    tRec.ucZone        = ptEvent->ucZone;
+    tRec.ucSource      = (uint8_t)ptEvent->eSource;
+    strncpy(tRec.acLabel, ptEvent->acLabel, BELL_LOG_LABEL_LEN - 1);
+    tRec.ucCheck       = bellLog_Checksum(&tRec);
+
+    size_t ulOffset = s_tLog.ulHeadSector * BELL_LOG_SECTOR_SIZE
+                    + s_tLog.ulHeadSlot * BELL_LOG_RECORD_SIZE;
+    err = esp_partition_write(s_tLog.ptPart, ulOffset, &tRec, sizeof(tRec));
+    if (ESP_OK == err)
+    {
+        FlashStats_RecordWrite(FLASH_STATS_AREA_RAW, BELL_LOG_PARTITION_LABEL, sizeof(tRec));
+        if (tRec.ulTimestamp < s_tLog.ulLastTs)
+        {
+            ESP_LOGW(TAG, "Clock stepped back %"PRIu32" s, queries scan the whole log until seq %"PRIu32" is overwritten",
+                     s_tLog.ulLastTs - tRec.ulTimestamp, tRec.ulSeq);
+            s_tLog.ulBackStepSeq = tRec.ulSeq;
+        }
+        s_tLog.ulLastTs = tRec.ulTimestamp;
+        if (0 == s_tLog.ulHeadSlot)
+        {
+            s_tLog.pulSectorSeq[s_tLog.ulHeadSector] = tRec.ulSeq;
+            s_tLog.pulSectorTs[s_tLog.ulHeadSector]  = tRec.ulTimestamp;
+        }
+        ptEvent->ulSeq = tRec.ulSeq;
+        s_tLog.ulHeadSlot++;
+        s_tLog.ulNextSeq++;
+        s_tLog.ulAppends++;
+    }
+    else
+    {
+        /* Skip the slot: it may be partially programmed */
+        s_tLog.ulHeadSlot++;
+        ESP_LOGE(TAG, "Append failed: %s", esp_err_to_name(err));
+    }
+
+    xSemaphoreGive(s_tLog.hMutex);
+    return err;
+}
+
+esp_err_t
+Bell_Log_Record(BELL_SOURCE_E eSource, uint16_t usDurationSec)
+{
+    BELL_EVENT_T tEvent = {
+        .usDurationSec = usDurationSec,
+        .usBellId      = BELL_LOG_BELL_ID_NONE,
+        .ucZone        = 0,
+        .eSource       = eSource,
+    };
+    return Bell_Log_Append(&tEvent);
+}
+
+esp_err_t
+Bell_Log_Query(uint32_t ulFrom, uint32_t ulTo,
+               BELL_EVENT_T* ptOut, uint32_t ulMax,
+               uint32_t* pulCount, bool* pbMore)
+{
+    if ((NULL == ptOut) || (NULL == pulCount)) return ESP_ERR_INVALID_ARG;
+    *pulCount = 0;
+    if (pbMore) *pbMore = false;
+    if (NULL == s_tLog.hMutex) return ESP_ERR_INVALID_STATE;
+    if (ulFrom > ulTo) return ESP_OK;
+
+    BELL_LOG_RECORD_T* ptBuf = (BELL_LOG_RECORD_T*)malloc(BELL_LOG_SECTOR_SIZE);
+    uint32_t* pulOrder = (uint32_t*)malloc(s_tLog.ulSectorCount * sizeof(uint32_t));
+    if ((NULL == ptBuf) || (NULL == pulOrder))
+    {
+        free(ptBuf);
+        free(pulOrder);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTake(s_tLog.hMutex, portMAX_DELAY);
+
+    uint32_t ulUsed   = bellLog_RingOrderLocked(pulOrder);
+    bool     bOrdered = bellLog_IsOrderedLocked(pulOrder, ulUsed);
+
+    /* Binary search: last sector whose first timestamp is <= ulFrom.
+     * Valid only while timestamps are non-decreasing; after a back step
+     * of the clock every sector is read and nothing ends the scan early */
+    uint32_t ulStart = 0;
+    if (bOrdered)
+    {
+        uint32_t ulLo = 0, ulHi = ulUsed;
+        while (ulLo < ulHi)
+        {
+            uint32_t ulMid = (ulLo + ulHi) / 2;
+            if (s_tLog.pulSectorTs[pulOrder[ulMid]] <= ulFrom) ulLo = ulMid + 1;
+            else                                               ulHi = ulMid;
+        }
+        ulStart = (ulLo > 0) ? ulLo - 1 : 0;
+    }
+
+    esp_err_t err = ESP_OK;
+    bool bDone = false;
+    for (uint32_t k = ulStart; k < ulUsed && !bDone; k++)
+    {
+        uint32_t ulSector = pulOrder[k];
+        if (bOrdered && (s_tLog.pulSectorTs[ulSector] > ulTo)) break;
+
+        err = bellLog_ReadSector(ulSector, ptBuf);
+        if (ESP_OK != err) break;
+
+        uint32_t ulSlots = (ulSector == s_tLog.ulHeadSector) ? s_tLog.ulHeadSlot
+                                                             : BELL_LOG_RECORDS_PER_SECTOR;
+        for (uint32_t s = 0; s < ulSlots; s++)
+        {
+            if (!bellLog_IsValid(&ptBuf[s])) continue;
+            if (ptBuf[s].ulTimestamp < ulFrom) continue;
+            if (ptBuf[s].ulTimestamp > ulTo)
+            {
+                if (bOrdered) { bDone = true; break; }
+                continue;
+            }
+
+            if (*pulCount >= ulMax)
+            {
+                if (pbMore) *pbMore = true;
+                bDone = true;
+                break;
+            }
+            bellLog_ToEvent(&ptBuf[s], &ptOut[(*pulCount)++]);
+        }
+    }
+
+    xSemaphoreGive(s_tLog.hMutex);
+
+    free(ptBuf);
+    free(pulOrder);
+    return err;
+}
+
+void
+Bell_Log_GetStats(BELL_LOG_STATS_T* ptStats)
+{
+    if (NULL == ptStats) return;
+    memset(ptStats, 0, sizeof(BELL_LOG_STATS_T));
+    if (NULL == s_tLog.hMutex) return;
+
+    xSemaphoreTake(s_tLog.hMutex, portMAX_DELAY);
+    ptStats->ulCapacity     = s_tLog.ulSectorCount * BELL_LOG_RECORDS_PER_SECTOR;
+    ptStats->ulCount        = bellLog_CountLocked();
+    ptStats->ulNextSeq      = s_tLog.ulNextSeq;
+    ptStats->ulAppends      = s_tLog.ulAppends;
+    ptStats->ulSectorErases = s_tLog.ulSectorErases;
+    xSemaphoreGive(s_tLog.hMutex);
+}
+
+const char*
+Bell_Log_SourceToStr(BELL_SOURCE_E eSource)
+{
+    switch (eSource)
+    {
+        case BELL_SOURCE_SCHEDULE: return "schedule";
+        case BELL_SOURCE_TEST:     return "test";
+        case BELL_SOURCE_PANIC:    return "panic";
+        case BELL_SOURCE_UI:       return "ui";
+        default:                   return "unknown";
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ------------------------------------------------------------------ */
+/* Limits                                                              */
+/* ------------------------------------------------------------------ */
+#define BELL_LOG_PARTITION_LABEL    "bell_log"
+#define BELL_LOG_LABEL_LEN          13      /* truncated bell label incl. '\0' */
+#define BELL_LOG_BELL_ID_NONE       0       /* event not tied to a schedule bell (SCHEDULE_ITEM_ID_NONE) */
+
+typedef enum
+{
+    BELL_SOURCE_SCHEDULE = 0,   /* Fired by the scheduler task */
+    BELL_SOURCE_TEST     = 1,   /* Test ring from the web UI */
+    BELL_SOURCE_PANIC    = 2,   /* Panic mode enabled (web or touchscreen) */
+    BELL_SOURCE_UI       = 3,   /* Test ring from the touchscreen */
+} BELL_SOURCE_E;
+
+typedef struct
+{
+    uint32_t      ulSeq;          /* assigned by Bell_Log_Append */
+    uint32_t      ulTimestamp;    /* Unix time, UTC seconds */
+    int32_t       lLatenessMs;    /* actual - scheduled start (schedule source only) */
+    uint16_t      usDurationSec;  /* 0 = until stopped (panic) */
+    uint16_t      usBellId;       /* the bell's stable id (usId), or BELL_LOG_BELL_ID_NONE */
+    uint8_t       ucZone;         /* relay zone (single relay today: 0) */
+    BELL_SOURCE_E eSource;
+    char          acLabel[BELL_LOG_LABEL_LEN];
+} BELL_EVENT_T;
+
+typedef struct
+{
+    uint32_t ulCapacity;        /* records the partition can hold */
+    uint32_t ulCount;           /* records currently stored */
+    uint32_t ulNextSeq;
+    uint32_t ulAppends;         /* appends since boot */
+    uint32_t ulSectorErases;    /* sector erases since boot */
+} BELL_LOG_STATS_T;
+
+/**
+ * @brief Locate the head of the ring on the bell_log partition and build
+ *        the per-sector sparse index.
+ */
+esp_err_t Bell_Log_Init(void);
+
+/**
+ * @brief Append one event (one 32-byte flash write; one sector erase
+ *        every 128 appends when the ring advances into a new sector).
+ *        ulSeq is filled in; ulTimestamp is taken from the clock if 0.
+ *        Takes the log's own mutex and may block on flash: do not call
+ *        with another module's lock held.
+ * @return ESP_ERR_INVALID_STATE, nothing written, while the clock is not
+ *         synced: the sector index is only searched while timestamps grow.
+ */
+esp_err_t Bell_Log_Append(BELL_EVENT_T* ptEvent);
+
+/**
+ * @brief Convenience wrapper for a non-schedule source.
+ */
+esp_err_t Bell_Log_Record(BELL_SOURCE_E eSource, uint16_t usDurationSec);
+
+/**
+ * @brief Copy events with ulFrom <= timestamp <= ulTo, oldest first
+ *        (in seq order). The start sector is found by binary search over
+ *        the sparse index; while a record written after the clock stepped
+ *        back is still stored, the whole log is scanned instead.
+ * @param pulCount  Receives the number of events written to ptOut.
+ * @param pbMore    If non-NULL, set when more matching events exist past ulMax.
+ */
+esp_err_t Bell_Log_Query(uint32_t ulFrom, uint32_t ulTo,
+                         BELL_EVENT_T* ptOut, uint32_t ulMax,
+                         uint32_t* pulCount, bool* pbMore);
+
+/**
+ * @brief Snapshot log counters.
+ */
+void Bell_Log_GetStats(BELL_LOG_STATS_T* ptStats);
+
+/**
+ * @brief JSON name of a trigger source ("schedule", "test", "panic", "ui").
+ */
+const char* Bell_Log_SourceToStr(BELL_SOURCE_E eSource);
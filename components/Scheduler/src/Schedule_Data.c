@@ -1,4 +1,5 @@
 #include "Schedule_Data.h"
+#include "Schedule_Persist.h"
 #include "SPIFFS_API.h"
 #include "esp_log.h"
 #include <string.h>
@@ -8,8 +9,6 @@
 
 static const char* TAG = "schedule_data";
 
-#define JSON_READ_BUF_SIZE  8192
-
 /* ================================================================== */
 /* Internal helpers                                                    */
 /* ================================================================== */
@@ -32,21 +31,50 @@ dateStrToOrdinal(const char* pcDate)
     return (int)(t / 86400);
 }
 
+bool
+Schedule_Data_IsValidDate(const char* pcDate)
+{
+    static const uint8_t aucMonthDays[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    /* Stops at a short string's terminator, which is neither digit nor dash */
+    for (int i = 0; i < 10; i++)
+    {
+        bool bDash = (4 == i) || (7 == i);
+        if (bDash ? (pcDate[i] != '-') : ((pcDate[i] < '0') || (pcDate[i] > '9'))) return false;
+    }
+    if (pcDate[10] != '\0') return false;
+
+    int iYear  = atoi(pcDate);
+    int iMonth = atoi(pcDate + 5);
+    int iDay   = atoi(pcDate + 8);
+    if ((iMonth < 1) || (iMonth > 12)) return false;
+
+    bool bLeap    = ((iYear % 4 == 0) && (iYear % 100 != 0)) || (iYear % 400 == 0);
+    int  iMaxDay  = ((2 == iMonth) && !bLeap) ? 28 : aucMonthDays[iMonth - 1];
+    return (iDay >= 1) && (iDay <= iMaxDay);
+}
+
 static cJSON*
 readJsonFile(const char* pcPath)
 {
-    char* pcBuf = (char*)malloc(JSON_READ_BUF_SIZE);
-    if (NULL == pcBuf) return NULL;
+    /* Edits not yet flushed take precedence over the file on flash */
+    cJSON* ptStaged = NULL;
+    if (Schedule_Persist_ParseStaged(pcPath, &ptStaged)) return ptStaged;
 
+    /* Sized from the file: the body limits allow sections well past 8 KB */
+    char* pcBuf = NULL;
     size_t ulRead = 0;
-    esp_err_t err = SPIFFS_ReadFile(pcPath, pcBuf, JSON_READ_BUF_SIZE, &ulRead);
+    esp_err_t err = SPIFFS_ReadFileAlloc(pcPath, &pcBuf, &ulRead);
     if (err != ESP_OK)
     {
-        free(pcBuf);
+        if (err != ESP_ERR_NOT_FOUND)
+        {
+            ESP_LOGE(TAG, "Failed to read %s: %s", pcPath, esp_err_to_name(err));
+        }
         return NULL;
     }
 
-    cJSON* ptRoot = cJSON_Parse(pcBuf);
+    cJSON* ptRoot = cJSON_ParseWithLength(pcBuf, ulRead);
     free(pcBuf);
     return ptRoot;
 }
@@ -54,14 +82,73 @@ readJsonFile(const char* pcPath)
 static esp_err_t
 writeJsonFile(const char* pcPath, cJSON* ptRoot)
 {
-    const char* pcJson = cJSON_PrintUnformatted(ptRoot);
+    /* cJSON may be hooked to a short-lived allocator (the web server's
+     * request arena), so the text handed on is a plain heap copy. */
+    char* pcPrinted = cJSON_PrintUnformatted(ptRoot);
+    if (NULL == pcPrinted) return ESP_ERR_NO_MEM;
+    char* pcJson = strdup(pcPrinted);
+    cJSON_free(pcPrinted);
     if (NULL == pcJson) return ESP_ERR_NO_MEM;
 
+    /* Write-behind: the persistence layer takes ownership of pcJson.
+     * The generation moves only once the new content is readable, so a
+     * reader that samples it before loading never tags old data as new. */
+    if (Schedule_Persist_Stage(pcPath, pcJson) == ESP_OK)
+    {
+        Schedule_Persist_NoteChanged(pcPath);
+        return ESP_OK;
+    }
+
     esp_err_t err = SPIFFS_WriteFile(pcPath, pcJson, strlen(pcJson));
-    free((void*)pcJson);
+    free(pcJson);
+    if (err == ESP_OK) Schedule_Persist_NoteChanged(pcPath);
     return err;
 }
 
+/** File exists on flash or is staged for the next flush */
+static bool
+jsonFileExists(const char* pcPath)
+{
+    return Schedule_Persist_IsStaged(pcPath) || SPIFFS_FileExists(pcPath);
+}
+
+uint16_t
+Schedule_Data_ReadItemId(const cJSON* ptItem)
+{
+    cJSON* ptId = cJSON_GetObjectItem(ptItem, "id");
+    if (!cJSON_IsNumber(ptId) || (ptId->valueint < 1) || (ptId->valueint > UINT16_MAX))
+    {
+        return SCHEDULE_ITEM_ID_NONE;
+    }
+    return (uint16_t)ptId->valueint;
+}
+
+/** Keep unique ids, renumber missing and duplicate ones after the highest kept */
+static void
+assignIds(uint16_t* apusId[], uint32_t ulCount)
+{
+    uint32_t ulMax = 0;
+
+    for (uint32_t i = 0; i < ulCount; i++)
+    {
+        uint16_t usId = *apusId[i];
+        for (uint32_t j = 0; (usId != SCHEDULE_ITEM_ID_NONE) && (j < i); j++)
+        {
+            if (*apusId[j] == usId) usId = SCHEDULE_ITEM_ID_NONE;
+        }
+        *apusId[i] = usId;
+        if (usId > ulMax) ulMax = usId;
+    }
+
+    for (uint32_t i = 0; i < ulCount; i++)
+    {
+        if ((*apusId[i] == SCHEDULE_ITEM_ID_NONE) && (ulMax < UINT16_MAX))
+        {
+            *apusId[i] = (uint16_t)++ulMax;
+        }
+    }
+}
+
 static void
 parseBellArray(cJSON* ptArray, BELL_ENTRY_T* ptBells, uint32_t* pulCount, uint32_t ulMax)
 {
@@ -84,6 +171,7 @@ parseBellArray(cJSON* ptArray, BELL_ENTRY_T* ptBells, uint32_t* pulCount, uint32
             ptBells[*pulCount].ucHour        = (uint8_t)ptHour->valueint;
             ptBells[*pulCount].ucMinute       = (uint8_t)ptMin->valueint;
             ptBells[*pulCount].usDurationSec  = (ptDur && cJSON_IsNumber(ptDur)) ? (uint16_t)ptDur->valueint : 3;
+            ptBells[*pulCount].usId           = Schedule_Data_ReadItemId(ptItem);
             memset(ptBells[*pulCount].acLabel, 0, SCHEDULE_LABEL_MAX_LEN);
             if (ptLbl && cJSON_IsString(ptLbl))
             {
@@ -100,12 +188,7 @@ bellsToJsonArray(const BELL_ENTRY_T* ptBells, uint32_t ulCount)
     cJSON* ptArr = cJSON_CreateArray();
     for (uint32_t i = 0; i < ulCount; i++)
     {
-        cJSON* ptItem = cJSON_CreateObject();
-        cJSON_AddNumberToObject(ptItem, "hour", ptBells[i].ucHour);
-        cJSON_AddNumberToObject(ptItem, "minute", ptBells[i].ucMinute);
-        cJSON_AddNumberToObject(ptItem, "durationSec", ptBells[i].usDurationSec);
-        cJSON_AddStringToObject(ptItem, "label", ptBells[i].acLabel);
-        cJSON_AddItemToArray(ptArr, ptItem);
+        cJSON_AddItemToArray(ptArr, Schedule_Data_BellToJson(&ptBells[i]));
     }
     return ptArr;
 }
@@ -230,9 +313,41 @@ Schedule_Data_LoadBells(SCHEDULE_SHIFT_T* ptFirst, SCHEDULE_SHIFT_T* ptSecond)
     }
 
     cJSON_Delete(ptRoot);
+    Schedule_Data_AssignBellIds(ptFirst, ptSecond);
     return ESP_OK;
 }
 
+void
+Schedule_Data_AssignBellIds(SCHEDULE_SHIFT_T* ptFirst, SCHEDULE_SHIFT_T* ptSecond)
+{
+    uint16_t* apusId[2 * SCHEDULE_MAX_BELLS_PER_SHIFT];
+    uint32_t  ulCount = 0;
+
+    for (uint32_t i = 0; i < ptFirst->ulBellCount; i++)  apusId[ulCount++] = &ptFirst->atBells[i].usId;
+    for (uint32_t i = 0; i < ptSecond->ulBellCount; i++) apusId[ulCount++] = &ptSecond->atBells[i].usId;
+
+    assignIds(apusId, ulCount);
+}
+
+void
+Schedule_Data_SortBells(SCHEDULE_SHIFT_T* ptShift)
+{
+    /* Insertion sort: the list is short and all but one bell is in order */
+    for (uint32_t i = 1; i < ptShift->ulBellCount; i++)
+    {
+        BELL_ENTRY_T tBell    = ptShift->atBells[i];
+        int          iMinutes = tBell.ucHour * 60 + tBell.ucMinute;
+        uint32_t     j        = i;
+
+        while ((j > 0) && (ptShift->atBells[j - 1].ucHour * 60 + ptShift->atBells[j - 1].ucMinute > iMinutes))
+        {
+            ptShift->atBells[j] = ptShift->atBells[j - 1];
+            j--;
+        }
+        ptShift->atBells[j] = tBell;
+    }
+}
+
 esp_err_t
 Schedule_Data_SaveBells(const SCHEDULE_SHIFT_T* ptFirst, const SCHEDULE_SHIFT_T* ptSecond)
 {
@@ -394,6 +509,7 @@ Schedule_Data_LoadCalendar(SCHEDULE_DATA_T* ptData)
             if (ptStart && cJSON_IsString(ptStart) && ptEnd && cJSON_IsString(ptEnd))
             {
                 HOLIDAY_T* ptH = &ptData->atHolidays[ptData->ulHolidayCount];
+                ptH->usId = Schedule_Data_ReadItemId(ptItem);
                 strncpy(ptH->acStartDate, ptStart->valuestring, SCHEDULE_DATE_STR_LEN - 1);
                 strncpy(ptH->acEndDate, ptEnd->valuestring, SCHEDULE_DATE_STR_LEN - 1);
                 memset(ptH->acLabel, 0, SCHEDULE_LABEL_MAX_LEN);
@@ -424,6 +540,7 @@ Schedule_Data_LoadCalendar(SCHEDULE_DATA_T* ptData)
             memset(ptEx, 0, sizeof(EXCEPTION_ENTRY_T));
             strncpy(ptEx->acStartDate, ptStart->valuestring, SCHEDULE_DATE_STR_LEN - 1);
             ptEx->ucCustomBellsIdx = 0xFF;
+            ptEx->usId = Schedule_Data_ReadItemId(ptItem);
 
             cJSON* ptEnd = cJSON_GetObjectItem(ptItem, "endDate");
             if (ptEnd && cJSON_IsString(ptEnd))
@@ -485,9 +602,22 @@ Schedule_Data_LoadCalendar(SCHEDULE_DATA_T* ptData)
     }
 
     cJSON_Delete(ptRoot);
+    Schedule_Data_AssignCalendarIds(ptData);
     return ESP_OK;
 }
 
+void
+Schedule_Data_AssignCalendarIds(SCHEDULE_DATA_T* ptData)
+{
+    uint16_t* apusId[SCHEDULE_MAX_HOLIDAYS];
+
+    for (uint32_t i = 0; i < ptData->ulHolidayCount; i++) apusId[i] = &ptData->atHolidays[i].usId;
+    assignIds(apusId, ptData->ulHolidayCount);
+
+    for (uint32_t i = 0; i < ptData->ulExceptionCount; i++) apusId[i] = &ptData->atExceptions[i].usId;
+    assignIds(apusId, ptData->ulExceptionCount);
+}
+
 esp_err_t
 Schedule_Data_SaveCalendar(const SCHEDULE_DATA_T* ptData)
 {
@@ -499,28 +629,14 @@ Schedule_Data_SaveCalendar(const SCHEDULE_DATA_T* ptData)
     cJSON* ptHolArr = cJSON_AddArrayToObject(ptRoot, "holidays");
     for (uint32_t i = 0; i < ptData->ulHolidayCount; i++)
     {
-        cJSON* ptItem = cJSON_CreateObject();
-        cJSON_AddStringToObject(ptItem, "startDate", ptData->atHolidays[i].acStartDate);
-        cJSON_AddStringToObject(ptItem, "endDate", ptData->atHolidays[i].acEndDate);
-        cJSON_AddStringToObject(ptItem, "label", ptData->atHolidays[i].acLabel);
-        cJSON_AddItemToArray(ptHolArr, ptItem);
+        cJSON_AddItemToArray(ptHolArr, Schedule_Data_HolidayToJson(&ptData->atHolidays[i]));
     }
 
     /* Unified exceptions */
     cJSON* ptExArr = cJSON_AddArrayToObject(ptRoot, "exceptions");
     for (uint32_t i = 0; i < ptData->ulExceptionCount; i++)
     {
-        const EXCEPTION_ENTRY_T* ptEx = &ptData->atExceptions[i];
-        cJSON* ptItem = cJSON_CreateObject();
-        cJSON_AddStringToObject(ptItem, "startDate", ptEx->acStartDate);
-        cJSON_AddStringToObject(ptItem, "endDate", ptEx->acEndDate);
-        cJSON_AddStringToObject(ptItem, "label", ptEx->acLabel);
-        cJSON_AddStringToObject(ptItem, "action", actionToStr(ptEx->eAction));
-        cJSON_AddNumberToObject(ptItem, "timeOffsetMin", ptEx->iTimeOffsetMin);
-        cJSON_AddNumberToObject(ptItem, "templateIdx", ptEx->ucTemplateIdx);
-        cJSON_AddNumberToObject(ptItem, "customBellsIdx",
-                                ptEx->ucCustomBellsIdx == 0xFF ? -1 : ptEx->ucCustomBellsIdx);
-        cJSON_AddItemToArray(ptExArr, ptItem);
+        cJSON_AddItemToArray(ptExArr, Schedule_Data_ExceptionToJson(&ptData->atExceptions[i]));
     }
 
     /* Custom bell sets */
@@ -570,6 +686,46 @@ Schedule_Data_BellsToJson(const SCHEDULE_SHIFT_T* ptFirst, const SCHEDULE_SHIFT_
     return ptRoot;
 }
 
+/* Template and custom-set bells carry no id, so theirs is omitted */
+cJSON*
+Schedule_Data_BellToJson(const BELL_ENTRY_T* ptBell)
+{
+    cJSON* ptItem = cJSON_CreateObject();
+    if (ptBell->usId != SCHEDULE_ITEM_ID_NONE) cJSON_AddNumberToObject(ptItem, "id", ptBell->usId);
+    cJSON_AddNumberToObject(ptItem, "hour", ptBell->ucHour);
+    cJSON_AddNumberToObject(ptItem, "minute", ptBell->ucMinute);
+    cJSON_AddNumberToObject(ptItem, "durationSec", ptBell->usDurationSec);
+    cJSON_AddStringToObject(ptItem, "label", ptBell->acLabel);
+    return ptItem;
+}
+
+cJSON*
+Schedule_Data_HolidayToJson(const HOLIDAY_T* ptHoliday)
+{
+    cJSON* ptItem = cJSON_CreateObject();
+    cJSON_AddNumberToObject(ptItem, "id", ptHoliday->usId);
+    cJSON_AddStringToObject(ptItem, "startDate", ptHoliday->acStartDate);
+    cJSON_AddStringToObject(ptItem, "endDate", ptHoliday->acEndDate);
+    cJSON_AddStringToObject(ptItem, "label", ptHoliday->acLabel);
+    return ptItem;
+}
+
+cJSON*
+Schedule_Data_ExceptionToJson(const EXCEPTION_ENTRY_T* ptEx)
+{
+    cJSON* ptItem = cJSON_CreateObject();
+    cJSON_AddNumberToObject(ptItem, "id", ptEx->usId);
+    cJSON_AddStringToObject(ptItem, "startDate", ptEx->acStartDate);
+    cJSON_AddStringToObject(ptItem, "endDate", ptEx->acEndDate);
+    cJSON_AddStringToObject(ptItem, "label", ptEx->acLabel);
+    cJSON_AddStringToObject(ptItem, "action", actionToStr(ptEx->eAction));
+    cJSON_AddNumberToObject(ptItem, "timeOffsetMin", ptEx->iTimeOffsetMin);
+    cJSON_AddNumberToObject(ptItem, "templateIdx", ptEx->ucTemplateIdx);
+    cJSON_AddNumberToObject(ptItem, "customBellsIdx",
+                            ptEx->ucCustomBellsIdx == 0xFF ? -1 : ptEx->ucCustomBellsIdx);
+    return ptItem;
+}
+
 cJSON*
 Schedule_Data_HolidaysToJson(const HOLIDAY_T* ptHolidays, uint32_t ulCount)
 {
@@ -577,11 +733,7 @@ Schedule_Data_HolidaysToJson(const HOLIDAY_T* ptHolidays, uint32_t ulCount)
     cJSON* ptArr = cJSON_AddArrayToObject(ptRoot, "holidays");
     for (uint32_t i = 0; i < ulCount; i++)
     {
-        cJSON* ptItem = cJSON_CreateObject();
-        cJSON_AddStringToObject(ptItem, "startDate", ptHolidays[i].acStartDate);
-        cJSON_AddStringToObject(ptItem, "endDate", ptHolidays[i].acEndDate);
-        cJSON_AddStringToObject(ptItem, "label", ptHolidays[i].acLabel);
-        cJSON_AddItemToArray(ptArr, ptItem);
+        cJSON_AddItemToArray(ptArr, Schedule_Data_HolidayToJson(&ptHolidays[i]));
     }
     return ptRoot;
 }
@@ -595,17 +747,7 @@ Schedule_Data_ExceptionsToJson(const EXCEPTION_ENTRY_T* ptExceptions, uint32_t u
     cJSON* ptExArr = cJSON_AddArrayToObject(ptRoot, "exceptions");
     for (uint32_t i = 0; i < ulCount; i++)
     {
-        const EXCEPTION_ENTRY_T* ptEx = &ptExceptions[i];
-        cJSON* ptItem = cJSON_CreateObject();
-        cJSON_AddStringToObject(ptItem, "startDate", ptEx->acStartDate);
-        cJSON_AddStringToObject(ptItem, "endDate", ptEx->acEndDate);
-        cJSON_AddStringToObject(ptItem, "label", ptEx->acLabel);
-        cJSON_AddStringToObject(ptItem, "action", actionToStr(ptEx->eAction));
-        cJSON_AddNumberToObject(ptItem, "timeOffsetMin", ptEx->iTimeOffsetMin);
-        cJSON_AddNumberToObject(ptItem, "templateIdx", ptEx->ucTemplateIdx);
-        cJSON_AddNumberToObject(ptItem, "customBellsIdx",
-                                ptEx->ucCustomBellsIdx == 0xFF ? -1 : ptEx->ucCustomBellsIdx);
-        cJSON_AddItemToArray(ptExArr, ptItem);
+        cJSON_AddItemToArray(ptExArr, Schedule_Data_ExceptionToJson(&ptExceptions[i]));
     }
 
     cJSON* ptCustArr = cJSON_AddArrayToObject(ptRoot, "customBellSets");
@@ -627,22 +769,17 @@ Schedule_Data_ExceptionsToJson(const EXCEPTION_ENTRY_T* ptExceptions, uint32_t u
 static cJSON*
 readDefaultsFromFlash(void)
 {
-    char* pcBuf = (char*)malloc(JSON_READ_BUF_SIZE);
-    if (NULL == pcBuf) return NULL;
-
-    FILE* pFile = fopen(SCHEDULE_FILE_DEFAULTS, "r");
-    if (NULL == pFile)
+    char* pcBuf = NULL;
+    size_t ulRead = 0;
+    esp_err_t err = SPIFFS_ReadFileAlloc(SCHEDULE_FILE_DEFAULTS, &pcBuf, &ulRead);
+    if (err != ESP_OK)
     {
-        free(pcBuf);
-        ESP_LOGI(TAG, "No flashed default config found at %s", SCHEDULE_FILE_DEFAULTS);
+        ESP_LOGI(TAG, "No flashed default config found at %s (%s)",
+                 SCHEDULE_FILE_DEFAULTS, esp_err_to_name(err));
         return NULL;
     }
 
-    size_t ulRead = fread(pcBuf, 1, JSON_READ_BUF_SIZE - 1, pFile);
-    pcBuf[ulRead] = '\0';
-    fclose(pFile);
-
-    cJSON* ptRoot = cJSON_Parse(pcBuf);
+    cJSON* ptRoot = cJSON_ParseWithLength(pcBuf, ulRead);
     free(pcBuf);
 
     if (ptRoot)
@@ -664,7 +801,7 @@ Schedule_Data_CreateDefaults(void)
     cJSON* ptDefaults = readDefaultsFromFlash();
 
     /* Settings */
-    if (!SPIFFS_FileExists(SCHEDULE_FILE_SETTINGS))
+    if (!jsonFileExists(SCHEDULE_FILE_SETTINGS))
     {
         SCHEDULE_SETTINGS_T tDefSettings = { 0 };
         strncpy(tDefSettings.acTimezone, "UTC0", sizeof(tDefSettings.acTimezone) - 1);
@@ -709,7 +846,7 @@ Schedule_Data_CreateDefaults(void)
 
     /* Bells (two shifts) — heap-allocated to avoid stack overflow
        (each SCHEDULE_SHIFT_T is ~2.6 KB, APP_TASK stack is only 4 KB) */
-    if (!SPIFFS_FileExists(SCHEDULE_FILE_BELLS))
+    if (!jsonFileExists(SCHEDULE_FILE_BELLS))
     {
         SCHEDULE_SHIFT_T* ptFirst  = (SCHEDULE_SHIFT_T*)calloc(1, sizeof(SCHEDULE_SHIFT_T));
         SCHEDULE_SHIFT_T* ptSecond = (SCHEDULE_SHIFT_T*)calloc(1, sizeof(SCHEDULE_SHIFT_T));
@@ -747,7 +884,7 @@ Schedule_Data_CreateDefaults(void)
     }
 
     /* Calendar */
-    if (!SPIFFS_FileExists(SCHEDULE_FILE_CALENDAR))
+    if (!jsonFileExists(SCHEDULE_FILE_CALENDAR))
     {
         cJSON* ptRoot = cJSON_CreateObject();
 
@@ -779,7 +916,7 @@ Schedule_Data_CreateDefaults(void)
     }
 
     /* Templates */
-    if (!SPIFFS_FileExists(SCHEDULE_FILE_TEMPLATES))
+    if (!jsonFileExists(SCHEDULE_FILE_TEMPLATES))
     {
         cJSON* ptRoot = cJSON_CreateObject();
         cJSON_AddItemToObject(ptRoot, "templates", cJSON_CreateArray());
@@ -800,18 +937,10 @@ Schedule_Data_CreateDefaults(void)
 /* Cleanup expired exceptions                                          */
 /* ================================================================== */
 
-esp_err_t
-Schedule_Data_CleanupExpiredExceptions(void)
+bool
+Schedule_Data_CleanupExpiredExceptions(SCHEDULE_DATA_T* ptData)
 {
-    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)calloc(1, sizeof(SCHEDULE_DATA_T));
-    if (NULL == ptData) return ESP_ERR_NO_MEM;
-
-    esp_err_t err = Schedule_Data_LoadCalendar(ptData);
-    if (err != ESP_OK)
-    {
-        free(ptData);
-        return err;
-    }
+    if (NULL == ptData) return false;
 
     /* Get today's ordinal */
     time_t tNow = time(NULL);
@@ -916,13 +1045,11 @@ Schedule_Data_CleanupExpiredExceptions(void)
 
     if (bChanged)
     {
-        err = Schedule_Data_SaveCalendar(ptData);
         ESP_LOGI(TAG, "Calendar cleaned: %"PRIu32" holidays, %"PRIu32" exceptions remaining",
                  ptData->ulHolidayCount, ptData->ulExceptionCount);
     }
 
-    free(ptData);
-    return err;
+    return bChanged;
 }
 
 /* ================================================================== */
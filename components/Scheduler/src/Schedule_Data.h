@@ -18,6 +18,7 @@
 #define SCHEDULE_LABEL_MAX_LEN          48
 #define SCHEDULE_TEMPLATE_NAME_LEN      32
 #define SCHEDULE_DATE_STR_LEN           11  /* "YYYY-MM-DD\0" */
+#define SCHEDULE_ITEM_ID_NONE            0  /* not yet numbered */
 
 /* File paths */
 #define SCHEDULE_FILE_SETTINGS          "/storage/settings.json"
@@ -35,11 +36,13 @@ typedef struct
     uint8_t  ucHour;        /* 0-23 */
     uint8_t  ucMinute;      /* 0-59 */
     uint16_t usDurationSec; /* bell ring duration in seconds */
+    uint16_t usId;          /* stable across edits; shift bells only, unique over both shifts */
     char     acLabel[SCHEDULE_LABEL_MAX_LEN];
 } BELL_ENTRY_T;
 
 typedef struct
 {
+    uint16_t usId;                           /* stable across edits */
     char acStartDate[SCHEDULE_DATE_STR_LEN]; /* "YYYY-MM-DD" */
     char acEndDate[SCHEDULE_DATE_STR_LEN];   /* "YYYY-MM-DD" */
     char acLabel[SCHEDULE_LABEL_MAX_LEN];
@@ -64,6 +67,7 @@ typedef struct
     int8_t             iTimeOffsetMin;    /* -120..+120: shift all bell times */
     uint8_t            ucTemplateIdx;     /* valid when eAction == TEMPLATE */
     uint8_t            ucCustomBellsIdx;  /* index into custom bell sets, 0xFF = none */
+    uint16_t           usId;              /* stable across edits */
 } EXCEPTION_ENTRY_T;
 
 typedef struct
@@ -122,6 +126,11 @@ typedef struct
 
 /* ------------------------------------------------------------------ */
 /* API                                                                 */
+/*                                                                     */
+/* Once the scheduler is running, the Save functions are only called   */
+/* under its lock, from Scheduler_EditData and the scheduler itself.   */
+/* Other components edit the schedule through Scheduler_EditData, so   */
+/* one section is never written by two tasks at once.                  */
 /* ------------------------------------------------------------------ */
 
 /**
@@ -154,6 +163,47 @@ esp_err_t Schedule_Data_LoadCalendar(SCHEDULE_DATA_T* ptData);
  */
 esp_err_t Schedule_Data_SaveCalendar(const SCHEDULE_DATA_T* ptData);
 
+/**
+ * @brief Give every shift bell a unique, non-zero id. Ids that are already
+ *        unique are kept; the rest are numbered after the highest in use.
+ *        Done by Schedule_Data_LoadBells; call before saving bells that
+ *        came from a client.
+ */
+void Schedule_Data_AssignBellIds(SCHEDULE_SHIFT_T* ptFirst, SCHEDULE_SHIFT_T* ptSecond);
+
+/**
+ * @brief Order a shift's bells by time of day; bells at the same time
+ *        keep their order.
+ */
+void Schedule_Data_SortBells(SCHEDULE_SHIFT_T* ptShift);
+
+/**
+ * @brief Same as Schedule_Data_AssignBellIds for holidays and exceptions
+ *        (each numbered separately). Done by Schedule_Data_LoadCalendar.
+ */
+void Schedule_Data_AssignCalendarIds(SCHEDULE_DATA_T* ptData);
+
+/**
+ * @brief Item "id" from JSON, or SCHEDULE_ITEM_ID_NONE if absent or out of
+ *        range. A client-supplied id is kept if unique, otherwise it is
+ *        renumbered on save.
+ */
+uint16_t Schedule_Data_ReadItemId(const cJSON* ptItem);
+
+/**
+ * @brief true if pcDate is a calendar date written as "YYYY-MM-DD".
+ *        Dates in that form compare in order with strcmp.
+ */
+bool Schedule_Data_IsValidDate(const char* pcDate);
+
+/**
+ * @brief Serialize one bell, holiday or exception as it appears in the
+ *        section arrays (caller must cJSON_Delete).
+ */
+cJSON* Schedule_Data_BellToJson(const BELL_ENTRY_T* ptBell);
+cJSON* Schedule_Data_HolidayToJson(const HOLIDAY_T* ptHoliday);
+cJSON* Schedule_Data_ExceptionToJson(const EXCEPTION_ENTRY_T* ptException);
+
 /**
  * @brief Serialize settings to cJSON (caller must cJSON_Delete).
  */
@@ -203,8 +253,10 @@ cJSON* Schedule_Data_ReadDefaultsJson(void);
 esp_err_t Schedule_Data_CreateDefaults(void);
 
 /**
- * @brief Remove expired exceptions (date is in the past).
- *        Call from scheduler task after midnight.
- * @return ESP_OK if cleanup succeeded (even if nothing to clean).
+ * @brief Remove expired exceptions and holiday ranges (date is in the past)
+ *        from a loaded calendar, and custom bell sets no longer used.
+ *        Does not save; the scheduler runs it through Scheduler_EditData
+ *        after midnight.
+ * @return true if anything was removed.
  */
-esp_err_t Schedule_Data_CleanupExpiredExceptions(void);
+bool Schedule_Data_CleanupExpiredExceptions(SCHEDULE_DATA_T* ptData);
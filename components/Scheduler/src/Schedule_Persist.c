@@ -0,0 +1,368 @@
+#include "Schedule_Persist.h"
+#include "Schedule_Data.h"
+#include "SPIFFS_API.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+static const char* TAG = "schedule_persist";
+
+#define PERSIST_TASK_STACK_SIZE     4096
+#define PERSIST_TASK_PRIORITY       2
+#define PERSIST_DELAY_MS            CONFIG_SCHEDULER_PERSIST_DELAY_MS
+
+/* ------------------------------------------------------------------ */
+/* State                                                               */
+/* ------------------------------------------------------------------ */
+
+static const char* const s_apcSectionPath[SCHEDULE_SECTION_COUNT] =
+{
+    [SCHEDULE_SECTION_SETTINGS]  = SCHEDULE_FILE_SETTINGS,
+    [SCHEDULE_SECTION_BELLS]     = SCHEDULE_FILE_BELLS,
+    [SCHEDULE_SECTION_CALENDAR]  = SCHEDULE_FILE_CALENDAR,
+    [SCHEDULE_SECTION_TEMPLATES] = SCHEDULE_FILE_TEMPLATES,
+};
+
+typedef struct
+{
+    SemaphoreHandle_t        hMutex;        /* staged state; never held across file I/O */
+    SemaphoreHandle_t        hFlushMutex;   /* one flush at a time, so writes stay in order */
+    TaskHandle_t             hTask;
+    esp_timer_handle_t       hTimer;
+    char*                    apcStaged[SCHEDULE_SECTION_COUNT];
+    char*                    apcInFlight[SCHEDULE_SECTION_COUNT]; /* being written by a flush */
+    int64_t                  llFirstDirtyUs;
+    SCHEDULE_PERSIST_STATS_T tStats;
+} PERSIST_STATE_T;
+
+static PERSIST_STATE_T s_tPersist;
+
+/* Usable before Schedule_Persist_Init (defaults are written at boot) */
+static atomic_uint_fast32_t s_aulGeneration[SCHEDULE_SECTION_COUNT];
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+
+static int
+persist_SectionFromPath(const char* pcPath)
+{
+    for (int i = 0; i < SCHEDULE_SECTION_COUNT; i++)
+    {
+        if (strcmp(pcPath, s_apcSectionPath[i]) == 0) return i;
+    }
+    return -1;
+}
+
+/** esp_timer context: hand the flush to the persist task (no flash I/O here) */
+static void
+persist_TimerCallback(void* pvArg)
+{
+    (void)pvArg;
+    xTaskNotifyGive(s_tPersist.hTask);
+}
+
+static void
+persist_Task(void* pvArg)
+{
+    (void)pvArg;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        Schedule_Persist_Flush();
+    }
+}
+
+static void
+persist_ShutdownHandler(void)
+{
+    Schedule_Persist_Flush();
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                          */
+/* ------------------------------------------------------------------ */
+
+esp_err_t
+Schedule_Persist_Init(void)
+{
+    s_tPersist.tStats.ulDelayMs = PERSIST_DELAY_MS;
+
+    if (NULL != s_tPersist.hMutex) return ESP_OK;
+
+    if (PERSIST_DELAY_MS == 0)
+    {
+        ESP_LOGI(TAG, "Write-behind disabled, schedule edits are written through");
+        return ESP_OK;
+    }
+
+    s_tPersist.hMutex      = xSemaphoreCreateMutex();
+    s_tPersist.hFlushMutex = xSemaphoreCreateMutex();
+    if ((NULL == s_tPersist.hMutex) || (NULL == s_tPersist.hFlushMutex))
+    {
+        if (NULL != s_tPersist.hMutex) vSemaphoreDelete(s_tPersist.hMutex);
+        if (NULL != s_tPersist.hFlushMutex) vSemaphoreDelete(s_tPersist.hFlushMutex);
+        s_tPersist.hMutex      = NULL;
+        s_tPersist.hFlushMutex = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t tTimerArgs = {
+        .callback = persist_TimerCallback,
+        .name     = "sched_persist",
+    };
+    esp_err_t err = esp_timer_create(&tTimerArgs, &s_tPersist.hTimer);
+    if (ESP_OK != err)
+    {
+        vSemaphoreDelete(s_tPersist.hFlushMutex);
+        vSemaphoreDelete(s_tPersist.hMutex);
+        s_tPersist.hMutex = NULL;
+        return err;
+    }
+
+    BaseType_t xResult = xTaskCreate(persist_Task, "SCHED_PERSIST",
+                                     PERSIST_TASK_STACK_SIZE,
+                                     NULL,
+                                     PERSIST_TASK_PRIORITY,
+                                     &s_tPersist.hTask);
+    if (pdPASS != xResult)
+    {
+        esp_timer_delete(s_tPersist.hTimer);
+        vSemaphoreDelete(s_tPersist.hFlushMutex);
+        vSemaphoreDelete(s_tPersist.hMutex);
+        s_tPersist.hMutex = NULL;
+        return ESP_FAIL;
+    }
+
+    err = esp_register_shutdown_handler(persist_ShutdownHandler);
+    if (ESP_OK != err)
+    {
+        ESP_LOGW(TAG, "Shutdown hook not registered: %s", esp_err_to_name(err));
+    }
+
+    ESP_LOGI(TAG, "Write-behind enabled (%d ms window)", PERSIST_DELAY_MS);
+    return ESP_OK;
+}
+
+esp_err_t
+Schedule_Persist_Stage(const char* pcPath, char* pcJson)
+{
+    if ((NULL == pcPath) || (NULL == pcJson)) return ESP_ERR_INVALID_ARG;
+    if (NULL == s_tPersist.hMutex) return ESP_ERR_INVALID_STATE;
+
+    int iSection = persist_SectionFromPath(pcPath);
+    if (iSection < 0) return ESP_ERR_NOT_SUPPORTED;
+
+    xSemaphoreTake(s_tPersist.hMutex, portMAX_DELAY);
+
+    if (NULL != s_tPersist.apcStaged[iSection])
+    {
+        free(s_tPersist.apcStaged[iSection]);
+        s_tPersist.tStats.ulCoalescedCount++;
+    }
+    s_tPersist.apcStaged[iSection] = pcJson;
+
+    /* The window opens on the first unsaved edit and is not extended by
+     * later ones, so a steady stream of edits still reaches flash. */
+    if (0 == s_tPersist.tStats.ulPendingMask)
+    {
+        s_tPersist.llFirstDirtyUs = esp_timer_get_time();
+        esp_timer_start_once(s_tPersist.hTimer, (uint64_t)PERSIST_DELAY_MS * 1000ULL);
+    }
+    s_tPersist.tStats.ulPendingMask |= (1UL << iSection);
+    s_tPersist.tStats.ulEditCount++;
+
+    xSemaphoreGive(s_tPersist.hMutex);
+    return ESP_OK;
+}
+
+bool
+Schedule_Persist_ParseStaged(const char* pcPath, cJSON** pptRoot)
+{
+    if ((NULL == pcPath) || (NULL == pptRoot) || (NULL == s_tPersist.hMutex)) return false;
+
+    int iSection = persist_SectionFromPath(pcPath);
+    if (iSection < 0) return false;
+
+    bool bStaged = false;
+    xSemaphoreTake(s_tPersist.hMutex, portMAX_DELAY);
+    /* The file may be half written while a flush is on it: use its copy */
+    const char* pcJson = (NULL != s_tPersist.apcStaged[iSection]) ? s_tPersist.apcStaged[iSection]
+                                                                  : s_tPersist.apcInFlight[iSection];
+    if (NULL != pcJson)
+    {
+        *pptRoot = cJSON_Parse(pcJson);
+        bStaged = true;
+    }
+    xSemaphoreGive(s_tPersist.hMutex);
+
+    return bStaged;
+}
+
+bool
+Schedule_Persist_IsStaged(const char* pcPath)
+{
+    if ((NULL == pcPath) || (NULL == s_tPersist.hMutex)) return false;
+
+    int iSection = persist_SectionFromPath(pcPath);
+    if (iSection < 0) return false;
+
+    xSemaphoreTake(s_tPersist.hMutex, portMAX_DELAY);
+    bool bStaged = (NULL != s_tPersist.apcStaged[iSection]) || (NULL != s_tPersist.apcInFlight[iSection]);
+    xSemaphoreGive(s_tPersist.hMutex);
+
+    return bStaged;
+}
+
+esp_err_t
+Schedule_Persist_Flush(void)
+{
+    if (NULL == s_tPersist.hMutex) return ESP_OK;
+
+    /* Explicit flushes (reboot, factory reset) race the window timer's;
+     * the later one waits, so a section is never written out of order */
+    xSemaphoreTake(s_tPersist.hFlushMutex, portMAX_DELAY);
+    xSemaphoreTake(s_tPersist.hMutex, portMAX_DELAY);
+
+    if (0 == s_tPersist.tStats.ulPendingMask)
+    {
+        xSemaphoreGive(s_tPersist.hMutex);
+        xSemaphoreGive(s_tPersist.hFlushMutex);
+        return ESP_OK;
+    }
+
+    esp_timer_stop(s_tPersist.hTimer);
+
+    /* Take the staged copies: edits staged from here on wait for the next
+     * flush instead of for this one's SPIFFS writes */
+    for (int i = 0; i < SCHEDULE_SECTION_COUNT; i++)
+    {
+        s_tPersist.apcInFlight[i] = s_tPersist.apcStaged[i];
+        s_tPersist.apcStaged[i]   = NULL;
+    }
+
+    xSemaphoreGive(s_tPersist.hMutex);
+
+    esp_err_t errRet = ESP_OK;
+    esp_err_t aErr[SCHEDULE_SECTION_COUNT];
+    uint32_t ulWritten = 0;
+    int64_t llStartUs = esp_timer_get_time();
+
+    for (int i = 0; i < SCHEDULE_SECTION_COUNT; i++)
+    {
+        const char* pcJson = s_tPersist.apcInFlight[i];  /* only this flush changes it */
+        aErr[i] = ESP_OK;
+        if (NULL == pcJson) continue;
+
+        aErr[i] = SPIFFS_WriteFile(s_apcSectionPath[i], pcJson, strlen(pcJson));
+        if (ESP_OK != aErr[i])
+        {
+            ESP_LOGE(TAG, "Flush of %s failed: %s", s_apcSectionPath[i], esp_err_to_name(aErr[i]));
+            errRet = aErr[i];
+            continue;
+        }
+        ulWritten++;
+    }
+
+    int64_t llEndUs = esp_timer_get_time();
+    uint32_t ulFlushUs = (uint32_t)(llEndUs - llStartUs);
+
+    xSemaphoreTake(s_tPersist.hMutex, portMAX_DELAY);
+
+    for (int i = 0; i < SCHEDULE_SECTION_COUNT; i++)
+    {
+        char* pcJson = s_tPersist.apcInFlight[i];
+        if (NULL == pcJson) continue;
+        s_tPersist.apcInFlight[i] = NULL;
+
+        if (ESP_OK == aErr[i])
+        {
+            s_tPersist.tStats.aulWriteCount[i]++;
+            free(pcJson);
+        }
+        else if (NULL == s_tPersist.apcStaged[i])
+        {
+            /* Stage it again so the edit is retried, not lost */
+            s_tPersist.tStats.ulWriteErrors++;
+            s_tPersist.apcStaged[i] = pcJson;
+        }
+        else
+        {
+            /* A newer edit came in meanwhile; it replaces this one */
+            s_tPersist.tStats.ulWriteErrors++;
+            free(pcJson);
+        }
+
+        if (NULL == s_tPersist.apcStaged[i])
+        {
+            s_tPersist.tStats.ulPendingMask &= ~(1UL << i);
+        }
+    }
+
+    s_tPersist.tStats.ulLastFlushUs = ulFlushUs;
+    if (ulFlushUs > s_tPersist.tStats.ulMaxFlushUs)
+    {
+        s_tPersist.tStats.ulMaxFlushUs = ulFlushUs;
+    }
+    if (ulWritten > 0)
+    {
+        s_tPersist.tStats.ulFlushCount++;
+        s_tPersist.tStats.ulLastPendingAgeMs = (uint32_t)((llEndUs - s_tPersist.llFirstDirtyUs) / 1000);
+    }
+
+    /* Retries and edits staged during the writes get a new window */
+    if (0 != s_tPersist.tStats.ulPendingMask)
+    {
+        s_tPersist.llFirstDirtyUs = llEndUs;
+        esp_timer_start_once(s_tPersist.hTimer, (uint64_t)PERSIST_DELAY_MS * 1000ULL);
+    }
+
+    xSemaphoreGive(s_tPersist.hMutex);
+    xSemaphoreGive(s_tPersist.hFlushMutex);
+
+    ESP_LOGI(TAG, "Flushed %"PRIu32" file(s) in %"PRIu32" us", ulWritten, ulFlushUs);
+    return errRet;
+}
+
+void
+Schedule_Persist_GetStats(SCHEDULE_PERSIST_STATS_T* ptStats)
+{
+    if (NULL == ptStats) return;
+
+    if (NULL == s_tPersist.hMutex)
+    {
+        *ptStats = s_tPersist.tStats;
+        return;
+    }
+
+    xSemaphoreTake(s_tPersist.hMutex, portMAX_DELAY);
+    *ptStats = s_tPersist.tStats;
+    xSemaphoreGive(s_tPersist.hMutex);
+}
+
+void
+Schedule_Persist_NoteChanged(const char* pcPath)
+{
+    if (NULL == pcPath) return;
+
+    int iSection = persist_SectionFromPath(pcPath);
+    if (iSection >= 0)
+    {
+        atomic_fetch_add(&s_aulGeneration[iSection], 1);
+    }
+}
+
+uint32_t
+Schedule_Persist_GetGeneration(SCHEDULE_SECTION_E eSection)
+{
+    if ((unsigned)eSection >= SCHEDULE_SECTION_COUNT) return 0;
+    return (uint32_t)atomic_load(&s_aulGeneration[eSection]);
+}
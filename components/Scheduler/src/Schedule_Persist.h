@@ -0,0 +1,82 @@
+#pragma once
+
+#include "esp_err.h"
+#include "cJSON.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ------------------------------------------------------------------ */
+/* Sections (one per schedule JSON file)                               */
+/* ------------------------------------------------------------------ */
+typedef enum
+{
+    SCHEDULE_SECTION_SETTINGS  = 0,
+    SCHEDULE_SECTION_BELLS     = 1,
+    SCHEDULE_SECTION_CALENDAR  = 2,
+    SCHEDULE_SECTION_TEMPLATES = 3,
+    SCHEDULE_SECTION_COUNT
+} SCHEDULE_SECTION_E;
+
+typedef struct
+{
+    uint32_t ulDelayMs;                               /* configured write-behind window */
+    uint32_t ulPendingMask;                           /* bit per SCHEDULE_SECTION_E */
+    uint32_t ulEditCount;                             /* edits staged since boot */
+    uint32_t ulCoalescedCount;                        /* edits that replaced a pending one */
+    uint32_t ulFlushCount;                            /* flushes that wrote at least one file */
+    uint32_t ulWriteErrors;
+    uint32_t aulWriteCount[SCHEDULE_SECTION_COUNT];   /* file writes per section */
+    uint32_t ulLastFlushUs;                           /* duration of the last flush */
+    uint32_t ulMaxFlushUs;
+    uint32_t ulLastPendingAgeMs;                      /* first edit -> on flash, last flush */
+} SCHEDULE_PERSIST_STATS_T;
+
+/**
+ * @brief Start the write-behind flusher and register the shutdown hook.
+ *        Until this is called every save is written through immediately.
+ */
+esp_err_t Schedule_Persist_Init(void);
+
+/**
+ * @brief Stage the serialized JSON for a schedule file.
+ * @param pcPath  One of the SCHEDULE_FILE_* paths.
+ * @param pcJson  Heap string; ownership passes to the persistence layer on ESP_OK.
+ * @return ESP_OK if staged, ESP_ERR_INVALID_STATE if write-behind is
+ *         disabled or not started (caller must write through).
+ */
+esp_err_t Schedule_Persist_Stage(const char* pcPath, char* pcJson);
+
+/**
+ * @brief Parse the staged (not yet flushed) content for a file.
+ * @return true if a staged copy exists; *pptRoot holds the parse result.
+ */
+bool Schedule_Persist_ParseStaged(const char* pcPath, cJSON** pptRoot);
+
+/**
+ * @brief True if the file has staged content waiting to be flushed.
+ */
+bool Schedule_Persist_IsStaged(const char* pcPath);
+
+/**
+ * @brief Write all staged sections to SPIFFS now (blocking).
+ *
+ * The writes run without the staging lock; a concurrent flush waits for this one.
+ */
+esp_err_t Schedule_Persist_Flush(void);
+
+/**
+ * @brief Snapshot write-behind counters.
+ */
+void Schedule_Persist_GetStats(SCHEDULE_PERSIST_STATS_T* ptStats);
+
+/**
+ * @brief Record that a schedule file's content changed.
+ *        Schedule_Data calls this after every save, staged or written through.
+ */
+void Schedule_Persist_NoteChanged(const char* pcPath);
+
+/**
+ * @brief Number of saves of a section since boot. Only ever increases;
+ *        read it before loading the section to tag what was loaded.
+ */
+uint32_t Schedule_Persist_GetGeneration(SCHEDULE_SECTION_E eSection);
@@ -1,21 +1,26 @@
 #include "Scheduler_API.h"
 #include "Schedule_Data.h"
+#include "Schedule_Persist.h"
+#include "Bell_Log.h"
 #include "TimeSync_API.h"
 #include "RingBell_API.h"
 #include "SPIFFS_API.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/time.h>
 
 static const char* TAG = "scheduler";
 
 #define SCHEDULER_TASK_STACK_SIZE   8192
 #define SCHEDULER_TASK_PRIORITY     2
 #define SCHEDULER_CHECK_INTERVAL_MS 1000
+#define SCHEDULER_FIRE_BATCH        4       /* bells fired (and logged) per pass */
 
 /* ------------------------------------------------------------------ */
 /* Resource struct                                                     */
@@ -29,10 +34,14 @@ typedef struct _SCHEDULER_RSC_T
     
     /* Runtime state */
     bool                bRunning;
+    bool                bSettingsLoaded;    /* last settings load read the file */
+    uint32_t            ulLastLoopMs;       /* task heartbeat; 32 bits so other tasks read it whole */
     int                 iLastFiredDay;       /* tm_yday of last reset */
     uint8_t             abFiredBitmap[SCHEDULE_MAX_BELLS / 8 + 1];
     DAY_TYPE_E          eCachedDayType;
     int                 iCachedDayYday;     /* tm_yday when day type was cached */
+    uint32_t            ulGeneration;       /* bumped on every reload */
+    uint32_t            aulLoadedGen[SCHEDULE_SECTION_COUNT]; /* persist generation of loaded data */
 } SCHEDULER_RSC_T;
 
 /* ------------------------------------------------------------------ */
@@ -348,6 +357,36 @@ scheduler_MarkBellFired(SCHEDULER_RSC_T* ptRsc, uint32_t ulIndex)
     ptRsc->abFiredBitmap[ulIndex / 8] |= (1 << (ulIndex % 8));
 }
 
+/** Bell log event for a fired bell, with its lateness against the scheduled minute */
+static void
+scheduler_MakeBellEvent(const struct tm* ptNow, const BELL_ENTRY_T* ptBell, BELL_EVENT_T* ptEvent)
+{
+    struct tm tScheduled = *ptNow;
+    tScheduled.tm_sec = 0;
+    time_t tScheduledEpoch = mktime(&tScheduled);
+
+    struct timeval tTv;
+    gettimeofday(&tTv, NULL);
+
+    *ptEvent = (BELL_EVENT_T){
+        .ulTimestamp   = (uint32_t)tTv.tv_sec,
+        .lLatenessMs   = (int32_t)((tTv.tv_sec - tScheduledEpoch) * 1000 + tTv.tv_usec / 1000),
+        .usDurationSec = ptBell->usDurationSec,
+        .usBellId      = ptBell->usId,  /* template / custom set bells have none */
+        .ucZone        = 0,
+        .eSource       = BELL_SOURCE_SCHEDULE,
+    };
+    strncpy(ptEvent->acLabel, ptBell->acLabel, BELL_LOG_LABEL_LEN - 1);
+}
+
+/** Scheduler_EditData callback: drop what expired; save only if something did */
+static esp_err_t
+scheduler_CleanupCalendar(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    (void)pvCtx;
+    return Schedule_Data_CleanupExpiredExceptions(ptData) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
 /* ------------------------------------------------------------------ */
 /* Background task                                                     */
 /* ------------------------------------------------------------------ */
@@ -356,11 +395,13 @@ static void
 scheduler_Task(void* pvArg)
 {
     SCHEDULER_RSC_T* ptRsc = (SCHEDULER_RSC_T*)pvArg;
+    ptRsc->ulLastLoopMs = (uint32_t)(esp_timer_get_time() / 1000);
     ptRsc->bRunning = true;
 
     while (true)
     {
         vTaskDelay(pdMS_TO_TICKS(SCHEDULER_CHECK_INTERVAL_MS));
+        ptRsc->ulLastLoopMs = (uint32_t)(esp_timer_get_time() / 1000);
 
         /* Skip if time not synced */
         if (!TimeSync_IsSynced()) continue;
@@ -374,6 +415,10 @@ scheduler_Task(void* pvArg)
         /* Defense-in-depth: reject obviously invalid system time */
         if (tNow.tm_year < 124) continue;  /* year < 2024 */
 
+        /* Logged after the mutex is given: an append may program or erase flash */
+        BELL_EVENT_T atFired[SCHEDULER_FIRE_BATCH];
+        uint32_t ulFired = 0;
+
         xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
 
         /* Reset fired bitmap at midnight */
@@ -383,11 +428,10 @@ scheduler_Task(void* pvArg)
             ptRsc->iLastFiredDay = tNow.tm_yday;
             ptRsc->iCachedDayYday = -1; /* force recalculation */
 
-            /* Clean up expired exceptions (date before today) */
+            /* Clean up expired exceptions (date before today) through the
+               same serialised path as every other calendar edit */
             xSemaphoreGive(ptRsc->hMutex);
-            Schedule_Data_CleanupExpiredExceptions();
-            /* Reload to pick up cleaned data */
-            Scheduler_ReloadSchedule(ptRsc);
+            Scheduler_EditData(ptRsc, SCHEDULE_SECTION_CALENDAR, scheduler_CleanupCalendar, NULL, NULL);
             continue; /* re-enter loop with fresh data */
         }
 
@@ -432,7 +476,8 @@ scheduler_Task(void* pvArg)
                 ulCount = scheduler_MergeBells(ptRsc->ptData, atMerged, SCHEDULE_MAX_BELLS);
             }
 
-            for (uint32_t i = 0; i < ulCount; i++)
+            /* A full batch leaves the rest for the next pass, a second later */
+            for (uint32_t i = 0; (i < ulCount) && (ulFired < SCHEDULER_FIRE_BATCH); i++)
             {
                 if (tNow.tm_hour == atMerged[i].ucHour &&
                     tNow.tm_min  == atMerged[i].ucMinute &&
@@ -444,12 +489,83 @@ scheduler_Task(void* pvArg)
 
                     RingBell_RunForDuration(atMerged[i].usDurationSec);
                     scheduler_MarkBellFired(ptRsc, i);
+                    scheduler_MakeBellEvent(&tNow, &atMerged[i], &atFired[ulFired++]);
                 }
             }
         }
 
         xSemaphoreGive(ptRsc->hMutex);
+
+        for (uint32_t i = 0; i < ulFired; i++)
+        {
+            Bell_Log_Append(&atFired[i]);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Section load / save (mutex held)                                    */
+/* ------------------------------------------------------------------ */
+
+/** Load one section into the model, tagged with the save count it reflects */
+static esp_err_t
+scheduler_LoadSection(SCHEDULER_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection)
+{
+    /* Sample before reading so a concurrent save can only make us reload again */
+    ptRsc->aulLoadedGen[eSection] = Schedule_Persist_GetGeneration(eSection);
+
+    switch (eSection)
+    {
+        case SCHEDULE_SECTION_SETTINGS:
+        {
+            esp_err_t err = Schedule_Data_LoadSettings(&ptRsc->ptData->tSettings);
+            ptRsc->bSettingsLoaded = (ESP_OK == err);
+            return err;
+        }
+        case SCHEDULE_SECTION_BELLS:
+            return Schedule_Data_LoadBells(&ptRsc->ptData->tFirstShift, &ptRsc->ptData->tSecondShift);
+        case SCHEDULE_SECTION_CALENDAR:
+            return Schedule_Data_LoadCalendar(ptRsc->ptData);
+        case SCHEDULE_SECTION_TEMPLATES:
+            return Schedule_Data_LoadTemplates(ptRsc->ptData);
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+}
+
+static esp_err_t
+scheduler_SaveSection(SCHEDULER_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection)
+{
+    switch (eSection)
+    {
+        case SCHEDULE_SECTION_SETTINGS:
+            return Schedule_Data_SaveSettings(&ptRsc->ptData->tSettings);
+        case SCHEDULE_SECTION_BELLS:
+            return Schedule_Data_SaveBells(&ptRsc->ptData->tFirstShift, &ptRsc->ptData->tSecondShift);
+        case SCHEDULE_SECTION_CALENDAR:
+            return Schedule_Data_SaveCalendar(ptRsc->ptData);
+        case SCHEDULE_SECTION_TEMPLATES:
+            return Schedule_Data_SaveTemplates(ptRsc->ptData);
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+}
+
+/** Reload every section and re-evaluate today (mutex held) */
+static void
+scheduler_ReloadAll(SCHEDULER_RSC_T* ptRsc)
+{
+    for (int i = 0; i < SCHEDULE_SECTION_COUNT; i++)
+    {
+        scheduler_LoadSection(ptRsc, (SCHEDULE_SECTION_E)i);
     }
+
+    /* Reset cached day type so it recalculates */
+    ptRsc->iCachedDayYday = -1;
+    /* Reset fired bitmap to re-evaluate today's bells */
+    memset(ptRsc->abFiredBitmap, 0, sizeof(ptRsc->abFiredBitmap));
+
+    ptRsc->ulGeneration++;
 }
 
 /* ------------------------------------------------------------------ */
@@ -482,14 +598,24 @@ Scheduler_Init(SCHEDULER_H* phScheduler)
     ptRsc->iLastFiredDay  = -1;
     ptRsc->iCachedDayYday = -1;
 
+    /* Start write-behind persistence before anything is saved */
+    esp_err_t err = Schedule_Persist_Init();
+    if (ESP_OK != err)
+    {
+        ESP_LOGW(TAG, "Write-behind unavailable (%s), saving directly", esp_err_to_name(err));
+    }
+
+    /* Bell history is optional: missing partition only disables it */
+    Bell_Log_Init();
+
     /* Create defaults if needed */
     Schedule_Data_CreateDefaults();
 
     /* Load schedule data */
-    Schedule_Data_LoadSettings(&ptRsc->ptData->tSettings);
-    Schedule_Data_LoadBells(&ptRsc->ptData->tFirstShift, &ptRsc->ptData->tSecondShift);
-    Schedule_Data_LoadCalendar(ptRsc->ptData);
-    Schedule_Data_LoadTemplates(ptRsc->ptData);
+    for (int i = 0; i < SCHEDULE_SECTION_COUNT; i++)
+    {
+        scheduler_LoadSection(ptRsc, (SCHEDULE_SECTION_E)i);
+    }
 
     ESP_LOGI(TAG, "Loaded schedule: 1st(%s,%"PRIu32") 2nd(%s,%"PRIu32") %"PRIu32" holidays, %"PRIu32" exceptions, %"PRIu32" templates",
              ptRsc->ptData->tFirstShift.bEnabled ? "on" : "off",
@@ -527,21 +653,41 @@ Scheduler_ReloadSchedule(SCHEDULER_H hScheduler)
     SCHEDULER_RSC_T* ptRsc = (SCHEDULER_RSC_T*)hScheduler;
 
     xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    scheduler_ReloadAll(ptRsc);
+    uint32_t ulGeneration = ptRsc->ulGeneration;
+    xSemaphoreGive(ptRsc->hMutex);
 
-    Schedule_Data_LoadSettings(&ptRsc->ptData->tSettings);
-    Schedule_Data_LoadBells(&ptRsc->ptData->tFirstShift, &ptRsc->ptData->tSecondShift);
-    Schedule_Data_LoadCalendar(ptRsc->ptData);
-    Schedule_Data_LoadTemplates(ptRsc->ptData);
+    ESP_LOGI(TAG, "Schedule reloaded (generation %"PRIu32")", ulGeneration);
+    return ESP_OK;
+}
 
-    /* Reset cached day type so it recalculates */
-    ptRsc->iCachedDayYday = -1;
-    /* Reset fired bitmap to re-evaluate today's bells */
-    memset(ptRsc->abFiredBitmap, 0, sizeof(ptRsc->abFiredBitmap));
+esp_err_t
+Scheduler_ResetToDefaults(SCHEDULER_H hScheduler)
+{
+    if (NULL == hScheduler) return ESP_ERR_INVALID_ARG;
+    SCHEDULER_RSC_T* ptRsc = (SCHEDULER_RSC_T*)hScheduler;
+
+    /* Held across the file work (rare, and short): no edit may be staged
+       between the flush and the remove, or land on the old files */
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+
+    /* Land any pending write-behind edits first so a late flush cannot
+     * resurrect the old schedule after the files are removed */
+    Schedule_Persist_Flush();
+
+    /* Remove current config files so CreateDefaults will regenerate them */
+    remove(SCHEDULE_FILE_SETTINGS);
+    remove(SCHEDULE_FILE_BELLS);
+    remove(SCHEDULE_FILE_CALENDAR);
+
+    esp_err_t err = Schedule_Data_CreateDefaults();
+    scheduler_ReloadAll(ptRsc);
+    uint32_t ulGeneration = ptRsc->ulGeneration;
 
     xSemaphoreGive(ptRsc->hMutex);
 
-    ESP_LOGI(TAG, "Schedule reloaded");
-    return ESP_OK;
+    ESP_LOGW(TAG, "Schedule reset to defaults (generation %"PRIu32")", ulGeneration);
+    return err;
 }
 
 esp_err_t
@@ -568,15 +714,93 @@ Scheduler_GetStatus(SCHEDULER_H hScheduler, SCHEDULER_STATUS_T* ptStatus)
 
     memset(ptStatus, 0, sizeof(SCHEDULER_STATUS_T));
     ptStatus->bRunning         = ptRsc->bRunning;
+    ptStatus->ulLoopAgeMs      = ptRsc->bRunning ? (uint32_t)(esp_timer_get_time() / 1000) - ptRsc->ulLastLoopMs : UINT32_MAX;
     ptStatus->bTimeSynced      = TimeSync_IsSynced();
     ptStatus->ulLastSyncAgeSec = TimeSync_GetLastSyncAgeSec();
 
     TimeSync_GetLocalTime(&ptStatus->tCurrentTime);
 
     xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    ptStatus->bSettingsLoaded = ptRsc->bSettingsLoaded;
     ptStatus->eDayType = ptRsc->eCachedDayType;
+    ptStatus->ulGeneration = ptRsc->ulGeneration;
     scheduler_FindNextBell(ptRsc, &ptStatus->tCurrentTime, &ptStatus->tNextBell);
     xSemaphoreGive(ptRsc->hMutex);
 
     return ESP_OK;
 }
+
+esp_err_t
+Scheduler_GetData(SCHEDULER_H hScheduler, SCHEDULE_DATA_T* ptData, uint32_t* pulGeneration)
+{
+    if ((NULL == hScheduler) || (NULL == ptData)) return ESP_ERR_INVALID_ARG;
+    SCHEDULER_RSC_T* ptRsc = (SCHEDULER_RSC_T*)hScheduler;
+
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    memcpy(ptData, ptRsc->ptData, sizeof(SCHEDULE_DATA_T));
+    if (NULL != pulGeneration) *pulGeneration = ptRsc->ulGeneration;
+    xSemaphoreGive(ptRsc->hMutex);
+
+    return ESP_OK;
+}
+
+esp_err_t
+Scheduler_EditData(SCHEDULER_H hScheduler, SCHEDULE_SECTION_E eSection,
+                   SCHEDULER_EDIT_FN pfnEdit, void* pvCtx, uint32_t* pulGeneration)
+{
+    if ((NULL == hScheduler) || (NULL == pfnEdit) || (eSection >= SCHEDULE_SECTION_COUNT))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    SCHEDULER_RSC_T* ptRsc = (SCHEDULER_RSC_T*)hScheduler;
+
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+
+    /* Saved by someone else but not reloaded yet: edit what is on flash */
+    if (Schedule_Persist_GetGeneration(eSection) != ptRsc->aulLoadedGen[eSection])
+    {
+        scheduler_LoadSection(ptRsc, eSection);
+    }
+
+    /* Compare-and-save: the If-Match check of the REST API lands here */
+    esp_err_t err = ESP_OK;
+    if ((NULL != pulGeneration) && (SCHEDULER_GENERATION_ANY != *pulGeneration)
+        && (*pulGeneration != Schedule_Persist_GetGeneration(eSection)))
+    {
+        err = ESP_ERR_INVALID_VERSION;
+    }
+    else
+    {
+        err = pfnEdit(ptRsc->ptData, pvCtx);
+    }
+
+    if (ESP_OK == err)
+    {
+        err = scheduler_SaveSection(ptRsc, eSection);
+        if (ESP_OK != err)
+        {
+            /* Keep memory in step with flash */
+            scheduler_LoadSection(ptRsc, eSection);
+        }
+        else
+        {
+            ptRsc->aulLoadedGen[eSection] = Schedule_Persist_GetGeneration(eSection);
+            ptRsc->iCachedDayYday = -1;
+            memset(ptRsc->abFiredBitmap, 0, sizeof(ptRsc->abFiredBitmap));
+            ptRsc->ulGeneration++;
+        }
+    }
+
+    uint32_t ulGeneration = ptRsc->ulGeneration;
+    if (NULL != pulGeneration)
+    {
+        *pulGeneration = Schedule_Persist_GetGeneration(eSection);
+    }
+    xSemaphoreGive(ptRsc->hMutex);
+
+    if (ESP_OK == err)
+    {
+        ESP_LOGI(TAG, "Schedule section %d edited (generation %"PRIu32")", eSection, ulGeneration);
+    }
+    return err;
+}
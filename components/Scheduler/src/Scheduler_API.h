@@ -2,6 +2,7 @@
 
 #include "esp_err.h"
 #include "Schedule_Data.h"
+#include "Schedule_Persist.h"
 #include <stdbool.h>
 #include <time.h>
 
@@ -28,11 +29,14 @@ typedef struct
 typedef struct
 {
     bool            bRunning;
+    uint32_t        ulLoopAgeMs;        /* since the task last woke; UINT32_MAX before it started */
+    bool            bSettingsLoaded;    /* settings came from storage, not built-in fallbacks */
     bool            bTimeSynced;
     uint32_t        ulLastSyncAgeSec;
     DAY_TYPE_E      eDayType;
     NEXT_BELL_INFO_T tNextBell;
     struct tm       tCurrentTime;
+    uint32_t        ulGeneration;       /* schedule reloads since boot */
 } SCHEDULER_STATUS_T;
 
 /**
@@ -41,10 +45,18 @@ typedef struct
 esp_err_t Scheduler_Init(SCHEDULER_H* phScheduler);
 
 /**
- * @brief Reload schedule data from SPIFFS (call after API writes).
+ * @brief Reload schedule data (call after API writes).
+ *        Staged write-behind edits take precedence over SPIFFS.
  */
 esp_err_t Scheduler_ReloadSchedule(SCHEDULER_H hScheduler);
 
+/**
+ * @brief Replace settings, bells and calendar with the flashed defaults
+ *        (templates are kept) and reload. Serialised with every other
+ *        schedule write.
+ */
+esp_err_t Scheduler_ResetToDefaults(SCHEDULER_H hScheduler);
+
 /**
  * @brief Get info about next scheduled bell.
  */
@@ -54,3 +66,37 @@ esp_err_t Scheduler_GetNextBell(SCHEDULER_H hScheduler, NEXT_BELL_INFO_T* ptInfo
  * @brief Get full scheduler status.
  */
 esp_err_t Scheduler_GetStatus(SCHEDULER_H hScheduler, SCHEDULER_STATUS_T* ptStatus);
+
+/**
+ * @brief Copy the in-memory schedule (settings, bells, calendar, templates)
+ *        and the generation it belongs to, taken together under the lock.
+ *        No filesystem access.
+ * @param pulGeneration  May be NULL.
+ */
+esp_err_t Scheduler_GetData(SCHEDULER_H hScheduler, SCHEDULE_DATA_T* ptData, uint32_t* pulGeneration);
+
+/**
+ * @brief Edit callback for Scheduler_EditData. Runs under the scheduler
+ *        lock; must not block or call back into the scheduler.
+ * @return ESP_OK to save the section, anything else to discard (the error
+ *         is returned to the caller; the model must be left unchanged).
+ */
+typedef esp_err_t (*SCHEDULER_EDIT_FN)(SCHEDULE_DATA_T* ptData, void* pvCtx);
+
+/* *pulGeneration for Scheduler_EditData: edit whatever is current */
+#define SCHEDULER_GENERATION_ANY    UINT32_MAX
+
+/**
+ * @brief Apply an edit to one section of the in-memory schedule and save
+ *        just that section. Replaces the save + Scheduler_ReloadSchedule
+ *        round trip for small edits.
+ * @param pulGeneration  May be NULL. In: the section's save count
+ *        (Schedule_Persist_GetGeneration) the edit is based on, or
+ *        SCHEDULER_GENERATION_ANY. It is compared under the same lock as the
+ *        save, so of two edits based on one generation only the first is
+ *        saved. Out: the section's save count after the call.
+ * @return ESP_ERR_INVALID_VERSION if the section was saved since that
+ *         generation (nothing is edited).
+ */
+esp_err_t Scheduler_EditData(SCHEDULER_H hScheduler, SCHEDULE_SECTION_E eSection,
+                             SCHEDULER_EDIT_FN pfnEdit, void* pvCtx, uint32_t* pulGeneration);
@@ -1,5 +1,5 @@
 #include "TimeSync_API.h"
-#include "NVS_API.h"
+#include "NVS_Config.h"
 #include "SPIFFS_API.h"
 #include "cJSON.h"
 #include "esp_sntp.h"
@@ -86,18 +86,16 @@ timeSync_IpEventHandler(void* pvArg, esp_event_base_t tEventBase,
 static void
 timeSync_ApplyStoredTimezone(void)
 {
-    nvs_handle_t hNvs;
     char acTz[TIMESYNC_TZ_MAX_LEN] = { 0 };
 
     /* --- Try NVS first --- */
-    if (NVS_Open(TIMESYNC_NVS_NAMESPACE, NVS_READONLY, &hNvs) == ESP_OK)
+    if (NVS_Config_GetStr(TIMESYNC_NVS_NAMESPACE, TIMESYNC_NVS_KEY_TZ, acTz, sizeof(acTz)) == ESP_OK)
     {
-        size_t ulLen = sizeof(acTz);
-        if (NVS_ReadString(hNvs, TIMESYNC_NVS_KEY_TZ, acTz, &ulLen) == ESP_OK)
-        {
-            ESP_LOGI(TAG, "Loaded timezone from NVS: %s", acTz);
-        }
-        NVS_Close(hNvs);
+        ESP_LOGI(TAG, "Loaded timezone from NVS: %s", acTz);
+    }
+    else
+    {
+        acTz[0] = '\0';
     }
 
     /* --- SPIFFS fallback (covers erase-flash scenario) --- */
@@ -187,18 +185,8 @@ TimeSync_SetTimezone(const char* pcTzPosix)
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Persist to NVS */
-    nvs_handle_t hNvs;
-    esp_err_t espRslt = NVS_Open(TIMESYNC_NVS_NAMESPACE, NVS_READWRITE, &hNvs);
-    if (ESP_OK == espRslt)
-    {
-        espRslt = NVS_WriteString(hNvs, TIMESYNC_NVS_KEY_TZ, pcTzPosix);
-        if (ESP_OK == espRslt)
-        {
-            espRslt = NVS_Commit(hNvs);
-        }
-        NVS_Close(hNvs);
-    }
+    /* Persist to NVS (batched by the config store) */
+    esp_err_t espRslt = NVS_Config_SetStr(TIMESYNC_NVS_NAMESPACE, TIMESYNC_NVS_KEY_TZ, pcTzPosix);
 
     /* Apply immediately */
     setenv("TZ", pcTzPosix, 1);
@@ -216,14 +204,8 @@ TimeSync_GetTimezone(char* pcOutBuf, size_t ulBufLen)
         return ESP_ERR_INVALID_ARG;
     }
 
-    nvs_handle_t hNvs;
-    esp_err_t espRslt = NVS_Open(TIMESYNC_NVS_NAMESPACE, NVS_READONLY, &hNvs);
-    if (ESP_OK == espRslt)
-    {
-        size_t ulLen = ulBufLen;
-        espRslt = NVS_ReadString(hNvs, TIMESYNC_NVS_KEY_TZ, pcOutBuf, &ulLen);
-        NVS_Close(hNvs);
-    }
+    /* Served from the config store's RAM cache after the first read */
+    esp_err_t espRslt = NVS_Config_GetStr(TIMESYNC_NVS_NAMESPACE, TIMESYNC_NVS_KEY_TZ, pcOutBuf, ulBufLen);
 
     if (espRslt != ESP_OK)
     {
@@ -2,6 +2,7 @@
 /* ts_bell_service.c — Bell state, panic, test ring                    */
 /* ================================================================== */
 #include "TouchScreen_Services.h"
+#include "Bell_Log.h"
 #include "esp_log.h"
 
 static const char *TAG = "TS_BELL";
@@ -29,7 +30,12 @@ esp_err_t
 TS_Bell_SetPanic(bool bEnable)
 {
     ESP_LOGI(TAG, "Setting panic mode: %s", bEnable ? "ON" : "OFF");
-    return RingBell_SetPanic(bEnable);
+    esp_err_t err = RingBell_SetPanic(bEnable);
+    if ((ESP_OK == err) && bEnable)
+    {
+        Bell_Log_Record(BELL_SOURCE_PANIC, 0);
+    }
+    return err;
 }
 
 esp_err_t
@@ -52,5 +58,10 @@ TS_Bell_TestRing(uint32_t ulDurationSec)
     }
 
     ESP_LOGI(TAG, "Test ring for %lu seconds", (unsigned long)ulDurationSec);
-    return RingBell_RunForDuration(ulDurationSec);
+    esp_err_t err = RingBell_RunForDuration(ulDurationSec);
+    if (ESP_OK == err)
+    {
+        Bell_Log_Record(BELL_SOURCE_UI, (uint16_t)ulDurationSec);
+    }
+    return err;
 }
@@ -2,7 +2,7 @@
 /* ts_pin_service.c — PIN validation, storage (NVS), lockout logic     */
 /* ================================================================== */
 #include "TouchScreen_Services.h"
-#include "NVS_API.h"
+#include "NVS_Config.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 
@@ -47,37 +47,18 @@ pin_is_valid_format(const char *pcPin)
 static esp_err_t
 pin_nvs_read(char *pcBuf, size_t ulBufLen)
 {
-    nvs_handle_t hNvs;
-    esp_err_t err = NVS_Open(PIN_NVS_NAMESPACE, NVS_READWRITE, &hNvs);
-    if (ESP_OK != err)
-    {
-        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
-        return err;
-    }
-
-    size_t usLen = ulBufLen;
-    err = NVS_ReadString(hNvs, PIN_NVS_KEY, pcBuf, &usLen);
-    NVS_Close(hNvs);
-    return err;
+    /* Cached by the config store — every keypad validation hits this */
+    return NVS_Config_GetStr(PIN_NVS_NAMESPACE, PIN_NVS_KEY, pcBuf, ulBufLen);
 }
 
 static esp_err_t
 pin_nvs_write(const char *pcPin)
 {
-    nvs_handle_t hNvs;
-    esp_err_t err = NVS_Open(PIN_NVS_NAMESPACE, NVS_READWRITE, &hNvs);
+    esp_err_t err = NVS_Config_SetStr(PIN_NVS_NAMESPACE, PIN_NVS_KEY, pcPin);
     if (ESP_OK != err)
     {
-        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
-        return err;
-    }
-
-    err = NVS_WriteString(hNvs, PIN_NVS_KEY, pcPin);
-    if (ESP_OK == err)
-    {
-        err = NVS_Commit(hNvs);
+        ESP_LOGE(TAG, "PIN write failed: %s", esp_err_to_name(err));
     }
-    NVS_Close(hNvs);
     return err;
 }
 
@@ -164,15 +145,11 @@ TS_Pin_Set(const char *pcNewPin)
     esp_err_t err = pin_nvs_write(pcNewPin);
     if (ESP_OK == err)
     {
-        /* Mark PIN as explicitly configured by user */
-        nvs_handle_t hNvs;
-        if (NVS_Open(PIN_NVS_NAMESPACE, NVS_READWRITE, &hNvs) == ESP_OK)
-        {
-            uint8_t ucSet = 1;
-            NVS_Write(hNvs, PIN_NVS_KEY_SET, &ucSet, sizeof(ucSet));
-            NVS_Commit(hNvs);
-            NVS_Close(hNvs);
-        }
+        /* Mark PIN as explicitly configured by user; both keys go to
+         * flash in one commit */
+        uint8_t ucSet = 1;
+        NVS_Config_SetBlob(PIN_NVS_NAMESPACE, PIN_NVS_KEY_SET, &ucSet, sizeof(ucSet));
+        err = NVS_Config_Flush();
         ESP_LOGI(TAG, "PIN updated (%d digits)", (int)strlen(pcNewPin));
     }
     return err;
@@ -203,17 +180,9 @@ TS_Pin_GetLength(void)
 bool
 TS_Pin_IsConfigured(void)
 {
-    nvs_handle_t hNvs;
-    esp_err_t err = NVS_Open(PIN_NVS_NAMESPACE, NVS_READONLY, &hNvs);
-    if (ESP_OK != err)
-    {
-        return false;
-    }
-
     uint8_t ucSet = 0;
     size_t ulLen = sizeof(ucSet);
-    err = NVS_Read(hNvs, PIN_NVS_KEY_SET, &ucSet, &ulLen);
-    NVS_Close(hNvs);
+    esp_err_t err = NVS_Config_GetBlob(PIN_NVS_NAMESPACE, PIN_NVS_KEY_SET, &ucSet, &ulLen);
 
     return (ESP_OK == err && ucSet != 0);
 }
@@ -221,19 +190,10 @@ TS_Pin_IsConfigured(void)
 esp_err_t
 TS_Pin_Reset(void)
 {
-    nvs_handle_t hNvs;
-    esp_err_t err = NVS_Open(PIN_NVS_NAMESPACE, NVS_READWRITE, &hNvs);
-    if (ESP_OK != err)
-    {
-        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
-        return err;
-    }
-
     /* Erase both keys — PIN and the "set" flag */
-    nvs_erase_key(hNvs, PIN_NVS_KEY);
-    nvs_erase_key(hNvs, PIN_NVS_KEY_SET);
-    err = NVS_Commit(hNvs);
-    NVS_Close(hNvs);
+    NVS_Config_EraseKey(PIN_NVS_NAMESPACE, PIN_NVS_KEY);
+    NVS_Config_EraseKey(PIN_NVS_NAMESPACE, PIN_NVS_KEY_SET);
+    esp_err_t err = NVS_Config_Flush();
 
     if (ESP_OK == err)
     {
@@ -5,6 +5,7 @@
 #include "Schedule_Data.h"
 #include "esp_log.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -126,120 +127,136 @@ TS_Schedule_GetSettings(SCHEDULE_SETTINGS_T *ptSettings)
 /* ------------------------------------------------------------------ */
 /* Day Override: add/replace a temporary single-day exception           */
 /* ------------------------------------------------------------------ */
-esp_err_t
-TS_Schedule_SetTodayOverride(EXCEPTION_ACTION_E eAction)
-{
-    if (s_hScheduler == NULL)
-    {
-        ESP_LOGE(TAG, "Schedule service not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
 
-    /* Only allow day-off or normal (day-on with default schedule) */
-    if (eAction != EXCEPTION_ACTION_DAY_OFF && eAction != EXCEPTION_ACTION_NORMAL)
-    {
-        ESP_LOGE(TAG, "Invalid override action: %d", eAction);
-        return ESP_ERR_INVALID_ARG;
-    }
+#define TS_OVERRIDE_LABEL   "Manual Override"
+
+/* Carried into the Scheduler_EditData callbacks below */
+typedef struct
+{
+    char               acToday[SCHEDULE_DATE_STR_LEN];
+    EXCEPTION_ACTION_E eAction;
+} TS_OVERRIDE_EDIT_T;
 
-    /* Get today's date string */
+static void
+todayDateStr(char *pcOut, size_t ulLen)
+{
     time_t now;
     time(&now);
     struct tm tm_now;
     localtime_r(&now, &tm_now);
-
-    char today_str[SCHEDULE_DATE_STR_LEN];
-    snprintf(today_str, sizeof(today_str), "%04d-%02d-%02d",
+    snprintf(pcOut, ulLen, "%04d-%02d-%02d",
              tm_now.tm_year + 1900, tm_now.tm_mon + 1, tm_now.tm_mday);
+}
 
-    ESP_LOGI(TAG, "Setting today override: date=%s action=%d", today_str, eAction);
-
-    /* Load current calendar data (heap-allocated due to large size) */
-    SCHEDULE_DATA_T *ptData = calloc(1, sizeof(SCHEDULE_DATA_T));
-    if (ptData == NULL)
-    {
-        ESP_LOGE(TAG, "Failed to allocate calendar buffer");
-        return ESP_ERR_NO_MEM;
-    }
-
-    esp_err_t err = Schedule_Data_LoadCalendar(ptData);
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Failed to load calendar: %s", esp_err_to_name(err));
-        free(ptData);
-        return err;
-    }
+/* Single-day exception for pcToday; bOverrideOnly also requires our label */
+static bool
+isTodayException(const EXCEPTION_ENTRY_T *pEx, const char *pcToday, bool bOverrideOnly)
+{
+    return (strcmp(pEx->acStartDate, pcToday) == 0)
+           && (pEx->acEndDate[0] == '\0' || strcmp(pEx->acEndDate, pcToday) == 0)
+           && (!bOverrideOnly || strcmp(pEx->acLabel, TS_OVERRIDE_LABEL) == 0);
+}
 
-    /* Scan existing exceptions: remove any matching today's date */
+/* Remove matching exceptions, returns how many */
+static uint32_t
+removeTodayExceptions(SCHEDULE_DATA_T *ptData, const char *pcToday, bool bOverrideOnly)
+{
+    uint32_t ulRemoved = 0;
     for (uint32_t i = 0; i < ptData->ulExceptionCount; /* no increment */)
     {
-        EXCEPTION_ENTRY_T *pEx = &ptData->atExceptions[i];
-
-        /* Match single-day exceptions for today */
-        bool is_today = (strcmp(pEx->acStartDate, today_str) == 0)
-                        && (pEx->acEndDate[0] == '\0'
-                            || strcmp(pEx->acEndDate, today_str) == 0);
-
-        if (is_today)
+        if (isTodayException(&ptData->atExceptions[i], pcToday, bOverrideOnly))
         {
-            ESP_LOGI(TAG, "Removing existing today exception at index %" PRIu32, i);
-            /* Shift remaining entries down */
-            uint32_t remaining = ptData->ulExceptionCount - i - 1;
-            if (remaining > 0)
-            {
-                memmove(&ptData->atExceptions[i],
-                        &ptData->atExceptions[i + 1],
-                        remaining * sizeof(EXCEPTION_ENTRY_T));
-            }
+            ESP_LOGI(TAG, "Removing today exception at index %" PRIu32, i);
+            /* Shift remaining entries down; check the one that slid into this slot */
+            memmove(&ptData->atExceptions[i], &ptData->atExceptions[i + 1],
+                    (ptData->ulExceptionCount - i - 1) * sizeof(EXCEPTION_ENTRY_T));
             ptData->ulExceptionCount--;
-            /* Don't increment i — check the entry that slid into this slot */
+            ulRemoved++;
         }
         else
         {
             i++;
         }
     }
+    return ulRemoved;
+}
+
+/* Runs under the scheduler lock on its in-memory calendar */
+static esp_err_t
+editSetOverride(SCHEDULE_DATA_T *ptData, void *pvCtx)
+{
+    const TS_OVERRIDE_EDIT_T *ptEdit = (const TS_OVERRIDE_EDIT_T *)pvCtx;
 
-    /* Append new single-day exception for today */
-    if (ptData->ulExceptionCount >= SCHEDULE_MAX_EXCEPTIONS)
+    /* Check for room first: on error the model must be left as it was */
+    uint32_t ulToday = 0;
+    for (uint32_t i = 0; i < ptData->ulExceptionCount; i++)
     {
-        ESP_LOGE(TAG, "Exception list full (%d), cannot add override",
-                 SCHEDULE_MAX_EXCEPTIONS);
-        free(ptData);
+        if (isTodayException(&ptData->atExceptions[i], ptEdit->acToday, false)) ulToday++;
+    }
+    if (ptData->ulExceptionCount - ulToday >= SCHEDULE_MAX_EXCEPTIONS)
+    {
+        ESP_LOGE(TAG, "Exception list full (%d), cannot add override", SCHEDULE_MAX_EXCEPTIONS);
         return ESP_ERR_NO_MEM;
     }
 
+    removeTodayExceptions(ptData, ptEdit->acToday, false);
+
     EXCEPTION_ENTRY_T *pNew = &ptData->atExceptions[ptData->ulExceptionCount];
     memset(pNew, 0, sizeof(EXCEPTION_ENTRY_T));
-    strncpy(pNew->acStartDate, today_str, SCHEDULE_DATE_STR_LEN - 1);
+    strncpy(pNew->acStartDate, ptEdit->acToday, SCHEDULE_DATE_STR_LEN - 1);
     pNew->acEndDate[0] = '\0';   /* Single day */
-    strncpy(pNew->acLabel, "Manual Override", SCHEDULE_LABEL_MAX_LEN - 1);
-    pNew->eAction          = eAction;
+    strncpy(pNew->acLabel, TS_OVERRIDE_LABEL, SCHEDULE_LABEL_MAX_LEN - 1);
+    pNew->eAction          = ptEdit->eAction;
     pNew->iTimeOffsetMin   = 0;
     pNew->ucTemplateIdx    = 0;
     pNew->ucCustomBellsIdx = 0xFF;
     ptData->ulExceptionCount++;
 
-    /* Save back to SPIFFS */
-    err = Schedule_Data_SaveCalendar(ptData);
-    free(ptData);
+    /* The new entry gets the next free id */
+    Schedule_Data_AssignCalendarIds(ptData);
+    return ESP_OK;
+}
 
-    if (err != ESP_OK)
+static esp_err_t
+editCancelOverride(SCHEDULE_DATA_T *ptData, void *pvCtx)
+{
+    const TS_OVERRIDE_EDIT_T *ptEdit = (const TS_OVERRIDE_EDIT_T *)pvCtx;
+    return (removeTodayExceptions(ptData, ptEdit->acToday, true) > 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t
+TS_Schedule_SetTodayOverride(EXCEPTION_ACTION_E eAction)
+{
+    if (s_hScheduler == NULL)
     {
-        ESP_LOGE(TAG, "Failed to save calendar: %s", esp_err_to_name(err));
-        return err;
+        ESP_LOGE(TAG, "Schedule service not initialized");
+        return ESP_ERR_INVALID_STATE;
     }
 
-    /* Reload schedule so the change takes effect immediately */
-    err = Scheduler_ReloadSchedule(s_hScheduler);
+    /* Only allow day-off or normal (day-on with default schedule) */
+    if (eAction != EXCEPTION_ACTION_DAY_OFF && eAction != EXCEPTION_ACTION_NORMAL)
+    {
+        ESP_LOGE(TAG, "Invalid override action: %d", eAction);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    TS_OVERRIDE_EDIT_T tEdit = { .eAction = eAction };
+    todayDateStr(tEdit.acToday, sizeof(tEdit.acToday));
+
+    ESP_LOGI(TAG, "Setting today override: date=%s action=%d", tEdit.acToday, eAction);
+
+    /* Edited and saved under the scheduler lock, like the web API's edits,
+       and in effect at once (no reload needed) */
+    esp_err_t err = Scheduler_EditData(s_hScheduler, SCHEDULE_SECTION_CALENDAR,
+                                       editSetOverride, &tEdit, NULL);
     if (err != ESP_OK)
     {
-        ESP_LOGW(TAG, "Schedule reload failed: %s (override saved but not active yet)",
-                 esp_err_to_name(err));
+        ESP_LOGE(TAG, "Failed to save override: %s", esp_err_to_name(err));
+        return err;
     }
 
     ESP_LOGI(TAG, "Today override set successfully: %s = %s",
-             today_str, (eAction == EXCEPTION_ACTION_DAY_OFF) ? "Day Off" : "Day On");
+             tEdit.acToday, (eAction == EXCEPTION_ACTION_DAY_OFF) ? "Day Off" : "Day On");
     return ESP_OK;
 }
 
@@ -255,82 +272,24 @@ TS_Schedule_CancelTodayOverride(void)
         return ESP_ERR_INVALID_STATE;
     }
 
-    time_t now;
-    time(&now);
-    struct tm tm_now;
-    localtime_r(&now, &tm_now);
-
-    char today_str[SCHEDULE_DATE_STR_LEN];
-    snprintf(today_str, sizeof(today_str), "%04d-%02d-%02d",
-             tm_now.tm_year + 1900, tm_now.tm_mon + 1, tm_now.tm_mday);
-
-    ESP_LOGI(TAG, "Cancelling today override for %s", today_str);
-
-    SCHEDULE_DATA_T *ptData = calloc(1, sizeof(SCHEDULE_DATA_T));
-    if (ptData == NULL)
-    {
-        ESP_LOGE(TAG, "Failed to allocate calendar buffer");
-        return ESP_ERR_NO_MEM;
-    }
-
-    esp_err_t err = Schedule_Data_LoadCalendar(ptData);
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "Failed to load calendar: %s", esp_err_to_name(err));
-        free(ptData);
-        return err;
-    }
-
-    bool bFound = false;
-    for (uint32_t i = 0; i < ptData->ulExceptionCount; /* no increment */)
-    {
-        EXCEPTION_ENTRY_T *pEx = &ptData->atExceptions[i];
-        bool is_today = (strcmp(pEx->acStartDate, today_str) == 0)
-                        && (pEx->acEndDate[0] == '\0'
-                            || strcmp(pEx->acEndDate, today_str) == 0)
-                        && (strcmp(pEx->acLabel, "Manual Override") == 0);
+    TS_OVERRIDE_EDIT_T tEdit = { 0 };
+    todayDateStr(tEdit.acToday, sizeof(tEdit.acToday));
 
-        if (is_today)
-        {
-            ESP_LOGI(TAG, "Removing manual override at index %" PRIu32, i);
-            uint32_t remaining = ptData->ulExceptionCount - i - 1;
-            if (remaining > 0)
-            {
-                memmove(&ptData->atExceptions[i],
-                        &ptData->atExceptions[i + 1],
-                        remaining * sizeof(EXCEPTION_ENTRY_T));
-            }
-            ptData->ulExceptionCount--;
-            bFound = true;
-        }
-        else
-        {
-            i++;
-        }
-    }
+    ESP_LOGI(TAG, "Cancelling today override for %s", tEdit.acToday);
 
-    if (!bFound)
+    esp_err_t err = Scheduler_EditData(s_hScheduler, SCHEDULE_SECTION_CALENDAR,
+                                       editCancelOverride, &tEdit, NULL);
+    if (err == ESP_ERR_NOT_FOUND)
     {
         ESP_LOGI(TAG, "No manual override found for today");
-        free(ptData);
         return ESP_OK;
     }
-
-    err = Schedule_Data_SaveCalendar(ptData);
-    free(ptData);
-
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "Failed to save calendar: %s", esp_err_to_name(err));
         return err;
     }
 
-    err = Scheduler_ReloadSchedule(s_hScheduler);
-    if (err != ESP_OK)
-    {
-        ESP_LOGW(TAG, "Schedule reload failed: %s", esp_err_to_name(err));
-    }
-
     ESP_LOGI(TAG, "Today manual override cancelled");
     return ESP_OK;
 }
@@ -353,24 +312,14 @@ TS_Schedule_GetTodayOverrideAction(void)
         return -1;
     }
 
-    time_t now;
-    time(&now);
-    struct tm tm_now;
-    localtime_r(&now, &tm_now);
-
     char today_str[SCHEDULE_DATE_STR_LEN];
-    snprintf(today_str, sizeof(today_str), "%04d-%02d-%02d",
-             tm_now.tm_year + 1900, tm_now.tm_mon + 1, tm_now.tm_mday);
+    todayDateStr(today_str, sizeof(today_str));
 
     int result = -1;
     for (uint32_t i = 0; i < ptData->ulExceptionCount; i++)
     {
         EXCEPTION_ENTRY_T *pEx = &ptData->atExceptions[i];
-        bool is_today = (strcmp(pEx->acStartDate, today_str) == 0)
-                        && (pEx->acEndDate[0] == '\0'
-                            || strcmp(pEx->acEndDate, today_str) == 0)
-                        && (strcmp(pEx->acLabel, "Manual Override") == 0);
-        if (is_today)
+        if (isTodayException(pEx, today_str, true))
         {
             result = (int)pEx->eAction;
             break;
@@ -8,6 +8,8 @@
 #include "../../components/card/card_component.h"
 #include "TouchScreen_Services.h"
 #include "TouchScreen_UI_Manager.h"
+#include "FlashStats_API.h"
+#include "SPIFFS_API.h"
 #include "esp_log.h"
 #include "esp_chip_info.h"
 #include "esp_mac.h"
@@ -16,6 +18,7 @@
 #include "lvgl.h"
 #include "bsp/esp-bsp.h"
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -26,6 +29,7 @@ static const char *TAG = "INFO_SCREEN";
 /* ------------------------------------------------------------------ */
 #define CONTENT_WIDTH   (480 - 2 * UI_PAD_SCREEN)   /* 456px */
 #define QR_CODE_SIZE    150
+#define STORAGE_REFRESH_TICKS   30      /* info_refresh_all runs at 1 Hz */
 
 /* ------------------------------------------------------------------ */
 /* Module state — LVGL objects                                         */
@@ -38,6 +42,11 @@ static lv_obj_t *s_idf_version_lbl = NULL;
 static lv_obj_t *s_chip_info_lbl   = NULL;
 static lv_obj_t *s_mac_addr_lbl    = NULL;
 
+/* Storage card */
+static lv_obj_t *s_storage_used_lbl = NULL;
+static lv_obj_t *s_flash_writes_lbl = NULL;
+static uint32_t  s_storage_refresh_ticks = 0;
+
 /* Web access card */
 static lv_obj_t *s_qr_code         = NULL;
 static lv_obj_t *s_web_url_lbl     = NULL;
@@ -123,6 +132,19 @@ static void info_create_device_card(lv_obj_t *parent)
     create_info_row(card, LV_SYMBOL_GPS,      ui_str(STR_MAC_ADDRESS),      &s_mac_addr_lbl);
 }
 
+static void info_create_storage_card(lv_obj_t *parent)
+{
+    lv_obj_t *card = card_component_create_with_title(
+                         parent, CONTENT_WIDTH, LV_SIZE_CONTENT, ui_str(STR_STORAGE));
+    lv_obj_set_style_pad_all(card, 12, 0);
+    lv_obj_set_flex_flow(card, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_pad_row(card, 6, 0);
+
+    create_info_row(card, LV_SYMBOL_DRIVE,    ui_str(STR_STORAGE_USED),     &s_storage_used_lbl);
+    create_divider(card);
+    create_info_row(card, LV_SYMBOL_EDIT,     ui_str(STR_FLASH_WRITES),     &s_flash_writes_lbl);
+}
+
 static void info_create_web_access_card(lv_obj_t *parent)
 {
     lv_obj_t *card = card_component_create_with_title(
@@ -207,6 +229,35 @@ static void info_refresh_all(void)
         }
     }
 
+    /* Storage usage: LittleFS computes usage by walking the tree, so only
+     * every STORAGE_REFRESH_TICKS updates rather than every second */
+    if (s_storage_used_lbl && (s_storage_refresh_ticks++ % STORAGE_REFRESH_TICKS) == 0) {
+        size_t total = 0, used = 0;
+        if (SPIFFS_GetInfo(&total, &used) == ESP_OK && total > 0) {
+            char buf[48];
+            snprintf(buf, sizeof(buf), "%u / %u KB (%s)",
+                     (unsigned)(used / 1024), (unsigned)(total / 1024),
+                     SPIFFS_GetBackendName());
+            lv_label_set_text(s_storage_used_lbl, buf);
+        } else {
+            lv_label_set_text(s_storage_used_lbl, ui_str(STR_UNKNOWN));
+        }
+    }
+
+    /* Flash writes since boot, all areas, with the extrapolated daily rate */
+    if (s_flash_writes_lbl) {
+        FLASH_STATS_SUMMARY_T summary;
+        FlashStats_GetSummary(&summary);
+        uint64_t boot_bytes = 0;
+        for (int i = 0; i < FLASH_STATS_AREA_COUNT; i++) {
+            boot_bytes += summary.atArea[i].ullBootBytes;
+        }
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%" PRIu64 " KB, ~%" PRIu64 " KB/day",
+                 boot_bytes / 1024, FlashStats_BootRatePerDay(boot_bytes) / 1024);
+        lv_label_set_text(s_flash_writes_lbl, buf);
+    }
+
     /* Web access: QR code + URL */
     char ip[16] = {0};
     bool has_ip = (TS_WiFi_GetIpAddress(ip, sizeof(ip)) == ESP_OK && ip[0]);
@@ -265,6 +316,7 @@ void touchscreen_info_screen_create(void)
     lv_obj_set_scrollbar_mode(s_content, LV_SCROLLBAR_MODE_AUTO);
 
     info_create_device_card(s_content);
+    info_create_storage_card(s_content);
     info_create_web_access_card(s_content);
 
     bsp_display_unlock();
@@ -284,6 +336,9 @@ void touchscreen_info_screen_destroy(void)
     s_idf_version_lbl = NULL;
     s_chip_info_lbl   = NULL;
     s_mac_addr_lbl    = NULL;
+    s_storage_used_lbl = NULL;
+    s_flash_writes_lbl = NULL;
+    s_storage_refresh_ticks = 0;
     s_qr_code         = NULL;
     s_web_url_lbl     = NULL;
     s_last_ip[0]      = '\0';
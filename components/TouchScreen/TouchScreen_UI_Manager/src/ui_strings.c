@@ -115,6 +115,9 @@ static const char * const s_strings_bg[STR_COUNT] = {
     [STR_ABOUT]               = "Относно",
     [STR_ABOUT_DESC]          = "Автоматичен училищен звънец с\nтъчскрийн и уеб управление.",
     [STR_BOARD_INFO]          = "Платка: Waveshare ESP32-S3-Touch-LCD-4",
+    [STR_STORAGE]             = "Памет",
+    [STR_STORAGE_USED]        = "Използвано хранилище",
+    [STR_FLASH_WRITES]        = "Записи във флаш (от старта)",
 
     /* PIN entry */
     [STR_ENTER_PIN]           = "Въведете ПИН",
@@ -273,6 +276,9 @@ static const char * const s_strings_en[STR_COUNT] = {
     [STR_ABOUT]               = "About",
     [STR_ABOUT_DESC]          = "Automated school bell system with\ntouchscreen control and web management.",
     [STR_BOARD_INFO]          = "Board: Waveshare ESP32-S3-Touch-LCD-4",
+    [STR_STORAGE]             = "Storage",
+    [STR_STORAGE_USED]        = "Storage Used",
+    [STR_FLASH_WRITES]        = "Flash Writes (since boot)",
 
     /* PIN entry */
     [STR_ENTER_PIN]           = "Enter PIN",
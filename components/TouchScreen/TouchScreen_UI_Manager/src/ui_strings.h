@@ -121,6 +121,9 @@ typedef enum {
     STR_ABOUT,
     STR_ABOUT_DESC,
     STR_BOARD_INFO,
+    STR_STORAGE,
+    STR_STORAGE_USED,
+    STR_FLASH_WRITES,
 
     /* --- PIN entry --- */
     STR_ENTER_PIN,
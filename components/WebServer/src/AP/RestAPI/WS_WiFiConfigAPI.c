@@ -10,10 +10,12 @@
 #include "esp_system.h"
 #include "cJSON.h"
 #include "Auth/WS_Auth.h"
+#include "WS_Body.h"
 
 static const char* TAG = "WIFI_CONFIG_API";
 
 #define WIFI_SCAN_MAX_AP    20
+#define WIFI_CONFIG_BODY_MAX 384
 
 typedef struct _WIFI_CONFIG_API_RSC_T
 {
@@ -127,7 +129,7 @@ wifiConfigApi_GetStatus(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, pcJson);
 
     cJSON_Delete(ptRoot);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
 
     return ESP_OK;
 }
@@ -149,21 +151,11 @@ wifiConfigApi_PostConfig(httpd_req_t* ptReq)
 
     (void)ptReq->user_ctx; /* WiFi_Manager_SaveCredentials is a free function */
 
-    char acBuf[384];
-    int  iLen = httpd_req_recv(ptReq, acBuf, sizeof(acBuf) - 1);
-
-    if (iLen <= 0)
-    {
-        httpd_resp_send_err(ptReq, HTTPD_400_BAD_REQUEST, "Empty body");
-        return ESP_FAIL;
-    }
-    acBuf[iLen] = '\0';
-
-    cJSON* ptRoot = cJSON_Parse(acBuf);
-    if (NULL == ptRoot)
+    cJSON*    ptRoot  = NULL;
+    esp_err_t espBody = WS_Body_ReadJson(ptReq, WIFI_CONFIG_BODY_MAX, &ptRoot);
+    if (ESP_OK != espBody)
     {
-        httpd_resp_send_err(ptReq, HTTPD_400_BAD_REQUEST, "Invalid JSON");
-        return ESP_FAIL;
+        return WS_Body_SendError(ptReq, espBody);
     }
 
     cJSON* ptSsid = cJSON_GetObjectItem(ptRoot, "ssid");
@@ -198,7 +190,7 @@ wifiConfigApi_PostConfig(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, pcJson);
 
     cJSON_Delete(ptResp);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
 
     /* Small delay so the HTTP response is flushed before the reset */
     vTaskDelay(pdMS_TO_TICKS(500));
@@ -289,7 +281,7 @@ wifiConfigApi_GetNetworks(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, pcJson);
 
     cJSON_Delete(ptRoot);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
 
     return ESP_OK;
 }
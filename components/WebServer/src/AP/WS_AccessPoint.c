@@ -9,7 +9,7 @@ static const char* TAG = "WS_ACCESS_POINT";
 static WIFI_CONFIG_API_H s_hWifiConfigApi = NULL;
 
 esp_err_t
-WS_AccessPoint_Start(WIFI_MANAGER_H hWiFiManager)
+WS_AccessPoint_Start(WIFI_MANAGER_H hWiFiManager, httpd_handle_t* phServer)
 {
     esp_err_t espRslt = ESP_OK;
 
@@ -48,6 +48,7 @@ WS_AccessPoint_Start(WIFI_MANAGER_H hWiFiManager)
 
     if (ESP_OK == espRslt)
     {
+        *phServer = hHttpServer;
         ESP_LOGI(TAG, "AP HTTP server started (React + WiFi Config API)");
     }
 
@@ -1,5 +1,6 @@
 #include "esp_err.h"
+#include "esp_http_server.h"
 #include "WiFi_Manager_API.h"
 
 esp_err_t
-WS_AccessPoint_Start(WIFI_MANAGER_H hWiFiManager);
\ No newline at end of file
+WS_AccessPoint_Start(WIFI_MANAGER_H hWiFiManager, httpd_handle_t* phServer);
\ No newline at end of file
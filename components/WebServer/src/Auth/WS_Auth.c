@@ -1,5 +1,9 @@
 #include "WS_Auth.h"
+#include "WS_AuthSession.h"
 #include "WS_AuthStore.h"
+#include "WS_Arena.h"
+#include "WS_Async.h"
+#include "WS_Https.h"
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
@@ -8,63 +12,24 @@
 
 #include "esp_log.h"
 #include "esp_system.h"
-#include "esp_random.h"
 #include "cJSON.h"
 #include "sdkconfig.h"
 
 static const char *TAG = "AUTH";
 
 // ---------------------- Config ----------------------
-#define SESSION_TOKEN_LEN 32
-#define USER_MAX_LEN  31
-#define ROLE_MAX_LEN  15
-
-#define MAX_SESSIONS 1
-#define SESSION_MAX_AGE_S 3600
-
 static const char* ROLE_SERVICE = "service";
 static const char* ROLE_CLIENT  = "client";
 
-// login rate limit: 5 attempts / 60 seconds (global, simple)
-#define LOGIN_WINDOW_SEC 60
-#define LOGIN_MAX_ATTEMPTS 5
+#define COOKIE_HDR_MAX 256
 
 // ---------------------- State ----------------------
-typedef struct {
-    char token[SESSION_TOKEN_LEN + 1];
-    char username[USER_MAX_LEN + 1];
-    char role[ROLE_MAX_LEN + 1];
-    time_t created_at;
-    bool active;
-} session_t;
-
-static session_t g_sessions[MAX_SESSIONS] = {0};
-
-static int  g_login_count = 0;
-static long g_login_window_start = 0;
+// Session a guard accepted, per task: the user/role pointers it hands out
+// point in here and stay put until that task's next check, which a
+// handler (on the server task or an async worker) never outlives
+static __thread auth_session_t t_session;
 
 // ---------------------- Helpers ----------------------
-static esp_err_t rate_limited(void)
-{
-    long now = (long)time(NULL);
-    if ((0 == g_login_window_start) || ((now - g_login_window_start) >= LOGIN_WINDOW_SEC)) {
-        g_login_window_start = now;
-        g_login_count = 0;
-    }
-
-    g_login_count++;
-    return (g_login_count > LOGIN_MAX_ATTEMPTS) ? ESP_FAIL : ESP_OK;
-}
-
-static void make_token(char out[SESSION_TOKEN_LEN + 1])
-{
-    for (size_t i = 0; i < SESSION_TOKEN_LEN; i += 2) {
-        uint8_t byte = (uint8_t)(esp_random() & 0xFF);
-        sprintf(out + i, "%02x", byte);
-    }
-    out[SESSION_TOKEN_LEN] = '\0';
-}
-
 void auth_set_security_headers(httpd_req_t* req)
 {
     httpd_resp_set_hdr(req, "X-Content-Type-Options", "nosniff");
@@ -99,10 +64,9 @@ static esp_err_t read_body(httpd_req_t* req, char* out, size_t outlen)
     return ESP_OK;
 }
 
-static const char* extract_session_cookie(httpd_req_t* req)
+static const char* extract_session_cookie(httpd_req_t* req, char* cookie_buf, size_t len)
 {
-    static char cookie_buf[256];
-    if (httpd_req_get_hdr_value_str(req, "Cookie", cookie_buf, sizeof(cookie_buf)) != ESP_OK) {
+    if (httpd_req_get_hdr_value_str(req, "Cookie", cookie_buf, len) != ESP_OK) {
         return NULL;
     }
 
@@ -124,78 +88,9 @@ static const char* extract_session_cookie(httpd_req_t* req)
     return start;
 }
 
-static session_t* find_session(const char* token)
-{
-    if (NULL == token) {
-        return NULL;
-    }
-
-    time_t now = time(NULL);
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (g_sessions[i].active && (strcmp(g_sessions[i].token, token) == 0)) {
-            if (difftime(now, g_sessions[i].created_at) > SESSION_MAX_AGE_S) {
-                g_sessions[i].active = false;
-                return NULL;
-            }
-            return &g_sessions[i];
-        }
-    }
-
-    return NULL;
-}
-
-static session_t* allocate_session_slot(void)
-{
-    int oldest_idx = 0;
-    time_t oldest = g_sessions[0].created_at;
-
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (!g_sessions[i].active) {
-            return &g_sessions[i];
-        }
-
-        if (i == 0 || g_sessions[i].created_at < oldest) {
-            oldest = g_sessions[i].created_at;
-            oldest_idx = i;
-        }
-    }
-
-    return &g_sessions[oldest_idx];
-}
-
-static void invalidate_session_by_token(const char* token)
-{
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (g_sessions[i].active && (strcmp(g_sessions[i].token, token) == 0)) {
-            g_sessions[i].active = false;
-            g_sessions[i].token[0] = '\0';
-            g_sessions[i].username[0] = '\0';
-            g_sessions[i].role[0] = '\0';
-            g_sessions[i].created_at = 0;
-            return;
-        }
-    }
-}
-
 int auth_active_session_count(void)
 {
-    int count = 0;
-    time_t now = time(NULL);
-
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (!g_sessions[i].active) {
-            continue;
-        }
-
-        if (difftime(now, g_sessions[i].created_at) > SESSION_MAX_AGE_S) {
-            g_sessions[i].active = false;
-            continue;
-        }
-
-        count++;
-    }
-
-    return count;
+    return auth_session_count();
 }
 
 bool auth_csrf_check(httpd_req_t* req)
@@ -224,24 +119,44 @@ bool auth_csrf_check(httpd_req_t* req)
 // ---------------------- Public guard ----------------------
 esp_err_t auth_require_session(httpd_req_t* req, const char** out_user, const char** out_role)
 {
-    const char* token = extract_session_cookie(req);
+    char cookie[COOKIE_HDR_MAX];
+    const char* token = extract_session_cookie(req, cookie, sizeof(cookie));
     if (NULL == token) {
         (void)send_json(req, "401 Unauthorized", "{\"error\":\"Authentication required\"}");
         return ESP_FAIL;
     }
 
-    session_t* s = find_session(token);
-    if (NULL == s) {
+    if (!auth_session_find(token, true, &t_session)) {
         (void)send_json(req, "401 Unauthorized", "{\"error\":\"Invalid or expired session\"}");
         return ESP_FAIL;
     }
 
-    if (NULL != out_user) { *out_user = s->username; }
-    if (NULL != out_role) { *out_role = s->role; }
+    if (NULL != out_user) { *out_user = t_session.username; }
+    if (NULL != out_role) { *out_role = t_session.role; }
+
+    return ESP_OK;
+}
+
+esp_err_t auth_get_session(httpd_req_t* req, char* out_token,
+                           const char** out_user, const char** out_role)
+{
+    char cookie[COOKIE_HDR_MAX];
+    if (!auth_session_find(extract_session_cookie(req, cookie, sizeof(cookie)), true, &t_session)) {
+        return ESP_FAIL;
+    }
+
+    if (NULL != out_token) { memcpy(out_token, t_session.token, AUTH_SESSION_TOKEN_LEN + 1); }
+    if (NULL != out_user)  { *out_user = t_session.username; }
+    if (NULL != out_role)  { *out_role = t_session.role; }
 
     return ESP_OK;
 }
 
+bool auth_session_is_valid(const char* token)
+{
+    return (NULL != token) && (token[0] != '\0') && auth_session_find(token, false, NULL);
+}
+
 // ---------------------- Endpoints ----------------------
 static esp_err_t api_login(httpd_req_t* req)
 {
@@ -249,10 +164,6 @@ static esp_err_t api_login(httpd_req_t* req)
         return ESP_OK;
     }
 
-    if (ESP_OK != rate_limited()) {
-        return send_json(req, "429 Too Many Requests", "{\"error\":\"Too many login attempts. Try again later.\"}");
-    }
-
     char body[512];
     if (ESP_OK != read_body(req, body, sizeof(body))) {
         return send_json(req, "400 Bad Request", "{\"error\":\"invalid body\"}");
@@ -286,18 +197,17 @@ static esp_err_t api_login(httpd_req_t* req)
         return send_json(req, "401 Unauthorized", "{\"error\":\"invalid credentials\"}");
     }
 
-    session_t* session = allocate_session_slot();
-    memset(session, 0, sizeof(*session));
-    make_token(session->token);
-    snprintf(session->username, sizeof(session->username), "%s", username);
-    snprintf(session->role, sizeof(session->role), "%s", role);
-    session->created_at = time(NULL);
-    session->active = true;
+    uint32_t role_limit = (role == ROLE_SERVICE) ? CONFIG_WS_AUTH_MAX_SERVICE_SESSIONS
+                                                 : CONFIG_WS_AUTH_MAX_CLIENT_SESSIONS;
+    auth_session_t session;
+    auth_session_create(username, role, role_limit, &session);
 
     cJSON_Delete(root);
 
     char cookie[128];
-    snprintf(cookie, sizeof(cookie), "session=%s; HttpOnly; SameSite=Strict; Path=/", session->token);
+    // Secure only over TLS: a browser would never send it back over plain HTTP
+    snprintf(cookie, sizeof(cookie), "session=%s; HttpOnly; SameSite=Strict; Path=/%s",
+             session.token, WS_Https_IsSecure(req) ? "; Secure" : "");
     httpd_resp_set_hdr(req, "Set-Cookie", cookie);
 
     char resp[256];
@@ -306,7 +216,7 @@ static esp_err_t api_login(httpd_req_t* req)
           "\"user\":{\"username\":\"%s\",\"role\":\"%s\"},"
           "\"message\":\"Login successful\""
         "}",
-        session->username, session->role);
+        session.username, session.role);
 
     return send_json(req, "200 OK", resp);
 }
@@ -323,9 +233,10 @@ static esp_err_t api_logout(httpd_req_t* req)
         return ESP_OK;
     }
 
-    const char* token = extract_session_cookie(req);
+    char cookie[COOKIE_HDR_MAX];
+    const char* token = extract_session_cookie(req, cookie, sizeof(cookie));
     if (NULL != token) {
-        invalidate_session_by_token(token);
+        auth_session_remove(token);
     }
 
     httpd_resp_set_hdr(req, "Set-Cookie", "session=; HttpOnly; SameSite=Strict; Path=/; Max-Age=0");
@@ -357,6 +268,10 @@ static esp_err_t api_validate(httpd_req_t* req)
 
 esp_err_t auth_init(void)
 {
+    esp_err_t err = auth_session_init();
+    if (ESP_OK != err) {
+        return err;
+    }
     return auth_store_init();
 }
 
@@ -383,13 +298,7 @@ esp_err_t auth_require_role(httpd_req_t* req, const char* required_role,
 
 void auth_invalidate_all_sessions(void)
 {
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        g_sessions[i].active = false;
-        g_sessions[i].token[0] = '\0';
-        g_sessions[i].username[0] = '\0';
-        g_sessions[i].role[0] = '\0';
-        g_sessions[i].created_at = 0;
-    }
+    auth_session_remove_all();
     ESP_LOGI(TAG, "All sessions invalidated");
 }
 
@@ -415,14 +324,16 @@ esp_err_t auth_register_endpoints(httpd_handle_t server)
 
     esp_err_t espErr = ESP_OK;
 
-    espErr = httpd_register_uri_handler(server, &login);
+    // Password hashing takes ~CONFIG_WS_AUTH_KDF_TARGET_MS per account tried.
+    // The wrapper also applies the per-client login budget (WS_RateLimit)
+    espErr = WS_Async_RegisterUri(server, &login);
     if(ESP_OK == espErr) 
     {
-       espErr = httpd_register_uri_handler(server, &logout);
+       espErr = WS_Arena_RegisterUri(server, &logout);
 
        if(ESP_OK == espErr)
        {
-           espErr = httpd_register_uri_handler(server, &validate);
+           espErr = WS_Arena_RegisterUri(server, &validate);
        }
     }
 
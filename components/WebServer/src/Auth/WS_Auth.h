@@ -1,6 +1,8 @@
 #include "esp_http_server.h"
 #include <stdbool.h>
 
+#define AUTH_SESSION_TOKEN_LEN 32
+
 /**
  * @brief  Initialise the authentication subsystem.
  *         Provisions the service account hash on first boot.
@@ -14,6 +16,27 @@ void auth_set_security_headers(httpd_req_t* req);
 bool auth_csrf_check(httpd_req_t* req);
 esp_err_t auth_require_session(httpd_req_t* req, const char** out_user, const char** out_role);
 
+/**
+ * @brief  Same check as auth_require_session, but never sends a response.
+ *         For WebSocket upgrades: the handshake has already been answered
+ *         when the handler runs, so a 401 body cannot be sent.
+ *
+ * @param[in]  req        Upgrade request carrying the session cookie
+ * @param[out] out_token  Receives the session token (AUTH_SESSION_TOKEN_LEN + 1
+ *                        bytes) for later auth_session_is_valid() checks
+ * @param[out] out_user   Receives username (may be NULL)
+ * @param[out] out_role   Receives role (may be NULL)
+ * @return ESP_OK if the cookie names a live session
+ */
+esp_err_t auth_get_session(httpd_req_t* req, char* out_token,
+                           const char** out_user, const char** out_role);
+
+/**
+ * @brief  True while the session for token exists and has not expired or
+ *         been logged out. Lets long-lived connections re-check per command.
+ */
+bool auth_session_is_valid(const char* token);
+
 /**
  * @brief  Require a specific role for the current session.
  *         Returns 403 if the session role doesn't match required_role.
@@ -27,6 +50,10 @@ esp_err_t auth_require_session(httpd_req_t* req, const char** out_user, const ch
 esp_err_t auth_require_role(httpd_req_t* req, const char* required_role,
                             const char** out_user, const char** out_role);
 
+/**
+ * @brief  Number of live sessions. Expired sessions are dropped first.
+ *         Detailed counters: auth_session_get_stats() in WS_AuthSession.h.
+ */
 int auth_active_session_count(void);
 
 /**
@@ -4,8 +4,13 @@
 #include <stdio.h>
 
 #include "esp_random.h"
+#include "esp_timer.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/constant_time.h"
+#include "mbedtls/platform_util.h"
+
+#define SHA256_BLOCK_LEN        64
+#define CALIBRATE_START_ITER    1024
 
 /* ------------------------------------------------------------------ */
 /* Internal helpers                                                    */
@@ -41,9 +46,9 @@ static esp_err_t hex_to_bin(const char* hex, uint8_t* bin_out, size_t bin_len)
 }
 
 /**
- * @brief Compute SHA-256( salt || password ) into hash_out.
+ * @brief Compute SHA-256( salt || password ) into hash_out (legacy format).
  */
-static esp_err_t compute_hash(const uint8_t salt[AUTH_CRYPTO_SALT_LEN],
+static esp_err_t compute_legacy_hash(const uint8_t salt[AUTH_CRYPTO_SALT_LEN],
                                const char* password,
                                uint8_t hash_out[AUTH_CRYPTO_HASH_LEN])
 {
@@ -66,37 +71,170 @@ cleanup:
     return (0 == ret) ? ESP_OK : ESP_FAIL;
 }
 
+/**
+ * @brief Finish one HMAC half: resume from a keyed pad state, absorb 32 bytes.
+ */
+static int hmac_half(mbedtls_sha256_context* work, const mbedtls_sha256_context* pad_state,
+                     uint8_t inout[AUTH_CRYPTO_HASH_LEN])
+{
+    mbedtls_sha256_clone(work, pad_state);
+    int ret = mbedtls_sha256_update(work, inout, AUTH_CRYPTO_HASH_LEN);
+    if (0 == ret) {
+        ret = mbedtls_sha256_finish(work, inout);
+    }
+    return ret;
+}
+
+/**
+ * @brief PBKDF2-HMAC-SHA256 (RFC 8018), one 32-byte output block.
+ *
+ * The ipad/opad blocks are hashed once and their states cloned for every
+ * iteration, so an iteration costs two SHA-256 compressions on the
+ * hardware engine instead of four.
+ */
+static esp_err_t compute_pbkdf2(const uint8_t* salt, size_t salt_len,
+                                const char* password, uint32_t iterations,
+                                uint8_t hash_out[AUTH_CRYPTO_HASH_LEN])
+{
+    uint8_t key[SHA256_BLOCK_LEN] = {0};
+    uint8_t pad[SHA256_BLOCK_LEN];
+    uint8_t u[AUTH_CRYPTO_HASH_LEN];
+    const uint8_t block_index[4] = { 0, 0, 0, 1 };
+    size_t pw_len = strlen(password);
+    int ret = 0;
+
+    mbedtls_sha256_context inner, outer, work;
+    mbedtls_sha256_init(&inner);
+    mbedtls_sha256_init(&outer);
+    mbedtls_sha256_init(&work);
+
+    /* HMAC keys longer than a block are hashed first */
+    if (pw_len > SHA256_BLOCK_LEN) {
+        ret = mbedtls_sha256((const uint8_t*)password, pw_len, key, 0);
+        if (0 != ret) { goto cleanup; }
+    } else {
+        memcpy(key, password, pw_len);
+    }
+
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) { pad[i] = key[i] ^ 0x36; }
+    ret = mbedtls_sha256_starts(&inner, 0);
+    if (0 == ret) { ret = mbedtls_sha256_update(&inner, pad, SHA256_BLOCK_LEN); }
+    if (0 != ret) { goto cleanup; }
+
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) { pad[i] = key[i] ^ 0x5c; }
+    ret = mbedtls_sha256_starts(&outer, 0);
+    if (0 == ret) { ret = mbedtls_sha256_update(&outer, pad, SHA256_BLOCK_LEN); }
+    if (0 != ret) { goto cleanup; }
+
+    /* U1 = HMAC( password, salt || INT(1) ) */
+    mbedtls_sha256_clone(&work, &inner);
+    ret = mbedtls_sha256_update(&work, salt, salt_len);
+    if (0 == ret) { ret = mbedtls_sha256_update(&work, block_index, sizeof(block_index)); }
+    if (0 == ret) { ret = mbedtls_sha256_finish(&work, u); }
+    if (0 == ret) { ret = hmac_half(&work, &outer, u); }
+    if (0 != ret) { goto cleanup; }
+    memcpy(hash_out, u, AUTH_CRYPTO_HASH_LEN);
+
+    /* Un = HMAC( password, Un-1 ), result = U1 ^ U2 ^ ... */
+    for (uint32_t n = 1; n < iterations; n++) {
+        ret = hmac_half(&work, &inner, u);
+        if (0 == ret) { ret = hmac_half(&work, &outer, u); }
+        if (0 != ret) { goto cleanup; }
+
+        for (size_t i = 0; i < AUTH_CRYPTO_HASH_LEN; i++) { hash_out[i] ^= u[i]; }
+    }
+
+cleanup:
+    mbedtls_platform_zeroize(key, sizeof(key));
+    mbedtls_platform_zeroize(pad, sizeof(pad));
+    mbedtls_platform_zeroize(u, sizeof(u));
+    mbedtls_sha256_free(&inner);
+    mbedtls_sha256_free(&outer);
+    mbedtls_sha256_free(&work);
+    return (0 == ret) ? ESP_OK : ESP_FAIL;
+}
+
 /* ------------------------------------------------------------------ */
 /* Public API                                                          */
 /* ------------------------------------------------------------------ */
 
-esp_err_t auth_crypto_hash_password(const char* password,
+esp_err_t auth_crypto_hash_password(const char* password, uint32_t iterations,
                                     uint8_t salt_out[AUTH_CRYPTO_SALT_LEN],
                                     uint8_t hash_out[AUTH_CRYPTO_HASH_LEN])
 {
-    if ((NULL == password) || (NULL == salt_out) || (NULL == hash_out)) {
+    if ((NULL == password) || (NULL == salt_out) || (NULL == hash_out)
+        || (iterations < AUTH_CRYPTO_MIN_ITERATIONS) || (iterations > AUTH_CRYPTO_MAX_ITERATIONS)) {
         return ESP_ERR_INVALID_ARG;
     }
 
     esp_fill_random(salt_out, AUTH_CRYPTO_SALT_LEN);
-    return compute_hash(salt_out, password, hash_out);
+    return compute_pbkdf2(salt_out, AUTH_CRYPTO_SALT_LEN, password, iterations, hash_out);
+}
+
+esp_err_t auth_crypto_pbkdf2(const char* password, const uint8_t* salt, size_t salt_len,
+                             uint32_t iterations, uint8_t hash_out[AUTH_CRYPTO_HASH_LEN])
+{
+    if ((NULL == password) || ((NULL == salt) && (salt_len > 0)) || (NULL == hash_out)
+        || (iterations < 1) || (iterations > AUTH_CRYPTO_MAX_ITERATIONS)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return compute_pbkdf2(salt, salt_len, password, iterations, hash_out);
 }
 
 bool auth_crypto_verify_password(const char* password,
                                  const uint8_t salt[AUTH_CRYPTO_SALT_LEN],
+                                 uint32_t iterations,
                                  const uint8_t hash[AUTH_CRYPTO_HASH_LEN])
 {
-    if ((NULL == password) || (NULL == salt) || (NULL == hash)) {
+    if ((NULL == password) || (NULL == salt) || (NULL == hash)
+        || (iterations > AUTH_CRYPTO_MAX_ITERATIONS)) {
         return false;
     }
 
     uint8_t computed[AUTH_CRYPTO_HASH_LEN];
-    if (ESP_OK != compute_hash(salt, password, computed)) {
+    esp_err_t err = (AUTH_CRYPTO_LEGACY_ITERATIONS == iterations)
+                  ? compute_legacy_hash(salt, password, computed)
+                  : compute_pbkdf2(salt, AUTH_CRYPTO_SALT_LEN, password, iterations, computed);
+    if (ESP_OK != err) {
         return false;
     }
 
     /* Constant-time comparison — prevents timing attacks */
-    return (0 == mbedtls_ct_memcmp(computed, hash, AUTH_CRYPTO_HASH_LEN));
+    bool match = (0 == mbedtls_ct_memcmp(computed, hash, AUTH_CRYPTO_HASH_LEN));
+    mbedtls_platform_zeroize(computed, sizeof(computed));
+    return match;
+}
+
+uint32_t auth_crypto_calibrate(uint32_t target_ms)
+{
+    const uint8_t salt[AUTH_CRYPTO_SALT_LEN] = {0};
+    uint8_t out[AUTH_CRYPTO_HASH_LEN];
+    const int64_t target_us = (int64_t)target_ms * 1000;
+
+    /* Double the run until it is long enough to time: a short one is
+     * dominated by set-up and timer resolution */
+    uint32_t iterations = CALIBRATE_START_ITER;
+    int64_t elapsed_us = 0;
+    while (true) {
+        int64_t start_us = esp_timer_get_time();
+        if (ESP_OK != compute_pbkdf2(salt, sizeof(salt), "calibrate", iterations, out)) {
+            return AUTH_CRYPTO_MIN_ITERATIONS;
+        }
+        elapsed_us = esp_timer_get_time() - start_us;
+
+        if ((elapsed_us >= target_us / 8) || (iterations >= AUTH_CRYPTO_MAX_ITERATIONS / 2)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    uint64_t scaled = (elapsed_us > 0) ? ((uint64_t)iterations * (uint64_t)target_us) / (uint64_t)elapsed_us
+                                       : AUTH_CRYPTO_MAX_ITERATIONS;
+    scaled &= ~(uint64_t)1023;
+    if (scaled < AUTH_CRYPTO_MIN_ITERATIONS) { scaled = AUTH_CRYPTO_MIN_ITERATIONS; }
+    if (scaled > AUTH_CRYPTO_MAX_ITERATIONS) { scaled = AUTH_CRYPTO_MAX_ITERATIONS; }
+    return (uint32_t)scaled;
 }
 
 void auth_crypto_salt_to_hex(const uint8_t salt[AUTH_CRYPTO_SALT_LEN],
@@ -10,31 +10,58 @@
 #define AUTH_CRYPTO_SALT_HEX  (AUTH_CRYPTO_SALT_LEN * 2 + 1)  /* 33 bytes incl. NUL */
 #define AUTH_CRYPTO_HASH_HEX  (AUTH_CRYPTO_HASH_LEN * 2 + 1)  /* 65 bytes incl. NUL */
 
+/* Stored iteration count 0: a hash from before PBKDF2, SHA-256( salt || password ) */
+#define AUTH_CRYPTO_LEGACY_ITERATIONS   0
+#define AUTH_CRYPTO_MIN_ITERATIONS      4096
+#define AUTH_CRYPTO_MAX_ITERATIONS      1000000
+
 /**
  * @brief  Hash a password with a freshly generated random salt.
- *         Computes SHA-256( salt || password ).
+ *         Computes PBKDF2-HMAC-SHA256( password, salt, iterations ), 32 bytes.
  *
- * @param[in]  password   NUL-terminated plaintext password
- * @param[out] salt_out   16-byte random salt
- * @param[out] hash_out   32-byte SHA-256 digest
+ * @param[in]  password    NUL-terminated plaintext password
+ * @param[in]  iterations  PBKDF2 cost, see auth_crypto_calibrate()
+ * @param[out] salt_out    16-byte random salt
+ * @param[out] hash_out    32-byte derived key
  * @return ESP_OK on success
  */
-esp_err_t auth_crypto_hash_password(const char* password,
+esp_err_t auth_crypto_hash_password(const char* password, uint32_t iterations,
                                     uint8_t salt_out[AUTH_CRYPTO_SALT_LEN],
                                     uint8_t hash_out[AUTH_CRYPTO_HASH_LEN]);
 
+/**
+ * @brief  PBKDF2-HMAC-SHA256 with a given salt of any length, first 32-byte
+ *         block. The derivation auth_crypto_hash_password() uses, exposed
+ *         for known-answer tests (RFC 7914 §11).
+ *
+ * @param[in]  iterations  1..AUTH_CRYPTO_MAX_ITERATIONS
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad input
+ */
+esp_err_t auth_crypto_pbkdf2(const char* password, const uint8_t* salt, size_t salt_len,
+                             uint32_t iterations, uint8_t hash_out[AUTH_CRYPTO_HASH_LEN]);
+
 /**
  * @brief  Verify a password against a stored salt + hash (constant-time).
  *
- * @param[in] password  NUL-terminated plaintext password
- * @param[in] salt      16-byte salt that was used when hashing
- * @param[in] hash      32-byte expected SHA-256 digest
+ * @param[in] password    NUL-terminated plaintext password
+ * @param[in] salt        16-byte salt that was used when hashing
+ * @param[in] iterations  Stored PBKDF2 cost, or AUTH_CRYPTO_LEGACY_ITERATIONS
+ * @param[in] hash        32-byte expected digest
  * @return true if the password matches
  */
 bool auth_crypto_verify_password(const char* password,
                                  const uint8_t salt[AUTH_CRYPTO_SALT_LEN],
+                                 uint32_t iterations,
                                  const uint8_t hash[AUTH_CRYPTO_HASH_LEN]);
 
+/**
+ * @brief  Time a short PBKDF2 run on this chip and scale it to target_ms.
+ *         The result is rounded to a multiple of 1024 and clamped to
+ *         AUTH_CRYPTO_MIN_ITERATIONS..AUTH_CRYPTO_MAX_ITERATIONS.
+ *         Takes at most about target_ms / 2.
+ */
+uint32_t auth_crypto_calibrate(uint32_t target_ms);
+
 /**
  * @brief  Convert a binary salt to a hex string (32 chars + NUL).
  */
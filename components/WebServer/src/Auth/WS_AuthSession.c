@@ -0,0 +1,263 @@
+#include "WS_AuthSession.h"
+
+#include <string.h>
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "AUTH_SESSION";
+
+#define SESSION_CAPACITY    CONFIG_WS_AUTH_MAX_SESSIONS
+#define SESSION_BUCKETS     64      // power of two, at least 2x the largest capacity
+#define SESSION_IDLE_S      ((uint32_t)CONFIG_WS_AUTH_SESSION_IDLE_MIN * 60)
+#define SESSION_MAX_AGE_S   ((uint32_t)CONFIG_WS_AUTH_SESSION_MAX_HOURS * 3600)
+#define NIL                 (-1)
+
+// Slots are chained per hash bucket and also kept on one LRU list
+// (head = most recently used). Free slots are simply !active.
+static auth_session_t       s_slots[SESSION_CAPACITY];
+static int16_t              s_buckets[SESSION_BUCKETS];
+static int16_t              s_lru_head = NIL;
+static int16_t              s_lru_tail = NIL;
+static auth_session_stats_t s_stats;
+static SemaphoreHandle_t    s_mutex    = NULL;
+static StaticSemaphore_t    s_mutex_buf;
+
+// ----------------------------------------------------------------
+// Helpers
+// ----------------------------------------------------------------
+static uint32_t now_s(void)
+{
+    // Monotonic: an SNTP step must not expire (or revive) sessions
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+static void lock(void)   { xSemaphoreTake(s_mutex, portMAX_DELAY); }
+static void unlock(void) { xSemaphoreGive(s_mutex); }
+
+// FNV-1a. Tokens are random, so the bucket spread does not depend on it
+static uint32_t bucket_of(const char* token)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < AUTH_SESSION_TOKEN_LEN; i++) {
+        h = (h ^ (uint8_t)token[i]) * 16777619u;
+    }
+    return h & (SESSION_BUCKETS - 1);
+}
+
+static bool token_equal(const char* a, const char* b)
+{
+    uint8_t diff = 0;
+    for (int i = 0; i < AUTH_SESSION_TOKEN_LEN; i++) {
+        diff |= (uint8_t)a[i] ^ (uint8_t)b[i];
+    }
+    return 0 == diff;
+}
+
+static void make_token(char out[AUTH_SESSION_TOKEN_LEN + 1])
+{
+    for (size_t i = 0; i < AUTH_SESSION_TOKEN_LEN; i += 2) {
+        uint8_t byte = (uint8_t)(esp_random() & 0xFF);
+        sprintf(out + i, "%02x", byte);
+    }
+    out[AUTH_SESSION_TOKEN_LEN] = '\0';
+}
+
+static void lru_unlink(int16_t i)
+{
+    auth_session_t* s = &s_slots[i];
+    if (NIL != s->lru_prev) s_slots[s->lru_prev].lru_next = s->lru_next; else s_lru_head = s->lru_next;
+    if (NIL != s->lru_next) s_slots[s->lru_next].lru_prev = s->lru_prev; else s_lru_tail = s->lru_prev;
+    s->lru_prev = NIL;
+    s->lru_next = NIL;
+}
+
+static void lru_push_front(int16_t i)
+{
+    auth_session_t* s = &s_slots[i];
+    s->lru_prev = NIL;
+    s->lru_next = s_lru_head;
+    if (NIL != s_lru_head) s_slots[s_lru_head].lru_prev = i; else s_lru_tail = i;
+    s_lru_head = i;
+}
+
+static void hash_unlink(int16_t i)
+{
+    int16_t* link = &s_buckets[bucket_of(s_slots[i].token)];
+    while (NIL != *link) {
+        if (*link == i) {
+            *link = s_slots[i].hash_next;
+            break;
+        }
+        link = &s_slots[*link].hash_next;
+    }
+    s_slots[i].hash_next = NIL;
+}
+
+static void release(int16_t i, uint32_t* counter)
+{
+    hash_unlink(i);
+    lru_unlink(i);
+    memset(&s_slots[i], 0, sizeof(s_slots[i]));
+    s_stats.active--;
+    (*counter)++;
+}
+
+static bool is_expired(const auth_session_t* s, uint32_t now)
+{
+    return ((now - s->last_used_s) > SESSION_IDLE_S) || ((now - s->created_s) > SESSION_MAX_AGE_S);
+}
+
+// Expired sessions are dropped lazily on lookup; this catches the rest
+static void sweep_expired(void)
+{
+    uint32_t now = now_s();
+    for (int16_t i = 0; i < SESSION_CAPACITY; i++) {
+        if (s_slots[i].active && is_expired(&s_slots[i], now)) {
+            release(i, &s_stats.expired);
+        }
+    }
+}
+
+static int16_t find_locked(const char* token, bool touch)
+{
+    if ((NULL == token) || (strlen(token) != AUTH_SESSION_TOKEN_LEN)) {
+        return NIL;
+    }
+
+    for (int16_t i = s_buckets[bucket_of(token)]; NIL != i; i = s_slots[i].hash_next) {
+        if (!token_equal(s_slots[i].token, token)) continue;
+
+        uint32_t now = now_s();
+        if (is_expired(&s_slots[i], now)) {
+            release(i, &s_stats.expired);
+            return NIL;
+        }
+        if (touch) {
+            s_slots[i].last_used_s = now;
+            lru_unlink(i);
+            lru_push_front(i);
+        }
+        return i;
+    }
+    return NIL;
+}
+
+// ----------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------
+esp_err_t auth_session_init(void)
+{
+    if (NULL != s_mutex) return ESP_OK;
+
+    for (int i = 0; i < SESSION_BUCKETS; i++) s_buckets[i] = NIL;
+    s_stats.capacity = SESSION_CAPACITY;
+    s_mutex = xSemaphoreCreateMutexStatic(&s_mutex_buf);
+    return (NULL != s_mutex) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void auth_session_create(const char* username, const char* role, uint32_t role_limit, auth_session_t* out)
+{
+    lock();
+    sweep_expired();
+
+    // Role full: walk from the LRU end to that role's oldest session
+    uint32_t role_count = 0;
+    int16_t  role_lru   = NIL;
+    for (int16_t i = s_lru_tail; NIL != i; i = s_slots[i].lru_prev) {
+        if (0 == strcmp(s_slots[i].role, role)) {
+            if (NIL == role_lru) role_lru = i;
+            role_count++;
+        }
+    }
+    if ((role_count >= role_limit) && (NIL != role_lru)) {
+        ESP_LOGI(TAG, "Role '%s' at its limit (%lu), evicting LRU session of %s",
+                 role, (unsigned long)role_limit, s_slots[role_lru].username);
+        release(role_lru, &s_stats.evicted_role);
+    }
+
+    int16_t slot = NIL;
+    for (int16_t i = 0; i < SESSION_CAPACITY; i++) {
+        if (!s_slots[i].active) {
+            slot = i;
+            break;
+        }
+    }
+    if (NIL == slot) {
+        slot = s_lru_tail;
+        ESP_LOGI(TAG, "Session store full, evicting LRU session of %s", s_slots[slot].username);
+        release(slot, &s_stats.evicted_lru);
+    }
+
+    auth_session_t* s = &s_slots[slot];
+    make_token(s->token);
+    snprintf(s->username, sizeof(s->username), "%s", username);
+    snprintf(s->role, sizeof(s->role), "%s", role);
+    s->created_s   = now_s();
+    s->last_used_s = s->created_s;
+    s->active      = true;
+
+    uint32_t b   = bucket_of(s->token);
+    s->hash_next = s_buckets[b];
+    s_buckets[b] = slot;
+    lru_push_front(slot);
+
+    s_stats.active++;
+    s_stats.created++;
+    *out = *s;
+    unlock();
+}
+
+bool auth_session_find(const char* token, bool touch, auth_session_t* out)
+{
+    lock();
+    int16_t i = find_locked(token, touch);
+    if ((NIL != i) && (NULL != out)) {
+        *out = s_slots[i];
+    }
+    unlock();
+    return NIL != i;
+}
+
+void auth_session_remove(const char* token)
+{
+    lock();
+    int16_t i = find_locked(token, false);
+    if (NIL != i) {
+        release(i, &s_stats.removed);
+    }
+    unlock();
+}
+
+void auth_session_remove_all(void)
+{
+    lock();
+    for (int16_t i = 0; i < SESSION_CAPACITY; i++) {
+        if (s_slots[i].active) {
+            release(i, &s_stats.removed);
+        }
+    }
+    unlock();
+}
+
+int auth_session_count(void)
+{
+    lock();
+    sweep_expired();
+    int count = (int)s_stats.active;
+    unlock();
+    return count;
+}
+
+void auth_session_get_stats(auth_session_stats_t* stats)
+{
+    lock();
+    sweep_expired();
+    *stats = s_stats;
+    unlock();
+}
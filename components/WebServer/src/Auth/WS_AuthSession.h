@@ -0,0 +1,73 @@
+#pragma once
+
+#include "esp_err.h"
+#include "WS_Auth.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AUTH_SESSION_USER_MAX       31
+#define AUTH_SESSION_ROLE_MAX       15
+
+/**
+ * A logged-in browser. Handlers run on the HTTP server task and on the
+ * async workers, so every call takes the store's mutex and hands back a
+ * copy; a session evicted meanwhile cannot change what the caller holds.
+ */
+typedef struct
+{
+    char     token[AUTH_SESSION_TOKEN_LEN + 1];
+    char     username[AUTH_SESSION_USER_MAX + 1];
+    char     role[AUTH_SESSION_ROLE_MAX + 1];
+    uint32_t created_s;         // monotonic seconds since boot
+    uint32_t last_used_s;
+
+    // Private — owned by WS_AuthSession.c
+    bool     active;
+    int16_t  hash_next;
+    int16_t  lru_prev;
+    int16_t  lru_next;
+} auth_session_t;
+
+typedef struct
+{
+    uint32_t capacity;
+    uint32_t active;
+    uint32_t created;
+    uint32_t evicted_lru;       // pushed out because every slot was taken
+    uint32_t evicted_role;      // pushed out by the per-role limit
+    uint32_t expired;           // idle or absolute lifetime reached
+    uint32_t removed;           // logout or invalidate-all
+} auth_session_stats_t;
+
+/**
+ * @brief Set up the store. Call once from auth_init(), before any handler runs.
+ */
+esp_err_t auth_session_init(void);
+
+/**
+ * @brief Create a session with a fresh random token. When the role already
+ *        holds role_limit sessions, its least recently used one is evicted;
+ *        when the store is full, the least recently used of all is.
+ * @param out  Receives a copy of the new session.
+ */
+void auth_session_create(const char* username, const char* role, uint32_t role_limit, auth_session_t* out);
+
+/**
+ * @brief Look a token up (constant-time compare) and drop it if expired.
+ * @param touch  true for user requests: restarts the idle timer and marks
+ *               the session most recently used. false for re-checks that
+ *               are not user activity (WebSocket pushes).
+ * @param out    Receives a copy of the session, may be NULL.
+ * @return true if the token names a live session.
+ */
+bool auth_session_find(const char* token, bool touch, auth_session_t* out);
+
+void auth_session_remove(const char* token);
+void auth_session_remove_all(void);
+
+/**
+ * @brief Number of live sessions (expired ones are dropped first).
+ */
+int auth_session_count(void);
+
+void auth_session_get_stats(auth_session_stats_t* stats);
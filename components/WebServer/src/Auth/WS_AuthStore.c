@@ -2,10 +2,15 @@
 #include "WS_AuthCrypto.h"
 
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include "esp_log.h"
-#include "nvs_flash.h"
-#include "nvs.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mbedtls/constant_time.h"
+#include "NVS_Config.h"
 #include "sdkconfig.h"
 
 static const char* TAG = "AUTH_STORE";
@@ -15,30 +20,242 @@ static const char* TAG = "AUTH_STORE";
 /* ------------------------------------------------------------------ */
 #define AUTH_NVS_NAMESPACE  "auth"
 
+#define KEY_SVC_CRED    "svc_cred"
 #define KEY_SVC_SALT    "svc_salt"
 #define KEY_SVC_HASH    "svc_hash"
+#define KEY_SVC_ITER    "svc_iter"
 #define KEY_CLI_USER    "cli_user"
+#define KEY_CLI_CRED    "cli_cred"
 #define KEY_CLI_SALT    "cli_salt"
 #define KEY_CLI_HASH    "cli_hash"
+#define KEY_CLI_ITER    "cli_iter"
 #define KEY_CLI_EXISTS  "cli_exists"
 
+#define ITER_STR_MAX    12
+#define USERNAME_MAX    31
+
+#define CRED_BLOB_VERSION   1
+
 /* Service username — compile-time constant from Kconfig */
 #define SVC_USERNAME    CONFIG_WS_AUTH_USERNAME
 #define SVC_PASSWORD    CONFIG_WS_AUTH_PASSWORD
 
+/* A credential is one blob, written with a single set. Older firmware kept
+ * salt, hash and iterations in three keys (no iteration key: a pre-PBKDF2
+ * hash); those are still read, and replaced by the blob on login */
+typedef struct {
+    const char* cred_key;
+    const char* salt_key;
+    const char* hash_key;
+    const char* iter_key;
+} cred_keys_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  version;           // CRED_BLOB_VERSION
+    uint8_t  reserved[3];
+    uint32_t iterations;
+    uint8_t  salt[AUTH_CRYPTO_SALT_LEN];
+    uint8_t  hash[AUTH_CRYPTO_HASH_LEN];
+} cred_blob_t;
+
+typedef struct {
+    uint8_t  salt[AUTH_CRYPTO_SALT_LEN];
+    uint8_t  hash[AUTH_CRYPTO_HASH_LEN];
+    uint32_t iterations;
+    bool     split_keys;        // read from the old three-key layout
+} cred_t;
+
+static const cred_keys_t SVC_KEYS = { KEY_SVC_CRED, KEY_SVC_SALT, KEY_SVC_HASH, KEY_SVC_ITER };
+static const cred_keys_t CLI_KEYS = { KEY_CLI_CRED, KEY_CLI_SALT, KEY_CLI_HASH, KEY_CLI_ITER };
+
+/* Hashing runs outside the lock (it takes ~CONFIG_WS_AUTH_KDF_TARGET_MS);
+ * the lock only keeps salt, hash and iterations consistent with each
+ * other while the login worker and the server task read and write them */
+static SemaphoreHandle_t  s_mutex = NULL;
+static StaticSemaphore_t  s_mutex_buf;
+static uint32_t           s_kdf_iterations = AUTH_CRYPTO_MIN_ITERATIONS;
+static auth_kdf_stats_t   s_kdf_stats;
+
+static void lock(void)   { xSemaphoreTake(s_mutex, portMAX_DELAY); }
+static void unlock(void) { xSemaphoreGive(s_mutex); }
+
 /* ------------------------------------------------------------------ */
-/* NVS helpers                                                         */
+/* NVS helpers — reads are served from the config store's RAM cache,  */
+/* so per-request verification does not touch flash                    */
 /* ------------------------------------------------------------------ */
-static esp_err_t nvs_write_str(nvs_handle_t h, const char* key, const char* val)
+static esp_err_t nvs_write_str(const char* key, const char* val)
+{
+    return NVS_Config_SetStr(AUTH_NVS_NAMESPACE, key, val);
+}
+
+static esp_err_t nvs_read_str(const char* key, char* buf, size_t buf_len)
 {
-    esp_err_t err = nvs_set_str(h, key, val);
+    return NVS_Config_GetStr(AUTH_NVS_NAMESPACE, key, buf, buf_len);
+}
+
+/* Caller holds the lock */
+static bool load_split_cred(const cred_keys_t* keys, cred_t* out)
+{
+    char salt_hex[AUTH_CRYPTO_SALT_HEX];
+    char hash_hex[AUTH_CRYPTO_HASH_HEX];
+    char iter_str[ITER_STR_MAX];
+
+    if ((ESP_OK != nvs_read_str(keys->salt_key, salt_hex, sizeof(salt_hex)))
+        || (ESP_OK != nvs_read_str(keys->hash_key, hash_hex, sizeof(hash_hex)))
+        || (ESP_OK != auth_crypto_hex_to_salt(salt_hex, out->salt))
+        || (ESP_OK != auth_crypto_hex_to_hash(hash_hex, out->hash))) {
+        return false;
+    }
+    out->split_keys = true;
+
+    esp_err_t err = nvs_read_str(keys->iter_key, iter_str, sizeof(iter_str));
+    if (ESP_ERR_NVS_NOT_FOUND == err) {
+        out->iterations = AUTH_CRYPTO_LEGACY_ITERATIONS;
+        return true;
+    }
+
+    char* end = NULL;
+    unsigned long iterations = strtoul(iter_str, &end, 10);
+    if ((ESP_OK != err) || (end == iter_str) || ('\0' != *end)) {
+        return false;
+    }
+    out->iterations = (uint32_t)iterations;
+    return true;
+}
+
+/* Caller holds the lock */
+static bool load_cred(const cred_keys_t* keys, cred_t* out)
+{
+    cred_blob_t blob;
+    size_t len = sizeof(blob);
+    esp_err_t err = NVS_Config_GetBlob(AUTH_NVS_NAMESPACE, keys->cred_key, &blob, &len);
+
+    if (ESP_ERR_NVS_NOT_FOUND == err) {
+        return load_split_cred(keys, out);
+    }
+    if ((ESP_OK != err) || (sizeof(blob) != len) || (CRED_BLOB_VERSION != blob.version)
+        || (blob.iterations < AUTH_CRYPTO_MIN_ITERATIONS) || (blob.iterations > AUTH_CRYPTO_MAX_ITERATIONS)) {
+        ESP_LOGE(TAG, "Unreadable %s (%s, %u bytes)", keys->cred_key, esp_err_to_name(err), (unsigned)len);
+        return false;
+    }
+
+    memcpy(out->salt, blob.salt, sizeof(out->salt));
+    memcpy(out->hash, blob.hash, sizeof(out->hash));
+    out->iterations = blob.iterations;
+    out->split_keys = false;
+    return true;
+}
+
+/* Caller holds the lock. ESP_OK if the blob or an old-layout hash is
+ * there, ESP_ERR_NVS_NOT_FOUND if neither is */
+static esp_err_t cred_exists(const cred_keys_t* keys)
+{
+    char hash_hex[AUTH_CRYPTO_HASH_HEX];
+    size_t len = 0;
+
+    esp_err_t err = NVS_Config_GetBlob(AUTH_NVS_NAMESPACE, keys->cred_key, NULL, &len);
+    if (ESP_ERR_NVS_NOT_FOUND == err) {
+        err = nvs_read_str(keys->hash_key, hash_hex, sizeof(hash_hex));
+    }
+    return err;
+}
+
+/* Caller holds the lock. The blob is set and flushed before this returns,
+ * so a power cut leaves either the old credential or the new one. Keys of
+ * the old layout are dropped only after that; the blob wins over them */
+static esp_err_t store_cred(const cred_keys_t* keys, const cred_t* cred)
+{
+    cred_blob_t blob = { .version = CRED_BLOB_VERSION, .iterations = cred->iterations };
+    memcpy(blob.salt, cred->salt, sizeof(blob.salt));
+    memcpy(blob.hash, cred->hash, sizeof(blob.hash));
+
+    esp_err_t err = NVS_Config_SetBlob(AUTH_NVS_NAMESPACE, keys->cred_key, &blob, sizeof(blob));
+    if (ESP_OK == err) { err = NVS_Config_Flush(); }
+    if (ESP_OK == err) {
+        NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, keys->salt_key);
+        NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, keys->hash_key);
+        NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, keys->iter_key);
+        NVS_Config_Flush();
+    }
     return err;
 }
 
-static esp_err_t nvs_read_str(nvs_handle_t h, const char* key, char* buf, size_t buf_len)
+static esp_err_t hash_new(const char* password, cred_t* out)
+{
+    out->iterations = s_kdf_iterations;
+    return auth_crypto_hash_password(password, out->iterations, out->salt, out->hash);
+}
+
+/* Move a credential from the old three-key layout into the blob, now that
+ * the password is known to match. A legacy SHA-256 hash is re-hashed with
+ * PBKDF2; a PBKDF2 one is kept. Skipped if the credential changed while
+ * this login was hashing */
+static void upgrade_legacy(const cred_keys_t* keys, const char* password, const cred_t* old)
+{
+    bool rehash = (AUTH_CRYPTO_LEGACY_ITERATIONS == old->iterations);
+    cred_t fresh = *old;
+    if (rehash && (ESP_OK != hash_new(password, &fresh))) {
+        return;
+    }
+
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    cred_t current;
+    lock();
+    if (load_cred(keys, &current)
+        && current.split_keys
+        && (current.iterations == old->iterations)
+        && (0 == memcmp(current.salt, old->salt, sizeof(current.salt)))) {
+        err = store_cred(keys, &fresh);
+    }
+    unlock();
+
+    if (ESP_OK == err) {
+        if (rehash) {
+            s_kdf_stats.upgraded++;
+        }
+        ESP_LOGI(TAG, "Moved %s to %s (PBKDF2, %lu iterations)", keys->hash_key, keys->cred_key,
+                 (unsigned long)fresh.iterations);
+    } else if (ESP_ERR_INVALID_STATE != err) {
+        ESP_LOGW(TAG, "Upgrading %s failed: %s", keys->hash_key, esp_err_to_name(err));
+    }
+}
+
+/* Stand-in for an account that does not exist or a username that did not
+ * match. Hashing against it costs what a real check costs, so the reply
+ * time does not tell which usernames are valid */
+static void dummy_cred(cred_t* out)
+{
+    memset(out, 0, sizeof(*out));
+    out->iterations = s_kdf_iterations;
+}
+
+/* Compares the whole field whatever the contents, unlike strcmp() */
+static bool username_equal(const char* submitted, const char* stored)
+{
+    char a[USERNAME_MAX + 1] = {0};
+    char b[USERNAME_MAX + 1] = {0};
+    size_t len = strnlen(submitted, sizeof(a));
+    bool fits = (len < sizeof(a));
+
+    memcpy(a, submitted, fits ? len : sizeof(a) - 1);
+    strlcpy(b, stored, sizeof(b));
+    bool equal = (0 == mbedtls_ct_memcmp(a, b, sizeof(a)));
+    return fits & equal;
+}
+
+/* Runs the KDF whether or not the account and username are known; an
+ * old-layout credential is upgraded only when all three matched */
+static bool verify_cred(const cred_keys_t* keys, bool known, const cred_t* cred, const char* password)
 {
-    size_t required = buf_len;
-    return nvs_get_str(h, key, buf, &required);
+    int64_t start_us = esp_timer_get_time();
+    bool match = auth_crypto_verify_password(password, cred->salt, cred->iterations, cred->hash);
+    s_kdf_stats.last_verify_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    match = known & match;
+    if (match && cred->split_keys) {
+        upgrade_legacy(keys, password, cred);
+    }
+    return match;
 }
 
 /* ------------------------------------------------------------------ */
@@ -46,42 +263,37 @@ static esp_err_t nvs_read_str(nvs_handle_t h, const char* key, char* buf, size_t
 /* ------------------------------------------------------------------ */
 esp_err_t auth_store_init(void)
 {
-    nvs_handle_t h;
-    esp_err_t err = nvs_open(AUTH_NVS_NAMESPACE, NVS_READWRITE, &h);
-    if (ESP_OK != err) {
-        ESP_LOGE(TAG, "nvs_open failed: %s", esp_err_to_name(err));
-        return err;
+    if (NULL == s_mutex) {
+        s_mutex = xSemaphoreCreateMutexStatic(&s_mutex_buf);
     }
 
-    /* Check if service hash already exists */
-    char existing[AUTH_CRYPTO_HASH_HEX];
-    size_t len = sizeof(existing);
-    err = nvs_get_str(h, KEY_SVC_HASH, existing, &len);
+    /* Cost for hashes made from now on; stored hashes keep their own */
+    int64_t start_us = esp_timer_get_time();
+    s_kdf_iterations = auth_crypto_calibrate(CONFIG_WS_AUTH_KDF_TARGET_MS);
+    s_kdf_stats.iterations = s_kdf_iterations;
+    s_kdf_stats.target_ms  = CONFIG_WS_AUTH_KDF_TARGET_MS;
+    ESP_LOGI(TAG, "PBKDF2 calibrated to %lu iterations for %d ms (took %lu ms)",
+             (unsigned long)s_kdf_iterations, CONFIG_WS_AUTH_KDF_TARGET_MS,
+             (unsigned long)((esp_timer_get_time() - start_us) / 1000));
+
+    /* Provision only if neither the blob nor an old-layout hash is there */
+    lock();
+    esp_err_t err = cred_exists(&SVC_KEYS);
+    unlock();
 
     if (ESP_ERR_NVS_NOT_FOUND == err) {
         /* First boot — hash the Kconfig default password */
         ESP_LOGI(TAG, "First boot: provisioning service account hash");
 
-        uint8_t salt[AUTH_CRYPTO_SALT_LEN];
-        uint8_t hash[AUTH_CRYPTO_HASH_LEN];
-        err = auth_crypto_hash_password(SVC_PASSWORD, salt, hash);
+        cred_t cred;
+        err = hash_new(SVC_PASSWORD, &cred);
         if (ESP_OK != err) {
-            nvs_close(h);
             return err;
         }
 
-        char salt_hex[AUTH_CRYPTO_SALT_HEX];
-        char hash_hex[AUTH_CRYPTO_HASH_HEX];
-        auth_crypto_salt_to_hex(salt, salt_hex);
-        auth_crypto_hash_to_hex(hash, hash_hex);
-
-        err = nvs_write_str(h, KEY_SVC_SALT, salt_hex);
-        if (ESP_OK == err) {
-            err = nvs_write_str(h, KEY_SVC_HASH, hash_hex);
-        }
-        if (ESP_OK == err) {
-            err = nvs_commit(h);
-        }
+        lock();
+        err = store_cred(&SVC_KEYS, &cred);
+        unlock();
 
         if (ESP_OK != err) {
             ESP_LOGE(TAG, "Failed to provision service hash: %s", esp_err_to_name(err));
@@ -91,11 +303,15 @@ esp_err_t auth_store_init(void)
     } else if (ESP_OK == err) {
         ESP_LOGI(TAG, "Service account already provisioned");
     } else {
-        ESP_LOGE(TAG, "Error reading service hash: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "Error reading service credential: %s", esp_err_to_name(err));
     }
 
-    nvs_close(h);
-    return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_FAIL : err;
+    return err;
+}
+
+void auth_store_get_kdf_stats(auth_kdf_stats_t* stats)
+{
+    *stats = s_kdf_stats;
 }
 
 /* ------------------------------------------------------------------ */
@@ -107,35 +323,18 @@ bool auth_store_verify_service(const char* username, const char* password)
         return false;
     }
 
-    /* Username must match the compile-time constant */
-    if (0 != strcmp(username, SVC_USERNAME)) {
-        return false;
-    }
-
-    nvs_handle_t h;
-    if (ESP_OK != nvs_open(AUTH_NVS_NAMESPACE, NVS_READONLY, &h)) {
-        return false;
-    }
-
-    char salt_hex[AUTH_CRYPTO_SALT_HEX];
-    char hash_hex[AUTH_CRYPTO_HASH_HEX];
-    bool result = false;
-
-    if (ESP_OK == nvs_read_str(h, KEY_SVC_SALT, salt_hex, sizeof(salt_hex))
-        && ESP_OK == nvs_read_str(h, KEY_SVC_HASH, hash_hex, sizeof(hash_hex)))
-    {
-        uint8_t salt[AUTH_CRYPTO_SALT_LEN];
-        uint8_t hash[AUTH_CRYPTO_HASH_LEN];
-
-        if (ESP_OK == auth_crypto_hex_to_salt(salt_hex, salt)
-            && ESP_OK == auth_crypto_hex_to_hash(hash_hex, hash))
-        {
-            result = auth_crypto_verify_password(password, salt, hash);
-        }
+    cred_t cred;
+    lock();
+    bool loaded = load_cred(&SVC_KEYS, &cred);
+    unlock();
+    if (!loaded) {
+        dummy_cred(&cred);
     }
 
-    nvs_close(h);
-    return result;
+    /* Username must match the compile-time constant; checked without
+     * skipping the KDF, so a wrong name costs as long as a wrong password */
+    bool known = loaded & username_equal(username, SVC_USERNAME);
+    return verify_cred(&SVC_KEYS, known, &cred, password);
 }
 
 /* ------------------------------------------------------------------ */
@@ -143,14 +342,8 @@ bool auth_store_verify_service(const char* username, const char* password)
 /* ------------------------------------------------------------------ */
 bool auth_store_client_exists(void)
 {
-    nvs_handle_t h;
-    if (ESP_OK != nvs_open(AUTH_NVS_NAMESPACE, NVS_READONLY, &h)) {
-        return false;
-    }
-
     uint8_t flag = 0;
-    esp_err_t err = nvs_get_u8(h, KEY_CLI_EXISTS, &flag);
-    nvs_close(h);
+    esp_err_t err = NVS_Config_GetU8(AUTH_NVS_NAMESPACE, KEY_CLI_EXISTS, &flag);
 
     return (ESP_OK == err) && (1 == flag);
 }
@@ -161,38 +354,21 @@ bool auth_store_verify_client(const char* username, const char* password)
         return false;
     }
 
-    if (!auth_store_client_exists()) {
-        return false;
-    }
-
-    nvs_handle_t h;
-    if (ESP_OK != nvs_open(AUTH_NVS_NAMESPACE, NVS_READONLY, &h)) {
-        return false;
-    }
-
-    char stored_user[32] = {0};
-    char salt_hex[AUTH_CRYPTO_SALT_HEX];
-    char hash_hex[AUTH_CRYPTO_HASH_HEX];
-    bool result = false;
-
-    if (ESP_OK == nvs_read_str(h, KEY_CLI_USER, stored_user, sizeof(stored_user))
-        && ESP_OK == nvs_read_str(h, KEY_CLI_SALT, salt_hex, sizeof(salt_hex))
-        && ESP_OK == nvs_read_str(h, KEY_CLI_HASH, hash_hex, sizeof(hash_hex)))
-    {
-        if (0 == strcmp(username, stored_user)) {
-            uint8_t salt[AUTH_CRYPTO_SALT_LEN];
-            uint8_t hash[AUTH_CRYPTO_HASH_LEN];
-
-            if (ESP_OK == auth_crypto_hex_to_salt(salt_hex, salt)
-                && ESP_OK == auth_crypto_hex_to_hash(hash_hex, hash))
-            {
-                result = auth_crypto_verify_password(password, salt, hash);
-            }
-        }
+    char stored_user[USERNAME_MAX + 1] = {0};
+    cred_t cred;
+
+    lock();
+    bool loaded = auth_store_client_exists()
+               && (ESP_OK == nvs_read_str(KEY_CLI_USER, stored_user, sizeof(stored_user)))
+               && load_cred(&CLI_KEYS, &cred);
+    unlock();
+    if (!loaded) {
+        dummy_cred(&cred);
+        stored_user[0] = '\0';
     }
 
-    nvs_close(h);
-    return result;
+    bool known = loaded & username_equal(username, stored_user);
+    return verify_cred(&CLI_KEYS, known, &cred, password);
 }
 
 esp_err_t auth_store_set_client(const char* username, const char* password)
@@ -201,38 +377,25 @@ esp_err_t auth_store_set_client(const char* username, const char* password)
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (strlen(username) == 0 || strlen(username) > 31) {
+    if (strlen(username) == 0 || strlen(username) > USERNAME_MAX) {
         return ESP_ERR_INVALID_ARG;
     }
     if (strlen(password) < 8) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    uint8_t salt[AUTH_CRYPTO_SALT_LEN];
-    uint8_t hash[AUTH_CRYPTO_HASH_LEN];
-    esp_err_t err = auth_crypto_hash_password(password, salt, hash);
-    if (ESP_OK != err) {
-        return err;
-    }
-
-    char salt_hex[AUTH_CRYPTO_SALT_HEX];
-    char hash_hex[AUTH_CRYPTO_HASH_HEX];
-    auth_crypto_salt_to_hex(salt, salt_hex);
-    auth_crypto_hash_to_hex(hash, hash_hex);
-
-    nvs_handle_t h;
-    err = nvs_open(AUTH_NVS_NAMESPACE, NVS_READWRITE, &h);
+    cred_t cred;
+    esp_err_t err = hash_new(password, &cred);
     if (ESP_OK != err) {
         return err;
     }
 
-    err = nvs_write_str(h, KEY_CLI_USER, username);
-    if (ESP_OK == err) { err = nvs_write_str(h, KEY_CLI_SALT, salt_hex); }
-    if (ESP_OK == err) { err = nvs_write_str(h, KEY_CLI_HASH, hash_hex); }
-    if (ESP_OK == err) { err = nvs_set_u8(h, KEY_CLI_EXISTS, 1); }
-    if (ESP_OK == err) { err = nvs_commit(h); }
-
-    nvs_close(h);
+    /* Username, credential and flag go out in one flush (store_cred's) */
+    lock();
+    err = nvs_write_str(KEY_CLI_USER, username);
+    if (ESP_OK == err) { err = NVS_Config_SetU8(AUTH_NVS_NAMESPACE, KEY_CLI_EXISTS, 1); }
+    if (ESP_OK == err) { err = store_cred(&CLI_KEYS, &cred); }
+    unlock();
 
     if (ESP_OK == err) {
         ESP_LOGI(TAG, "Client account set: %s", username);
@@ -245,20 +408,16 @@ esp_err_t auth_store_set_client(const char* username, const char* password)
 
 esp_err_t auth_store_delete_client(void)
 {
-    nvs_handle_t h;
-    esp_err_t err = nvs_open(AUTH_NVS_NAMESPACE, NVS_READWRITE, &h);
-    if (ESP_OK != err) {
-        return err;
-    }
-
-    /* Erase all client keys — ignore NOT_FOUND errors */
-    nvs_erase_key(h, KEY_CLI_USER);
-    nvs_erase_key(h, KEY_CLI_SALT);
-    nvs_erase_key(h, KEY_CLI_HASH);
-    nvs_erase_key(h, KEY_CLI_EXISTS);
-    err = nvs_commit(h);
-
-    nvs_close(h);
+    /* Erase all client keys — missing keys are not an error */
+    lock();
+    NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, KEY_CLI_USER);
+    NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, KEY_CLI_CRED);
+    NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, KEY_CLI_SALT);
+    NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, KEY_CLI_HASH);
+    NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, KEY_CLI_ITER);
+    NVS_Config_EraseKey(AUTH_NVS_NAMESPACE, KEY_CLI_EXISTS);
+    esp_err_t err = NVS_Config_Flush();
+    unlock();
 
     ESP_LOGI(TAG, "Client account deleted");
     return err;
@@ -274,13 +433,5 @@ esp_err_t auth_store_get_client_username(char* out, size_t len)
         return ESP_ERR_NOT_FOUND;
     }
 
-    nvs_handle_t h;
-    esp_err_t err = nvs_open(AUTH_NVS_NAMESPACE, NVS_READONLY, &h);
-    if (ESP_OK != err) {
-        return err;
-    }
-
-    err = nvs_read_str(h, KEY_CLI_USER, out, len);
-    nvs_close(h);
-    return err;
+    return nvs_read_str(KEY_CLI_USER, out, len);
 }
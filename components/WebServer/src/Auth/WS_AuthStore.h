@@ -3,20 +3,38 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t iterations;        // PBKDF2 cost for new hashes, calibrated at boot
+    uint32_t target_ms;         // CONFIG_WS_AUTH_KDF_TARGET_MS
+    uint32_t last_verify_ms;    // most recent password check
+    uint32_t upgraded;          // legacy SHA-256 hashes re-hashed since boot
+} auth_kdf_stats_t;
 
 /**
  * @brief  Initialise the credential store.
+ *         Calibrates the PBKDF2 iteration count to CONFIG_WS_AUTH_KDF_TARGET_MS.
  *         On first boot (no service hash in NVS), hashes the Kconfig default
- *         password and writes the salt + hash to the "auth" NVS namespace.
- *         Must be called once at startup before any login attempt.
+ *         password and writes the salt + hash + iterations as one blob to the
+ *         "auth" NVS namespace. Must be called once at startup before any
+ *         login attempt.
  *
  * @return ESP_OK on success
  */
 esp_err_t auth_store_init(void);
 
+/**
+ * @brief  Password hashing cost and activity, for /api/status.
+ */
+void auth_store_get_kdf_stats(auth_kdf_stats_t* stats);
+
 /**
  * @brief  Verify service account credentials.
  *         Service username is the compile-time CONFIG_WS_AUTH_USERNAME.
+ *         Takes about CONFIG_WS_AUTH_KDF_TARGET_MS; a legacy SHA-256 hash is
+ *         replaced by a PBKDF2 one when the password matches.
  *
  * @param[in] username  Submitted username
  * @param[in] password  Submitted plaintext password
@@ -31,7 +49,8 @@ bool auth_store_verify_service(const char* username, const char* password);
 bool auth_store_client_exists(void);
 
 /**
- * @brief  Verify client account credentials.
+ * @brief  Verify client account credentials (same cost and upgrade as
+ *         the service account).
  *
  * @param[in] username  Submitted username
  * @param[in] password  Submitted plaintext password
@@ -41,8 +60,8 @@ bool auth_store_verify_client(const char* username, const char* password);
 
 /**
  * @brief  Create or update the client account.
- *         Generates a fresh salt, hashes the password, and stores everything
- *         in the "auth" NVS namespace.
+ *         Generates a fresh salt, hashes the password with the calibrated
+ *         PBKDF2 cost, and stores everything in the "auth" NVS namespace.
  *
  * @param[in] username  Client username (max 31 chars)
  * @param[in] password  Client plaintext password (min 8 chars)
@@ -5,6 +5,9 @@
 #include "CredentialAPI.h"
 #include "Auth/WS_Auth.h"
 #include "Auth/WS_AuthStore.h"
+#include "WS_Body.h"
+#include "WS_Arena.h"
+#include "WS_Async.h"
 #include "cJSON.h"
 #include "esp_log.h"
 
@@ -13,6 +16,8 @@
 
 static const char *TAG = "CRED_API";
 
+#define CREDENTIAL_BODY_MAX 256
+
 /* ------------------------------------------------------------------ */
 /* Resource struct                                                     */
 /* ------------------------------------------------------------------ */
@@ -37,7 +42,7 @@ sendJson(httpd_req_t *ptReq, cJSON *ptRoot)
     const char *pcJson = cJSON_PrintUnformatted(ptRoot);
     auth_set_security_headers(ptReq);
     httpd_resp_sendstr(ptReq, pcJson);
-    free((void *)pcJson);
+    cJSON_free((void *)pcJson);
     cJSON_Delete(ptRoot);
     return ESP_OK;
 }
@@ -51,7 +56,7 @@ sendError(httpd_req_t *ptReq, const char *pcStatus, const char *pcMsg)
     auth_set_security_headers(ptReq);
     httpd_resp_set_status(ptReq, pcStatus);
     httpd_resp_sendstr(ptReq, pcJson);
-    free((void *)pcJson);
+    cJSON_free((void *)pcJson);
     cJSON_Delete(ptRoot);
     return ESP_OK;
 }
@@ -111,7 +116,7 @@ CredentialAPI_Register(CREDENTIAL_API_H hApi, httpd_handle_t hHttpServer)
         .handler  = handler_GetCredentials,
         .user_ctx = ptRsc,
     };
-    esp_err_t err = httpd_register_uri_handler(hHttpServer, &tGetUri);
+    esp_err_t err = WS_Arena_RegisterUri(hHttpServer, &tGetUri);
 
     if (ESP_OK == err) {
         httpd_uri_t tPostUri = {
@@ -120,7 +125,8 @@ CredentialAPI_Register(CREDENTIAL_API_H hApi, httpd_handle_t hHttpServer)
             .handler  = handler_PostCredentials,
             .user_ctx = ptRsc,
         };
-        err = httpd_register_uri_handler(hHttpServer, &tPostUri);
+        /* Hashing the new password takes CONFIG_WS_AUTH_KDF_TARGET_MS */
+        err = WS_Async_RegisterUri(hHttpServer, &tPostUri);
     }
 
     if (ESP_OK == err) {
@@ -130,7 +136,7 @@ CredentialAPI_Register(CREDENTIAL_API_H hApi, httpd_handle_t hHttpServer)
             .handler  = handler_DeleteCredentials,
             .user_ctx = ptRsc,
         };
-        err = httpd_register_uri_handler(hHttpServer, &tDeleteUri);
+        err = WS_Arena_RegisterUri(hHttpServer, &tDeleteUri);
     }
 
     if (ESP_OK == err) {
@@ -181,16 +187,10 @@ handler_PostCredentials(httpd_req_t *ptReq)
         return ESP_OK;
     }
 
-    char acBuf[256];
-    int iLen = httpd_req_recv(ptReq, acBuf, sizeof(acBuf) - 1);
-    if (iLen <= 0) {
-        return sendError(ptReq, "400 Bad Request", "Empty body");
-    }
-    acBuf[iLen] = '\0';
-
-    cJSON *ptRoot = cJSON_Parse(acBuf);
-    if (ptRoot == NULL) {
-        return sendError(ptReq, "400 Bad Request", "Invalid JSON");
+    cJSON *ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, CREDENTIAL_BODY_MAX, &ptRoot);
+    if (err != ESP_OK) {
+        return WS_Body_SendError(ptReq, err);
     }
 
     cJSON *ptUser = cJSON_GetObjectItem(ptRoot, "username");
@@ -214,7 +214,7 @@ handler_PostCredentials(httpd_req_t *ptReq)
         return sendError(ptReq, "400 Bad Request", "Password must be at least 8 characters");
     }
 
-    esp_err_t err = auth_store_set_client(username, password);
+    err = auth_store_set_client(username, password);
     cJSON_Delete(ptRoot);
 
     if (ESP_OK != err) {
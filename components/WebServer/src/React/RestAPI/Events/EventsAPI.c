@@ -0,0 +1,978 @@
+/* ================================================================== */
+/* EventsAPI.c — live bell/device state, session-protected             */
+/*   GET /api/events   Server-Sent Events (push only)                  */
+/*   GET /ws           WebSocket: status push + binary commands        */
+/* ================================================================== */
+#include "EventsAPI.h"
+#include "RingBell_API.h"
+#include "Bell_Log.h"
+#include "TouchScreen_Services.h"
+#include "Auth/WS_Auth.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+
+#include <sys/socket.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CONFIG_HTTPD_WS_SUPPORT
+#error "EventsAPI needs CONFIG_HTTPD_WS_SUPPORT for /ws"
+#endif
+
+static const char* TAG = "EVENTS_API";
+
+#define EVENTS_TASK_STACK_SIZE      4096
+#define EVENTS_TASK_PRIORITY        3
+#define EVENTS_MAX_CLIENTS          CONFIG_WS_EVENTS_MAX_CLIENTS
+#define EVENTS_POLL_MS              CONFIG_WS_EVENTS_POLL_MS
+#define EVENTS_HEARTBEAT_US         ((int64_t)CONFIG_WS_EVENTS_HEARTBEAT_SEC * 1000000LL)
+#define EVENTS_SEND_TIMEOUT_SEC     2       /* a client this far behind is dropped */
+#define EVENTS_RETRY_MS             3000    /* EventSource reconnect delay */
+#define EVENTS_BUF_SIZE             768
+#define EVENTS_MAX_WS_CLIENTS       CONFIG_WS_EVENTS_MAX_WS_CLIENTS
+#define EVENTS_WS_USER_LEN          32
+
+/* One bit per event name. A client's pending mask holds the events it has
+   not been sent yet; a change while one is still pending only updates the
+   value that goes out, so a slow client never queues more than one frame. */
+#define EVENT_BELL          (1u << 0)
+#define EVENT_PANIC         (1u << 1)
+#define EVENT_NEXT          (1u << 2)
+#define EVENT_DAY           (1u << 3)
+#define EVENT_TIME          (1u << 4)
+#define EVENT_SCHEDULE      (1u << 5)
+#define EVENT_ALL           (EVENT_BELL | EVENT_PANIC | EVENT_NEXT | EVENT_DAY | EVENT_TIME | EVENT_SCHEDULE)
+
+/* /ws binary protocol. Client frames are [op][seq][args...]; every command
+   is answered with [op | WS_REPLY][seq][WS_ST_*]. Status pushes are
+   [WS_MSG_STATUS][changed EVENT_* bits][fields, see events_WsEncodeStatus]. */
+#define WS_OP_SUBSCRIBE     0x01    /* [mask]: EVENT_* bits to push, 0 = stop */
+#define WS_OP_STATUS        0x02    /* one status frame now */
+#define WS_OP_TEST_RING     0x10    /* [durationSec], 0 = default */
+#define WS_OP_PANIC         0x11    /* [0|1] */
+#define WS_OP_TODAY         0x12    /* [0 day off | 1 normal | 0xFF cancel] */
+#define WS_OP_PING          0x7F    /* echo, for round-trip timing */
+#define WS_REPLY            0x80
+#define WS_MSG_STATUS       0xC0
+
+#define WS_ST_OK            0
+#define WS_ST_BAD_REQUEST   1
+#define WS_ST_UNAUTHORIZED  2       /* session expired or logged out; socket closes */
+#define WS_ST_CONFLICT      3       /* e.g. test ring during panic */
+#define WS_ST_FAILED        4
+#define WS_ST_UNKNOWN_OP    5
+
+#define WS_TODAY_CANCEL     0xFF
+#define WS_CMD_MAX_LEN      8
+#define WS_STATUS_MAX_LEN   (18 + SCHEDULE_LABEL_MAX_LEN)
+
+#define WS_CLOSE_TRY_AGAIN      1013    /* too many sockets */
+#define WS_CLOSE_UNAUTHORIZED   4401
+
+/* ------------------------------------------------------------------ */
+/* Resource struct                                                     */
+/* ------------------------------------------------------------------ */
+typedef struct
+{
+    BELL_STATE_E        eBellState;
+    bool                bPanic;
+    NEXT_BELL_INFO_T    tNextBell;
+    DAY_TYPE_E          eDayType;
+    char                acDate[SCHEDULE_DATE_STR_LEN];
+    uint16_t            usYear;
+    uint8_t             ucMonth;
+    uint8_t             ucDay;
+    bool                bTimeSynced;
+    uint32_t            ulGeneration;
+} EVENTS_SNAPSHOT_T;
+
+typedef struct
+{
+    httpd_req_t*        ptReq;          /* async request copy, NULL = free slot */
+    uint32_t            ulPending;      /* EVENT_* bits not yet sent */
+    bool                bFirst;         /* nothing sent yet (headers + retry) */
+    int64_t             llLastSendUs;
+    char                acToken[AUTH_SESSION_TOKEN_LEN + 1];    /* session that opened the stream */
+} EVENTS_CLIENT_T;
+
+struct _EVENTS_API_RSC_T;
+
+/* One /ws socket. Doubles as the httpd session context, so the server
+   releases the slot (events_WsFreeCtx) when the socket closes. */
+typedef struct
+{
+    struct _EVENTS_API_RSC_T* ptRsc;
+    httpd_handle_t      hServer;        /* HTTP or HTTPS listener the socket is on */
+    int                 iFd;            /* -1 = free slot */
+    uint8_t             ucSubscribed;   /* EVENT_* bits the client asked for */
+    uint32_t            ulPending;      /* subscribed bits not yet pushed */
+    bool                bInFlight;      /* a push is queued on the server task */
+    int64_t             llLastSendUs;
+    char                acToken[AUTH_SESSION_TOKEN_LEN + 1];
+    char                acUser[EVENTS_WS_USER_LEN];
+} EVENTS_WS_CLIENT_T;
+
+typedef struct _EVENTS_API_RSC_T
+{
+    SCHEDULER_H         hScheduler;
+    TaskHandle_t        hTask;
+    SemaphoreHandle_t   hMutex;         /* guards atClient / atWs and the counts */
+    EVENTS_CLIENT_T     atClient[EVENTS_MAX_CLIENTS];
+    uint32_t            ulClientCount;
+    EVENTS_WS_CLIENT_T  atWs[EVENTS_MAX_WS_CLIENTS];
+    uint32_t            ulWsCount;
+    EVENTS_SNAPSHOT_T   tLast;
+} EVENTS_API_RSC_T;
+
+/* Frame handed to the server task by events_WsQueue */
+typedef struct
+{
+    EVENTS_API_RSC_T*   ptRsc;
+    size_t              ulSlot;
+    httpd_handle_t      hServer;
+    int                 iFd;
+    httpd_ws_type_t     eType;
+    size_t              ulLen;
+    uint8_t             aucData[WS_STATUS_MAX_LEN];
+} EVENTS_WS_PUSH_T;
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+static const char*
+events_BellStateStr(BELL_STATE_E eState)
+{
+    switch (eState)
+    {
+        case BELL_STATE_RINGING:    return "ringing";
+        case BELL_STATE_PANIC:      return "panic";
+        case BELL_STATE_IDLE:
+        default:                    return "idle";
+    }
+}
+
+static const char*
+events_DayTypeStr(DAY_TYPE_E eDayType)
+{
+    /* Same names as GET /api/bell/status */
+    static const char* apcDayTypes[] = { "off", "working", "holiday", "exceptionWorking", "exceptionHoliday" };
+    return ((unsigned)eDayType < sizeof(apcDayTypes) / sizeof(apcDayTypes[0])) ? apcDayTypes[eDayType] : "off";
+}
+
+static void
+events_Snapshot(EVENTS_API_RSC_T* ptRsc, EVENTS_SNAPSHOT_T* ptSnap)
+{
+    SCHEDULER_STATUS_T tStatus;
+    Scheduler_GetStatus(ptRsc->hScheduler, &tStatus);
+
+    memset(ptSnap, 0, sizeof(EVENTS_SNAPSHOT_T));
+    ptSnap->eBellState   = RingBell_GetState();
+    ptSnap->bPanic       = RingBell_IsPanic();
+    ptSnap->tNextBell    = tStatus.tNextBell;
+    ptSnap->eDayType     = tStatus.eDayType;
+    ptSnap->bTimeSynced  = tStatus.bTimeSynced;
+    ptSnap->ulGeneration = tStatus.ulGeneration;
+    ptSnap->usYear       = (uint16_t)(tStatus.tCurrentTime.tm_year + 1900);
+    ptSnap->ucMonth      = (uint8_t)(tStatus.tCurrentTime.tm_mon + 1);
+    ptSnap->ucDay        = (uint8_t)tStatus.tCurrentTime.tm_mday;
+    snprintf(ptSnap->acDate, sizeof(ptSnap->acDate), "%04u-%02u-%02u",
+             (unsigned)ptSnap->usYear, (unsigned)ptSnap->ucMonth, (unsigned)ptSnap->ucDay);
+}
+
+static uint32_t
+events_Diff(const EVENTS_SNAPSHOT_T* ptOld, const EVENTS_SNAPSHOT_T* ptNew)
+{
+    uint32_t ulChanged = 0;
+    const NEXT_BELL_INFO_T* ptA = &ptOld->tNextBell;
+    const NEXT_BELL_INFO_T* ptB = &ptNew->tNextBell;
+
+    if (ptOld->eBellState != ptNew->eBellState) ulChanged |= EVENT_BELL;
+    if (ptOld->bPanic != ptNew->bPanic)         ulChanged |= EVENT_PANIC;
+    if ((ptA->bValid != ptB->bValid) ||
+        (ptB->bValid && ((ptA->ucHour != ptB->ucHour) ||
+                         (ptA->ucMinute != ptB->ucMinute) ||
+                         (ptA->usDurationSec != ptB->usDurationSec) ||
+                         (strcmp(ptA->acLabel, ptB->acLabel) != 0))))
+    {
+        ulChanged |= EVENT_NEXT;
+    }
+    if ((ptOld->eDayType != ptNew->eDayType) ||
+        (strcmp(ptOld->acDate, ptNew->acDate) != 0))
+    {
+        ulChanged |= EVENT_DAY;
+    }
+    if (ptOld->bTimeSynced != ptNew->bTimeSynced)   ulChanged |= EVENT_TIME;
+    if (ptOld->ulGeneration != ptNew->ulGeneration) ulChanged |= EVENT_SCHEDULE;
+
+    return ulChanged;
+}
+
+/* Append printf output to pcBuf at *pulLen; false once the buffer is full. */
+static bool
+events_Append(char* pcBuf, size_t ulSize, size_t* pulLen, const char* pcFmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static bool
+events_Append(char* pcBuf, size_t ulSize, size_t* pulLen, const char* pcFmt, ...)
+{
+    if (*pulLen >= ulSize) return false;
+
+    va_list tArgs;
+    va_start(tArgs, pcFmt);
+    int iLen = vsnprintf(pcBuf + *pulLen, ulSize - *pulLen, pcFmt, tArgs);
+    va_end(tArgs);
+
+    if ((iLen < 0) || ((size_t)iLen >= ulSize - *pulLen)) return false;
+    *pulLen += (size_t)iLen;
+    return true;
+}
+
+/* Bell labels are user input: escape them for a JSON string. */
+static void
+events_JsonEscape(const char* pcIn, char* pcOut, size_t ulOutSize)
+{
+    size_t ulOut = 0;
+    for (; *pcIn && (ulOut + 7 < ulOutSize); pcIn++)
+    {
+        unsigned char c = (unsigned char)*pcIn;
+        if ((c == '"') || (c == '\\'))
+        {
+            pcOut[ulOut++] = '\\';
+            pcOut[ulOut++] = (char)c;
+        }
+        else if (c < 0x20)
+        {
+            ulOut += (size_t)snprintf(pcOut + ulOut, ulOutSize - ulOut, "\\u%04x", c);
+        }
+        else
+        {
+            pcOut[ulOut++] = (char)c;
+        }
+    }
+    pcOut[ulOut] = '\0';
+}
+
+/* Serialise the pending events as SSE frames. Returns the length, 0 on overflow. */
+static size_t
+events_Format(const EVENTS_SNAPSHOT_T* ptSnap, uint32_t ulMask, bool bFirst,
+              char* pcBuf, size_t ulSize)
+{
+    size_t ulLen = 0;
+    bool   bOk   = true;
+
+    if (bFirst)
+    {
+        bOk = events_Append(pcBuf, ulSize, &ulLen, "retry: %d\n\n", EVENTS_RETRY_MS);
+    }
+
+    if (bOk && (ulMask & EVENT_BELL))
+    {
+        bOk = events_Append(pcBuf, ulSize, &ulLen, "event: bell\ndata: {\"state\":\"%s\"}\n\n",
+                            events_BellStateStr(ptSnap->eBellState));
+    }
+
+    if (bOk && (ulMask & EVENT_PANIC))
+    {
+        bOk = events_Append(pcBuf, ulSize, &ulLen, "event: panic\ndata: {\"enabled\":%s}\n\n",
+                            ptSnap->bPanic ? "true" : "false");
+    }
+
+    if (bOk && (ulMask & EVENT_NEXT))
+    {
+        const NEXT_BELL_INFO_T* ptNext = &ptSnap->tNextBell;
+        if (ptNext->bValid)
+        {
+            char acLabel[SCHEDULE_LABEL_MAX_LEN * 6];     /* worst case: every byte escaped to 6 */
+            events_JsonEscape(ptNext->acLabel, acLabel, sizeof(acLabel));
+            bOk = events_Append(pcBuf, ulSize, &ulLen,
+                                "event: next\ndata: {\"time\":\"%02u:%02u\",\"durationSec\":%u,\"label\":\"%s\"}\n\n",
+                                (unsigned)ptNext->ucHour, (unsigned)ptNext->ucMinute,
+                                (unsigned)ptNext->usDurationSec, acLabel);
+        }
+        else
+        {
+            bOk = events_Append(pcBuf, ulSize, &ulLen, "event: next\ndata: null\n\n");
+        }
+    }
+
+    if (bOk && (ulMask & EVENT_DAY))
+    {
+        bOk = events_Append(pcBuf, ulSize, &ulLen, "event: day\ndata: {\"dayType\":\"%s\",\"date\":\"%s\"}\n\n",
+                            events_DayTypeStr(ptSnap->eDayType), ptSnap->acDate);
+    }
+
+    if (bOk && (ulMask & EVENT_TIME))
+    {
+        bOk = events_Append(pcBuf, ulSize, &ulLen, "event: time\ndata: {\"synced\":%s}\n\n",
+                            ptSnap->bTimeSynced ? "true" : "false");
+    }
+
+    if (bOk && (ulMask & EVENT_SCHEDULE))
+    {
+        bOk = events_Append(pcBuf, ulSize, &ulLen, "event: schedule\ndata: {\"generation\":%lu}\n\n",
+                            (unsigned long)ptSnap->ulGeneration);
+    }
+
+    return bOk ? ulLen : 0;
+}
+
+/* Release a client slot and close its socket (task context only). */
+static void
+events_Drop(EVENTS_API_RSC_T* ptRsc, size_t ulSlot)
+{
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    httpd_req_t* ptReq = ptRsc->atClient[ulSlot].ptReq;
+    memset(&ptRsc->atClient[ulSlot], 0, sizeof(EVENTS_CLIENT_T));
+    ptRsc->ulClientCount--;
+    uint32_t ulLeft = ptRsc->ulClientCount;
+    xSemaphoreGive(ptRsc->hMutex);
+
+    httpd_handle_t hServer = ptReq->handle;
+    int            iFd     = httpd_req_to_sockfd(ptReq);
+
+    httpd_req_async_handler_complete(ptReq);
+    httpd_sess_trigger_close(hServer, iFd);
+
+    ESP_LOGI(TAG, "Event stream closed (%lu open)", (unsigned long)ulLeft);
+}
+
+/* ------------------------------------------------------------------ */
+/* WebSocket                                                           */
+/* ------------------------------------------------------------------ */
+
+/* Status frame, little-endian, 18 bytes + label:
+     [0] WS_MSG_STATUS   [1] changed EVENT_* bits   [2] BELL_STATE_E
+     [3] flags: bit0 panic, bit1 time synced, bit2 next bell valid
+     [4] DAY_TYPE_E      [5..6] year   [7] month   [8] day
+     [9..12] schedule generation
+     [13] next hour   [14] next minute   [15..16] next durationSec
+     [17] label length   [18..] label (UTF-8, not terminated) */
+static size_t
+events_WsEncodeStatus(const EVENTS_SNAPSHOT_T* ptSnap, uint32_t ulChanged, uint8_t* pucOut)
+{
+    const NEXT_BELL_INFO_T* ptNext  = &ptSnap->tNextBell;
+    size_t                  ulLabel = ptNext->bValid ? strnlen(ptNext->acLabel, SCHEDULE_LABEL_MAX_LEN - 1) : 0;
+
+    memset(pucOut, 0, 18);
+    pucOut[0]  = WS_MSG_STATUS;
+    pucOut[1]  = (uint8_t)ulChanged;
+    pucOut[2]  = (uint8_t)ptSnap->eBellState;
+    pucOut[3]  = (uint8_t)((ptSnap->bPanic ? 0x01 : 0) | (ptSnap->bTimeSynced ? 0x02 : 0) | (ptNext->bValid ? 0x04 : 0));
+    pucOut[4]  = (uint8_t)ptSnap->eDayType;
+    pucOut[5]  = (uint8_t)(ptSnap->usYear & 0xFF);
+    pucOut[6]  = (uint8_t)(ptSnap->usYear >> 8);
+    pucOut[7]  = ptSnap->ucMonth;
+    pucOut[8]  = ptSnap->ucDay;
+    pucOut[9]  = (uint8_t)(ptSnap->ulGeneration & 0xFF);
+    pucOut[10] = (uint8_t)((ptSnap->ulGeneration >> 8) & 0xFF);
+    pucOut[11] = (uint8_t)((ptSnap->ulGeneration >> 16) & 0xFF);
+    pucOut[12] = (uint8_t)(ptSnap->ulGeneration >> 24);
+    if (ptNext->bValid)
+    {
+        pucOut[13] = ptNext->ucHour;
+        pucOut[14] = ptNext->ucMinute;
+        pucOut[15] = (uint8_t)(ptNext->usDurationSec & 0xFF);
+        pucOut[16] = (uint8_t)(ptNext->usDurationSec >> 8);
+    }
+    pucOut[17] = (uint8_t)ulLabel;
+    memcpy(&pucOut[18], ptNext->acLabel, ulLabel);
+
+    return 18 + ulLabel;
+}
+
+/* Runs on the socket's server task, so it never interleaves with a command reply
+   on the same socket. Sessions are also only ever read from this task. */
+static void
+events_WsPushWork(void* pvArg)
+{
+    EVENTS_WS_PUSH_T*   ptPush = (EVENTS_WS_PUSH_T*)pvArg;
+    EVENTS_API_RSC_T*   ptRsc  = ptPush->ptRsc;
+    EVENTS_WS_CLIENT_T* ptWs   = &ptRsc->atWs[ptPush->ulSlot];
+    bool                bClose = false;
+    esp_err_t           err    = ESP_FAIL;
+
+    /* The socket may have closed (and its fd been reused) while queued */
+    if ((ptWs->iFd == ptPush->iFd) &&
+        (HTTPD_WS_CLIENT_WEBSOCKET == httpd_ws_get_fd_info(ptPush->hServer, ptPush->iFd)))
+    {
+        if (!auth_session_is_valid(ptWs->acToken))
+        {
+            uint8_t aucCode[2] = { (uint8_t)(WS_CLOSE_UNAUTHORIZED >> 8), (uint8_t)(WS_CLOSE_UNAUTHORIZED & 0xFF) };
+            httpd_ws_frame_t tClose = { .final = true, .type = HTTPD_WS_TYPE_CLOSE, .payload = aucCode, .len = 2 };
+            (void)httpd_ws_send_frame_async(ptPush->hServer, ptPush->iFd, &tClose);
+            bClose = true;
+        }
+        else
+        {
+            httpd_ws_frame_t tFrame = {
+                .final   = true,
+                .type    = ptPush->eType,
+                .payload = ptPush->aucData,
+                .len     = ptPush->ulLen,
+            };
+            err    = httpd_ws_send_frame_async(ptPush->hServer, ptPush->iFd, &tFrame);
+            bClose = (ESP_OK != err);
+        }
+    }
+
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    if (ptWs->iFd == ptPush->iFd)
+    {
+        ptWs->bInFlight = false;
+        if (ESP_OK == err) ptWs->llLastSendUs = esp_timer_get_time();
+    }
+    xSemaphoreGive(ptRsc->hMutex);
+
+    if (bClose)
+    {
+        httpd_sess_trigger_close(ptPush->hServer, ptPush->iFd);
+    }
+    free(ptPush);
+}
+
+/* Hand one frame to the server task (push task context). The slot is
+   already marked in flight; on failure the events go back to pending. */
+static void
+events_WsQueue(EVENTS_API_RSC_T* ptRsc, size_t ulSlot, httpd_handle_t hServer, int iFd, uint32_t ulMask,
+               httpd_ws_type_t eType, const uint8_t* pucData, size_t ulLen)
+{
+    EVENTS_WS_PUSH_T* ptPush = (EVENTS_WS_PUSH_T*)malloc(sizeof(EVENTS_WS_PUSH_T));
+    if (NULL != ptPush)
+    {
+        ptPush->ptRsc   = ptRsc;
+        ptPush->ulSlot  = ulSlot;
+        ptPush->hServer = hServer;
+        ptPush->iFd     = iFd;
+        ptPush->eType   = eType;
+        ptPush->ulLen   = ulLen;
+        if (ulLen > 0) memcpy(ptPush->aucData, pucData, ulLen);
+
+        if (ESP_OK == httpd_queue_work(hServer, events_WsPushWork, ptPush))
+        {
+            return;
+        }
+        free(ptPush);
+    }
+
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    if (ptRsc->atWs[ulSlot].iFd == iFd)
+    {
+        ptRsc->atWs[ulSlot].bInFlight  = false;
+        ptRsc->atWs[ulSlot].ulPending |= ulMask;
+    }
+    xSemaphoreGive(ptRsc->hMutex);
+}
+
+/* Session context destructor: the server calls it when a /ws socket closes. */
+static void
+events_WsFreeCtx(void* pvCtx)
+{
+    EVENTS_WS_CLIENT_T* ptWs  = (EVENTS_WS_CLIENT_T*)pvCtx;
+    EVENTS_API_RSC_T*   ptRsc = ptWs->ptRsc;
+
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    memset(ptWs, 0, sizeof(EVENTS_WS_CLIENT_T));
+    ptWs->ptRsc = ptRsc;
+    ptWs->iFd   = -1;
+    ptRsc->ulWsCount--;
+    uint32_t ulLeft = ptRsc->ulWsCount;
+    xSemaphoreGive(ptRsc->hMutex);
+
+    ESP_LOGI(TAG, "WebSocket closed (%lu open)", (unsigned long)ulLeft);
+}
+
+/* Send a close frame; returning ESP_FAIL afterwards makes the server drop the socket. */
+static esp_err_t
+events_WsClose(httpd_req_t* ptReq, uint16_t usCode)
+{
+    uint8_t aucCode[2] = { (uint8_t)(usCode >> 8), (uint8_t)(usCode & 0xFF) };
+    httpd_ws_frame_t tFrame = { .final = true, .type = HTTPD_WS_TYPE_CLOSE, .payload = aucCode, .len = 2 };
+    (void)httpd_ws_send_frame(ptReq, &tFrame);
+    return ESP_FAIL;
+}
+
+static esp_err_t
+events_WsReply(httpd_req_t* ptReq, uint8_t ucOp, uint8_t ucSeq, uint8_t ucStatus)
+{
+    uint8_t aucReply[3] = { (uint8_t)(ucOp | WS_REPLY), ucSeq, ucStatus };
+    httpd_ws_frame_t tFrame = { .final = true, .type = HTTPD_WS_TYPE_BINARY, .payload = aucReply, .len = sizeof(aucReply) };
+    return httpd_ws_send_frame(ptReq, &tFrame);
+}
+
+static esp_err_t
+events_WsSendStatus(httpd_req_t* ptReq, EVENTS_API_RSC_T* ptRsc)
+{
+    EVENTS_SNAPSHOT_T tSnap;
+    uint8_t           aucFrame[WS_STATUS_MAX_LEN];
+
+    events_Snapshot(ptRsc, &tSnap);
+    httpd_ws_frame_t tFrame = {
+        .final   = true,
+        .type    = HTTPD_WS_TYPE_BINARY,
+        .payload = aucFrame,
+        .len     = events_WsEncodeStatus(&tSnap, EVENT_ALL, aucFrame),
+    };
+    return httpd_ws_send_frame(ptReq, &tFrame);
+}
+
+/* Browsers attach cookies to cross-origin WebSocket upgrades and do not
+   apply CORS, so a page served from elsewhere is refused by Origin. */
+static bool
+events_WsOriginOk(httpd_req_t* ptReq)
+{
+    char acOrigin[96];
+    char acHost[64];
+
+    if (ESP_OK != httpd_req_get_hdr_value_str(ptReq, "Origin", acOrigin, sizeof(acOrigin)))
+    {
+        return true;    /* not a browser */
+    }
+    if (ESP_OK != httpd_req_get_hdr_value_str(ptReq, "Host", acHost, sizeof(acHost)))
+    {
+        return false;
+    }
+
+    const char* pcOriginHost = strstr(acOrigin, "://");
+    return (NULL != pcOriginHost) && (strcmp(pcOriginHost + 3, acHost) == 0);
+}
+
+/* Upgrade request. The server has already answered the handshake, so a
+   refusal is a close frame rather than a 401. */
+static esp_err_t
+events_WsOpen(httpd_req_t* ptReq)
+{
+    EVENTS_API_RSC_T* ptRsc  = (EVENTS_API_RSC_T*)ptReq->user_ctx;
+    const char*       pcUser = NULL;
+    char              acToken[AUTH_SESSION_TOKEN_LEN + 1];
+
+    if (!events_WsOriginOk(ptReq) || (ESP_OK != auth_get_session(ptReq, acToken, &pcUser, NULL)))
+    {
+        ESP_LOGW(TAG, "WebSocket refused: no valid session");
+        return events_WsClose(ptReq, WS_CLOSE_UNAUTHORIZED);
+    }
+
+    EVENTS_WS_CLIENT_T* ptWs = NULL;
+
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+    for (size_t i = 0; i < EVENTS_MAX_WS_CLIENTS; i++)
+    {
+        if (ptRsc->atWs[i].iFd < 0)
+        {
+            ptWs = &ptRsc->atWs[i];
+            ptWs->hServer      = ptReq->handle;
+            ptWs->iFd          = httpd_req_to_sockfd(ptReq);
+            ptWs->ucSubscribed = 0;
+            ptWs->ulPending    = 0;
+            ptWs->bInFlight    = false;
+            ptWs->llLastSendUs = esp_timer_get_time();
+            memcpy(ptWs->acToken, acToken, sizeof(ptWs->acToken));
+            strlcpy(ptWs->acUser, pcUser, sizeof(ptWs->acUser));
+            ptRsc->ulWsCount++;
+            break;
+        }
+    }
+    uint32_t ulOpen = ptRsc->ulWsCount;
+    xSemaphoreGive(ptRsc->hMutex);
+
+    if (NULL == ptWs)
+    {
+        ESP_LOGW(TAG, "WebSocket refused: %d already open", EVENTS_MAX_WS_CLIENTS);
+        return events_WsClose(ptReq, WS_CLOSE_TRY_AGAIN);
+    }
+
+    ptReq->sess_ctx = ptWs;
+    ptReq->free_ctx = events_WsFreeCtx;
+
+    struct timeval tTimeout = { .tv_sec = EVENTS_SEND_TIMEOUT_SEC, .tv_usec = 0 };
+    (void)setsockopt(ptWs->iFd, SOL_SOCKET, SO_SNDTIMEO, &tTimeout, sizeof(tTimeout));
+
+    ESP_LOGI(TAG, "WebSocket opened by %s (%lu/%d)", ptWs->acUser, (unsigned long)ulOpen, EVENTS_MAX_WS_CLIENTS);
+    xTaskNotifyGive(ptRsc->hTask);
+    return ESP_OK;
+}
+
+/* Execute one command frame; returns a WS_ST_* code. */
+static uint8_t
+events_WsCommand(EVENTS_API_RSC_T* ptRsc, EVENTS_WS_CLIENT_T* ptWs, uint8_t ucOp,
+                 const uint8_t* pucArg, size_t ulArgs)
+{
+    switch (ucOp)
+    {
+        case WS_OP_SUBSCRIBE:
+        {
+            if (ulArgs < 1) return WS_ST_BAD_REQUEST;
+            xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+            ptWs->ucSubscribed = (uint8_t)(pucArg[0] & EVENT_ALL);
+            ptWs->ulPending    = 0;     /* the reply carries the full status */
+            xSemaphoreGive(ptRsc->hMutex);
+            return WS_ST_OK;
+        }
+
+        case WS_OP_STATUS:
+        case WS_OP_PING:
+            return WS_ST_OK;
+
+        case WS_OP_TEST_RING:
+        {
+            uint32_t ulDuration = ((ulArgs >= 1) && (pucArg[0] != 0)) ? pucArg[0] : 3;
+            if (ulDuration > 30) return WS_ST_BAD_REQUEST;
+            if (RingBell_IsPanic()) return WS_ST_CONFLICT;
+
+            ESP_LOGI(TAG, "Test bell for %lu seconds (by %s, ws)", (unsigned long)ulDuration, ptWs->acUser);
+            if (RingBell_RunForDuration(ulDuration) != ESP_OK) return WS_ST_FAILED;
+            Bell_Log_Record(BELL_SOURCE_TEST, (uint16_t)ulDuration);
+            return WS_ST_OK;
+        }
+
+        case WS_OP_PANIC:
+        {
+            if ((ulArgs < 1) || (pucArg[0] > 1)) return WS_ST_BAD_REQUEST;
+            bool bEnable = (pucArg[0] == 1);
+
+            ESP_LOGW(TAG, "Panic mode %s by user %s (ws)", bEnable ? "ENABLED" : "DISABLED", ptWs->acUser);
+            if (RingBell_SetPanic(bEnable) != ESP_OK) return WS_ST_FAILED;
+            if (bEnable) Bell_Log_Record(BELL_SOURCE_PANIC, 0);
+            return WS_ST_OK;
+        }
+
+        case WS_OP_TODAY:
+        {
+            if (ulArgs < 1) return WS_ST_BAD_REQUEST;
+
+            esp_err_t err;
+            if (WS_TODAY_CANCEL == pucArg[0])                  err = TS_Schedule_CancelTodayOverride();
+            else if (EXCEPTION_ACTION_DAY_OFF == pucArg[0])    err = TS_Schedule_SetTodayOverride(EXCEPTION_ACTION_DAY_OFF);
+            else if (EXCEPTION_ACTION_NORMAL == pucArg[0])     err = TS_Schedule_SetTodayOverride(EXCEPTION_ACTION_NORMAL);
+            else return WS_ST_BAD_REQUEST;
+
+            ESP_LOGI(TAG, "Today override %u by %s (ws): %s", (unsigned)pucArg[0], ptWs->acUser, esp_err_to_name(err));
+            return (ESP_OK == err) ? WS_ST_OK : WS_ST_FAILED;
+        }
+
+        default:
+            return WS_ST_UNKNOWN_OP;
+    }
+}
+
+/* ================================================================== */
+/* GET /ws                                                             */
+/* ================================================================== */
+
+static esp_err_t
+handler_Ws(httpd_req_t* ptReq)
+{
+    if (HTTP_GET == ptReq->method)
+    {
+        return events_WsOpen(ptReq);
+    }
+
+    EVENTS_API_RSC_T*   ptRsc = (EVENTS_API_RSC_T*)ptReq->user_ctx;
+    EVENTS_WS_CLIENT_T* ptWs  = (EVENTS_WS_CLIENT_T*)ptReq->sess_ctx;
+    uint8_t             aucCmd[WS_CMD_MAX_LEN];
+    httpd_ws_frame_t    tFrame = { 0 };
+
+    /* Length first: a frame larger than any command is not ours, and
+       leaving it unread would desync the socket, so drop the client. */
+    esp_err_t err = httpd_ws_recv_frame(ptReq, &tFrame, 0);
+    if ((ESP_OK != err) || (tFrame.len > sizeof(aucCmd))) return ESP_FAIL;
+
+    if (tFrame.len > 0)
+    {
+        tFrame.payload = aucCmd;
+        err = httpd_ws_recv_frame(ptReq, &tFrame, sizeof(aucCmd));
+        if (ESP_OK != err) return ESP_FAIL;
+    }
+
+    if ((HTTPD_WS_TYPE_BINARY != tFrame.type) || (tFrame.len < 2))
+    {
+        return events_WsReply(ptReq, 0, 0, WS_ST_BAD_REQUEST);
+    }
+
+    uint8_t ucOp  = aucCmd[0];
+    uint8_t ucSeq = aucCmd[1];
+
+    /* The upgrade was authenticated; re-check so logout or expiry also
+       ends the socket's authority. */
+    if ((NULL == ptWs) || !auth_session_is_valid(ptWs->acToken))
+    {
+        (void)events_WsReply(ptReq, ucOp, ucSeq, WS_ST_UNAUTHORIZED);
+        return events_WsClose(ptReq, WS_CLOSE_UNAUTHORIZED);
+    }
+
+    uint8_t ucStatus = events_WsCommand(ptRsc, ptWs, ucOp, &aucCmd[2], tFrame.len - 2);
+
+    err = events_WsReply(ptReq, ucOp, ucSeq, ucStatus);
+    if ((ESP_OK == err) && (WS_ST_OK == ucStatus) &&
+        ((WS_OP_STATUS == ucOp) || ((WS_OP_SUBSCRIBE == ucOp) && (0 != ptWs->ucSubscribed))))
+    {
+        err = events_WsSendStatus(ptReq, ptRsc);
+    }
+
+    /* State-changing commands: push to every subscriber now, not at the next poll */
+    if ((WS_OP_TEST_RING == ucOp) || (WS_OP_PANIC == ucOp) || (WS_OP_TODAY == ucOp))
+    {
+        xTaskNotifyGive(ptRsc->hTask);
+    }
+
+    return err;
+}
+
+/* ------------------------------------------------------------------ */
+/* Push task                                                           */
+/* ------------------------------------------------------------------ */
+static void
+events_Task(void* pvArg)
+{
+    EVENTS_API_RSC_T* ptRsc = (EVENTS_API_RSC_T*)pvArg;
+    static char acBuf[EVENTS_BUF_SIZE];
+
+    for (;;)
+    {
+        /* Idle until someone subscribes; then sample the state every poll period.
+           The handler notifies on subscribe so the first frame goes out at once. */
+        bool       bAny  = (ptRsc->ulClientCount + ptRsc->ulWsCount) > 0;
+        TickType_t tWait = bAny ? pdMS_TO_TICKS(EVENTS_POLL_MS) : portMAX_DELAY;
+        (void)ulTaskNotifyTake(pdTRUE, tWait);
+
+        EVENTS_SNAPSHOT_T tNow;
+        events_Snapshot(ptRsc, &tNow);
+        uint32_t ulChanged = events_Diff(&ptRsc->tLast, &tNow);
+        ptRsc->tLast = tNow;
+
+        int64_t llNowUs = esp_timer_get_time();
+
+        for (size_t i = 0; i < EVENTS_MAX_CLIENTS; i++)
+        {
+            xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+            EVENTS_CLIENT_T* ptClient = &ptRsc->atClient[i];
+            httpd_req_t* ptReq   = ptClient->ptReq;
+            uint32_t     ulMask  = ptClient->ulPending | ulChanged;
+            bool         bFirst  = ptClient->bFirst;
+            bool         bBeat   = (llNowUs - ptClient->llLastSendUs) >= EVENTS_HEARTBEAT_US;
+            ptClient->ulPending = 0;
+            xSemaphoreGive(ptRsc->hMutex);
+
+            if (NULL == ptReq) continue;
+
+            /* As for /ws: logout or expiry ends the stream. The browser's
+               reconnect is then refused with 401. */
+            if (!auth_session_is_valid(ptClient->acToken))
+            {
+                events_Drop(ptRsc, i);
+                continue;
+            }
+
+            if ((0 == ulMask) && !bBeat) continue;
+
+            size_t ulLen = (0 != ulMask)
+                         ? events_Format(&tNow, ulMask, bFirst, acBuf, sizeof(acBuf))
+                         : (size_t)snprintf(acBuf, sizeof(acBuf), ": ping\n\n");
+            if (0 == ulLen)
+            {
+                ESP_LOGE(TAG, "Event frame exceeds %d bytes", EVENTS_BUF_SIZE);
+                continue;
+            }
+
+            /* The socket send timeout is short, so a stalled client fails
+               here instead of holding up everyone else. */
+            if (ESP_OK != httpd_resp_send_chunk(ptReq, acBuf, (ssize_t)ulLen))
+            {
+                events_Drop(ptRsc, i);
+                continue;
+            }
+
+            xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+            ptClient->bFirst       = false;
+            ptClient->llLastSendUs = llNowUs;
+            xSemaphoreGive(ptRsc->hMutex);
+        }
+
+        /* WebSocket frames are written by the server task (events_WsPushWork).
+           One frame per client is in flight at a time; while it is, changes
+           collect in ulPending and go out together in the next one. */
+        for (size_t i = 0; i < EVENTS_MAX_WS_CLIENTS; i++)
+        {
+            xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+            EVENTS_WS_CLIENT_T* ptWs    = &ptRsc->atWs[i];
+            httpd_handle_t      hServer = ptWs->hServer;
+            int                 iFd     = ptWs->iFd;
+            uint32_t            ulMask  = (ptWs->ulPending | ulChanged) & ptWs->ucSubscribed;
+            bool                bBeat   = (llNowUs - ptWs->llLastSendUs) >= EVENTS_HEARTBEAT_US;
+            bool                bSend   = (iFd >= 0) && !ptWs->bInFlight && ((0 != ulMask) || bBeat);
+            if (bSend)
+            {
+                ptWs->ulPending = 0;
+                ptWs->bInFlight = true;
+            }
+            else if (iFd >= 0)
+            {
+                ptWs->ulPending = ulMask;
+            }
+            xSemaphoreGive(ptRsc->hMutex);
+
+            if (!bSend) continue;
+
+            if (0 != ulMask)
+            {
+                uint8_t aucFrame[WS_STATUS_MAX_LEN];
+                size_t  ulLen = events_WsEncodeStatus(&tNow, ulMask, aucFrame);
+                events_WsQueue(ptRsc, i, hServer, iFd, ulMask, HTTPD_WS_TYPE_BINARY, aucFrame, ulLen);
+            }
+            else
+            {
+                events_WsQueue(ptRsc, i, hServer, iFd, 0, HTTPD_WS_TYPE_PING, NULL, 0);
+            }
+        }
+    }
+}
+
+/* ================================================================== */
+/* GET /api/events                                                     */
+/* ================================================================== */
+
+static esp_err_t
+handler_GetEvents(httpd_req_t* ptReq)
+{
+    EVENTS_API_RSC_T* ptRsc = (EVENTS_API_RSC_T*)ptReq->user_ctx;
+
+    if (auth_require_session(ptReq, NULL, NULL) != ESP_OK) return ESP_OK;
+
+    /* Kept for the push task's re-check; left empty (and so dropped on the
+       first poll) if the session ended in between */
+    char acToken[AUTH_SESSION_TOKEN_LEN + 1] = "";
+    (void)auth_get_session(ptReq, acToken, NULL, NULL);
+
+    xSemaphoreTake(ptRsc->hMutex, portMAX_DELAY);
+
+    int iSlot = -1;
+    for (size_t i = 0; i < EVENTS_MAX_CLIENTS; i++)
+    {
+        if (NULL == ptRsc->atClient[i].ptReq)
+        {
+            iSlot = (int)i;
+            break;
+        }
+    }
+
+    /* Keep the request open past this handler: the copy is sent on by the
+       push task and the socket is not read again until it completes. */
+    httpd_req_t* ptAsync = NULL;
+    esp_err_t    err     = (iSlot < 0) ? ESP_ERR_NOT_FOUND
+                                       : httpd_req_async_handler_begin(ptReq, &ptAsync);
+    if (ESP_OK == err)
+    {
+        EVENTS_CLIENT_T* ptClient = &ptRsc->atClient[iSlot];
+        ptClient->ptReq        = ptAsync;
+        ptClient->ulPending    = EVENT_ALL;
+        ptClient->bFirst       = true;
+        ptClient->llLastSendUs = esp_timer_get_time();
+        memcpy(ptClient->acToken, acToken, sizeof(ptClient->acToken));
+        ptRsc->ulClientCount++;
+    }
+    uint32_t ulOpen = ptRsc->ulClientCount;
+
+    xSemaphoreGive(ptRsc->hMutex);
+
+    if (ESP_OK != err)
+    {
+        auth_set_security_headers(ptReq);
+        httpd_resp_set_status(ptReq, "503 Service Unavailable");
+        httpd_resp_set_hdr(ptReq, "Retry-After", "10");
+        return httpd_resp_sendstr(ptReq, (iSlot < 0) ? "{\"error\":\"Too many event streams\"}"
+                                                     : "{\"error\":\"Out of memory\"}");
+    }
+
+    httpd_resp_set_type(ptAsync, "text/event-stream");
+    httpd_resp_set_hdr(ptAsync, "Cache-Control", "no-cache");
+    httpd_resp_set_hdr(ptAsync, "X-Content-Type-Options", "nosniff");
+
+    struct timeval tTimeout = { .tv_sec = EVENTS_SEND_TIMEOUT_SEC, .tv_usec = 0 };
+    (void)setsockopt(httpd_req_to_sockfd(ptAsync), SOL_SOCKET, SO_SNDTIMEO, &tTimeout, sizeof(tTimeout));
+
+    ESP_LOGI(TAG, "Event stream opened (%lu/%d)", (unsigned long)ulOpen, EVENTS_MAX_CLIENTS);
+    xTaskNotifyGive(ptRsc->hTask);
+    return ESP_OK;
+}
+
+/* ================================================================== */
+/* Init & Register                                                     */
+/* ================================================================== */
+
+esp_err_t
+EventsAPI_Init(const EVENTS_API_PARAMS_T* ptParams, EVENTS_API_H* phApi)
+{
+    if ((NULL == ptParams) || (NULL == phApi)) return ESP_ERR_INVALID_ARG;
+
+    EVENTS_API_RSC_T* ptRsc = (EVENTS_API_RSC_T*)calloc(1, sizeof(EVENTS_API_RSC_T));
+    if (NULL == ptRsc) return ESP_ERR_NO_MEM;
+
+    ptRsc->hScheduler = ptParams->hScheduler;
+    for (size_t i = 0; i < EVENTS_MAX_WS_CLIENTS; i++)
+    {
+        ptRsc->atWs[i].ptRsc = ptRsc;
+        ptRsc->atWs[i].iFd   = -1;
+    }
+
+    ptRsc->hMutex = xSemaphoreCreateMutex();
+    if (NULL == ptRsc->hMutex)
+    {
+        free(ptRsc);
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t xResult = xTaskCreate(events_Task, "WS_EVENTS",
+                                     EVENTS_TASK_STACK_SIZE,
+                                     ptRsc,
+                                     EVENTS_TASK_PRIORITY,
+                                     &ptRsc->hTask);
+    if (pdPASS != xResult)
+    {
+        vSemaphoreDelete(ptRsc->hMutex);
+        free(ptRsc);
+        return ESP_FAIL;
+    }
+
+    *phApi = ptRsc;
+    return ESP_OK;
+}
+
+esp_err_t
+EventsAPI_Register(EVENTS_API_H hApi, httpd_handle_t hHttpServer)
+{
+    if ((NULL == hApi) || (NULL == hHttpServer)) return ESP_ERR_INVALID_ARG;
+
+    const httpd_uri_t tEvents = {
+        .uri      = "/api/events",
+        .method   = HTTP_GET,
+        .handler  = handler_GetEvents,
+        .user_ctx = hApi,
+    };
+    const httpd_uri_t tWs = {
+        .uri                      = "/ws",
+        .method                   = HTTP_GET,
+        .handler                  = handler_Ws,
+        .user_ctx                 = hApi,
+        .is_websocket             = true,
+        .handle_ws_control_frames = false,
+    };
+
+    /* Not wrapped by WS_Metrics: both are connections that stay open for
+       minutes, so a per-request latency would be meaningless */
+    esp_err_t err = httpd_register_uri_handler(hHttpServer, &tEvents);
+    if (ESP_OK == err)
+    {
+        err = httpd_register_uri_handler(hHttpServer, &tWs);
+    }
+    if (ESP_OK == err)
+    {
+        ESP_LOGI(TAG, "Event stream registered: GET /api/events (max %d clients), /ws (max %d clients)",
+                 EVENTS_MAX_CLIENTS, EVENTS_MAX_WS_CLIENTS);
+    }
+    return err;
+}
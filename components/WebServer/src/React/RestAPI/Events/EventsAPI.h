@@ -0,0 +1,24 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "Scheduler_API.h"
+
+typedef struct _EVENTS_API_RSC_T* EVENTS_API_H;
+
+typedef struct
+{
+    SCHEDULER_H hScheduler;
+} EVENTS_API_PARAMS_T;
+
+/**
+ * @brief Initialise the event stream resource and start the push task.
+ *        The task sleeps until the first client subscribes.
+ */
+esp_err_t EventsAPI_Init(const EVENTS_API_PARAMS_T* ptParams, EVENTS_API_H* phApi);
+
+/**
+ * @brief Register GET /api/events (Server-Sent Events).
+ */
+esp_err_t EventsAPI_Register(EVENTS_API_H hApi, httpd_handle_t hHttpServer);
+
@@ -5,6 +5,7 @@
 
 #include "esp_log.h"
 #include "cJSON.h"
+#include "WS_Metrics.h"
 
 static const char* TAG = "EXAMPLE_API";
 
@@ -68,7 +69,7 @@ esp_err_t ExampleAPI_Register(EXAMPLE_API_H hExampleApi, httpd_handle_t hHttpSer
         .user_ctx = ptRsc
     };
 
-    esp_err_t espErr = httpd_register_uri_handler(hHttpServer, &tGetModeUri);
+    esp_err_t espErr = WS_Metrics_RegisterUri(hHttpServer, &tGetModeUri);
 
     if (ESP_OK == espErr)
     {
@@ -80,7 +81,7 @@ esp_err_t ExampleAPI_Register(EXAMPLE_API_H hExampleApi, httpd_handle_t hHttpSer
             .user_ctx = ptRsc
         };
 
-        espErr = httpd_register_uri_handler(hHttpServer, &tPostModeUri);
+        espErr = WS_Metrics_RegisterUri(hHttpServer, &tPostModeUri);
     }
 
     if (ESP_OK == espErr)
@@ -107,7 +108,7 @@ static esp_err_t ws_React_GetMode(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, json);
 
     cJSON_Delete(ptJsonRoot);
-    free((void*)json);
+    cJSON_free((void*)json);
 
     return ESP_OK;
 }
@@ -154,7 +155,7 @@ static esp_err_t ws_React_PostMode(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, json);
 
     cJSON_Delete(resp);
-    free((void*)json);
+    cJSON_free((void*)json);
 
     return ESP_OK;
 }
@@ -0,0 +1,339 @@
+/* ================================================================== */
+/* LogsAPI.c — GET /api/logs, GET/POST /api/logs/levels                */
+/* Service-role only: reads the in-RAM log ring and sets tag levels.   */
+/* ================================================================== */
+#include "LogsAPI.h"
+#include "LogRing_API.h"
+#include "Auth/WS_Auth.h"
+#include "WS_Body.h"
+#include "WS_Arena.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "LOGS_API";
+
+#define LOGS_BODY_MAX           128
+#define LOGS_DEFAULT_LIMIT      100
+#define LOGS_MAX_LIMIT          200     /* keeps one response inside the request arena */
+
+/* ------------------------------------------------------------------ */
+/* Resource struct                                                     */
+/* ------------------------------------------------------------------ */
+typedef struct _LOGS_API_RSC_T
+{
+    int reserved;
+} LOGS_API_RSC_T;
+
+typedef struct
+{
+    cJSON           *ptEntries;
+    uint32_t         ulCount;
+    uint32_t         ulLimit;
+    esp_log_level_t  eMinLevel;     /* least severe level included */
+} LOGS_COLLECT_T;
+
+/* ------------------------------------------------------------------ */
+/* Forward declarations                                                */
+/* ------------------------------------------------------------------ */
+static esp_err_t handler_GetLogs(httpd_req_t *ptReq);
+static esp_err_t handler_GetLevels(httpd_req_t *ptReq);
+static esp_err_t handler_PostLevels(httpd_req_t *ptReq);
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+static esp_err_t
+sendJson(httpd_req_t *ptReq, cJSON *ptRoot)
+{
+    const char *pcJson = cJSON_PrintUnformatted(ptRoot);
+    auth_set_security_headers(ptReq);
+    httpd_resp_sendstr(ptReq, pcJson);
+    cJSON_free((void *)pcJson);
+    cJSON_Delete(ptRoot);
+    return ESP_OK;
+}
+
+static esp_err_t
+sendError(httpd_req_t *ptReq, const char *pcStatus, const char *pcMsg)
+{
+    cJSON *ptRoot = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptRoot, "error", pcMsg);
+    const char *pcJson = cJSON_PrintUnformatted(ptRoot);
+    auth_set_security_headers(ptReq);
+    httpd_resp_set_status(ptReq, pcStatus);
+    httpd_resp_sendstr(ptReq, pcJson);
+    cJSON_free((void *)pcJson);
+    cJSON_Delete(ptRoot);
+    return ESP_OK;
+}
+
+/**
+ * @brief Require service role + CSRF check for mutating requests.
+ */
+static bool
+requireServiceAccess(httpd_req_t *ptReq)
+{
+    auth_set_security_headers(ptReq);
+
+    if ((ptReq->method == HTTP_POST || ptReq->method == HTTP_PUT || ptReq->method == HTTP_DELETE)
+        && !auth_csrf_check(ptReq)) {
+        return false;
+    }
+
+    return (auth_require_role(ptReq, "service", NULL, NULL) == ESP_OK);
+}
+
+static uint32_t
+queryU32(const char *pcQuery, const char *pcKey, uint32_t ulDefault)
+{
+    char acVal[16];
+    if (httpd_query_key_value(pcQuery, pcKey, acVal, sizeof(acVal)) != ESP_OK) return ulDefault;
+
+    char *pcEnd = NULL;
+    unsigned long ulVal = strtoul(acVal, &pcEnd, 10);
+    return (pcEnd != acVal && *pcEnd == '\0') ? (uint32_t)ulVal : ulDefault;
+}
+
+static esp_log_level_t
+levelFromChar(char cLevel)
+{
+    switch (cLevel)
+    {
+        case 'E': return ESP_LOG_ERROR;
+        case 'W': return ESP_LOG_WARN;
+        case 'D': return ESP_LOG_DEBUG;
+        case 'V': return ESP_LOG_VERBOSE;
+        default:  return ESP_LOG_INFO;
+    }
+}
+
+static bool
+collectEntry(const LOG_RING_ENTRY_T *ptEntry, void *pvCtx)
+{
+    LOGS_COLLECT_T *ptCollect = (LOGS_COLLECT_T *)pvCtx;
+
+    if (levelFromChar(ptEntry->cLevel) > ptCollect->eMinLevel) return true;
+
+    cJSON *ptItem = cJSON_CreateObject();
+    cJSON_AddNumberToObject(ptItem, "seq", (double)ptEntry->ulSeq);
+    cJSON_AddNumberToObject(ptItem, "timeMs", (double)ptEntry->ulTimeMs);
+    cJSON_AddStringToObject(ptItem, "level", LogRing_LevelToStr(levelFromChar(ptEntry->cLevel)));
+    cJSON_AddStringToObject(ptItem, "tag", ptEntry->pcTag);
+    cJSON_AddStringToObject(ptItem, "msg", ptEntry->pcMsg);
+    cJSON_AddItemToArray(ptCollect->ptEntries, ptItem);
+
+    return (++ptCollect->ulCount < ptCollect->ulLimit);
+}
+
+/* ------------------------------------------------------------------ */
+/* Init                                                                */
+/* ------------------------------------------------------------------ */
+esp_err_t
+LogsAPI_Init(const LOGS_API_PARAMS_T *ptParams, LOGS_API_H *phApi)
+{
+    (void)ptParams;
+
+    if (phApi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    LOGS_API_RSC_T *ptRsc = (LOGS_API_RSC_T *)calloc(1, sizeof(LOGS_API_RSC_T));
+    if (ptRsc == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    *phApi = ptRsc;
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Register                                                            */
+/* ------------------------------------------------------------------ */
+esp_err_t
+LogsAPI_Register(LOGS_API_H hApi, httpd_handle_t hHttpServer)
+{
+    if (hApi == NULL || hHttpServer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    LOGS_API_RSC_T *ptRsc = (LOGS_API_RSC_T *)hApi;
+
+    const httpd_uri_t atUris[] = {
+        { "/api/logs",        HTTP_GET,  handler_GetLogs,    ptRsc },
+        { "/api/logs/levels", HTTP_GET,  handler_GetLevels,  ptRsc },
+        { "/api/logs/levels", HTTP_POST, handler_PostLevels, ptRsc },
+    };
+
+    for (size_t i = 0; i < sizeof(atUris) / sizeof(atUris[0]); i++)
+    {
+        esp_err_t err = WS_Arena_RegisterUri(hHttpServer, &atUris[i]);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to register %s %s",
+                     http_method_str(atUris[i].method), atUris[i].uri);
+            return err;
+        }
+    }
+
+    ESP_LOGI(TAG, "Logs API registered: GET /api/logs, GET/POST /api/logs/levels");
+    return ESP_OK;
+}
+
+/* ================================================================== */
+/* GET /api/logs?since=<seq>&limit=<n>&level=<name>                    */
+/* Returns: { "first", "last", "next", "lost", "more", "entries": [] } */
+/* ================================================================== */
+static esp_err_t
+handler_GetLogs(httpd_req_t *ptReq)
+{
+    if (!requireServiceAccess(ptReq))
+    {
+        return ESP_OK;
+    }
+
+    LOG_RING_STATS_T tStats;
+    LogRing_GetStats(&tStats);
+    if (0 == tStats.ulCapacity)
+    {
+        return sendError(ptReq, "503 Service Unavailable", "Log ring not running");
+    }
+
+    uint32_t ulSince = 0;
+    LOGS_COLLECT_T tCollect = {
+        .ulLimit   = LOGS_DEFAULT_LIMIT,
+        .eMinLevel = ESP_LOG_VERBOSE,
+    };
+
+    char acQuery[96];
+    if (httpd_req_get_url_query_str(ptReq, acQuery, sizeof(acQuery)) == ESP_OK)
+    {
+        ulSince          = queryU32(acQuery, "since", ulSince);
+        tCollect.ulLimit = queryU32(acQuery, "limit", tCollect.ulLimit);
+
+        char acLevel[16];
+        if ((httpd_query_key_value(acQuery, "level", acLevel, sizeof(acLevel)) == ESP_OK) &&
+            !LogRing_LevelFromStr(acLevel, &tCollect.eMinLevel))
+        {
+            return sendError(ptReq, "400 Bad Request", "Unknown level");
+        }
+    }
+    if (tCollect.ulLimit == 0 || tCollect.ulLimit > LOGS_MAX_LIMIT) tCollect.ulLimit = LOGS_MAX_LIMIT;
+
+    cJSON *ptRoot = cJSON_CreateObject();
+    tCollect.ptEntries = cJSON_CreateArray();
+
+    /* The visitor stops at the limit; lines below the level filter are
+     * skipped without counting, so "next" always moves forward */
+    uint32_t ulNext = LogRing_Read(ulSince, UINT32_MAX, collectEntry, &tCollect);
+
+    /* Lines between "since" and the oldest one still held were overwritten */
+    uint32_t ulLost = ((0 != tStats.ulFirstSeq) && (ulSince + 1 < tStats.ulFirstSeq))
+                    ? tStats.ulFirstSeq - ulSince - 1 : 0;
+
+    cJSON_AddNumberToObject(ptRoot, "first", (double)tStats.ulFirstSeq);
+    cJSON_AddNumberToObject(ptRoot, "last", (double)tStats.ulLastSeq);
+    cJSON_AddNumberToObject(ptRoot, "next", (double)ulNext);
+    cJSON_AddNumberToObject(ptRoot, "lost", (double)ulLost);
+    cJSON_AddBoolToObject(ptRoot, "more", tCollect.ulCount >= tCollect.ulLimit);
+    cJSON_AddItemToObject(ptRoot, "entries", tCollect.ptEntries);
+
+    return sendJson(ptReq, ptRoot);
+}
+
+/* ================================================================== */
+/* GET /api/logs/levels                                                */
+/* Returns: { "default": "info", "maximum": "info", "tags": {...},     */
+/*            "ring": {...} }                                          */
+/* ================================================================== */
+static esp_err_t
+handler_GetLevels(httpd_req_t *ptReq)
+{
+    if (!requireServiceAccess(ptReq))
+    {
+        return ESP_OK;
+    }
+
+    LOG_RING_LEVEL_T atLevels[LOG_RING_MAX_TAG_LEVELS];
+    uint32_t ulCount = LogRing_GetLevels(atLevels, LOG_RING_MAX_TAG_LEVELS);
+
+    LOG_RING_STATS_T tStats;
+    LogRing_GetStats(&tStats);
+
+    cJSON *ptRoot = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptRoot, "default", LogRing_LevelToStr(atLevels[0].eLevel));
+    cJSON_AddStringToObject(ptRoot, "maximum", LogRing_LevelToStr((esp_log_level_t)CONFIG_LOG_MAXIMUM_LEVEL));
+
+    cJSON *ptTags = cJSON_AddObjectToObject(ptRoot, "tags");
+    for (uint32_t i = 1; i < ulCount; i++)
+    {
+        cJSON_AddStringToObject(ptTags, atLevels[i].acTag, LogRing_LevelToStr(atLevels[i].eLevel));
+    }
+
+    cJSON *ptRing = cJSON_AddObjectToObject(ptRoot, "ring");
+    cJSON_AddNumberToObject(ptRing, "capacity", (double)tStats.ulCapacity);
+    cJSON_AddNumberToObject(ptRing, "used", (double)tStats.ulUsed);
+    cJSON_AddNumberToObject(ptRing, "textLines", (double)tStats.ulTextRecords);
+    cJSON_AddNumberToObject(ptRing, "uartSkipped", (double)tStats.ulUartSkipped);
+
+    return sendJson(ptReq, ptRoot);
+}
+
+/* ================================================================== */
+/* POST /api/logs/levels                                               */
+/* Body: { "tag": "SCHEDULER", "level": "warn" }  ("*" = default)      */
+/* Returns: { "status": "ok" }                                         */
+/* ================================================================== */
+static esp_err_t
+handler_PostLevels(httpd_req_t *ptReq)
+{
+    if (!requireServiceAccess(ptReq))
+    {
+        return ESP_OK;
+    }
+
+    cJSON *ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, LOGS_BODY_MAX, &ptRoot);
+    if (err != ESP_OK)
+    {
+        return WS_Body_SendError(ptReq, err);
+    }
+
+    cJSON *ptTag   = cJSON_GetObjectItem(ptRoot, "tag");
+    cJSON *ptLevel = cJSON_GetObjectItem(ptRoot, "level");
+    esp_log_level_t eLevel = ESP_LOG_NONE;
+
+    if (!cJSON_IsString(ptTag) || !cJSON_IsString(ptLevel))
+    {
+        cJSON_Delete(ptRoot);
+        return sendError(ptReq, "400 Bad Request", "Missing 'tag' or 'level' field");
+    }
+    if (!LogRing_LevelFromStr(ptLevel->valuestring, &eLevel))
+    {
+        cJSON_Delete(ptRoot);
+        return sendError(ptReq, "400 Bad Request", "Unknown level");
+    }
+
+    err = LogRing_SetLevel(ptTag->valuestring, eLevel);
+    if (ESP_OK == err)
+    {
+        ESP_LOGI(TAG, "Log level of '%s' set to %s", ptTag->valuestring, ptLevel->valuestring);
+    }
+    cJSON_Delete(ptRoot);
+
+    if (ESP_ERR_INVALID_ARG == err)
+    {
+        return sendError(ptReq, "400 Bad Request", "Tag must be 1-15 characters");
+    }
+    if (ESP_ERR_NO_MEM == err)
+    {
+        return sendError(ptReq, "507 Insufficient Storage", "Too many tag levels, reset with tag '*'");
+    }
+
+    cJSON *ptResp = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptResp, "status", "ok");
+    return sendJson(ptReq, ptResp);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+typedef struct _LOGS_API_RSC_T *LOGS_API_H;
+
+typedef struct
+{
+    int reserved;   /* Reads the LogRing component directly */
+} LOGS_API_PARAMS_T;
+
+/**
+ * @brief Initialize Logs API resource.
+ */
+esp_err_t LogsAPI_Init(const LOGS_API_PARAMS_T *ptParams, LOGS_API_H *phApi);
+
+/**
+ * @brief Register GET /api/logs and GET/POST /api/logs/levels handlers.
+ */
+esp_err_t LogsAPI_Register(LOGS_API_H hApi, httpd_handle_t hHttpServer);
@@ -0,0 +1,495 @@
+/* ================================================================== */
+/* OtaAPI.c — GET/POST/DELETE /api/system/ota                          */
+/* Service-role only: firmware upload into the spare OTA slot.         */
+/* ================================================================== */
+#include "OtaAPI.h"
+#include "Ota_API.h"
+#include "Auth/WS_Auth.h"
+#include "WS_Arena.h"
+#include "WS_Async.h"
+#include "WS_Upload.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "OTA_API";
+
+#define OTA_API_CHUNK_SIZE      4096
+#define OTA_API_CONTENT_TYPE    "application/octet-stream"
+#define OTA_API_REBOOT_DELAY_US (1000 * 1000)
+
+_Static_assert(WS_UPLOAD_DIGEST_LEN == OTA_DIGEST_LEN, "OTA digest is the upload SHA-256");
+
+/* ------------------------------------------------------------------ */
+/* Resource struct                                                     */
+/* ------------------------------------------------------------------ */
+typedef struct _OTA_API_RSC_T
+{
+    esp_timer_handle_t hRebootTimer;
+} OTA_API_RSC_T;
+
+/* ------------------------------------------------------------------ */
+/* Forward declarations                                                */
+/* ------------------------------------------------------------------ */
+static esp_err_t handler_GetOta(httpd_req_t *ptReq);
+static esp_err_t handler_PostOta(httpd_req_t *ptReq);
+static esp_err_t handler_DeleteOta(httpd_req_t *ptReq);
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+static esp_err_t
+sendJson(httpd_req_t *ptReq, cJSON *ptRoot)
+{
+    const char *pcJson = cJSON_PrintUnformatted(ptRoot);
+    auth_set_security_headers(ptReq);
+    httpd_resp_sendstr(ptReq, pcJson);
+    cJSON_free((void *)pcJson);
+    cJSON_Delete(ptRoot);
+    return ESP_OK;
+}
+
+static esp_err_t
+sendError(httpd_req_t *ptReq, const char *pcStatus, const char *pcMsg)
+{
+    cJSON *ptRoot = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptRoot, "error", pcMsg);
+    const char *pcJson = cJSON_PrintUnformatted(ptRoot);
+    auth_set_security_headers(ptReq);
+    httpd_resp_set_status(ptReq, pcStatus);
+    httpd_resp_sendstr(ptReq, pcJson);
+    cJSON_free((void *)pcJson);
+    cJSON_Delete(ptRoot);
+    return ESP_OK;
+}
+
+/**
+ * @brief Refuse an upload, telling the client where the session stands.
+ *        If the body is still on the wire the socket is closed rather
+ *        than drained. A NULL status sends nothing (the client is gone).
+ */
+static esp_err_t
+sendUploadError(httpd_req_t *ptReq, const char *pcStatus, const char *pcMsg,
+                uint32_t ulOffset, bool bBodyRead)
+{
+    if (NULL != pcStatus) {
+        cJSON *ptRoot = cJSON_CreateObject();
+        cJSON_AddStringToObject(ptRoot, "error", pcMsg);
+        cJSON_AddNumberToObject(ptRoot, "offset", (double)ulOffset);
+        const char *pcJson = cJSON_PrintUnformatted(ptRoot);
+        auth_set_security_headers(ptReq);
+        httpd_resp_set_status(ptReq, pcStatus);
+        if (!bBodyRead) {
+            httpd_resp_set_hdr(ptReq, "Connection", "close");
+        }
+        httpd_resp_sendstr(ptReq, pcJson);
+        cJSON_free((void *)pcJson);
+        cJSON_Delete(ptRoot);
+    }
+
+    if (bBodyRead) {
+        return ESP_OK;
+    }
+    httpd_sess_trigger_close(ptReq->handle, httpd_req_to_sockfd(ptReq));
+    return ESP_FAIL;
+}
+
+/**
+ * @brief Require service role + CSRF check for mutating requests.
+ */
+static bool
+requireServiceAccess(httpd_req_t *ptReq)
+{
+    auth_set_security_headers(ptReq);
+
+    if ((ptReq->method == HTTP_POST || ptReq->method == HTTP_PUT || ptReq->method == HTTP_DELETE)
+        && !auth_csrf_check(ptReq)) {
+        return false;
+    }
+
+    return (auth_require_role(ptReq, "service", NULL, NULL) == ESP_OK);
+}
+
+/**
+ * @brief Where the body goes: "Content-Range: bytes <first>-<last>/<size>",
+ *        or the whole image from 0 without the header.
+ */
+static bool
+parseRange(httpd_req_t *ptReq, uint32_t *pulOffset, uint32_t *pulSize)
+{
+    char acRange[64];
+    if (httpd_req_get_hdr_value_str(ptReq, "Content-Range", acRange, sizeof(acRange)) != ESP_OK) {
+        *pulOffset = 0;
+        *pulSize   = (uint32_t)ptReq->content_len;
+        return true;
+    }
+
+    uint32_t ulFirst = 0, ulLast = 0, ulSize = 0;
+    int      iEnd = 0;
+    if ((sscanf(acRange, "bytes %" SCNu32 "-%" SCNu32 "/%" SCNu32 "%n", &ulFirst, &ulLast, &ulSize, &iEnd) != 3)
+        || ('\0' != acRange[iEnd])
+        || (ulLast < ulFirst) || (ulLast >= ulSize)
+        || ((size_t)(ulLast - ulFirst) + 1 != ptReq->content_len)) {
+        return false;
+    }
+
+    *pulOffset = ulFirst;
+    *pulSize   = ulSize;
+    return true;
+}
+
+/* KB/s over the time the device spent in transfers */
+static double
+throughputKBps(uint32_t ulBytes, uint32_t ulMs)
+{
+    if (0 == ulMs) return 0.0;
+    return (double)((uint64_t)ulBytes * 10000 / ((uint64_t)ulMs * 1024)) / 10.0;
+}
+
+static void
+addTransferStats(cJSON *ptObj, uint32_t ulBytes, uint32_t ulTransfers,
+                 uint32_t ulActiveMs, uint32_t ulFlashMs)
+{
+    cJSON_AddNumberToObject(ptObj, "transfers", (double)ulTransfers);
+    cJSON_AddNumberToObject(ptObj, "activeMs", (double)ulActiveMs);
+    cJSON_AddNumberToObject(ptObj, "flashMs", (double)ulFlashMs);
+    cJSON_AddNumberToObject(ptObj, "throughputKBps", throughputKBps(ulBytes, ulActiveMs));
+}
+
+static void
+rebootTimerCallback(void *pvArg)
+{
+    (void)pvArg;
+    esp_restart();
+}
+
+/* One image upload: each chunk goes to flash before the next is read */
+typedef struct
+{
+    uint32_t    ulAt;           /* image offset the next chunk is written at */
+    const char *pcStatus;
+    const char *pcError;
+} OTA_API_UPLOAD_T;
+
+/* A short chunk is written too: the resume starts after it */
+static esp_err_t
+writeChunk(void *pvCtx, const uint8_t *pucData, size_t ulLen)
+{
+    OTA_API_UPLOAD_T *ptUpload = (OTA_API_UPLOAD_T *)pvCtx;
+
+    esp_err_t err = Ota_Write(pucData, ulLen);
+    if (ESP_OK != err) {
+        ESP_LOGE(TAG, "esp_ota_write failed at %" PRIu32 " (%s)", ptUpload->ulAt, esp_err_to_name(err));
+        ptUpload->pcStatus = "500 Internal Server Error";
+        ptUpload->pcError  = "Writing flash failed, start again";
+        ptUpload->ulAt     = 0;
+        return err;
+    }
+    ptUpload->ulAt += (uint32_t)ulLen;
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Init                                                                */
+/* ------------------------------------------------------------------ */
+esp_err_t
+OtaAPI_Init(const OTA_API_PARAMS_T *ptParams, OTA_API_H *phApi)
+{
+    (void)ptParams;
+
+    if (phApi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    OTA_API_RSC_T *ptRsc = (OTA_API_RSC_T *)calloc(1, sizeof(OTA_API_RSC_T));
+    if (ptRsc == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t tTimerArgs = {
+        .callback = rebootTimerCallback,
+        .name     = "ota_reboot",
+    };
+    esp_err_t err = esp_timer_create(&tTimerArgs, &ptRsc->hRebootTimer);
+    if (ESP_OK != err) {
+        free(ptRsc);
+        return err;
+    }
+
+    *phApi = ptRsc;
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Register                                                            */
+/* ------------------------------------------------------------------ */
+esp_err_t
+OtaAPI_Register(OTA_API_H hApi, httpd_handle_t hHttpServer)
+{
+    if (hApi == NULL || hHttpServer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    OTA_API_RSC_T *ptRsc = (OTA_API_RSC_T *)hApi;
+
+    httpd_uri_t tGetUri = {
+        .uri      = "/api/system/ota",
+        .method   = HTTP_GET,
+        .handler  = handler_GetOta,
+        .user_ctx = ptRsc,
+    };
+    esp_err_t err = WS_Arena_RegisterUri(hHttpServer, &tGetUri);
+
+    if (ESP_OK == err) {
+        httpd_uri_t tPostUri = {
+            .uri      = "/api/system/ota",
+            .method   = HTTP_POST,
+            .handler  = handler_PostOta,
+            .user_ctx = ptRsc,
+        };
+        /* Receiving and writing an image takes tens of seconds */
+        err = WS_Async_RegisterUri(hHttpServer, &tPostUri);
+    }
+
+    if (ESP_OK == err) {
+        httpd_uri_t tDeleteUri = {
+            .uri      = "/api/system/ota",
+            .method   = HTTP_DELETE,
+            .handler  = handler_DeleteOta,
+            .user_ctx = ptRsc,
+        };
+        err = WS_Arena_RegisterUri(hHttpServer, &tDeleteUri);
+    }
+
+    if (ESP_OK == err) {
+        ESP_LOGI(TAG, "OTA API registered: GET/POST/DELETE /api/system/ota");
+    }
+
+    return err;
+}
+
+/* ================================================================== */
+/* GET /api/system/ota                                                 */
+/* Returns: { "running": {...}, "pendingVerify", "healthCheckSec",     */
+/*            "next": {...}, "rolledBack": {...}, "session": {...},    */
+/*            "last": {...} }                                          */
+/* ================================================================== */
+static esp_err_t
+handler_GetOta(httpd_req_t *ptReq)
+{
+    if (!requireServiceAccess(ptReq))
+    {
+        return ESP_OK;
+    }
+
+    OTA_STATUS_T tStatus;
+    Ota_GetStatus(&tStatus);
+
+    cJSON *ptRoot = cJSON_CreateObject();
+
+    cJSON *ptRunning = cJSON_AddObjectToObject(ptRoot, "running");
+    cJSON_AddStringToObject(ptRunning, "partition", tStatus.acRunning);
+    cJSON_AddStringToObject(ptRunning, "version", tStatus.acVersion);
+    cJSON_AddStringToObject(ptRunning, "state", tStatus.pcState);
+    cJSON_AddBoolToObject(ptRoot, "pendingVerify", tStatus.bPendingVerify);
+    cJSON_AddNumberToObject(ptRoot, "healthCheckSec", CONFIG_OTA_HEALTH_CHECK_DELAY_SEC);
+
+    if ('\0' != tStatus.acNext[0])
+    {
+        cJSON *ptNext = cJSON_AddObjectToObject(ptRoot, "next");
+        cJSON_AddStringToObject(ptNext, "partition", tStatus.acNext);
+        cJSON_AddNumberToObject(ptNext, "slotBytes", (double)tStatus.ulSlotSize);
+    }
+    else
+    {
+        cJSON_AddNullToObject(ptRoot, "next");
+    }
+
+    if ('\0' != tStatus.acRolledBack[0])
+    {
+        cJSON *ptRolledBack = cJSON_AddObjectToObject(ptRoot, "rolledBack");
+        cJSON_AddStringToObject(ptRolledBack, "partition", tStatus.acRolledBack);
+        cJSON_AddStringToObject(ptRolledBack, "version", tStatus.acRolledBackVersion);
+    }
+
+    const OTA_SESSION_T *ptSession = &tStatus.tSession;
+    if (ptSession->bOpen)
+    {
+        cJSON *ptObj = cJSON_AddObjectToObject(ptRoot, "session");
+        cJSON_AddStringToObject(ptObj, "partition", ptSession->acTarget);
+        cJSON_AddNumberToObject(ptObj, "size", (double)ptSession->ulSize);
+        cJSON_AddNumberToObject(ptObj, "offset", (double)ptSession->ulOffset);
+        cJSON_AddBoolToObject(ptObj, "transferring", ptSession->bTransfer);
+        addTransferStats(ptObj, ptSession->ulOffset, ptSession->ulTransfers,
+                         ptSession->ulActiveMs, ptSession->ulFlashMs);
+        cJSON_AddNumberToObject(ptObj, "heapFreeStart", (double)ptSession->ulHeapFreeStart);
+        cJSON_AddNumberToObject(ptObj, "heapFreeMin", (double)ptSession->ulHeapFreeMin);
+    }
+    else
+    {
+        cJSON_AddNullToObject(ptRoot, "session");
+    }
+
+    const OTA_RESULT_T *ptLast = &tStatus.tLast;
+    if (ptLast->bValid)
+    {
+        cJSON *ptObj = cJSON_AddObjectToObject(ptRoot, "last");
+        cJSON_AddBoolToObject(ptObj, "ok", ptLast->bOk);
+        cJSON_AddStringToObject(ptObj, "result", ptLast->acResult);
+        cJSON_AddStringToObject(ptObj, "partition", ptLast->acTarget);
+        cJSON_AddStringToObject(ptObj, "version", ptLast->acVersion);
+        cJSON_AddNumberToObject(ptObj, "bytes", (double)ptLast->ulSize);
+        addTransferStats(ptObj, ptLast->ulSize, ptLast->ulTransfers, ptLast->ulActiveMs, ptLast->ulFlashMs);
+        cJSON_AddNumberToObject(ptObj, "heapFreeMin", (double)ptLast->ulHeapFreeMin);
+        cJSON_AddNumberToObject(ptObj, "heapPeakUsed", (double)ptLast->ulHeapPeakUsed);
+    }
+
+    return sendJson(ptReq, ptRoot);
+}
+
+/* ================================================================== */
+/* POST /api/system/ota                                                */
+/* Body: image bytes, Content-Type: application/octet-stream           */
+/* Headers: X-Content-SHA256: <64 hex digits of the whole image>       */
+/*          Content-Range: bytes <first>-<last>/<size>  (optional)     */
+/* Returns: { "status": "partial", "offset", "size" } or               */
+/*          { "status": "rebooting", "partition", "version", ... }     */
+/* ================================================================== */
+static esp_err_t
+handler_PostOta(httpd_req_t *ptReq)
+{
+    OTA_API_RSC_T *ptRsc = (OTA_API_RSC_T *)ptReq->user_ctx;
+
+    const char *pcStatus = NULL;
+    const char *pcError  = NULL;
+    if (ESP_OK != WS_Upload_CheckAccess(ptReq, OTA_API_CONTENT_TYPE, "Content-Type must be " OTA_API_CONTENT_TYPE,
+                                        &pcStatus, &pcError))
+    {
+        return sendUploadError(ptReq, pcStatus, pcError, 0, false);
+    }
+
+    uint8_t aucDigest[WS_UPLOAD_DIGEST_LEN];
+    if (ESP_OK != WS_Upload_GetDigest(ptReq, aucDigest))
+    {
+        return sendUploadError(ptReq, "400 Bad Request", WS_UPLOAD_DIGEST_HEADER " must hold 64 hex digits", 0, false);
+    }
+
+    uint32_t ulOffset = 0, ulSize = 0;
+    if ((0 == ptReq->content_len) || !parseRange(ptReq, &ulOffset, &ulSize))
+    {
+        return sendUploadError(ptReq, "400 Bad Request", "Content-Range does not match the body", 0, false);
+    }
+
+    uint32_t  ulAt = 0;
+    esp_err_t err  = Ota_Open(ulSize, aucDigest, ulOffset, (uint32_t)ptReq->content_len, &ulAt);
+    switch (err)
+    {
+        case ESP_OK:
+            break;
+        case ESP_ERR_INVALID_STATE:
+            return sendUploadError(ptReq, "409 Conflict", "Another firmware upload is running", ulAt, false);
+        case ESP_ERR_OTA_ROLLBACK_INVALID_STATE:
+            return sendUploadError(ptReq, "409 Conflict", "Running firmware is not confirmed yet", ulAt, false);
+        case ESP_ERR_NOT_FOUND:
+            return sendUploadError(ptReq, "409 Conflict", "No upload of this image to resume, start at 0", ulAt, false);
+        case ESP_ERR_INVALID_ARG:
+            return sendUploadError(ptReq, "409 Conflict", "Upload continues at another offset", ulAt, false);
+        case ESP_ERR_INVALID_SIZE:
+            return sendUploadError(ptReq, "413 Payload Too Large", "Image does not fit the OTA slot", ulAt, false);
+        case ESP_ERR_NOT_SUPPORTED:
+            return sendUploadError(ptReq, "503 Service Unavailable", "No OTA slots in the partition table", 0, false);
+        default:
+            ESP_LOGE(TAG, "Ota_Open failed (%s)", esp_err_to_name(err));
+            return sendUploadError(ptReq, "500 Internal Server Error", "Starting the update failed", ulAt, false);
+    }
+
+    OTA_API_UPLOAD_T tUpload = { .ulAt = ulAt };
+    err = WS_Upload_Receive(ptReq, OTA_API_CHUNK_SIZE, true, writeChunk, &tUpload, NULL, &pcStatus, &pcError);
+    ulAt = tUpload.ulAt;
+    if (ESP_ERR_INVALID_RESPONSE == err)
+    {
+        pcStatus = tUpload.pcStatus;
+        pcError  = tUpload.pcError;
+    }
+    if (ESP_OK != err)
+    {
+        Ota_Close();    /* no-op if the write error already ended the session */
+        return sendUploadError(ptReq, pcStatus, pcError, ulAt, false);
+    }
+
+    if (ulAt < ulSize)
+    {
+        Ota_Close();
+        cJSON *ptResp = cJSON_CreateObject();
+        cJSON_AddStringToObject(ptResp, "status", "partial");
+        cJSON_AddNumberToObject(ptResp, "offset", (double)ulAt);
+        cJSON_AddNumberToObject(ptResp, "size", (double)ulSize);
+        return sendJson(ptReq, ptResp);
+    }
+
+    err = Ota_Finish();
+    if (ESP_ERR_INVALID_CRC == err)
+    {
+        return sendUploadError(ptReq, "422 Unprocessable Entity", "SHA-256 does not match " WS_UPLOAD_DIGEST_HEADER, 0, true);
+    }
+    if (ESP_ERR_OTA_VALIDATE_FAILED == err)
+    {
+        return sendUploadError(ptReq, "422 Unprocessable Entity", "Not a valid firmware image for this device", 0, true);
+    }
+    if (ESP_OK != err)
+    {
+        ESP_LOGE(TAG, "Ota_Finish failed (%s)", esp_err_to_name(err));
+        return sendUploadError(ptReq, "500 Internal Server Error", "Activating the image failed", 0, true);
+    }
+
+    OTA_STATUS_T tStatus;
+    Ota_GetStatus(&tStatus);
+    const OTA_RESULT_T *ptLast = &tStatus.tLast;
+
+    ESP_LOGW(TAG, "Firmware %s written to %s, rebooting", ptLast->acVersion, ptLast->acTarget);
+
+    cJSON *ptResp = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptResp, "status", "rebooting");
+    cJSON_AddStringToObject(ptResp, "partition", ptLast->acTarget);
+    cJSON_AddStringToObject(ptResp, "version", ptLast->acVersion);
+    cJSON_AddNumberToObject(ptResp, "bytes", (double)ptLast->ulSize);
+    addTransferStats(ptResp, ptLast->ulSize, ptLast->ulTransfers, ptLast->ulActiveMs, ptLast->ulFlashMs);
+    cJSON_AddNumberToObject(ptResp, "heapFreeMin", (double)ptLast->ulHeapFreeMin);
+    cJSON_AddNumberToObject(ptResp, "heapPeakUsed", (double)ptLast->ulHeapPeakUsed);
+    sendJson(ptReq, ptResp);
+
+    /* Delay reboot so the HTTP response can be sent */
+    esp_timer_start_once(ptRsc->hRebootTimer, OTA_API_REBOOT_DELAY_US);
+    return ESP_OK;
+}
+
+/* ================================================================== */
+/* DELETE /api/system/ota                                              */
+/* Drops an unfinished upload; the slot is overwritten by the next.    */
+/* Returns: { "status": "ok" }                                         */
+/* ================================================================== */
+static esp_err_t
+handler_DeleteOta(httpd_req_t *ptReq)
+{
+    if (!requireServiceAccess(ptReq))
+    {
+        return ESP_OK;
+    }
+
+    if (ESP_OK != Ota_Abort())
+    {
+        return sendError(ptReq, "409 Conflict", "A transfer is running");
+    }
+
+    cJSON *ptResp = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptResp, "status", "ok");
+    return sendJson(ptReq, ptResp);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * Firmware updates over HTTP, on top of the Ota component.
+ *
+ * The image is POSTed as application/octet-stream with the SHA-256 of the
+ * whole image in X-Content-SHA256. A body that is only part of the image
+ * says where it belongs with Content-Range; after a dropped connection the
+ * client asks GET /api/system/ota for the offset reached and sends the rest
+ * from there. When the last byte is written and verified the device reboots
+ * into the new image.
+ */
+
+typedef struct _OTA_API_RSC_T *OTA_API_H;
+
+typedef struct
+{
+    int reserved;   /* The Ota component keeps the session */
+} OTA_API_PARAMS_T;
+
+/**
+ * @brief Initialize OTA API resource.
+ */
+esp_err_t OtaAPI_Init(const OTA_API_PARAMS_T *ptParams, OTA_API_H *phApi);
+
+/**
+ * @brief Register GET/POST/DELETE /api/system/ota handlers.
+ */
+esp_err_t OtaAPI_Register(OTA_API_H hApi, httpd_handle_t hHttpServer);
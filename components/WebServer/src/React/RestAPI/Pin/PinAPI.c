@@ -4,6 +4,8 @@
 #include "PinAPI.h"
 #include "TouchScreen_Services.h"
 #include "Auth/WS_Auth.h"
+#include "WS_Body.h"
+#include "WS_Arena.h"
 #include "cJSON.h"
 #include "esp_log.h"
 
@@ -12,6 +14,8 @@
 
 static const char *TAG = "PIN_API";
 
+#define PIN_BODY_MAX 128
+
 /* ------------------------------------------------------------------ */
 /* Resource struct                                                     */
 /* ------------------------------------------------------------------ */
@@ -35,7 +39,7 @@ sendJson(httpd_req_t *ptReq, cJSON *ptRoot)
     const char *pcJson = cJSON_PrintUnformatted(ptRoot);
     auth_set_security_headers(ptReq);
     httpd_resp_sendstr(ptReq, pcJson);
-    free((void *)pcJson);
+    cJSON_free((void *)pcJson);
     cJSON_Delete(ptRoot);
     return ESP_OK;
 }
@@ -49,7 +53,7 @@ sendError(httpd_req_t *ptReq, const char *pcStatus, const char *pcMsg)
     auth_set_security_headers(ptReq);
     httpd_resp_set_status(ptReq, pcStatus);
     httpd_resp_sendstr(ptReq, pcJson);
-    free((void *)pcJson);
+    cJSON_free((void *)pcJson);
     cJSON_Delete(ptRoot);
     return ESP_OK;
 }
@@ -117,7 +121,7 @@ PinAPI_Register(PIN_API_H hApi, httpd_handle_t hHttpServer)
         .handler  = handler_GetPin,
         .user_ctx = ptRsc,
     };
-    esp_err_t err = httpd_register_uri_handler(hHttpServer, &tGetUri);
+    esp_err_t err = WS_Arena_RegisterUri(hHttpServer, &tGetUri);
 
     if (ESP_OK == err)
     {
@@ -127,7 +131,7 @@ PinAPI_Register(PIN_API_H hApi, httpd_handle_t hHttpServer)
             .handler  = handler_PostPin,
             .user_ctx = ptRsc,
         };
-        err = httpd_register_uri_handler(hHttpServer, &tPostUri);
+        err = WS_Arena_RegisterUri(hHttpServer, &tPostUri);
     }
 
     if (ESP_OK == err)
@@ -179,18 +183,11 @@ handler_PostPin(httpd_req_t *ptReq)
         return ESP_OK;
     }
 
-    char acBuf[128];
-    int iLen = httpd_req_recv(ptReq, acBuf, sizeof(acBuf) - 1);
-    if (iLen <= 0)
-    {
-        return sendError(ptReq, "400 Bad Request", "Empty body");
-    }
-    acBuf[iLen] = '\0';
-
-    cJSON *ptRoot = cJSON_Parse(acBuf);
-    if (ptRoot == NULL)
+    cJSON *ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, PIN_BODY_MAX, &ptRoot);
+    if (err != ESP_OK)
     {
-        return sendError(ptReq, "400 Bad Request", "Invalid JSON");
+        return WS_Body_SendError(ptReq, err);
     }
 
     cJSON *ptPin = cJSON_GetObjectItem(ptRoot, "pin");
@@ -200,7 +197,7 @@ handler_PostPin(httpd_req_t *ptReq)
         return sendError(ptReq, "400 Bad Request", "Missing 'pin' field");
     }
 
-    esp_err_t err = TS_Pin_Set(ptPin->valuestring);
+    err = TS_Pin_Set(ptPin->valuestring);
     cJSON_Delete(ptRoot);
 
     if (ESP_OK != err)
@@ -1,13 +1,22 @@
 #include "ScheduleAPI.h"
 #include "Schedule_Data.h"
+#include "Schedule_Persist.h"
+#include "Bell_Log.h"
+#include "FlashStats_API.h"
+#include "SPIFFS_API.h"
 #include "Scheduler_API.h"
 #include "RingBell_API.h"
 #include "TimeSync_API.h"
 #include "TouchScreen_Services.h"
 #include "Auth/WS_Auth.h"
+#include "WS_Body.h"
+#include "WS_Arena.h"
+#include "WS_Async.h"
+#include "React/WS_React_AssetCache.h"
 #include "cJSON.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_random.h"
 #include "esp_chip_info.h"
 #include "esp_timer.h"
 #include <stdlib.h>
@@ -16,7 +25,21 @@
 
 static const char* TAG = "schedule_api";
 
-#define REQ_BODY_MAX 8192
+/* Largest accepted body per route; sized for the schedule limits with
+   long labels, plus room for formatting */
+#define SETTINGS_BODY_MAX           1024
+#define BELLS_BODY_MAX              (16 * 1024)
+#define HOLIDAYS_BODY_MAX           (12 * 1024)
+#define EXCEPTIONS_BODY_MAX         (32 * 1024)
+#define TEMPLATES_BODY_MAX          (24 * 1024)
+#define ITEM_BODY_MAX               512
+#define CONTROL_BODY_MAX            128
+
+#define BELL_HISTORY_DEFAULT_LIMIT  100
+#define BELL_HISTORY_MAX_LIMIT      200
+
+#define SECTION_ETAG_LEN            32
+#define ETAG_LIST_MAX               128
 
 /* ================================================================== */
 /* Resource                                                            */
@@ -25,6 +48,7 @@ static const char* TAG = "schedule_api";
 typedef struct _SCHEDULE_API_RSC_T
 {
     SCHEDULER_H hScheduler;
+    uint32_t    ulBootId;       /* ETag prefix; section generations restart at boot */
 } SCHEDULE_API_RSC_T;
 
 /* ================================================================== */
@@ -37,7 +61,7 @@ sendJson(httpd_req_t* ptReq, cJSON* ptRoot)
     const char* pcJson = cJSON_PrintUnformatted(ptRoot);
     auth_set_security_headers(ptReq);
     httpd_resp_sendstr(ptReq, pcJson);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
     cJSON_Delete(ptRoot);
     return ESP_OK;
 }
@@ -51,28 +75,18 @@ sendError(httpd_req_t* ptReq, const char* pcStatus, const char* pcMsg)
     auth_set_security_headers(ptReq);
     httpd_resp_set_status(ptReq, pcStatus);
     httpd_resp_sendstr(ptReq, pcJson);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
     cJSON_Delete(ptRoot);
     return ESP_OK;
 }
 
-static int
-readBody(httpd_req_t* ptReq, char* pcBuf, size_t ulBufSize)
-{
-    int iLen = httpd_req_recv(ptReq, pcBuf, ulBufSize - 1);
-    if (iLen > 0)
-    {
-        pcBuf[iLen] = '\0';
-    }
-    return iLen;
-}
-
 static bool
 requireProtectedAccess(httpd_req_t* ptReq, const char** ppcUser, const char** ppcRole)
 {
     auth_set_security_headers(ptReq);
 
-    if ((ptReq->method == HTTP_POST || ptReq->method == HTTP_PUT || ptReq->method == HTTP_DELETE)
+    if ((ptReq->method == HTTP_POST || ptReq->method == HTTP_PUT ||
+         ptReq->method == HTTP_PATCH || ptReq->method == HTTP_DELETE)
         && !auth_csrf_check(ptReq)) {
         return false;
     }
@@ -80,6 +94,183 @@ requireProtectedAccess(httpd_req_t* ptReq, const char** ppcUser, const char** pp
     return (auth_require_session(ptReq, ppcUser, ppcRole) == ESP_OK);
 }
 
+/* Strong ETag for a schedule section: boot id, section and its save count.
+   Holidays and exceptions share the calendar file, so they share a count. */
+static void
+formatEtag(const SCHEDULE_API_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection, uint32_t ulGeneration, char* pcEtag)
+{
+    snprintf(pcEtag, SECTION_ETAG_LEN, "\"%08lx-%d-%lu\"",
+             (unsigned long)ptRsc->ulBootId, (int)eSection, (unsigned long)ulGeneration);
+}
+
+static void
+sectionEtag(const SCHEDULE_API_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection, char* pcEtag)
+{
+    formatEtag(ptRsc, eSection, Schedule_Persist_GetGeneration(eSection), pcEtag);
+}
+
+/* If-None-Match: "*" or a comma-separated list of tags, compared weakly
+   (a W/ copy of our tag matches too) */
+static bool
+etagListMatches(const char* pcList, const char* pcEtag)
+{
+    while (*pcList == ' ' || *pcList == '\t') pcList++;
+    if (*pcList == '*') return true;
+
+    return (strstr(pcList, pcEtag) != NULL);
+}
+
+/* GET: tag the response, and answer 304 when the client already has this
+   version. Returns true if the 304 was sent. pcEtag must outlive the
+   response (httpd keeps the pointer). */
+static bool
+sendIfNotModified(httpd_req_t* ptReq, const char* pcEtag)
+{
+    httpd_resp_set_hdr(ptReq, "ETag", pcEtag);
+    httpd_resp_set_hdr(ptReq, "Cache-Control", "no-cache");
+
+    char acList[ETAG_LIST_MAX];
+    if ((httpd_req_get_hdr_value_str(ptReq, "If-None-Match", acList, sizeof(acList)) != ESP_OK) ||
+        !etagListMatches(acList, pcEtag))
+    {
+        return false;
+    }
+
+    httpd_resp_set_status(ptReq, "304 Not Modified");
+    httpd_resp_send(ptReq, NULL, 0);
+    return true;
+}
+
+/* POST/PATCH/DELETE: the section generation named by If-Match, for Scheduler_EditData
+   to compare under the lock it saves with. Without the header, or with "*",
+   any generation will do. Only the first strong tag of this boot and
+   section counts. Returns false if the 412 was sent: the header names no
+   such tag, so it can never match. */
+static bool
+ifMatchGeneration(httpd_req_t* ptReq, const SCHEDULE_API_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection,
+                  uint32_t* pulGeneration, char* pcEtag)
+{
+    *pulGeneration = SCHEDULER_GENERATION_ANY;
+
+    char acList[ETAG_LIST_MAX];
+    esp_err_t err = httpd_req_get_hdr_value_str(ptReq, "If-Match", acList, sizeof(acList));
+    if (err == ESP_ERR_NOT_FOUND) return true;
+
+    if (err == ESP_OK)
+    {
+        char* pcSave = NULL;
+        for (char* pcTag = strtok_r(acList, ",", &pcSave); pcTag; pcTag = strtok_r(NULL, ",", &pcSave))
+        {
+            while (*pcTag == ' ' || *pcTag == '\t') pcTag++;
+            if (*pcTag == '*') return true;
+
+            unsigned long ulBootId = 0, ulGeneration = 0;
+            int iSection = -1, iEnd = 0;
+            if ((sscanf(pcTag, "\"%8lx-%d-%lu\"%n", &ulBootId, &iSection, &ulGeneration, &iEnd) == 3)
+                && (iEnd > 0) && ((pcTag[iEnd] == '\0') || (pcTag[iEnd] == ' ') || (pcTag[iEnd] == '\t'))
+                && (ulBootId == ptRsc->ulBootId) && (iSection == (int)eSection)
+                && (ulGeneration < SCHEDULER_GENERATION_ANY))
+            {
+                *pulGeneration = (uint32_t)ulGeneration;
+                return true;
+            }
+        }
+    }
+
+    sectionEtag(ptRsc, eSection, pcEtag);
+    httpd_resp_set_hdr(ptReq, "ETag", pcEtag);
+    sendError(ptReq, "412 Precondition Failed", "Changed since it was loaded; reload and retry");
+    return false;
+}
+
+/* Scheduler_EditData refused the save: the section moved past the client's
+   If-Match. ulGeneration is the current one. */
+static esp_err_t
+sendPreconditionFailed(httpd_req_t* ptReq, const SCHEDULE_API_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection,
+                       uint32_t ulGeneration, char* pcEtag)
+{
+    formatEtag(ptRsc, eSection, ulGeneration, pcEtag);
+    httpd_resp_set_hdr(ptReq, "ETag", pcEtag);
+    return sendError(ptReq, "412 Precondition Failed", "Changed since it was loaded; reload and retry");
+}
+
+/* Reply to a successful section save, carrying the ETag of what was saved */
+static esp_err_t
+sendSaved(httpd_req_t* ptReq, const SCHEDULE_API_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection,
+          uint32_t ulGeneration, char* pcEtag)
+{
+    formatEtag(ptRsc, eSection, ulGeneration, pcEtag);
+    httpd_resp_set_hdr(ptReq, "ETag", pcEtag);
+
+    cJSON* ptResp = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptResp, "status", "ok");
+    return sendJson(ptReq, ptResp);
+}
+
+/* Whole-section POSTs: swap the parsed section (pvCtx, a staged
+   SCHEDULE_DATA_T) into the scheduler's model under its lock. The If-Match
+   compare and the save happen under the same lock, so two uploads based on
+   one ETag cannot both succeed. */
+static esp_err_t
+replaceBells(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    const SCHEDULE_DATA_T* ptNew = (const SCHEDULE_DATA_T*)pvCtx;
+    ptData->tFirstShift  = ptNew->tFirstShift;
+    ptData->tSecondShift = ptNew->tSecondShift;
+    return ESP_OK;
+}
+
+static esp_err_t
+replaceHolidays(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    const SCHEDULE_DATA_T* ptNew = (const SCHEDULE_DATA_T*)pvCtx;
+    ptData->ulHolidayCount = ptNew->ulHolidayCount;
+    memcpy(ptData->atHolidays, ptNew->atHolidays, sizeof(ptData->atHolidays));
+    Schedule_Data_AssignCalendarIds(ptData);
+    return ESP_OK;
+}
+
+static esp_err_t
+replaceExceptions(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    const SCHEDULE_DATA_T* ptNew = (const SCHEDULE_DATA_T*)pvCtx;
+    ptData->ulExceptionCount = ptNew->ulExceptionCount;
+    memcpy(ptData->atExceptions, ptNew->atExceptions, sizeof(ptData->atExceptions));
+    ptData->ulCustomBellSetCount = ptNew->ulCustomBellSetCount;
+    memcpy(ptData->atCustomBellSets, ptNew->atCustomBellSets, sizeof(ptData->atCustomBellSets));
+    Schedule_Data_AssignCalendarIds(ptData);
+    return ESP_OK;
+}
+
+static esp_err_t
+replaceTemplates(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    const SCHEDULE_DATA_T* ptNew = (const SCHEDULE_DATA_T*)pvCtx;
+    ptData->ulTemplateCount = ptNew->ulTemplateCount;
+    memcpy(ptData->atTemplates, ptNew->atTemplates, sizeof(ptData->atTemplates));
+    return ESP_OK;
+}
+
+static esp_err_t
+replaceSettings(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    ptData->tSettings = *(const SCHEDULE_SETTINGS_T*)pvCtx;
+    return ESP_OK;
+}
+
+/* Save a staged section through the scheduler and answer the request */
+static esp_err_t
+saveSection(httpd_req_t* ptReq, const SCHEDULE_API_RSC_T* ptRsc, SCHEDULE_SECTION_E eSection,
+            SCHEDULER_EDIT_FN pfnReplace, void* pvCtx, uint32_t ulIfGeneration, char* pcEtag)
+{
+    uint32_t ulGeneration = ulIfGeneration;
+    esp_err_t err = Scheduler_EditData(ptRsc->hScheduler, eSection, pfnReplace, pvCtx, &ulGeneration);
+    if (err == ESP_ERR_INVALID_VERSION) return sendPreconditionFailed(ptReq, ptRsc, eSection, ulGeneration, pcEtag);
+    if (err != ESP_OK) return sendError(ptReq, "500 Internal Server Error", "Failed to save");
+
+    return sendSaved(ptReq, ptRsc, eSection, ulGeneration, pcEtag);
+}
+
 /* ================================================================== */
 /* GET /api/schedule/settings                                          */
 /* ================================================================== */
@@ -90,6 +281,13 @@ handler_GetSettings(httpd_req_t* ptReq)
     const char* pcUser; const char* pcRole;
     if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
 
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+
+    /* Sampled before loading: a save in between makes the tag stale, never the data */
+    char acEtag[SECTION_ETAG_LEN];
+    sectionEtag(ptRsc, SCHEDULE_SECTION_SETTINGS, acEtag);
+    if (sendIfNotModified(ptReq, acEtag)) return ESP_OK;
+
     SCHEDULE_SETTINGS_T tSettings;
     Schedule_Data_LoadSettings(&tSettings);
 
@@ -109,21 +307,21 @@ handler_PostSettings(httpd_req_t* ptReq)
 
     SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
 
-    char acBuf[1024];
-    int iLen = readBody(ptReq, acBuf, sizeof(acBuf));
-    if (iLen <= 0) return sendError(ptReq, "400 Bad Request", "Empty body");
+    char     acEtag[SECTION_ETAG_LEN];
+    uint32_t ulGeneration;
+    if (!ifMatchGeneration(ptReq, ptRsc, SCHEDULE_SECTION_SETTINGS, &ulGeneration, acEtag)) return ESP_OK;
 
-    cJSON* ptRoot = cJSON_Parse(acBuf);
-    if (!ptRoot) return sendError(ptReq, "400 Bad Request", "Invalid JSON");
+    cJSON* ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, SETTINGS_BODY_MAX, &ptRoot);
+    if (err != ESP_OK) return WS_Body_SendError(ptReq, err);
 
     SCHEDULE_SETTINGS_T tSettings = { 0 };
 
     cJSON* ptTz = cJSON_GetObjectItem(ptRoot, "timezone");
-    if (ptTz && cJSON_IsString(ptTz))
+    bool bTimezone = (ptTz && cJSON_IsString(ptTz));
+    if (bTimezone)
     {
         strncpy(tSettings.acTimezone, ptTz->valuestring, sizeof(tSettings.acTimezone) - 1);
-        /* Also update system timezone */
-        TimeSync_SetTimezone(ptTz->valuestring);
     }
 
     cJSON* ptDays = cJSON_GetObjectItem(ptRoot, "workingDays");
@@ -143,14 +341,17 @@ handler_PostSettings(httpd_req_t* ptReq)
 
     cJSON_Delete(ptRoot);
 
-    esp_err_t err = Schedule_Data_SaveSettings(&tSettings);
+    err = Scheduler_EditData(ptRsc->hScheduler, SCHEDULE_SECTION_SETTINGS, replaceSettings, &tSettings, &ulGeneration);
+    if (err == ESP_ERR_INVALID_VERSION)
+    {
+        return sendPreconditionFailed(ptReq, ptRsc, SCHEDULE_SECTION_SETTINGS, ulGeneration, acEtag);
+    }
     if (err != ESP_OK) return sendError(ptReq, "500 Internal Server Error", "Failed to save");
 
-    Scheduler_ReloadSchedule(ptRsc->hScheduler);
+    /* Only once saved, so a refused upload leaves the live timezone alone */
+    if (bTimezone) TimeSync_SetTimezone(tSettings.acTimezone);
 
-    cJSON* ptResp = cJSON_CreateObject();
-    cJSON_AddStringToObject(ptResp, "status", "ok");
-    return sendJson(ptReq, ptResp);
+    return sendSaved(ptReq, ptRsc, SCHEDULE_SECTION_SETTINGS, ulGeneration, acEtag);
 }
 
 /* ================================================================== */
@@ -163,6 +364,12 @@ handler_GetBells(httpd_req_t* ptReq)
     const char* pcUser; const char* pcRole;
     if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
 
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+
+    char acEtag[SECTION_ETAG_LEN];
+    sectionEtag(ptRsc, SCHEDULE_SECTION_BELLS, acEtag);
+    if (sendIfNotModified(ptReq, acEtag)) return ESP_OK;
+
     SCHEDULE_SHIFT_T tFirst, tSecond;
     Schedule_Data_LoadBells(&tFirst, &tSecond);
 
@@ -174,8 +381,9 @@ handler_GetBells(httpd_req_t* ptReq)
 /* POST /api/schedule/bells                                            */
 /* ================================================================== */
 
+/* Only shift bells are addressable, so template and custom-set bells take no id */
 static void
-parseBellArrayFromJson(cJSON* ptArr, BELL_ENTRY_T* ptBells, uint32_t* pulCount, uint32_t ulMax)
+parseBellArrayFromJson(cJSON* ptArr, BELL_ENTRY_T* ptBells, uint32_t* pulCount, uint32_t ulMax, bool bWithIds)
 {
     *pulCount = 0;
     if (!ptArr || !cJSON_IsArray(ptArr)) return;
@@ -196,6 +404,7 @@ parseBellArrayFromJson(cJSON* ptArr, BELL_ENTRY_T* ptBells, uint32_t* pulCount,
             ptBells[*pulCount].ucHour = (uint8_t)ptH->valueint;
             ptBells[*pulCount].ucMinute = (uint8_t)ptM->valueint;
             ptBells[*pulCount].usDurationSec = (ptD && cJSON_IsNumber(ptD)) ? (uint16_t)ptD->valueint : 3;
+            ptBells[*pulCount].usId = bWithIds ? Schedule_Data_ReadItemId(ptItem) : SCHEDULE_ITEM_ID_NONE;
             memset(ptBells[*pulCount].acLabel, 0, SCHEDULE_LABEL_MAX_LEN);
             if (ptL && cJSON_IsString(ptL))
             {
@@ -221,7 +430,7 @@ parseShiftFromJson(cJSON* ptShiftObj, SCHEDULE_SHIFT_T* ptShift)
     }
 
     cJSON* ptArr = cJSON_GetObjectItem(ptShiftObj, "bells");
-    parseBellArrayFromJson(ptArr, ptShift->atBells, &ptShift->ulBellCount, SCHEDULE_MAX_BELLS_PER_SHIFT);
+    parseBellArrayFromJson(ptArr, ptShift->atBells, &ptShift->ulBellCount, SCHEDULE_MAX_BELLS_PER_SHIFT, true);
 }
 
 static esp_err_t
@@ -232,18 +441,13 @@ handler_PostBells(httpd_req_t* ptReq)
 
     SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
 
-    char* pcBuf = (char*)malloc(REQ_BODY_MAX);
-    if (!pcBuf) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
-
-    int iLen = readBody(ptReq, pcBuf, REQ_BODY_MAX);
-    if (iLen <= 0) { free(pcBuf); return sendError(ptReq, "400 Bad Request", "Empty body"); }
+    char     acEtag[SECTION_ETAG_LEN];
+    uint32_t ulGeneration;
+    if (!ifMatchGeneration(ptReq, ptRsc, SCHEDULE_SECTION_BELLS, &ulGeneration, acEtag)) return ESP_OK;
 
-    cJSON* ptRoot = cJSON_Parse(pcBuf);
-    free(pcBuf);
-    if (!ptRoot) return sendError(ptReq, "400 Bad Request", "Invalid JSON");
-
-    SCHEDULE_SHIFT_T tFirst  = { .bEnabled = true,  .ulBellCount = 0 };
-    SCHEDULE_SHIFT_T tSecond = { .bEnabled = false, .ulBellCount = 0 };
+    cJSON* ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, BELLS_BODY_MAX, &ptRoot);
+    if (err != ESP_OK) return WS_Body_SendError(ptReq, err);
 
     cJSON* ptFirstShift  = cJSON_GetObjectItem(ptRoot, "firstShift");
     cJSON* ptSecondShift = cJSON_GetObjectItem(ptRoot, "secondShift");
@@ -254,19 +458,18 @@ handler_PostBells(httpd_req_t* ptReq)
         return sendError(ptReq, "400 Bad Request", "Missing 'firstShift' or 'secondShift'");
     }
 
-    parseShiftFromJson(ptFirstShift, &tFirst);
-    parseShiftFromJson(ptSecondShift, &tSecond);
-
-    cJSON_Delete(ptRoot);
+    SCHEDULE_DATA_T* ptNew = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
+    if (!ptNew) { cJSON_Delete(ptRoot); return sendError(ptReq, "500 Internal Server Error", "OOM"); }
 
-    esp_err_t err = Schedule_Data_SaveBells(&tFirst, &tSecond);
-    if (err != ESP_OK) return sendError(ptReq, "500 Internal Server Error", "Failed to save");
+    parseShiftFromJson(ptFirstShift, &ptNew->tFirstShift);
+    parseShiftFromJson(ptSecondShift, &ptNew->tSecondShift);
+    Schedule_Data_AssignBellIds(&ptNew->tFirstShift, &ptNew->tSecondShift);
 
-    Scheduler_ReloadSchedule(ptRsc->hScheduler);
+    cJSON_Delete(ptRoot);
 
-    cJSON* ptResp = cJSON_CreateObject();
-    cJSON_AddStringToObject(ptResp, "status", "ok");
-    return sendJson(ptReq, ptResp);
+    err = saveSection(ptReq, ptRsc, SCHEDULE_SECTION_BELLS, replaceBells, ptNew, ulGeneration, acEtag);
+    WS_Arena_Free(ptNew);
+    return err;
 }
 
 /* ================================================================== */
@@ -279,12 +482,18 @@ handler_GetHolidays(httpd_req_t* ptReq)
     const char* pcUser; const char* pcRole;
     if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
 
-    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)calloc(1, sizeof(SCHEDULE_DATA_T));
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+
+    char acEtag[SECTION_ETAG_LEN];
+    sectionEtag(ptRsc, SCHEDULE_SECTION_CALENDAR, acEtag);
+    if (sendIfNotModified(ptReq, acEtag)) return ESP_OK;
+
+    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
     if (!ptData) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
 
     Schedule_Data_LoadCalendar(ptData);
     cJSON* ptRoot = Schedule_Data_HolidaysToJson(ptData->atHolidays, ptData->ulHolidayCount);
-    free(ptData);
+    WS_Arena_Free(ptData);
 
     return sendJson(ptReq, ptRoot);
 }
@@ -301,24 +510,18 @@ handler_PostHolidays(httpd_req_t* ptReq)
 
     SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
 
-    char* pcBuf = (char*)malloc(REQ_BODY_MAX);
-    if (!pcBuf) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
+    char     acEtag[SECTION_ETAG_LEN];
+    uint32_t ulGeneration;
+    if (!ifMatchGeneration(ptReq, ptRsc, SCHEDULE_SECTION_CALENDAR, &ulGeneration, acEtag)) return ESP_OK;
 
-    int iLen = readBody(ptReq, pcBuf, REQ_BODY_MAX);
-    if (iLen <= 0) { free(pcBuf); return sendError(ptReq, "400 Bad Request", "Empty body"); }
+    cJSON* ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, HOLIDAYS_BODY_MAX, &ptRoot);
+    if (err != ESP_OK) return WS_Body_SendError(ptReq, err);
 
-    cJSON* ptRoot = cJSON_Parse(pcBuf);
-    free(pcBuf);
-    if (!ptRoot) return sendError(ptReq, "400 Bad Request", "Invalid JSON");
-
-    /* Load existing calendar to preserve exceptions */
-    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)calloc(1, sizeof(SCHEDULE_DATA_T));
+    /* Only the holidays are staged; exceptions stay as the scheduler has them */
+    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
     if (!ptData) { cJSON_Delete(ptRoot); return sendError(ptReq, "500 Internal Server Error", "OOM"); }
 
-    Schedule_Data_LoadCalendar(ptData);
-
-    /* Replace holidays */
-    ptData->ulHolidayCount = 0;
     cJSON* ptArr = cJSON_GetObjectItem(ptRoot, "holidays");
     if (ptArr && cJSON_IsArray(ptArr))
     {
@@ -335,6 +538,7 @@ handler_PostHolidays(httpd_req_t* ptReq)
             if (ptS && cJSON_IsString(ptS) && ptE && cJSON_IsString(ptE))
             {
                 HOLIDAY_T* ptH = &ptData->atHolidays[ptData->ulHolidayCount];
+                ptH->usId = Schedule_Data_ReadItemId(ptItem);
                 strncpy(ptH->acStartDate, ptS->valuestring, SCHEDULE_DATE_STR_LEN - 1);
                 strncpy(ptH->acEndDate, ptE->valuestring, SCHEDULE_DATE_STR_LEN - 1);
                 memset(ptH->acLabel, 0, SCHEDULE_LABEL_MAX_LEN);
@@ -349,16 +553,9 @@ handler_PostHolidays(httpd_req_t* ptReq)
 
     cJSON_Delete(ptRoot);
 
-    esp_err_t err = Schedule_Data_SaveCalendar(ptData);
-    free(ptData);
-
-    if (err != ESP_OK) return sendError(ptReq, "500 Internal Server Error", "Failed to save");
-
-    Scheduler_ReloadSchedule(ptRsc->hScheduler);
-
-    cJSON* ptResp = cJSON_CreateObject();
-    cJSON_AddStringToObject(ptResp, "status", "ok");
-    return sendJson(ptReq, ptResp);
+    err = saveSection(ptReq, ptRsc, SCHEDULE_SECTION_CALENDAR, replaceHolidays, ptData, ulGeneration, acEtag);
+    WS_Arena_Free(ptData);
+    return err;
 }
 
 /* ================================================================== */
@@ -371,14 +568,20 @@ handler_GetExceptions(httpd_req_t* ptReq)
     const char* pcUser; const char* pcRole;
     if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
 
-    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)calloc(1, sizeof(SCHEDULE_DATA_T));
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+
+    char acEtag[SECTION_ETAG_LEN];
+    sectionEtag(ptRsc, SCHEDULE_SECTION_CALENDAR, acEtag);
+    if (sendIfNotModified(ptReq, acEtag)) return ESP_OK;
+
+    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
     if (!ptData) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
 
     Schedule_Data_LoadCalendar(ptData);
     cJSON* ptRoot = Schedule_Data_ExceptionsToJson(
         ptData->atExceptions, ptData->ulExceptionCount,
         ptData->atCustomBellSets, ptData->ulCustomBellSetCount);
-    free(ptData);
+    WS_Arena_Free(ptData);
 
     return sendJson(ptReq, ptRoot);
 }
@@ -387,6 +590,99 @@ handler_GetExceptions(httpd_req_t* ptReq)
 /* POST /api/schedule/exceptions                                       */
 /* ================================================================== */
 
+/* Copy the exception fields present in ptItem onto ptEx. The bulk POST
+   starts from a cleared entry, a PATCH from the stored one. On a bad field
+   ptEx is partly updated, so a PATCH applies this to a copy. */
+static esp_err_t
+applyExceptionFields(EXCEPTION_ENTRY_T* ptEx, const cJSON* ptItem, const char** ppcError)
+{
+    cJSON* ptStart = cJSON_GetObjectItem(ptItem, "startDate");
+    if (ptStart && cJSON_IsString(ptStart))
+    {
+        if (!Schedule_Data_IsValidDate(ptStart->valuestring))
+        {
+            *ppcError = "'startDate' must be a YYYY-MM-DD date";
+            return ESP_ERR_INVALID_ARG;
+        }
+        strncpy(ptEx->acStartDate, ptStart->valuestring, SCHEDULE_DATE_STR_LEN - 1);
+    }
+
+    /* Empty end date: single day */
+    cJSON* ptEnd = cJSON_GetObjectItem(ptItem, "endDate");
+    if (ptEnd && cJSON_IsString(ptEnd))
+    {
+        if ((ptEnd->valuestring[0] != '\0') && !Schedule_Data_IsValidDate(ptEnd->valuestring))
+        {
+            *ppcError = "'endDate' must be a YYYY-MM-DD date or empty";
+            return ESP_ERR_INVALID_ARG;
+        }
+        memset(ptEx->acEndDate, 0, SCHEDULE_DATE_STR_LEN);
+        strncpy(ptEx->acEndDate, ptEnd->valuestring, SCHEDULE_DATE_STR_LEN - 1);
+    }
+
+    if ((ptEx->acEndDate[0] != '\0') && (strcmp(ptEx->acEndDate, ptEx->acStartDate) < 0))
+    {
+        *ppcError = "'endDate' is before 'startDate'";
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cJSON* ptLbl = cJSON_GetObjectItem(ptItem, "label");
+    if (ptLbl && cJSON_IsString(ptLbl))
+        strncpy(ptEx->acLabel, ptLbl->valuestring, SCHEDULE_LABEL_MAX_LEN - 1);
+
+    cJSON* ptAction = cJSON_GetObjectItem(ptItem, "action");
+    if (ptAction && cJSON_IsString(ptAction))
+    {
+        if (strcmp(ptAction->valuestring, "normal") == 0)
+            ptEx->eAction = EXCEPTION_ACTION_NORMAL;
+        else if (strcmp(ptAction->valuestring, "first-shift") == 0)
+            ptEx->eAction = EXCEPTION_ACTION_FIRST_SHIFT;
+        else if (strcmp(ptAction->valuestring, "second-shift") == 0)
+            ptEx->eAction = EXCEPTION_ACTION_SECOND_SHIFT;
+        else if (strcmp(ptAction->valuestring, "template") == 0)
+            ptEx->eAction = EXCEPTION_ACTION_TEMPLATE;
+        else if (strcmp(ptAction->valuestring, "custom") == 0)
+            ptEx->eAction = EXCEPTION_ACTION_CUSTOM;
+        else
+            ptEx->eAction = EXCEPTION_ACTION_DAY_OFF;
+    }
+
+    cJSON* ptOffset = cJSON_GetObjectItem(ptItem, "timeOffsetMin");
+    if (ptOffset && cJSON_IsNumber(ptOffset))
+    {
+        int iOff = ptOffset->valueint;
+        if (iOff < -120) iOff = -120;
+        if (iOff > 120) iOff = 120;
+        ptEx->iTimeOffsetMin = (int8_t)iOff;
+    }
+
+    /* Checked against the array sizes only: templates are a separate
+       section, and the scheduler skips an index past the loaded count */
+    cJSON* ptTplIdx = cJSON_GetObjectItem(ptItem, "templateIdx");
+    if (ptTplIdx && cJSON_IsNumber(ptTplIdx))
+    {
+        if ((ptTplIdx->valueint < 0) || (ptTplIdx->valueint >= SCHEDULE_MAX_TEMPLATES))
+        {
+            *ppcError = "'templateIdx' out of range";
+            return ESP_ERR_INVALID_ARG;
+        }
+        ptEx->ucTemplateIdx = (uint8_t)ptTplIdx->valueint;
+    }
+
+    /* -1: no custom set */
+    cJSON* ptCustIdx = cJSON_GetObjectItem(ptItem, "customBellsIdx");
+    if (ptCustIdx && cJSON_IsNumber(ptCustIdx))
+    {
+        if ((ptCustIdx->valueint < -1) || (ptCustIdx->valueint >= SCHEDULE_MAX_CUSTOM_BELL_SETS))
+        {
+            *ppcError = "'customBellsIdx' out of range";
+            return ESP_ERR_INVALID_ARG;
+        }
+        ptEx->ucCustomBellsIdx = (ptCustIdx->valueint >= 0) ? (uint8_t)ptCustIdx->valueint : 0xFF;
+    }
+    return ESP_OK;
+}
+
 static esp_err_t
 handler_PostExceptions(httpd_req_t* ptReq)
 {
@@ -395,24 +691,18 @@ handler_PostExceptions(httpd_req_t* ptReq)
 
     SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
 
-    char* pcBuf = (char*)malloc(REQ_BODY_MAX);
-    if (!pcBuf) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
+    char     acEtag[SECTION_ETAG_LEN];
+    uint32_t ulGeneration;
+    if (!ifMatchGeneration(ptReq, ptRsc, SCHEDULE_SECTION_CALENDAR, &ulGeneration, acEtag)) return ESP_OK;
 
-    int iLen = readBody(ptReq, pcBuf, REQ_BODY_MAX);
-    if (iLen <= 0) { free(pcBuf); return sendError(ptReq, "400 Bad Request", "Empty body"); }
+    cJSON* ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, EXCEPTIONS_BODY_MAX, &ptRoot);
+    if (err != ESP_OK) return WS_Body_SendError(ptReq, err);
 
-    cJSON* ptRoot = cJSON_Parse(pcBuf);
-    free(pcBuf);
-    if (!ptRoot) return sendError(ptReq, "400 Bad Request", "Invalid JSON");
-
-    /* Load existing calendar to preserve holidays */
-    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)calloc(1, sizeof(SCHEDULE_DATA_T));
+    /* Only exceptions and custom sets are staged; holidays stay as the scheduler has them */
+    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
     if (!ptData) { cJSON_Delete(ptRoot); return sendError(ptReq, "500 Internal Server Error", "OOM"); }
 
-    Schedule_Data_LoadCalendar(ptData);
-
-    /* Replace exceptions */
-    ptData->ulExceptionCount = 0;
     cJSON* ptExArr = cJSON_GetObjectItem(ptRoot, "exceptions");
     if (ptExArr && cJSON_IsArray(ptExArr))
     {
@@ -427,57 +717,22 @@ handler_PostExceptions(httpd_req_t* ptReq)
 
             EXCEPTION_ENTRY_T* ptEx = &ptData->atExceptions[ptData->ulExceptionCount];
             memset(ptEx, 0, sizeof(EXCEPTION_ENTRY_T));
-            strncpy(ptEx->acStartDate, ptStart->valuestring, SCHEDULE_DATE_STR_LEN - 1);
             ptEx->ucCustomBellsIdx = 0xFF;
+            ptEx->usId = Schedule_Data_ReadItemId(ptItem);
 
-            cJSON* ptEnd = cJSON_GetObjectItem(ptItem, "endDate");
-            if (ptEnd && cJSON_IsString(ptEnd))
-                strncpy(ptEx->acEndDate, ptEnd->valuestring, SCHEDULE_DATE_STR_LEN - 1);
-
-            cJSON* ptLbl = cJSON_GetObjectItem(ptItem, "label");
-            if (ptLbl && cJSON_IsString(ptLbl))
-                strncpy(ptEx->acLabel, ptLbl->valuestring, SCHEDULE_LABEL_MAX_LEN - 1);
-
-            cJSON* ptAction = cJSON_GetObjectItem(ptItem, "action");
-            if (ptAction && cJSON_IsString(ptAction))
+            const char* pcError = NULL;
+            if (applyExceptionFields(ptEx, ptItem, &pcError) != ESP_OK)
             {
-                if (strcmp(ptAction->valuestring, "normal") == 0)
-                    ptEx->eAction = EXCEPTION_ACTION_NORMAL;
-                else if (strcmp(ptAction->valuestring, "first-shift") == 0)
-                    ptEx->eAction = EXCEPTION_ACTION_FIRST_SHIFT;
-                else if (strcmp(ptAction->valuestring, "second-shift") == 0)
-                    ptEx->eAction = EXCEPTION_ACTION_SECOND_SHIFT;
-                else if (strcmp(ptAction->valuestring, "template") == 0)
-                    ptEx->eAction = EXCEPTION_ACTION_TEMPLATE;
-                else if (strcmp(ptAction->valuestring, "custom") == 0)
-                    ptEx->eAction = EXCEPTION_ACTION_CUSTOM;
-                else
-                    ptEx->eAction = EXCEPTION_ACTION_DAY_OFF;
+                cJSON_Delete(ptRoot);
+                WS_Arena_Free(ptData);
+                return sendError(ptReq, "400 Bad Request", pcError);
             }
 
-            cJSON* ptOffset = cJSON_GetObjectItem(ptItem, "timeOffsetMin");
-            if (ptOffset && cJSON_IsNumber(ptOffset))
-            {
-                int iOff = ptOffset->valueint;
-                if (iOff < -120) iOff = -120;
-                if (iOff > 120) iOff = 120;
-                ptEx->iTimeOffsetMin = (int8_t)iOff;
-            }
-
-            cJSON* ptTplIdx = cJSON_GetObjectItem(ptItem, "templateIdx");
-            if (ptTplIdx && cJSON_IsNumber(ptTplIdx))
-                ptEx->ucTemplateIdx = (uint8_t)ptTplIdx->valueint;
-
-            cJSON* ptCustIdx = cJSON_GetObjectItem(ptItem, "customBellsIdx");
-            if (ptCustIdx && cJSON_IsNumber(ptCustIdx) && ptCustIdx->valueint >= 0)
-                ptEx->ucCustomBellsIdx = (uint8_t)ptCustIdx->valueint;
-
             ptData->ulExceptionCount++;
         }
     }
 
-    /* Replace custom bell sets */
-    ptData->ulCustomBellSetCount = 0;
+    /* Custom bell sets */
     cJSON* ptCustSets = cJSON_GetObjectItem(ptRoot, "customBellSets");
     if (ptCustSets && cJSON_IsArray(ptCustSets))
     {
@@ -492,7 +747,7 @@ handler_PostExceptions(httpd_req_t* ptReq)
             {
                 EXCEPTION_CUSTOM_BELLS_T* ptSet = &ptData->atCustomBellSets[ptData->ulCustomBellSetCount];
                 uint32_t ulTmpCount = 0;
-                parseBellArrayFromJson(ptBells, ptSet->atBells, &ulTmpCount, SCHEDULE_MAX_CUSTOM_BELLS);
+                parseBellArrayFromJson(ptBells, ptSet->atBells, &ulTmpCount, SCHEDULE_MAX_CUSTOM_BELLS, false);
                 ptSet->ucBellCount = (uint8_t)ulTmpCount;
                 ptData->ulCustomBellSetCount++;
             }
@@ -501,16 +756,9 @@ handler_PostExceptions(httpd_req_t* ptReq)
 
     cJSON_Delete(ptRoot);
 
-    esp_err_t err = Schedule_Data_SaveCalendar(ptData);
-    free(ptData);
-
-    if (err != ESP_OK) return sendError(ptReq, "500 Internal Server Error", "Failed to save");
-
-    Scheduler_ReloadSchedule(ptRsc->hScheduler);
-
-    cJSON* ptResp = cJSON_CreateObject();
-    cJSON_AddStringToObject(ptResp, "status", "ok");
-    return sendJson(ptReq, ptResp);
+    err = saveSection(ptReq, ptRsc, SCHEDULE_SECTION_CALENDAR, replaceExceptions, ptData, ulGeneration, acEtag);
+    WS_Arena_Free(ptData);
+    return err;
 }
 
 /* ================================================================== */
@@ -523,12 +771,18 @@ handler_GetTemplates(httpd_req_t* ptReq)
     const char* pcUser; const char* pcRole;
     if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
 
-    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)calloc(1, sizeof(SCHEDULE_DATA_T));
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+
+    char acEtag[SECTION_ETAG_LEN];
+    sectionEtag(ptRsc, SCHEDULE_SECTION_TEMPLATES, acEtag);
+    if (sendIfNotModified(ptReq, acEtag)) return ESP_OK;
+
+    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
     if (!ptData) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
 
     Schedule_Data_LoadTemplates(ptData);
     cJSON* ptRoot = Schedule_Data_TemplatesToJson(ptData->atTemplates, ptData->ulTemplateCount);
-    free(ptData);
+    WS_Arena_Free(ptData);
 
     return sendJson(ptReq, ptRoot);
 }
@@ -545,17 +799,15 @@ handler_PostTemplates(httpd_req_t* ptReq)
 
     SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
 
-    char* pcBuf = (char*)malloc(REQ_BODY_MAX);
-    if (!pcBuf) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
-
-    int iLen = readBody(ptReq, pcBuf, REQ_BODY_MAX);
-    if (iLen <= 0) { free(pcBuf); return sendError(ptReq, "400 Bad Request", "Empty body"); }
+    char     acEtag[SECTION_ETAG_LEN];
+    uint32_t ulGeneration;
+    if (!ifMatchGeneration(ptReq, ptRsc, SCHEDULE_SECTION_TEMPLATES, &ulGeneration, acEtag)) return ESP_OK;
 
-    cJSON* ptRoot = cJSON_Parse(pcBuf);
-    free(pcBuf);
-    if (!ptRoot) return sendError(ptReq, "400 Bad Request", "Invalid JSON");
+    cJSON* ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, TEMPLATES_BODY_MAX, &ptRoot);
+    if (err != ESP_OK) return WS_Body_SendError(ptReq, err);
 
-    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)calloc(1, sizeof(SCHEDULE_DATA_T));
+    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
     if (!ptData) { cJSON_Delete(ptRoot); return sendError(ptReq, "500 Internal Server Error", "OOM"); }
 
     ptData->ulTemplateCount = 0;
@@ -579,7 +831,7 @@ handler_PostTemplates(httpd_req_t* ptReq)
             if (ptBells && cJSON_IsArray(ptBells))
             {
                 uint32_t ulTmpCount = 0;
-                parseBellArrayFromJson(ptBells, ptTpl->atBells, &ulTmpCount, SCHEDULE_MAX_CUSTOM_BELLS);
+                parseBellArrayFromJson(ptBells, ptTpl->atBells, &ulTmpCount, SCHEDULE_MAX_CUSTOM_BELLS, false);
                 ptTpl->ucBellCount = (uint8_t)ulTmpCount;
             }
 
@@ -589,30 +841,293 @@ handler_PostTemplates(httpd_req_t* ptReq)
 
     cJSON_Delete(ptRoot);
 
-    esp_err_t err = Schedule_Data_SaveTemplates(ptData);
-    free(ptData);
+    err = saveSection(ptReq, ptRsc, SCHEDULE_SECTION_TEMPLATES, replaceTemplates, ptData, ulGeneration, acEtag);
+    WS_Arena_Free(ptData);
+    return err;
+}
 
-    if (err != ESP_OK) return sendError(ptReq, "500 Internal Server Error", "Failed to save");
+/* ================================================================== */
+/* PATCH / DELETE /api/schedule/{bells,holidays,exceptions}/{id}       */
+/* ================================================================== */
 
-    Scheduler_ReloadSchedule(ptRsc->hScheduler);
+/* Carried into the Scheduler_EditData callback. ptPatch NULL = delete. */
+typedef struct
+{
+    uint16_t    usId;
+    cJSON*      ptPatch;
+    const char* pcError;    /* 400 message when the edit returns ESP_ERR_INVALID_ARG */
+    cJSON*      ptResult;   /* updated item, built under the lock */
+} ITEM_EDIT_T;
+
+/* Trailing "/{id}" of the request URI, or SCHEDULE_ITEM_ID_NONE */
+static uint16_t
+itemIdFromUri(const char* pcUri)
+{
+    const char* pcId = strrchr(pcUri, '/');
+    if (!pcId || (pcId[1] < '0') || (pcId[1] > '9')) return SCHEDULE_ITEM_ID_NONE;
 
-    cJSON* ptResp = cJSON_CreateObject();
-    cJSON_AddStringToObject(ptResp, "status", "ok");
-    return sendJson(ptReq, ptResp);
+    char* pcEnd;
+    unsigned long ulId = strtoul(pcId + 1, &pcEnd, 10);
+    if (((*pcEnd != '\0') && (*pcEnd != '?')) || (ulId > UINT16_MAX)) return SCHEDULE_ITEM_ID_NONE;
+    return (uint16_t)ulId;
 }
 
-/* ================================================================== */
-/* GET /api/bell/status                                                */
-/* ================================================================== */
+static esp_err_t
+applyBellPatch(BELL_ENTRY_T* ptBell, const cJSON* ptPatch, const char** ppcError)
+{
+    cJSON* ptH = cJSON_GetObjectItem(ptPatch, "hour");
+    cJSON* ptM = cJSON_GetObjectItem(ptPatch, "minute");
+    cJSON* ptD = cJSON_GetObjectItem(ptPatch, "durationSec");
+    cJSON* ptL = cJSON_GetObjectItem(ptPatch, "label");
+
+    if (ptH)
+    {
+        if (!cJSON_IsNumber(ptH) || (ptH->valueint < 0) || (ptH->valueint > 23))
+        {
+            *ppcError = "'hour' must be 0-23";
+            return ESP_ERR_INVALID_ARG;
+        }
+        ptBell->ucHour = (uint8_t)ptH->valueint;
+    }
+    if (ptM)
+    {
+        if (!cJSON_IsNumber(ptM) || (ptM->valueint < 0) || (ptM->valueint > 59))
+        {
+            *ppcError = "'minute' must be 0-59";
+            return ESP_ERR_INVALID_ARG;
+        }
+        ptBell->ucMinute = (uint8_t)ptM->valueint;
+    }
+    if (ptD && cJSON_IsNumber(ptD))
+    {
+        ptBell->usDurationSec = (uint16_t)ptD->valueint;
+    }
+    if (ptL && cJSON_IsString(ptL))
+    {
+        memset(ptBell->acLabel, 0, SCHEDULE_LABEL_MAX_LEN);
+        strncpy(ptBell->acLabel, ptL->valuestring, SCHEDULE_LABEL_MAX_LEN - 1);
+    }
+    return ESP_OK;
+}
 
 static esp_err_t
-handler_GetBellStatus(httpd_req_t* ptReq)
+editBell(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    ITEM_EDIT_T* ptEdit = (ITEM_EDIT_T*)pvCtx;
+    SCHEDULE_SHIFT_T* aptShift[] = { &ptData->tFirstShift, &ptData->tSecondShift };
+
+    for (size_t s = 0; s < sizeof(aptShift) / sizeof(aptShift[0]); s++)
+    {
+        SCHEDULE_SHIFT_T* ptShift = aptShift[s];
+        for (uint32_t i = 0; i < ptShift->ulBellCount; i++)
+        {
+            if (ptShift->atBells[i].usId != ptEdit->usId) continue;
+
+            if (NULL == ptEdit->ptPatch)
+            {
+                memmove(&ptShift->atBells[i], &ptShift->atBells[i + 1],
+                        (ptShift->ulBellCount - i - 1) * sizeof(BELL_ENTRY_T));
+                ptShift->ulBellCount--;
+                return ESP_OK;
+            }
+
+            BELL_ENTRY_T tBell = ptShift->atBells[i];
+            esp_err_t err = applyBellPatch(&tBell, ptEdit->ptPatch, &ptEdit->pcError);
+            if (ESP_OK != err) return err;
+
+            /* A new time can move the bell; lists are kept in time order */
+            ptShift->atBells[i] = tBell;
+            Schedule_Data_SortBells(ptShift);
+            ptEdit->ptResult = Schedule_Data_BellToJson(&tBell);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t
+editHoliday(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    ITEM_EDIT_T* ptEdit = (ITEM_EDIT_T*)pvCtx;
+
+    for (uint32_t i = 0; i < ptData->ulHolidayCount; i++)
+    {
+        HOLIDAY_T* ptH = &ptData->atHolidays[i];
+        if (ptH->usId != ptEdit->usId) continue;
+
+        if (NULL == ptEdit->ptPatch)
+        {
+            memmove(ptH, ptH + 1, (ptData->ulHolidayCount - i - 1) * sizeof(HOLIDAY_T));
+            ptData->ulHolidayCount--;
+            return ESP_OK;
+        }
+
+        cJSON* ptS = cJSON_GetObjectItem(ptEdit->ptPatch, "startDate");
+        cJSON* ptE = cJSON_GetObjectItem(ptEdit->ptPatch, "endDate");
+        cJSON* ptL = cJSON_GetObjectItem(ptEdit->ptPatch, "label");
+
+        /* Patched on a copy so a rejected edit leaves the holiday as it was */
+        HOLIDAY_T tHoliday = *ptH;
+        if (ptS && cJSON_IsString(ptS))
+        {
+            if (!Schedule_Data_IsValidDate(ptS->valuestring))
+            {
+                ptEdit->pcError = "'startDate' must be a YYYY-MM-DD date";
+                return ESP_ERR_INVALID_ARG;
+            }
+            strncpy(tHoliday.acStartDate, ptS->valuestring, SCHEDULE_DATE_STR_LEN - 1);
+        }
+        if (ptE && cJSON_IsString(ptE))
+        {
+            if (!Schedule_Data_IsValidDate(ptE->valuestring))
+            {
+                ptEdit->pcError = "'endDate' must be a YYYY-MM-DD date";
+                return ESP_ERR_INVALID_ARG;
+            }
+            strncpy(tHoliday.acEndDate, ptE->valuestring, SCHEDULE_DATE_STR_LEN - 1);
+        }
+        if (strcmp(tHoliday.acEndDate, tHoliday.acStartDate) < 0)
+        {
+            ptEdit->pcError = "'endDate' is before 'startDate'";
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (ptL && cJSON_IsString(ptL))
+        {
+            memset(tHoliday.acLabel, 0, SCHEDULE_LABEL_MAX_LEN);
+            strncpy(tHoliday.acLabel, ptL->valuestring, SCHEDULE_LABEL_MAX_LEN - 1);
+        }
+
+        *ptH = tHoliday;
+        ptEdit->ptResult = Schedule_Data_HolidayToJson(ptH);
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t
+editException(SCHEDULE_DATA_T* ptData, void* pvCtx)
+{
+    ITEM_EDIT_T* ptEdit = (ITEM_EDIT_T*)pvCtx;
+
+    for (uint32_t i = 0; i < ptData->ulExceptionCount; i++)
+    {
+        EXCEPTION_ENTRY_T* ptEx = &ptData->atExceptions[i];
+        if (ptEx->usId != ptEdit->usId) continue;
+
+        /* Custom sets are left in place; the midnight cleanup drops unused ones */
+        if (NULL == ptEdit->ptPatch)
+        {
+            memmove(ptEx, ptEx + 1, (ptData->ulExceptionCount - i - 1) * sizeof(EXCEPTION_ENTRY_T));
+            ptData->ulExceptionCount--;
+            return ESP_OK;
+        }
+
+        EXCEPTION_ENTRY_T tEx = *ptEx;
+        esp_err_t err = applyExceptionFields(&tEx, ptEdit->ptPatch, &ptEdit->pcError);
+        if (ESP_OK != err) return err;
+
+        /* The whole schedule is loaded here, so a patched index must name
+           an entry; an index the patch leaves alone is not checked */
+        if (cJSON_GetObjectItem(ptEdit->ptPatch, "templateIdx") && (tEx.ucTemplateIdx >= ptData->ulTemplateCount))
+        {
+            ptEdit->pcError = "'templateIdx' does not name a template";
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (cJSON_GetObjectItem(ptEdit->ptPatch, "customBellsIdx") && (0xFF != tEx.ucCustomBellsIdx)
+            && (tEx.ucCustomBellsIdx >= ptData->ulCustomBellSetCount))
+        {
+            ptEdit->pcError = "'customBellsIdx' does not name a custom bell set";
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        *ptEx = tEx;
+        ptEdit->ptResult = Schedule_Data_ExceptionToJson(ptEx);
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/* Common body of the item routes: PATCH applies the JSON body, DELETE
+   removes the item. Only the addressed section is saved. */
+static esp_err_t
+handleItemEdit(httpd_req_t* ptReq, SCHEDULE_SECTION_E eSection, SCHEDULER_EDIT_FN pfnEdit)
+{
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+
+    ITEM_EDIT_T tEdit = { .usId = itemIdFromUri(ptReq->uri) };
+    if (SCHEDULE_ITEM_ID_NONE == tEdit.usId) return sendError(ptReq, "400 Bad Request", "Missing or invalid id");
+
+    /* Only parsed here; Scheduler_EditData compares it under the lock the
+       edit and save run under, so nothing can land in between */
+    char     acEtag[SECTION_ETAG_LEN];
+    uint32_t ulGeneration;
+    if (!ifMatchGeneration(ptReq, ptRsc, eSection, &ulGeneration, acEtag)) return ESP_OK;
+
+    if (ptReq->method == HTTP_PATCH)
+    {
+        esp_err_t err = WS_Body_ReadJson(ptReq, ITEM_BODY_MAX, &tEdit.ptPatch);
+        if (err != ESP_OK) return WS_Body_SendError(ptReq, err);
+
+        if (!cJSON_IsObject(tEdit.ptPatch))
+        {
+            cJSON_Delete(tEdit.ptPatch);
+            return sendError(ptReq, "400 Bad Request", "Invalid JSON");
+        }
+    }
+
+    esp_err_t err = Scheduler_EditData(ptRsc->hScheduler, eSection, pfnEdit, &tEdit, &ulGeneration);
+    cJSON_Delete(tEdit.ptPatch);
+
+    if (err == ESP_ERR_INVALID_VERSION) return sendPreconditionFailed(ptReq, ptRsc, eSection, ulGeneration, acEtag);
+    if (err == ESP_ERR_NOT_FOUND)   return sendError(ptReq, "404 Not Found", "No item with that id");
+    if (err == ESP_ERR_INVALID_ARG) return sendError(ptReq, "400 Bad Request", tEdit.pcError ? tEdit.pcError : "Invalid item");
+    if (err != ESP_OK)
+    {
+        cJSON_Delete(tEdit.ptResult);
+        return sendError(ptReq, "500 Internal Server Error", "Failed to save");
+    }
+
+    if (NULL == tEdit.ptResult) return sendSaved(ptReq, ptRsc, eSection, ulGeneration, acEtag);
+
+    formatEtag(ptRsc, eSection, ulGeneration, acEtag);
+    httpd_resp_set_hdr(ptReq, "ETag", acEtag);
+    return sendJson(ptReq, tEdit.ptResult);
+}
+
+static esp_err_t
+handler_EditBell(httpd_req_t* ptReq)
 {
     const char* pcUser; const char* pcRole;
     if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
 
-    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+    return handleItemEdit(ptReq, SCHEDULE_SECTION_BELLS, editBell);
+}
+
+static esp_err_t
+handler_EditHoliday(httpd_req_t* ptReq)
+{
+    const char* pcUser; const char* pcRole;
+    if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
+
+    return handleItemEdit(ptReq, SCHEDULE_SECTION_CALENDAR, editHoliday);
+}
+
+static esp_err_t
+handler_EditException(httpd_req_t* ptReq)
+{
+    const char* pcUser; const char* pcRole;
+    if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
+
+    return handleItemEdit(ptReq, SCHEDULE_SECTION_CALENDAR, editException);
+}
+
+/* ================================================================== */
+/* GET /api/bell/status                                                */
+/* ================================================================== */
 
+static cJSON*
+buildBellStatusJson(SCHEDULE_API_RSC_T* ptRsc)
+{
     SCHEDULER_STATUS_T tStatus;
     Scheduler_GetStatus(ptRsc->hScheduler, &tStatus);
 
@@ -660,7 +1175,113 @@ handler_GetBellStatus(httpd_req_t* ptReq)
         cJSON_AddNullToObject(ptRoot, "nextBell");
     }
 
-    return sendJson(ptReq, ptRoot);
+    return ptRoot;
+}
+
+static esp_err_t
+handler_GetBellStatus(httpd_req_t* ptReq)
+{
+    const char* pcUser; const char* pcRole;
+    if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
+
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+    return sendJson(ptReq, buildBellStatusJson(ptRsc));
+}
+
+/* ================================================================== */
+/* GET /api/schedule/all                                               */
+/* ================================================================== */
+
+/* Print one section and send it as its own chunk, so only one section's
+   text is ever held in memory. Takes ownership of ptSection. */
+static esp_err_t
+sendSectionChunk(httpd_req_t* ptReq, const char* pcName, cJSON* ptSection)
+{
+    char* pcJson = (NULL != ptSection) ? cJSON_PrintUnformatted(ptSection) : NULL;
+    cJSON_Delete(ptSection);
+
+    char acKey[24];
+    snprintf(acKey, sizeof(acKey), ",\"%s\":", pcName);
+
+    esp_err_t err = httpd_resp_send_chunk(ptReq, acKey, HTTPD_RESP_USE_STRLEN);
+    if (ESP_OK == err)
+    {
+        err = httpd_resp_send_chunk(ptReq, pcJson ? pcJson : "null", HTTPD_RESP_USE_STRLEN);
+    }
+    cJSON_free(pcJson);
+    return err;
+}
+
+/* Everything the schedule page needs in one round trip, taken from the
+   scheduler's in-memory copy (no SPIFFS reads). Each section has the same
+   shape as its own GET endpoint. */
+static esp_err_t
+handler_GetScheduleAll(httpd_req_t* ptReq)
+{
+    const char* pcUser; const char* pcRole;
+    if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
+
+    SCHEDULE_API_RSC_T* ptRsc = (SCHEDULE_API_RSC_T*)ptReq->user_ctx;
+
+    SCHEDULE_DATA_T* ptData = (SCHEDULE_DATA_T*)WS_Arena_Calloc(1, sizeof(SCHEDULE_DATA_T));
+    if (!ptData) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
+
+    /* Section tags first (see handler_GetSettings), so a client that
+       bootstraps here can still send If-Match with its edits */
+    cJSON* ptEtags = cJSON_CreateObject();
+    const struct { const char* pcName; SCHEDULE_SECTION_E eSection; } atTags[] = {
+        { "settings",   SCHEDULE_SECTION_SETTINGS  },
+        { "bells",      SCHEDULE_SECTION_BELLS     },
+        { "holidays",   SCHEDULE_SECTION_CALENDAR  },
+        { "exceptions", SCHEDULE_SECTION_CALENDAR  },
+        { "templates",  SCHEDULE_SECTION_TEMPLATES },
+    };
+    for (size_t i = 0; i < sizeof(atTags) / sizeof(atTags[0]); i++)
+    {
+        char acEtag[SECTION_ETAG_LEN];
+        sectionEtag(ptRsc, atTags[i].eSection, acEtag);
+        cJSON_AddStringToObject(ptEtags, atTags[i].pcName, acEtag);
+    }
+
+    uint32_t ulGeneration = 0;
+    Scheduler_GetData(ptRsc->hScheduler, ptData, &ulGeneration);
+
+    httpd_resp_set_type(ptReq, "application/json");
+
+    char acHead[32];
+    snprintf(acHead, sizeof(acHead), "{\"generation\":%lu", (unsigned long)ulGeneration);
+
+    esp_err_t err = httpd_resp_send_chunk(ptReq, acHead, HTTPD_RESP_USE_STRLEN);
+    if (ESP_OK == err)
+        err = sendSectionChunk(ptReq, "settings", Schedule_Data_SettingsToJson(&ptData->tSettings));
+    if (ESP_OK == err)
+        err = sendSectionChunk(ptReq, "bells", Schedule_Data_BellsToJson(&ptData->tFirstShift, &ptData->tSecondShift));
+    if (ESP_OK == err)
+        err = sendSectionChunk(ptReq, "holidays", Schedule_Data_HolidaysToJson(ptData->atHolidays, ptData->ulHolidayCount));
+    if (ESP_OK == err)
+        err = sendSectionChunk(ptReq, "exceptions", Schedule_Data_ExceptionsToJson(
+                  ptData->atExceptions, ptData->ulExceptionCount,
+                  ptData->atCustomBellSets, ptData->ulCustomBellSetCount));
+    if (ESP_OK == err)
+        err = sendSectionChunk(ptReq, "templates", Schedule_Data_TemplatesToJson(ptData->atTemplates, ptData->ulTemplateCount));
+    if (ESP_OK == err)
+        err = sendSectionChunk(ptReq, "status", buildBellStatusJson(ptRsc));
+    if (ESP_OK == err)
+        err = sendSectionChunk(ptReq, "etags", ptEtags);
+    else
+        cJSON_Delete(ptEtags);
+    if (ESP_OK == err)
+        err = httpd_resp_send_chunk(ptReq, "}", 1);
+    if (ESP_OK == err)
+        err = httpd_resp_send_chunk(ptReq, NULL, 0);
+
+    WS_Arena_Free(ptData);
+
+    if (ESP_OK != err)
+    {
+        ESP_LOGW(TAG, "schedule/all: client went away mid-response");
+    }
+    return err;
 }
 
 /* ================================================================== */
@@ -673,12 +1294,9 @@ handler_PostPanic(httpd_req_t* ptReq)
     const char* pcUser; const char* pcRole;
     if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
 
-    char acBuf[128];
-    int iLen = readBody(ptReq, acBuf, sizeof(acBuf));
-    if (iLen <= 0) return sendError(ptReq, "400 Bad Request", "Empty body");
-
-    cJSON* ptRoot = cJSON_Parse(acBuf);
-    if (!ptRoot) return sendError(ptReq, "400 Bad Request", "Invalid JSON");
+    cJSON* ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, CONTROL_BODY_MAX, &ptRoot);
+    if (err != ESP_OK) return WS_Body_SendError(ptReq, err);
 
     cJSON* ptEnabled = cJSON_GetObjectItem(ptRoot, "enabled");
     if (!ptEnabled || !cJSON_IsBool(ptEnabled))
@@ -691,7 +1309,10 @@ handler_PostPanic(httpd_req_t* ptReq)
     cJSON_Delete(ptRoot);
 
     ESP_LOGW(TAG, "Panic mode %s by user %s", bEnable ? "ENABLED" : "DISABLED", pcUser);
-    RingBell_SetPanic(bEnable);
+    if ((RingBell_SetPanic(bEnable) == ESP_OK) && bEnable)
+    {
+        Bell_Log_Record(BELL_SOURCE_PANIC, 0);
+    }
 
     cJSON* ptResp = cJSON_CreateObject();
     cJSON_AddStringToObject(ptResp, "status", "ok");
@@ -699,6 +1320,91 @@ handler_PostPanic(httpd_req_t* ptReq)
     return sendJson(ptReq, ptResp);
 }
 
+/* ================================================================== */
+/* GET /api/bell/history?from=<unix>&to=<unix>&limit=<n>               */
+/* ================================================================== */
+
+static uint32_t
+queryU32(const char* pcQuery, const char* pcKey, uint32_t ulDefault)
+{
+    char acVal[16];
+    if (httpd_query_key_value(pcQuery, pcKey, acVal, sizeof(acVal)) != ESP_OK) return ulDefault;
+
+    char* pcEnd = NULL;
+    unsigned long ulVal = strtoul(acVal, &pcEnd, 10);
+    return (pcEnd != acVal && *pcEnd == '\0') ? (uint32_t)ulVal : ulDefault;
+}
+
+static esp_err_t
+handler_GetBellHistory(httpd_req_t* ptReq)
+{
+    const char* pcUser; const char* pcRole;
+    if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
+
+    uint32_t ulFrom  = 0;
+    uint32_t ulTo    = UINT32_MAX;
+    uint32_t ulLimit = BELL_HISTORY_DEFAULT_LIMIT;
+
+    char acQuery[96];
+    if (httpd_req_get_url_query_str(ptReq, acQuery, sizeof(acQuery)) == ESP_OK)
+    {
+        ulFrom  = queryU32(acQuery, "from", ulFrom);
+        ulTo    = queryU32(acQuery, "to", ulTo);
+        ulLimit = queryU32(acQuery, "limit", ulLimit);
+    }
+    if (ulLimit == 0 || ulLimit > BELL_HISTORY_MAX_LIMIT) ulLimit = BELL_HISTORY_MAX_LIMIT;
+
+    BELL_EVENT_T* ptEvents = (BELL_EVENT_T*)WS_Arena_Calloc(ulLimit, sizeof(BELL_EVENT_T));
+    if (NULL == ptEvents) return sendError(ptReq, "500 Internal Server Error", "Out of memory");
+
+    uint32_t ulCount = 0;
+    bool bMore = false;
+    esp_err_t err = Bell_Log_Query(ulFrom, ulTo, ptEvents, ulLimit, &ulCount, &bMore);
+    if (err == ESP_ERR_INVALID_STATE)
+    {
+        WS_Arena_Free(ptEvents);
+        return sendError(ptReq, "503 Service Unavailable", "Bell history not available");
+    }
+    if (err != ESP_OK)
+    {
+        WS_Arena_Free(ptEvents);
+        return sendError(ptReq, "500 Internal Server Error", "Failed to read bell history");
+    }
+
+    cJSON* ptRoot = cJSON_CreateObject();
+    cJSON_AddNumberToObject(ptRoot, "from", (double)ulFrom);
+    cJSON_AddNumberToObject(ptRoot, "to", (double)ulTo);
+    cJSON_AddNumberToObject(ptRoot, "count", (double)ulCount);
+    cJSON_AddBoolToObject(ptRoot, "more", bMore);
+
+    cJSON* ptArr = cJSON_AddArrayToObject(ptRoot, "events");
+    for (uint32_t i = 0; i < ulCount; i++)
+    {
+        const BELL_EVENT_T* ptEv = &ptEvents[i];
+        cJSON* ptItem = cJSON_CreateObject();
+        cJSON_AddNumberToObject(ptItem, "seq", (double)ptEv->ulSeq);
+        cJSON_AddNumberToObject(ptItem, "ts", (double)ptEv->ulTimestamp);
+        cJSON_AddStringToObject(ptItem, "source", Bell_Log_SourceToStr(ptEv->eSource));
+        if (ptEv->usBellId != BELL_LOG_BELL_ID_NONE)
+        {
+            cJSON_AddNumberToObject(ptItem, "bellId", ptEv->usBellId);
+        }
+        cJSON_AddNumberToObject(ptItem, "zone", ptEv->ucZone);
+        cJSON_AddNumberToObject(ptItem, "durationSec", ptEv->usDurationSec);
+        cJSON_AddNumberToObject(ptItem, "latenessMs", (double)ptEv->lLatenessMs);
+        cJSON_AddStringToObject(ptItem, "label", ptEv->acLabel);
+        cJSON_AddItemToArray(ptArr, ptItem);
+    }
+    if (bMore && ulCount > 0)
+    {
+        /* Resume point; events sharing this second are repeated (dedupe by seq) */
+        cJSON_AddNumberToObject(ptRoot, "nextFrom", (double)ptEvents[ulCount - 1].ulTimestamp);
+    }
+
+    WS_Arena_Free(ptEvents);
+    return sendJson(ptReq, ptRoot);
+}
+
 /* ================================================================== */
 /* GET /api/system/time                                                */
 /* ================================================================== */
@@ -770,25 +1476,30 @@ handler_PostTestBell(httpd_req_t* ptReq)
 
     uint32_t ulDuration = 3; /* default 3 seconds */
 
-    char acBuf[128];
-    int iLen = readBody(ptReq, acBuf, sizeof(acBuf));
-    if (iLen > 0)
+    /* The body is optional: none or unparsable means the default */
+    cJSON* ptRoot = NULL;
+    esp_err_t err = WS_Body_ReadJson(ptReq, CONTROL_BODY_MAX, &ptRoot);
+    if ((err != ESP_OK) && (err != ESP_ERR_NOT_FOUND) && (err != ESP_ERR_INVALID_RESPONSE))
     {
-        cJSON* ptRoot = cJSON_Parse(acBuf);
-        if (ptRoot)
+        return WS_Body_SendError(ptReq, err);
+    }
+
+    if (ptRoot)
+    {
+        cJSON* ptDur = cJSON_GetObjectItem(ptRoot, "durationSec");
+        if (ptDur && cJSON_IsNumber(ptDur))
         {
-            cJSON* ptDur = cJSON_GetObjectItem(ptRoot, "durationSec");
-            if (ptDur && cJSON_IsNumber(ptDur))
-            {
-                int iVal = ptDur->valueint;
-                if (iVal >= 1 && iVal <= 30) ulDuration = (uint32_t)iVal;
-            }
-            cJSON_Delete(ptRoot);
+            int iVal = ptDur->valueint;
+            if (iVal >= 1 && iVal <= 30) ulDuration = (uint32_t)iVal;
         }
+        cJSON_Delete(ptRoot);
     }
 
     ESP_LOGI(TAG, "Test bell for %lu seconds (by %s)", (unsigned long)ulDuration, pcUser);
-    RingBell_RunForDuration(ulDuration);
+    if (RingBell_RunForDuration(ulDuration) == ESP_OK)
+    {
+        Bell_Log_Record(BELL_SOURCE_TEST, (uint16_t)ulDuration);
+    }
 
     cJSON* ptResp = cJSON_CreateObject();
     cJSON_AddStringToObject(ptResp, "status", "ok");
@@ -845,6 +1556,126 @@ handler_GetSystemInfo(httpd_req_t* ptReq)
     TimeSync_GetTimezone(acTz, sizeof(acTz));
     cJSON_AddStringToObject(ptRoot, "timezone", acTz);
 
+    /* Schedule write-behind persistence */
+    SCHEDULE_PERSIST_STATS_T tPersist;
+    Schedule_Persist_GetStats(&tPersist);
+    cJSON* ptPersist = cJSON_AddObjectToObject(ptRoot, "persistence");
+    cJSON_AddNumberToObject(ptPersist, "delayMs", (double)tPersist.ulDelayMs);
+    cJSON_AddNumberToObject(ptPersist, "pendingMask", (double)tPersist.ulPendingMask);
+    cJSON_AddNumberToObject(ptPersist, "edits", (double)tPersist.ulEditCount);
+    cJSON_AddNumberToObject(ptPersist, "coalesced", (double)tPersist.ulCoalescedCount);
+    cJSON_AddNumberToObject(ptPersist, "flushes", (double)tPersist.ulFlushCount);
+    cJSON_AddNumberToObject(ptPersist, "writeErrors", (double)tPersist.ulWriteErrors);
+    cJSON* ptWrites = cJSON_AddObjectToObject(ptPersist, "fileWrites");
+    cJSON_AddNumberToObject(ptWrites, "settings", (double)tPersist.aulWriteCount[SCHEDULE_SECTION_SETTINGS]);
+    cJSON_AddNumberToObject(ptWrites, "bells", (double)tPersist.aulWriteCount[SCHEDULE_SECTION_BELLS]);
+    cJSON_AddNumberToObject(ptWrites, "calendar", (double)tPersist.aulWriteCount[SCHEDULE_SECTION_CALENDAR]);
+    cJSON_AddNumberToObject(ptWrites, "templates", (double)tPersist.aulWriteCount[SCHEDULE_SECTION_TEMPLATES]);
+    cJSON_AddNumberToObject(ptPersist, "lastFlushUs", (double)tPersist.ulLastFlushUs);
+    cJSON_AddNumberToObject(ptPersist, "maxFlushUs", (double)tPersist.ulMaxFlushUs);
+    cJSON_AddNumberToObject(ptPersist, "lastPendingAgeMs", (double)tPersist.ulLastPendingAgeMs);
+
+    /* PSRAM cache of web assets */
+    ws_asset_cache_stats_t tAssets;
+    WS_React_AssetCache_GetStats(&tAssets);
+    cJSON* ptAssets = cJSON_AddObjectToObject(ptRoot, "assetCache");
+    cJSON_AddNumberToObject(ptAssets, "budgetBytes", (double)tAssets.budget);
+    cJSON_AddNumberToObject(ptAssets, "usedBytes", (double)tAssets.used);
+    cJSON_AddNumberToObject(ptAssets, "entries", (double)tAssets.entries);
+    cJSON_AddNumberToObject(ptAssets, "hits", (double)tAssets.hits);
+    cJSON_AddNumberToObject(ptAssets, "misses", (double)tAssets.misses);
+    cJSON_AddNumberToObject(ptAssets, "evictions", (double)tAssets.evictions);
+    cJSON_AddNumberToObject(ptAssets, "uncacheable", (double)tAssets.uncacheable);
+
+    return sendJson(ptReq, ptRoot);
+}
+
+/* ================================================================== */
+/* GET /api/system/storage                                             */
+/* ================================================================== */
+
+static int
+compareEntryBootBytes(const void* pvA, const void* pvB)
+{
+    const FLASH_STATS_ENTRY_T* ptA = (const FLASH_STATS_ENTRY_T*)pvA;
+    const FLASH_STATS_ENTRY_T* ptB = (const FLASH_STATS_ENTRY_T*)pvB;
+    if (ptA->ullBootBytes != ptB->ullBootBytes) return (ptA->ullBootBytes < ptB->ullBootBytes) ? 1 : -1;
+    return (ptA->ullBytes < ptB->ullBytes) ? 1 : (ptA->ullBytes > ptB->ullBytes) ? -1 : 0;
+}
+
+static esp_err_t
+handler_GetSystemStorage(httpd_req_t* ptReq)
+{
+    const char* pcUser; const char* pcRole;
+    if (!requireProtectedAccess(ptReq, &pcUser, &pcRole)) return ESP_OK;
+
+    const uint32_t ulMax = FLASH_STATS_MAX_ENTRIES + FLASH_STATS_AREA_COUNT;
+    FLASH_STATS_ENTRY_T* ptEntries = (FLASH_STATS_ENTRY_T*)WS_Arena_Calloc(ulMax, sizeof(FLASH_STATS_ENTRY_T));
+    if (NULL == ptEntries)
+    {
+        return sendError(ptReq, "500 Internal Server Error", "Out of memory");
+    }
+
+    FLASH_STATS_SUMMARY_T tSummary;
+    FlashStats_GetSummary(&tSummary);
+    uint32_t ulCount = FlashStats_GetEntries(ptEntries, ulMax);
+
+    /* Heaviest current writer first */
+    qsort(ptEntries, ulCount, sizeof(FLASH_STATS_ENTRY_T), compareEntryBootBytes);
+
+    cJSON* ptRoot = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptRoot, "backend", SPIFFS_GetBackendName());
+
+    size_t ulTotal = 0, ulUsed = 0;
+    if (SPIFFS_GetInfo(&ulTotal, &ulUsed) == ESP_OK)
+    {
+        cJSON_AddNumberToObject(ptRoot, "totalBytes", (double)ulTotal);
+        cJSON_AddNumberToObject(ptRoot, "usedBytes", (double)ulUsed);
+    }
+
+    cJSON_AddNumberToObject(ptRoot, "uptimeSec", (double)tSummary.ulUptimeSec);
+    cJSON_AddNumberToObject(ptRoot, "trackedSec", (double)tSummary.ulTrackedSec);
+    cJSON_AddNumberToObject(ptRoot, "saves", (double)tSummary.ulPersistCount);
+    if (UINT32_MAX != tSummary.ulLastPersistAgeSec)
+    {
+        cJSON_AddNumberToObject(ptRoot, "lastSaveAgeSec", (double)tSummary.ulLastPersistAgeSec);
+    }
+
+    /* Lifetime rate uses the whole tracked window; since-boot rate is the
+     * one that reveals a client misbehaving right now */
+    cJSON* ptAreas = cJSON_AddObjectToObject(ptRoot, "areas");
+    for (int i = 0; i < FLASH_STATS_AREA_COUNT; i++)
+    {
+        const FLASH_STATS_TOTAL_T* ptTotal = &tSummary.atArea[i];
+        cJSON* ptArea = cJSON_AddObjectToObject(ptAreas, FlashStats_AreaToStr((FLASH_STATS_AREA_E)i));
+        cJSON_AddNumberToObject(ptArea, "writes", (double)ptTotal->ulWrites);
+        cJSON_AddNumberToObject(ptArea, "bytes", (double)ptTotal->ullBytes);
+        cJSON_AddNumberToObject(ptArea, "eraseEquiv", (double)ptTotal->ulEraseEquiv);
+        cJSON_AddNumberToObject(ptArea, "bytesPerDay",
+            (tSummary.ulTrackedSec > 0) ? (double)ptTotal->ullBytes * 86400.0 / tSummary.ulTrackedSec : 0);
+        cJSON_AddNumberToObject(ptArea, "bootBytesPerDay",
+            (double)FlashStats_BootRatePerDay(ptTotal->ullBootBytes));
+    }
+
+    cJSON* ptItems = cJSON_AddArrayToObject(ptRoot, "items");
+    for (uint32_t i = 0; i < ulCount; i++)
+    {
+        const FLASH_STATS_ENTRY_T* ptEntry = &ptEntries[i];
+        cJSON* ptItem = cJSON_CreateObject();
+        cJSON_AddStringToObject(ptItem, "area", FlashStats_AreaToStr((FLASH_STATS_AREA_E)ptEntry->eArea));
+        cJSON_AddStringToObject(ptItem, "name", ptEntry->acName);
+        cJSON_AddNumberToObject(ptItem, "writes", (double)ptEntry->ulWrites);
+        cJSON_AddNumberToObject(ptItem, "bytes", (double)ptEntry->ullBytes);
+        cJSON_AddNumberToObject(ptItem, "eraseEquiv", (double)ptEntry->ulEraseEquiv);
+        cJSON_AddNumberToObject(ptItem, "bootWrites", (double)ptEntry->ulBootWrites);
+        cJSON_AddNumberToObject(ptItem, "bootBytes", (double)ptEntry->ullBootBytes);
+        cJSON_AddNumberToObject(ptItem, "bootBytesPerDay",
+                                (double)FlashStats_BootRatePerDay(ptEntry->ullBootBytes));
+        cJSON_AddBoolToObject(ptItem, "hot", FlashStats_IsHot(ptEntry->ullBootBytes));
+        cJSON_AddItemToArray(ptItems, ptItem);
+    }
+
+    WS_Arena_Free(ptEntries);
     return sendJson(ptReq, ptRoot);
 }
 
@@ -898,16 +1729,12 @@ handler_PostFactoryReset(httpd_req_t* ptReq)
 
     ESP_LOGW(TAG, "Factory reset requested by user %s", pcUser);
 
-    /* Remove current config files so CreateDefaults will regenerate them */
-    remove(SCHEDULE_FILE_SETTINGS);
-    remove(SCHEDULE_FILE_BELLS);
-    remove(SCHEDULE_FILE_CALENDAR);
-
-    /* Recreate from flashed defaults */
-    Schedule_Data_CreateDefaults();
-
-    /* Reload scheduler with fresh data */
-    Scheduler_ReloadSchedule(ptRsc->hScheduler);
+    /* Under the scheduler lock, like every other schedule write, so an
+     * upload running on another worker cannot interleave with it */
+    if (Scheduler_ResetToDefaults(ptRsc->hScheduler) != ESP_OK)
+    {
+        return sendError(ptReq, "500 Internal Server Error", "Failed to restore defaults");
+    }
 
     /* Reset timezone to what the defaults say */
     SCHEDULE_SETTINGS_T tSettings;
@@ -958,6 +1785,7 @@ ScheduleAPI_Init(const SCHEDULE_API_PARAMS_T* ptParams, SCHEDULE_API_H* phApi)
     if (NULL == ptRsc) return ESP_ERR_NO_MEM;
 
     ptRsc->hScheduler = ptParams->hScheduler;
+    ptRsc->ulBootId   = esp_random();
     *phApi = ptRsc;
     return ESP_OK;
 }
@@ -973,36 +1801,63 @@ ScheduleAPI_Register(SCHEDULE_API_H hApi, httpd_handle_t hHttpServer)
         { "/api/schedule/settings",   HTTP_GET,  handler_GetSettings,    ptRsc },
         { "/api/schedule/settings",   HTTP_POST, handler_PostSettings,   ptRsc },
         { "/api/schedule/bells",      HTTP_GET,  handler_GetBells,       ptRsc },
-        { "/api/schedule/bells",      HTTP_POST, handler_PostBells,      ptRsc },
         { "/api/schedule/holidays",   HTTP_GET,  handler_GetHolidays,    ptRsc },
-        { "/api/schedule/holidays",   HTTP_POST, handler_PostHolidays,   ptRsc },
         { "/api/schedule/exceptions", HTTP_GET,  handler_GetExceptions,  ptRsc },
-        { "/api/schedule/exceptions", HTTP_POST, handler_PostExceptions, ptRsc },
         { "/api/schedule/templates",  HTTP_GET,  handler_GetTemplates,   ptRsc },
-        { "/api/schedule/templates",  HTTP_POST, handler_PostTemplates,  ptRsc },
+        { "/api/schedule/bells/*",      HTTP_PATCH,  handler_EditBell,      ptRsc },
+        { "/api/schedule/bells/*",      HTTP_DELETE, handler_EditBell,      ptRsc },
+        { "/api/schedule/holidays/*",   HTTP_PATCH,  handler_EditHoliday,   ptRsc },
+        { "/api/schedule/holidays/*",   HTTP_DELETE, handler_EditHoliday,   ptRsc },
+        { "/api/schedule/exceptions/*", HTTP_PATCH,  handler_EditException, ptRsc },
+        { "/api/schedule/exceptions/*", HTTP_DELETE, handler_EditException, ptRsc },
+        { "/api/schedule/all",        HTTP_GET,  handler_GetScheduleAll, ptRsc },
         { "/api/bell/status",         HTTP_GET,  handler_GetBellStatus,  ptRsc },
         { "/api/bell/panic",          HTTP_POST, handler_PostPanic,      ptRsc },
         { "/api/bell/test",           HTTP_POST, handler_PostTestBell,   ptRsc },
+        { "/api/bell/history",        HTTP_GET,  handler_GetBellHistory, ptRsc },
         { "/api/system/time",         HTTP_GET,  handler_GetSystemTime,  ptRsc },
         { "/api/system/info",         HTTP_GET,  handler_GetSystemInfo,  ptRsc },
+        { "/api/system/storage",      HTTP_GET,  handler_GetSystemStorage, ptRsc },
         { "/api/system/reboot",       HTTP_POST, handler_PostReboot,     ptRsc },
-        { "/api/system/factory-reset",HTTP_POST, handler_PostFactoryReset, ptRsc },
         { "/api/system/sync-time",  HTTP_POST, handler_PostSyncTime,     ptRsc },
         { "/api/schedule/defaults",   HTTP_GET,  handler_GetDefaults,    ptRsc },
     };
 
+    /* Whole-section uploads (large bodies on slow links, full rewrites) and
+       factory reset run on the worker pool so the server task keeps serving */
+    const httpd_uri_t atSlowUris[] = {
+        { "/api/schedule/bells",      HTTP_POST, handler_PostBells,      ptRsc },
+        { "/api/schedule/holidays",   HTTP_POST, handler_PostHolidays,   ptRsc },
+        { "/api/schedule/exceptions", HTTP_POST, handler_PostExceptions, ptRsc },
+        { "/api/schedule/templates",  HTTP_POST, handler_PostTemplates,  ptRsc },
+        { "/api/system/factory-reset",HTTP_POST, handler_PostFactoryReset, ptRsc },
+    };
+
     for (size_t i = 0; i < sizeof(atUris) / sizeof(atUris[0]); i++)
     {
-        err = httpd_register_uri_handler(hHttpServer, &atUris[i]);
+        err = WS_Arena_RegisterUri(hHttpServer, &atUris[i]);
         if (err != ESP_OK)
         {
             ESP_LOGE(TAG, "Failed to register %s %s", 
-                     atUris[i].method == HTTP_GET ? "GET" : "POST", atUris[i].uri);
+                     http_method_str(atUris[i].method), atUris[i].uri);
+            return err;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(atSlowUris) / sizeof(atSlowUris[0]); i++)
+    {
+        err = WS_Async_RegisterUri(hHttpServer, &atSlowUris[i]);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Failed to register %s %s",
+                     http_method_str(atSlowUris[i].method), atSlowUris[i].uri);
             return err;
         }
     }
 
-    ESP_LOGI(TAG, "Schedule API registered (%d endpoints)", (int)(sizeof(atUris) / sizeof(atUris[0])));
+    ESP_LOGI(TAG, "Schedule API registered (%d endpoints, %d on workers)",
+             (int)(sizeof(atUris) / sizeof(atUris[0]) + sizeof(atSlowUris) / sizeof(atSlowUris[0])),
+             (int)(sizeof(atSlowUris) / sizeof(atSlowUris[0])));
     return ESP_OK;
 }
 
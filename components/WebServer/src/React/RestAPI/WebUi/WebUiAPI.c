@@ -0,0 +1,853 @@
+/* ================================================================== */
+/* WebUiAPI.c — GET/POST/DELETE /api/system/webui                      */
+/* Service-role only: replaces the served React app without a reflash. */
+/* ================================================================== */
+#include "WebUiAPI.h"
+#include "React/WS_React_FileServer.h"
+#include "Auth/WS_Auth.h"
+#include "WS_Arena.h"
+#include "WS_Async.h"
+#include "WS_Upload.h"
+#include "FatFS_API.h"
+#include "FlashStats_API.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "mbedtls/sha256.h"
+#include "sdkconfig.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "WEBUI_API";
+
+#define WEBUI_CHUNK_SIZE        4096    /* whole tar blocks: a header never straddles two chunks */
+#define WEBUI_TAR_BLOCK         512
+#define WEBUI_PATH_MAX          256
+#define WEBUI_FREE_MARGIN       (64 * 1024)     /* FAT rounds every file up to a cluster */
+#define WEBUI_CONTENT_TYPE      "application/x-tar"
+#define WEBUI_MAX_BYTES         ((size_t)CONFIG_WS_WEBUI_MAX_KB * 1024)
+
+/* ustar header fields */
+#define TAR_NAME_OFF            0
+#define TAR_NAME_LEN            100
+#define TAR_SIZE_OFF            124
+#define TAR_SIZE_LEN            12
+#define TAR_CHKSUM_OFF          148
+#define TAR_CHKSUM_LEN          8
+#define TAR_TYPE_OFF            156
+#define TAR_MAGIC_OFF           257
+#define TAR_PREFIX_OFF          345
+#define TAR_PREFIX_LEN          155
+
+/* ------------------------------------------------------------------ */
+/* Resource struct                                                     */
+/* ------------------------------------------------------------------ */
+typedef struct
+{
+    bool     bValid;
+    bool     bOk;
+    char     acResult[64];
+    char     acRoot[WS_REACT_ROOT_MAX];
+    uint32_t ulBytes;
+    uint32_t ulFiles;
+    uint32_t ulMs;
+} WEBUI_LAST_T;
+
+typedef struct _WEBUI_API_RSC_T
+{
+    bool         bBusy;         /* one upload or root change at a time */
+    WEBUI_LAST_T tLast;
+} WEBUI_API_RSC_T;
+
+/* One upload being unpacked */
+typedef struct
+{
+    const char *pcRoot;
+    FILE       *ptFile;         /* entry being written, NULL while skipping data */
+    char        acFile[WEBUI_PATH_MAX];  /* its path, for flash write accounting */
+    size_t      ulFileBytes;    /* bytes written to it so far */
+    uint64_t    ullLeft;        /* data bytes of the current entry still to come */
+    uint32_t    ulFiles;
+    uint32_t    ulZeroBlocks;
+    bool        bEnd;           /* end-of-archive marker seen */
+    bool        bPax;           /* current entry is a pax extended header */
+    size_t      ulPaxLen;
+    char        acPax[WEBUI_TAR_BLOCK];
+    char        acPaxPath[WEBUI_PATH_MAX - WS_REACT_ROOT_MAX];   /* name for the next entry */
+    mbedtls_sha256_context tSha;   /* of the whole body, checked against the header */
+    bool        bBodyRead;      /* whole body received, the connection is reusable */
+    const char *pcStatus;       /* set on failure; NULL if the client is gone */
+    const char *pcError;
+} WEBUI_UNPACK_T;
+
+/* Guards the resource; both listeners' workers share it */
+static portMUX_TYPE s_tLock = portMUX_INITIALIZER_UNLOCKED;
+
+/* ------------------------------------------------------------------ */
+/* Forward declarations                                                */
+/* ------------------------------------------------------------------ */
+static esp_err_t handler_GetWebUi(httpd_req_t *ptReq);
+static esp_err_t handler_PostWebUi(httpd_req_t *ptReq);
+static esp_err_t handler_DeleteWebUi(httpd_req_t *ptReq);
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                             */
+/* ------------------------------------------------------------------ */
+static esp_err_t
+sendJson(httpd_req_t *ptReq, cJSON *ptRoot)
+{
+    const char *pcJson = cJSON_PrintUnformatted(ptRoot);
+    auth_set_security_headers(ptReq);
+    httpd_resp_sendstr(ptReq, pcJson);
+    cJSON_free((void *)pcJson);
+    cJSON_Delete(ptRoot);
+    return ESP_OK;
+}
+
+static esp_err_t
+sendError(httpd_req_t *ptReq, const char *pcStatus, const char *pcMsg)
+{
+    cJSON *ptRoot = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptRoot, "error", pcMsg);
+    const char *pcJson = cJSON_PrintUnformatted(ptRoot);
+    auth_set_security_headers(ptReq);
+    httpd_resp_set_status(ptReq, pcStatus);
+    httpd_resp_sendstr(ptReq, pcJson);
+    cJSON_free((void *)pcJson);
+    cJSON_Delete(ptRoot);
+    return ESP_OK;
+}
+
+/**
+ * @brief Refuse an upload whose body is still on the wire: answer, then
+ *        close the socket rather than have the server drain a megabyte.
+ */
+static esp_err_t
+sendAbort(httpd_req_t *ptReq, const char *pcStatus, const char *pcMsg)
+{
+    if (NULL != pcStatus) {
+        httpd_resp_set_hdr(ptReq, "Connection", "close");
+        sendError(ptReq, pcStatus, pcMsg);
+    }
+    httpd_sess_trigger_close(ptReq->handle, httpd_req_to_sockfd(ptReq));
+    return ESP_FAIL;
+}
+
+/**
+ * @brief Require service role + CSRF check for mutating requests.
+ */
+static bool
+requireServiceAccess(httpd_req_t *ptReq)
+{
+    auth_set_security_headers(ptReq);
+
+    if ((ptReq->method == HTTP_POST || ptReq->method == HTTP_PUT || ptReq->method == HTTP_DELETE)
+        && !auth_csrf_check(ptReq)) {
+        return false;
+    }
+
+    return (auth_require_role(ptReq, "service", NULL, NULL) == ESP_OK);
+}
+
+static bool
+claimBusy(WEBUI_API_RSC_T *ptRsc)
+{
+    taskENTER_CRITICAL(&s_tLock);
+    bool bClaimed = !ptRsc->bBusy;
+    ptRsc->bBusy = true;
+    taskEXIT_CRITICAL(&s_tLock);
+    return bClaimed;
+}
+
+static void
+releaseBusy(WEBUI_API_RSC_T *ptRsc)
+{
+    taskENTER_CRITICAL(&s_tLock);
+    ptRsc->bBusy = false;
+    taskEXIT_CRITICAL(&s_tLock);
+}
+
+/* The uploaded root not being served; the other one may still be */
+static const char *
+pickSlot(void)
+{
+    ws_react_fs_info_t tInfo;
+    WS_React_FileServer_GetInfo(&tInfo);
+    return (0 == strcmp(tInfo.root, WEBUI_SLOT_ROOT_1)) ? WEBUI_SLOT_ROOT_2 : WEBUI_SLOT_ROOT_1;
+}
+
+static void
+recordLast(WEBUI_API_RSC_T *ptRsc, const WEBUI_LAST_T *ptLast)
+{
+    taskENTER_CRITICAL(&s_tLock);
+    ptRsc->tLast = *ptLast;
+    taskEXIT_CRITICAL(&s_tLock);
+}
+
+/* ------------------------------------------------------------------ */
+/* Slot directories                                                    */
+/* ------------------------------------------------------------------ */
+
+/* Everything below pcPath, then pcPath itself. A missing path is fine. */
+static void
+removeTree(const char *pcPath)
+{
+    DIR *ptDir = opendir(pcPath);
+    if (NULL == ptDir) {
+        (void)unlink(pcPath);
+        return;
+    }
+
+    char acChild[WEBUI_PATH_MAX];
+    struct dirent *ptEnt;
+    while ((ptEnt = readdir(ptDir)) != NULL) {
+        if (0 == strcmp(ptEnt->d_name, ".") || 0 == strcmp(ptEnt->d_name, "..")) continue;
+
+        int iLen = snprintf(acChild, sizeof(acChild), "%s/%s", pcPath, ptEnt->d_name);
+        if (iLen < 0 || (size_t)iLen >= sizeof(acChild)) continue;
+
+        if (DT_DIR == ptEnt->d_type) {
+            removeTree(acChild);
+        } else {
+            (void)unlink(acChild);
+        }
+    }
+    closedir(ptDir);
+    (void)rmdir(pcPath);
+}
+
+/* mkdir every directory of pcPath from offset ulFrom on, except the last component */
+static bool
+makeParents(char *pcPath, size_t ulFrom)
+{
+    for (char *pc = pcPath + ulFrom; *pc; pc++) {
+        if ('/' != *pc) continue;
+
+        *pc = '\0';
+        int iRc = mkdir(pcPath, 0755);
+        *pc = '/';
+        if (0 != iRc && EEXIST != errno) return false;
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/* ustar unpacking                                                     */
+/* ------------------------------------------------------------------ */
+static bool
+unpackFail(WEBUI_UNPACK_T *ptUnpack, const char *pcStatus, const char *pcError)
+{
+    ptUnpack->pcStatus = pcStatus;
+    ptUnpack->pcError  = pcError;
+    return false;
+}
+
+/* Closes the entry being written and accounts what reached flash, failed or not */
+static bool
+unpackCloseFile(WEBUI_UNPACK_T *ptUnpack)
+{
+    FILE *ptFile = ptUnpack->ptFile;
+    ptUnpack->ptFile = NULL;
+    if (NULL == ptFile) {
+        return true;
+    }
+
+    int iRc = fclose(ptFile);
+    FlashStats_RecordWrite(FLASH_STATS_AREA_FATFS, ptUnpack->acFile, ptUnpack->ulFileBytes);
+    if (0 != iRc) {
+        return unpackFail(ptUnpack, "507 Insufficient Storage", "Writing the bundle failed");
+    }
+    return true;
+}
+
+/* NUL- or space-terminated octal; base-256 sizes (over 8 GB) are refused */
+static uint64_t
+tarOctal(const uint8_t *pucField, size_t ulLen, bool *pbOk)
+{
+    uint64_t ullValue = 0;
+    size_t   i = 0;
+
+    if (pucField[0] & 0x80) {
+        *pbOk = false;
+        return 0;
+    }
+    while (i < ulLen && ' ' == pucField[i]) i++;
+    for (; i < ulLen && pucField[i] >= '0' && pucField[i] <= '7'; i++) {
+        ullValue = (ullValue << 3) | (uint64_t)(pucField[i] - '0');
+    }
+    if (i < ulLen && '\0' != pucField[i] && ' ' != pucField[i]) {
+        *pbOk = false;
+    }
+    return ullValue;
+}
+
+static bool
+tarChecksumOk(const uint8_t *pucBlock)
+{
+    bool     bOk = true;
+    uint64_t ullStored = tarOctal(pucBlock + TAR_CHKSUM_OFF, TAR_CHKSUM_LEN, &bOk);
+    uint32_t ulSum = 0;
+
+    for (int i = 0; i < WEBUI_TAR_BLOCK; i++) {
+        bool bField = (i >= TAR_CHKSUM_OFF) && (i < TAR_CHKSUM_OFF + TAR_CHKSUM_LEN);
+        ulSum += bField ? (uint32_t)' ' : pucBlock[i];
+    }
+    return bOk && (ullStored == ulSum);
+}
+
+/**
+ * @brief "<root>/<name>" with "." and empty components dropped. Refuses
+ *        "..", backslashes and colons, so no entry lands outside the root.
+ *        An empty result (the archive's "./") is allowed; callers decide.
+ */
+static bool
+tarPath(const char *pcRoot, const char *pcName, char *pcOut, size_t ulOutLen)
+{
+    int iLen = snprintf(pcOut, ulOutLen, "%s/%s", pcRoot, pcName);
+    if (iLen < 0 || (size_t)iLen >= ulOutLen) return false;
+
+    char *pcRel   = pcOut + strlen(pcRoot) + 1;
+    char *pcRead  = pcRel;
+    char *pcWrite = pcRel;
+    while ('\0' != *pcRead) {
+        size_t ulLen = strcspn(pcRead, "/");
+        if (2 == ulLen && 0 == strncmp(pcRead, "..", 2)) return false;
+
+        bool bSkip = (0 == ulLen) || (1 == ulLen && '.' == pcRead[0]);
+        if (!bSkip) {
+            if (pcWrite != pcRel) *pcWrite++ = '/';
+            memmove(pcWrite, pcRead, ulLen);
+            pcWrite += ulLen;
+        }
+        pcRead += ulLen;
+        if ('/' == *pcRead) pcRead++;
+    }
+    *pcWrite = '\0';
+
+    return (NULL == strpbrk(pcRel, "\\:"));
+}
+
+/* The entry's name: a pax "path" record if one came before it, else ustar prefix/name */
+static bool
+tarEntryPath(WEBUI_UNPACK_T *ptUnpack, const uint8_t *pucBlock, char *pcOut, size_t ulOutLen)
+{
+    char acName[TAR_PREFIX_LEN + 1 + TAR_NAME_LEN + 1];
+
+    if ('\0' != ptUnpack->acPaxPath[0]) {
+        bool bOk = tarPath(ptUnpack->pcRoot, ptUnpack->acPaxPath, pcOut, ulOutLen);
+        ptUnpack->acPaxPath[0] = '\0';
+        return bOk;
+    }
+
+    char acPrefix[TAR_PREFIX_LEN + 1];
+    memcpy(acPrefix, pucBlock + TAR_PREFIX_OFF, TAR_PREFIX_LEN);
+    acPrefix[TAR_PREFIX_LEN] = '\0';
+    snprintf(acName, sizeof(acName), "%s%s%.*s", acPrefix, acPrefix[0] ? "/" : "",
+             TAR_NAME_LEN, (const char *)pucBlock + TAR_NAME_OFF);
+    return tarPath(ptUnpack->pcRoot, acName, pcOut, ulOutLen);
+}
+
+/* Records are "<len> <key>=<value>\n"; only "path" matters here */
+static bool
+tarPaxParse(WEBUI_UNPACK_T *ptUnpack)
+{
+    size_t ulPos = 0;
+    while (ulPos < ptUnpack->ulPaxLen) {
+        const char *pcRec = ptUnpack->acPax + ulPos;
+        size_t      ulRec = 0;
+        size_t      i = 0;
+        for (; ulPos + i < ptUnpack->ulPaxLen && pcRec[i] >= '0' && pcRec[i] <= '9'; i++) {
+            ulRec = ulRec * 10 + (size_t)(pcRec[i] - '0');
+        }
+        if (0 == ulRec || ulRec > ptUnpack->ulPaxLen - ulPos || ' ' != pcRec[i] || '\n' != pcRec[ulRec - 1]) {
+            return unpackFail(ptUnpack, "400 Bad Request", "Malformed pax header in archive");
+        }
+
+        const char *pcKey = pcRec + i + 1;
+        size_t      ulKv  = ulRec - (i + 1) - 1;     /* "key=value" without the newline */
+        if (ulKv > 5 && 0 == strncmp(pcKey, "path=", 5)) {
+            if (ulKv - 5 >= sizeof(ptUnpack->acPaxPath)) {
+                return unpackFail(ptUnpack, "400 Bad Request", "Unsafe or too long path in archive");
+            }
+            memcpy(ptUnpack->acPaxPath, pcKey + 5, ulKv - 5);
+            ptUnpack->acPaxPath[ulKv - 5] = '\0';
+        }
+        ulPos += ulRec;
+    }
+    return true;
+}
+
+static bool
+tarHeader(WEBUI_UNPACK_T *ptUnpack, const uint8_t *pucBlock)
+{
+    bool bZero = true;
+    for (int i = 0; i < WEBUI_TAR_BLOCK && bZero; i++) {
+        bZero = (0 == pucBlock[i]);
+    }
+    if (bZero) {
+        ptUnpack->bEnd = (++ptUnpack->ulZeroBlocks >= 2);
+        return true;
+    }
+    ptUnpack->ulZeroBlocks = 0;
+
+    if (0 != memcmp(pucBlock + TAR_MAGIC_OFF, "ustar", 5) || !tarChecksumOk(pucBlock)) {
+        return unpackFail(ptUnpack, "400 Bad Request", "Not a ustar archive");
+    }
+
+    bool bOk = true;
+    ptUnpack->ullLeft = tarOctal(pucBlock + TAR_SIZE_OFF, TAR_SIZE_LEN, &bOk);
+    if (!bOk) {
+        return unpackFail(ptUnpack, "400 Bad Request", "Bad entry size in archive");
+    }
+
+    char   acPath[WEBUI_PATH_MAX];
+    size_t ulRel = strlen(ptUnpack->pcRoot) + 1;
+    char   cType = (char)pucBlock[TAR_TYPE_OFF];
+    switch (cType)
+    {
+        case '0':
+        case '\0':
+        case '7':
+            if (!tarEntryPath(ptUnpack, pucBlock, acPath, sizeof(acPath)) || '\0' == acPath[ulRel]) {
+                return unpackFail(ptUnpack, "400 Bad Request", "Unsafe or too long path in archive");
+            }
+            if (!makeParents(acPath, ulRel)) {
+                return unpackFail(ptUnpack, "507 Insufficient Storage", "Creating a directory failed");
+            }
+            ptUnpack->ptFile = fopen(acPath, "wb");
+            if (NULL == ptUnpack->ptFile) {
+                ESP_LOGE(TAG, "fopen %s failed (errno=%d)", acPath, errno);
+                return unpackFail(ptUnpack, "507 Insufficient Storage", "Creating a file failed");
+            }
+            /* Data arrives a chunk at a time already; a stdio buffer would be a second copy */
+            setvbuf(ptUnpack->ptFile, NULL, _IONBF, 0);
+            strlcpy(ptUnpack->acFile, acPath, sizeof(ptUnpack->acFile));
+            ptUnpack->ulFileBytes = 0;
+            ptUnpack->ulFiles++;
+            return (0 == ptUnpack->ullLeft) ? unpackCloseFile(ptUnpack) : true;
+
+        case '5':
+            if (!tarEntryPath(ptUnpack, pucBlock, acPath, sizeof(acPath))) {
+                return unpackFail(ptUnpack, "400 Bad Request", "Unsafe or too long path in archive");
+            }
+            if ('\0' == acPath[ulRel]) {
+                return true;    /* "./", the root itself */
+            }
+            if (!makeParents(acPath, ulRel) || (0 != mkdir(acPath, 0755) && EEXIST != errno)) {
+                return unpackFail(ptUnpack, "507 Insufficient Storage", "Creating a directory failed");
+            }
+            return true;
+
+        case 'x':
+            /* Extended header for the next entry: collected by tarFeed */
+            if (ptUnpack->ullLeft > sizeof(ptUnpack->acPax)) {
+                return unpackFail(ptUnpack, "400 Bad Request", "pax header too large, pack as ustar");
+            }
+            ptUnpack->bPax     = true;
+            ptUnpack->ulPaxLen = 0;
+            return (0 == ptUnpack->ullLeft) ? tarPaxParse(ptUnpack) : true;
+
+        case 'L':
+        case 'K':
+            return unpackFail(ptUnpack, "400 Bad Request", "GNU long names are not supported, pack as ustar");
+
+        default:
+            /* Global pax headers, links and devices: their data, if any, is skipped */
+            if ('g' != cType) {
+                ESP_LOGW(TAG, "skipping tar entry of type '%c'", cType);
+            }
+            ptUnpack->acPaxPath[0] = '\0';
+            return true;
+    }
+}
+
+/**
+ * @brief Unpack one chunk. ulLen is a multiple of WEBUI_TAR_BLOCK, and so
+ *        is every entry once padded, so entries never start mid-block.
+ */
+static bool
+tarFeed(WEBUI_UNPACK_T *ptUnpack, const uint8_t *pucChunk, size_t ulLen)
+{
+    size_t ulOff = 0;
+    while (ulOff < ulLen) {
+        if (ptUnpack->bEnd) {
+            return true;    /* tar pads the end with zero records */
+        }
+
+        if (0 == ptUnpack->ullLeft) {
+            if (!tarHeader(ptUnpack, pucChunk + ulOff)) return false;
+            ulOff += WEBUI_TAR_BLOCK;
+            continue;
+        }
+
+        /* The entry's data in this chunk, in one write */
+        size_t ulRun = ulLen - ulOff;
+        if (ptUnpack->ullLeft < ulRun) ulRun = (size_t)ptUnpack->ullLeft;
+
+        if (ptUnpack->bPax) {
+            memcpy(ptUnpack->acPax + ptUnpack->ulPaxLen, pucChunk + ulOff, ulRun);
+            ptUnpack->ulPaxLen += ulRun;
+        } else if (NULL != ptUnpack->ptFile) {
+            size_t ulWritten = fwrite(pucChunk + ulOff, 1, ulRun, ptUnpack->ptFile);
+            ptUnpack->ulFileBytes += ulWritten;
+            if (ulWritten != ulRun) {
+                return unpackFail(ptUnpack, "507 Insufficient Storage", "Writing the bundle failed");
+            }
+        }
+
+        ptUnpack->ullLeft -= ulRun;
+        ulOff += (ulRun + WEBUI_TAR_BLOCK - 1) / WEBUI_TAR_BLOCK * WEBUI_TAR_BLOCK;
+        if (0 != ptUnpack->ullLeft) continue;
+
+        if (ptUnpack->bPax) {
+            ptUnpack->bPax = false;
+            if (!tarPaxParse(ptUnpack)) return false;
+        } else if (!unpackCloseFile(ptUnpack)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* WS_Upload sink: hash and unpack each chunk before the next is read */
+static esp_err_t
+unpackChunk(void *pvCtx, const uint8_t *pucChunk, size_t ulLen)
+{
+    WEBUI_UNPACK_T *ptUnpack = (WEBUI_UNPACK_T *)pvCtx;
+
+    (void)mbedtls_sha256_update(&ptUnpack->tSha, pucChunk, ulLen);
+    return tarFeed(ptUnpack, pucChunk, ulLen) ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief Receive the body into the slot, hashing it on the way.
+ */
+static bool
+receiveBundle(httpd_req_t *ptReq, WEBUI_UNPACK_T *ptUnpack, uint8_t aucDigest[WS_UPLOAD_DIGEST_LEN])
+{
+    mbedtls_sha256_init(&ptUnpack->tSha);
+    (void)mbedtls_sha256_starts(&ptUnpack->tSha, 0);
+
+    const char *pcStatus = NULL;
+    const char *pcError  = NULL;
+    size_t      ulGot    = 0;
+    esp_err_t   err      = WS_Upload_Receive(ptReq, WEBUI_CHUNK_SIZE, false, unpackChunk, ptUnpack,
+                                             &ulGot, &pcStatus, &pcError);
+    bool        bOk      = (ESP_OK == err);
+    if (!bOk && ESP_ERR_INVALID_RESPONSE != err) {
+        unpackFail(ptUnpack, pcStatus, pcError);
+    }
+
+    (void)mbedtls_sha256_finish(&ptUnpack->tSha, aucDigest);
+    mbedtls_sha256_free(&ptUnpack->tSha);
+
+    ptUnpack->bBodyRead = (ulGot == ptReq->content_len);
+    if (bOk && 0 != ptUnpack->ullLeft) {
+        bOk = unpackFail(ptUnpack, "400 Bad Request", "Archive is truncated");
+    }
+
+    /* A file is only left open by a failure; keep its reason */
+    if (NULL != ptUnpack->ptFile) {
+        const char *pcStatus = ptUnpack->pcStatus;
+        const char *pcError  = ptUnpack->pcError;
+        (void)unpackCloseFile(ptUnpack);
+        ptUnpack->pcStatus = pcStatus;
+        ptUnpack->pcError  = pcError;
+    }
+    return bOk;
+}
+
+/* ------------------------------------------------------------------ */
+/* Init                                                                */
+/* ------------------------------------------------------------------ */
+esp_err_t
+WebUiAPI_Init(const WEBUI_API_PARAMS_T *ptParams, WEBUI_API_H *phApi)
+{
+    (void)ptParams;
+
+    if (phApi == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    WEBUI_API_RSC_T *ptRsc = (WEBUI_API_RSC_T *)calloc(1, sizeof(WEBUI_API_RSC_T));
+    if (ptRsc == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    *phApi = ptRsc;
+    return ESP_OK;
+}
+
+/* ------------------------------------------------------------------ */
+/* Register                                                            */
+/* ------------------------------------------------------------------ */
+esp_err_t
+WebUiAPI_Register(WEBUI_API_H hApi, httpd_handle_t hHttpServer)
+{
+    if (hApi == NULL || hHttpServer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    WEBUI_API_RSC_T *ptRsc = (WEBUI_API_RSC_T *)hApi;
+
+    httpd_uri_t tGetUri = {
+        .uri      = "/api/system/webui",
+        .method   = HTTP_GET,
+        .handler  = handler_GetWebUi,
+        .user_ctx = ptRsc,
+    };
+    esp_err_t err = WS_Arena_RegisterUri(hHttpServer, &tGetUri);
+
+    if (ESP_OK == err) {
+        httpd_uri_t tPostUri = {
+            .uri      = "/api/system/webui",
+            .method   = HTTP_POST,
+            .handler  = handler_PostWebUi,
+            .user_ctx = ptRsc,
+        };
+        /* Receiving and writing a bundle takes seconds */
+        err = WS_Async_RegisterUri(hHttpServer, &tPostUri);
+    }
+
+    if (ESP_OK == err) {
+        httpd_uri_t tDeleteUri = {
+            .uri      = "/api/system/webui",
+            .method   = HTTP_DELETE,
+            .handler  = handler_DeleteWebUi,
+            .user_ctx = ptRsc,
+        };
+        /* Loads the factory table and preloads the cache from flash */
+        err = WS_Async_RegisterUri(hHttpServer, &tDeleteUri);
+    }
+
+    if (ESP_OK == err) {
+        ESP_LOGI(TAG, "Web UI API registered: GET/POST/DELETE /api/system/webui");
+    }
+
+    return err;
+}
+
+/* ================================================================== */
+/* GET /api/system/webui                                               */
+/* Returns: { "root", "factory", "source", "files", "retired",         */
+/*            "switches", "busy", "fsTotalBytes", "fsFreeBytes",       */
+/*            "maxBytes", "last": {...} }                              */
+/* ================================================================== */
+static esp_err_t
+handler_GetWebUi(httpd_req_t *ptReq)
+{
+    WEBUI_API_RSC_T *ptRsc = (WEBUI_API_RSC_T *)ptReq->user_ctx;
+
+    if (!requireServiceAccess(ptReq))
+    {
+        return ESP_OK;
+    }
+
+    ws_react_fs_info_t tInfo;
+    WS_React_FileServer_GetInfo(&tInfo);
+
+    WEBUI_LAST_T tLast;
+    taskENTER_CRITICAL(&s_tLock);
+    tLast = ptRsc->tLast;
+    bool bBusy = ptRsc->bBusy;
+    taskEXIT_CRITICAL(&s_tLock);
+
+    cJSON *ptRoot = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptRoot, "root", tInfo.root);
+    cJSON_AddBoolToObject(ptRoot, "factory", 0 == strcmp(tInfo.root, WS_REACT_FACTORY_ROOT));
+    cJSON_AddStringToObject(ptRoot, "source", tInfo.from_manifest ? "manifest" : "walk");
+    cJSON_AddNumberToObject(ptRoot, "files", (double)tInfo.files);
+    cJSON_AddNumberToObject(ptRoot, "retired", (double)tInfo.retired);
+    cJSON_AddNumberToObject(ptRoot, "switches", (double)tInfo.switches);
+    cJSON_AddBoolToObject(ptRoot, "busy", bBusy);
+    cJSON_AddNumberToObject(ptRoot, "maxBytes", (double)WEBUI_MAX_BYTES);
+
+    uint64_t ullTotal = 0, ullFree = 0;
+    if (FatFS_GetInfo(&ullTotal, &ullFree) == ESP_OK)
+    {
+        cJSON_AddNumberToObject(ptRoot, "fsTotalBytes", (double)ullTotal);
+        cJSON_AddNumberToObject(ptRoot, "fsFreeBytes", (double)ullFree);
+    }
+
+    if (tLast.bValid)
+    {
+        cJSON *ptLast = cJSON_AddObjectToObject(ptRoot, "last");
+        cJSON_AddBoolToObject(ptLast, "ok", tLast.bOk);
+        cJSON_AddStringToObject(ptLast, "result", tLast.acResult);
+        cJSON_AddStringToObject(ptLast, "root", tLast.acRoot);
+        cJSON_AddNumberToObject(ptLast, "bytes", (double)tLast.ulBytes);
+        cJSON_AddNumberToObject(ptLast, "files", (double)tLast.ulFiles);
+        cJSON_AddNumberToObject(ptLast, "ms", (double)tLast.ulMs);
+    }
+
+    return sendJson(ptReq, ptRoot);
+}
+
+/* ================================================================== */
+/* POST /api/system/webui                                              */
+/* Body: ustar archive, Content-Type: application/x-tar                */
+/* Header: X-Content-SHA256: <64 hex digits of the whole body>         */
+/* Returns: { "status": "ok", "root", "files", "bytes", "ms" }         */
+/* ================================================================== */
+static esp_err_t
+handler_PostWebUi(httpd_req_t *ptReq)
+{
+    WEBUI_API_RSC_T *ptRsc = (WEBUI_API_RSC_T *)ptReq->user_ctx;
+
+    const char *pcStatus = NULL;
+    const char *pcError  = NULL;
+    if (ESP_OK != WS_Upload_CheckAccess(ptReq, WEBUI_CONTENT_TYPE, "Content-Type must be " WEBUI_CONTENT_TYPE,
+                                        &pcStatus, &pcError))
+    {
+        return sendAbort(ptReq, pcStatus, pcError);
+    }
+
+    uint8_t aucExpected[WS_UPLOAD_DIGEST_LEN];
+    if (ESP_OK != WS_Upload_GetDigest(ptReq, aucExpected))
+    {
+        return sendAbort(ptReq, "400 Bad Request", WS_UPLOAD_DIGEST_HEADER " must hold 64 hex digits");
+    }
+
+    size_t ulTotal = ptReq->content_len;
+    if (0 == ulTotal || 0 != ulTotal % WEBUI_TAR_BLOCK)
+    {
+        return sendAbort(ptReq, "400 Bad Request", "Body is not a tar archive");
+    }
+    if (ulTotal > WEBUI_MAX_BYTES)
+    {
+        return sendAbort(ptReq, "413 Payload Too Large", "Bundle is larger than CONFIG_WS_WEBUI_MAX_KB");
+    }
+
+    if (!claimBusy(ptRsc))
+    {
+        return sendAbort(ptReq, "409 Conflict", "Another web UI change is running");
+    }
+
+    /* Requests that looked up a file before the last switch may still
+     * be sending it from this slot; they take a second or two */
+    const char *pcSlot = pickSlot();
+    if (WS_React_FileServer_RootInUse(pcSlot))
+    {
+        releaseBusy(ptRsc);
+        httpd_resp_set_hdr(ptReq, "Retry-After", "2");
+        return sendAbort(ptReq, "409 Conflict", "Previous web UI still being served, retry shortly");
+    }
+
+    removeTree(pcSlot);
+    if (0 != mkdir(pcSlot, 0755))
+    {
+        ESP_LOGE(TAG, "mkdir %s failed (errno=%d)", pcSlot, errno);
+        releaseBusy(ptRsc);
+        return sendAbort(ptReq, "507 Insufficient Storage", "Cannot create the staging directory");
+    }
+
+    uint64_t ullFsTotal = 0, ullFsFree = 0;
+    if ((FatFS_GetInfo(&ullFsTotal, &ullFsFree) == ESP_OK) && (ullFsFree < ulTotal + WEBUI_FREE_MARGIN))
+    {
+        ESP_LOGW(TAG, "bundle of %u bytes, %llu free", (unsigned)ulTotal, (unsigned long long)ullFsFree);
+        removeTree(pcSlot);
+        releaseBusy(ptRsc);
+        return sendAbort(ptReq, "507 Insufficient Storage", "Not enough free space for the bundle");
+    }
+
+    ESP_LOGI(TAG, "receiving %u byte bundle into %s", (unsigned)ulTotal, pcSlot);
+    int64_t llStart = esp_timer_get_time();
+
+    WEBUI_UNPACK_T tUnpack = { .pcRoot = pcSlot };
+    uint8_t        aucActual[WS_UPLOAD_DIGEST_LEN];
+    bool           bOk = receiveBundle(ptReq, &tUnpack, aucActual);
+
+    if (bOk && 0 != memcmp(aucActual, aucExpected, WS_UPLOAD_DIGEST_LEN))
+    {
+        bOk = unpackFail(&tUnpack, "400 Bad Request", "SHA-256 does not match " WS_UPLOAD_DIGEST_HEADER);
+    }
+
+    /* The switch: the served root changes only once the slot is complete */
+    if (bOk)
+    {
+        esp_err_t err = WS_React_FileServer_SetRoot(pcSlot);
+        if (ESP_ERR_NOT_FOUND == err)
+        {
+            bOk = unpackFail(&tUnpack, "422 Unprocessable Entity", "Bundle has no index.html");
+        }
+        else if (ESP_OK != err)
+        {
+            bOk = unpackFail(&tUnpack, "500 Internal Server Error", "Loading the bundle failed");
+        }
+    }
+
+    WEBUI_LAST_T tLast = {
+        .bValid  = true,
+        .bOk     = bOk,
+        .ulBytes = (uint32_t)ulTotal,
+        .ulFiles = tUnpack.ulFiles,
+        .ulMs    = (uint32_t)((esp_timer_get_time() - llStart) / 1000),
+    };
+    strlcpy(tLast.acRoot, pcSlot, sizeof(tLast.acRoot));
+    strlcpy(tLast.acResult, bOk ? "ok" : tUnpack.pcError, sizeof(tLast.acResult));
+    recordLast(ptRsc, &tLast);
+
+    if (!bOk)
+    {
+        ESP_LOGW(TAG, "web UI upload refused: %s", tUnpack.pcError);
+        removeTree(pcSlot);
+        releaseBusy(ptRsc);
+        return tUnpack.bBodyRead ? sendError(ptReq, tUnpack.pcStatus, tUnpack.pcError)
+                                 : sendAbort(ptReq, tUnpack.pcStatus, tUnpack.pcError);
+    }
+
+    releaseBusy(ptRsc);
+    ESP_LOGI(TAG, "web UI now served from %s: %u files in %u ms",
+             pcSlot, (unsigned)tLast.ulFiles, (unsigned)tLast.ulMs);
+
+    cJSON *ptResp = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptResp, "status", "ok");
+    cJSON_AddStringToObject(ptResp, "root", pcSlot);
+    cJSON_AddNumberToObject(ptResp, "files", (double)tLast.ulFiles);
+    cJSON_AddNumberToObject(ptResp, "bytes", (double)tLast.ulBytes);
+    cJSON_AddNumberToObject(ptResp, "ms", (double)tLast.ulMs);
+    return sendJson(ptReq, ptResp);
+}
+
+/* ================================================================== */
+/* DELETE /api/system/webui                                            */
+/* Serves the factory root again. The uploaded slots stay on flash     */
+/* until the next upload overwrites one.                               */
+/* Returns: { "status": "ok", "root": "/react" }                       */
+/* ================================================================== */
+static esp_err_t
+handler_DeleteWebUi(httpd_req_t *ptReq)
+{
+    WEBUI_API_RSC_T *ptRsc = (WEBUI_API_RSC_T *)ptReq->user_ctx;
+
+    if (!requireServiceAccess(ptReq))
+    {
+        return ESP_OK;
+    }
+
+    if (!claimBusy(ptRsc))
+    {
+        return sendError(ptReq, "409 Conflict", "Another web UI change is running");
+    }
+
+    esp_err_t err = WS_React_FileServer_SetRoot(WS_REACT_FACTORY_ROOT);
+    releaseBusy(ptRsc);
+
+    if (ESP_OK != err)
+    {
+        ESP_LOGE(TAG, "back to factory web UI failed (%s)", esp_err_to_name(err));
+        return sendError(ptReq, "500 Internal Server Error", "Factory web UI did not load");
+    }
+
+    cJSON *ptResp = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptResp, "status", "ok");
+    cJSON_AddStringToObject(ptResp, "root", WS_REACT_FACTORY_ROOT);
+    return sendJson(ptReq, ptResp);
+}
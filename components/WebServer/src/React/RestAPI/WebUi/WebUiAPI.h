@@ -0,0 +1,35 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/**
+ * Web UI updates over HTTP.
+ *
+ * A bundle is a ustar archive of the built app (what scripts/gen_asset_manifest.py
+ * stages, asset-manifest.json included). It is unpacked, 4 KB at a time,
+ * into whichever of WEBUI_SLOT_ROOT_1 / WEBUI_SLOT_ROOT_2 is not being
+ * served, and only becomes live once the SHA-256 of the upload matches the
+ * X-Content-SHA256 header and the slot has an index.html. The factory root
+ * (/react, flashed with the image) is never written.
+ */
+
+#define WEBUI_SLOT_ROOT_1   "/react/.ui1"
+#define WEBUI_SLOT_ROOT_2   "/react/.ui2"
+
+typedef struct _WEBUI_API_RSC_T *WEBUI_API_H;
+
+typedef struct
+{
+    int reserved;   /* Drives WS_React_FileServer directly */
+} WEBUI_API_PARAMS_T;
+
+/**
+ * @brief Initialize Web UI API resource.
+ */
+esp_err_t WebUiAPI_Init(const WEBUI_API_PARAMS_T *ptParams, WEBUI_API_H *phApi);
+
+/**
+ * @brief Register GET/POST/DELETE /api/system/webui handlers.
+ */
+esp_err_t WebUiAPI_Register(WEBUI_API_H hApi, httpd_handle_t hHttpServer);
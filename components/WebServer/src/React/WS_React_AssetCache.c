@@ -0,0 +1,298 @@
+#include "WS_React_AssetCache.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "WS_ASSET_CACHE";
+
+#define WS_CACHE_BUDGET_BYTES   ((size_t)CONFIG_WS_ASSET_CACHE_BUDGET_KB * 1024)
+#define WS_CACHE_MAX_FILE_BYTES ((size_t)CONFIG_WS_ASSET_CACHE_MAX_FILE_KB * 1024)
+
+// Doubly linked LRU list: head is the most recently used entry.
+// Only a handful of files are ever cached, so lookups are linear.
+static SemaphoreHandle_t      s_lock = NULL;
+static ws_cached_asset_t*     s_head = NULL;
+static ws_cached_asset_t*     s_tail = NULL;
+static ws_asset_cache_stats_t s_stats;
+static uint32_t               s_generation = 0;
+
+// ----------------------------------------------------------------
+// List helpers (caller holds s_lock)
+// ----------------------------------------------------------------
+static void lru_unlink(ws_cached_asset_t* a)
+{
+    if (a->prev) a->prev->next = a->next; else s_head = a->next;
+    if (a->next) a->next->prev = a->prev; else s_tail = a->prev;
+    a->prev = NULL;
+    a->next = NULL;
+}
+
+static void lru_push_front(ws_cached_asset_t* a)
+{
+    a->prev = NULL;
+    a->next = s_head;
+    if (s_head) s_head->prev = a; else s_tail = a;
+    s_head = a;
+}
+
+static ws_cached_asset_t* lru_find(const char* path)
+{
+    for (ws_cached_asset_t* a = s_head; a; a = a->next)
+    {
+        if (strcmp(a->path, path) == 0)
+        {
+            return a;
+        }
+    }
+    return NULL;
+}
+
+static void asset_free(ws_cached_asset_t* a)
+{
+    heap_caps_free(a->data);
+    free(a->path);
+    free(a);
+}
+
+// Remove from the cache; a pinned entry is freed by its last release.
+static void asset_drop(ws_cached_asset_t* a)
+{
+    lru_unlink(a);
+    a->linked = false;
+    s_stats.used -= (uint32_t)a->size;
+    s_stats.entries--;
+    if (a->refs == 0)
+    {
+        asset_free(a);
+    }
+}
+
+// ----------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------
+esp_err_t WS_React_AssetCache_Init(void)
+{
+    if (s_lock)
+    {
+        return ESP_OK;
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.budget = (uint32_t)WS_CACHE_BUDGET_BYTES;
+
+    ESP_LOGI(TAG, "asset cache: %u KB budget, files up to %u KB",
+             (unsigned)CONFIG_WS_ASSET_CACHE_BUDGET_KB,
+             (unsigned)CONFIG_WS_ASSET_CACHE_MAX_FILE_KB);
+    return ESP_OK;
+}
+
+const ws_cached_asset_t* WS_React_AssetCache_Acquire(const char* path)
+{
+    if (!s_lock || !path)
+    {
+        return NULL;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ws_cached_asset_t* a = lru_find(path);
+    if (a)
+    {
+        a->refs++;
+        if (a != s_head)
+        {
+            lru_unlink(a);
+            lru_push_front(a);
+        }
+        s_stats.hits++;
+    }
+    else
+    {
+        s_stats.misses++;
+    }
+    xSemaphoreGive(s_lock);
+
+    return a;
+}
+
+void WS_React_AssetCache_Release(const ws_cached_asset_t* asset)
+{
+    if (!asset || !s_lock)
+    {
+        return;
+    }
+
+    ws_cached_asset_t* a = (ws_cached_asset_t*)asset;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (a->refs > 0)
+    {
+        a->refs--;
+    }
+    bool release = (a->refs == 0) && !a->linked;
+    xSemaphoreGive(s_lock);
+
+    if (release)
+    {
+        asset_free(a);
+    }
+}
+
+uint8_t* WS_React_AssetCache_Alloc(size_t size)
+{
+    if (!s_lock || (WS_CACHE_BUDGET_BYTES == 0))
+    {
+        return NULL;
+    }
+
+    uint8_t* data = NULL;
+    if ((size > 0) && (size <= WS_CACHE_MAX_FILE_BYTES) && (size <= WS_CACHE_BUDGET_BYTES))
+    {
+        data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    }
+
+    if (!data)
+    {
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_stats.uncacheable++;
+        xSemaphoreGive(s_lock);
+    }
+    return data;
+}
+
+const ws_cached_asset_t* WS_React_AssetCache_Insert(const char* path,
+                                                    uint8_t*    data,
+                                                    size_t      size,
+                                                    const char* mime,
+                                                    const char* cache_control,
+                                                    const char* etag,
+                                                    const char* encoding,
+                                                    uint32_t    generation)
+{
+    if (!s_lock || !path || !data)
+    {
+        heap_caps_free(data);
+        return NULL;
+    }
+
+    ws_cached_asset_t* a = (ws_cached_asset_t*)calloc(1, sizeof(ws_cached_asset_t));
+    char*              p = strdup(path);
+    if (!a || !p)
+    {
+        free(a);
+        free(p);
+        heap_caps_free(data);
+        return NULL;
+    }
+
+    a->path          = p;
+    a->data          = data;
+    a->size          = size;
+    a->mime          = mime;
+    a->cache_control = cache_control;
+    a->encoding      = encoding;
+    a->refs          = 1;
+    strlcpy(a->etag, etag ? etag : "", sizeof(a->etag));
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    // Another request may have filled the same file meanwhile
+    ws_cached_asset_t* old = lru_find(path);
+    if (old)
+    {
+        asset_drop(old);
+    }
+
+    // Evict from the cold end, skipping files still being sent
+    ws_cached_asset_t* victim = s_tail;
+    while (victim && ((size_t)s_stats.used + size > WS_CACHE_BUDGET_BYTES))
+    {
+        ws_cached_asset_t* prev = victim->prev;
+        if (victim->refs == 0)
+        {
+            ESP_LOGD(TAG, "evict %s (%u B)", victim->path, (unsigned)victim->size);
+            asset_drop(victim);
+            s_stats.evictions++;
+        }
+        victim = prev;
+    }
+
+    if (generation != s_generation)
+    {
+        // Read before a Clear: the file may belong to assets that were replaced
+        s_stats.uncacheable++;
+    }
+    else if ((size_t)s_stats.used + size <= WS_CACHE_BUDGET_BYTES)
+    {
+        a->linked = true;
+        lru_push_front(a);
+        s_stats.used += (uint32_t)size;
+        s_stats.entries++;
+        s_stats.insertions++;
+    }
+    else
+    {
+        s_stats.uncacheable++;
+    }
+
+    xSemaphoreGive(s_lock);
+    return a;
+}
+
+void WS_React_AssetCache_Clear(void)
+{
+    if (!s_lock)
+    {
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    while (s_head)
+    {
+        asset_drop(s_head);
+    }
+    s_generation++;
+    xSemaphoreGive(s_lock);
+}
+
+uint32_t WS_React_AssetCache_Generation(void)
+{
+    if (!s_lock)
+    {
+        return 0;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint32_t generation = s_generation;
+    xSemaphoreGive(s_lock);
+    return generation;
+}
+
+void WS_React_AssetCache_GetStats(ws_asset_cache_stats_t* stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    if (!s_lock)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
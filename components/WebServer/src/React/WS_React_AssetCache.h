@@ -0,0 +1,95 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define WS_ASSET_CACHE_ETAG_LEN 24
+
+/**
+ * A cached file together with the header values it is served with, so a hit
+ * needs neither the filesystem nor the asset table. mime, cache_control and
+ * encoding are not copied: pass string literals or strings that are never freed.
+ */
+typedef struct ws_cached_asset
+{
+    char*        path;              // absolute FS path, the cache key
+    uint8_t*     data;              // PSRAM
+    size_t       size;
+    const char*  mime;
+    const char*  cache_control;
+    const char*  encoding;          // Content-Encoding value, NULL for identity
+    char         etag[WS_ASSET_CACHE_ETAG_LEN];
+
+    // Private — owned by WS_React_AssetCache.c
+    uint32_t                refs;
+    bool                    linked;
+    struct ws_cached_asset* prev;
+    struct ws_cached_asset* next;
+} ws_cached_asset_t;
+
+typedef struct
+{
+    uint32_t budget;            // bytes
+    uint32_t used;              // bytes held by cached files
+    uint32_t entries;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t insertions;
+    uint32_t evictions;
+    uint32_t uncacheable;       // misses that were too large or found no room
+} ws_asset_cache_stats_t;
+
+/**
+ * @brief Create the cache with the CONFIG_WS_ASSET_CACHE_BUDGET_KB budget.
+ *        Safe to call more than once.
+ */
+esp_err_t WS_React_AssetCache_Init(void);
+
+/**
+ * @brief Look up a file and pin it until WS_React_AssetCache_Release.
+ * @return The entry (now most recently used) or NULL on a miss.
+ */
+const ws_cached_asset_t* WS_React_AssetCache_Acquire(const char* path);
+
+void WS_React_AssetCache_Release(const ws_cached_asset_t* asset);
+
+/**
+ * @brief Allocate a PSRAM buffer for a file about to be inserted.
+ * @return NULL if the cache is disabled, the file exceeds the per-file or
+ *         total budget, or PSRAM is exhausted — stream the file instead.
+ */
+uint8_t* WS_React_AssetCache_Alloc(size_t size);
+
+/**
+ * @brief Current generation; WS_React_AssetCache_Clear starts a new one.
+ *        Read it before deciding a file is worth caching.
+ */
+uint32_t WS_React_AssetCache_Generation(void);
+
+/**
+ * @brief Insert a file read into a buffer from WS_React_AssetCache_Alloc.
+ *        Takes ownership of data and evicts least recently used files until
+ *        it fits. If pinned files leave no room, or the cache was cleared
+ *        since generation was read, the entry is still returned but is
+ *        freed on release instead of being kept.
+ * @return The pinned entry, or NULL (data freed) if out of memory.
+ */
+const ws_cached_asset_t* WS_React_AssetCache_Insert(const char* path,
+                                                    uint8_t*    data,
+                                                    size_t      size,
+                                                    const char* mime,
+                                                    const char* cache_control,
+                                                    const char* etag,
+                                                    const char* encoding,
+                                                    uint32_t    generation);
+
+/**
+ * @brief Drop every file (call after the web assets change). Files still
+ *        being sent are freed when their last holder releases them, and
+ *        files read before the call are no longer kept.
+ */
+void WS_React_AssetCache_Clear(void);
+
+void WS_React_AssetCache_GetStats(ws_asset_cache_stats_t* stats);
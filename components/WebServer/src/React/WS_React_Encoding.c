@@ -0,0 +1,161 @@
+#include "WS_React_Encoding.h"
+
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+// Indexed by ws_react_enc_t
+static const char* const s_enc_token[WS_REACT_ENC_COUNT] = { "identity", "gzip", "br" };
+
+const char* WS_React_Encoding_Token(ws_react_enc_t enc)
+{
+    return (enc < WS_REACT_ENC_COUNT) ? s_enc_token[enc] : NULL;
+}
+
+const char* WS_React_Encoding_Header(ws_react_enc_t enc)
+{
+    return ((enc == WS_REACT_ENC_IDENTITY) || (enc >= WS_REACT_ENC_COUNT)) ? NULL : s_enc_token[enc];
+}
+
+// "0", "0.5", "1.000" -> 0, 500, 1000
+static uint16_t parse_qvalue(const char* s)
+{
+    uint32_t q = 0;
+    if (*s == '1')
+    {
+        return WS_REACT_Q_MAX;
+    }
+    if (*s++ != '0')
+    {
+        return WS_REACT_Q_MAX;  // malformed: treat as acceptable
+    }
+    if (*s++ == '.')
+    {
+        for (int i = 0, scale = 100; (i < 3) && isdigit((unsigned char)*s); i++, s++, scale /= 10)
+        {
+            q += (uint32_t)(*s - '0') * (uint32_t)scale;
+        }
+    }
+    return (uint16_t)q;
+}
+
+// Weight from the ";q=" parameter in [params, end), full weight if absent
+static uint16_t param_qvalue(const char* params, const char* end)
+{
+    for (const char* p = params; p + 1 < end; p++)
+    {
+        if (((p[0] == 'q') || (p[0] == 'Q')) && (p[1] == '='))
+        {
+            return parse_qvalue(p + 2);
+        }
+    }
+    return WS_REACT_Q_MAX;
+}
+
+void WS_React_Encoding_ParseAccept(const char* value, uint16_t q[WS_REACT_ENC_COUNT])
+{
+    if (!value)
+    {
+        for (int e = 0; e < WS_REACT_ENC_COUNT; e++)
+        {
+            q[e] = WS_REACT_Q_MAX;
+        }
+        return;
+    }
+
+    bool seen[WS_REACT_ENC_COUNT] = { false };
+    int  star = -1;
+
+    // Walked in place: the header value is not copied or modified
+    for (const char* tok = value; *tok; )
+    {
+        size_t      tok_len = strcspn(tok, ",");
+        const char* next    = tok + tok_len + ((tok[tok_len] == ',') ? 1 : 0);
+
+        while ((tok_len > 0) && ((*tok == ' ') || (*tok == '\t')))
+        {
+            tok++;
+            tok_len--;
+        }
+
+        size_t      name_len = strcspn(tok, " \t;,");
+        const char* params   = memchr(tok, ';', tok_len);
+        uint16_t    weight   = params ? param_qvalue(params, tok + tok_len) : WS_REACT_Q_MAX;
+
+        if ((name_len == 1) && (tok[0] == '*'))
+        {
+            star = weight;
+        }
+        else if ((name_len == 6) && (strncasecmp(tok, "x-gzip", 6) == 0))
+        {
+            seen[WS_REACT_ENC_GZIP] = true;
+            q[WS_REACT_ENC_GZIP]    = weight;
+        }
+        else
+        {
+            for (int e = 0; e < WS_REACT_ENC_COUNT; e++)
+            {
+                if ((strlen(s_enc_token[e]) == name_len) && (strncasecmp(tok, s_enc_token[e], name_len) == 0))
+                {
+                    seen[e] = true;
+                    q[e]    = weight;
+                }
+            }
+        }
+        tok = next;
+    }
+
+    for (int e = 0; e < WS_REACT_ENC_COUNT; e++)
+    {
+        if (!seen[e])
+        {
+            if (e == WS_REACT_ENC_IDENTITY)
+            {
+                q[e] = (star == 0) ? 0 : WS_REACT_Q_MAX;
+            }
+            else
+            {
+                q[e] = (star > 0) ? (uint16_t)star : 0;
+            }
+        }
+    }
+}
+
+ws_react_enc_t WS_React_Encoding_Choose(const ws_react_enc_avail_t avail[WS_REACT_ENC_COUNT],
+                                        const uint16_t             q[WS_REACT_ENC_COUNT])
+{
+    static const ws_react_enc_t order[] = { WS_REACT_ENC_BR, WS_REACT_ENC_GZIP, WS_REACT_ENC_IDENTITY };
+    ws_react_enc_t best = WS_REACT_ENC_COUNT;
+
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+    {
+        const ws_react_enc_avail_t* v = &avail[order[i]];
+        if (v->stored && (q[order[i]] > 0) &&
+            ((best == WS_REACT_ENC_COUNT) || (v->size < avail[best].size)))
+        {
+            best = order[i];
+        }
+    }
+    return best;
+}
+
+void WS_React_Encoding_Negotiate(const char*                accept_encoding,
+                                 const ws_react_enc_avail_t avail[WS_REACT_ENC_COUNT],
+                                 ws_react_negotiation_t*    out)
+{
+    uint16_t q[WS_REACT_ENC_COUNT];
+    WS_React_Encoding_ParseAccept(accept_encoding, q);
+
+    out->enc              = WS_React_Encoding_Choose(avail, q);
+    out->inflate          = false;
+    out->content_encoding = WS_React_Encoding_Header(out->enc);
+    out->vary             = "Accept-Encoding";
+
+    if ((out->enc == WS_REACT_ENC_COUNT) && (q[WS_REACT_ENC_IDENTITY] > 0) &&
+        avail[WS_REACT_ENC_GZIP].stored)
+    {
+        // The body goes out decoded, so no Content-Encoding
+        out->enc     = WS_REACT_ENC_GZIP;
+        out->inflate = true;
+    }
+}
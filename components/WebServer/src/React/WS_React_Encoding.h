@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Content-coding negotiation for WS_React_FileServer. Plain C with no
+// ESP-IDF dependencies, so test/ builds it for the host as well.
+
+// Accept-Encoding qvalues are kept in thousandths
+#define WS_REACT_Q_MAX          1000
+
+// Stored content codings of an asset (data/ build emits .gz and .br)
+typedef enum
+{
+    WS_REACT_ENC_IDENTITY = 0,
+    WS_REACT_ENC_GZIP,
+    WS_REACT_ENC_BR,
+    WS_REACT_ENC_COUNT,
+    WS_REACT_ENC_NEGOTIATE = WS_REACT_ENC_COUNT,    // choose from Accept-Encoding
+} ws_react_enc_t;
+
+// One stored variant of an asset, as far as negotiation cares
+typedef struct
+{
+    bool     stored;
+    uint32_t size;
+} ws_react_enc_avail_t;
+
+// How a negotiated request is answered. Header values are literals, or
+// NULL when the header is not sent.
+typedef struct
+{
+    ws_react_enc_t enc;                 // variant to read; WS_REACT_ENC_COUNT: 406
+    bool           inflate;             // enc is gzip, sent inflated as identity
+    const char*    content_encoding;
+    const char*    vary;
+} ws_react_negotiation_t;
+
+/**
+ * @brief Coding token as used in Accept-Encoding and the manifest
+ *        ("identity", "gzip", "br").
+ */
+const char* WS_React_Encoding_Token(ws_react_enc_t enc);
+
+/**
+ * @brief Content-Encoding value for a variant sent as stored; NULL for identity.
+ */
+const char* WS_React_Encoding_Header(ws_react_enc_t enc);
+
+/**
+ * @brief Fill q[] (thousandths) per coding from an Accept-Encoding value.
+ *
+ * NULL (no header) means anything goes. A coding not listed takes the "*"
+ * weight, except identity, which stays acceptable unless "identity;q=0" or
+ * "*;q=0" excludes it (RFC 9110 §12.5.3). "x-gzip" counts as gzip.
+ */
+void WS_React_Encoding_ParseAccept(const char* value, uint16_t q[WS_REACT_ENC_COUNT]);
+
+/**
+ * @brief Smallest stored variant the client accepts; ties go to br, then gzip.
+ * @return WS_REACT_ENC_COUNT if none is acceptable.
+ */
+ws_react_enc_t WS_React_Encoding_Choose(const ws_react_enc_avail_t avail[WS_REACT_ENC_COUNT],
+                                        const uint16_t             q[WS_REACT_ENC_COUNT]);
+
+/**
+ * @brief Pick the variant and response headers for one request.
+ *
+ * Vary: Accept-Encoding is always set. A client that accepts neither stored
+ * coding but allows identity gets the gzip variant inflated; if nothing fits,
+ * out->enc is WS_REACT_ENC_COUNT and the answer is 406.
+ */
+void WS_React_Encoding_Negotiate(const char*                accept_encoding,
+                                 const ws_react_enc_avail_t avail[WS_REACT_ENC_COUNT],
+                                 ws_react_negotiation_t*    out);
@@ -2,12 +2,23 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <assert.h>
 
 #include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "miniz.h"
+#include "cJSON.h"
+#include "NVS_Config.h"
+#include "sdkconfig.h"
+
+#include "WS_React_AssetCache.h"
 
 static const char* TAG = "WS_FILE_SERVER";
 
@@ -15,133 +26,915 @@ static const char* TAG = "WS_FILE_SERVER";
 // for large compressed JS/CSS bundles compared to the original 1 KB.
 #define WS_FILE_CHUNK_SIZE 4096
 
+// The manifest lists a handful of files and is a few hundred bytes per entry
+#define WS_MANIFEST_MAX_SIZE    (16 * 1024)
+#define WS_MANIFEST_VERSION     2
+#define WS_ETAG_LEN             24      // quotes + up to 20 chars + NUL
+#define WS_WALK_PATH_MAX        256
+
+// Root chosen by WS_React_FileServer_SetRoot; unset means the factory root
+#define WS_NVS_NAMESPACE        "webui"
+#define WS_NVS_KEY_ROOT         "root"
+
+#define WS_CACHE_IMMUTABLE      "public, max-age=31536000, immutable"
+#define WS_CACHE_REVALIDATE     "no-cache"
+
+// One stored file of an asset; fs_path is NULL if the coding is not stored
+typedef struct
+{
+    char*    fs_path;           // "/react/assets/index-abc.js.br"
+    char     etag[WS_ETAG_LEN];
+    uint32_t size;
+} ws_react_variant_t;
+
+// Everything needed to answer a request, resolved when the root is loaded.
+// mime is a literal or interned (mime_intern), so the PSRAM cache may keep
+// it after the table is gone.
+struct ws_react_asset
+{
+    char*                  uri;     // "/assets/index-abc.js"
+    const char*            mime;
+    bool                   immutable;
+    bool                   preload; // index.html and hashed bundles go to PSRAM on load
+    ws_react_variant_t     variant[WS_REACT_ENC_COUNT];
+    struct ws_react_table* table;
+};
+
+// One generation of the asset table: everything served from one root.
+// A lookup pins the table until the asset is served, so a root switch
+// never frees it under a request.
+typedef struct ws_react_table
+{
+    char                    root[WS_REACT_ROOT_MAX];
+    ws_react_asset_t*       assets;     // sorted by uri for binary search
+    size_t                  count;
+    const ws_react_asset_t* index;
+    bool                    from_manifest;
+    uint32_t                refs;       // 1 while current, +1 per looked-up asset
+    struct ws_react_table*  next;       // live tables, current and retired
+} ws_react_table_t;
+
+// A manifest MIME type the table below lacks; kept for good
+typedef struct ws_mime_extra
+{
+    struct ws_mime_extra* next;
+    char                  mime[];
+} ws_mime_extra_t;
+
+// Indexed by ws_react_enc_t
+static const char* const s_enc_suffix[WS_REACT_ENC_COUNT] = { "", ".gz", ".br" };
+
+static ws_react_table_t* s_table      = NULL;     // current
+static ws_react_table_t* s_tables     = NULL;     // every live table
+static uint32_t          s_switches   = 0;
+static portMUX_TYPE      s_lock       = portMUX_INITIALIZER_UNLOCKED;
+
+// Table builds run one at a time; they alone touch s_mime_extra
+static SemaphoreHandle_t s_build_lock = NULL;
+static ws_mime_extra_t*  s_mime_extra = NULL;
+
+static const ws_react_asset_t* table_find(const ws_react_table_t* t, const char* uri, size_t len);
+static void cache_preload(const ws_react_table_t* t);
+
 // ----------------------------------------------------------------
 // MIME type detection
 // ----------------------------------------------------------------
+static const struct
+{
+    const char* ext;
+    const char* mime;
+} s_mime_types[] =
+{
+    { ".html", "text/html" },
+    { ".js",   "application/javascript" },
+    { ".css",  "text/css" },
+    { ".json", "application/json" },
+    { ".svg",  "image/svg+xml" },
+    { ".png",  "image/png" },
+    { ".jpg",  "image/jpeg" },
+    { ".jpeg", "image/jpeg" },
+    { ".ico",  "image/x-icon" },
+    { ".wasm", "application/wasm" },
+};
+
+// Coding named by a ".gz"/".br" suffix of the first len bytes of path
+static ws_react_enc_t enc_from_suffix(const char* path, size_t len)
+{
+    for (int e = WS_REACT_ENC_GZIP; e < WS_REACT_ENC_COUNT; e++)
+    {
+        size_t n = strlen(s_enc_suffix[e]);
+        if ((len > n) && (strncmp(path + len - n, s_enc_suffix[e], n) == 0))
+        {
+            return (ws_react_enc_t)e;
+        }
+    }
+    return WS_REACT_ENC_IDENTITY;
+}
+
 const char* WS_React_FileServer_GetMime(const char* path)
 {
     assert(path);
 
-    if (strstr(path, ".html")) return "text/html";
-    if (strstr(path, ".js"))   return "application/javascript";
-    if (strstr(path, ".css"))  return "text/css";
-    if (strstr(path, ".json")) return "application/json";
-    if (strstr(path, ".svg"))  return "image/svg+xml";
-    if (strstr(path, ".png"))  return "image/png";
-    if (strstr(path, ".jpg"))  return "image/jpeg";
-    if (strstr(path, ".jpeg")) return "image/jpeg";
-    if (strstr(path, ".ico"))  return "image/x-icon";
-    if (strstr(path, ".wasm")) return "application/wasm";
+    // Match the real extension only: ".js" must not catch ".json"
+    size_t len = strlen(path);
+    len -= strlen(s_enc_suffix[enc_from_suffix(path, len)]);
+
+    size_t dot = len;
+    while ((dot > 0) && (path[dot - 1] != '.') && (path[dot - 1] != '/'))
+    {
+        dot--;
+    }
+    if ((dot == 0) || (path[dot - 1] != '.'))
+    {
+        return "text/plain";
+    }
+
+    const char* ext     = path + dot - 1;
+    size_t      ext_len = len - (dot - 1);
+    for (size_t i = 0; i < sizeof(s_mime_types) / sizeof(s_mime_types[0]); i++)
+    {
+        if ((strlen(s_mime_types[i].ext) == ext_len) &&
+            (strncasecmp(ext, s_mime_types[i].ext, ext_len) == 0))
+        {
+            return s_mime_types[i].mime;
+        }
+    }
 
     return "text/plain";
 }
 
+// Caller holds s_build_lock
+static const char* mime_intern(const char* mime)
+{
+    for (ws_mime_extra_t* m = s_mime_extra; m; m = m->next)
+    {
+        if (strcmp(m->mime, mime) == 0)
+        {
+            return m->mime;
+        }
+    }
+
+    size_t           len = strlen(mime) + 1;
+    ws_mime_extra_t* m   = (ws_mime_extra_t*)malloc(sizeof(ws_mime_extra_t) + len);
+    if (!m)
+    {
+        return NULL;
+    }
+    memcpy(m->mime, mime, len);
+    m->next      = s_mime_extra;
+    s_mime_extra = m;
+    return m->mime;
+}
+
 // ----------------------------------------------------------------
-// Internal helpers
+// Request header helpers
 // ----------------------------------------------------------------
-static bool fs_file_exists(const char* path)
+// Returns a heap copy of a request header, or NULL if absent
+static char* req_header_dup(httpd_req_t* req, const char* field)
 {
-    struct stat st;
-    return (stat(path, &st) == 0);
+    size_t len = httpd_req_get_hdr_value_len(req, field);
+    if (len == 0)
+    {
+        return NULL;
+    }
+
+    char* value = (char*)malloc(len + 1);
+    if (value && (httpd_req_get_hdr_value_str(req, field, value, len + 1) != ESP_OK))
+    {
+        free(value);
+        value = NULL;
+    }
+    return value;
 }
 
-static bool uri_ends_with_gz(const char* uri)
+// If-None-Match may be "*", a single tag or a comma-separated list, each
+// possibly weak (W/"..."). Weak comparison is correct for If-None-Match,
+// so finding our quoted tag anywhere in the value is a match.
+static bool etag_matches(const char* if_none_match, const char* etag)
 {
-    if (!uri) return false;
-    size_t len = strlen(uri);
-    return (len >= 3) && (strcmp(uri + len - 3, ".gz") == 0);
+    while (*if_none_match == ' ' || *if_none_match == '\t')
+    {
+        if_none_match++;
+    }
+    if (*if_none_match == '*')
+    {
+        return true;
+    }
+    return (strstr(if_none_match, etag) != NULL);
+}
+
+static bool request_etag_matches(httpd_req_t* req, const char* etag)
+{
+    char* value = req_header_dup(req, "If-None-Match");
+    if (!value)
+    {
+        return false;
+    }
+
+    bool match = etag_matches(value, etag);
+    free(value);
+    return match;
 }
 
 // ----------------------------------------------------------------
-// Path resolution
+// Table construction
 // ----------------------------------------------------------------
-esp_err_t WS_React_FileServer_ResolvePath(const char* uri,
-                                          char*        out_path,
-                                          size_t       out_len,
-                                          bool*        out_gz)
+static int asset_compare(const void* a, const void* b)
 {
-    if (!uri || !out_path || !out_gz || (out_len == 0))
+    return strcmp(((const ws_react_asset_t*)a)->uri, ((const ws_react_asset_t*)b)->uri);
+}
+
+static void asset_free_strings(ws_react_asset_t* a)
+{
+    free(a->uri);
+    for (int e = 0; e < WS_REACT_ENC_COUNT; e++)
     {
-        return ESP_ERR_INVALID_ARG;
+        free(a->variant[e].fs_path);
+    }
+}
+
+static char* fs_path_dup(const char* root, const char* rel)
+{
+    size_t len  = strlen(root) + strlen(rel) + 2;
+    char*  path = (char*)malloc(len);
+    if (path)
+    {
+        snprintf(path, len, "%s/%s", root, rel);
     }
+    return path;
+}
 
-    // Root: try .gz then plain index.html
-    if (strcmp(uri, "/") == 0)
+static void table_free(ws_react_table_t* t)
+{
+    for (size_t i = 0; i < t->count; i++)
     {
-        snprintf(out_path, out_len, "/react/index.html.gz");
-        if (fs_file_exists(out_path))
+        asset_free_strings(&t->assets[i]);
+    }
+    free(t->assets);
+    free(t);
+}
+
+// ----------------------------------------------------------------
+// Table source 1: the build-time manifest
+// ----------------------------------------------------------------
+static bool manifest_add_variants(const char* dir, ws_react_asset_t* a, const cJSON* variants)
+{
+    bool   any = false;
+    cJSON* v   = NULL;
+    cJSON_ArrayForEach(v, variants)
+    {
+        const cJSON* encoding = cJSON_GetObjectItem(v, "encoding");
+        const cJSON* file     = cJSON_GetObjectItem(v, "file");
+        const cJSON* hash     = cJSON_GetObjectItem(v, "hash");
+        const cJSON* size     = cJSON_GetObjectItem(v, "size");
+        if (!cJSON_IsString(encoding) || !cJSON_IsString(file) || !cJSON_IsString(hash) ||
+            !cJSON_IsNumber(size) || (strlen(hash->valuestring) > WS_ETAG_LEN - 3))
         {
-            *out_gz = true;
-            return ESP_OK;
+            continue;
         }
 
-        snprintf(out_path, out_len, "/react/index.html");
-        if (fs_file_exists(out_path))
+        for (int e = 0; e < WS_REACT_ENC_COUNT; e++)
         {
-            *out_gz = false;
-            return ESP_OK;
+            ws_react_variant_t* var = &a->variant[e];
+            if ((strcmp(encoding->valuestring, WS_React_Encoding_Token((ws_react_enc_t)e)) != 0) || var->fs_path)
+            {
+                continue;
+            }
+
+            var->fs_path = fs_path_dup(dir, file->valuestring);
+            if (!var->fs_path)
+            {
+                return false;
+            }
+            var->size = (uint32_t)size->valuedouble;
+            snprintf(var->etag, sizeof(var->etag), "\"%s\"", hash->valuestring);
+            any = true;
         }
+    }
+    return any;
+}
 
-        ESP_LOGW(TAG, "index.html not found (tried .gz and plain)");
+static esp_err_t table_from_manifest(const char* dir, ws_react_asset_t** out, size_t* out_count)
+{
+    char path[WS_WALK_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/" WS_REACT_MANIFEST_NAME, dir);
+
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
         return ESP_ERR_NOT_FOUND;
     }
 
-    // Client requested pre-compressed asset: serve as-is
-    if (uri_ends_with_gz(uri))
+    struct stat st;
+    if ((fstat(fileno(f), &st) != 0) || (st.st_size <= 0) ||
+        (st.st_size > WS_MANIFEST_MAX_SIZE))
+    {
+        fclose(f);
+        ESP_LOGE(TAG, "asset manifest has invalid size");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char* text = (char*)malloc((size_t)st.st_size + 1);
+    if (!text)
+    {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t r = fread(text, 1, (size_t)st.st_size, f);
+    fclose(f);
+    text[r] = '\0';
+
+    cJSON* root = cJSON_Parse(text);
+    free(text);
+
+    const cJSON* version = cJSON_GetObjectItem(root, "version");
+    cJSON*       files   = cJSON_GetObjectItem(root, "files");
+    if (!cJSON_IsArray(files) || !cJSON_IsNumber(version) ||
+        (version->valueint != WS_MANIFEST_VERSION))
+    {
+        cJSON_Delete(root);
+        ESP_LOGE(TAG, "asset manifest is malformed or not version %d", WS_MANIFEST_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    size_t count = (size_t)cJSON_GetArraySize(files);
+    ws_react_asset_t* assets = (ws_react_asset_t*)calloc(count ? count : 1, sizeof(ws_react_asset_t));
+    if (!assets)
     {
-        snprintf(out_path, out_len, "/react%s", uri);
-        if (fs_file_exists(out_path))
+        cJSON_Delete(root);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t used = 0;
+    cJSON* item = NULL;
+    cJSON_ArrayForEach(item, files)
+    {
+        const cJSON* path = cJSON_GetObjectItem(item, "path");
+        if (!cJSON_IsString(path) || (path->valuestring[0] != '/'))
         {
-            *out_gz = true;
-            return ESP_OK;
+            ESP_LOGW(TAG, "skipping malformed manifest entry");
+            continue;
+        }
+
+        ws_react_asset_t* a = &assets[used];
+        a->uri = strdup(path->valuestring);
+        if (!a->uri || !manifest_add_variants(dir, a, cJSON_GetObjectItem(item, "variants")))
+        {
+            ESP_LOGW(TAG, "skipping manifest entry %s", path->valuestring);
+            asset_free_strings(a);
+            memset(a, 0, sizeof(*a));
+            continue;
+        }
+        used++;
+
+        a->immutable = cJSON_IsTrue(cJSON_GetObjectItem(item, "immutable"));
+        a->mime      = WS_React_FileServer_GetMime(a->uri);
+
+        // Prefer the manifest's type for extensions the table above lacks
+        const cJSON* mime = cJSON_GetObjectItem(item, "mime");
+        if ((strcmp(a->mime, "text/plain") == 0) && cJSON_IsString(mime))
+        {
+            const char* interned = mime_intern(mime->valuestring);
+            if (interned)
+            {
+                a->mime = interned;
+            }
+        }
+    }
+    cJSON_Delete(root);
+
+    *out       = assets;
+    *out_count = used;
+    return ESP_OK;
+}
+
+// ----------------------------------------------------------------
+// Table source 2: one walk of the root (no manifest on this image)
+// ----------------------------------------------------------------
+typedef struct
+{
+    const char*       root;
+    ws_react_asset_t* items;
+    size_t            count;
+    size_t            capacity;
+} ws_walk_t;
+
+static ws_react_asset_t* walk_asset_for(ws_walk_t* w, const char* uri, size_t uri_len)
+{
+    for (size_t i = 0; i < w->count; i++)
+    {
+        if ((strncmp(w->items[i].uri, uri, uri_len) == 0) && (w->items[i].uri[uri_len] == '\0'))
+        {
+            return &w->items[i];
+        }
+    }
+
+    if (w->count == w->capacity)
+    {
+        size_t cap = w->capacity ? (w->capacity * 2) : 16;
+        ws_react_asset_t* grown = (ws_react_asset_t*)realloc(w->items, cap * sizeof(ws_react_asset_t));
+        if (!grown)
+        {
+            return NULL;
         }
+        w->items    = grown;
+        w->capacity = cap;
+    }
+
+    ws_react_asset_t* a = &w->items[w->count];
+    memset(a, 0, sizeof(*a));
+    a->uri = strndup(uri, uri_len);
+    if (!a->uri)
+    {
+        return NULL;
+    }
+    a->mime = WS_React_FileServer_GetMime(a->uri);
+    w->count++;
+    return a;
+}
+
+static bool walk_add(ws_walk_t* w, const char* rel, const struct stat* st)
+{
+    char uri[WS_WALK_PATH_MAX];
+    snprintf(uri, sizeof(uri), "/%s", rel);
+
+    size_t         len = strlen(uri);
+    ws_react_enc_t enc = enc_from_suffix(uri, len);
+    len -= strlen(s_enc_suffix[enc]);
+
+    ws_react_asset_t* a = walk_asset_for(w, uri, len);
+    if (!a)
+    {
+        return false;
+    }
+
+    ws_react_variant_t* v = &a->variant[enc];
+    v->fs_path = fs_path_dup(w->root, rel);
+    if (!v->fs_path)
+    {
+        return false;
+    }
+    v->size = (uint32_t)st->st_size;
+    snprintf(v->etag, sizeof(v->etag), "\"%lx-%llx\"",
+             (unsigned long)st->st_size, (unsigned long long)st->st_mtime);
+    return true;
+}
+
+static void walk_dir(ws_walk_t* w, const char* rel_dir)
+{
+    char dir_path[WS_WALK_PATH_MAX];
+    snprintf(dir_path, sizeof(dir_path), "%s%s%s", w->root, rel_dir[0] ? "/" : "", rel_dir);
+
+    DIR* d = opendir(dir_path);
+    if (!d)
+    {
+        ESP_LOGW(TAG, "opendir %s failed (errno=%d)", dir_path, errno);
+        return;
+    }
 
-        ESP_LOGW(TAG, "gz asset not found: %s (errno=%d)", out_path, errno);
+    // Dot names are skipped, which also keeps uploaded roots (/react/.ui1)
+    // out of a walk of the factory root
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL)
+    {
+        if (e->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        char rel[WS_WALK_PATH_MAX];
+        char full[WS_WALK_PATH_MAX];
+        int  n = snprintf(rel, sizeof(rel), "%s%s%s", rel_dir, rel_dir[0] ? "/" : "", e->d_name);
+        if ((n < 0) || ((size_t)n >= sizeof(rel) - 1))
+        {
+            continue;
+        }
+        snprintf(full, sizeof(full), "%s/%s", w->root, rel);
+
+        struct stat st;
+        if (stat(full, &st) != 0)
+        {
+            continue;
+        }
+
+        if (S_ISDIR(st.st_mode))
+        {
+            walk_dir(w, rel);
+        }
+        else if (!walk_add(w, rel, &st))
+        {
+            break;
+        }
+    }
+    closedir(d);
+}
+
+static esp_err_t table_from_walk(const char* root, ws_react_asset_t** out, size_t* out_count)
+{
+    ws_walk_t w = { .root = root };
+    walk_dir(&w, "");
+
+    if (w.count == 0)
+    {
+        free(w.items);
         return ESP_ERR_NOT_FOUND;
     }
 
-    // Try compressed version first
-    snprintf(out_path, out_len, "/react%s.gz", uri);
-    if (fs_file_exists(out_path))
+    *out       = w.items;
+    *out_count = w.count;
+    return ESP_OK;
+}
+
+// ----------------------------------------------------------------
+// Asset table
+// ----------------------------------------------------------------
+// Caller holds s_build_lock. The table comes back unpublished, refs 0.
+static esp_err_t table_build(const char* root, ws_react_table_t** out)
+{
+    ws_react_table_t* t = (ws_react_table_t*)calloc(1, sizeof(ws_react_table_t));
+    if (!t)
     {
-        *out_gz = true;
-        ESP_LOGI(TAG, "resolved to gz: %s", out_path);
-        return ESP_OK;
+        return ESP_ERR_NO_MEM;
     }
+    strlcpy(t->root, root, sizeof(t->root));
+
+    ws_react_asset_t* assets = NULL;
+    size_t            count  = 0;
+    t->from_manifest = true;
 
-    // Fallback to plain file
-    snprintf(out_path, out_len, "/react%s", uri);
-    if (fs_file_exists(out_path))
+    esp_err_t espErr = table_from_manifest(root, &assets, &count);
+    if (ESP_OK != espErr)
+    {
+        ESP_LOGW(TAG, "no usable asset manifest in %s (%s) — walking it, no long-lived caching",
+                 root, esp_err_to_name(espErr));
+        t->from_manifest = false;
+        espErr = table_from_walk(root, &assets, &count);
+        if (ESP_OK != espErr)
+        {
+            ESP_LOGE(TAG, "no web assets found under %s", root);
+            free(t);
+            return espErr;
+        }
+    }
+
+    qsort(assets, count, sizeof(ws_react_asset_t), asset_compare);
+
+    // Drop duplicate URIs and the manifest itself
+    size_t kept = 0;
+    size_t immutable = 0;
+    size_t brotli = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        ws_react_asset_t* a = &assets[i];
+        if (((kept > 0) && (strcmp(assets[kept - 1].uri, a->uri) == 0)) ||
+            (strcmp(a->uri, "/" WS_REACT_MANIFEST_NAME) == 0))
+        {
+            asset_free_strings(a);
+            continue;
+        }
+
+        a->preload = a->immutable || (strcmp(a->uri, "/index.html") == 0);
+        a->table   = t;
+        immutable += a->immutable ? 1 : 0;
+        brotli    += a->variant[WS_REACT_ENC_BR].fs_path ? 1 : 0;
+        assets[kept++] = *a;
+    }
+
+    t->assets = assets;
+    t->count  = kept;
+    t->index  = table_find(t, "/index.html", strlen("/index.html"));
+
+    ESP_LOGI(TAG, "asset table of %s from %s: %u files (%u immutable, %u with br)%s",
+             root, t->from_manifest ? "manifest" : "directory walk",
+             (unsigned)kept, (unsigned)immutable, (unsigned)brotli,
+             t->index ? "" : " — index.html missing");
+
+    *out = t;
+    return ESP_OK;
+}
+
+static ws_react_table_t* table_pin(void)
+{
+    taskENTER_CRITICAL(&s_lock);
+    ws_react_table_t* t = s_table;
+    if (t)
+    {
+        t->refs++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return t;
+}
+
+static void table_unpin(ws_react_table_t* t)
+{
+    bool last = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (--t->refs == 0)
+    {
+        for (ws_react_table_t** pp = &s_tables; *pp; pp = &(*pp)->next)
+        {
+            if (*pp == t)
+            {
+                *pp = t->next;
+                break;
+            }
+        }
+        last = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (last)
+    {
+        ESP_LOGI(TAG, "asset table of %s released", t->root);
+        table_free(t);
+    }
+}
+
+// Caller holds s_build_lock
+static void table_publish(ws_react_table_t* t)
+{
+    t->refs = 1;
+
+    taskENTER_CRITICAL(&s_lock);
+    ws_react_table_t* old = s_table;
+    t->next  = s_tables;
+    s_tables = t;
+    s_table  = t;
+    if (old)
+    {
+        s_switches++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    // Cached files are keyed by path under the old root: they would only
+    // hold budget, and must be gone before that root is written again.
+    // Requests of the old table that read a file meanwhile cannot put it
+    // back, because the generation changes here.
+    if (old)
+    {
+        WS_React_AssetCache_Clear();
+    }
+
+#if CONFIG_WS_ASSET_CACHE_PRELOAD
+    cache_preload(t);
+#endif
+
+    if (old)
+    {
+        table_unpin(old);
+    }
+}
+
+esp_err_t WS_React_FileServer_Init(void)
+{
+    if (s_table)
     {
-        *out_gz = false;
-        ESP_LOGI(TAG, "resolved to plain: %s", out_path);
         return ESP_OK;
     }
 
-    ESP_LOGW(TAG, "file not found for URI %s (errno=%d)", uri, errno);
-    return ESP_ERR_NOT_FOUND;
+    // The cache works for walked tables too (filled on first access)
+    (void)WS_React_AssetCache_Init();
+
+    if (!s_build_lock)
+    {
+        s_build_lock = xSemaphoreCreateMutex();
+        if (!s_build_lock)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    char root[WS_REACT_ROOT_MAX];
+    if (NVS_Config_GetStr(WS_NVS_NAMESPACE, WS_NVS_KEY_ROOT, root, sizeof(root)) != ESP_OK)
+    {
+        strlcpy(root, WS_REACT_FACTORY_ROOT, sizeof(root));
+    }
+
+    xSemaphoreTake(s_build_lock, portMAX_DELAY);
+    ws_react_table_t* t = NULL;
+    esp_err_t espErr = table_build(root, &t);
+
+    // An uploaded root that no longer loads must not leave the device without a UI
+    if ((strcmp(root, WS_REACT_FACTORY_ROOT) != 0) && ((ESP_OK != espErr) || !t->index))
+    {
+        ESP_LOGE(TAG, "web UI root %s unusable — back to %s", root, WS_REACT_FACTORY_ROOT);
+        if (t)
+        {
+            table_free(t);
+            t = NULL;
+        }
+        espErr = table_build(WS_REACT_FACTORY_ROOT, &t);
+    }
+
+    if (ESP_OK == espErr)
+    {
+        table_publish(t);
+    }
+    xSemaphoreGive(s_build_lock);
+    return espErr;
+}
+
+esp_err_t WS_React_FileServer_SetRoot(const char* root)
+{
+    if (!root || (root[0] != '/') || (strlen(root) >= WS_REACT_ROOT_MAX))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_build_lock)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_build_lock, portMAX_DELAY);
+
+    ws_react_table_t* t = NULL;
+    esp_err_t espErr = table_build(root, &t);
+    if ((ESP_OK == espErr) && !t->index)
+    {
+        table_free(t);
+        espErr = ESP_ERR_NOT_FOUND;
+    }
+
+    // Saved before the switch, so a reboot right after serves what the
+    // caller was told is live
+    if (ESP_OK == espErr)
+    {
+        espErr = (strcmp(root, WS_REACT_FACTORY_ROOT) == 0)
+               ? NVS_Config_EraseKey(WS_NVS_NAMESPACE, WS_NVS_KEY_ROOT)
+               : NVS_Config_SetStr(WS_NVS_NAMESPACE, WS_NVS_KEY_ROOT, root);
+        if (ESP_OK == espErr)
+        {
+            espErr = NVS_Config_Flush();
+        }
+        if (ESP_OK != espErr)
+        {
+            ESP_LOGE(TAG, "saving web UI root failed (%s)", esp_err_to_name(espErr));
+            table_free(t);
+        }
+    }
+
+    if (ESP_OK == espErr)
+    {
+        table_publish(t);
+        ESP_LOGI(TAG, "serving web UI from %s", root);
+    }
+
+    xSemaphoreGive(s_build_lock);
+    return espErr;
+}
+
+bool WS_React_FileServer_RootInUse(const char* root)
+{
+    bool used = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    for (const ws_react_table_t* t = s_tables; t && !used; t = t->next)
+    {
+        used = (strcmp(t->root, root) == 0);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return used;
+}
+
+void WS_React_FileServer_GetInfo(ws_react_fs_info_t* info)
+{
+    memset(info, 0, sizeof(*info));
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s_table)
+    {
+        strlcpy(info->root, s_table->root, sizeof(info->root));
+        info->from_manifest = s_table->from_manifest;
+        info->files         = (uint32_t)s_table->count;
+    }
+    for (const ws_react_table_t* t = s_tables; t; t = t->next)
+    {
+        info->retired += (t != s_table) ? 1 : 0;
+    }
+    info->switches = s_switches;
+    taskEXIT_CRITICAL(&s_lock);
 }
 
 // ----------------------------------------------------------------
-// Chunked file sender
+// Path resolution
 // ----------------------------------------------------------------
-esp_err_t WS_React_FileServer_ServeFile(httpd_req_t* req,
-                                        const char*  path,
-                                        const char*  mime,
-                                        bool         is_gz)
+static const ws_react_asset_t* table_find(const ws_react_table_t* t, const char* uri, size_t len)
 {
-    assert(req && path && mime);
+    size_t lo = 0;
+    size_t hi = t->count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        const char* key = t->assets[mid].uri;
+        int c = strncmp(key, uri, len);
+        if ((c == 0) && (key[len] != '\0'))
+        {
+            c = 1;      // key is longer than the URI
+        }
 
-    FILE* f = fopen(path, "rb");
-    if (!f)
+        if (c == 0)
+        {
+            return &t->assets[mid];
+        }
+        if (c < 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+static const ws_react_asset_t* table_lookup(const ws_react_table_t* t, const char* uri,
+                                            ws_react_enc_t* out_enc)
+{
+    size_t len = strcspn(uri, "?");
+    if (len == 1)
     {
-        ESP_LOGE(TAG, "fopen failed: %s (errno=%d)", path, errno);
-        return httpd_resp_send_404(req);
+        return t->index;
+    }
+
+    const ws_react_asset_t* a = table_find(t, uri, len);
+    if (a)
+    {
+        return a;
     }
 
+    // Client asked for a stored compressed file by name: serve it as-is
+    ws_react_enc_t enc = enc_from_suffix(uri, len);
+    if (enc != WS_REACT_ENC_IDENTITY)
+    {
+        a = table_find(t, uri, len - strlen(s_enc_suffix[enc]));
+        if (a && a->variant[enc].fs_path)
+        {
+            *out_enc = enc;
+            return a;
+        }
+    }
+    return NULL;
+}
+
+const ws_react_asset_t* WS_React_FileServer_Lookup(const char*     uri,
+                                                   ws_react_enc_t* out_enc)
+{
+    if (!uri || (uri[0] != '/') || !out_enc)
+    {
+        return NULL;
+    }
+
+    *out_enc = WS_REACT_ENC_NEGOTIATE;
+
+    ws_react_table_t* t = table_pin();
+    if (!t)
+    {
+        return NULL;
+    }
+
+    const ws_react_asset_t* a = table_lookup(t, uri, out_enc);
+    if (!a)
+    {
+        table_unpin(t);
+    }
+    return a;
+}
+
+void WS_React_FileServer_Release(const ws_react_asset_t* asset)
+{
+    if (asset)
+    {
+        table_unpin(asset->table);
+    }
+}
+
+// ----------------------------------------------------------------
+// Response helpers
+// ----------------------------------------------------------------
+static const char* asset_cache_control(const ws_react_asset_t* asset)
+{
+    return asset->immutable ? WS_CACHE_IMMUTABLE : WS_CACHE_REVALIDATE;
+}
+
+// Validator headers first: a 304 carries these and nothing else.
+static void set_validator_headers(httpd_req_t* req, const char* etag,
+                                  const char* cache_control, const char* vary)
+{
     (void)httpd_resp_set_hdr(req, "X-Content-Type-Options", "nosniff");
+    (void)httpd_resp_set_hdr(req, "ETag", etag);
+    (void)httpd_resp_set_hdr(req, "Cache-Control", cache_control);
+    if (vary)
+    {
+        (void)httpd_resp_set_hdr(req, "Vary", vary);
+    }
+}
+
+static void set_content_headers(httpd_req_t* req, const char* mime, const char* encoding)
+{
     (void)httpd_resp_set_hdr(req, "X-Frame-Options", "DENY");
-    (void)httpd_resp_set_hdr(req, "Cache-Control", "no-store");
     (void)httpd_resp_set_type(req, mime);
 
     if (strstr(mime, "text/html") != NULL)
@@ -151,15 +944,145 @@ esp_err_t WS_React_FileServer_ServeFile(httpd_req_t* req,
             "img-src 'self' data:; connect-src 'self'");
     }
 
-    if (is_gz)
+    if (encoding)
+    {
+        (void)httpd_resp_set_hdr(req, "Content-Encoding", encoding);
+    }
+}
+
+static esp_err_t send_not_modified(httpd_req_t* req)
+{
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, NULL, 0);
+}
+
+// Whole file from PSRAM in one send with Content-Length
+static esp_err_t send_cached(httpd_req_t* req, const ws_cached_asset_t* a, const char* vary)
+{
+    set_validator_headers(req, a->etag, a->cache_control, vary);
+    if (request_etag_matches(req, a->etag))
+    {
+        return send_not_modified(req);
+    }
+
+    set_content_headers(req, a->mime, a->encoding);
+    if (httpd_resp_send(req, (const char*)a->data, (ssize_t)a->size) != ESP_OK)
+    {
+        // Same reasoning as the chunked path: the socket is gone, let httpd close it
+        ESP_LOGW(TAG, "send failed for cached %s — client likely disconnected", a->path);
+    }
+    return ESP_OK;
+}
+
+// Read a whole variant into the PSRAM cache. Returns the pinned entry, or
+// NULL if the file does not fit (the caller then streams it).
+static const ws_cached_asset_t* cache_fill(FILE* f, const ws_react_asset_t* asset, ws_react_enc_t enc)
+{
+    const ws_react_variant_t* v = &asset->variant[enc];
+
+    // Generation first: a table switch after this read makes Insert drop
+    // the file, one before it fails the check below
+    uint32_t generation = WS_React_AssetCache_Generation();
+    taskENTER_CRITICAL(&s_lock);
+    bool current = (asset->table == s_table);
+    taskEXIT_CRITICAL(&s_lock);
+    if (!current)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if ((fstat(fileno(f), &st) != 0) || (st.st_size <= 0))
     {
-        (void)httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+        return NULL;
     }
 
+    uint8_t* data = WS_React_AssetCache_Alloc((size_t)st.st_size);
+    if (!data)
+    {
+        return NULL;
+    }
+
+    size_t r = fread(data, 1, (size_t)st.st_size, f);
+    if (r != (size_t)st.st_size)
+    {
+        ESP_LOGW(TAG, "short read filling cache: %s (%u of %ld)",
+                 v->fs_path, (unsigned)r, (long)st.st_size);
+        heap_caps_free(data);
+        rewind(f);
+        return NULL;
+    }
+
+    return WS_React_AssetCache_Insert(v->fs_path, data, r, asset->mime,
+                                      asset_cache_control(asset), v->etag, WS_React_Encoding_Header(enc),
+                                      generation);
+}
+
+static void cache_preload(const ws_react_table_t* t)
+{
+    uint32_t loaded = 0;
+
+    for (size_t i = 0; i < t->count; i++)
+    {
+        const ws_react_asset_t* asset = &t->assets[i];
+        if (!asset->preload)
+        {
+            continue;
+        }
+
+        // Browsers send br only over HTTPS: without the TLS listener no
+        // request ever picks it, so it is not worth PSRAM up front
+#if CONFIG_WS_HTTPS_ENABLE
+        static const ws_react_enc_t preload_enc[] = { WS_REACT_ENC_BR, WS_REACT_ENC_GZIP, WS_REACT_ENC_IDENTITY };
+#else
+        static const ws_react_enc_t preload_enc[] = { WS_REACT_ENC_GZIP, WS_REACT_ENC_IDENTITY };
+#endif
+        for (size_t e = 0; e < sizeof(preload_enc) / sizeof(preload_enc[0]); e++)
+        {
+            ws_react_enc_t enc  = preload_enc[e];
+            const char*    path = asset->variant[enc].fs_path;
+            FILE*       f    = path ? fopen(path, "rb") : NULL;
+            if (!f)
+            {
+                continue;
+            }
+
+            const ws_cached_asset_t* cached = cache_fill(f, asset, enc);
+            fclose(f);
+            if (cached)
+            {
+                WS_React_AssetCache_Release(cached);
+                loaded++;
+            }
+        }
+    }
+
+    ws_asset_cache_stats_t stats;
+    WS_React_AssetCache_GetStats(&stats);
+    ESP_LOGI(TAG, "preloaded %u assets into PSRAM (%u of %u bytes)",
+             (unsigned)loaded, (unsigned)stats.used, (unsigned)stats.budget);
+}
+
+// ----------------------------------------------------------------
+// Streaming senders
+// ----------------------------------------------------------------
+static void send_final_chunk(httpd_req_t* req, const char* path)
+{
+    // Terminate chunked transfer. Ignore errors here — the browser may have
+    // closed the connection after receiving the last data chunk, which is normal
+    // pipelining behaviour.
+    esp_err_t espFinalChunk = httpd_resp_send_chunk(req, NULL, 0);
+    if (ESP_OK != espFinalChunk)
+    {
+        ESP_LOGD(TAG, "final chunk send failed for %s (client likely closed connection)", path);
+    }
+}
+
+static esp_err_t send_file_chunked(httpd_req_t* req, FILE* f, const char* path)
+{
     char* buf = (char*)malloc(WS_FILE_CHUNK_SIZE);
     if (!buf)
     {
-        fclose(f);
         ESP_LOGE(TAG, "malloc failed for chunk buffer");
         return httpd_resp_send_404(req);
     }
@@ -176,21 +1099,239 @@ esp_err_t WS_React_FileServer_ServeFile(httpd_req_t* req,
             // screen. Log and return ESP_OK so httpd closes the connection cleanly.
             ESP_LOGW(TAG, "mid-transfer send_chunk failed for %s — client likely disconnected", path);
             free(buf);
-            fclose(f);
             return ESP_OK;
         }
     }
     free(buf);
-    fclose(f);
 
-    // Terminate chunked transfer. Ignore errors here — the browser may have
-    // closed the connection after receiving the last data chunk, which is normal
-    // pipelining behaviour.
-    esp_err_t espFinalChunk = httpd_resp_send_chunk(req, NULL, 0);
-    if (ESP_OK != espFinalChunk)
+    send_final_chunk(req, path);
+    return ESP_OK;
+}
+
+// Offset of the deflate stream after the gzip member header (RFC 1952),
+// or 0 if buf does not hold a complete gzip header.
+static size_t gzip_header_len(const uint8_t* buf, size_t len)
+{
+    if ((len < 10) || (buf[0] != 0x1f) || (buf[1] != 0x8b) || (buf[2] != 8))
     {
-        ESP_LOGD(TAG, "final chunk send failed for %s (client likely closed connection)", path);
+        return 0;
     }
 
-    return ESP_OK;
+    uint8_t flags = buf[3];
+    size_t  pos   = 10;
+
+    if (flags & 0x04)                           // FEXTRA
+    {
+        if (pos + 2 > len) return 0;
+        pos += 2 + (size_t)(buf[pos] | (buf[pos + 1] << 8));
+    }
+    for (uint8_t bit = 0x08; bit <= 0x10; bit <<= 1)    // FNAME, FCOMMENT
+    {
+        if (flags & bit)
+        {
+            while ((pos < len) && (buf[pos] != 0)) pos++;
+            pos++;
+        }
+    }
+    if (flags & 0x02)                           // FHCRC
+    {
+        pos += 2;
+    }
+
+    return (pos < len) ? pos : 0;
+}
+
+// For clients that accept neither gzip nor br: inflate the gzip file with
+// the ROM miniz decoder and stream the plain bytes.
+static esp_err_t send_inflated(httpd_req_t* req, FILE* f, const char* path)
+{
+    tinfl_decompressor* inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+    uint8_t*            in       = (uint8_t*)malloc(WS_FILE_CHUNK_SIZE);
+    uint8_t*            dict     = (uint8_t*)heap_caps_malloc(TINFL_LZ_DICT_SIZE, MALLOC_CAP_SPIRAM);
+    if (!dict)
+    {
+        dict = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+    }
+
+    esp_err_t espErr = ESP_OK;
+    if (!inflator || !in || !dict)
+    {
+        ESP_LOGE(TAG, "no memory to inflate %s", path);
+        espErr = httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        goto cleanup;
+    }
+
+    size_t in_len = fread(in, 1, WS_FILE_CHUNK_SIZE, f);
+    size_t in_pos = gzip_header_len(in, in_len);
+    if (in_pos == 0)
+    {
+        ESP_LOGE(TAG, "not a gzip file: %s", path);
+        espErr = httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Bad asset");
+        goto cleanup;
+    }
+
+    tinfl_init(inflator);
+    size_t dict_pos = 0;
+    bool   eof      = feof(f);
+
+    for (;;)
+    {
+        if ((in_pos == in_len) && !eof)
+        {
+            in_len = fread(in, 1, WS_FILE_CHUNK_SIZE, f);
+            in_pos = 0;
+            eof    = (in_len < WS_FILE_CHUNK_SIZE);
+        }
+
+        size_t in_bytes  = in_len - in_pos;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - dict_pos;
+        tinfl_status status = tinfl_decompress(inflator, in + in_pos, &in_bytes,
+                                               dict, dict + dict_pos, &out_bytes,
+                                               eof ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+        in_pos += in_bytes;
+
+        if ((out_bytes > 0) &&
+            (httpd_resp_send_chunk(req, (const char*)(dict + dict_pos), (ssize_t)out_bytes) != ESP_OK))
+        {
+            ESP_LOGW(TAG, "mid-transfer send_chunk failed for %s — client likely disconnected", path);
+            goto cleanup;
+        }
+        dict_pos = (dict_pos + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status == TINFL_STATUS_DONE)
+        {
+            send_final_chunk(req, path);
+            break;
+        }
+        if ((status < TINFL_STATUS_DONE) ||
+            ((status == TINFL_STATUS_NEEDS_MORE_INPUT) && eof && (in_pos == in_len)))
+        {
+            // Headers are gone already; ending without the final chunk
+            // tells the client the body is incomplete.
+            ESP_LOGE(TAG, "inflate failed for %s (status %d)", path, (int)status);
+            break;
+        }
+    }
+
+cleanup:
+    free(inflator);
+    free(in);
+    heap_caps_free(dict);
+    return espErr;
+}
+
+// ----------------------------------------------------------------
+// Asset sender
+// ----------------------------------------------------------------
+static esp_err_t serve_asset(httpd_req_t*            req,
+                             const ws_react_asset_t* asset,
+                             ws_react_enc_t          enc)
+{
+    // A coding named by the URI is sent as stored, without Vary
+    ws_react_negotiation_t neg =
+    {
+        .enc              = enc,
+        .content_encoding = WS_React_Encoding_Header(enc),
+    };
+
+    if (enc == WS_REACT_ENC_NEGOTIATE)
+    {
+        ws_react_enc_avail_t avail[WS_REACT_ENC_COUNT];
+        for (int e = 0; e < WS_REACT_ENC_COUNT; e++)
+        {
+            avail[e].stored = (asset->variant[e].fs_path != NULL);
+            avail[e].size   = asset->variant[e].size;
+        }
+
+        char* accept = req_header_dup(req, "Accept-Encoding");
+        WS_React_Encoding_Negotiate(accept, avail, &neg);
+        free(accept);
+
+        if (neg.enc == WS_REACT_ENC_COUNT)
+        {
+            httpd_resp_set_status(req, "406 Not Acceptable");
+            (void)httpd_resp_set_hdr(req, "Vary", neg.vary);
+            return httpd_resp_send(req, NULL, 0);
+        }
+    }
+
+    enc = neg.enc;
+    const bool                inflate = neg.inflate;
+    const ws_react_variant_t* v       = &asset->variant[enc];
+
+    // Hot path: no filesystem access at all
+    if (!inflate)
+    {
+        const ws_cached_asset_t* cached = WS_React_AssetCache_Acquire(v->fs_path);
+        if (cached)
+        {
+            esp_err_t espErr = send_cached(req, cached, neg.vary);
+            WS_React_AssetCache_Release(cached);
+            return espErr;
+        }
+    }
+
+    // The inflated body is a different representation from the .gz file,
+    // so it gets its own (still strong) validator. Must outlive the response.
+    char etag[WS_ETAG_LEN + 3];
+    if (inflate)
+    {
+        snprintf(etag, sizeof(etag), "%.*s-id\"", (int)strlen(v->etag) - 1, v->etag);
+    }
+    else
+    {
+        memcpy(etag, v->etag, sizeof(v->etag));
+    }
+
+    set_validator_headers(req, etag, asset_cache_control(asset), neg.vary);
+    if (request_etag_matches(req, etag))
+    {
+        return send_not_modified(req);
+    }
+
+    FILE* f = fopen(v->fs_path, "rb");
+    if (!f)
+    {
+        ESP_LOGE(TAG, "fopen failed: %s (errno=%d)", v->fs_path, errno);
+        return httpd_resp_send_404(req);
+    }
+
+    esp_err_t espErr = ESP_OK;
+    if (inflate)
+    {
+        set_content_headers(req, asset->mime, neg.content_encoding);
+        espErr = send_inflated(req, f, v->fs_path);
+        fclose(f);
+        return espErr;
+    }
+
+    // Cache miss: keep the file in PSRAM for next time if it fits
+    const ws_cached_asset_t* cached = cache_fill(f, asset, enc);
+    set_content_headers(req, asset->mime, neg.content_encoding);
+    if (cached)
+    {
+        if (httpd_resp_send(req, (const char*)cached->data, (ssize_t)cached->size) != ESP_OK)
+        {
+            ESP_LOGW(TAG, "send failed for %s — client likely disconnected", v->fs_path);
+        }
+        WS_React_AssetCache_Release(cached);
+    }
+    else
+    {
+        espErr = send_file_chunked(req, f, v->fs_path);
+    }
+
+    fclose(f);
+    return espErr;
+}
+
+esp_err_t WS_React_FileServer_ServeAsset(httpd_req_t*            req,
+                                         const ws_react_asset_t* asset,
+                                         ws_react_enc_t          enc)
+{
+    assert(req && asset);
+
+    esp_err_t espErr = serve_asset(req, asset, enc);
+    WS_React_FileServer_Release(asset);
+    return espErr;
 }
@@ -2,40 +2,114 @@
 
 #include "esp_err.h"
 #include "esp_http_server.h"
+#include "WS_React_Encoding.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Written by scripts/gen_asset_manifest.py into the top of every web-UI root
+#define WS_REACT_MANIFEST_NAME "asset-manifest.json"
+
+// Root flashed with the fatfs-react image. Uploaded bundles live in
+// subdirectories of it (see WebUiAPI.h); this one is never written.
+#define WS_REACT_FACTORY_ROOT  "/react"
+
+#define WS_REACT_ROOT_MAX      32
+
+// One servable file: URI, MIME type, caching policy and the stored variant
+// per content coding, all resolved when its root is loaded. Opaque outside
+// WS_React_FileServer.c.
+typedef struct ws_react_asset ws_react_asset_t;
+
+typedef struct
+{
+    char     root[WS_REACT_ROOT_MAX];   // directory being served
+    bool     from_manifest;
+    uint32_t files;
+    uint32_t retired;                   // replaced tables still pinned by requests
+    uint32_t switches;                  // root changes since boot
+} ws_react_fs_info_t;
+
+/**
+ * @brief Build the in-memory table of served files.
+ *
+ * The root is the one last chosen with WS_React_FileServer_SetRoot (kept in
+ * NVS), or WS_REACT_FACTORY_ROOT if that is unset or no longer loads. The
+ * table comes from the root's asset manifest; without one (image built by
+ * an older toolchain) the root is walked once instead, with ETags derived
+ * from size and mtime and no long-lived caching. Safe to call more than
+ * once; only the first successful call loads.
+ */
+esp_err_t WS_React_FileServer_Init(void);
+
+/**
+ * @brief Serve a different root from the next request on.
+ *
+ * The new table is built and checked for index.html before anything
+ * changes; on failure the current root stays. On success the choice is
+ * saved to NVS, the PSRAM cache is emptied and preloaded from the new
+ * root. Requests already holding an asset of the old table finish from
+ * it; the old table is freed by the last of them.
+ *
+ * @return ESP_ERR_NOT_FOUND if root has no index.html, or the table
+ *         construction error.
+ */
+esp_err_t WS_React_FileServer_SetRoot(const char* root);
 
 /**
- * @brief Return the MIME type string for the given file path based on its extension.
- *        Falls back to "text/plain" for unknown extensions.
+ * @brief True while the current or a retired table serves files from root.
+ *        A root must not be rewritten until this turns false.
+ */
+bool WS_React_FileServer_RootInUse(const char* root);
+
+void WS_React_FileServer_GetInfo(ws_react_fs_info_t* info);
+
+/**
+ * @brief Return the MIME type for the extension of path, ignoring a trailing
+ *        ".gz" or ".br". Falls back to "text/plain" for unknown extensions.
  */
 const char* WS_React_FileServer_GetMime(const char* path);
 
 /**
- * @brief Resolve a request URI to an absolute filesystem path under /react/.
- *
- * Resolution rules (matching the original Ws_React_Static.c logic):
- *   "/"          -> tries /react/index.html.gz then /react/index.html
- *   "<uri>.gz"   -> tries /react<uri> directly (already compressed)
- *   "<uri>"      -> tries /react<uri>.gz first, then /react<uri> as fallback
- *
- * @param uri      Stripped URI string (no query string, must start with '/').
- * @param out_path Output buffer that receives the absolute FS path.
- * @param out_len  Size of out_path buffer.
- * @param out_gz   Set to true when the resolved file is gzip-compressed.
- * @return         ESP_OK when a matching file exists, ESP_ERR_NOT_FOUND otherwise.
+ * @brief Resolve a request URI with one table lookup (no filesystem access).
+ *
+ *   "/"          -> the index.html entry
+ *   "<uri>.gz"   -> <uri>, gzip variant only (sent as-is)
+ *   "<uri>.br"   -> <uri>, Brotli variant only (sent as-is)
+ *   "<uri>"      -> <uri>, variant negotiated per request
+ *
+ * A query string, if present, is ignored.
+ *
+ * The asset's table stays alive, even across WS_React_FileServer_SetRoot,
+ * until the asset is passed to WS_React_FileServer_ServeAsset or
+ * WS_React_FileServer_Release.
+ *
+ * @param out_enc  WS_REACT_ENC_NEGOTIATE, or the coding the URI named.
+ * @return The asset, or NULL if nothing is served at that URI.
+ */
+const ws_react_asset_t* WS_React_FileServer_Lookup(const char*     uri,
+                                                   ws_react_enc_t* out_enc);
+
+/**
+ * @brief Give back an asset from WS_React_FileServer_Lookup without serving it.
  */
-esp_err_t WS_React_FileServer_ResolvePath(const char* uri,
-                                          char*        out_path,
-                                          size_t       out_len,
-                                          bool*        out_gz);
+void WS_React_FileServer_Release(const ws_react_asset_t* asset);
 
 /**
- * @brief Stream a file from the filesystem to the HTTP client as a chunked response.
+ * @brief Send an asset from WS_React_FileServer_Lookup.
+ *
+ * With WS_REACT_ENC_NEGOTIATE the smallest stored variant the client's
+ * Accept-Encoding allows is sent, with Vary: Accept-Encoding. A client that
+ * accepts neither gzip nor br gets the gzip file inflated on the fly.
+ *
+ * Sets Content-Type, a strong per-variant ETag and Cache-Control.
+ * Content-hashed bundles listed as immutable in the manifest are cached for
+ * a year; everything else is revalidated. Replies 304 Not Modified without
+ * a body when If-None-Match matches. Files held in the PSRAM cache go out in
+ * one send with Content-Length; larger ones are streamed as a chunked response.
  *
- * Sets Content-Type and, when is_gz is true, Content-Encoding: gzip.
- * Sends the terminating zero-length chunk on success.
+ * Releases the asset (see WS_React_FileServer_Lookup).
  */
-esp_err_t WS_React_FileServer_ServeFile(httpd_req_t* req,
-                                        const char*  path,
-                                        const char*  mime,
-                                        bool         is_gz);
+esp_err_t WS_React_FileServer_ServeAsset(httpd_req_t*            req,
+                                         const ws_react_asset_t* asset,
+                                         ws_react_enc_t          enc);
@@ -1,8 +1,6 @@
 #include "WS_React_Routes.h"
 #include "WS_React_FileServer.h"
-
-#include <string.h>
-#include <stdlib.h>
+#include "WS_Metrics.h"
 
 #include "esp_log.h"
 
@@ -50,16 +48,20 @@ static const httpd_uri_t s_root_file_uri =
 // ----------------------------------------------------------------
 esp_err_t Ws_React_RegisterRoutes(httpd_handle_t hHttpServer)
 {
-    esp_err_t espErr = httpd_register_uri_handler(hHttpServer, &s_index_uri);
+    // Without a manifest /react is walked instead; if that finds nothing
+    // too, every static route below simply answers 404
+    (void)WS_React_FileServer_Init();
+
+    esp_err_t espErr = WS_Metrics_RegisterUri(hHttpServer, &s_index_uri);
 
     if (ESP_OK == espErr)
     {
-        espErr = httpd_register_uri_handler(hHttpServer, &s_assets_uri);
+        espErr = WS_Metrics_RegisterUri(hHttpServer, &s_assets_uri);
     }
 
     if (ESP_OK == espErr)
     {
-        espErr = httpd_register_uri_handler(hHttpServer, &s_favicon_uri);
+        espErr = WS_Metrics_RegisterUri(hHttpServer, &s_favicon_uri);
     }
 
     if (ESP_OK == espErr)
@@ -72,7 +74,7 @@ esp_err_t Ws_React_RegisterRoutes(httpd_handle_t hHttpServer)
 
 esp_err_t Ws_React_RegisterCatchAll(httpd_handle_t hHttpServer)
 {
-    esp_err_t espErr = httpd_register_uri_handler(hHttpServer, &s_root_file_uri);
+    esp_err_t espErr = WS_Metrics_RegisterUri(hHttpServer, &s_root_file_uri);
 
     if (ESP_OK == espErr)
     {
@@ -87,20 +89,16 @@ esp_err_t Ws_React_RegisterCatchAll(httpd_handle_t hHttpServer)
 // ----------------------------------------------------------------
 static esp_err_t ws_react_index_handler(httpd_req_t* req)
 {
-    char path[64];
-    bool is_gz = false;
-
-    esp_err_t espErr = WS_React_FileServer_ResolvePath("/", path, sizeof(path), &is_gz);
-    if (ESP_OK != espErr)
+    ws_react_enc_t          enc   = WS_REACT_ENC_NEGOTIATE;
+    const ws_react_asset_t* asset = WS_React_FileServer_Lookup("/", &enc);
+    if (!asset)
     {
         return httpd_resp_send_404(req);
     }
 
-    // SPA entry point — must not be cached, otherwise an outdated shell will
-    // prevent the browser from picking up new hashed asset filenames.
-    (void)httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
-
-    return WS_React_FileServer_ServeFile(req, path, "text/html", is_gz);
+    // SPA entry point — ServeAsset sends "no-cache" so the browser always
+    // revalidates it (a cheap 304) and picks up new hashed asset filenames.
+    return WS_React_FileServer_ServeAsset(req, asset, enc);
 }
 
 // ----------------------------------------------------------------
@@ -108,13 +106,11 @@ static esp_err_t ws_react_index_handler(httpd_req_t* req)
 // ----------------------------------------------------------------
 static esp_err_t ws_react_favicon_handler(httpd_req_t* req)
 {
-    char  path[64];
-    bool  is_gz = false;
-
-    esp_err_t espErr = WS_React_FileServer_ResolvePath("/favicon.ico", path, sizeof(path), &is_gz);
-    if (ESP_OK == espErr)
+    ws_react_enc_t          enc   = WS_REACT_ENC_NEGOTIATE;
+    const ws_react_asset_t* asset = WS_React_FileServer_Lookup("/favicon.ico", &enc);
+    if (asset)
     {
-        return WS_React_FileServer_ServeFile(req, path, "image/x-icon", is_gz);
+        return WS_React_FileServer_ServeAsset(req, asset, enc);
     }
 
     // Not on the filesystem — return 204 so the browser stops retrying
@@ -127,41 +123,18 @@ static esp_err_t ws_react_favicon_handler(httpd_req_t* req)
 // ----------------------------------------------------------------
 static esp_err_t ws_react_assets_handler(httpd_req_t* req)
 {
-    // URI can be up to CONFIG_HTTPD_MAX_URI_LEN (512); use heap to keep stack lean
-    size_t uri_len = strlen(req->uri);
-    char*  uri     = (char*)malloc(uri_len + 1);
-    if (!uri)
+    // Lookup ignores the query string and never touches FatFS, so an
+    // unknown asset is a 404 straight from the in-memory table.
+    ws_react_enc_t          enc   = WS_REACT_ENC_NEGOTIATE;
+    const ws_react_asset_t* asset = WS_React_FileServer_Lookup(req->uri, &enc);
+    if (!asset)
     {
         return httpd_resp_send_404(req);
     }
 
-    memcpy(uri, req->uri, uri_len + 1);
-
-    // Strip query string in-place
-    char* q = strchr(uri, '?');
-    if (q) { *q = '\0'; }
-
-    // Resolve to a concrete FS path (max 256 — /react + /assets/... + .gz + NUL)
-    char  path[256];
-    bool  is_gz = false;
-    esp_err_t espErr = WS_React_FileServer_ResolvePath(uri, path, sizeof(path), &is_gz);
-    free(uri);
-
-    if (ESP_OK != espErr)
-    {
-        return httpd_resp_send_404(req);
-    }
-
-    const char* mime = WS_React_FileServer_GetMime(path);
-
-    // Vite hashes asset filenames on every build — they are safe to cache
-    // indefinitely in the browser. This eliminates redundant re-downloads.
-    //(void)httpd_resp_set_hdr(req, "Cache-Control", "public, max-age=31536000, immutable");
-
-    // However, during development we want to disable caching of assets, otherwise the browser may fail to pick up new hashed filenames after a rebuild, resulting in a broken app until
-    (void)httpd_resp_set_hdr(req, "Cache-Control", "no-store");
-
-    return WS_React_FileServer_ServeFile(req, path, mime, is_gz);
+    // Vite hashes asset filenames on every build; the asset manifest marks
+    // them immutable so ServeAsset lets the browser cache them for a year.
+    return WS_React_FileServer_ServeAsset(req, asset, enc);
 }
 
 // ----------------------------------------------------------------
@@ -170,38 +143,17 @@ static esp_err_t ws_react_assets_handler(httpd_req_t* req)
 // ----------------------------------------------------------------
 static esp_err_t ws_react_root_file_handler(httpd_req_t* req)
 {
-    size_t uri_len = strlen(req->uri);
-    char*  uri     = (char*)malloc(uri_len + 1);
-    if (!uri)
-    {
-        return httpd_resp_send_404(req);
-    }
-
-    memcpy(uri, req->uri, uri_len + 1);
-
-    // Strip query string in-place
-    char* q = strchr(uri, '?');
-    if (q) { *q = '\0'; }
-
-    char  path[256];
-    bool  is_gz = false;
-    esp_err_t espErr = WS_React_FileServer_ResolvePath(uri, path, sizeof(path), &is_gz);
-    free(uri);
-
-    if (ESP_OK != espErr)
+    ws_react_enc_t          enc   = WS_REACT_ENC_NEGOTIATE;
+    const ws_react_asset_t* asset = WS_React_FileServer_Lookup(req->uri, &enc);
+    if (!asset)
     {
         // Not a real file — serve index.html for SPA client-side routing
-        bool idx_gz = false;
-        espErr = WS_React_FileServer_ResolvePath("/", path, sizeof(path), &idx_gz);
-        if (ESP_OK != espErr)
+        asset = WS_React_FileServer_Lookup("/", &enc);
+        if (!asset)
         {
             return httpd_resp_send_404(req);
         }
-        (void)httpd_resp_set_hdr(req, "Cache-Control", "no-cache, no-store, must-revalidate");
-        return WS_React_FileServer_ServeFile(req, path, "text/html", idx_gz);
     }
 
-    const char* mime = WS_React_FileServer_GetMime(path);
-    (void)httpd_resp_set_hdr(req, "Cache-Control", "no-store");
-    return WS_React_FileServer_ServeFile(req, path, mime, is_gz);
+    return WS_React_FileServer_ServeAsset(req, asset, enc);
 }
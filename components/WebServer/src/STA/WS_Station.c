@@ -11,20 +11,38 @@
 #include "React/WS_React_Routes.h"
 #include "React/RestAPI/Example/ExampleAPI.h"
 #include "React/RestAPI/Schedule/ScheduleAPI.h"
+#include "React/RestAPI/Events/EventsAPI.h"
 #include "React/RestAPI/Pin/PinAPI.h"
 #include "React/RestAPI/Credential/CredentialAPI.h"
+#include "React/RestAPI/Logs/LogsAPI.h"
+#include "React/RestAPI/WebUi/WebUiAPI.h"
+#include "React/RestAPI/Ota/OtaAPI.h"
 #include "Auth/WS_Auth.h"
+#include "Auth/WS_AuthSession.h"
+#include "Auth/WS_AuthStore.h"
+#include "WS_Arena.h"
+#include "WS_Async.h"
+#include "WS_Body.h"
+#include "WS_Https.h"
+#include "WS_Metrics.h"
+#include "WS_RateLimit.h"
 #include <string.h>
 #include <time.h>
+#include "sdkconfig.h"
 
 static const char* TAG = "WS_STATION";
 
 #define WIFI_SCAN_MAX_AP    20
+#define WIFI_CONFIG_BODY_MAX 384
 
 static EXAMPLE_API_H s_hExampleApi = NULL;
 static SCHEDULE_API_H s_hScheduleApi = NULL;
+static EVENTS_API_H s_hEventsApi = NULL;
 static PIN_API_H s_hPinApi = NULL;
 static CREDENTIAL_API_H s_hCredentialApi = NULL;
+static LOGS_API_H s_hLogsApi = NULL;
+static WEBUI_API_H s_hWebUiApi = NULL;
+static OTA_API_H s_hOtaApi = NULL;
 
 static esp_err_t ws_Station_HealthHandler(httpd_req_t* ptReq);
 static esp_err_t ws_Station_StatusHandler(httpd_req_t* ptReq);
@@ -86,21 +104,11 @@ ws_Station_WifiConfigHandler(httpd_req_t* ptReq)
         if (ESP_OK != espAuth) return ESP_OK;
     }
 
-    char acBuf[384];
-    int  iLen = httpd_req_recv(ptReq, acBuf, sizeof(acBuf) - 1);
-
-    if (iLen <= 0)
+    cJSON*    ptRoot  = NULL;
+    esp_err_t espBody = WS_Body_ReadJson(ptReq, WIFI_CONFIG_BODY_MAX, &ptRoot);
+    if (ESP_OK != espBody)
     {
-        httpd_resp_send_err(ptReq, HTTPD_400_BAD_REQUEST, "Empty body");
-        return ESP_FAIL;
-    }
-    acBuf[iLen] = '\0';
-
-    cJSON* ptRoot = cJSON_Parse(acBuf);
-    if (NULL == ptRoot)
-    {
-        httpd_resp_send_err(ptReq, HTTPD_400_BAD_REQUEST, "Invalid JSON");
-        return ESP_FAIL;
+        return WS_Body_SendError(ptReq, espBody);
     }
 
     cJSON* ptSsid = cJSON_GetObjectItem(ptRoot, "ssid");
@@ -150,7 +158,7 @@ ws_Station_WifiConfigHandler(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, pcJson);
 
     cJSON_Delete(ptResp);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
 
     vTaskDelay(pdMS_TO_TICKS(500));
     esp_restart();
@@ -241,7 +249,7 @@ ws_Station_WifiNetworksHandler(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, pcJson);
 
     cJSON_Delete(ptRoot);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
 
     return ESP_OK;
 }
@@ -265,7 +273,7 @@ ws_Station_HealthHandler(httpd_req_t* ptReq)
     httpd_resp_sendstr(ptReq, pcJson);
 
     cJSON_Delete(ptRoot);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
     return ESP_OK;
 }
 
@@ -288,70 +296,177 @@ ws_Station_StatusHandler(httpd_req_t* ptReq)
     }
     cJSON_AddItemToObject(ptRoot, "wifi", ptWifi);
 
+    auth_session_stats_t tSessions;
+    auth_session_get_stats(&tSessions);
+
     cJSON* ptAuth = cJSON_CreateObject();
     cJSON_AddBoolToObject(ptAuth, "enabled", true);
-    cJSON_AddNumberToObject(ptAuth, "sessions", auth_active_session_count());
+    cJSON_AddNumberToObject(ptAuth, "sessions", tSessions.active);
+    cJSON_AddNumberToObject(ptAuth, "capacity", tSessions.capacity);
+    cJSON_AddNumberToObject(ptAuth, "evictedLru", tSessions.evicted_lru);
+    cJSON_AddNumberToObject(ptAuth, "evictedRole", tSessions.evicted_role);
+    cJSON_AddNumberToObject(ptAuth, "expired", tSessions.expired);
+
+    auth_kdf_stats_t tKdf;
+    auth_store_get_kdf_stats(&tKdf);
+    cJSON* ptKdf = cJSON_CreateObject();
+    cJSON_AddStringToObject(ptKdf, "algorithm", "pbkdf2-sha256");
+    cJSON_AddNumberToObject(ptKdf, "iterations", tKdf.iterations);
+    cJSON_AddNumberToObject(ptKdf, "targetMs", tKdf.target_ms);
+    cJSON_AddNumberToObject(ptKdf, "lastVerifyMs", tKdf.last_verify_ms);
+    cJSON_AddNumberToObject(ptKdf, "upgraded", tKdf.upgraded);
+    cJSON_AddItemToObject(ptAuth, "kdf", ptKdf);
     cJSON_AddItemToObject(ptRoot, "auth", ptAuth);
 
+    /* Request arena: per-route peak use, to size CONFIG_WS_ARENA_SIZE_KB */
+    cJSON* ptArena = cJSON_CreateObject();
+    cJSON_AddNumberToObject(ptArena, "capacity", (double)WS_Arena_Capacity());
+    cJSON* ptRoutes = cJSON_AddArrayToObject(ptArena, "routes");
+    size_t ulRoutes = WS_Arena_RouteCount();
+    ws_arena_route_stats_t* ptStats = (ws_arena_route_stats_t*)WS_Arena_Calloc(ulRoutes, sizeof(ws_arena_route_stats_t));
+    if (NULL != ptStats)
+    {
+        ulRoutes = WS_Arena_GetRouteStats(ptStats, ulRoutes);
+        for (size_t i = 0; i < ulRoutes; i++)
+        {
+            if (0 == ptStats[i].requests) continue;
+            cJSON* ptRoute = cJSON_CreateObject();
+            cJSON_AddStringToObject(ptRoute, "method", http_method_str(ptStats[i].method));
+            cJSON_AddStringToObject(ptRoute, "uri", ptStats[i].uri);
+            cJSON_AddNumberToObject(ptRoute, "requests", ptStats[i].requests);
+            cJSON_AddNumberToObject(ptRoute, "highWater", ptStats[i].high_water);
+            cJSON_AddNumberToObject(ptRoute, "overflows", ptStats[i].overflows);
+            cJSON_AddItemToArray(ptRoutes, ptRoute);
+        }
+        WS_Arena_Free(ptStats);
+    }
+    cJSON_AddItemToObject(ptRoot, "arena", ptArena);
+
+    /* Worker pool for slow handlers */
+    ws_async_stats_t tAsync;
+    WS_Async_GetStats(&tAsync);
+
+    cJSON* ptAsync = cJSON_CreateObject();
+    cJSON_AddNumberToObject(ptAsync, "workers", tAsync.workers);
+    cJSON_AddNumberToObject(ptAsync, "queueLen", tAsync.queue_len);
+    cJSON_AddNumberToObject(ptAsync, "depth", tAsync.depth);
+    cJSON_AddNumberToObject(ptAsync, "depthPeak", tAsync.depth_peak);
+    cJSON_AddNumberToObject(ptAsync, "running", tAsync.running);
+    cJSON_AddNumberToObject(ptAsync, "jobs", tAsync.jobs);
+    cJSON_AddNumberToObject(ptAsync, "rejected", tAsync.rejected);
+    cJSON_AddNumberToObject(ptAsync, "waitLastMs", tAsync.wait_last_ms);
+    cJSON_AddNumberToObject(ptAsync, "waitMaxMs", tAsync.wait_max_ms);
+    cJSON_AddNumberToObject(ptAsync, "waitAvgMs",
+                            (tAsync.jobs + tAsync.running > 0) ? (double)tAsync.wait_total_ms / (tAsync.jobs + tAsync.running) : 0);
+    cJSON_AddItemToObject(ptRoot, "async", ptAsync);
+
+    ws_rate_stats_t tRate;
+    WS_RateLimit_GetStats(&tRate);
+    cJSON* ptRate = cJSON_CreateObject();
+    cJSON_AddNumberToObject(ptRate, "clients", tRate.clients);
+    cJSON_AddNumberToObject(ptRate, "capacity", tRate.capacity);
+    cJSON_AddNumberToObject(ptRate, "evicted", tRate.evicted);
+    for (int i = 0; i < WS_RATE_CLASSES; i++)
+    {
+        cJSON* ptClass = cJSON_CreateObject();
+        cJSON_AddNumberToObject(ptClass, "burst", tRate.classes[i].burst);
+        cJSON_AddNumberToObject(ptClass, "perMin", tRate.classes[i].per_min);
+        cJSON_AddNumberToObject(ptClass, "allowed", tRate.classes[i].allowed);
+        cJSON_AddNumberToObject(ptClass, "limited", tRate.classes[i].limited);
+        cJSON_AddItemToObject(ptRate, WS_RateLimit_ClassName((ws_rate_class_t)i), ptClass);
+    }
+    cJSON_AddItemToObject(ptRoot, "rateLimit", ptRate);
+
+    ws_https_stats_t tHttps;
+    WS_Https_GetStats(&tHttps);
+    cJSON* ptHttps = cJSON_CreateObject();
+    cJSON_AddBoolToObject(ptHttps, "enabled", tHttps.enabled);
+    if (tHttps.enabled)
+    {
+        cJSON_AddNumberToObject(ptHttps, "port", tHttps.port);
+        cJSON_AddBoolToObject(ptHttps, "sessionTickets", tHttps.session_tickets);
+        cJSON_AddNumberToObject(ptHttps, "open", tHttps.open);
+        cJSON_AddNumberToObject(ptHttps, "sessions", tHttps.sessions);
+        cJSON_AddNumberToObject(ptHttps, "certCreatedMs", tHttps.cert_created_ms);
+    }
+    cJSON_AddItemToObject(ptRoot, "https", ptHttps);
+
     const char* pcJson = cJSON_PrintUnformatted(ptRoot);
     httpd_resp_sendstr(ptReq, pcJson);
 
     cJSON_Delete(ptRoot);
-    free((void*)pcJson);
+    cJSON_free((void*)pcJson);
     return ESP_OK;
 }
 
-esp_err_t
-WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
+/* REST API modules. Their handles serve both listeners */
+static esp_err_t
+ws_Station_InitApis(SCHEDULER_H hScheduler)
 {
     esp_err_t espRslt = ESP_OK;
-    httpd_config_t tHttpServerConfig = HTTPD_DEFAULT_CONFIG();
 
-    /* Initialise auth subsystem (provisions service hash on first boot) */
-    espRslt = auth_init();
-    if (ESP_OK != espRslt)
+    EXAMPLE_API_PARAMS_T tExampleParams = {0};
+    espRslt = ExampleAPI_Init(&tExampleParams, &s_hExampleApi);
+
+    if (ESP_OK == espRslt)
     {
-        ESP_LOGE(TAG, "auth_init failed: %s", esp_err_to_name(espRslt));
-        return espRslt;
+        SCHEDULE_API_PARAMS_T tScheduleParams = { .hScheduler = hScheduler };
+        espRslt = ScheduleAPI_Init(&tScheduleParams, &s_hScheduleApi);
     }
 
-    (void)hWiFiManager; /* WiFi_Manager_SaveCredentials is a free function */
-    tHttpServerConfig.max_uri_handlers = 64;
-    tHttpServerConfig.stack_size = 16384;
-    tHttpServerConfig.uri_match_fn = httpd_uri_match_wildcard;
-    // Large JS bundles can exceed the default 5-second socket send timeout;
-    // raise both directions to prevent EAGAIN drops mid-transfer.
-    tHttpServerConfig.send_wait_timeout = 30;
-    tHttpServerConfig.recv_wait_timeout = 30;
-    httpd_handle_t hHttpServer = NULL;
+    if (ESP_OK == espRslt)
+    {
+        EVENTS_API_PARAMS_T tEventsParams = { .hScheduler = hScheduler };
+        espRslt = EventsAPI_Init(&tEventsParams, &s_hEventsApi);
+    }
 
-    espRslt = httpd_start(&hHttpServer, &tHttpServerConfig);
+    if (ESP_OK == espRslt)
+    {
+        PIN_API_PARAMS_T tPinParams = {0};
+        espRslt = PinAPI_Init(&tPinParams, &s_hPinApi);
+    }
 
     if (ESP_OK == espRslt)
     {
-        espRslt = Ws_React_RegisterStaticFiles(hHttpServer);
+        CREDENTIAL_API_PARAMS_T tCredParams = {0};
+        espRslt = CredentialAPI_Init(&tCredParams, &s_hCredentialApi);
     }
 
     if (ESP_OK == espRslt)
     {
-        espRslt = Ws_React_RegisterApiHandlers(hHttpServer);
+        LOGS_API_PARAMS_T tLogsParams = {0};
+        espRslt = LogsAPI_Init(&tLogsParams, &s_hLogsApi);
     }
 
     if (ESP_OK == espRslt)
     {
-        EXAMPLE_API_PARAMS_T tExampleParams = {0};
-        espRslt = ExampleAPI_Init(&tExampleParams, &s_hExampleApi);
+        WEBUI_API_PARAMS_T tWebUiParams = {0};
+        espRslt = WebUiAPI_Init(&tWebUiParams, &s_hWebUiApi);
     }
 
     if (ESP_OK == espRslt)
     {
-        espRslt = ExampleAPI_Register(s_hExampleApi, hHttpServer);
+        OTA_API_PARAMS_T tOtaParams = {0};
+        espRslt = OtaAPI_Init(&tOtaParams, &s_hOtaApi);
     }
 
+    return espRslt;
+}
+
+/* Every route, on one listener. The HTTP and HTTPS servers get the same set */
+static esp_err_t
+ws_Station_RegisterRoutes(httpd_handle_t hHttpServer)
+{
+    esp_err_t espRslt = Ws_React_RegisterStaticFiles(hHttpServer);
+
     if (ESP_OK == espRslt)
     {
-        SCHEDULE_API_PARAMS_T tScheduleParams = { .hScheduler = hScheduler };
-        espRslt = ScheduleAPI_Init(&tScheduleParams, &s_hScheduleApi);
+        espRslt = Ws_React_RegisterApiHandlers(hHttpServer);
+    }
+
+    if (ESP_OK == espRslt)
+    {
+        espRslt = ExampleAPI_Register(s_hExampleApi, hHttpServer);
     }
 
     if (ESP_OK == espRslt)
@@ -361,8 +476,7 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
 
     if (ESP_OK == espRslt)
     {
-        PIN_API_PARAMS_T tPinParams = {0};
-        espRslt = PinAPI_Init(&tPinParams, &s_hPinApi);
+        espRslt = EventsAPI_Register(s_hEventsApi, hHttpServer);
     }
 
     if (ESP_OK == espRslt)
@@ -372,13 +486,22 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
 
     if (ESP_OK == espRslt)
     {
-        CREDENTIAL_API_PARAMS_T tCredParams = {0};
-        espRslt = CredentialAPI_Init(&tCredParams, &s_hCredentialApi);
+        espRslt = CredentialAPI_Register(s_hCredentialApi, hHttpServer);
     }
 
     if (ESP_OK == espRslt)
     {
-        espRslt = CredentialAPI_Register(s_hCredentialApi, hHttpServer);
+        espRslt = LogsAPI_Register(s_hLogsApi, hHttpServer);
+    }
+
+    if (ESP_OK == espRslt)
+    {
+        espRslt = WebUiAPI_Register(s_hWebUiApi, hHttpServer);
+    }
+
+    if (ESP_OK == espRslt)
+    {
+        espRslt = OtaAPI_Register(s_hOtaApi, hHttpServer);
     }
 
     if (ESP_OK == espRslt)
@@ -389,7 +512,7 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
             .handler  = ws_Station_HealthHandler,
             .user_ctx = NULL,
         };
-        espRslt = httpd_register_uri_handler(hHttpServer, &tHealth);
+        espRslt = WS_Arena_RegisterUri(hHttpServer, &tHealth);
     }
 
     if (ESP_OK == espRslt)
@@ -400,7 +523,7 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
             .handler  = ws_Station_StatusHandler,
             .user_ctx = NULL,
         };
-        espRslt = httpd_register_uri_handler(hHttpServer, &tStatus);
+        espRslt = WS_Arena_RegisterUri(hHttpServer, &tStatus);
     }
 
     /* WiFi status endpoint — lets the frontend detect STA mode */
@@ -412,7 +535,7 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
             .handler  = ws_Station_WifiStatusHandler,
             .user_ctx = NULL,
         };
-        espRslt = httpd_register_uri_handler(hHttpServer, &tWifiStatus);
+        espRslt = WS_Metrics_RegisterUri(hHttpServer, &tWifiStatus);
     }
 
     /* WiFi config endpoint — save new credentials and restart */
@@ -424,10 +547,11 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
             .handler  = ws_Station_WifiConfigHandler,
             .user_ctx = NULL,
         };
-        espRslt = httpd_register_uri_handler(hHttpServer, &tWifiConfig);
+        espRslt = WS_Metrics_RegisterUri(hHttpServer, &tWifiConfig);
     }
 
-    /* WiFi networks endpoint — scan for available networks */
+    /* WiFi networks endpoint — scan for available networks. The blocking
+       scan takes seconds, so it runs on the worker pool */
     if (ESP_OK == espRslt)
     {
         httpd_uri_t tWifiNetworks = {
@@ -436,7 +560,12 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
             .handler  = ws_Station_WifiNetworksHandler,
             .user_ctx = NULL,
         };
-        espRslt = httpd_register_uri_handler(hHttpServer, &tWifiNetworks);
+        espRslt = WS_Async_RegisterUri(hHttpServer, &tWifiNetworks);
+    }
+
+    if (ESP_OK == espRslt)
+    {
+        espRslt = WS_Metrics_RegisterEndpoints(hHttpServer);
     }
 
     /* Register the catch-all wildcard LAST so it does not shadow API routes */
@@ -447,3 +576,81 @@ WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager)
 
     return espRslt;
 }
+
+esp_err_t
+WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager, httpd_handle_t* phServer)
+{
+    esp_err_t espRslt = ESP_OK;
+    httpd_config_t tHttpServerConfig = HTTPD_DEFAULT_CONFIG();
+
+    /* Initialise auth subsystem (provisions service hash on first boot) */
+    espRslt = auth_init();
+    if (ESP_OK != espRslt)
+    {
+        ESP_LOGE(TAG, "auth_init failed: %s", esp_err_to_name(espRslt));
+        return espRslt;
+    }
+
+    /* Metrics table, cJSON hooks and the worker pool go in before any
+       handler can run */
+    espRslt = WS_Metrics_Init();
+    if (ESP_OK == espRslt)
+    {
+        espRslt = WS_Arena_Init();
+    }
+    if (ESP_OK == espRslt)
+    {
+        espRslt = WS_Async_Init();
+    }
+    if (ESP_OK != espRslt)
+    {
+        ESP_LOGE(TAG, "Handler setup failed: %s", esp_err_to_name(espRslt));
+        return espRslt;
+    }
+
+    (void)hWiFiManager; /* WiFi_Manager_SaveCredentials is a free function */
+    tHttpServerConfig.max_uri_handlers = 64;
+    tHttpServerConfig.stack_size = 16384;
+    tHttpServerConfig.uri_match_fn = httpd_uri_match_wildcard;
+    // Large JS bundles can exceed the default 5-second socket send timeout;
+    // raise both directions to prevent EAGAIN drops mid-transfer.
+    tHttpServerConfig.send_wait_timeout = 30;
+    tHttpServerConfig.recv_wait_timeout = 30;
+    httpd_handle_t hHttpServer = NULL;
+
+    espRslt = ws_Station_InitApis(hScheduler);
+
+    if (ESP_OK == espRslt)
+    {
+        espRslt = httpd_start(&hHttpServer, &tHttpServerConfig);
+    }
+
+    if (ESP_OK == espRslt)
+    {
+        espRslt = ws_Station_RegisterRoutes(hHttpServer);
+    }
+
+    if (ESP_OK == espRslt)
+    {
+        *phServer = hHttpServer;
+    }
+
+#if CONFIG_WS_HTTPS_ENABLE
+    /* HTTPS is an extra: without it the HTTP server carries on */
+    if (ESP_OK == espRslt)
+    {
+        httpd_handle_t hHttpsServer = NULL;
+        esp_err_t espHttps = WS_Https_Start(&tHttpServerConfig, &hHttpsServer);
+        if (ESP_OK == espHttps)
+        {
+            espHttps = ws_Station_RegisterRoutes(hHttpsServer);
+        }
+        if (ESP_OK != espHttps)
+        {
+            ESP_LOGE(TAG, "HTTPS not available: %s", esp_err_to_name(espHttps));
+        }
+    }
+#endif
+
+    return espRslt;
+}
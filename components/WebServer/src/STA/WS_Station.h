@@ -1,6 +1,7 @@
 #include "esp_err.h"
+#include "esp_http_server.h"
 #include "Scheduler_API.h"
 #include "WiFi_Manager_API.h"
 
 esp_err_t
-WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager);
\ No newline at end of file
+WS_Station_Start(SCHEDULER_H hScheduler, WIFI_MANAGER_H hWiFiManager, httpd_handle_t* phServer);
\ No newline at end of file
@@ -12,10 +12,12 @@
 #include "lwip/inet.h"   // for IPSTR / IP2STR
 #include "WS_EventHandlers.h"
 #include "mdns.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
 
 static const char* TAG = "WEBSERVER_API";
 
-#define WS_MDNS_HOSTNAME    "ringy"
 #define WS_MDNS_INSTANCE    "Ringy School Bell"
 
 static esp_err_t
@@ -45,6 +47,9 @@ ws_InitMdns(void)
     /* Advertise HTTP service so the device is discoverable by
        service browsers (e.g. "dns-sd -B _http._tcp") */
     (void)mdns_service_add(WS_MDNS_INSTANCE, "_http", "_tcp", 80, NULL, 0);
+#if CONFIG_WS_HTTPS_ENABLE
+    (void)mdns_service_add(WS_MDNS_INSTANCE, "_https", "_tcp", CONFIG_WS_HTTPS_PORT, NULL, 0);
+#endif
 
     ESP_LOGI(TAG, "mDNS started — device reachable at http://" WS_MDNS_HOSTNAME ".local");
     return ESP_OK;
@@ -55,6 +60,8 @@ typedef struct _WEB_SERVER_RSC_T
     WEB_SERVER_PARAMS_T             tParams;                /* Init params */
     esp_netif_t*                    hNetif;                 /* netif handle (AP or STA) */
     esp_event_handler_instance_t    tEventHandlerStaGotIp;  /* STA got IP event handler instance */  
+    httpd_handle_t                  hHttpServer;            /* HTTP listener (AP or STA) */
+    SemaphoreHandle_t               hProbeDone;             /* given by the Ws_IsServing probe */
 } WEB_SERVER_RSC_T;
 
 static esp_err_t
@@ -99,7 +106,7 @@ Ws_Init(WEB_SERVER_PARAMS_T* ptParams, WEB_SERVER_H* phWebServer)
                     // TODO : Move WS_AccessPoint_Start out of here (in event handler)
                     if(ESP_OK == espErr)
                     {
-                        espErr = WS_AccessPoint_Start(ptRsc->tParams.hWiFiManager);
+                        espErr = WS_AccessPoint_Start(ptRsc->tParams.hWiFiManager, &ptRsc->hHttpServer);
                     }
 
                     if(ESP_OK == espErr) 
@@ -125,7 +132,8 @@ Ws_Init(WEB_SERVER_PARAMS_T* ptParams, WEB_SERVER_H* phWebServer)
                     if(ESP_OK == espErr)
                     {
                         espErr = WS_Station_Start(ptRsc->tParams.hScheduler,
-                                               ptRsc->tParams.hWiFiManager);
+                                               ptRsc->tParams.hWiFiManager,
+                                               &ptRsc->hHttpServer);
                     }
 
                     if(ESP_OK == espErr)
@@ -160,6 +168,36 @@ Ws_Init(WEB_SERVER_PARAMS_T* ptParams, WEB_SERVER_H* phWebServer)
     return espErr;
 }
 
+/* Runs on the server task: getting here shows it is serving its queue */
+static void
+ws_ProbeWork(void* pvArg)
+{
+    WEB_SERVER_RSC_T* ptRsc = (WEB_SERVER_RSC_T*)pvArg;
+    xSemaphoreGive(ptRsc->hProbeDone);
+}
+
+bool
+Ws_IsServing(WEB_SERVER_H hWebServer, uint32_t ulTimeoutMs)
+{
+    WEB_SERVER_RSC_T* ptRsc = (WEB_SERVER_RSC_T*)hWebServer;
+    if ((NULL == ptRsc) || (NULL == ptRsc->hHttpServer))
+    {
+        return false;
+    }
+
+    if (NULL == ptRsc->hProbeDone)
+    {
+        ptRsc->hProbeDone = xSemaphoreCreateBinary();
+        if (NULL == ptRsc->hProbeDone) return false;
+    }
+
+    /* A probe that timed out earlier may have completed since */
+    (void)xSemaphoreTake(ptRsc->hProbeDone, 0);
+
+    return (ESP_OK == httpd_queue_work(ptRsc->hHttpServer, ws_ProbeWork, ptRsc)) &&
+           (pdTRUE == xSemaphoreTake(ptRsc->hProbeDone, pdMS_TO_TICKS(ulTimeoutMs)));
+}
+
 static esp_err_t
 ws_ConfigureAp(WEB_SERVER_RSC_T* ptRsc)
 {
@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <stdint.h>
 #include "esp_err.h"
 #include "WS_Public.h"
@@ -9,5 +10,9 @@ typedef struct _WEB_SERVER_RSC_T*     WEB_SERVER_H;
 esp_err_t 
 Ws_Init(WEB_SERVER_PARAMS_T* ptParams, WEB_SERVER_H* phWebServer);
 
+/* True when the HTTP server task runs a queued probe within ulTimeoutMs */
+bool
+Ws_IsServing(WEB_SERVER_H hWebServer, uint32_t ulTimeoutMs);
+
 // esp_err_t
 // Ws_Start();
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "WS_Arena.h"
+#include "WS_Metrics.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "cJSON.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "WS_ARENA";
+
+#define ARENA_SIZE          ((size_t)CONFIG_WS_ARENA_SIZE_KB * 1024)
+#define ARENA_ALIGN         8
+#define ARENA_MAX_ROUTES    64      // matches the server's max_uri_handlers
+
+typedef struct
+{
+    esp_err_t             (*handler)(httpd_req_t* req);
+    void*                   user_ctx;
+    ws_arena_route_stats_t  stats;
+} ws_arena_route_t;
+
+static uint8_t*          s_base     = NULL;
+static size_t            s_used     = 0;
+static bool              s_spilled  = false;
+static TaskHandle_t      s_owner    = NULL;     // task whose handler owns the arena
+static ws_arena_route_t  s_routes[ARENA_MAX_ROUTES];
+static size_t            s_route_count = 0;
+static portMUX_TYPE      s_lock     = portMUX_INITIALIZER_UNLOCKED;
+
+// ----------------------------------------------------------------
+// Allocator
+// ----------------------------------------------------------------
+static bool in_arena(const void* ptr)
+{
+    return (NULL != s_base) && ((const uint8_t*)ptr >= s_base) && ((const uint8_t*)ptr < s_base + ARENA_SIZE);
+}
+
+static bool arena_mine(void)
+{
+    // s_owner is only ever set and cleared by the owning task, so a
+    // stale read elsewhere can never match the caller
+    return (NULL != s_owner) && (xTaskGetCurrentTaskHandle() == s_owner);
+}
+
+static void* arena_take(size_t size)
+{
+    size_t need = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (0 == need) {
+        need = ARENA_ALIGN;     // distinct pointer, like malloc(0) may give
+    }
+    if ((need < size) || (need > ARENA_SIZE - s_used)) {
+        s_spilled = true;
+        return NULL;
+    }
+    void* ptr = s_base + s_used;
+    s_used += need;
+    return ptr;
+}
+
+static void* hook_malloc(size_t size)
+{
+    if (arena_mine()) {
+        void* ptr = arena_take(size);
+        if (NULL != ptr) return ptr;
+    }
+    return malloc(size);
+}
+
+static void hook_free(void* ptr)
+{
+    if (in_arena(ptr)) return;      // released with the whole arena
+    free(ptr);
+}
+
+// ----------------------------------------------------------------
+// Handler wrapper
+// ----------------------------------------------------------------
+static esp_err_t arena_handler(httpd_req_t* req)
+{
+    ws_arena_route_t* route = (ws_arena_route_t*)req->user_ctx;
+
+    // The HTTP and HTTPS server tasks share one arena; whichever handler
+    // claims it first uses it and the other runs on the heap. A re-entry
+    // on the owning task also finds it busy
+    bool owned = false;
+    taskENTER_CRITICAL(&s_lock);
+    if ((NULL != s_base) && (NULL == s_owner)) {
+        s_used    = 0;
+        s_spilled = false;
+        s_owner   = xTaskGetCurrentTaskHandle();
+        owned     = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    req->user_ctx = route->user_ctx;
+    esp_err_t err = route->handler(req);
+    req->user_ctx = route;
+
+    bool spilled = false;
+    taskENTER_CRITICAL(&s_lock);
+    route->stats.requests++;
+    if (owned) {
+        if (s_used > route->stats.high_water) {
+            route->stats.high_water = (uint32_t)s_used;
+        }
+        if (s_spilled) {
+            route->stats.overflows++;
+            spilled = true;
+        }
+        s_owner = NULL;     // the next claim resets s_used
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (spilled) {
+        ESP_LOGW(TAG, "%s %s: arena full, used heap for the rest",
+                 http_method_str(route->stats.method), route->stats.uri);
+    }
+    return err;
+}
+
+// ----------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------
+esp_err_t WS_Arena_Init(void)
+{
+    if (NULL == s_base) {
+        s_base = (uint8_t*)heap_caps_malloc(ARENA_SIZE, MALLOC_CAP_SPIRAM);
+        if (NULL == s_base) {
+            ESP_LOGW(TAG, "No PSRAM for a %u byte arena, handlers use the heap", (unsigned)ARENA_SIZE);
+        } else {
+            ESP_LOGI(TAG, "Request arena: %u bytes", (unsigned)ARENA_SIZE);
+        }
+    }
+
+    cJSON_Hooks hooks = {
+        .malloc_fn = hook_malloc,
+        .free_fn   = hook_free,
+    };
+    cJSON_InitHooks(&hooks);
+    return ESP_OK;
+}
+
+esp_err_t WS_Arena_RegisterUri(httpd_handle_t server, const httpd_uri_t* uri)
+{
+    // A route registered on both listeners keeps one entry
+    size_t slot = 0;
+    while ((slot < s_route_count) &&
+           ((s_routes[slot].stats.method != uri->method) ||
+            (0 != strncmp(s_routes[slot].stats.uri, uri->uri, sizeof(s_routes[slot].stats.uri) - 1)))) {
+        slot++;
+    }
+    if (slot >= ARENA_MAX_ROUTES) {
+        ESP_LOGE(TAG, "Route table full, %s not wrapped", uri->uri);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ws_arena_route_t* route = &s_routes[slot];
+    route->handler      = uri->handler;
+    route->user_ctx     = uri->user_ctx;
+    route->stats.method = uri->method;
+    snprintf(route->stats.uri, sizeof(route->stats.uri), "%s", uri->uri);
+
+    httpd_uri_t wrapped = *uri;
+    wrapped.handler  = arena_handler;
+    wrapped.user_ctx = route;
+
+    esp_err_t err = WS_Metrics_RegisterUri(server, &wrapped);
+    if ((ESP_OK == err) && (slot == s_route_count)) {
+        s_route_count++;
+    }
+    return err;
+}
+
+void* WS_Arena_Calloc(size_t n, size_t size)
+{
+    if ((0 != size) && (n > SIZE_MAX / size)) {
+        return NULL;
+    }
+    if (arena_mine()) {
+        void* ptr = arena_take(n * size);
+        if (NULL != ptr) {
+            memset(ptr, 0, n * size);
+            return ptr;
+        }
+    }
+    return heap_caps_calloc_prefer(n, size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+}
+
+void WS_Arena_Free(void* ptr)
+{
+    hook_free(ptr);
+}
+
+size_t WS_Arena_Capacity(void)
+{
+    return (NULL != s_base) ? ARENA_SIZE : 0;
+}
+
+size_t WS_Arena_RouteCount(void)
+{
+    return s_route_count;
+}
+
+size_t WS_Arena_GetRouteStats(ws_arena_route_stats_t* out, size_t max)
+{
+    size_t n = (s_route_count < max) ? s_route_count : max;
+    taskENTER_CRITICAL(&s_lock);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_routes[i].stats;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return n;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Per-request bump arena for cJSON and handler scratch memory.
+ *
+ * A REST handler builds a cJSON tree, prints it and throws both away, so
+ * every node is a short-lived heap allocation. Routes registered through
+ * WS_Arena_RegisterUri() instead allocate from one PSRAM block that is
+ * reset in one step when the handler returns.
+ *
+ * cJSON hooks are process-wide, so they are installed once at start-up
+ * and only use the arena from a server task while a wrapped handler runs;
+ * every other task (touch screen, scheduler) keeps the normal heap. With
+ * the HTTPS listener running, a handler that finds the arena in use by the
+ * other server uses the heap.
+ * Frees of arena memory are no-ops. When the arena is full, allocations
+ * fall back to the heap and the request is counted as an overflow.
+ *
+ * Consequences for code running inside a wrapped handler:
+ *   - release cJSON_Print*() output with cJSON_free(), never free()
+ *   - nothing allocated through cJSON may outlive the request; hand other
+ *     tasks a heap copy instead
+ */
+
+#define WS_ARENA_URI_MAX    40
+
+typedef struct
+{
+    char            uri[WS_ARENA_URI_MAX];
+    httpd_method_t  method;
+    uint32_t        requests;
+    uint32_t        high_water;     // most arena bytes one request has used
+    uint32_t        overflows;      // requests that spilled onto the heap
+} ws_arena_route_stats_t;
+
+/**
+ * @brief Allocate the arena and install the cJSON hooks. Call once, before
+ *        the server starts. Without PSRAM the routes still work (and are
+ *        still counted) but allocate from the heap.
+ */
+esp_err_t WS_Arena_Init(void);
+
+/**
+ * @brief WS_Metrics_RegisterUri() with the handler run inside the arena.
+ *        The handler sees its own user_ctx as usual.
+ */
+esp_err_t WS_Arena_RegisterUri(httpd_handle_t server, const httpd_uri_t* uri);
+
+/**
+ * @brief Scratch memory for the running request, zeroed. Outside a wrapped
+ *        handler (or when the arena is full) it comes from the heap,
+ *        PSRAM preferred.
+ *        Release with WS_Arena_Free().
+ */
+void* WS_Arena_Calloc(size_t n, size_t size);
+
+/**
+ * @brief Free memory from WS_Arena_Calloc() or cJSON. No-op for arena memory.
+ */
+void WS_Arena_Free(void* ptr);
+
+/**
+ * @brief Arena size in bytes (0 when it could not be allocated) and the
+ *        number of wrapped routes.
+ */
+size_t WS_Arena_Capacity(void);
+size_t WS_Arena_RouteCount(void);
+
+/**
+ * @brief Copy the per-route counters.
+ * @return Number of entries written.
+ */
+size_t WS_Arena_GetRouteStats(ws_arena_route_stats_t* out, size_t max);
@@ -0,0 +1,216 @@
+#include "WS_Async.h"
+
+#include <string.h>
+#include <stdio.h>
+
+#include "Auth/WS_Auth.h"
+#include "WS_Metrics.h"
+#include "WS_RateLimit.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "WS_ASYNC";
+
+#define ASYNC_MAX_ROUTES    16
+#define ASYNC_PRIORITY      5       // same as the HTTP server task
+
+typedef struct
+{
+    esp_err_t (*handler)(httpd_req_t* req);
+    void*       user_ctx;
+    const char* uri;
+    httpd_method_t      method;
+    ws_metrics_route_t* metrics;
+    ws_rate_class_t     rate_class;
+} ws_async_route_t;
+
+typedef struct
+{
+    httpd_req_t*      req;          // detached copy, owned by the worker
+    ws_async_route_t* route;
+    int64_t           queued_us;    // also the metrics start time
+} ws_async_job_t;
+
+static QueueHandle_t    s_queue = NULL;
+static ws_async_route_t s_routes[ASYNC_MAX_ROUTES];
+static size_t           s_route_count = 0;
+static ws_async_stats_t s_stats;
+static portMUX_TYPE     s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ----------------------------------------------------------------
+// Worker
+// ----------------------------------------------------------------
+static void worker_task(void* arg)
+{
+    (void)arg;
+    ws_async_job_t job;
+
+    for (;;) {
+        if (pdTRUE != xQueueReceive(s_queue, &job, portMAX_DELAY)) continue;
+
+        uint32_t wait_ms = (uint32_t)((esp_timer_get_time() - job.queued_us) / 1000);
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.depth--;
+        s_stats.running++;
+        s_stats.wait_last_ms   = wait_ms;
+        s_stats.wait_total_ms += wait_ms;
+        if (wait_ms > s_stats.wait_max_ms) s_stats.wait_max_ms = wait_ms;
+        taskEXIT_CRITICAL(&s_lock);
+
+        job.req->user_ctx = job.route->user_ctx;
+        (void)job.route->handler(job.req);
+        WS_Metrics_End(job.route->metrics, job.req, job.queued_us);
+        httpd_req_async_handler_complete(job.req);
+
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.running--;
+        s_stats.jobs++;
+        taskEXIT_CRITICAL(&s_lock);
+    }
+}
+
+// ----------------------------------------------------------------
+// Server-task side
+// ----------------------------------------------------------------
+static void send_busy(httpd_req_t* req, ws_async_route_t* route)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.rejected++;
+    taskEXIT_CRITICAL(&s_lock);
+    ESP_LOGW(TAG, "%s: worker queue full, answering 503", route->uri);
+
+    // Body is left unread, so the connection cannot be reused
+    auth_set_security_headers(req);
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_hdr(req, "Retry-After", "1");
+    httpd_resp_set_hdr(req, "Connection", "close");
+    httpd_resp_sendstr(req, "{\"error\":\"Server busy, retry shortly\"}");
+}
+
+static esp_err_t async_handler(httpd_req_t* req)
+{
+    ws_async_route_t* route = (ws_async_route_t*)req->user_ctx;
+    int64_t           start = WS_Metrics_Begin(req);
+
+    // Before the queue, so a flood cannot take the workers from others
+    if (!WS_RateLimit_Admit(req, route->rate_class)) {
+        WS_Metrics_End(route->metrics, req, start);
+        return ESP_FAIL;
+    }
+
+    // Checked before detaching so the common refusal costs no copy. The
+    // HTTPS server task enqueues too, so the send below can still fail
+    if (0 == uxQueueSpacesAvailable(s_queue)) {
+        send_busy(req, route);
+        WS_Metrics_End(route->metrics, req, start);
+        return ESP_FAIL;
+    }
+
+    httpd_req_t* copy = NULL;
+    if (ESP_OK != httpd_req_async_handler_begin(req, &copy)) {
+        // No memory for the copy: slower for everyone, but still answered
+        ESP_LOGW(TAG, "%s: could not detach, running on the server task", route->uri);
+        req->user_ctx = route->user_ctx;
+        esp_err_t err = route->handler(req);
+        req->user_ctx = route;
+        WS_Metrics_End(route->metrics, req, start);
+        return err;
+    }
+
+    ws_async_job_t job = {
+        .req       = copy,
+        .route     = route,
+        .queued_us = start,
+    };
+
+    // Counted before the send so a worker that takes it at once never
+    // sees the depth go below zero
+    taskENTER_CRITICAL(&s_lock);
+    s_stats.depth++;
+    if (s_stats.depth > s_stats.depth_peak) s_stats.depth_peak = s_stats.depth;
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (pdTRUE != xQueueSend(s_queue, &job, 0)) {
+        taskENTER_CRITICAL(&s_lock);
+        s_stats.depth--;
+        taskEXIT_CRITICAL(&s_lock);
+
+        // The detached copy answers; completing it closes the socket
+        send_busy(copy, route);
+        WS_Metrics_End(route->metrics, copy, start);
+        httpd_req_async_handler_complete(copy);
+    }
+    return ESP_OK;
+}
+
+// ----------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------
+esp_err_t WS_Async_Init(void)
+{
+    if (NULL != s_queue) return ESP_OK;
+
+    s_queue = xQueueCreate(CONFIG_WS_ASYNC_QUEUE_LEN, sizeof(ws_async_job_t));
+    if (NULL == s_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_stats.workers   = CONFIG_WS_ASYNC_WORKERS;
+    s_stats.queue_len = CONFIG_WS_ASYNC_QUEUE_LEN;
+
+    for (int i = 0; i < CONFIG_WS_ASYNC_WORKERS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "ws_async%d", i);
+        // Internal-RAM stack: handlers write flash, which disables the PSRAM cache
+        if (pdPASS != xTaskCreate(worker_task, name, CONFIG_WS_ASYNC_WORKER_STACK, NULL, ASYNC_PRIORITY, NULL)) {
+            ESP_LOGE(TAG, "Failed to start %s", name);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    ESP_LOGI(TAG, "%d workers, queue of %d", CONFIG_WS_ASYNC_WORKERS, CONFIG_WS_ASYNC_QUEUE_LEN);
+    return ESP_OK;
+}
+
+esp_err_t WS_Async_RegisterUri(httpd_handle_t server, const httpd_uri_t* uri)
+{
+    // A route registered on both listeners keeps one entry
+    size_t slot = 0;
+    while ((slot < s_route_count) &&
+           ((s_routes[slot].method != uri->method) || (0 != strcmp(s_routes[slot].uri, uri->uri)))) {
+        slot++;
+    }
+    if (slot >= ASYNC_MAX_ROUTES) {
+        ESP_LOGE(TAG, "Route table full, %s not registered", uri->uri);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ws_async_route_t* route = &s_routes[slot];
+    route->handler    = uri->handler;
+    route->user_ctx   = uri->user_ctx;
+    route->uri        = uri->uri;     // string literal at every call site
+    route->method     = uri->method;
+    route->metrics    = WS_Metrics_AddRoute(uri->uri, uri->method);
+    route->rate_class = WS_RateLimit_ClassOf(uri->uri, uri->method);
+
+    httpd_uri_t wrapped = *uri;
+    wrapped.handler  = async_handler;
+    wrapped.user_ctx = route;
+
+    esp_err_t err = httpd_register_uri_handler(server, &wrapped);
+    if ((ESP_OK == err) && (slot == s_route_count)) {
+        s_route_count++;
+    }
+    return err;
+}
+
+void WS_Async_GetStats(ws_async_stats_t* stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
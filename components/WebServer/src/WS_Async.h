@@ -0,0 +1,55 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdint.h>
+
+/**
+ * Worker pool for slow HTTP handlers.
+ *
+ * esp_http_server runs every handler on its one task, so a factory reset,
+ * a large schedule upload or a WiFi scan stalls static files and status
+ * polling for every client. Routes registered through
+ * WS_Async_RegisterUri() are detached with httpd_req_async_handler_begin()
+ * and queued for CONFIG_WS_ASYNC_WORKERS worker tasks; everything else
+ * stays on the server task.
+ *
+ * The queue is bounded (CONFIG_WS_ASYNC_QUEUE_LEN). When it is full the
+ * request is answered 503 with Retry-After instead of waiting. Each queued
+ * or running request holds its socket, so workers + queue must stay below
+ * the server's max_open_sockets.
+ *
+ * Metrics (WS_Metrics) time these routes from handler entry on the server
+ * task, so the queue wait shows up in their latency.
+ *
+ * Handlers that run here share state with the server task: they must only
+ * use thread-safe APIs (auth, Scheduler, Schedule_Persist are) and get the
+ * heap instead of the request arena.
+ */
+
+typedef struct
+{
+    uint32_t workers;
+    uint32_t queue_len;         // capacity
+    uint32_t depth;             // waiting now
+    uint32_t depth_peak;
+    uint32_t running;           // on a worker now
+    uint32_t jobs;              // finished since boot
+    uint32_t rejected;          // turned away with 503, queue full
+    uint32_t wait_last_ms;      // queued until a worker picked it up
+    uint32_t wait_max_ms;
+    uint64_t wait_total_ms;     // over jobs + running, gives the average
+} ws_async_stats_t;
+
+/**
+ * @brief Create the queue and worker tasks. Call once, before the server starts.
+ */
+esp_err_t WS_Async_Init(void);
+
+/**
+ * @brief httpd_register_uri_handler() with the handler run on a worker.
+ *        The handler sees its own user_ctx as usual.
+ */
+esp_err_t WS_Async_RegisterUri(httpd_handle_t server, const httpd_uri_t* uri);
+
+void WS_Async_GetStats(ws_async_stats_t* stats);
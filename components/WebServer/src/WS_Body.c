@@ -0,0 +1,117 @@
+#include "WS_Body.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "Auth/WS_Auth.h"
+#include "WS_Arena.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "WS_BODY";
+
+#define WS_BODY_TIMEOUT_US ((int64_t)CONFIG_WS_BODY_READ_TIMEOUT_SEC * 1000000)
+
+esp_err_t WS_Body_Read(httpd_req_t* req, size_t max_len, char** out, size_t* out_len)
+{
+    *out = NULL;
+    if (out_len) *out_len = 0;
+
+    size_t total = req->content_len;
+    if (0 == total) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (total > max_len) {
+        ESP_LOGW(TAG, "%s: body %u bytes, limit %u", req->uri, (unsigned)total, (unsigned)max_len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Sized from Content-Length, so segments land in place and are never copied
+    char* buf = (char*)WS_Arena_Calloc(1, total + 1);
+    if (NULL == buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t deadline = esp_timer_get_time() + WS_BODY_TIMEOUT_US;
+    size_t  got      = 0;
+    while (got < total) {
+        int r = httpd_req_recv(req, buf + got, total - got);
+        if (HTTPD_SOCK_ERR_TIMEOUT == r) {
+            // Each recv already waited recv_wait_timeout; keep going on a slow link
+            if (esp_timer_get_time() < deadline) continue;
+            ESP_LOGW(TAG, "%s: timed out after %u of %u bytes", req->uri, (unsigned)got, (unsigned)total);
+            WS_Arena_Free(buf);
+            return ESP_ERR_TIMEOUT;
+        }
+        if (r <= 0) {
+            WS_Arena_Free(buf);
+            return ESP_FAIL;
+        }
+        got += (size_t)r;
+    }
+
+    buf[got] = '\0';
+    *out = buf;
+    if (out_len) *out_len = got;
+    return ESP_OK;
+}
+
+esp_err_t WS_Body_ReadJson(httpd_req_t* req, size_t max_len, cJSON** out)
+{
+    *out = NULL;
+
+    char*     buf = NULL;
+    size_t    len = 0;
+    esp_err_t err = WS_Body_Read(req, max_len, &buf, &len);
+    if (ESP_OK != err) {
+        return err;
+    }
+
+    *out = cJSON_ParseWithLength(buf, len);
+    WS_Arena_Free(buf);
+    return (NULL == *out) ? ESP_ERR_INVALID_RESPONSE : ESP_OK;
+}
+
+esp_err_t WS_Body_SendError(httpd_req_t* req, esp_err_t err)
+{
+    const char* status;
+    const char* json;
+    esp_err_t   ret = ESP_OK;
+
+    switch (err) {
+        case ESP_ERR_NOT_FOUND:
+            status = "400 Bad Request";
+            json   = "{\"error\":\"Empty body\"}";
+            break;
+        case ESP_ERR_INVALID_RESPONSE:
+            status = "400 Bad Request";
+            json   = "{\"error\":\"Invalid JSON\"}";
+            break;
+        case ESP_ERR_INVALID_SIZE:
+            status = "413 Payload Too Large";
+            json   = "{\"error\":\"Body too large\"}";
+            ret    = ESP_FAIL;
+            break;
+        case ESP_ERR_TIMEOUT:
+            status = "408 Request Timeout";
+            json   = "{\"error\":\"Body not received in time\"}";
+            ret    = ESP_FAIL;
+            break;
+        case ESP_ERR_NO_MEM:
+            status = "500 Internal Server Error";
+            json   = "{\"error\":\"Out of memory\"}";
+            ret    = ESP_FAIL;
+            break;
+        default:
+            return ESP_FAIL;    // connection is gone, nothing to answer
+    }
+
+    auth_set_security_headers(req);
+    httpd_resp_set_status(req, status);
+    if (ESP_FAIL == ret) {
+        httpd_resp_set_hdr(req, "Connection", "close");
+    }
+    httpd_resp_sendstr(req, json);
+    return ret;
+}
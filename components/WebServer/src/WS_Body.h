@@ -0,0 +1,47 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "cJSON.h"
+#include <stddef.h>
+
+/**
+ * Request body reader shared by the REST handlers.
+ *
+ * httpd_req_recv() returns whatever has arrived so far, which on a slow
+ * link is one TCP segment of a larger body. These helpers keep receiving
+ * until Content-Length bytes are in, retrying socket timeouts until
+ * CONFIG_WS_BODY_READ_TIMEOUT_SEC has passed.
+ *
+ * Errors:
+ *   ESP_ERR_NOT_FOUND         no body (Content-Length 0)
+ *   ESP_ERR_INVALID_SIZE      Content-Length above the route's limit
+ *   ESP_ERR_TIMEOUT           body did not arrive in time
+ *   ESP_ERR_NO_MEM            buffer allocation failed
+ *   ESP_ERR_INVALID_RESPONSE  (ReadJson only) body is not valid JSON
+ *   ESP_FAIL                  client closed the connection
+ */
+
+/**
+ * @brief Read the whole body into a new NUL-terminated buffer, taken from
+ *        the request arena when there is one (see WS_Arena.h).
+ * @param max_len  Largest body accepted for this route, in bytes.
+ * @param out      Receives the buffer; release it with WS_Arena_Free().
+ * @param out_len  Body length, may be NULL.
+ */
+esp_err_t WS_Body_Read(httpd_req_t* req, size_t max_len, char** out, size_t* out_len);
+
+/**
+ * @brief Read the whole body and parse it. The receive buffer is freed
+ *        before returning.
+ * @param out  Receives the parse result; release it with cJSON_Delete().
+ */
+esp_err_t WS_Body_ReadJson(httpd_req_t* req, size_t max_len, cJSON** out);
+
+/**
+ * @brief Answer a failed read with a JSON error (400, 408, 413 or 500).
+ * @return The value the handler should return: ESP_FAIL when the client
+ *         is gone or the rest of the body was not read, so the server
+ *         closes the socket instead of parsing leftover body as a request.
+ */
+esp_err_t WS_Body_SendError(httpd_req_t* req, esp_err_t err);
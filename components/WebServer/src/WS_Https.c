@@ -0,0 +1,320 @@
+#include "WS_Https.h"
+
+#include <string.h>
+
+#include "sdkconfig.h"
+
+#if CONFIG_WS_HTTPS_ENABLE
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "WS_Public.h"
+#include "NVS_Config.h"
+#include "esp_https_server.h"
+#include "esp_tls.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ecp.h"
+#include "mbedtls/x509_crt.h"
+
+static const char* TAG = "WS_HTTPS";
+
+#define TLS_NVS_NAMESPACE   "tls"
+#define KEY_CERT            "cert"
+#define KEY_PKEY            "key"
+#define CERT_PEM_MAX        1536
+#define PKEY_PEM_MAX        512
+#define CERT_HOST           WS_MDNS_HOSTNAME ".local"
+#define CERT_SUBJECT        "CN=" CERT_HOST ",O=Ringy School Bell"
+#define CERT_NOT_BEFORE     "20240101000000"    // the clock may not be set yet
+#define CERT_NOT_AFTER      "20491231235959"
+
+static httpd_handle_t   s_server = NULL;
+static char*            s_cert_pem = NULL;      // kept for the server's lifetime
+static char*            s_pkey_pem = NULL;
+static int              s_fds[CONFIG_WS_HTTPS_MAX_SOCKETS];
+static ws_https_stats_t s_stats;
+static portMUX_TYPE     s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ----------------------------------------------------------------
+// Certificate
+// ----------------------------------------------------------------
+static int cert_rng(void* ctx, unsigned char* buf, size_t len)
+{
+    (void)ctx;
+    esp_fill_random(buf, len);
+    return 0;
+}
+
+static esp_err_t cert_create(char* cert_pem, char* pkey_pem)
+{
+    mbedtls_pk_context     key;
+    mbedtls_x509write_cert crt;
+    unsigned char          serial[16];
+
+    mbedtls_pk_init(&key);
+    mbedtls_x509write_crt_init(&crt);
+
+    esp_fill_random(serial, sizeof(serial));
+    serial[0] = (serial[0] & 0x7F) | 0x40;     // positive, no leading zero byte
+
+    mbedtls_x509_san_list san = {
+        .node = {
+            .type = MBEDTLS_X509_SAN_DNS_NAME,
+            .san.unstructured_name = {
+                .p   = (unsigned char*)CERT_HOST,
+                .len = sizeof(CERT_HOST) - 1,
+            },
+        },
+        .next = NULL,
+    };
+
+    int ret = mbedtls_pk_setup(&key, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+    if (0 == ret) {
+        ret = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, mbedtls_pk_ec(key), cert_rng, NULL);
+    }
+    if (0 == ret) {
+        mbedtls_x509write_crt_set_version(&crt, MBEDTLS_X509_CRT_VERSION_3);
+        mbedtls_x509write_crt_set_md_alg(&crt, MBEDTLS_MD_SHA256);
+        mbedtls_x509write_crt_set_subject_key(&crt, &key);
+        mbedtls_x509write_crt_set_issuer_key(&crt, &key);
+        ret = mbedtls_x509write_crt_set_subject_name(&crt, CERT_SUBJECT);
+    }
+    if (0 == ret) { ret = mbedtls_x509write_crt_set_issuer_name(&crt, CERT_SUBJECT); }
+    if (0 == ret) { ret = mbedtls_x509write_crt_set_serial_raw(&crt, serial, sizeof(serial)); }
+    if (0 == ret) { ret = mbedtls_x509write_crt_set_validity(&crt, CERT_NOT_BEFORE, CERT_NOT_AFTER); }
+    if (0 == ret) { ret = mbedtls_x509write_crt_set_basic_constraints(&crt, 0, -1); }
+    if (0 == ret) { ret = mbedtls_x509write_crt_set_key_usage(&crt, MBEDTLS_X509_KU_DIGITAL_SIGNATURE); }
+    if (0 == ret) { ret = mbedtls_x509write_crt_set_subject_key_identifier(&crt); }
+    if (0 == ret) { ret = mbedtls_x509write_crt_set_subject_alternative_name(&crt, &san); }
+    if (0 == ret) {
+        ret = mbedtls_x509write_crt_pem(&crt, (unsigned char*)cert_pem, CERT_PEM_MAX, cert_rng, NULL);
+    }
+    if (0 == ret) {
+        ret = mbedtls_pk_write_key_pem(&key, (unsigned char*)pkey_pem, PKEY_PEM_MAX);
+    }
+
+    mbedtls_x509write_crt_free(&crt);
+    mbedtls_pk_free(&key);
+
+    if (0 != ret) {
+        ESP_LOGE(TAG, "Certificate generation failed: -0x%04x", (unsigned)-ret);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t pem_load(const char* key, char* out, size_t max)
+{
+    size_t len = max;
+    esp_err_t err = NVS_Config_GetBlob(TLS_NVS_NAMESPACE, key, out, &len);
+    if ((ESP_OK == err) && ((0 == len) || ('\0' != out[len - 1]))) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    return err;
+}
+
+// The key never leaves the device; erasing the "tls" namespace makes a new one
+static esp_err_t cert_load_or_create(void)
+{
+    s_cert_pem = (char*)calloc(1, CERT_PEM_MAX);
+    s_pkey_pem = (char*)calloc(1, PKEY_PEM_MAX);
+    if ((NULL == s_cert_pem) || (NULL == s_pkey_pem)) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = pem_load(KEY_CERT, s_cert_pem, CERT_PEM_MAX);
+    if (ESP_OK == err) {
+        err = pem_load(KEY_PKEY, s_pkey_pem, PKEY_PEM_MAX);
+    }
+    if (ESP_OK == err) {
+        ESP_LOGI(TAG, "Certificate loaded from NVS");
+        return ESP_OK;
+    }
+    if (ESP_ERR_NVS_NOT_FOUND != err) {
+        ESP_LOGW(TAG, "Stored certificate unusable (%s), making a new one", esp_err_to_name(err));
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    err = cert_create(s_cert_pem, s_pkey_pem);
+    if (ESP_OK != err) {
+        return err;
+    }
+    s_stats.cert_created_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    err = NVS_Config_SetBlob(TLS_NVS_NAMESPACE, KEY_CERT, s_cert_pem, strlen(s_cert_pem) + 1);
+    if (ESP_OK == err) {
+        err = NVS_Config_SetBlob(TLS_NVS_NAMESPACE, KEY_PKEY, s_pkey_pem, strlen(s_pkey_pem) + 1);
+    }
+    if (ESP_OK == err) {
+        err = NVS_Config_Flush();
+    }
+    if (ESP_OK != err) {
+        // Still usable this boot; browsers will see a new certificate next time
+        ESP_LOGW(TAG, "Could not store the certificate: %s", esp_err_to_name(err));
+    }
+
+    ESP_LOGI(TAG, "Self-signed certificate for %s created in %lu ms",
+             CERT_HOST, (unsigned long)s_stats.cert_created_ms);
+    return ESP_OK;
+}
+
+// ----------------------------------------------------------------
+// Session accounting. esp_https_server calls open_fn after a completed
+// handshake; close_fn runs for every socket, failed handshakes included
+// ----------------------------------------------------------------
+static esp_err_t https_open(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < CONFIG_WS_HTTPS_MAX_SOCKETS; i++) {
+        if (s_fds[i] < 0) {
+            s_fds[i] = sockfd;
+            s_stats.open++;
+            break;
+        }
+    }
+    s_stats.sessions++;
+    taskEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+static void https_close(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < CONFIG_WS_HTTPS_MAX_SOCKETS; i++) {
+        if (s_fds[i] == sockfd) {
+            s_fds[i] = -1;
+            s_stats.open--;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    // With a close_fn set, closing the socket is ours to do
+    close(sockfd);
+}
+
+// ----------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------
+esp_err_t WS_Https_Start(const httpd_config_t* base, httpd_handle_t* out)
+{
+    if (NULL != s_server) {
+        *out = s_server;
+        return ESP_OK;
+    }
+
+    esp_err_t err = cert_load_or_create();
+    if (ESP_OK != err) {
+        return err;
+    }
+
+    for (int i = 0; i < CONFIG_WS_HTTPS_MAX_SOCKETS; i++) {
+        s_fds[i] = -1;
+    }
+
+    httpd_ssl_config_t conf = HTTPD_SSL_CONFIG_DEFAULT();
+    conf.httpd                  = *base;
+    conf.httpd.ctrl_port        = base->ctrl_port + 1;      // one per server
+    conf.httpd.max_open_sockets = CONFIG_WS_HTTPS_MAX_SOCKETS;
+    conf.httpd.open_fn          = https_open;
+    conf.httpd.close_fn         = https_close;
+    conf.port_secure            = CONFIG_WS_HTTPS_PORT;
+    conf.servercert             = (const uint8_t*)s_cert_pem;
+    conf.servercert_len         = strlen(s_cert_pem) + 1;
+    conf.prvtkey_pem            = (const uint8_t*)s_pkey_pem;
+    conf.prvtkey_len            = strlen(s_pkey_pem) + 1;
+#if CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+    conf.session_tickets        = true;
+#endif
+
+    err = httpd_ssl_start(&s_server, &conf);
+    if (ESP_OK != err) {
+        s_server = NULL;
+        return err;
+    }
+
+    s_stats.enabled         = true;
+    s_stats.port            = CONFIG_WS_HTTPS_PORT;
+    s_stats.session_tickets = conf.session_tickets;
+    ESP_LOGI(TAG, "HTTPS listening on port %d (%d sockets, session tickets %s)",
+             CONFIG_WS_HTTPS_PORT, CONFIG_WS_HTTPS_MAX_SOCKETS, conf.session_tickets ? "on" : "off");
+
+    *out = s_server;
+    return ESP_OK;
+}
+
+bool WS_Https_Owns(httpd_handle_t hd)
+{
+    return (NULL != hd) && (hd == s_server);
+}
+
+bool WS_Https_IsSecure(httpd_req_t* req)
+{
+    return WS_Https_Owns(req->handle);
+}
+
+// Same as esp_https_server's send: the session's transport context is its esp_tls
+int WS_Https_Send(httpd_handle_t hd, int sockfd, const char* buf, size_t buf_len, int flags)
+{
+    (void)flags;
+    esp_tls_t* tls = (esp_tls_t*)httpd_sess_get_transport_ctx(hd, sockfd);
+    if ((NULL == tls) || (NULL == buf)) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+
+    ssize_t ret = esp_tls_conn_write(tls, buf, buf_len);
+    if (ret < 0) {
+        return ((ESP_TLS_ERR_SSL_WANT_READ == ret) || (ESP_TLS_ERR_SSL_WANT_WRITE == ret))
+               ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+    }
+    return (int)ret;
+}
+
+void WS_Https_GetStats(ws_https_stats_t* stats)
+{
+    taskENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+#else   // CONFIG_WS_HTTPS_ENABLE
+
+esp_err_t WS_Https_Start(const httpd_config_t* base, httpd_handle_t* out)
+{
+    (void)base;
+    *out = NULL;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool WS_Https_Owns(httpd_handle_t hd)
+{
+    (void)hd;
+    return false;
+}
+
+bool WS_Https_IsSecure(httpd_req_t* req)
+{
+    (void)req;
+    return false;
+}
+
+int WS_Https_Send(httpd_handle_t hd, int sockfd, const char* buf, size_t buf_len, int flags)
+{
+    (void)hd; (void)sockfd; (void)buf; (void)buf_len; (void)flags;
+    return HTTPD_SOCK_ERR_INVALID;
+}
+
+void WS_Https_GetStats(ws_https_stats_t* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif  // CONFIG_WS_HTTPS_ENABLE
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Optional HTTPS listener (CONFIG_WS_HTTPS_ENABLE) next to the plain HTTP
+ * one. Both serve the same routes; WS_Station registers them on each.
+ *
+ * The certificate is a self-signed ECDSA P-256 one made on the device the
+ * first time and kept in NVS (namespace "tls"), so it survives reboots and
+ * firmware updates and browsers only have to accept it once. ECDSA keeps
+ * the handshake's signature cheap; with CONFIG_ESP_TLS_SERVER_SESSION_TICKETS
+ * a returning browser resumes its session and skips the ECDHE exchange.
+ *
+ * TLS sessions send through esp_tls. Code that overrides a session's send
+ * function (WS_Metrics) must route those sessions through WS_Https_Send().
+ */
+
+typedef struct
+{
+    bool     enabled;           // listener running
+    uint16_t port;
+    bool     session_tickets;
+    uint32_t open;              // TLS sessions now
+    uint32_t sessions;          // handshakes completed since boot
+    uint32_t cert_created_ms;   // time to make the certificate this boot, 0 if loaded
+} ws_https_stats_t;
+
+/**
+ * @brief Load or create the certificate and start the listener.
+ * @param base  Settings shared with the HTTP listener (handlers, timeouts,
+ *              stack); port, sockets and control port are set here.
+ * @param out   Server handle, for registering routes.
+ */
+esp_err_t WS_Https_Start(const httpd_config_t* base, httpd_handle_t* out);
+
+/**
+ * @brief True if the request came in over TLS.
+ */
+bool WS_Https_IsSecure(httpd_req_t* req);
+
+/**
+ * @brief True if hd is the HTTPS listener.
+ */
+bool WS_Https_Owns(httpd_handle_t hd);
+
+/**
+ * @brief esp_https_server's own send, for sessions of WS_Https_Owns() servers.
+ */
+int WS_Https_Send(httpd_handle_t hd, int sockfd, const char* buf, size_t buf_len, int flags);
+
+void WS_Https_GetStats(ws_https_stats_t* stats);
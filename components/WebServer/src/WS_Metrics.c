@@ -0,0 +1,501 @@
+#include "WS_Metrics.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/socket.h>
+
+#include "Auth/WS_Auth.h"
+#include "WS_Arena.h"
+#include "WS_Https.h"
+#include "WS_RateLimit.h"
+#include "cJSON.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "WS_METRICS";
+
+#define METRICS_MAX_ROUTES  64      // matches the server's max_uri_handlers
+#define METRICS_URI_MAX     40
+#define METRICS_BUCKETS     14      // 13 bounds + overflow
+#define METRICS_CLASSES     6       // no response, 1xx .. 5xx
+#define METRICS_SOCKETS     CONFIG_LWIP_MAX_SOCKETS
+#define METRICS_OUT_CHUNK   1024
+#define METRICS_PREFIX      "ringy_http_"
+
+// Upper bounds in ms; coarse enough to stay small, fine enough for p95
+static const uint32_t s_bound_ms[METRICS_BUCKETS - 1] = {
+    1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000
+};
+static const char* const s_class_name[METRICS_CLASSES] = {
+    "none", "1xx", "2xx", "3xx", "4xx", "5xx"
+};
+
+struct ws_metrics_route
+{
+    char             uri[METRICS_URI_MAX];
+    httpd_method_t   method;
+    esp_err_t      (*handler)(httpd_req_t* req);
+    void*            user_ctx;
+    ws_rate_class_t  rate_class;
+
+    uint32_t         requests;
+    uint32_t         status[METRICS_CLASSES];
+    uint64_t         bytes;
+    uint32_t         buckets[METRICS_BUCKETS];
+    uint64_t         sum_us;
+    uint32_t         max_us;
+};
+
+// What the send override has seen on a socket during the current request
+typedef struct
+{
+    int      fd;                    // -1 = free
+    uint32_t bytes;
+    uint16_t status;
+} ws_metrics_sock_t;
+
+static ws_metrics_route_t* s_routes = NULL;     // PSRAM, METRICS_MAX_ROUTES
+static size_t              s_route_count = 0;
+static ws_metrics_sock_t   s_socks[METRICS_SOCKETS];
+static portMUX_TYPE        s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ----------------------------------------------------------------
+// Socket accounting
+// ----------------------------------------------------------------
+
+// Caller holds s_lock
+static ws_metrics_sock_t* sock_find(int fd)
+{
+    for (int i = 0; i < METRICS_SOCKETS; i++) {
+        if (s_socks[i].fd == fd) return &s_socks[i];
+    }
+    return NULL;
+}
+
+// Same as httpd's default send
+static int plain_send(int sockfd, const char* buf, size_t buf_len, int flags)
+{
+    int ret = send(sockfd, buf, buf_len, flags);
+    if (ret < 0) {
+        switch (errno) {
+            case EAGAIN:
+            case EINTR:
+                return HTTPD_SOCK_ERR_TIMEOUT;
+            case EINVAL:
+            case EBADF:
+            case EFAULT:
+            case ENOTSOCK:
+                return HTTPD_SOCK_ERR_INVALID;
+            default:
+                return HTTPD_SOCK_ERR_FAIL;
+        }
+    }
+    return ret;
+}
+
+// The session's own send, plus counting. TLS sessions count plaintext bytes
+static int metrics_send(httpd_handle_t hd, int sockfd, const char* buf, size_t buf_len, int flags)
+{
+    if (NULL == buf) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+
+    int ret = WS_Https_Owns(hd) ? WS_Https_Send(hd, sockfd, buf, buf_len, flags)
+                                : plain_send(sockfd, buf, buf_len, flags);
+    if (ret < 0) {
+        return ret;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    ws_metrics_sock_t* sock = sock_find(sockfd);
+    if (NULL != sock) {
+        // httpd writes the status line as the first bytes of a response
+        if ((0 == sock->status) && (ret >= 12) && (0 == memcmp(buf, "HTTP/1.1 ", 9))) {
+            sock->status = (uint16_t)((buf[9] - '0') * 100 + (buf[10] - '0') * 10 + (buf[11] - '0'));
+        }
+        sock->bytes += (uint32_t)ret;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    return ret;
+}
+
+// ----------------------------------------------------------------
+// Histogram
+// ----------------------------------------------------------------
+static int bucket_of(uint32_t us)
+{
+    for (int i = 0; i < METRICS_BUCKETS - 1; i++) {
+        if (us <= s_bound_ms[i] * 1000) return i;
+    }
+    return METRICS_BUCKETS - 1;
+}
+
+// Linear interpolation inside the bucket holding the q-th request
+static uint32_t quantile_us(const ws_metrics_route_t* r, float q)
+{
+    if (0 == r->requests) return 0;
+
+    float    target = q * (float)r->requests;
+    uint32_t cum    = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        if ((0 == r->buckets[i]) || ((float)(cum + r->buckets[i]) < target)) {
+            cum += r->buckets[i];
+            continue;
+        }
+        uint32_t lower = (i > 0) ? s_bound_ms[i - 1] * 1000 : 0;
+        uint32_t upper = (i < METRICS_BUCKETS - 1) ? s_bound_ms[i] * 1000 : r->max_us;
+        if (upper > r->max_us) upper = r->max_us;
+        if (lower > upper) lower = upper;
+        float frac = (target - (float)cum) / (float)r->buckets[i];
+        return lower + (uint32_t)((float)(upper - lower) * frac);
+    }
+    return r->max_us;
+}
+
+// ----------------------------------------------------------------
+// Wrapper
+// ----------------------------------------------------------------
+static esp_err_t metrics_handler(httpd_req_t* req)
+{
+    ws_metrics_route_t* route = (ws_metrics_route_t*)req->user_ctx;
+
+    int64_t start = WS_Metrics_Begin(req);
+    if (!WS_RateLimit_Admit(req, route->rate_class)) {
+        WS_Metrics_End(route, req, start);
+        return ESP_FAIL;
+    }
+
+    req->user_ctx = route->user_ctx;
+    esp_err_t err = route->handler(req);
+    req->user_ctx = route;
+    WS_Metrics_End(route, req, start);
+    return err;
+}
+
+// ----------------------------------------------------------------
+// Export
+// ----------------------------------------------------------------
+typedef struct
+{
+    httpd_req_t* req;
+    esp_err_t    err;
+    size_t       len;
+    char         buf[METRICS_OUT_CHUNK];
+} metrics_out_t;
+
+static void out_flush(metrics_out_t* out)
+{
+    if ((ESP_OK == out->err) && (out->len > 0)) {
+        out->err = httpd_resp_send_chunk(out->req, out->buf, out->len);
+    }
+    out->len = 0;
+}
+
+// Formats straight into the chunk buffer; what does not fit goes out
+// first and the text is formatted again at the start
+static void out_printf(metrics_out_t* out, const char* fmt, ...)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t  room = sizeof(out->buf) - out->len;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(out->buf + out->len, room, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if ((size_t)n < room) {
+            out->len += (size_t)n;
+            return;
+        }
+        out_flush(out);
+    }
+}
+
+// Copy the routes that have seen traffic, so export runs without the lock
+static size_t snapshot(ws_metrics_route_t* snap)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < s_route_count; i++) {
+        taskENTER_CRITICAL(&s_lock);
+        if (s_routes[i].requests > 0) {
+            snap[n++] = s_routes[i];
+        }
+        taskEXIT_CRITICAL(&s_lock);
+    }
+    return n;
+}
+
+static esp_err_t send_prometheus(httpd_req_t* req, const ws_metrics_route_t* snap, size_t n)
+{
+    metrics_out_t* out = (metrics_out_t*)WS_Arena_Calloc(1, sizeof(metrics_out_t));
+    if (NULL == out) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    out->req = req;
+
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    out_printf(out, "# HELP " METRICS_PREFIX "requests_total Requests answered, by route and status class.\n"
+                    "# TYPE " METRICS_PREFIX "requests_total counter\n");
+    for (size_t i = 0; i < n; i++) {
+        for (int c = 0; c < METRICS_CLASSES; c++) {
+            if (0 == snap[i].status[c]) continue;
+            out_printf(out, METRICS_PREFIX "requests_total{method=\"%s\",route=\"%s\",code=\"%s\"} %lu\n",
+                       http_method_str(snap[i].method), snap[i].uri, s_class_name[c],
+                       (unsigned long)snap[i].status[c]);
+        }
+    }
+
+    out_printf(out, "# HELP " METRICS_PREFIX "response_bytes_total Bytes written to the socket, headers included.\n"
+                    "# TYPE " METRICS_PREFIX "response_bytes_total counter\n");
+    for (size_t i = 0; i < n; i++) {
+        out_printf(out, METRICS_PREFIX "response_bytes_total{method=\"%s\",route=\"%s\"} %llu\n",
+                   http_method_str(snap[i].method), snap[i].uri, (unsigned long long)snap[i].bytes);
+    }
+
+    out_printf(out, "# HELP " METRICS_PREFIX "request_duration_seconds From handler entry (headers parsed) until the handler finished.\n"
+                    "# TYPE " METRICS_PREFIX "request_duration_seconds histogram\n");
+    for (size_t i = 0; i < n; i++) {
+        const char* method = http_method_str(snap[i].method);
+        uint32_t    cum    = 0;
+        for (int b = 0; b < METRICS_BUCKETS - 1; b++) {
+            cum += snap[i].buckets[b];
+            out_printf(out, METRICS_PREFIX "request_duration_seconds_bucket{method=\"%s\",route=\"%s\",le=\"%g\"} %lu\n",
+                       method, snap[i].uri, s_bound_ms[b] / 1000.0, (unsigned long)cum);
+        }
+        out_printf(out, METRICS_PREFIX "request_duration_seconds_bucket{method=\"%s\",route=\"%s\",le=\"+Inf\"} %lu\n"
+                        METRICS_PREFIX "request_duration_seconds_sum{method=\"%s\",route=\"%s\"} %.6f\n"
+                        METRICS_PREFIX "request_duration_seconds_count{method=\"%s\",route=\"%s\"} %lu\n",
+                   method, snap[i].uri, (unsigned long)snap[i].requests,
+                   method, snap[i].uri, snap[i].sum_us / 1e6,
+                   method, snap[i].uri, (unsigned long)snap[i].requests);
+    }
+
+    out_printf(out, "# HELP " METRICS_PREFIX "request_duration_quantile_seconds p50/p95 estimated from the histogram; quantile 1 is the exact max.\n"
+                    "# TYPE " METRICS_PREFIX "request_duration_quantile_seconds gauge\n");
+    for (size_t i = 0; i < n; i++) {
+        const char* method = http_method_str(snap[i].method);
+        out_printf(out, METRICS_PREFIX "request_duration_quantile_seconds{method=\"%s\",route=\"%s\",quantile=\"0.5\"} %.6f\n",
+                   method, snap[i].uri, quantile_us(&snap[i], 0.5f) / 1e6);
+        out_printf(out, METRICS_PREFIX "request_duration_quantile_seconds{method=\"%s\",route=\"%s\",quantile=\"0.95\"} %.6f\n",
+                   method, snap[i].uri, quantile_us(&snap[i], 0.95f) / 1e6);
+        out_printf(out, METRICS_PREFIX "request_duration_quantile_seconds{method=\"%s\",route=\"%s\",quantile=\"1\"} %.6f\n",
+                   method, snap[i].uri, snap[i].max_us / 1e6);
+    }
+
+    out_flush(out);
+    esp_err_t err = out->err;
+    WS_Arena_Free(out);
+    if (ESP_OK == err) {
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    return err;
+}
+
+static esp_err_t send_json(httpd_req_t* req, const ws_metrics_route_t* snap, size_t n)
+{
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "uptimeSec", (double)(esp_timer_get_time() / 1000000));
+    cJSON* routes = cJSON_AddArrayToObject(root, "routes");
+
+    for (size_t i = 0; i < n; i++) {
+        const ws_metrics_route_t* r = &snap[i];
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "method", http_method_str(r->method));
+        cJSON_AddStringToObject(item, "route", r->uri);
+        cJSON_AddNumberToObject(item, "requests", r->requests);
+
+        cJSON* status = cJSON_AddObjectToObject(item, "status");
+        for (int c = 0; c < METRICS_CLASSES; c++) {
+            if (r->status[c] > 0) cJSON_AddNumberToObject(status, s_class_name[c], r->status[c]);
+        }
+        cJSON_AddNumberToObject(item, "bytes", (double)r->bytes);
+
+        cJSON* latency = cJSON_AddObjectToObject(item, "latencyMs");
+        cJSON_AddNumberToObject(latency, "p50", quantile_us(r, 0.5f) / 1000.0);
+        cJSON_AddNumberToObject(latency, "p95", quantile_us(r, 0.95f) / 1000.0);
+        cJSON_AddNumberToObject(latency, "max", r->max_us / 1000.0);
+        cJSON_AddNumberToObject(latency, "avg", (double)r->sum_us / r->requests / 1000.0);
+        cJSON_AddItemToArray(routes, item);
+    }
+
+    char* json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (NULL == json) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    auth_set_security_headers(req);
+    esp_err_t err = httpd_resp_sendstr(req, json);
+    cJSON_free(json);
+    return err;
+}
+
+// GET /api/metrics[?format=json] — public, like /api/status, so the NOC
+// can scrape without a session
+static esp_err_t api_metrics(httpd_req_t* req)
+{
+    bool as_json = false;
+    char query[32];
+    char value[8];
+    if ((ESP_OK == httpd_req_get_url_query_str(req, query, sizeof(query))) &&
+        (ESP_OK == httpd_query_key_value(query, "format", value, sizeof(value)))) {
+        as_json = (0 == strcmp(value, "json"));
+    }
+
+    ws_metrics_route_t* snap = (ws_metrics_route_t*)WS_Arena_Calloc(METRICS_MAX_ROUTES, sizeof(ws_metrics_route_t));
+    if (NULL == snap) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    size_t n = (NULL != s_routes) ? snapshot(snap) : 0;
+
+    esp_err_t err = as_json ? send_json(req, snap, n) : send_prometheus(req, snap, n);
+    WS_Arena_Free(snap);
+    return err;
+}
+
+// ----------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------
+esp_err_t WS_Metrics_Init(void)
+{
+    if (NULL != s_routes) return ESP_OK;
+
+    for (int i = 0; i < METRICS_SOCKETS; i++) {
+        s_socks[i].fd = -1;
+    }
+
+    s_routes = (ws_metrics_route_t*)heap_caps_calloc(METRICS_MAX_ROUTES, sizeof(ws_metrics_route_t),
+                                                     MALLOC_CAP_SPIRAM);
+    if (NULL == s_routes) {
+        s_routes = (ws_metrics_route_t*)calloc(METRICS_MAX_ROUTES, sizeof(ws_metrics_route_t));
+    }
+    return (NULL != s_routes) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// Registration runs on one task, before either server takes requests
+static ws_metrics_route_t* route_find(const char* uri, httpd_method_t method)
+{
+    for (size_t i = 0; i < s_route_count; i++) {
+        if ((s_routes[i].method == method) && (0 == strncmp(s_routes[i].uri, uri, sizeof(s_routes[i].uri) - 1))) {
+            return &s_routes[i];
+        }
+    }
+    return NULL;
+}
+
+ws_metrics_route_t* WS_Metrics_AddRoute(const char* uri, httpd_method_t method)
+{
+    if (NULL == s_routes) {
+        return NULL;
+    }
+
+    // The HTTP and HTTPS listeners register the same routes and share counters
+    ws_metrics_route_t* route = route_find(uri, method);
+    if (NULL != route) {
+        return route;
+    }
+    if (s_route_count >= METRICS_MAX_ROUTES) {
+        ESP_LOGE(TAG, "No metrics slot for %s", uri);
+        return NULL;
+    }
+
+    route = &s_routes[s_route_count++];
+    snprintf(route->uri, sizeof(route->uri), "%s", uri);
+    route->method = method;
+    return route;
+}
+
+esp_err_t WS_Metrics_RegisterUri(httpd_handle_t server, const httpd_uri_t* uri)
+{
+    size_t count = s_route_count;
+    ws_metrics_route_t* route = WS_Metrics_AddRoute(uri->uri, uri->method);
+    if (NULL == route) {
+        return ESP_ERR_NO_MEM;
+    }
+    route->handler    = uri->handler;
+    route->user_ctx   = uri->user_ctx;
+    route->rate_class = WS_RateLimit_ClassOf(uri->uri, uri->method);
+
+    httpd_uri_t wrapped = *uri;
+    wrapped.handler  = metrics_handler;
+    wrapped.user_ctx = route;
+
+    esp_err_t err = httpd_register_uri_handler(server, &wrapped);
+    if ((ESP_OK != err) && (s_route_count > count)) {
+        s_route_count--;
+    }
+    return err;
+}
+
+int64_t WS_Metrics_Begin(httpd_req_t* req)
+{
+    int fd = httpd_req_to_sockfd(req);
+    if (fd >= 0) {
+        taskENTER_CRITICAL(&s_lock);
+        ws_metrics_sock_t* sock = sock_find(fd);
+        if (NULL == sock) sock = sock_find(-1);
+        if (NULL != sock) {
+            sock->fd     = fd;
+            sock->bytes  = 0;
+            sock->status = 0;
+        }
+        taskEXIT_CRITICAL(&s_lock);
+
+        // Stays on the session; harmless between requests
+        httpd_sess_set_send_override(req->handle, fd, metrics_send);
+    }
+    return esp_timer_get_time();
+}
+
+void WS_Metrics_End(ws_metrics_route_t* route, httpd_req_t* req, int64_t start_us)
+{
+    int64_t elapsed = esp_timer_get_time() - start_us;
+    uint32_t us = (elapsed > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+    int bucket = bucket_of(us);
+    int fd = httpd_req_to_sockfd(req);
+
+    taskENTER_CRITICAL(&s_lock);
+    uint32_t bytes  = 0;
+    uint16_t status = 0;
+    ws_metrics_sock_t* sock = (fd >= 0) ? sock_find(fd) : NULL;
+    if (NULL != sock) {
+        bytes    = sock->bytes;
+        status   = sock->status;
+        sock->fd = -1;
+    }
+    if (NULL != route) {
+        int cls = ((status >= 100) && (status < 600)) ? status / 100 : 0;
+        route->requests++;
+        route->status[cls]++;
+        route->bytes += bytes;
+        route->buckets[bucket]++;
+        route->sum_us += us;
+        if (us > route->max_us) route->max_us = us;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t WS_Metrics_RegisterEndpoints(httpd_handle_t server)
+{
+    httpd_uri_t metrics = {
+        .uri     = "/api/metrics",
+        .method  = HTTP_GET,
+        .handler = api_metrics,
+    };
+    esp_err_t err = WS_Arena_RegisterUri(server, &metrics);
+    if (ESP_OK == err) {
+        ESP_LOGI(TAG, "Metrics endpoint registered: /api/metrics");
+    }
+    return err;
+}
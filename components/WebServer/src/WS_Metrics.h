@@ -0,0 +1,55 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdint.h>
+
+/**
+ * Per-route HTTP metrics: request count, status class counts, bytes sent
+ * and a latency histogram (p50/p95 estimated from it, max exact).
+ *
+ * Routes registered through WS_Metrics_RegisterUri() are timed around the
+ * handler and checked against the client's rate budget (WS_RateLimit). Bytes and status come from the socket itself: for the duration
+ * of a request the session's send function is overridden, so everything
+ * httpd writes (headers included) is counted and the status line is read
+ * back; TLS sessions still send through esp_tls (WS_Https_Send). A route
+ * registered on both the HTTP and HTTPS listener has one entry, so the
+ * counts cover both. WS_Arena_RegisterUri() and WS_Async_RegisterUri() route through
+ * here too; async routes are timed from handler entry on the server task
+ * to the worker finishing, queue wait included.
+ *
+ * The clock starts when httpd calls the handler, after the request line
+ * and headers are parsed. Time spent before that is not counted: in the
+ * listen backlog, behind other requests on the server task, or receiving
+ * the headers.
+ *
+ * Exported at GET /api/metrics as Prometheus text, or as JSON with
+ * ?format=json.
+ */
+
+typedef struct ws_metrics_route ws_metrics_route_t;
+
+/**
+ * @brief Allocate the route table. Call once, before the server starts.
+ */
+esp_err_t WS_Metrics_Init(void);
+
+/**
+ * @brief httpd_register_uri_handler() with the handler timed and counted.
+ *        The handler sees its own user_ctx as usual.
+ */
+esp_err_t WS_Metrics_RegisterUri(httpd_handle_t server, const httpd_uri_t* uri);
+
+/**
+ * For wrappers that finish a request elsewhere (WS_Async): claim a route
+ * entry once at registration, then bracket each request with Begin/End.
+ * Begin must run on the server task; End may run on any task.
+ */
+ws_metrics_route_t* WS_Metrics_AddRoute(const char* uri, httpd_method_t method);
+int64_t WS_Metrics_Begin(httpd_req_t* req);
+void WS_Metrics_End(ws_metrics_route_t* route, httpd_req_t* req, int64_t start_us);
+
+/**
+ * @brief Register GET /api/metrics.
+ */
+esp_err_t WS_Metrics_RegisterEndpoints(httpd_handle_t server);
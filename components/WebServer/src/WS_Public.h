@@ -1,6 +1,9 @@
 #include "WiFi_Manager_API.h"
 #include "Scheduler_API.h"
 
+/* mDNS host name; the device answers at http://ringy.local */
+#define WS_MDNS_HOSTNAME    "ringy"
+
 typedef struct  _WEB_SERVER_PARAMS_T
 {
     WIFI_MANAGER_H       hWiFiManager;           /* WiFi manager handle */
@@ -0,0 +1,250 @@
+#include "WS_RateLimit.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "Auth/WS_Auth.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char* TAG = "WS_RATE";
+
+#define RATE_ADDR_LEN   16          // IPv6, or IPv4 mapped to ::ffff:a.b.c.d
+#define RATE_MILLI      1000u       // tokens are kept in thousandths
+#define RATE_US_PER_MIN 60000000ull
+
+typedef struct
+{
+    bool     used;
+    uint8_t  addr[RATE_ADDR_LEN];
+    uint8_t  limited;                       // bit per class, to log once per episode
+    int64_t  seen_us;                       // for eviction
+    uint32_t tokens[WS_RATE_CLASSES];       // thousandths of a token
+    int64_t  refill_us[WS_RATE_CLASSES];    // time the tokens were last topped up to
+} ws_rate_client_t;
+
+typedef struct
+{
+    uint32_t burst;
+    uint32_t per_min;
+} ws_rate_budget_t;
+
+static const ws_rate_budget_t s_budget[WS_RATE_CLASSES] = {
+    [WS_RATE_LOGIN] = { CONFIG_WS_RATE_LOGIN_BURST, CONFIG_WS_RATE_LOGIN_PER_MIN },
+    [WS_RATE_WRITE] = { CONFIG_WS_RATE_WRITE_BURST, CONFIG_WS_RATE_WRITE_PER_MIN },
+    [WS_RATE_HEAVY] = { CONFIG_WS_RATE_HEAVY_BURST, CONFIG_WS_RATE_HEAVY_PER_MIN },
+};
+
+static const char* const s_class_name[WS_RATE_CLASSES] = {
+    [WS_RATE_LOGIN] = "login",
+    [WS_RATE_WRITE] = "write",
+    [WS_RATE_HEAVY] = "heavy",
+};
+
+// GETs that print the whole schedule, walk flash or block on the radio
+static const char* const s_heavy_uris[] = {
+    "/api/schedule/all",
+    "/api/bell/history",
+    "/api/system/storage",
+    "/api/wifi/networks",
+    "/api/logs",
+    "/api/metrics",
+};
+
+static ws_rate_client_t s_clients[CONFIG_WS_RATE_CLIENTS];
+static uint32_t         s_evicted = 0;
+static uint32_t         s_allowed[WS_RATE_CLASSES];
+static uint32_t         s_limited[WS_RATE_CLASSES];
+static portMUX_TYPE     s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ----------------------------------------------------------------
+// Client table
+// ----------------------------------------------------------------
+static bool peer_addr(httpd_req_t* req, uint8_t out[RATE_ADDR_LEN])
+{
+    int fd = httpd_req_to_sockfd(req);
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    if ((fd < 0) || (0 != getpeername(fd, (struct sockaddr*)&ss, &len))) {
+        return false;
+    }
+
+    memset(out, 0, RATE_ADDR_LEN);
+    if (AF_INET6 == ss.ss_family) {
+        memcpy(out, &((struct sockaddr_in6*)&ss)->sin6_addr, RATE_ADDR_LEN);
+    } else if (AF_INET == ss.ss_family) {
+        out[10] = 0xff;
+        out[11] = 0xff;
+        memcpy(&out[12], &((struct sockaddr_in*)&ss)->sin_addr, 4);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void addr_str(const uint8_t addr[RATE_ADDR_LEN], char* buf, size_t len)
+{
+    static const uint8_t v4_prefix[12] = { 0,0,0,0, 0,0,0,0, 0,0,0xff,0xff };
+    if (0 == memcmp(addr, v4_prefix, sizeof(v4_prefix))) {
+        snprintf(buf, len, "%u.%u.%u.%u", addr[12], addr[13], addr[14], addr[15]);
+    } else if (NULL == inet_ntop(AF_INET6, addr, buf, len)) {
+        snprintf(buf, len, "?");
+    }
+}
+
+// Caller holds s_lock. Never fails: the least recently seen client makes room
+static ws_rate_client_t* client_get(const uint8_t addr[RATE_ADDR_LEN], int64_t now)
+{
+    ws_rate_client_t* victim = NULL;
+    for (int i = 0; i < CONFIG_WS_RATE_CLIENTS; i++) {
+        ws_rate_client_t* c = &s_clients[i];
+        if (!c->used) {
+            if ((NULL == victim) || victim->used) victim = c;
+            continue;
+        }
+        if (0 == memcmp(c->addr, addr, RATE_ADDR_LEN)) {
+            c->seen_us = now;
+            return c;
+        }
+        if ((NULL == victim) || (victim->used && (c->seen_us < victim->seen_us))) {
+            victim = c;
+        }
+    }
+
+    if (victim->used) s_evicted++;
+    memset(victim, 0, sizeof(*victim));
+    victim->used    = true;
+    victim->seen_us = now;
+    memcpy(victim->addr, addr, RATE_ADDR_LEN);
+    for (int k = 0; k < WS_RATE_CLASSES; k++) {
+        victim->tokens[k]    = s_budget[k].burst * RATE_MILLI;
+        victim->refill_us[k] = now;
+    }
+    return victim;
+}
+
+// Caller holds s_lock. Whole thousandths only; the remainder stays in refill_us
+static void refill(ws_rate_client_t* c, ws_rate_class_t cls, int64_t now)
+{
+    const ws_rate_budget_t* b = &s_budget[cls];
+    uint32_t cap = b->burst * RATE_MILLI;
+    uint64_t add = (uint64_t)(now - c->refill_us[cls]) * b->per_min * RATE_MILLI / RATE_US_PER_MIN;
+
+    if ((uint64_t)c->tokens[cls] + add >= cap) {
+        c->tokens[cls]    = cap;
+        c->refill_us[cls] = now;
+    } else if (add > 0) {
+        c->tokens[cls]    += (uint32_t)add;
+        c->refill_us[cls] += (int64_t)(add * RATE_US_PER_MIN / ((uint64_t)b->per_min * RATE_MILLI));
+    }
+}
+
+// ----------------------------------------------------------------
+// Public API
+// ----------------------------------------------------------------
+ws_rate_class_t WS_RateLimit_ClassOf(const char* uri, httpd_method_t method)
+{
+    switch (method) {
+        case HTTP_POST:
+            return (0 == strcmp(uri, "/api/login")) ? WS_RATE_LOGIN : WS_RATE_WRITE;
+        case HTTP_PUT:
+        case HTTP_PATCH:
+        case HTTP_DELETE:
+            return WS_RATE_WRITE;
+        case HTTP_GET:
+            for (size_t i = 0; i < sizeof(s_heavy_uris) / sizeof(s_heavy_uris[0]); i++) {
+                if (0 == strcmp(uri, s_heavy_uris[i])) return WS_RATE_HEAVY;
+            }
+            return WS_RATE_NONE;
+        default:
+            return WS_RATE_NONE;
+    }
+}
+
+bool WS_RateLimit_Admit(httpd_req_t* req, ws_rate_class_t cls)
+{
+    if ((cls <= WS_RATE_NONE) || (cls >= WS_RATE_CLASSES)) {
+        return true;
+    }
+
+    // Without a peer address there is nothing to key on; let it through
+    uint8_t addr[RATE_ADDR_LEN];
+    if (!peer_addr(req, addr)) {
+        return true;
+    }
+
+    int64_t  now = esp_timer_get_time();
+    uint32_t retry_s = 0;
+    bool     first = false;
+
+    taskENTER_CRITICAL(&s_lock);
+    ws_rate_client_t* c = client_get(addr, now);
+    refill(c, cls, now);
+    if (c->tokens[cls] >= RATE_MILLI) {
+        c->tokens[cls] -= RATE_MILLI;
+        c->limited &= (uint8_t)~(1u << cls);
+        s_allowed[cls]++;
+    } else {
+        uint64_t wait_us = (uint64_t)(RATE_MILLI - c->tokens[cls]) * RATE_US_PER_MIN
+                         / ((uint64_t)s_budget[cls].per_min * RATE_MILLI);
+        retry_s = (uint32_t)((wait_us + 999999) / 1000000);
+        if (0 == retry_s) retry_s = 1;
+        first = (0 == (c->limited & (1u << cls)));
+        c->limited |= (uint8_t)(1u << cls);
+        s_limited[cls]++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (0 == retry_s) {
+        return true;
+    }
+
+    if (first) {
+        char who[INET6_ADDRSTRLEN];
+        addr_str(addr, who, sizeof(who));
+        ESP_LOGW(TAG, "%s over its %s budget (%s %s)", who, s_class_name[cls],
+                 http_method_str((enum http_method)req->method), req->uri);
+    }
+
+    // Body is left unread, so the connection cannot be reused
+    char retry_hdr[12];
+    char body[80];
+    snprintf(retry_hdr, sizeof(retry_hdr), "%lu", (unsigned long)retry_s);
+    snprintf(body, sizeof(body), "{\"error\":\"Too many requests\",\"retryAfter\":%lu}", (unsigned long)retry_s);
+    auth_set_security_headers(req);
+    httpd_resp_set_status(req, "429 Too Many Requests");
+    httpd_resp_set_hdr(req, "Retry-After", retry_hdr);
+    httpd_resp_set_hdr(req, "Connection", "close");
+    httpd_resp_sendstr(req, body);
+    return false;
+}
+
+const char* WS_RateLimit_ClassName(ws_rate_class_t cls)
+{
+    return ((cls > WS_RATE_NONE) && (cls < WS_RATE_CLASSES)) ? s_class_name[cls] : "none";
+}
+
+void WS_RateLimit_GetStats(ws_rate_stats_t* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = CONFIG_WS_RATE_CLIENTS;
+
+    taskENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < CONFIG_WS_RATE_CLIENTS; i++) {
+        if (s_clients[i].used) stats->clients++;
+    }
+    stats->evicted = s_evicted;
+    for (int k = 0; k < WS_RATE_CLASSES; k++) {
+        stats->classes[k].burst   = s_budget[k].burst;
+        stats->classes[k].per_min = s_budget[k].per_min;
+        stats->classes[k].allowed = s_allowed[k];
+        stats->classes[k].limited = s_limited[k];
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Per-client request budgets.
+ *
+ * Each source address gets a token bucket per class in a fixed table of
+ * CONFIG_WS_RATE_CLIENTS entries; when the table is full the client seen
+ * least recently is dropped and the newcomer starts with full buckets.
+ * A request that finds its bucket empty is answered 429 with Retry-After
+ * and the connection is closed, because its body was not read.
+ *
+ * WS_Metrics and WS_Async check every route they wrap, so the 429s show up
+ * in /api/metrics. The class is fixed when the route is registered:
+ *
+ *   LOGIN   POST /api/login
+ *   WRITE   every other POST, PUT, PATCH and DELETE
+ *   HEAVY   GETs that build large responses or scan (see WS_RateLimit.c)
+ *   NONE    everything else: static files, status polls, SSE
+ */
+
+typedef enum
+{
+    WS_RATE_NONE = -1,
+    WS_RATE_LOGIN = 0,
+    WS_RATE_WRITE,
+    WS_RATE_HEAVY,
+    WS_RATE_CLASSES
+} ws_rate_class_t;
+
+typedef struct
+{
+    uint32_t burst;             // bucket size
+    uint32_t per_min;           // refill
+    uint32_t allowed;           // since boot
+    uint32_t limited;           // answered 429
+} ws_rate_class_stats_t;
+
+typedef struct
+{
+    uint32_t clients;           // addresses tracked now
+    uint32_t capacity;
+    uint32_t evicted;           // dropped to make room
+    ws_rate_class_stats_t classes[WS_RATE_CLASSES];
+} ws_rate_stats_t;
+
+/**
+ * @brief Budget a route draws from, decided once at registration.
+ */
+ws_rate_class_t WS_RateLimit_ClassOf(const char* uri, httpd_method_t method);
+
+/**
+ * @brief Take one token for the request's client. Run on the server task.
+ * @return true to go on; false when the 429 has been sent and the handler
+ *         should return ESP_FAIL to close the connection.
+ */
+bool WS_RateLimit_Admit(httpd_req_t* req, ws_rate_class_t cls);
+
+const char* WS_RateLimit_ClassName(ws_rate_class_t cls);
+
+void WS_RateLimit_GetStats(ws_rate_stats_t* stats);
@@ -0,0 +1,119 @@
+#include "WS_Upload.h"
+
+#include <string.h>
+
+#include "Auth/WS_Auth.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#define WS_UPLOAD_TIMEOUT_US ((int64_t)CONFIG_WS_BODY_READ_TIMEOUT_SEC * 1000000)
+
+esp_err_t WS_Upload_CheckAccess(httpd_req_t* req, const char* content_type, const char* type_error,
+                                const char** status, const char** error)
+{
+    auth_set_security_headers(req);
+
+    char value[64] = {0};
+    if ((httpd_req_get_hdr_value_str(req, "X-Requested-With", value, sizeof(value)) != ESP_OK)
+        || (strcmp(value, "XMLHttpRequest") != 0)) {
+        *status = "403 Forbidden";
+        *error  = "Missing X-Requested-With header";
+        return ESP_FAIL;
+    }
+
+    if ((httpd_req_get_hdr_value_str(req, "Content-Type", value, sizeof(value)) != ESP_OK)
+        || (strncmp(value, content_type, strlen(content_type)) != 0)) {
+        *status = "415 Unsupported Media Type";
+        *error  = type_error;
+        return ESP_FAIL;
+    }
+
+    if (auth_require_role(req, "service", NULL, NULL) != ESP_OK) {
+        *status = NULL;     // 401/403 already sent
+        *error  = "Not authorized";
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static int hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+esp_err_t WS_Upload_GetDigest(httpd_req_t* req, uint8_t digest[WS_UPLOAD_DIGEST_LEN])
+{
+    char hex[2 * WS_UPLOAD_DIGEST_LEN + 8];
+    if ((httpd_req_get_hdr_value_str(req, WS_UPLOAD_DIGEST_HEADER, hex, sizeof(hex)) != ESP_OK)
+        || (strlen(hex) != 2 * WS_UPLOAD_DIGEST_LEN)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < WS_UPLOAD_DIGEST_LEN; i++) {
+        int hi = hex_nibble(hex[2 * i]);
+        int lo = hex_nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return ESP_ERR_INVALID_ARG;
+        digest[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return ESP_OK;
+}
+
+esp_err_t WS_Upload_Receive(httpd_req_t* req, size_t chunk_size, bool keep_partial,
+                            ws_upload_sink_t sink, void* ctx, size_t* out_received,
+                            const char** status, const char** error)
+{
+    if (out_received) *out_received = 0;
+
+    uint8_t* chunk = (uint8_t*)heap_caps_malloc(chunk_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (NULL == chunk) {
+        *status = "500 Internal Server Error";
+        *error  = "Out of memory";
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t    left = req->content_len;
+    esp_err_t err  = ESP_OK;
+    while (ESP_OK == err && left > 0) {
+        size_t  want     = (left < chunk_size) ? left : chunk_size;
+        size_t  got      = 0;
+        int64_t deadline = esp_timer_get_time() + WS_UPLOAD_TIMEOUT_US;
+
+        while (ESP_OK == err && got < want) {
+            int r = httpd_req_recv(req, (char*)chunk + got, want - got);
+            if (HTTPD_SOCK_ERR_TIMEOUT == r && esp_timer_get_time() < deadline) {
+                continue;
+            }
+            if (r > 0) {
+                got += (size_t)r;
+                continue;
+            }
+            if (HTTPD_SOCK_ERR_TIMEOUT == r) {
+                err     = ESP_ERR_TIMEOUT;
+                *status = "408 Request Timeout";
+                *error  = "Body not received in time";
+            } else {
+                err     = ESP_FAIL;
+                *status = NULL;
+                *error  = "Client closed the connection";
+            }
+        }
+
+        if (ESP_OK != err && !(keep_partial && got > 0)) {
+            break;
+        }
+
+        if (out_received) *out_received += got;
+        left -= got;
+
+        if (ESP_OK != sink(ctx, chunk, got)) {
+            err = ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    heap_caps_free(chunk);
+    return err;
+}
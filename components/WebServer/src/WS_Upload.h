@@ -0,0 +1,67 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Streamed upload bodies shared by the service-role upload routes
+ * (firmware image, web UI bundle).
+ *
+ * These bodies are too large for WS_Body_Read(), so they are received a
+ * chunk at a time and handed to the route's sink, which writes each one
+ * to flash before the next is read. The receive deadline of
+ * CONFIG_WS_BODY_READ_TIMEOUT_SEC restarts per chunk.
+ *
+ * On failure the helpers return the status line and message for the
+ * reply; the route sends it in its own error format. A NULL status means
+ * nothing is to be sent: the client is gone, or a 401/403 already was.
+ */
+
+#define WS_UPLOAD_DIGEST_HEADER "X-Content-SHA256"
+#define WS_UPLOAD_DIGEST_LEN    32
+
+/**
+ * @brief Receives each chunk in order. Every call but the last gets
+ *        exactly chunk_size bytes.
+ * @return ESP_OK to go on; anything else stops the upload, and the sink
+ *         keeps its own reason for the reply.
+ */
+typedef esp_err_t (*ws_upload_sink_t)(void* ctx, const uint8_t* data, size_t len);
+
+/**
+ * @brief Service role for an upload. auth_csrf_check() insists on JSON,
+ *        so the X-Requested-With header alone forces the cross-site
+ *        preflight here. Also sets the security headers.
+ * @param content_type  Content-Type the route accepts (prefix match).
+ * @param type_error    Message for the 415 reply.
+ * @return ESP_OK, or ESP_FAIL with *status / *error set.
+ */
+esp_err_t WS_Upload_CheckAccess(httpd_req_t* req, const char* content_type, const char* type_error,
+                                const char** status, const char** error);
+
+/**
+ * @brief Parse the WS_UPLOAD_DIGEST_HEADER header: SHA-256 of the whole
+ *        body as 64 hex digits.
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG if it is missing or malformed.
+ */
+esp_err_t WS_Upload_GetDigest(httpd_req_t* req, uint8_t digest[WS_UPLOAD_DIGEST_LEN]);
+
+/**
+ * @brief Receive the whole body into sink, chunk_size bytes at a time.
+ *        The chunk buffer is in internal RAM: it is the source of flash
+ *        writes.
+ * @param keep_partial  Also pass a short chunk to the sink when the
+ *                      receive fails part-way (resumable uploads).
+ * @param out_received  Bytes received, may be NULL. The body has been
+ *                      read to the end when it equals content_len.
+ * @return ESP_OK, ESP_ERR_INVALID_RESPONSE when the sink stopped the
+ *         upload (the sink has the reason), or ESP_ERR_NO_MEM,
+ *         ESP_ERR_TIMEOUT or ESP_FAIL (client gone) with *status /
+ *         *error set.
+ */
+esp_err_t WS_Upload_Receive(httpd_req_t* req, size_t chunk_size, bool keep_partial,
+                            ws_upload_sink_t sink, void* ctx, size_t* out_received,
+                            const char** status, const char** error);
@@ -3,7 +3,7 @@
 #include "WiFi_Manager_API.h"
 #include "WiFI_Manager_Public.h"
 #include "AppErrors.h"
-#include "NVS_API.h"
+#include "NVS_Config.h"
 
 #define WIFI_MANAGER_DEFAULT_SSID              "ESP32_Setup"
 #define WIFI_MANAGER_DEFAULT_PASS              "12345678"
@@ -155,18 +155,12 @@ esp_err_t
 WiFi_Manager_SaveCredentials(const char* ssid, const char* pass, const uint8_t* pucBssid)
 {
     esp_err_t espErr = ESP_OK;
-    nvs_handle_t hNvs = 0;
 
-    espErr = NVS_Open(WIFI_MANAGER_NVS_NAMESPACE, NVS_READWRITE, &hNvs);
+    espErr = NVS_Config_SetStr(WIFI_MANAGER_NVS_NAMESPACE, WIFI_MANAGER_NVS_KEY_SSID, ssid);
 
     if(ESP_OK == espErr)
     {
-        espErr = NVS_WriteString(hNvs, WIFI_MANAGER_NVS_KEY_SSID, ssid);
-    }
-
-    if(ESP_OK == espErr)
-    {
-        espErr = NVS_WriteString(hNvs, WIFI_MANAGER_NVS_KEY_PASS, pass);
+        espErr = NVS_Config_SetStr(WIFI_MANAGER_NVS_NAMESPACE, WIFI_MANAGER_NVS_KEY_PASS, pass);
     }
 
     if(ESP_OK == espErr)
@@ -174,17 +168,14 @@ WiFi_Manager_SaveCredentials(const char* ssid, const char* pass, const uint8_t*
         /* Store BSSID as 6-byte blob; all-zeros if not provided */
         uint8_t abZeroBssid[WIFI_MANAGER_BSSID_LENGTH] = {0};
         const uint8_t* pucData = (pucBssid != NULL) ? pucBssid : abZeroBssid;
-        espErr = NVS_Write(hNvs, WIFI_MANAGER_NVS_KEY_BSSID, pucData, WIFI_MANAGER_BSSID_LENGTH);
+        espErr = NVS_Config_SetBlob(WIFI_MANAGER_NVS_NAMESPACE, WIFI_MANAGER_NVS_KEY_BSSID,
+                                    pucData, WIFI_MANAGER_BSSID_LENGTH);
     }
 
+    /* Callers reboot right after saving: commit all three keys now */
     if(ESP_OK == espErr)
     {
-        espErr = NVS_Commit(hNvs);
-    }
-
-    if(ESP_OK == espErr)
-    {
-        espErr = NVS_Close(hNvs);
+        espErr = NVS_Config_Flush();
     }
     
     return espErr;
@@ -193,28 +184,7 @@ WiFi_Manager_SaveCredentials(const char* ssid, const char* pass, const uint8_t*
 esp_err_t
 WiFi_Manager_ClearCredentials(void)
 {
-    esp_err_t espErr = ESP_OK;
-    nvs_handle_t hNvs = 0;
-    bool fIsOpen = false;
-
-    espErr = NVS_Open(WIFI_MANAGER_NVS_NAMESPACE, NVS_READWRITE, &hNvs);
-    if(ESP_OK == espErr)
-    {
-        fIsOpen = true;
-        espErr = nvs_erase_all(hNvs);
-    }
-
-    if(ESP_OK == espErr)
-    {
-        espErr = NVS_Commit(hNvs);
-    }
-    
-    if(fIsOpen)
-    {
-        espErr = NVS_Close(hNvs);
-    }
-
-    return espErr;
+    return NVS_Config_EraseNamespace(WIFI_MANAGER_NVS_NAMESPACE);
 }
     
 int32_t
@@ -222,29 +192,28 @@ wiFi_Manager_InitCredentials(WIFI_MANAGER_RSC_T* ptRsc)
 {    
     int32_t lResult = APP_SUCCESS;
     esp_err_t espErr = ESP_OK;
-    nvs_handle_t hNvs = 0;
     size_t szSsidLen = sizeof(ptRsc->abSsid);
     size_t szPassLen = sizeof(ptRsc->abPass);
     size_t szBssidLen = WIFI_MANAGER_BSSID_LENGTH;
 
     assert(NULL != ptRsc);
 
-    espErr = NVS_Open(WIFI_MANAGER_NVS_NAMESPACE, NVS_READWRITE, &hNvs);
+    espErr = NVS_Config_GetStr(WIFI_MANAGER_NVS_NAMESPACE, WIFI_MANAGER_NVS_KEY_SSID,
+                               (char*)ptRsc->abSsid, szSsidLen);
 
-    if(ESP_OK == espErr)
+    if((ESP_OK == espErr) || (ESP_ERR_NVS_NOT_FOUND == espErr))
     {
-        espErr = NVS_ReadString(hNvs, WIFI_MANAGER_NVS_KEY_SSID, (char*)ptRsc->abSsid, &szSsidLen);
-
         if (ESP_OK == espErr)
         {
-            espErr = NVS_ReadString(hNvs, WIFI_MANAGER_NVS_KEY_PASS, (char*)ptRsc->abPass, &szPassLen);
+            espErr = NVS_Config_GetStr(WIFI_MANAGER_NVS_NAMESPACE, WIFI_MANAGER_NVS_KEY_PASS,
+                                       (char*)ptRsc->abPass, szPassLen);
         }
 
         if (ESP_OK == espErr)
         {
             /* BSSID is optional — missing key (legacy devices) means no BSSID pinning */
-            esp_err_t bssidErr = NVS_Read(hNvs, WIFI_MANAGER_NVS_KEY_BSSID,
-                                          ptRsc->abBssid, &szBssidLen);
+            esp_err_t bssidErr = NVS_Config_GetBlob(WIFI_MANAGER_NVS_NAMESPACE, WIFI_MANAGER_NVS_KEY_BSSID,
+                                                    ptRsc->abBssid, &szBssidLen);
             if (ESP_OK != bssidErr)
             {
                 memset(ptRsc->abBssid, 0, WIFI_MANAGER_BSSID_LENGTH);
@@ -258,12 +227,10 @@ wiFi_Manager_InitCredentials(WIFI_MANAGER_RSC_T* ptRsc)
             strncpy((char*)ptRsc->abPass, WIFI_MANAGER_DEFAULT_PASS, sizeof(WIFI_MANAGER_DEFAULT_PASS));
             lResult = APP_SUCCESS;
         }
-
-        (void)NVS_Close(hNvs);
     }
     else
     {
-        // TODO: It should not happen, but if NVS open fails, use default values
+        // TODO: It should not happen, but if NVS read fails, use default values
         // Add diagnosis  / critical error handling as needed      
     }
 
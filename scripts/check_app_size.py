@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+Fails the build when the app image no longer fits an OTA slot.
+
+The firmware is updated over the air into the spare ota_0/ota_1 slot of
+partitions.csv, so the image has to fit the smallest app partition there.
+A warning is printed once less than --warn-percent of the slot is left.
+
+Called by the top-level CMakeLists.txt after the .bin is generated; can
+also be run by hand:
+    python scripts/check_app_size.py --bin build/esp32_school_bell.bin --partitions partitions.csv
+"""
+
+import argparse
+import os
+import sys
+
+
+def parse_size(text):
+    """Partition table sizes: decimal or 0x hex, optional K or M suffix."""
+    text = text.strip().upper()
+    scale = 1
+    if text.endswith("K"):
+        scale, text = 1024, text[:-1]
+    elif text.endswith("M"):
+        scale, text = 1024 * 1024, text[:-1]
+    return int(text, 0) * scale
+
+
+def app_slots(path):
+    """(name, size) of every app partition in the CSV."""
+    slots = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            fields = [x.strip() for x in line.split(",")]
+            if len(fields) >= 5 and fields[1] == "app":
+                slots.append((fields[0], parse_size(fields[4])))
+    return slots
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--bin", required=True, help="app image (.bin)")
+    parser.add_argument("--partitions", required=True, help="partition table CSV")
+    parser.add_argument("--warn-percent", type=int, default=10,
+                        help="warn when less than this much of the slot is free (default 10)")
+    args = parser.parse_args()
+
+    slots = app_slots(args.partitions)
+    if not slots:
+        print(f"error: no app partition in {args.partitions}", file=sys.stderr)
+        return 1
+
+    name, slot = min(slots, key=lambda s: s[1])
+    size = os.path.getsize(args.bin)
+    free = slot - size
+
+    if free < 0:
+        print(f"error: {os.path.basename(args.bin)} is {size} bytes, {-free} over the "
+              f"{slot} byte {name} slot; it could not be installed over the air", file=sys.stderr)
+        return 1
+
+    print(f"app size: {size} of {slot} bytes in {name} ({free * 100 // slot}% free)")
+    if free * 100 < slot * args.warn_percent:
+        print(f"warning: less than {args.warn_percent}% of the OTA slot is left", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
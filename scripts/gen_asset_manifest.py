@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+Stages the data/ directory for the fatfs-react image, adds precompressed
+variants, and writes asset-manifest.json next to the files.
+
+Every logical file is stored once per content coding:
+    identity   only if data/ has the plain file (it may be read by firmware,
+               e.g. default_schedule.json)
+    gzip       <name>.gz, kept from data/ or produced with gzip -9
+    br         <name>.br, produced when the 'brotli' module is installed
+
+A compressed variant is only kept if it is at least 5% smaller than the
+plain file. The server picks the smallest variant the client accepts and
+inflates gzip on the fly for the rare client that accepts neither.
+
+Manifest (version 2), one entry per logical file:
+    path       URI the browser requests
+    mime       Content-Type the server should send
+    immutable  true for content-hashed bundles (Vite assets/name-<hash>.ext)
+    variants   list of { encoding, file, size, hash }, where file is
+               relative to /react and hash is the first 16 hex digits of the
+               SHA-256 of the stored bytes (used as the ETag)
+
+Called by data/CMakeLists.txt; can also be run by hand:
+    python scripts/gen_asset_manifest.py --src data --out build/fatfs_stage
+"""
+
+import argparse
+import gzip
+import hashlib
+import io
+import json
+import os
+import re
+import shutil
+import sys
+
+try:
+    import brotli
+except ImportError:
+    brotli = None
+
+MANIFEST_NAME = "asset-manifest.json"
+MANIFEST_VERSION = 2
+HASH_HEX_DIGITS = 16
+MIN_SAVING = 0.05
+
+# Build inputs that must not end up in the image
+SKIP_FILES = {"CMakeLists.txt", MANIFEST_NAME}
+
+# Same table as WS_React_FileServer_GetMime()
+MIME_TYPES = {
+    ".html": "text/html",
+    ".js":   "application/javascript",
+    ".css":  "text/css",
+    ".json": "application/json",
+    ".svg":  "image/svg+xml",
+    ".png":  "image/png",
+    ".jpg":  "image/jpeg",
+    ".jpeg": "image/jpeg",
+    ".ico":  "image/x-icon",
+    ".wasm": "application/wasm",
+}
+
+# Vite emits assets/<name>-<8+ char base64url hash>.<ext>
+HASHED_ASSET_RE = re.compile(r"^assets/.+-[A-Za-z0-9_-]{8,}\.[A-Za-z0-9]+$")
+
+SUFFIX = {"gzip": ".gz", "br": ".br", "identity": ""}
+
+
+def sha256_prefix(data):
+    return hashlib.sha256(data).hexdigest()[:HASH_HEX_DIGITS]
+
+
+def gzip_bytes(raw):
+    # mtime=0 keeps the output (and so the ETag) stable across builds
+    buf = io.BytesIO()
+    with gzip.GzipFile(fileobj=buf, mode="wb", compresslevel=9, mtime=0) as f:
+        f.write(raw)
+    return buf.getvalue()
+
+
+def collect(src):
+    """Map logical relative path -> {'identity': bytes?, 'gzip': bytes?} from data/."""
+    files = {}
+    for root, dirs, names in os.walk(src):
+        dirs.sort()
+        rel_root = os.path.relpath(root, src)
+        for name in sorted(names):
+            if rel_root == "." and name in SKIP_FILES:
+                continue
+            rel = name if rel_root == "." else os.path.join(rel_root, name)
+            rel = rel.replace(os.sep, "/")
+            with open(os.path.join(root, name), "rb") as f:
+                data = f.read()
+            if rel.endswith(".gz"):
+                files.setdefault(rel[:-3], {})["gzip"] = data
+            else:
+                files.setdefault(rel, {})["identity"] = data
+    return files
+
+
+def variants_for(sources):
+    """Return {encoding: bytes} to store for one logical file."""
+    raw = sources.get("identity")
+    if raw is None:
+        raw = gzip.decompress(sources["gzip"])
+
+    out = {}
+    if "identity" in sources:
+        out["identity"] = raw
+
+    def worth_it(data):
+        return len(data) <= len(raw) * (1.0 - MIN_SAVING)
+
+    gz = sources.get("gzip") or gzip_bytes(raw)
+    if "gzip" in sources or worth_it(gz):
+        out["gzip"] = gz
+
+    if brotli is not None:
+        br = brotli.compress(raw, quality=11)
+        if worth_it(br) and ("gzip" not in out or len(br) < len(out["gzip"])):
+            out["br"] = br
+
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stage web assets and write the asset manifest")
+    parser.add_argument("--src", required=True, help="data/ directory")
+    parser.add_argument("--out", required=True, help="staging directory for the FatFS image")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.src):
+        print(f"error: {args.src} is not a directory", file=sys.stderr)
+        return 1
+
+    if brotli is None:
+        print("asset manifest: 'brotli' module not installed, skipping .br variants "
+              "(pip install brotli)", file=sys.stderr)
+
+    if os.path.isdir(args.out):
+        shutil.rmtree(args.out)
+    os.makedirs(args.out)
+
+    entries = []
+    stored = 0
+    for logical, sources in sorted(collect(args.src).items()):
+        variants = []
+        for encoding, data in sorted(variants_for(sources).items()):
+            rel = logical + SUFFIX[encoding]
+            dst = os.path.join(args.out, rel)
+            os.makedirs(os.path.dirname(dst), exist_ok=True)
+            with open(dst, "wb") as f:
+                f.write(data)
+            stored += len(data)
+            variants.append({
+                "encoding": encoding,
+                "file": rel,
+                "size": len(data),
+                "hash": sha256_prefix(data),
+            })
+
+        ext = os.path.splitext(logical)[1].lower()
+        entries.append({
+            "path": "/" + logical,
+            "mime": MIME_TYPES.get(ext, "text/plain"),
+            "immutable": bool(HASHED_ASSET_RE.match(logical)),
+            "variants": variants,
+        })
+
+    manifest = {"version": MANIFEST_VERSION, "files": entries}
+    with open(os.path.join(args.out, MANIFEST_NAME), "w", encoding="utf-8") as f:
+        json.dump(manifest, f, separators=(",", ":"))
+
+    print(f"asset manifest: {len(entries)} files, {stored} bytes stored -> {args.out}/{MANIFEST_NAME}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
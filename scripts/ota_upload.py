@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+Installs a firmware image on a running device without USB.
+
+Logs in with the service account and POSTs the app image (build/esp32_school_bell.bin)
+to /api/system/ota with its SHA-256. The device writes it to its spare OTA
+slot as it arrives and reboots into it only once the whole image is verified.
+If the connection drops, the upload continues at the offset the device
+reports instead of starting over; --chunk sends the image in several
+requests to begin with.
+
+--wait logs in again after the reboot and follows the new image through its
+health check until the device confirms it or rolls back. --abort drops an
+unfinished upload.
+
+Standard library only:
+    python scripts/ota_upload.py --host ringy.local --user admin --image build/esp32_school_bell.bin --wait
+"""
+
+import argparse
+import getpass
+import hashlib
+import http.client
+import json
+import ssl
+import sys
+import time
+
+
+def connect(args):
+    if args.https:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+        ctx.check_hostname = False
+        ctx.verify_mode = ssl.CERT_NONE     # self-signed device certificate
+        return http.client.HTTPSConnection(args.host, args.port or 443, timeout=args.timeout, context=ctx)
+    return http.client.HTTPConnection(args.host, args.port or 80, timeout=args.timeout)
+
+
+def request(conn, method, path, body=None, headers=None):
+    conn.request(method, path, body=body, headers=headers or {})
+    resp = conn.getresponse()
+    data = resp.read()
+    try:
+        payload = json.loads(data) if data else {}
+    except ValueError:
+        payload = {"error": data.decode(errors="replace")}
+    return resp, payload
+
+
+def login(conn, user, password):
+    resp, payload = request(conn, "POST", "/api/login",
+                            body=json.dumps({"username": user, "password": password}),
+                            headers={"Content-Type": "application/json",
+                                     "X-Requested-With": "XMLHttpRequest"})
+    if resp.status != 200:
+        raise RuntimeError(f"login failed: {resp.status} {payload.get('error', '')}")
+    for value in resp.headers.get_all("Set-Cookie") or []:
+        if value.startswith("session="):
+            return value.split(";", 1)[0]
+    raise RuntimeError("login answered without a session cookie")
+
+
+def get_status(args, cookie):
+    conn = connect(args)
+    try:
+        resp, payload = request(conn, "GET", "/api/system/ota",
+                                headers={"Cookie": cookie, "X-Requested-With": "XMLHttpRequest"})
+    finally:
+        conn.close()
+    if resp.status != 200:
+        raise RuntimeError(f"GET /api/system/ota: {resp.status} {payload.get('error', '')}")
+    return payload
+
+
+def resume_offset(args, cookie, size):
+    """Where an unfinished session for an image of this size stands, else 0.
+    Waits while the device still holds a transfer that lost its client."""
+    for _ in range(int(args.timeout // 2) + 1):
+        status = get_status(args, cookie)
+        if status.get("pendingVerify"):
+            raise RuntimeError("the running firmware has not passed its health check yet")
+        session = status.get("session")
+        if not session or session.get("size") != size:
+            return 0
+        if not session.get("transferring"):
+            return session.get("offset", 0)
+        time.sleep(2)
+    raise RuntimeError("another upload is still running")
+
+
+def upload(args, cookie, image, digest):
+    """POST the image from the offset the device has; returns the final payload."""
+    size = len(image)
+    offset = resume_offset(args, cookie, size)
+    if offset:
+        print(f"resuming at {offset} of {size} bytes")
+
+    failures = 0
+    while True:
+        end = size if not args.chunk else min(size, offset + args.chunk)
+        headers = {"Cookie": cookie,
+                   "X-Requested-With": "XMLHttpRequest",
+                   "Content-Type": "application/octet-stream",
+                   "X-Content-SHA256": digest,
+                   "Content-Range": f"bytes {offset}-{end - 1}/{size}"}
+        conn = connect(args)
+        try:
+            resp, payload = request(conn, "POST", "/api/system/ota", body=image[offset:end], headers=headers)
+        except (OSError, http.client.HTTPException) as exc:
+            failures += 1
+            if failures > args.retries:
+                raise RuntimeError(f"upload failed after {failures} attempts: {exc}")
+            print(f"connection lost ({exc}), retrying", file=sys.stderr)
+            time.sleep(2)
+            offset = resume_offset(args, cookie, size)
+            continue
+        finally:
+            conn.close()
+
+        if resp.status == 200 and payload.get("status") == "partial":
+            offset = payload.get("offset", end)
+            failures = 0
+            print(f"  {offset} / {size} bytes ({100 * offset // size}%)")
+            continue
+        if resp.status == 200:
+            return payload
+
+        # Stalled, or the session moved on: ask the device where it stands
+        if resp.status in (408, 409) and failures < args.retries:
+            failures += 1
+            print(f"{resp.status} {payload.get('error', '')}, checking the session", file=sys.stderr)
+            offset = resume_offset(args, cookie, size)
+            continue
+        raise RuntimeError(f"{resp.status} {payload.get('error', '')}")
+
+
+def wait_for_verdict(args, password, version, deadline):
+    """Poll the device through its reboot and health check."""
+    print("waiting for the device to come back")
+    state = None
+    while time.monotonic() < deadline:
+        time.sleep(5)
+        try:
+            conn = connect(args)
+            try:
+                cookie = login(conn, args.user, password)
+            finally:
+                conn.close()
+            status = get_status(args, cookie)
+        except (OSError, http.client.HTTPException, RuntimeError):
+            continue
+
+        running = status.get("running", {})
+        if status.get("rolledBack") or running.get("version") != version:
+            print(f"error: rolled back, running {running.get('partition')} {running.get('version')}",
+                  file=sys.stderr)
+            return 1
+        if not status.get("pendingVerify") and running.get("state") == "valid":
+            print(f"confirmed: {running.get('partition')} {running.get('version')}")
+            return 0
+        if state != running.get("state"):
+            state = running.get("state")
+            print(f"running {running.get('version')} on {running.get('partition')}, {state}, "
+                  f"health check after {status.get('healthCheckSec')} s")
+    print("error: no verdict before the timeout", file=sys.stderr)
+    return 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Upload a firmware image to the device")
+    parser.add_argument("--host", default="ringy.local", help="device host name or address")
+    parser.add_argument("--port", type=int, help="default 80, or 443 with --https")
+    parser.add_argument("--https", action="store_true", help="use the HTTPS listener")
+    parser.add_argument("--user", default="admin", help="service account")
+    parser.add_argument("--password", help="prompted for when omitted")
+    parser.add_argument("--image", help="app image, build/esp32_school_bell.bin")
+    parser.add_argument("--chunk", type=int, default=0, help="bytes per request (default: the rest of the image)")
+    parser.add_argument("--retries", type=int, default=5, help="resumes after lost connections")
+    parser.add_argument("--abort", action="store_true", help="drop an unfinished upload")
+    parser.add_argument("--wait", action="store_true", help="follow the reboot and health check")
+    parser.add_argument("--timeout", type=float, default=60.0, help="socket timeout (s)")
+    args = parser.parse_args()
+
+    if not args.abort and not args.image:
+        parser.error("--image is required unless --abort is given")
+
+    image = None
+    if not args.abort:
+        with open(args.image, "rb") as f:
+            image = f.read()
+        if not image or image[0] != 0xE9:
+            print(f"error: {args.image} is not an ESP app image", file=sys.stderr)
+            return 1
+        print(f"image: {len(image)} bytes, sha256 {hashlib.sha256(image).hexdigest()[:16]}…")
+
+    password = args.password if args.password is not None else getpass.getpass(f"{args.user} password: ")
+
+    try:
+        conn = connect(args)
+        try:
+            cookie = login(conn, args.user, password)
+            if args.abort:
+                resp, payload = request(conn, "DELETE", "/api/system/ota",
+                                        headers={"Cookie": cookie, "X-Requested-With": "XMLHttpRequest",
+                                                 "Content-Type": "application/json"})
+                if resp.status != 200:
+                    raise RuntimeError(f"{resp.status} {payload.get('error', '')}")
+                print("upload dropped")
+                return 0
+        finally:
+            conn.close()
+
+        start = time.perf_counter()
+        result = upload(args, cookie, image, hashlib.sha256(image).hexdigest())
+        elapsed = time.perf_counter() - start
+    except (OSError, http.client.HTTPException, RuntimeError) as exc:
+        print(f"error: {exc}", file=sys.stderr)
+        return 1
+
+    print(f"written to {result.get('partition')}: version {result.get('version')}, "
+          f"{result.get('bytes')} bytes in {result.get('transfers')} transfer(s)")
+    print(f"device: {result.get('throughputKBps')} KB/s, {result.get('activeMs')} ms receiving, "
+          f"{result.get('flashMs')} ms writing flash; round trip {elapsed:.1f} s")
+    print(f"heap: lowest free {result.get('heapFreeMin')} bytes, peak used {result.get('heapPeakUsed')} bytes")
+    print("device is rebooting into the new image")
+
+    if args.wait:
+        return wait_for_verdict(args, password, result.get("version"), time.monotonic() + 600)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
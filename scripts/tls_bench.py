@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""
+Times TLS handshakes against the device's HTTPS listener, full against
+resumed.
+
+Each round opens a connection, sends GET /api/health and closes. The first
+round of every pair is a full handshake (ECDHE + ECDSA signature on the
+device); the second offers the session ticket from the first. The device
+resumes when it was built with CONFIG_ESP_TLS_SERVER_SESSION_TICKETS.
+
+The certificate is self-signed, so it is not verified. TLS 1.2 is forced:
+that is what the device speaks, and Python only hands out the ticket of a
+1.2 session after the handshake.
+
+Standard library only:
+    python scripts/tls_bench.py --host ringy.local --rounds 20
+"""
+
+import argparse
+import socket
+import ssl
+import statistics
+import sys
+import time
+
+
+def one_request(ctx, host, port, session=None, timeout=10.0):
+    """Returns (handshake ms, total ms, reused, session)."""
+    start = time.perf_counter()
+    raw = socket.create_connection((host, port), timeout=timeout)
+    try:
+        tls = ctx.wrap_socket(raw, server_hostname=host, session=session)
+    except Exception:
+        raw.close()
+        raise
+    with tls:
+        handshake = time.perf_counter()
+        tls.sendall(f"GET /api/health HTTP/1.1\r\nHost: {host}\r\nConnection: close\r\n\r\n".encode())
+        while tls.recv(4096):
+            pass
+        done = time.perf_counter()
+        return ((handshake - start) * 1000.0, (done - start) * 1000.0, tls.session_reused, tls.session)
+
+
+def summary(name, values):
+    if not values:
+        return f"{name:8} no samples"
+    return (f"{name:8} n={len(values):3}  median {statistics.median(values):7.1f} ms  "
+            f"min {min(values):7.1f}  max {max(values):7.1f}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare full and resumed TLS handshakes")
+    parser.add_argument("--host", default="ringy.local", help="device host name or address")
+    parser.add_argument("--port", type=int, default=443, help="CONFIG_WS_HTTPS_PORT")
+    parser.add_argument("--rounds", type=int, default=10, help="full + resumed pairs")
+    args = parser.parse_args()
+
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    ctx.check_hostname = False
+    ctx.verify_mode = ssl.CERT_NONE
+    ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    full, resumed = [], []
+    not_resumed = 0
+    for i in range(args.rounds):
+        try:
+            hs, total, _, session = one_request(ctx, args.host, args.port)
+            full.append(hs)
+            hs2, total2, reused, _ = one_request(ctx, args.host, args.port, session=session)
+        except (OSError, ssl.SSLError) as exc:
+            print(f"error: round {i + 1}: {exc}", file=sys.stderr)
+            return 1
+        if reused:
+            resumed.append(hs2)
+        else:
+            not_resumed += 1
+            full.append(hs2)
+        print(f"round {i + 1:3}: full {hs:7.1f} ms ({total:7.1f} with request), "
+              f"{'resumed' if reused else 'full   '} {hs2:7.1f} ms ({total2:7.1f})")
+
+    print()
+    print(summary("full", full))
+    print(summary("resumed", resumed))
+    if not_resumed:
+        print(f"{not_resumed} of {args.rounds} ticket offers were refused; "
+              "check CONFIG_ESP_TLS_SERVER_SESSION_TICKETS")
+    if full and resumed:
+        print(f"resumption saves {statistics.median(full) - statistics.median(resumed):.1f} ms per handshake")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
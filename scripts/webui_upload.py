@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Installs a web UI build on a running device without reflashing.
+
+Packs a staged directory (what gen_asset_manifest.py wrote, so
+asset-manifest.json and the .gz/.br variants are included) into a ustar
+archive, logs in with the service account and POSTs the archive to
+/api/system/webui with its SHA-256. The device unpacks it into its spare
+slot and switches to it only if the digest matches and index.html is there;
+otherwise the current web UI stays.
+
+--revert switches back to the web UI flashed with the image.
+
+Standard library only:
+    python scripts/webui_upload.py --host ringy.local --user admin --dir build/fatfs_stage
+"""
+
+import argparse
+import getpass
+import hashlib
+import http.client
+import io
+import json
+import os
+import ssl
+import sys
+import tarfile
+import time
+
+
+def make_bundle(root):
+    """ustar archive of root, entries relative to it, without owner or mtime noise."""
+    buf = io.BytesIO()
+    with tarfile.open(fileobj=buf, mode="w", format=tarfile.USTAR_FORMAT) as tar:
+        for dirpath, dirnames, filenames in os.walk(root):
+            dirnames.sort()
+            for name in sorted(filenames):
+                path = os.path.join(dirpath, name)
+                arcname = os.path.relpath(path, root).replace(os.sep, "/")
+                info = tar.gettarinfo(path, arcname)
+                info.uid = info.gid = 0
+                info.uname = info.gname = ""
+                with open(path, "rb") as f:
+                    tar.addfile(info, f)
+    return buf.getvalue()
+
+
+def connect(args):
+    if args.https:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+        ctx.check_hostname = False
+        ctx.verify_mode = ssl.CERT_NONE     # self-signed device certificate
+        return http.client.HTTPSConnection(args.host, args.port or 443, timeout=args.timeout, context=ctx)
+    return http.client.HTTPConnection(args.host, args.port or 80, timeout=args.timeout)
+
+
+def request(conn, method, path, body=None, headers=None):
+    conn.request(method, path, body=body, headers=headers or {})
+    resp = conn.getresponse()
+    data = resp.read()
+    try:
+        payload = json.loads(data) if data else {}
+    except ValueError:
+        payload = {"error": data.decode(errors="replace")}
+    return resp, payload
+
+
+def login(conn, user, password):
+    resp, payload = request(conn, "POST", "/api/login",
+                            body=json.dumps({"username": user, "password": password}),
+                            headers={"Content-Type": "application/json",
+                                     "X-Requested-With": "XMLHttpRequest"})
+    if resp.status != 200:
+        raise RuntimeError(f"login failed: {resp.status} {payload.get('error', '')}")
+    for value in resp.headers.get_all("Set-Cookie") or []:
+        if value.startswith("session="):
+            return value.split(";", 1)[0]
+    raise RuntimeError("login answered without a session cookie")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Upload a web UI build to the device")
+    parser.add_argument("--host", default="ringy.local", help="device host name or address")
+    parser.add_argument("--port", type=int, help="default 80, or 443 with --https")
+    parser.add_argument("--https", action="store_true", help="use the HTTPS listener")
+    parser.add_argument("--user", default="admin", help="service account")
+    parser.add_argument("--password", help="prompted for when omitted")
+    parser.add_argument("--dir", help="staged web UI (gen_asset_manifest.py --out)")
+    parser.add_argument("--revert", action="store_true", help="switch back to the factory web UI")
+    parser.add_argument("--timeout", type=float, default=60.0, help="socket timeout (s)")
+    args = parser.parse_args()
+
+    if not args.revert and not args.dir:
+        parser.error("--dir is required unless --revert is given")
+
+    bundle = None
+    if not args.revert:
+        if not os.path.isfile(os.path.join(args.dir, "index.html")):
+            print(f"error: {args.dir} has no index.html", file=sys.stderr)
+            return 1
+        bundle = make_bundle(args.dir)
+        print(f"bundle: {len(bundle)} bytes, sha256 {hashlib.sha256(bundle).hexdigest()[:16]}…")
+
+    password = args.password if args.password is not None else getpass.getpass(f"{args.user} password: ")
+
+    conn = connect(args)
+    try:
+        cookie = login(conn, args.user, password)
+        headers = {"Cookie": cookie, "X-Requested-With": "XMLHttpRequest"}
+
+        start = time.perf_counter()
+        if args.revert:
+            headers["Content-Type"] = "application/json"
+            resp, payload = request(conn, "DELETE", "/api/system/webui", headers=headers)
+        else:
+            headers["Content-Type"] = "application/x-tar"
+            headers["X-Content-SHA256"] = hashlib.sha256(bundle).hexdigest()
+            resp, payload = request(conn, "POST", "/api/system/webui", body=bundle, headers=headers)
+        elapsed = time.perf_counter() - start
+    except (OSError, http.client.HTTPException, RuntimeError) as exc:
+        print(f"error: {exc}", file=sys.stderr)
+        return 1
+    finally:
+        conn.close()
+
+    if resp.status != 200:
+        retry = resp.headers.get("Retry-After")
+        print(f"error: {resp.status} {payload.get('error', '')}"
+              + (f" (retry after {retry} s)" if retry else ""), file=sys.stderr)
+        return 1
+
+    if args.revert:
+        print(f"serving the factory web UI from {payload.get('root')}")
+    else:
+        print(f"serving {payload.get('files')} files from {payload.get('root')} "
+              f"(device {payload.get('ms')} ms, round trip {elapsed:.1f} s)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,11 @@
+#pragma once
+
+// Host stand-in: log lines are type-checked and dropped
+#include <inttypes.h>
+
+void fake_log(const char* pcTag, const char* pcFmt, ...) __attribute__((format(printf, 2, 3)));
+
+#define ESP_LOGE(tag, fmt, ...)  fake_log(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)  fake_log(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...)  fake_log(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)  fake_log(tag, fmt, ##__VA_ARGS__)
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stddef.h>
+
+// Host stand-in: rand()-based, good enough for salts in tests
+void esp_fill_random(void* pvBuf, size_t ulLen);
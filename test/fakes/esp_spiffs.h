@@ -0,0 +1,17 @@
+#pragma once
+
+// Host stand-in: the "partition" is the host file system, always mounted
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct
+{
+    const char* base_path;
+    const char* partition_label;
+    size_t      max_files;
+    bool        format_if_mount_failed;
+} esp_vfs_spiffs_conf_t;
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t* ptConf);
+esp_err_t esp_spiffs_info(const char* pcLabel, size_t* pulTotal, size_t* pulUsed);
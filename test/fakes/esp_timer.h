@@ -0,0 +1,33 @@
+#pragma once
+
+// Host stand-in: the timer never fires by itself; tests read its state
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct esp_timer* esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void* pvArg);
+
+typedef struct
+{
+    esp_timer_cb_t callback;
+    void*          arg;
+    const char*    name;
+} esp_timer_create_args_t;
+
+typedef struct
+{
+    bool     bArmed;
+    uint64_t ullTimeoutUs;
+    uint32_t ulStarts;
+} TIMER_FAKE_T;
+
+extern TIMER_FAKE_T g_tTimerFake;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* ptArgs, esp_timer_handle_t* phTimer);
+esp_err_t esp_timer_start_once(esp_timer_handle_t hTimer, uint64_t ullTimeoutUs);
+esp_err_t esp_timer_stop(esp_timer_handle_t hTimer);
+esp_err_t esp_timer_delete(esp_timer_handle_t hTimer);
+
+// Microseconds from the host's monotonic clock
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,18 @@
+#pragma once
+
+// Host stand-in: single-threaded tests, so locks always succeed and
+// created tasks never run
+#include <stdint.h>
+
+typedef int      BaseType_t;
+typedef uint32_t TickType_t;
+typedef void*    SemaphoreHandle_t;
+typedef void*    TaskHandle_t;
+typedef void (*TaskFunction_t)(void* pvArg);
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define pdPASS          1
+#define portMAX_DELAY   0xFFFFFFFFUL
+
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
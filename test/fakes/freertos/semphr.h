@@ -0,0 +1,8 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t hSem, TickType_t xTicks);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t hSem);
+void              vSemaphoreDelete(SemaphoreHandle_t hSem);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+BaseType_t xTaskCreate(TaskFunction_t pfnTask, const char* pcName, uint32_t ulStack,
+                       void* pvArg, uint32_t ulPriority, TaskHandle_t* phTask);
+BaseType_t xTaskNotifyGive(TaskHandle_t hTask);
+uint32_t   ulTaskNotifyTake(BaseType_t xClear, TickType_t xTicks);
@@ -0,0 +1,8 @@
+#pragma once
+
+// Force-included into every host test source: libc gaps against newlib
+#include <stddef.h>
+
+#ifndef HAVE_STRLCPY
+size_t strlcpy(char* pcDst, const char* pcSrc, size_t ulSize);
+#endif
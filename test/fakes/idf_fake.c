@@ -0,0 +1,191 @@
+// Host stand-ins for the ESP-IDF, FreeRTOS and sibling-component calls the
+// code under test makes
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "FlashStats_API.h"
+#include "NVS_API.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+TIMER_FAKE_T g_tTimerFake;
+
+const char*
+esp_err_to_name(esp_err_t err)
+{
+    static char acName[16];
+    snprintf(acName, sizeof(acName), "0x%x", (unsigned)err);
+    return acName;
+}
+
+void
+fake_log(const char* pcTag, const char* pcFmt, ...)
+{
+    (void)pcTag;
+    (void)pcFmt;
+}
+
+#ifndef HAVE_STRLCPY
+size_t
+strlcpy(char* pcDst, const char* pcSrc, size_t ulSize)
+{
+    size_t ulLen = strlen(pcSrc);
+    if (ulSize > 0)
+    {
+        size_t ulCopy = (ulLen < ulSize) ? ulLen : ulSize - 1;
+        memcpy(pcDst, pcSrc, ulCopy);
+        pcDst[ulCopy] = '\0';
+    }
+    return ulLen;
+}
+#endif
+
+/* ---- esp_timer / esp_system ---- */
+
+esp_err_t
+esp_timer_create(const esp_timer_create_args_t* ptArgs, esp_timer_handle_t* phTimer)
+{
+    (void)ptArgs;
+    *phTimer = (esp_timer_handle_t)&g_tTimerFake;
+    return ESP_OK;
+}
+
+esp_err_t
+esp_timer_start_once(esp_timer_handle_t hTimer, uint64_t ullTimeoutUs)
+{
+    (void)hTimer;
+    g_tTimerFake.bArmed       = true;
+    g_tTimerFake.ullTimeoutUs = ullTimeoutUs;
+    g_tTimerFake.ulStarts++;
+    return ESP_OK;
+}
+
+esp_err_t
+esp_timer_stop(esp_timer_handle_t hTimer)
+{
+    (void)hTimer;
+    g_tTimerFake.bArmed = false;
+    return ESP_OK;
+}
+
+esp_err_t
+esp_timer_delete(esp_timer_handle_t hTimer)
+{
+    (void)hTimer;
+    return ESP_OK;
+}
+
+int64_t
+esp_timer_get_time(void)
+{
+    struct timespec tNow;
+    clock_gettime(CLOCK_MONOTONIC, &tNow);
+    return (int64_t)tNow.tv_sec * 1000000 + tNow.tv_nsec / 1000;
+}
+
+esp_err_t
+esp_register_shutdown_handler(shutdown_handler_t pfnHandler)
+{
+    (void)pfnHandler;
+    return ESP_OK;
+}
+
+/* ---- FreeRTOS ---- */
+
+SemaphoreHandle_t
+xSemaphoreCreateMutex(void)
+{
+    static int s_iMutex;
+    return &s_iMutex;
+}
+
+BaseType_t
+xSemaphoreTake(SemaphoreHandle_t hSem, TickType_t xTicks)
+{
+    (void)hSem;
+    (void)xTicks;
+    return pdTRUE;
+}
+
+BaseType_t
+xSemaphoreGive(SemaphoreHandle_t hSem)
+{
+    (void)hSem;
+    return pdTRUE;
+}
+
+void
+vSemaphoreDelete(SemaphoreHandle_t hSem)
+{
+    (void)hSem;
+}
+
+BaseType_t
+xTaskCreate(TaskFunction_t pfnTask, const char* pcName, uint32_t ulStack,
+            void* pvArg, uint32_t ulPriority, TaskHandle_t* phTask)
+{
+    (void)pfnTask;
+    (void)pcName;
+    (void)ulStack;
+    (void)pvArg;
+    (void)ulPriority;
+    static int s_iTask;
+    if (phTask) *phTask = &s_iTask;
+    return pdPASS;
+}
+
+BaseType_t
+xTaskNotifyGive(TaskHandle_t hTask)
+{
+    (void)hTask;
+    return pdPASS;
+}
+
+uint32_t
+ulTaskNotifyTake(BaseType_t xClear, TickType_t xTicks)
+{
+    (void)xClear;
+    (void)xTicks;
+    return 0;
+}
+
+/* ---- esp_spiffs ---- */
+
+esp_err_t
+esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t* ptConf)
+{
+    (void)ptConf;
+    return ESP_OK;
+}
+
+esp_err_t
+esp_spiffs_info(const char* pcLabel, size_t* pulTotal, size_t* pulUsed)
+{
+    (void)pcLabel;
+    *pulTotal = 0;
+    *pulUsed  = 0;
+    return ESP_OK;
+}
+
+/* ---- Sibling components ---- */
+
+void
+FlashStats_RecordWrite(FLASH_STATS_AREA_E eArea, const char* pcName, size_t ulBytes)
+{
+    (void)eArea;
+    (void)pcName;
+    (void)ulBytes;
+}
+
+size_t
+NVS_EntryFootprint(size_t ulDataLen, bool bBlob)
+{
+    (void)bBlob;
+    return 32 + ulDataLen;
+}
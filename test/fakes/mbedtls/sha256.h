@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the mbedtls SHA-256 API that WS_AuthCrypto uses: a
+// plain C implementation (FIPS 180-4), checked against the NIST vectors in
+// test_auth_crypto.c before anything is built on it
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t state[8];
+    uint64_t total;
+    uint8_t  buffer[64];
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_clone(mbedtls_sha256_context* dst, const mbedtls_sha256_context* src);
+int  mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224);
+int  mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t ilen);
+int  mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char output[32]);
+int  mbedtls_sha256(const unsigned char* input, size_t ilen, unsigned char output[32], int is224);
@@ -0,0 +1,50 @@
+#pragma once
+
+// Host stand-in for ESP-IDF NVS: an in-memory key store that counts every
+// call, so tests can see what reached "flash"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NVS_KEY_NAME_MAX_SIZE   16
+#define NVS_NS_NAME_MAX_SIZE    16
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum
+{
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+esp_err_t nvs_open(const char* pcNamespace, nvs_open_mode_t eMode, nvs_handle_t* phHandle);
+void      nvs_close(nvs_handle_t hHandle);
+esp_err_t nvs_get_str(nvs_handle_t hHandle, const char* pcKey, char* pcOut, size_t* pulLen);
+esp_err_t nvs_get_blob(nvs_handle_t hHandle, const char* pcKey, void* pvOut, size_t* pulLen);
+esp_err_t nvs_get_u8(nvs_handle_t hHandle, const char* pcKey, uint8_t* pucOut);
+esp_err_t nvs_set_str(nvs_handle_t hHandle, const char* pcKey, const char* pcValue);
+esp_err_t nvs_set_blob(nvs_handle_t hHandle, const char* pcKey, const void* pvValue, size_t ulLen);
+esp_err_t nvs_set_u8(nvs_handle_t hHandle, const char* pcKey, uint8_t ucValue);
+esp_err_t nvs_erase_key(nvs_handle_t hHandle, const char* pcKey);
+esp_err_t nvs_erase_all(nvs_handle_t hHandle);
+esp_err_t nvs_commit(nvs_handle_t hHandle);
+
+/* ------------------------------------------------------------------ */
+/* Test control                                                        */
+/* ------------------------------------------------------------------ */
+
+typedef struct
+{
+    uint32_t  ulOpens;
+    uint32_t  ulGets;
+    uint32_t  ulSets;           /* nvs_set_* and nvs_erase_key */
+    uint32_t  ulCommits;
+    esp_err_t errGet;           /* returned by every nvs_get_* while set */
+    esp_err_t errSet;           /* returned by every nvs_set_* while set */
+} NVS_FAKE_T;
+
+extern NVS_FAKE_T g_tNvsFake;
+
+/** Number of keys stored under pcNamespace */
+uint32_t NvsFake_Count(const char* pcNamespace);
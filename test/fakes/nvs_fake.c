@@ -0,0 +1,181 @@
+#include "nvs.h"
+
+#include <string.h>
+
+#define FAKE_NS_MAX         8
+#define FAKE_KEYS_MAX       64
+#define FAKE_VALUE_MAX      512
+
+typedef enum
+{
+    FAKE_TYPE_STR = 1,
+    FAKE_TYPE_BLOB,
+    FAKE_TYPE_U8,
+} FAKE_TYPE_E;
+
+typedef struct
+{
+    uint32_t ulNs;              /* handle; 0 = free */
+    char     acKey[NVS_KEY_NAME_MAX_SIZE];
+    uint8_t  eType;
+    size_t   ulLen;
+    uint8_t  aucData[FAKE_VALUE_MAX];
+} FAKE_KEY_T;
+
+NVS_FAKE_T g_tNvsFake;
+
+static char       s_aacNs[FAKE_NS_MAX][NVS_NS_NAME_MAX_SIZE];
+static FAKE_KEY_T s_atKeys[FAKE_KEYS_MAX];
+
+static FAKE_KEY_T*
+fake_Find(nvs_handle_t hHandle, const char* pcKey)
+{
+    for (int i = 0; i < FAKE_KEYS_MAX; i++)
+    {
+        if ((s_atKeys[i].ulNs == hHandle) && (strcmp(s_atKeys[i].acKey, pcKey) == 0)) return &s_atKeys[i];
+    }
+    return NULL;
+}
+
+static esp_err_t
+fake_Get(nvs_handle_t hHandle, const char* pcKey, FAKE_TYPE_E eType, void* pvOut, size_t* pulLen)
+{
+    g_tNvsFake.ulGets++;
+    if (ESP_OK != g_tNvsFake.errGet) return g_tNvsFake.errGet;
+
+    const FAKE_KEY_T* ptKey = fake_Find(hHandle, pcKey);
+    if ((NULL == ptKey) || (ptKey->eType != eType)) return ESP_ERR_NVS_NOT_FOUND;
+
+    if (NULL == pvOut)
+    {
+        *pulLen = ptKey->ulLen;
+        return ESP_OK;
+    }
+    if (*pulLen < ptKey->ulLen) return ESP_ERR_NVS_INVALID_LENGTH;
+    memcpy(pvOut, ptKey->aucData, ptKey->ulLen);
+    *pulLen = ptKey->ulLen;
+    return ESP_OK;
+}
+
+static esp_err_t
+fake_Set(nvs_handle_t hHandle, const char* pcKey, FAKE_TYPE_E eType, const void* pvValue, size_t ulLen)
+{
+    g_tNvsFake.ulSets++;
+    if (ESP_OK != g_tNvsFake.errSet) return g_tNvsFake.errSet;
+    if (ulLen > FAKE_VALUE_MAX) return ESP_ERR_NVS_INVALID_LENGTH;
+
+    FAKE_KEY_T* ptKey = fake_Find(hHandle, pcKey);
+    if (NULL == ptKey) ptKey = fake_Find(0, "");
+    if (NULL == ptKey) return ESP_ERR_NO_MEM;
+
+    ptKey->ulNs = hHandle;
+    strncpy(ptKey->acKey, pcKey, sizeof(ptKey->acKey) - 1);
+    ptKey->eType = (uint8_t)eType;
+    ptKey->ulLen = ulLen;
+    memcpy(ptKey->aucData, pvValue, ulLen);
+    return ESP_OK;
+}
+
+esp_err_t
+nvs_open(const char* pcNamespace, nvs_open_mode_t eMode, nvs_handle_t* phHandle)
+{
+    (void)eMode;
+    g_tNvsFake.ulOpens++;
+
+    for (int i = 0; i < FAKE_NS_MAX; i++)
+    {
+        if ((s_aacNs[i][0] == '\0') || (strcmp(s_aacNs[i], pcNamespace) == 0))
+        {
+            strncpy(s_aacNs[i], pcNamespace, NVS_NS_NAME_MAX_SIZE - 1);
+            *phHandle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void
+nvs_close(nvs_handle_t hHandle)
+{
+    (void)hHandle;
+}
+
+esp_err_t
+nvs_get_str(nvs_handle_t hHandle, const char* pcKey, char* pcOut, size_t* pulLen)
+{
+    return fake_Get(hHandle, pcKey, FAKE_TYPE_STR, pcOut, pulLen);
+}
+
+esp_err_t
+nvs_get_blob(nvs_handle_t hHandle, const char* pcKey, void* pvOut, size_t* pulLen)
+{
+    return fake_Get(hHandle, pcKey, FAKE_TYPE_BLOB, pvOut, pulLen);
+}
+
+esp_err_t
+nvs_get_u8(nvs_handle_t hHandle, const char* pcKey, uint8_t* pucOut)
+{
+    size_t ulLen = 1;
+    return fake_Get(hHandle, pcKey, FAKE_TYPE_U8, pucOut, &ulLen);
+}
+
+esp_err_t
+nvs_set_str(nvs_handle_t hHandle, const char* pcKey, const char* pcValue)
+{
+    return fake_Set(hHandle, pcKey, FAKE_TYPE_STR, pcValue, strlen(pcValue) + 1);
+}
+
+esp_err_t
+nvs_set_blob(nvs_handle_t hHandle, const char* pcKey, const void* pvValue, size_t ulLen)
+{
+    return fake_Set(hHandle, pcKey, FAKE_TYPE_BLOB, pvValue, ulLen);
+}
+
+esp_err_t
+nvs_set_u8(nvs_handle_t hHandle, const char* pcKey, uint8_t ucValue)
+{
+    return fake_Set(hHandle, pcKey, FAKE_TYPE_U8, &ucValue, 1);
+}
+
+esp_err_t
+nvs_erase_key(nvs_handle_t hHandle, const char* pcKey)
+{
+    g_tNvsFake.ulSets++;
+    FAKE_KEY_T* ptKey = fake_Find(hHandle, pcKey);
+    if (NULL == ptKey) return ESP_ERR_NVS_NOT_FOUND;
+    memset(ptKey, 0, sizeof(*ptKey));
+    return ESP_OK;
+}
+
+esp_err_t
+nvs_erase_all(nvs_handle_t hHandle)
+{
+    for (int i = 0; i < FAKE_KEYS_MAX; i++)
+    {
+        if (s_atKeys[i].ulNs == hHandle) memset(&s_atKeys[i], 0, sizeof(s_atKeys[i]));
+    }
+    return ESP_OK;
+}
+
+esp_err_t
+nvs_commit(nvs_handle_t hHandle)
+{
+    (void)hHandle;
+    g_tNvsFake.ulCommits++;
+    return ESP_OK;
+}
+
+uint32_t
+NvsFake_Count(const char* pcNamespace)
+{
+    uint32_t ulCount = 0;
+    for (int i = 0; i < FAKE_NS_MAX; i++)
+    {
+        if (strcmp(s_aacNs[i], pcNamespace) != 0) continue;
+        for (int k = 0; k < FAKE_KEYS_MAX; k++)
+        {
+            if (s_atKeys[k].ulNs == (uint32_t)(i + 1)) ulCount++;
+        }
+    }
+    return ulCount;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Kconfig values the host tests build with
+#define CONFIG_NVS_CONFIG_COMMIT_DELAY_MS   250
+#define CONFIG_NVS_CONFIG_CACHE_ENTRIES     8
@@ -0,0 +1,158 @@
+// PBKDF2-HMAC-SHA256 known answers and host cost per iteration count.
+// SHA-256 comes from fakes/mbedtls_fake.c, so its own vectors run first.
+#include "WS_AuthCrypto.h"
+#include "mbedtls/sha256.h"
+#include "esp_timer.h"
+#include "test_check.h"
+
+#include <inttypes.h>
+
+static void
+hex(const uint8_t* bin, size_t len, char* out)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        sprintf(out + 2 * i, "%02x", bin[i]);
+    }
+}
+
+static void
+check_sha256(const char* msg, const char* expect, int line)
+{
+    uint8_t out[32];
+    char    out_hex[65];
+    mbedtls_sha256((const unsigned char*)msg, strlen(msg), out, 0);
+    hex(out, sizeof(out), out_hex);
+    if (strcmp(out_hex, expect) != 0)
+    {
+        printf("line %d: sha256(\"%s\") = %s\n", line, msg, out_hex);
+        s_failures++;
+    }
+}
+#define SHA256(m, e) check_sha256((m), (e), __LINE__)
+
+static void
+check_pbkdf2(const char* pw, const char* salt, size_t salt_len, uint32_t c, const char* expect, int line)
+{
+    uint8_t out[AUTH_CRYPTO_HASH_LEN];
+    char    out_hex[AUTH_CRYPTO_HASH_HEX];
+    CHECK(auth_crypto_pbkdf2(pw, (const uint8_t*)salt, salt_len, c, out) == ESP_OK);
+    hex(out, sizeof(out), out_hex);
+    if (strcmp(out_hex, expect) != 0)
+    {
+        printf("line %d: PBKDF2(\"%.16s\", c=%" PRIu32 ") = %s\n", line, pw, c, out_hex);
+        s_failures++;
+    }
+}
+#define PBKDF2(p, s, sl, c, e) check_pbkdf2((p), (s), (sl), (c), (e), __LINE__)
+
+static void
+test_sha256(void)
+{
+    // FIPS 180-2 appendix B
+    SHA256("abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    SHA256("", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    SHA256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+static void
+test_pbkdf2_vectors(void)
+{
+    // RFC 7914 §11 (first 32 bytes of the 64-byte outputs)
+    PBKDF2("passwd", "salt", 4, 1,
+           "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc");
+    PBKDF2("Password", "NaCl", 4, 80000,
+           "4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56");
+    // RFC 6070 inputs with SHA-256
+    PBKDF2("password", "salt", 4, 4096,
+           "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a");
+
+    // Out-of-range costs are refused
+    uint8_t out[AUTH_CRYPTO_HASH_LEN];
+    CHECK(auth_crypto_pbkdf2("p", (const uint8_t*)"s", 1, 0, out) == ESP_ERR_INVALID_ARG);
+    CHECK(auth_crypto_pbkdf2("p", (const uint8_t*)"s", 1, AUTH_CRYPTO_MAX_ITERATIONS + 1, out)
+          == ESP_ERR_INVALID_ARG);
+}
+
+// Stored-credential form: 16-byte salt, hex as kept in NVS
+static void
+check_verify(const char* pw, uint32_t c, const char* hash_hex, int line)
+{
+    uint8_t salt[AUTH_CRYPTO_SALT_LEN];
+    uint8_t hash[AUTH_CRYPTO_HASH_LEN];
+    for (size_t i = 0; i < sizeof(salt); i++)
+    {
+        salt[i] = (uint8_t)i;
+    }
+    CHECK(auth_crypto_hex_to_hash(hash_hex, hash) == ESP_OK);
+
+    if (!auth_crypto_verify_password(pw, salt, c, hash))
+    {
+        printf("line %d: verify(\"%.16s\", c=%" PRIu32 ") failed\n", line, pw, c);
+        s_failures++;
+    }
+    hash[31] ^= 1;
+    CHECK(!auth_crypto_verify_password(pw, salt, c, hash));
+}
+#define VERIFY(p, c, h) check_verify((p), (c), (h), __LINE__)
+
+static void
+test_verify(void)
+{
+    VERIFY("correct horse battery staple", 4096,
+           "c4120a097ae5a3c78f702c4c8a719bc2fc0ede03832cf915ca8d96da09a68f66");
+    // HMAC key longer than a block is hashed first; exactly a block is not
+    VERIFY("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", 4096,
+           "78ff7da79bd2250b963bf5140566f23232f1546ef36083f19e19a4424862519f");
+    VERIFY("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 2,
+           "dd97e5f9f2e4f0432e9d82d26f8436e922564f890b378bb1312570c829c9ca42");
+    // Pre-PBKDF2 hashes: SHA-256( salt || password )
+    VERIFY("legacy-pass", AUTH_CRYPTO_LEGACY_ITERATIONS,
+           "8105c7498a0cf76a1905b112fbe8ad1a662c7c8e21ddd4b3c5dc69759ae6c533");
+
+    // Fresh salt each time, and the result verifies
+    uint8_t salt1[AUTH_CRYPTO_SALT_LEN], salt2[AUTH_CRYPTO_SALT_LEN];
+    uint8_t hash1[AUTH_CRYPTO_HASH_LEN], hash2[AUTH_CRYPTO_HASH_LEN];
+    CHECK(auth_crypto_hash_password("s3cret-pw", AUTH_CRYPTO_MIN_ITERATIONS, salt1, hash1) == ESP_OK);
+    CHECK(auth_crypto_hash_password("s3cret-pw", AUTH_CRYPTO_MIN_ITERATIONS, salt2, hash2) == ESP_OK);
+    CHECK(memcmp(salt1, salt2, sizeof(salt1)) != 0);
+    CHECK(auth_crypto_verify_password("s3cret-pw", salt1, AUTH_CRYPTO_MIN_ITERATIONS, hash1));
+    CHECK(!auth_crypto_verify_password("s3cret-pW", salt1, AUTH_CRYPTO_MIN_ITERATIONS, hash1));
+    CHECK(!auth_crypto_verify_password("s3cret-pw", salt1, AUTH_CRYPTO_MIN_ITERATIONS + 1, hash1));
+    CHECK(auth_crypto_hash_password("pw", AUTH_CRYPTO_MIN_ITERATIONS - 1, salt1, hash1) == ESP_ERR_INVALID_ARG);
+}
+
+// Host cost of a password check per iteration count. Reported, not checked:
+// the device uses the SHA accelerator, and calibrates at boot
+static void
+bench_verify(void)
+{
+    static const uint32_t s_aulIter[] = { 4096, 16384, 65536, 262144 };
+    uint8_t salt[AUTH_CRYPTO_SALT_LEN] = { 0 };
+    uint8_t hash[AUTH_CRYPTO_HASH_LEN] = { 0 };
+
+    printf("auth_crypto_verify_password on the host:\n");
+    for (size_t i = 0; i < sizeof(s_aulIter) / sizeof(s_aulIter[0]); i++)
+    {
+        int64_t llStart = esp_timer_get_time();
+        auth_crypto_verify_password("benchmark", salt, s_aulIter[i], hash);
+        int64_t llUs = esp_timer_get_time() - llStart;
+        printf("  %7" PRIu32 " iterations: %8.2f ms  (%.0f ns/iteration)\n",
+               s_aulIter[i], llUs / 1000.0, (llUs * 1000.0) / s_aulIter[i]);
+    }
+
+    uint32_t ulIter = auth_crypto_calibrate(150);
+    printf("  calibrated for 150 ms: %" PRIu32 " iterations\n", ulIter);
+    CHECK((ulIter % 1024) == 0);
+    CHECK((ulIter >= AUTH_CRYPTO_MIN_ITERATIONS) && (ulIter <= AUTH_CRYPTO_MAX_ITERATIONS));
+}
+
+int main(void)
+{
+    test_sha256();
+    test_pbkdf2_vectors();
+    test_verify();
+    bench_verify();
+    TEST_DONE();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+// Minimal checks for the host tests: report every failure, exit non-zero
+static int s_failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond))                                                        \
+        {                                                                   \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            s_failures++;                                                   \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_STR(a, b)                                                     \
+    do {                                                                    \
+        const char* pa_ = (a);                                              \
+        const char* pb_ = (b);                                              \
+        if (!((pa_ == pb_) || (pa_ && pb_ && (strcmp(pa_, pb_) == 0))))     \
+        {                                                                   \
+            printf("%s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__,         \
+                   pa_ ? pa_ : "(null)", pb_ ? pb_ : "(null)");             \
+            s_failures++;                                                   \
+        }                                                                   \
+    } while (0)
+
+#define TEST_DONE()                                                         \
+    do {                                                                    \
+        printf("%s\n", (s_failures == 0) ? "OK" : "FAILED");                \
+        return (s_failures == 0) ? 0 : 1;                                   \
+    } while (0)
@@ -0,0 +1,230 @@
+// NVS_Config key cache and batched commits, against the in-memory NVS fake.
+// One process, one NVS_Config: each step checks stat deltas.
+#include "NVS_Config.h"
+#include "nvs.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "test_check.h"
+
+#define ENTRIES     CONFIG_NVS_CONFIG_CACHE_ENTRIES
+
+static NVS_CONFIG_STATS_T
+stats(void)
+{
+    NVS_CONFIG_STATS_T tStats;
+    NVS_Config_GetStats(&tStats);
+    return tStats;
+}
+
+static void
+key_name(char* pcOut, size_t ulLen, const char* pcPrefix, int i)
+{
+    snprintf(pcOut, ulLen, "%s%d", pcPrefix, i);
+}
+
+static void
+test_read_cache(void)
+{
+    char acOut[32];
+
+    // Placed behind the cache's back, as if written by an earlier boot
+    nvs_handle_t hNvs;
+    nvs_open("rd", NVS_READWRITE, &hNvs);
+    nvs_set_str(hNvs, "name", "bell");
+
+    NVS_CONFIG_STATS_T tBefore = stats();
+    uint32_t ulGets = g_tNvsFake.ulGets;
+
+    CHECK(NVS_Config_GetStr("rd", "name", acOut, sizeof(acOut)) == ESP_OK);
+    CHECK_STR(acOut, "bell");
+    CHECK(NVS_Config_GetStr("rd", "name", acOut, sizeof(acOut)) == ESP_OK);
+    CHECK(g_tNvsFake.ulGets == ulGets + 1);
+
+    // Missing keys are cached too
+    CHECK(NVS_Config_GetStr("rd", "none", acOut, sizeof(acOut)) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(NVS_Config_GetStr("rd", "none", acOut, sizeof(acOut)) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(g_tNvsFake.ulGets == ulGets + 2);
+
+    NVS_CONFIG_STATS_T tAfter = stats();
+    CHECK(tAfter.ulMisses == tBefore.ulMisses + 2);
+    CHECK(tAfter.ulHits == tBefore.ulHits + 2);
+
+    // Same nvs_get_* semantics: size query, short buffer, wrong type
+    size_t ulLen = 0;
+    CHECK(NVS_Config_GetBlob("rd", "name", NULL, &ulLen) == ESP_ERR_NVS_TYPE_MISMATCH);
+    char acShort[3];
+    CHECK(NVS_Config_GetStr("rd", "name", acShort, sizeof(acShort)) == ESP_ERR_NVS_INVALID_LENGTH);
+}
+
+static void
+test_batched_commits(void)
+{
+    CHECK(NVS_Config_Flush() == ESP_OK);
+    NVS_CONFIG_STATS_T tBefore = stats();
+    uint32_t ulSets    = g_tNvsFake.ulSets;
+    uint32_t ulCommits = g_tNvsFake.ulCommits;
+
+    CHECK(NVS_Config_SetStr("wa", "k1", "one") == ESP_OK);
+    CHECK(NVS_Config_SetStr("wa", "k2", "two") == ESP_OK);
+    CHECK(NVS_Config_SetU8("wa", "k3", 3) == ESP_OK);
+    CHECK(NVS_Config_SetStr("wb", "k1", "uno") == ESP_OK);
+    CHECK(NVS_Config_SetStr("wb", "k2", "dos") == ESP_OK);
+
+    // Held in RAM until the window closes; reads see them already
+    CHECK(g_tNvsFake.ulSets == ulSets);
+    CHECK(g_tTimerFake.bArmed);
+    CHECK(g_tTimerFake.ullTimeoutUs == CONFIG_NVS_CONFIG_COMMIT_DELAY_MS * 1000ULL);
+    CHECK(stats().ulDirty == tBefore.ulDirty + 5);
+    uint8_t ucValue = 0;
+    CHECK(NVS_Config_GetU8("wa", "k3", &ucValue) == ESP_OK);
+    CHECK(ucValue == 3);
+
+    // Rewrites inside the window replace the pending value; equal ones are dropped
+    CHECK(NVS_Config_SetStr("wa", "k1", "ONE") == ESP_OK);
+    CHECK(NVS_Config_SetStr("wb", "k2", "dos") == ESP_OK);
+
+    // One write per key, one commit per namespace
+    CHECK(NVS_Config_Flush() == ESP_OK);
+    CHECK(g_tNvsFake.ulSets == ulSets + 5);
+    CHECK(g_tNvsFake.ulCommits == ulCommits + 2);
+    CHECK(!g_tTimerFake.bArmed);
+    CHECK(NvsFake_Count("wa") == 3);
+    CHECK(NvsFake_Count("wb") == 2);
+
+    char acOut[8];
+    size_t ulLen = sizeof(acOut);
+    nvs_handle_t hNvs;
+    nvs_open("wa", NVS_READWRITE, &hNvs);
+    CHECK(nvs_get_str(hNvs, "k1", acOut, &ulLen) == ESP_OK);
+    CHECK_STR(acOut, "ONE");
+
+    NVS_CONFIG_STATS_T tAfter = stats();
+    CHECK(tAfter.ulDirty == 0);
+    CHECK(tAfter.ulCoalesced == tBefore.ulCoalesced + 1);
+    CHECK(tAfter.ulSkipped == tBefore.ulSkipped + 1);
+    CHECK(tAfter.ulFlushes == tBefore.ulFlushes + 1);
+
+    // Nothing pending: no commit at all
+    CHECK(NVS_Config_Flush() == ESP_OK);
+    CHECK(g_tNvsFake.ulCommits == ulCommits + 2);
+
+    // Erase is staged like a write
+    CHECK(NVS_Config_EraseKey("wa", "k2") == ESP_OK);
+    CHECK(NVS_Config_GetStr("wa", "k2", acOut, sizeof(acOut)) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(NvsFake_Count("wa") == 3);
+    CHECK(NVS_Config_Flush() == ESP_OK);
+    CHECK(NvsFake_Count("wa") == 2);
+}
+
+static void
+test_failed_write_stays_dirty(void)
+{
+    uint32_t ulErrors = stats().ulWriteErrors;
+
+    CHECK(NVS_Config_SetStr("wf", "k", "v") == ESP_OK);
+    g_tNvsFake.errSet = ESP_FAIL;
+    CHECK(NVS_Config_Flush() == ESP_FAIL);
+    CHECK(stats().ulDirty == 1);
+    CHECK(stats().ulWriteErrors == ulErrors + 1);
+    CHECK(g_tTimerFake.bArmed);     // retried when the window closes again
+
+    g_tNvsFake.errSet = ESP_OK;
+    CHECK(NVS_Config_Flush() == ESP_OK);
+    CHECK(stats().ulDirty == 0);
+    CHECK(NvsFake_Count("wf") == 1);
+}
+
+static void
+test_large_values_bypass(void)
+{
+    uint8_t aucBig[NVS_CONFIG_VALUE_MAX + 1];
+    memset(aucBig, 0x5A, sizeof(aucBig));
+
+    uint32_t ulUsed    = stats().ulCacheUsed;
+    uint32_t ulCommits = g_tNvsFake.ulCommits;
+
+    // Written and committed at once, never cached
+    CHECK(NVS_Config_SetBlob("wl", "big", aucBig, sizeof(aucBig)) == ESP_OK);
+    CHECK(g_tNvsFake.ulCommits == ulCommits + 1);
+    CHECK(stats().ulCacheUsed == ulUsed);
+
+    uint8_t aucOut[sizeof(aucBig)];
+    size_t ulLen = sizeof(aucOut);
+    CHECK(NVS_Config_GetBlob("wl", "big", aucOut, &ulLen) == ESP_OK);
+    CHECK(ulLen == sizeof(aucBig));
+    CHECK(memcmp(aucOut, aucBig, sizeof(aucBig)) == 0);
+    // The slot tried for it is given back (after evicting, if the cache was full)
+    CHECK(stats().ulCacheUsed <= ulUsed);
+}
+
+static void
+test_cache_used_count(void)
+{
+    char acKey[NVS_KEY_NAME_MAX_SIZE];
+    char acOut[8];
+
+    // Start from an empty cache
+    CHECK(NVS_Config_Flush() == ESP_OK);
+    const char* apcNs[] = { "rd", "wa", "wb", "wf", "wl" };
+    for (size_t i = 0; i < sizeof(apcNs) / sizeof(apcNs[0]); i++)
+    {
+        CHECK(NVS_Config_EraseNamespace(apcNs[i]) == ESP_OK);
+    }
+    CHECK(stats().ulCacheUsed == 0);
+
+    // More distinct keys than slots: evictions keep the count at the size
+    for (int i = 0; i < ENTRIES + 4; i++)
+    {
+        key_name(acKey, sizeof(acKey), "r", i);
+        CHECK(NVS_Config_GetStr("cu", acKey, acOut, sizeof(acOut)) == ESP_ERR_NVS_NOT_FOUND);
+        CHECK(stats().ulCacheUsed == (uint32_t)((i < ENTRIES) ? i + 1 : ENTRIES));
+    }
+
+    // An evicted slot whose load fails goes back to the pool: one fewer used
+    g_tNvsFake.errGet = ESP_FAIL;
+    CHECK(NVS_Config_GetStr("cu", "fail1", acOut, sizeof(acOut)) == ESP_FAIL);
+    CHECK(stats().ulCacheUsed == ENTRIES - 1);
+
+    // A free slot whose load fails: the count is back where it was
+    CHECK(NVS_Config_GetStr("cu", "fail2", acOut, sizeof(acOut)) == ESP_FAIL);
+    CHECK(stats().ulCacheUsed == ENTRIES - 1);
+    g_tNvsFake.errGet = ESP_OK;
+
+    CHECK(NVS_Config_GetStr("cu", "ok", acOut, sizeof(acOut)) == ESP_ERR_NVS_NOT_FOUND);
+    CHECK(stats().ulCacheUsed == ENTRIES);
+
+    // A full cache of dirty slots is flushed early to make room
+    uint32_t ulSets = g_tNvsFake.ulSets;
+    for (int i = 0; i < ENTRIES + 1; i++)
+    {
+        key_name(acKey, sizeof(acKey), "w", i);
+        CHECK(NVS_Config_SetU8("cd", acKey, (uint8_t)i) == ESP_OK);
+    }
+    CHECK(g_tNvsFake.ulSets == ulSets + ENTRIES);
+    CHECK(stats().ulCacheUsed == ENTRIES);
+    CHECK(stats().ulDirty == 1);
+
+    // A cached value replaced by a large one drops its slot (w0 was evicted)
+    uint8_t aucBig[NVS_CONFIG_VALUE_MAX + 1] = { 0 };
+    CHECK(NVS_Config_SetBlob("cd", "w1", aucBig, sizeof(aucBig)) == ESP_OK);
+    CHECK(stats().ulCacheUsed == ENTRIES - 1);
+
+    // Dropping every namespace empties the cache exactly
+    CHECK(NVS_Config_EraseNamespace("cu") == ESP_OK);
+    CHECK(NVS_Config_EraseNamespace("cd") == ESP_OK);
+    CHECK(stats().ulCacheUsed == 0);
+    CHECK(stats().ulDirty == 0);
+}
+
+int main(void)
+{
+    CHECK(NVS_Config_Init() == ESP_OK);
+    CHECK(stats().ulCacheEntries == ENTRIES);
+
+    test_read_cache();
+    test_batched_commits();
+    test_failed_write_stays_dirty();
+    test_large_values_bypass();
+    test_cache_used_count();
+    TEST_DONE();
+}
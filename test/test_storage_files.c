@@ -0,0 +1,130 @@
+// Storage read/write round trip at the largest section the REST API accepts,
+// against the host file system.
+#include "SPIFFS_API.h"
+#include "test_check.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+// ScheduleAPI.c body limits. Holidays and exceptions share calendar.json,
+// so the largest file is the two together.
+#define HOLIDAYS_BODY_MAX       (12 * 1024)
+#define EXCEPTIONS_BODY_MAX     (32 * 1024)
+#define CALENDAR_FILE_MAX       (HOLIDAYS_BODY_MAX + EXCEPTIONS_BODY_MAX)
+
+static char s_acDir[] = "/tmp/bell_storage_XXXXXX";
+
+static void
+path(char* pcOut, size_t ulLen, const char* pcName)
+{
+    snprintf(pcOut, ulLen, "%s/%s", s_acDir, pcName);
+}
+
+// Exceptions-style JSON of exactly ulLen bytes
+static char*
+make_json(size_t ulLen)
+{
+    static const char acItem[] =
+        "{\"id\":65535,\"type\":\"override\",\"date\":\"2026-10-19\",\"endDate\":\"2026-10-23\","
+        "\"label\":\"Exam week bell\",\"templateIdx\":3,\"action\":\"template\"},";
+    char* pcJson = malloc(ulLen + 1);
+    size_t ulPos = 0;
+
+    pcJson[ulPos++] = '[';
+    while (ulPos + sizeof(acItem) < ulLen)
+    {
+        memcpy(pcJson + ulPos, acItem, sizeof(acItem) - 1);
+        ulPos += sizeof(acItem) - 1;
+    }
+    while (ulPos < ulLen - 1)
+    {
+        pcJson[ulPos++] = ' ';
+    }
+    pcJson[ulPos++] = ']';
+    pcJson[ulPos]   = '\0';
+    return pcJson;
+}
+
+static void
+round_trip(const char* pcName, size_t ulLen)
+{
+    char acPath[64];
+    path(acPath, sizeof(acPath), pcName);
+    char* pcJson = make_json(ulLen);
+
+    CHECK(SPIFFS_WriteFile(acPath, pcJson, ulLen) == ESP_OK);
+
+    char*  pcRead = NULL;
+    size_t ulRead = 0;
+    CHECK(SPIFFS_ReadFileAlloc(acPath, &pcRead, &ulRead) == ESP_OK);
+    CHECK(ulRead == ulLen);
+    CHECK((pcRead != NULL) && (memcmp(pcRead, pcJson, ulLen) == 0) && (pcRead[ulLen] == '\0'));
+
+    free(pcRead);
+    free(pcJson);
+    remove(acPath);
+}
+
+static void
+test_round_trip(void)
+{
+    round_trip("bells.json", 16 * 1024);
+    round_trip("exceptions.json", EXCEPTIONS_BODY_MAX);
+    round_trip("calendar.json", CALENDAR_FILE_MAX);
+    // Ids and defaults added on save can make the file larger than the body
+    round_trip("grown.json", CALENDAR_FILE_MAX + 4096);
+    round_trip("empty.json", 2);
+}
+
+static void
+test_errors(void)
+{
+    char acPath[64];
+    char* pcRead = (char*)1;
+
+    path(acPath, sizeof(acPath), "missing.json");
+    CHECK(SPIFFS_ReadFileAlloc(acPath, &pcRead, NULL) == ESP_ERR_NOT_FOUND);
+    CHECK(pcRead == NULL);
+
+    // Over the sanity bound
+    path(acPath, sizeof(acPath), "huge.json");
+    char* pcJson = make_json(129 * 1024);
+    CHECK(SPIFFS_WriteFile(acPath, pcJson, strlen(pcJson)) == ESP_OK);
+    CHECK(SPIFFS_ReadFileAlloc(acPath, &pcRead, NULL) == ESP_ERR_INVALID_SIZE);
+    free(pcJson);
+    remove(acPath);
+
+    // A fixed buffer reports truncation instead of returning a cut-off file
+    path(acPath, sizeof(acPath), "cut.json");
+    pcJson = make_json(9000);
+    CHECK(SPIFFS_WriteFile(acPath, pcJson, strlen(pcJson)) == ESP_OK);
+    char acBuf[8192];
+    size_t ulRead = 0;
+    CHECK(SPIFFS_ReadFile(acPath, acBuf, sizeof(acBuf), &ulRead) == ESP_ERR_INVALID_SIZE);
+    CHECK(ulRead == sizeof(acBuf) - 1);
+    free(pcJson);
+
+    // Exactly filling the buffer is not truncation
+    pcJson = make_json(sizeof(acBuf) - 1);
+    CHECK(SPIFFS_WriteFile(acPath, pcJson, strlen(pcJson)) == ESP_OK);
+    CHECK(SPIFFS_ReadFile(acPath, acBuf, sizeof(acBuf), &ulRead) == ESP_OK);
+    CHECK(strcmp(acBuf, pcJson) == 0);
+    free(pcJson);
+    remove(acPath);
+}
+
+int main(void)
+{
+    if (mkdtemp(s_acDir) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    CHECK(SPIFFS_Init() == ESP_OK);
+
+    test_round_trip();
+    test_errors();
+
+    rmdir(s_acDir);
+    TEST_DONE();
+}
@@ -0,0 +1,143 @@
+// Accept-Encoding parsing, variant choice and the headers that go with it
+#include "WS_React_Encoding.h"
+#include "test_check.h"
+
+#define I WS_REACT_ENC_IDENTITY
+#define G WS_REACT_ENC_GZIP
+#define B WS_REACT_ENC_BR
+
+static void parse(const char* value, uint16_t qi, uint16_t qg, uint16_t qb, int line)
+{
+    uint16_t q[WS_REACT_ENC_COUNT];
+    WS_React_Encoding_ParseAccept(value, q);
+    if ((q[I] != qi) || (q[G] != qg) || (q[B] != qb))
+    {
+        printf("line %d: \"%s\" -> identity %u gzip %u br %u, want %u %u %u\n", line,
+               value ? value : "(none)", q[I], q[G], q[B], qi, qg, qb);
+        s_failures++;
+    }
+}
+#define PARSE(v, qi, qg, qb) parse((v), (qi), (qg), (qb), __LINE__)
+
+static void test_parse(void)
+{
+    PARSE(NULL,                              1000, 1000, 1000);
+    PARSE("",                                1000,    0,    0);
+    PARSE("gzip, deflate, br",               1000, 1000, 1000);
+    PARSE("gzip, deflate",                   1000, 1000,    0);
+    PARSE("br;q=0.5, gzip;q=0.8",            1000,  800,  500);
+    PARSE("gzip;q=1.0, identity; q=0.5",      500, 1000,    0);
+    PARSE("GZIP;Q=0.25",                     1000,  250,    0);
+    PARSE("x-gzip",                          1000, 1000,    0);
+    PARSE("*",                               1000, 1000, 1000);
+    PARSE("*;q=0.3, br;q=0",                 1000,  300,    0);
+    PARSE("identity;q=0",                       0,    0,    0);
+    PARSE("*;q=0",                              0,    0,    0);
+    PARSE("*;q=0, identity",                 1000,    0,    0);
+    PARSE("gzip;q=0.0001",                   1000,    0,    0);
+    PARSE("gzip;q=bogus",                    1000, 1000,    0);
+    PARSE(" ,gzip,, br ;q=0.1",              1000, 1000,  100);
+    PARSE("gzipx, brotli",                   1000,    0,    0);
+}
+
+static void test_choose(void)
+{
+    ws_react_enc_avail_t all[WS_REACT_ENC_COUNT] =
+    {
+        [I] = { true, 1000 }, [G] = { true, 300 }, [B] = { true, 250 },
+    };
+    uint16_t any[WS_REACT_ENC_COUNT]    = { 1000, 1000, 1000 };
+    uint16_t no_br[WS_REACT_ENC_COUNT]  = { 1000, 1000, 0 };
+    uint16_t none[WS_REACT_ENC_COUNT]   = { 0, 0, 0 };
+
+    CHECK(WS_React_Encoding_Choose(all, any) == B);
+    CHECK(WS_React_Encoding_Choose(all, no_br) == G);
+    CHECK(WS_React_Encoding_Choose(all, none) == WS_REACT_ENC_COUNT);
+
+    // Smallest wins, whatever the coding
+    ws_react_enc_avail_t br_big[WS_REACT_ENC_COUNT] =
+    {
+        [I] = { true, 1000 }, [G] = { true, 300 }, [B] = { true, 310 },
+    };
+    CHECK(WS_React_Encoding_Choose(br_big, any) == G);
+
+    // Ties go to br, then gzip
+    ws_react_enc_avail_t tie[WS_REACT_ENC_COUNT] =
+    {
+        [I] = { true, 300 }, [G] = { true, 300 }, [B] = { true, 300 },
+    };
+    CHECK(WS_React_Encoding_Choose(tie, any) == B);
+    CHECK(WS_React_Encoding_Choose(tie, no_br) == G);
+
+    // A variant that is not stored is never chosen, however small
+    ws_react_enc_avail_t gz_only[WS_REACT_ENC_COUNT] =
+    {
+        [I] = { false, 0 }, [G] = { true, 300 }, [B] = { false, 0 },
+    };
+    CHECK(WS_React_Encoding_Choose(gz_only, any) == G);
+    uint16_t identity_only[WS_REACT_ENC_COUNT] = { 1000, 0, 0 };
+    CHECK(WS_React_Encoding_Choose(gz_only, identity_only) == WS_REACT_ENC_COUNT);
+}
+
+static void test_negotiate(void)
+{
+    ws_react_enc_avail_t all[WS_REACT_ENC_COUNT] =
+    {
+        [I] = { true, 1000 }, [G] = { true, 300 }, [B] = { true, 250 },
+    };
+    ws_react_enc_avail_t gz_only[WS_REACT_ENC_COUNT] =
+    {
+        [I] = { false, 0 }, [G] = { true, 300 }, [B] = { false, 0 },
+    };
+    ws_react_negotiation_t neg;
+
+    WS_React_Encoding_Negotiate("gzip, deflate, br", all, &neg);
+    CHECK(neg.enc == B);
+    CHECK(!neg.inflate);
+    CHECK_STR(neg.content_encoding, "br");
+    CHECK_STR(neg.vary, "Accept-Encoding");
+
+    // Plain HTTP: browsers leave br out
+    WS_React_Encoding_Negotiate("gzip, deflate", all, &neg);
+    CHECK(neg.enc == G);
+    CHECK_STR(neg.content_encoding, "gzip");
+    CHECK_STR(neg.vary, "Accept-Encoding");
+
+    WS_React_Encoding_Negotiate("identity", all, &neg);
+    CHECK(neg.enc == I);
+    CHECK(!neg.inflate);
+    CHECK_STR(neg.content_encoding, NULL);
+    CHECK_STR(neg.vary, "Accept-Encoding");
+
+    // No identity file: the gzip one is inflated and sent without Content-Encoding
+    WS_React_Encoding_Negotiate("identity", gz_only, &neg);
+    CHECK(neg.enc == G);
+    CHECK(neg.inflate);
+    CHECK_STR(neg.content_encoding, NULL);
+    CHECK_STR(neg.vary, "Accept-Encoding");
+
+    // Nothing acceptable: 406, still with Vary
+    WS_React_Encoding_Negotiate("br;q=0, identity;q=0", gz_only, &neg);
+    CHECK(neg.enc == WS_REACT_ENC_COUNT);
+    CHECK(!neg.inflate);
+    CHECK_STR(neg.content_encoding, NULL);
+    CHECK_STR(neg.vary, "Accept-Encoding");
+}
+
+static void test_headers(void)
+{
+    CHECK_STR(WS_React_Encoding_Header(WS_REACT_ENC_IDENTITY), NULL);
+    CHECK_STR(WS_React_Encoding_Header(WS_REACT_ENC_GZIP), "gzip");
+    CHECK_STR(WS_React_Encoding_Header(WS_REACT_ENC_BR), "br");
+    CHECK_STR(WS_React_Encoding_Header(WS_REACT_ENC_NEGOTIATE), NULL);
+    CHECK_STR(WS_React_Encoding_Token(WS_REACT_ENC_IDENTITY), "identity");
+}
+
+int main(void)
+{
+    test_parse();
+    test_choose();
+    test_negotiate();
+    test_headers();
+    TEST_DONE();
+}